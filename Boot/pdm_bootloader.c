@@ -0,0 +1,613 @@
+/*
+ * PDM CAN 引导程序（make bootloader，用 SWD 烧写到 0x08000000，只需烧写一次）。
+ * 协议、flash 布局和进入方式见 Core/Inc/pdm_boot.h，上位机见 Tools/pdm_flash.py。
+ * 不使用 HAL 和中断，直接操作寄存器：CAN 接收轮询 FIFO0，ISO-TP 只收一个请求、回一个单帧，
+ * 请求之间没有编程以外的耗时，500 kbit/s 连续帧（约 230 us 一帧）不会溢出 3 级 FIFO。
+ * 时钟：HSE 8 MHz 直接作为系统时钟（不起振时用 HSI 8 MHz），CAN 1 + 12 + 3 = 16 tq，500 kbit/s，采样点 81%。
+ * 负载开关引脚保持复位后的浮空输入（外部下拉，负载关断），引导程序中没有过流保护。
+ */
+#include "stm32f1xx.h"
+#include "pdm_boot.h"
+
+#define BOOT_SRAM_END       (SRAM_BASE + 0x5000u)
+#define BOOT_APP_END        (PDM_BOOT_APP_BASE + PDM_BOOT_APP_PAGES * PDM_BOOT_PAGE_SIZE)
+
+#define BOOT_MSG_MAX        (2u + PDM_BOOT_PAGE_SIZE)
+#define BOOT_PAD            0xCCu
+#define BOOT_CF_TIMEOUT_MS  1000u       /* 连续帧之间的最长间隔（N_Cr） */
+#define BOOT_IDLE_MS        30000u      /* 应用程序有效、由命令进入时，这么久没有请求就复位运行 */
+#define BOOT_TX_WAIT        100000u     /* 等待发送邮箱的循环次数（约 50 ms） */
+
+/* ISO-TP 协议控制信息，data[0] 高 4 位 */
+#define PCI_SF              0x0u
+#define PCI_FF              0x1u
+#define PCI_CF              0x2u
+#define FC_CTS              0x30u
+#define FC_OVFLW            0x32u
+
+_Static_assert(PDM_BOOT_APP_PAGES >= 16u && PDM_BOOT_APP_PAGES < 64u, "no room for the application before the data pages");
+
+#define RSP_NEGATIVE        0x7F
+#define NRC_NOT_SUPPORTED   0x11
+#define NRC_LENGTH          0x13
+#define NRC_CONDITIONS      0x22
+#define NRC_RANGE           0x31
+
+extern uint32_t _estack;
+extern uint32_t _sbss;
+extern uint32_t _ebss;
+
+void Reset_Handler(void);
+void Fault_Handler(void);
+
+/* 只用到复位和异常入口，不打开任何中断 */
+__attribute__((section(".isr_vector"), used))
+static void (*const g_vectors[4])(void) = {
+    (void (*)(void))&_estack,
+    Reset_Handler,
+    Fault_Handler,          /* NMI */
+    Fault_Handler,          /* HardFault */
+};
+
+static uint8_t g_msg[BOOT_MSG_MAX];
+static uint16_t g_msg_len;
+static uint16_t g_msg_pos;
+static uint8_t g_msg_sn;
+static uint8_t g_rx_busy;
+static uint32_t g_ms;
+static uint32_t g_cf_ms;
+static uint32_t g_tx_id;
+static uint8_t g_node;
+
+static uint16_t crc16(const uint8_t *p, uint32_t n)
+{
+    uint16_t crc = 0xFFFF;
+
+    while (n--)
+    {
+        crc ^= (uint16_t)(*p++ << 8);
+        for (uint8_t b = 0; b < 8; b++)
+        {
+            crc = (crc & 0x8000u) ? (uint16_t)((crc << 1) ^ 0x1021u) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static const volatile uint16_t *state_page(void)
+{
+    return (const volatile uint16_t *)PDM_BOOT_STATE_ADDR;
+}
+
+/* 开始记录之后没有有效记录：更新没有完成 */
+static uint8_t updating(void)
+{
+    return (uint8_t)(state_page()[0] == PDM_BOOT_ST_START && state_page()[4] != PDM_BOOT_ST_VALID);
+}
+
+/* 向量表中的栈顶在 SRAM 中，复位入口在程序区中 */
+static uint8_t app_vectors_ok(void)
+{
+    const volatile uint32_t *vec = (const volatile uint32_t *)PDM_BOOT_APP_BASE;
+
+    return (uint8_t)(vec[0] > SRAM_BASE && vec[0] <= BOOT_SRAM_END &&
+                     vec[1] > PDM_BOOT_APP_BASE && vec[1] < BOOT_APP_END);
+}
+
+static uint8_t app_valid(void)
+{
+    return (uint8_t)(!updating() && app_vectors_ok());
+}
+
+__attribute__((noreturn)) static void start_app(void)
+{
+    const volatile uint32_t *vec = (const volatile uint32_t *)PDM_BOOT_APP_BASE;
+
+    SCB->VTOR = PDM_BOOT_APP_BASE;
+    __set_MSP(vec[0]);
+    ((void (*)(void))vec[1])();
+    for (;;)
+    {
+    }
+}
+
+/* 读出并清除应用程序写入的更新请求，外设时钟恢复为复位值 */
+static uint8_t take_request(void)
+{
+    uint8_t req;
+
+    RCC->APB1ENR |= RCC_APB1ENR_PWREN | RCC_APB1ENR_BKPEN;
+    req = (uint8_t)(BKP->DR1 == PDM_BOOT_REQ_MAGIC);
+    if (req)
+    {
+        g_node = (uint8_t)BKP->DR2;
+        PWR->CR |= PWR_CR_DBP;
+        BKP->DR1 = 0;
+        PWR->CR &= ~PWR_CR_DBP;
+    }
+    RCC->APB1ENR = 0;
+    return req;
+}
+
+/* ---------------- flash ---------------- */
+
+static uint8_t flash_wait(void)
+{
+    uint32_t sr;
+
+    while (FLASH->SR & FLASH_SR_BSY)
+    {
+    }
+    sr = FLASH->SR;
+    FLASH->SR = FLASH_SR_EOP | FLASH_SR_PGERR | FLASH_SR_WRPRTERR;
+    return (uint8_t)((sr & (FLASH_SR_PGERR | FLASH_SR_WRPRTERR)) != 0);
+}
+
+static uint8_t flash_erase(uint32_t addr)
+{
+    uint8_t err;
+
+    FLASH->KEYR = FLASH_KEY1;
+    FLASH->KEYR = FLASH_KEY2;
+    FLASH->CR |= FLASH_CR_PER;
+    FLASH->AR = addr;
+    FLASH->CR |= FLASH_CR_STRT;
+    err = flash_wait();
+    FLASH->CR &= ~FLASH_CR_PER;
+    FLASH->CR |= FLASH_CR_LOCK;
+    return err;
+}
+
+/* 按半字编程 n 个字节（n 为偶数）后读回比较；返回 0 成功 */
+static uint8_t flash_program(uint32_t addr, const uint8_t *src, uint16_t n)
+{
+    volatile uint16_t *dst = (volatile uint16_t *)addr;
+    uint8_t err = 0;
+
+    FLASH->KEYR = FLASH_KEY1;
+    FLASH->KEYR = FLASH_KEY2;
+    FLASH->CR |= FLASH_CR_PG;
+    for (uint16_t i = 0; i < n && !err; i += 2u)
+    {
+        dst[i / 2u] = (uint16_t)(src[i] | (src[i + 1u] << 8));
+        err = flash_wait();
+    }
+    FLASH->CR &= ~FLASH_CR_PG;
+    FLASH->CR |= FLASH_CR_LOCK;
+    for (uint16_t i = 0; i < n && !err; i += 2u)
+    {
+        err = (uint8_t)(dst[i / 2u] != (uint16_t)(src[i] | (src[i + 1u] << 8)));
+    }
+    return err;
+}
+
+static uint8_t flash_same(uint32_t addr, const uint8_t *src, uint16_t n)
+{
+    const volatile uint8_t *p = (const volatile uint8_t *)addr;
+
+    for (uint16_t i = 0; i < n; i++)
+    {
+        if (p[i] != src[i])
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* ---------------- CAN ---------------- */
+
+static void clock_init(void)
+{
+    RCC->CR |= RCC_CR_HSEON;
+    for (uint32_t i = 0; i < 200000u && !(RCC->CR & RCC_CR_HSERDY); i++)
+    {
+    }
+    if (RCC->CR & RCC_CR_HSERDY)
+    {
+        RCC->CFGR = (RCC->CFGR & ~RCC_CFGR_SW) | RCC_CFGR_SW_HSE;
+        while ((RCC->CFGR & RCC_CFGR_SWS) != RCC_CFGR_SWS_HSE)
+        {
+        }
+    }
+
+    /* 1 ms 计数，只查询 COUNTFLAG，不产生中断 */
+    SysTick->LOAD = 8000u - 1u;
+    SysTick->VAL = 0;
+    SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_ENABLE_Msk;
+}
+
+static void can_init(void)
+{
+    uint32_t rx_id = PDM_CFG_ISOTP_RX_ID + (uint32_t)g_node * PDM_CFG_NODE_STRIDE;
+
+    g_tx_id = PDM_CFG_ISOTP_TX_ID + (uint32_t)g_node * PDM_CFG_NODE_STRIDE;
+
+    /* PA11 CAN_RX 浮空输入（复位值），PA12 CAN_TX 复用推挽 50 MHz */
+    RCC->APB2ENR |= RCC_APB2ENR_IOPAEN | RCC_APB2ENR_AFIOEN;
+    GPIOA->CRH = (GPIOA->CRH & ~(0xFu << 16)) | (0xBu << 16);
+
+    RCC->APB1ENR |= RCC_APB1ENR_CAN1EN;
+    CAN1->MCR = CAN_MCR_INRQ | CAN_MCR_ABOM;
+    while (!(CAN1->MSR & CAN_MSR_INAK))
+    {
+    }
+    CAN1->BTR = ((3u - 1u) << CAN_BTR_TS2_Pos) | ((12u - 1u) << CAN_BTR_TS1_Pos) | (1u - 1u);
+
+    /* 过滤器组 0：16 位列表模式，四个位置都是请求 ID */
+    CAN1->FMR |= CAN_FMR_FINIT;
+    CAN1->FA1R = 0;
+    CAN1->FM1R = 1u;
+    CAN1->FS1R = 0;
+    CAN1->FFA1R = 0;
+    CAN1->sFilterRegister[0].FR1 = (rx_id << 5) | (rx_id << 21);
+    CAN1->sFilterRegister[0].FR2 = (rx_id << 5) | (rx_id << 21);
+    CAN1->FA1R = 1u;
+    CAN1->FMR &= ~CAN_FMR_FINIT;
+
+    CAN1->MCR &= ~CAN_MCR_INRQ;
+}
+
+/* 返回收到的数据长度，没有时 -1 */
+static int8_t can_read(uint8_t *d)
+{
+    uint32_t lo, hi;
+    uint8_t dlc;
+
+    if ((CAN1->RF0R & CAN_RF0R_FMP0) == 0)
+    {
+        return -1;
+    }
+    dlc = (uint8_t)(CAN1->sFIFOMailBox[0].RDTR & CAN_RDT0R_DLC);
+    lo = CAN1->sFIFOMailBox[0].RDLR;
+    hi = CAN1->sFIFOMailBox[0].RDHR;
+    CAN1->RF0R = CAN_RF0R_RFOM0;
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        d[i] = (uint8_t)(lo >> (8u * i));
+        d[i + 4u] = (uint8_t)(hi >> (8u * i));
+    }
+    return (int8_t)(dlc > 8u ? 8u : dlc);
+}
+
+/* 发送一帧（8 字节，不足时填 BOOT_PAD），等到发送完成 */
+static void can_send(const uint8_t *d, uint8_t n)
+{
+    uint8_t b[8];
+    uint32_t i;
+
+    for (i = 0; i < 8u; i++)
+    {
+        b[i] = (i < n) ? d[i] : BOOT_PAD;
+    }
+    for (i = 0; i < BOOT_TX_WAIT && !(CAN1->TSR & CAN_TSR_TME0); i++)
+    {
+    }
+    if (!(CAN1->TSR & CAN_TSR_TME0))
+    {
+        CAN1->TSR = CAN_TSR_ABRQ0;      /* 没有应答（上位机断开），放弃上一帧 */
+        return;
+    }
+    CAN1->sTxMailBox[0].TDTR = 8u;
+    CAN1->sTxMailBox[0].TDLR = (uint32_t)b[0] | ((uint32_t)b[1] << 8) | ((uint32_t)b[2] << 16) | ((uint32_t)b[3] << 24);
+    CAN1->sTxMailBox[0].TDHR = (uint32_t)b[4] | ((uint32_t)b[5] << 8) | ((uint32_t)b[6] << 16) | ((uint32_t)b[7] << 24);
+    CAN1->sTxMailBox[0].TIR = (g_tx_id << CAN_TI0R_STID_Pos) | CAN_TI0R_TXRQ;
+    for (i = 0; i < BOOT_TX_WAIT && !(CAN1->TSR & CAN_TSR_RQCP0); i++)
+    {
+    }
+}
+
+/* 单帧响应 */
+static void reply(const uint8_t *p, uint8_t n)
+{
+    uint8_t f[8];
+
+    f[0] = (uint8_t)(PCI_SF << 4 | n);
+    for (uint8_t i = 0; i < n; i++)
+    {
+        f[i + 1u] = p[i];
+    }
+    can_send(f, (uint8_t)(n + 1u));
+}
+
+static void reply_negative(uint8_t nrc)
+{
+    uint8_t r[3] = { RSP_NEGATIVE, g_msg[0], nrc };
+
+    reply(r, sizeof(r));
+}
+
+/* ---------------- 请求 ---------------- */
+
+static void req_write(uint16_t len)
+{
+    uint8_t page = g_msg[1];
+    uint32_t addr = PDM_BOOT_APP_BASE + (uint32_t)page * PDM_BOOT_PAGE_SIZE;
+    uint8_t *data = &g_msg[2];
+    uint8_t r[3] = { PDM_BOOT_REQ_WRITE + 0x40u, page, 1 };
+
+    if (len < 3u)
+    {
+        reply_negative(NRC_LENGTH);
+        return;
+    }
+    if (page >= PDM_BOOT_APP_PAGES)
+    {
+        reply_negative(NRC_RANGE);
+        return;
+    }
+    if (!updating())
+    {
+        reply_negative(NRC_CONDITIONS);
+        return;
+    }
+    for (uint16_t i = (uint16_t)(len - 2u); i < PDM_BOOT_PAGE_SIZE; i++)
+    {
+        data[i] = 0xFF;
+    }
+    if (!flash_same(addr, data, PDM_BOOT_PAGE_SIZE))
+    {
+        r[2] = 0;
+        if (flash_erase(addr) != 0 || flash_program(addr, data, PDM_BOOT_PAGE_SIZE) != 0)
+        {
+            reply_negative(PDM_BOOT_NRC_PROGRAM);
+            return;
+        }
+    }
+    reply(r, sizeof(r));
+}
+
+static void req_commit(uint16_t len)
+{
+    uint32_t size;
+    uint16_t crc;
+    uint8_t rec[8];
+
+    if (len != 7u)
+    {
+        reply_negative(NRC_LENGTH);
+        return;
+    }
+    size = ((uint32_t)g_msg[1] << 24) | ((uint32_t)g_msg[2] << 16) | ((uint32_t)g_msg[3] << 8) | g_msg[4];
+    crc = (uint16_t)((g_msg[5] << 8) | g_msg[6]);
+    if (size < 8u || size > PDM_BOOT_APP_PAGES * PDM_BOOT_PAGE_SIZE)
+    {
+        reply_negative(NRC_RANGE);
+        return;
+    }
+    if (!updating() || !app_vectors_ok() ||
+        crc16((const uint8_t *)PDM_BOOT_APP_BASE, size) != crc)
+    {
+        reply_negative(NRC_CONDITIONS);
+        return;
+    }
+    rec[0] = (uint8_t)PDM_BOOT_ST_VALID;
+    rec[1] = (uint8_t)(PDM_BOOT_ST_VALID >> 8);
+    rec[2] = (uint8_t)size;
+    rec[3] = (uint8_t)(size >> 8);
+    rec[4] = (uint8_t)(size >> 16);
+    rec[5] = (uint8_t)(size >> 24);
+    rec[6] = (uint8_t)crc;
+    rec[7] = (uint8_t)(crc >> 8);
+    if (flash_program(PDM_BOOT_STATE_ADDR + 8u, rec, sizeof(rec)) != 0)
+    {
+        reply_negative(PDM_BOOT_NRC_PROGRAM);
+        return;
+    }
+    rec[0] = PDM_BOOT_REQ_COMMIT + 0x40u;
+    reply(rec, 1);
+}
+
+static void handle(uint16_t len)
+{
+    uint8_t r[6];
+
+    r[0] = (uint8_t)(g_msg[0] + 0x40u);
+    switch (g_msg[0])
+    {
+    case PDM_BOOT_REQ_INFO:
+        r[1] = PDM_BOOT_VERSION;
+        r[2] = updating() ? PDM_BOOT_STATE_UPDATING : app_vectors_ok() ? PDM_BOOT_STATE_VALID : PDM_BOOT_STATE_EMPTY;
+        r[3] = g_node;
+        r[4] = (uint8_t)PDM_BOOT_APP_PAGES;
+        r[5] = (uint8_t)(PDM_BOOT_PAGE_SIZE / 1024u);
+        reply(r, 6);
+        break;
+
+    case PDM_BOOT_REQ_START:
+        /* 状态页只在这里擦除：开始记录写入之前断电，应用程序仍然完整 */
+        r[1] = (uint8_t)PDM_BOOT_ST_START;
+        r[2] = (uint8_t)(PDM_BOOT_ST_START >> 8);
+        r[3] = g_node;
+        r[4] = 0;
+        if (flash_erase(PDM_BOOT_STATE_ADDR) != 0 || flash_program(PDM_BOOT_STATE_ADDR, &r[1], 4) != 0)
+        {
+            reply_negative(PDM_BOOT_NRC_PROGRAM);
+            break;
+        }
+        reply(r, 1);
+        break;
+
+    case PDM_BOOT_REQ_WRITE:
+        req_write(len);
+        break;
+
+    case PDM_BOOT_REQ_CRC:
+        if (len != 2u || g_msg[1] >= PDM_BOOT_APP_PAGES)
+        {
+            reply_negative(len != 2u ? NRC_LENGTH : NRC_RANGE);
+            break;
+        }
+        {
+            uint16_t crc = crc16((const uint8_t *)(PDM_BOOT_APP_BASE + (uint32_t)g_msg[1] * PDM_BOOT_PAGE_SIZE),
+                                 PDM_BOOT_PAGE_SIZE);
+
+            r[1] = g_msg[1];
+            r[2] = (uint8_t)(crc >> 8);
+            r[3] = (uint8_t)crc;
+            reply(r, 4);
+        }
+        break;
+
+    case PDM_BOOT_REQ_COMMIT:
+        req_commit(len);
+        break;
+
+    case PDM_BOOT_REQ_RUN:
+        reply(r, 1);
+        NVIC_SystemReset();
+        break;
+
+    default:
+        reply_negative(NRC_NOT_SUPPORTED);
+        break;
+    }
+}
+
+/* ISO-TP 接收，一个请求收完时返回其长度，否则 0 */
+static uint16_t tp_rx(const uint8_t *d, uint8_t dlc)
+{
+    uint8_t fc[3] = { FC_CTS, 0, 0 };       /* 不分块，不要求间隔 */
+    uint16_t n;
+
+    if (dlc == 0)
+    {
+        return 0;
+    }
+    switch (d[0] >> 4)
+    {
+    case PCI_SF:
+        n = d[0] & 0x0Fu;
+        if (n == 0 || n > 7u || n > dlc - 1u)
+        {
+            return 0;
+        }
+        g_rx_busy = 0;
+        for (uint8_t i = 0; i < n; i++)
+        {
+            g_msg[i] = d[i + 1u];
+        }
+        return n;
+
+    case PCI_FF:
+        n = (uint16_t)(((d[0] & 0x0Fu) << 8) | d[1]);
+        if (dlc < 8u || n < 8u)
+        {
+            return 0;
+        }
+        if (n > BOOT_MSG_MAX)
+        {
+            g_rx_busy = 0;
+            fc[0] = FC_OVFLW;
+            can_send(fc, sizeof(fc));
+            return 0;
+        }
+        for (uint8_t i = 0; i < 6u; i++)
+        {
+            g_msg[i] = d[i + 2u];
+        }
+        g_msg_len = n;
+        g_msg_pos = 6;
+        g_msg_sn = 1;
+        g_rx_busy = 1;
+        g_cf_ms = g_ms;
+        can_send(fc, sizeof(fc));
+        return 0;
+
+    case PCI_CF:
+        if (!g_rx_busy)
+        {
+            return 0;
+        }
+        if ((d[0] & 0x0Fu) != g_msg_sn)
+        {
+            g_rx_busy = 0;          /* 丢帧，上位机超时后重发这个请求 */
+            return 0;
+        }
+        n = (uint16_t)(g_msg_len - g_msg_pos);
+        if (n > 7u)
+        {
+            n = 7u;
+        }
+        if (n > dlc - 1u)
+        {
+            n = (uint16_t)(dlc - 1u);
+        }
+        for (uint8_t i = 0; i < n; i++)
+        {
+            g_msg[g_msg_pos + i] = d[i + 1u];
+        }
+        g_msg_pos = (uint16_t)(g_msg_pos + n);
+        g_msg_sn = (uint8_t)((g_msg_sn + 1u) & 0x0Fu);
+        g_cf_ms = g_ms;
+        if (g_msg_pos < g_msg_len)
+        {
+            return 0;
+        }
+        g_rx_busy = 0;
+        return g_msg_len;
+
+    default:
+        return 0;                   /* 上位机的流控帧：响应都是单帧，不需要 */
+    }
+}
+
+__attribute__((noreturn)) static void boot_main(void)
+{
+    uint32_t last_req = 0;
+    uint8_t d[8];
+    int8_t dlc;
+    uint16_t len;
+
+    clock_init();
+    can_init();
+    for (;;)
+    {
+        IWDG->KR = 0xAAAAu;         /* 选项字节打开硬件看门狗时也不复位 */
+        if (SysTick->CTRL & SysTick_CTRL_COUNTFLAG_Msk)
+        {
+            g_ms++;
+        }
+        dlc = can_read(d);
+        if (dlc >= 0)
+        {
+            len = tp_rx(d, (uint8_t)dlc);
+            if (len != 0)
+            {
+                last_req = g_ms;
+                handle(len);
+            }
+        }
+        if (g_rx_busy && g_ms - g_cf_ms > BOOT_CF_TIMEOUT_MS)
+        {
+            g_rx_busy = 0;
+        }
+        if (g_ms - last_req > BOOT_IDLE_MS && app_valid())
+        {
+            NVIC_SystemReset();
+        }
+    }
+}
+
+void Reset_Handler(void)
+{
+    for (uint32_t *p = &_sbss; p < &_ebss; p++)
+    {
+        *p = 0;
+    }
+    /* 没有请求且应用程序有效时立即跳转，不改时钟和外设 */
+    if (!take_request())
+    {
+        if (app_valid())
+        {
+            start_app();
+        }
+        g_node = updating() ? (uint8_t)state_page()[1] : 0u;
+    }
+    boot_main();
+}
+
+void Fault_Handler(void)
+{
+    NVIC_SystemReset();
+}
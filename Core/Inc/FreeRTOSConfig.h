@@ -0,0 +1,76 @@
+#ifndef FREERTOS_CONFIG_H
+#define FREERTOS_CONFIG_H
+
+/*
+ * FreeRTOS 配置（PDM_CFG_RTOS，make RTOS=1），任务划分见 pdm_rtos.h。
+ * 只用静态分配（不链接 heap_x.c），不用软件定时器；内核节拍 1 ms，与 HAL_GetTick() 相同。
+ * 运行时间统计用 PDM_Sched_NowUs()（1 us），32 位计数约 71 分钟回绕，rtos 命令按差值计算，两次输出间隔要短于回绕周期。
+ */
+
+#include <stdint.h>
+
+extern uint32_t SystemCoreClock;
+extern uint32_t PDM_Sched_NowUs(void);
+extern void Error_Handler(void);
+
+#define configUSE_PREEMPTION                    1
+#define configUSE_PORT_OPTIMISED_TASK_SELECTION 1
+#define configUSE_TICKLESS_IDLE                 0
+#define configCPU_CLOCK_HZ                      (SystemCoreClock)
+#define configTICK_RATE_HZ                      1000
+#define configMAX_PRIORITIES                    4
+#define configMINIMAL_STACK_SIZE                64
+#define configMAX_TASK_NAME_LEN                 8
+#define configUSE_16_BIT_TICKS                  0
+#define configIDLE_SHOULD_YIELD                 1
+#define configUSE_TASK_NOTIFICATIONS            1
+#define configUSE_MUTEXES                       1
+#define configUSE_RECURSIVE_MUTEXES             0
+#define configUSE_COUNTING_SEMAPHORES           0
+#define configQUEUE_REGISTRY_SIZE               0
+#define configUSE_QUEUE_SETS                    0
+#define configUSE_TIME_SLICING                  0
+#define configUSE_NEWLIB_REENTRANT              0
+
+/* 内存 */
+#define configSUPPORT_STATIC_ALLOCATION         1
+#define configSUPPORT_DYNAMIC_ALLOCATION        0
+
+/* 回调 */
+#define configUSE_IDLE_HOOK                     1
+#define configUSE_TICK_HOOK                     0
+#define configCHECK_FOR_STACK_OVERFLOW          2
+#define configUSE_MALLOC_FAILED_HOOK            0
+
+/* 统计（命令行 rtos） */
+#define configGENERATE_RUN_TIME_STATS           1
+#define configUSE_TRACE_FACILITY                1
+#define configUSE_STATS_FORMATTING_FUNCTIONS    0
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+#define portGET_RUN_TIME_COUNTER_VALUE()        PDM_Sched_NowUs()
+
+/* 软件定时器 */
+#define configUSE_TIMERS                        0
+
+/* 可选函数 */
+#define INCLUDE_vTaskPrioritySet                0
+#define INCLUDE_uxTaskPriorityGet               0
+#define INCLUDE_vTaskDelete                     0
+#define INCLUDE_vTaskSuspend                    1
+#define INCLUDE_vTaskDelayUntil                 0
+#define INCLUDE_vTaskDelay                      1
+#define INCLUDE_xTaskGetSchedulerState          1
+#define INCLUDE_uxTaskGetStackHighWaterMark     1
+
+/* 中断优先级（4 位，数字越大越低）：内核和 PendSV 最低；调用 FromISR 函数的中断不能高于 5 级，
+ * 即 PDM_IRQ_PRIO_RTOS（pdm_irq.h），0~4 级不被内核屏蔽 */
+#define configPRIO_BITS                         4
+#define configLIBRARY_LOWEST_INTERRUPT_PRIORITY 15
+#define configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY 5
+#define configKERNEL_INTERRUPT_PRIORITY         (configLIBRARY_LOWEST_INTERRUPT_PRIORITY << (8 - configPRIO_BITS))
+#define configMAX_SYSCALL_INTERRUPT_PRIORITY    (configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY << (8 - configPRIO_BITS))
+
+/* 断言失败时关中断停住，看门狗复位 */
+#define configASSERT(x)                         do { if ((x) == 0) { Error_Handler(); } } while (0)
+
+#endif /* FREERTOS_CONFIG_H */
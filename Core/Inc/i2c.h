@@ -29,7 +29,7 @@ extern "C" {
 #include "main.h"
 
 /* USER CODE BEGIN Includes */
-
+#include "pdm_config.h"
 /* USER CODE END Includes */
 
 extern I2C_HandleTypeDef hi2c1;
@@ -41,7 +41,12 @@ extern I2C_HandleTypeDef hi2c1;
 void MX_I2C1_Init(void);
 
 /* USER CODE BEGIN Prototypes */
+#if PDM_CFG_I2C2
+extern I2C_HandleTypeDef hi2c2;
 
+/* 第二条传感器总线 I2C2（PB10 SCL / PB11 SDA），CubeMX 工程中没有配置，在这里手写初始化 */
+void PDM_I2C2_Init(void);
+#endif
 /* USER CODE END Prototypes */
 
 #ifdef __cplusplus
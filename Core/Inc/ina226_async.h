@@ -0,0 +1,120 @@
+#ifndef INA226_ASYNC_H
+#define INA226_ASYNC_H
+
+#include <stdint.h>
+#include "driver_ina226_interface.h"
+
+/*
+ * 接口层（ina226_interface.c）在 LibDriver 接口之外提供的功能：
+ * 中断驱动的异步 I2C 读取队列、一次排队读完一组寄存器、寄存器副本和总线恢复。
+ * driver_ina226_interface.h 保持 LibDriver 原样，本项目增加的声明都在这里。
+ *
+ * PDM_CFG_INA226_SHADOW 打开时，ina226_interface_iic_read() 对已知的 CONF、CALIBRATION、
+ * ALERT_LIMIT 直接返回 RAM 中的副本，MASK 总是从器件读取（读取才清除报警和转换完成标志）；
+ * ina226_interface_iic_write() 写成功后同时更新副本，写 CONF 复位位时丢弃该器件的副本。
+ */
+
+/* INA226 寄存器地址，与 driver_ina226.c 中的私有定义相同 */
+#define INA226_REG_CONF                 0x00
+#define INA226_REG_SHUNT_VOLTAGE        0x01
+#define INA226_REG_BUS_VOLTAGE          0x02
+#define INA226_REG_POWER                0x03
+#define INA226_REG_CURRENT              0x04
+#define INA226_REG_CALIBRATION          0x05
+#define INA226_REG_MASK                 0x06
+#define INA226_REG_ALERT_LIMIT          0x07
+#define INA226_REG_MANUFACTURER         0xFE
+#define INA226_MANUFACTURER_ID          0x5449      /* "TI" */
+
+/* I2C 写地址的 bit0 选择第二条总线（PDM_CFG_I2C2），HAL 会替换读写位，器件地址不变 */
+#define INA226_IIC_BUS_BIT              0x01
+
+/* 一次通道读取的寄存器数：MASK、分流电压、总线电压、电流、功率 */
+#define INA226_READ_REGS        5
+
+/* 一个读取任务最多的寄存器数（INA228 带累计寄存器）和最长的寄存器字节数 */
+#define INA226_JOB_MAX_REGS     6
+#define INA226_JOB_MAX_LEN      5
+
+/* 异步读取完成回调：res 0 成功，1 失败；在 I2C 中断中调用，要短 */
+typedef void (*ina226_interface_iic_done_t)(uint8_t res, void *ctx);
+
+/* 一次通道读取得到的寄存器原始值 */
+typedef struct ina226_regs_s
+{
+    uint16_t mask;          /* MASK/ENABLE，最先读 */
+    int16_t shunt;          /* 分流电压 */
+    uint16_t bus;           /* 总线电压 */
+    int16_t current;        /* 电流 */
+    uint16_t power;         /* 功率 */
+} ina226_regs_t;
+
+/* 一组寄存器的读取任务，读完之前不能释放 */
+typedef struct ina226_read_job_s
+{
+    uint8_t raw[INA226_JOB_MAX_REGS][INA226_JOB_MAX_LEN]; /* 各寄存器的原始字节，大端 */
+    uint8_t n;                                  /* 排队的寄存器数 */
+    volatile uint8_t pending;                   /* 还没有读完的寄存器数 */
+    volatile uint8_t failed;                    /* 有寄存器读取失败 */
+    ina226_interface_iic_done_t done;           /* 最后一个寄存器读完后调用 */
+    void *ctx;                                  /* 回调参数 */
+} ina226_read_job_t;
+
+/* 异步读一个寄存器；buf 在 done 调用前必须有效，done 可以为 NULL。
+ * 事务按排队顺序依次执行。返回 0 已入队，1 队列已满 */
+uint8_t ina226_interface_iic_read_async(uint8_t addr, uint8_t reg, uint8_t *buf, uint16_t len,
+                                       ina226_interface_iic_done_t done, void *ctx);
+
+/* 发起一次通道读取（MASK + 分流 + 总线 + 电流 + 功率），5 个读取一起入队，连续执行；
+ * done 在最后一个寄存器读完后的 I2C 中断中调用，可以为 NULL。返回 0 已入队，1 队列已满 */
+uint8_t ina226_interface_read_channel_async(uint8_t addr, ina226_read_job_t *job,
+                                            ina226_interface_iic_done_t done, void *ctx);
+
+/* 把一组寄存器作为一个任务读取，第 i 个寄存器放在 job->raw[i]；
+ * 长度不超过 INA226_JOB_MAX_LEN，个数不超过 INA226_JOB_MAX_REGS。
+ * 用于 INA226 以外的传感器（pdm_sensor.c）。返回 0 已入队，1 队列已满 */
+uint8_t ina226_interface_read_regs_async(uint8_t addr, ina226_read_job_t *job,
+                                         const uint8_t *regs, const uint8_t *lens, uint8_t n,
+                                         ina226_interface_iic_done_t done, void *ctx);
+
+/* 任务是否还在进行：1 进行中，0 已结束 */
+uint8_t ina226_interface_job_busy(const ina226_read_job_t *job);
+
+/* 解析已结束的通道读取：返回 0 成功，1 读取失败，4 溢出 */
+uint8_t ina226_interface_channel_decode(const ina226_read_job_t *job, ina226_regs_t *snap);
+
+/* 阻塞的通道读取，等待排队的读取完成，返回值同 ina226_interface_channel_decode()；采样中用异步版本 */
+uint8_t ina226_interface_read_channel(uint8_t addr, ina226_regs_t *snap);
+
+/* 是否有异步事务未完成：1 有，0 空闲 */
+uint8_t ina226_interface_iic_busy(void);
+
+/* addr 所在总线是否被主循环的阻塞读写等待或占用：1 是，0 否。
+ * 在自己的完成回调中重新发起的读取（启动采集）在总线被占用时要停下，否则阻塞读写一直等不到队列空闲 */
+uint8_t ina226_interface_iic_held(uint8_t addr);
+
+/* 主循环中调用：检查当前事务超时（按失败结束），总线被占住时在这里发最多 9 个 SCL 脉冲并复位 I2C 外设 */
+void ina226_interface_iic_poll(void);
+
+/* I2Cx_EV_IRQHandler / I2Cx_ER_IRQHandler 中调用，bus 0 为 I2C1，1 为 I2C2。
+ * PDM_CFG_I2C_LL 打开时 2 字节读取由寄存器级状态机处理，其余交给 HAL */
+void ina226_interface_i2c_ev_irq(uint8_t bus);
+void ina226_interface_i2c_er_irq(uint8_t bus);
+
+/* 寄存器编排与 INA226 不同的器件不使用寄存器副本 */
+void ina226_interface_shadow_exclude(uint8_t addr);
+
+/* 从器件读到的值与副本比较：副本已知且不同时返回 1，否则 0；忽略 MASK 的状态位 */
+uint8_t ina226_interface_shadow_differs(uint8_t addr, uint8_t reg, uint16_t value);
+
+/* 器件丢失配置后按副本写回（阻塞）：先写校准、报警门限和 MASK，最后写 CONF。
+ * 返回 0 成功，1 没有副本或写入失败 */
+uint8_t ina226_interface_shadow_restore(uint8_t addr);
+
+/* 上电以来的总线恢复次数 */
+uint16_t ina226_interface_iic_recoveries(void);
+
+/* 驱动的 debug_print，记为诊断事件（见 pdm_diag.h），器件为 iic_read / iic_write 最近访问的那一片 */
+void ina226_interface_driver_print(const char *const fmt, ...);
+
+#endif /* INA226_ASYNC_H */
@@ -0,0 +1,42 @@
+#ifndef PDM_ADAPT_H
+#define PDM_ADAPT_H
+
+#include <stdint.h>
+#include "pdm_config.h"
+#include "driver_ina226.h"
+
+/*
+ * 按负载变化调整 INA226 平均次数（每通道独立）。
+ * 每个采样按相邻两次电流的变化率 (mA/s) 选择档位：
+ * 变化快时用快速档，平均窗口短，瞬态不会被平均掉；长时间平稳时用平稳档，噪声更低，
+ * 定时采样模式下芯片没有新结果的周期不再读取，I2C 读取次数随之减少。
+ * 切换时写一次配置寄存器，在一组采样完成、I2C 空闲时进行。
+ * 当前档位在 0x303 和 0x304 第 2 页中发出，各档平均窗口见下。
+ */
+
+#define PDM_ADAPT_FAST          0       /* 平均 4 次，转换时间同正常档（默认约 8.8 ms） */
+#define PDM_ADAPT_NORMAL        1       /* 通道表中的平均次数（默认 16 次，约 35 ms） */
+#define PDM_ADAPT_STEADY        2       /* 平均 64 次（默认约 141 ms） */
+
+#if PDM_CFG_ADAPT
+
+/* normal_avg: 正常档的平均次数；max_level: 允许的最高档位（需要保护响应时间的通道用 PDM_ADAPT_NORMAL） */
+void PDM_Adapt_Init(uint8_t ch, ina226_avg_t normal_avg, uint8_t max_level);
+
+/* 芯片已被重新配置为正常档后调用（离线后重新初始化、高速采集结束） */
+void PDM_Adapt_Reset(uint8_t ch);
+
+/* 每个有效采样调用，current_uA 为电流，dt_ms 为距上次采样的时间；返回 1 需要切换档位 */
+uint8_t PDM_Adapt_Add(uint8_t ch, int32_t current_uA, uint32_t dt_ms);
+
+/* 写入新档位的配置寄存器（阻塞，一次 I2C 写）；返回 0 成功或不需要切换，1 写失败（下次再试） */
+uint8_t PDM_Adapt_Apply(uint8_t ch, const ina226_handle_t *h);
+
+/* 当前生效的档位、平均次数和芯片一个平均结果覆盖的时间 (us) */
+uint8_t PDM_Adapt_Level(uint8_t ch);
+ina226_avg_t PDM_Adapt_Avg(uint8_t ch);
+uint32_t PDM_Adapt_WindowUs(uint8_t ch);
+
+#endif /* PDM_CFG_ADAPT */
+
+#endif /* PDM_ADAPT_H */
@@ -0,0 +1,25 @@
+#ifndef PDM_ALERT_H
+#define PDM_ALERT_H
+
+#include <stdint.h>
+#include "pdm_config.h"
+
+/*
+ * INA226 ALERT 引脚：ALERT1 接通道 0，ALERT2 接通道 1，其余通道没有 ALERT 引脚。
+ * EXTI 中断中先取边沿时间（PDM_CFG_ALERT_CAPTURE），再交给硬件门限保护（pdm_protect.h）、
+ * 高速采集（pdm_capture.h），并记下转换完成，ALERT 采样模式（PDM_CFG_SAMPLE_ON_ALERT）下由采样任务读取。
+ */
+
+#define PDM_ALERT_PINS      2
+
+/* HAL_GPIO_EXTI_Callback() 中调用，n 为 0（ALERT1）或 1（ALERT2） */
+void PDM_Alert_OnEdge(uint8_t n);
+
+/* 取走通道 ch 的转换完成通知：返回 1 有通知（已清除），PDM_CFG_ALERT_CAPTURE 时 *ts_us 改为边沿时间，
+ * 不含等待主循环的时间；返回 0 没有通知或通道没有 ALERT 引脚，*ts_us 不变 */
+uint8_t PDM_Alert_Take(uint8_t ch, uint32_t *ts_us);
+
+/* 定时采样时丢弃转换完成通知（ALERT 只用于保护和高速采集） */
+void PDM_Alert_Clear(void);
+
+#endif /* PDM_ALERT_H */
@@ -0,0 +1,18 @@
+#ifndef PDM_APPLY_H
+#define PDM_APPLY_H
+
+#include <stdint.h>
+#include "pdm_config.h"
+
+/*
+ * 运行参数（pdm_param.h）的默认值、检查和应用。
+ * 默认值来自通道表（pdm_monitor.c）和 pdm_config.h；检查校准值在寄存器范围内，通道帧 ID 不与其他报文重复、
+ * 加上节点偏移后仍是 11 位，采样周期和 CAN 周期在允许范围内。
+ * 运行中修改时只重新配置受影响的部分：采样电阻和平均次数重新配置该通道的器件，转换时间重新配置所有通道
+ * （一组采样完成、I2C 空闲时进行，见 PDM_Monitor_Reconfigure()），切断和阶跃门限、采样周期、CAN 报文立即生效。
+ */
+
+/* 启动时读入运行参数，在 PDM_Monitor_Init() 初始化器件之前调用 */
+void PDM_Apply_Init(void);
+
+#endif /* PDM_APPLY_H */
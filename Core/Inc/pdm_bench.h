@@ -0,0 +1,35 @@
+#ifndef PDM_BENCH_H
+#define PDM_BENCH_H
+
+#include <stdint.h>
+#include "pdm_config.h"
+
+/*
+ * 板上基准测试（make bench）：启动时在 PDM_Monitor_Init() 之前把一组固定的操作各运行 n 次，
+ * 用 DWT 周期计数器测量每次的周期数，通过 UART 输出表格，然后照常启动。
+ * 输入都是固定值（伪造的 I2C 读取结果），每次测量期间关中断，扣除空测量的开销，
+ * 同一固件、同一块板子上多次运行的最小值相同，用来比较编译选项（OPT、LTO、PDM_CFG_RAMFUNC）和代码修改。
+ *   decode      PDM_Sensor_Decode()：一次 INA226 读取的 5 个寄存器（I2C 换成内存中的固定字节）
+ *   convert     零点修正、电压/电流/功率换算、充放电能量积分（update_channel() 中的运算）
+ *   filter      PDM_Filter_Apply()（通道 0）
+ *   stats       PDM_Stats_Add()（通道 0）
+ *   sample      以上四项连在一起，一个通道一次采样的处理
+ *   can_encode  通道帧编码（0x300，含读取发布的通道数据，不用上次的编码结果）
+ *   can_cached  通道数据没有重新发布时的通道帧编码（复制上次的结果）
+ *   line_fixed  一个通道的状态行，PDM_Log_Fixed() 等直接写日志块（写完放弃，不发送）
+ *   line_printf 同样内容用 snprintf 格式化到栈上
+ *   record      保存记录的准备：填充、复制负载、CRC16（PDM_Store_Append() 的运算；编程在之后分步进行，
+ *               每个半字 50~70 us 由 flash 决定，不测）
+ * 通道 0 的滤波和统计状态由之后的 PDM_Monitor_Init() 重新初始化；黑匣子等在 RAM 中保留的数据不受影响。
+ * 输出：每项的次数、最小/平均/最大周期数和按 SystemCoreClock 换算的平均时间，表头为编译器版本、
+ * 优化选项和 flash 等待周期，同一表格可以直接对比。
+ */
+
+#if PDM_CFG_BENCH
+
+/* 运行全部测试并输出，n 为每项次数 */
+void PDM_Bench_Run(uint32_t n);
+
+#endif /* PDM_CFG_BENCH */
+
+#endif /* PDM_BENCH_H */
@@ -0,0 +1,63 @@
+#ifndef PDM_BLACKBOX_H
+#define PDM_BLACKBOX_H
+
+#include <stdint.h>
+#include "pdm_config.h"
+
+/*
+ * 黑匣子：每个采样把时间、电流、总线电压原始值加入 RAM 中的环形缓冲区，新记录覆盖最旧的记录。
+ * 每通道每 16 个采样压缩为一条记录（块格式见 pdm_pack.h）：
+ *   [记录长度][通道][时间 ms 块][电流块][总线电压块]
+ * 缓冲区和编码器状态放在 .noinit 段，启动代码不清零，热复位（看门狗、软件、复位引脚）后仍然保留；
+ * 上电时内容无效，由启动检查发现后重新开始。
+ * 以下情况冻结（停止记录，保留内容直到重新开始）：
+ *   硬件门限故障（再记录 PDM_CFG_BLACKBOX_POST_MS 后冻结）、PVD 掉电中断、看门狗复位、命令。
+ * 冻结后通过 ISO-TP（来源 3）下载，命令行 bb 显示状态。下载格式：
+ *   头 [状态, 原因, 通道数, 0, 冻结时间 ms (4), 数据字节数 (2), 每通道电流 LSB uA (4)...]，大端，
+ *   后接从最旧到最新的记录。解码见 Tools/pdm_blackbox.py。
+ */
+
+#if PDM_CFG_BLACKBOX
+
+/* 状态 */
+#define PDM_BB_RECORDING        0
+#define PDM_BB_FROZEN           1
+
+/* 冻结原因 */
+#define PDM_BB_REASON_NONE      0
+#define PDM_BB_REASON_FAULT     1       /* 硬件门限故障 */
+#define PDM_BB_REASON_WDG       2       /* 看门狗复位 */
+#define PDM_BB_REASON_PVD       3       /* VDD 跌落 */
+#define PDM_BB_REASON_MANUAL    4       /* 命令 */
+
+typedef struct {
+    uint8_t state;
+    uint8_t reason;
+    uint16_t used;                      /* 已有记录的字节数 */
+    uint32_t freeze_ms;                 /* 冻结请求的时间（可能是复位前的时间），看门狗复位时为 0xFFFFFFFF */
+} pdm_bb_status_t;
+
+/* 检查保留的内容：看门狗复位前正在记录时冻结，已冻结的保持，其他情况清空重新开始。
+ * current_ua_per_lsb: 各通道电流 LSB，重新开始时保存到缓冲区（下载时换算用）；reset_cause 见 pdm_wdg.h */
+void PDM_Blackbox_Init(const uint32_t *current_ua_per_lsb, uint8_t reset_cause);
+
+/* 加入一个采样，由主循环在每次读取后调用；冻结后不再记录 */
+void PDM_Blackbox_Add(uint8_t ch, uint32_t tick_ms, int16_t current, uint16_t bus);
+
+/* 请求冻结，可以在中断中调用；已冻结或已有请求时不改变原因 */
+void PDM_Blackbox_Freeze(uint8_t reason);
+
+/* 清空并重新开始记录（主循环） */
+void PDM_Blackbox_Restart(void);
+
+void PDM_Blackbox_GetStatus(pdm_bb_status_t *st);
+
+/* 冻结时为头 + 记录的字节数，正在记录时为 0（内容随时在变，不能下载） */
+uint32_t PDM_Blackbox_Size(void);
+
+/* 复制 [off, off + n) 到 buf；返回 0 成功，1 越界或未冻结 */
+uint8_t PDM_Blackbox_Read(uint32_t off, uint8_t *buf, uint8_t n);
+
+#endif /* PDM_CFG_BLACKBOX */
+
+#endif /* PDM_BLACKBOX_H */
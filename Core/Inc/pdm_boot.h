@@ -0,0 +1,79 @@
+#ifndef PDM_BOOT_H
+#define PDM_BOOT_H
+
+#include <stdint.h>
+#include "pdm_config.h"
+#include "pdm_param.h"
+
+/*
+ * CAN 引导程序（Boot/pdm_bootloader.c，make bootloader）和应用程序共用的定义。
+ * flash 开头 PDM_BOOT_SIZE 字节为引导程序（最后一页为状态页），应用程序从 PDM_BOOT_APP_BASE 开始（make BOOT=1），
+ * 到存储区、参数区、事件记录区和趋势记录区之前为止，引导程序不会写这些数据页。
+ * 上电后引导程序只读状态页和备份寄存器：没有更新请求且应用程序有效时立即跳转（几 us），不初始化任何外设。
+ * 进入引导程序：
+ *   - 应用程序收到命令 PDM_CMD_BOOT（或命令行 boot），回复后把请求写入备份寄存器 BKP_DR1 并复位；
+ *   - 状态页中有开始记录而没有有效记录（更新中途断电或复位），上电后停在引导程序中等待继续写入。
+ * 协议：ISO-TP，请求在 PDM_CFG_ISOTP_RX_ID，响应在 PDM_CFG_ISOTP_TX_ID（与应用程序相同，按节点号偏移），
+ * 响应都是单帧，否定响应 [0x7F, 请求码, 原因] 与 pdm_isotp.h 相同，另加 0x72 编程失败。
+ * 每页单独写入和校验，写过的页不用重写：中途断开后重新连接，用 PDM_BOOT_REQ_CRC 比较后从第一个不同的页继续。
+ * 没有足够的 flash 同时存放两份程序，更新期间程序区无效，COMMIT 校验整个镜像的 CRC 后才标为有效。
+ * 上位机见 Tools/pdm_flash.py。
+ */
+
+#define PDM_BOOT_FLASH_BASE     0x08000000u
+#define PDM_BOOT_PAGE_SIZE      1024u
+#define PDM_BOOT_SIZE           0x1000u     /* 引导程序 3 KB + 状态页 */
+#define PDM_BOOT_STATE_ADDR     (PDM_BOOT_FLASH_BASE + PDM_BOOT_SIZE - PDM_BOOT_PAGE_SIZE)
+#define PDM_BOOT_APP_BASE       (PDM_BOOT_FLASH_BASE + PDM_BOOT_SIZE)
+
+#if PDM_CFG_EVLOG
+#define PDM_BOOT_EV_PAGES       PDM_CFG_EVLOG_PAGES
+#else
+#define PDM_BOOT_EV_PAGES       0
+#endif
+#if PDM_CFG_TREND
+#define PDM_BOOT_TR_PAGES       PDM_CFG_TREND_PAGES
+#else
+#define PDM_BOOT_TR_PAGES       0
+#endif
+
+/* flash 末尾的数据页数：存储区、参数区、事件记录区和趋势记录区，程序镜像必须在这些页之前结束（链接时检查，见 pdm_store.c） */
+#define PDM_BOOT_DATA_PAGES     (PDM_CFG_STORE_PAGES + PDM_PARAM_PAGES + PDM_BOOT_EV_PAGES + PDM_BOOT_TR_PAGES)
+
+/* 程序区的页数（STM32F103C8: 64 KB flash），页号 0 为 PDM_BOOT_APP_BASE */
+#define PDM_BOOT_APP_PAGES      (64u - PDM_BOOT_SIZE / PDM_BOOT_PAGE_SIZE - PDM_BOOT_DATA_PAGES)
+
+/* 更新请求：应用程序写入备份寄存器后复位，引导程序读出后清除 */
+#define PDM_BOOT_REQ_MAGIC      0xB007u     /* BKP_DR1 */
+                                            /* BKP_DR2: 节点号 */
+
+/* 状态页：偏移 0 开始记录 [标志, 节点号]，偏移 8 有效记录 [标志, 长度低 16 位, 长度高 16 位, CRC16]（半字） */
+#define PDM_BOOT_ST_START       0x5354u
+#define PDM_BOOT_ST_VALID       0x4F4Bu
+
+/* 请求码，响应码为请求码 + 0x40；多字节字段大端 */
+#define PDM_BOOT_REQ_INFO       0x10    /* -> [0x50, 版本, 状态 (PDM_BOOT_STATE_*), 节点号, 程序区页数, 页大小 KB] */
+#define PDM_BOOT_REQ_START      0x11    /* 开始更新，程序区标为无效 -> [0x51] */
+#define PDM_BOOT_REQ_WRITE      0x12    /* [0x12, 页号, 数据 1~1024 字节]，不足一页补 0xFF -> [0x52, 页号, 0 已写入 / 1 内容相同] */
+#define PDM_BOOT_REQ_CRC        0x13    /* [0x13, 页号] -> [0x53, 页号, 整页 CRC16 (2)] */
+#define PDM_BOOT_REQ_COMMIT     0x14    /* [0x14, 长度 (4), CRC16 (2)] 校验镜像后标为有效 -> [0x54] */
+#define PDM_BOOT_REQ_RUN        0x15    /* -> [0x55] 后复位，应用程序有效时运行 */
+
+#define PDM_BOOT_NRC_PROGRAM    0x72
+
+#define PDM_BOOT_VERSION        1
+#define PDM_BOOT_STATE_VALID    0       /* 应用程序有效（包括用 SWD 烧写、状态页为空） */
+#define PDM_BOOT_STATE_UPDATING 1       /* 已开始更新，还没有 COMMIT */
+#define PDM_BOOT_STATE_EMPTY    2       /* 程序区没有程序（向量表不对） */
+
+#if PDM_CFG_BOOT
+
+/* 回复命令后（PDM_CFG_BOOT_DELAY_MS）复位进入引导程序 */
+void PDM_Boot_Request(void);
+
+/* CAN 任务调用：请求到时间后写备份寄存器并复位 */
+void PDM_Boot_Poll(uint32_t now);
+
+#endif /* PDM_CFG_BOOT */
+
+#endif /* PDM_BOOT_H */
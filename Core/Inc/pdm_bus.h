@@ -0,0 +1,57 @@
+#ifndef PDM_BUS_H
+#define PDM_BUS_H
+
+#include <stdint.h>
+#include "pdm_config.h"
+#include "ina226_async.h"
+
+/*
+ * 采集与使用者之间的事件分发。
+ * 采集每得到一个通道的结果发布 PDM_BUS_EV_SAMPLE，每组采样完成时发布 PDM_BUS_EV_GROUP；
+ * 订阅表由使用者静态定义（与调度任务表相同），按表中顺序（优先级）逐个调用，
+ * 事件中的 snap 指向采集处理中的结果，不复制，只在回调期间有效。
+ * 每个订阅有自己的抽取比（每 decim 个事件调用一次，SAMPLE 事件按通道分别计数），运行中可以修改；
+ * 新增使用者只在表中加一行，采集代码不变。回调中不能等待（I2C 阻塞读写、flash 擦除等）。
+ * 调度器中 sample 任务的运行时间包括所有回调，每个订阅的次数和最长时间用命令行 sub 查看。
+ */
+
+#define PDM_BUS_EV_SAMPLE       0       /* 一个通道的新结果 */
+#define PDM_BUS_EV_GROUP        1       /* 一组采样完成（所有在线通道） */
+
+#define PDM_BUS_MAX_SUBS        12
+
+typedef struct {
+    uint8_t type;                       /* PDM_BUS_EV_* */
+    uint8_t ch;                         /* SAMPLE：通道号 */
+    uint8_t mask;                       /* GROUP：本组有新结果的通道位 */
+    uint32_t ts_us;                     /* 开始读取的时间（PDM_Sched_NowUs()）；GROUP 为发布时间 */
+    const ina226_regs_t *snap;          /* SAMPLE：零点修正后的寄存器值；GROUP 为 NULL */
+} pdm_bus_event_t;
+
+typedef struct {
+    const char *name;
+    uint8_t type;                       /* 订阅的事件 */
+    uint8_t decim;                      /* 默认抽取比，1 为每个事件，0 为停用 */
+    void (*on_event)(const pdm_bus_event_t *ev);
+} pdm_bus_sub_t;
+
+typedef struct {
+    uint32_t calls;
+    uint32_t max_us;
+} pdm_bus_stat_t;
+
+void PDM_Bus_Init(const pdm_bus_sub_t *subs, uint8_t count);
+
+/* 发布事件，按订阅表顺序调用 */
+void PDM_Bus_Publish(const pdm_bus_event_t *ev);
+
+/* 修改第 i 个订阅的抽取比；返回 0 成功，1 无此订阅 */
+uint8_t PDM_Bus_SetDecim(uint8_t i, uint8_t decim);
+
+/* 按名字查找订阅，没有时返回 0xFF */
+uint8_t PDM_Bus_Find(const char *name);
+
+/* 命令行 sub：每个订阅的事件、抽取比、调用次数和最长时间 */
+void PDM_Bus_Print(void);
+
+#endif /* PDM_BUS_H */
@@ -0,0 +1,36 @@
+#ifndef PDM_CAL_H
+#define PDM_CAL_H
+
+#include <stdint.h>
+#include "pdm_config.h"
+
+/*
+ * 每通道两点标定。采样电阻的公差和温漂使按标称值算出的校准寄存器带增益误差，分流放大器和 PCB 热电势带来零点偏移。
+ *   零点：负载断开（电流为 0）时平均 PDM_CFG_CAL_SAMPLES 个分流电压采样，平均值作为零点修正（运行参数 0x40 + 通道）
+ *   参考点：流过已知电流 ref_mA（外接电流表读数，放电为正）时同样平均，减去零点修正后
+ *     实际电阻 = 分流电压 / ref_mA，写入采样电阻（运行参数 0x10 + 通道），校准寄存器按它重算，增益在芯片中修正，运行时不增加计算
+ * 先做零点再做参考点。结果只改 RAM 中的运行参数，确认后用 param save 保存。
+ * 零点修正在每个采样的寄存器值上减去（pdm_calc_trim_offset()），CAN、能量、统计都用修正后的值；
+ * INA228 通道的 ENERGY/CHARGE 累计寄存器不做零点修正。
+ * 参考电流越大越准：分流电压分辨率 2.5 uV，4 mOhm、5 A 时为 20 mV，平均 64 次后量化误差约万分之一；
+ * 分流电压不到 1 mV 或算出的电阻与当前值相差超过 20% 时认为接线或参考电流有误，不修改参数。
+ * 完成时在 PDM_CMD_REPLY_ID 发送 [0x0A, 结果, 通道, 点, 值 (4，大端)]：结果 0 成功（值为零点修正或电阻 uOhm），1 失败。
+ */
+
+#if PDM_CFG_CAL
+
+#define PDM_CAL_ZERO            0
+#define PDM_CAL_REF             1
+
+/* 开始标定一个点，ref_mA 为参考电流（零点时忽略）；返回 0 成功，1 参数错误或该通道正在标定 */
+uint8_t PDM_Cal_Start(uint8_t ch, uint8_t point, int32_t ref_mA);
+
+/* 每个有效采样调用，shunt_raw 为零点修正前的分流电压寄存器值 */
+void PDM_Cal_Add(uint8_t ch, int16_t shunt_raw);
+
+/* 命令行 cal：各通道标定进度和最近一次结果 */
+void PDM_Cal_Print(void);
+
+#endif /* PDM_CFG_CAL */
+
+#endif /* PDM_CAL_H */
@@ -0,0 +1,252 @@
+#ifndef PDM_CALC_H
+#define PDM_CALC_H
+
+#include <stdint.h>
+#if defined(__ARM_FEATURE_SAT)
+#include <arm_acle.h>
+#endif
+
+/*
+ * INA226 原始寄存器到物理量的整数换算。
+ * 只依赖 stdint，不调用 HAL，采样路径和 CAN 组帧都用这里的常量，不使用浮点。
+ */
+
+/* 默认采样电阻 (uOhm) 和电流 LSB (uA)，通道表没有特别指定时使用 */
+#define PDM_SHUNT_UOHM              4000
+
+/* 固定寄存器分辨率（INA226 手册） */
+#define PDM_BUS_UV_PER_LSB          1250        /* 总线电压 1.25 mV/LSB */
+#define PDM_SHUNT_NV_PER_LSB        2500        /* 分流电压 2.5 uV/LSB */
+
+/* 满量程 81.92 mV 对应 2^15：current_lsb = 81.92 mV / R / 32768 = 2.5 uV / R */
+#define PDM_CURRENT_UA_PER_LSB      (2500000 / PDM_SHUNT_UOHM)
+
+#if (2500000 % PDM_SHUNT_UOHM) != 0
+#error "PDM_SHUNT_UOHM must divide 2500000 so that the current LSB is an integer in uA"
+#endif
+
+/* CAN 报文分辨率见 pdm_signals.h */
+
+/* 累计到 655.36 Wh（CAN 字段 65536 x 10 mWh）后回绕 */
+#define PDM_ENERGY_WRAP_UWH         655360000ULL
+
+/*
+ * 每个通道的换算常量，由采样电阻和电流 LSB 用 PDM_CALC_SCALE() 在编译期算出，
+ * 启动时直接写校准寄存器，采样路径只做整数乘法。
+ * 能量累计器单位：该通道功率寄存器 LSB x 1 us（默认 15.625 nJ），64 位整数，不丢精度。
+ */
+typedef struct {
+    uint32_t shunt_uohm;
+    uint32_t current_ua_per_lsb;
+    uint32_t power_uw_per_lsb;          /* 25 x 电流 LSB */
+    uint16_t cal;                       /* 校准寄存器值 */
+    uint64_t energy_acc_per_uwh;        /* 1 uWh = 3.6e9 uW*us */
+    uint64_t energy_acc_wrap;
+} pdm_scale_t;
+
+/* 校准寄存器 = 0.00512 / (current_lsb x R)，四舍五入 */
+#define PDM_CALC_CAL(shunt_uohm, ua_per_lsb) \
+    ((5120000000ULL + (uint64_t)(ua_per_lsb) * (shunt_uohm) / 2u) / ((uint64_t)(ua_per_lsb) * (shunt_uohm)))
+
+#define PDM_CALC_SCALE(shunt_uohm, ua_per_lsb) {                                  \
+    (shunt_uohm), (ua_per_lsb), 25u * (ua_per_lsb),                             \
+    (uint16_t)PDM_CALC_CAL(shunt_uohm, ua_per_lsb),                             \
+    3600000000ULL / (25u * (ua_per_lsb)),                                       \
+    PDM_ENERGY_WRAP_UWH * (3600000000ULL / (25u * (ua_per_lsb))) }
+
+/* 编译期检查用：校准值在 1~32767 之间（寄存器 15 位），功率 LSB 整除 3.6e9 uW*us */
+#define PDM_CALC_SCALE_OK(shunt_uohm, ua_per_lsb)                                \
+    (PDM_CALC_CAL(shunt_uohm, ua_per_lsb) >= 1u &&                              \
+     PDM_CALC_CAL(shunt_uohm, ua_per_lsb) <= 32767u &&                          \
+     3600000000ULL % (25u * (ua_per_lsb)) == 0)
+
+static inline int32_t pdm_calc_bus_mV(uint16_t raw)
+{
+    return ((int32_t)raw * PDM_BUS_UV_PER_LSB + 500) / 1000;
+}
+
+static inline int32_t pdm_calc_current_uA(int16_t raw, const pdm_scale_t *sc)
+{
+    return (int32_t)raw * (int32_t)sc->current_ua_per_lsb;
+}
+
+static inline uint32_t pdm_calc_power_uW(uint16_t raw, const pdm_scale_t *sc)
+{
+    return (uint32_t)raw * sc->power_uw_per_lsb;
+}
+
+/* 电流 (mA) 换算为分流电压寄存器值（mA x uOhm = nV），用于 ALERT 门限 */
+static inline int32_t pdm_calc_shunt_raw_from_mA(int32_t mA, const pdm_scale_t *sc)
+{
+    return (int32_t)((int64_t)mA * (int32_t)sc->shunt_uohm / PDM_SHUNT_NV_PER_LSB);
+}
+
+/* 功率 (mW) 换算为功率寄存器值 */
+static inline uint32_t pdm_calc_power_raw_from_mW(uint32_t mW, const pdm_scale_t *sc)
+{
+    return (uint32_t)((uint64_t)mW * 1000u / sc->power_uw_per_lsb);
+}
+
+/* 总线电压 (mV) 换算为总线电压寄存器值 */
+static inline uint32_t pdm_calc_bus_raw_from_mV(uint32_t mV)
+{
+    return mV * 1000u / PDM_BUS_UV_PER_LSB;
+}
+
+/* 累加一个采样区间的能量，到回绕点后减去一整圈，保持与 CAN 字段一致 */
+static inline void pdm_calc_energy_add(uint64_t *acc, uint16_t raw_power, uint32_t dt_us,
+                                       const pdm_scale_t *sc)
+{
+    *acc += (uint64_t)raw_power * dt_us;
+    if (*acc >= sc->energy_acc_wrap)
+    {
+        *acc -= sc->energy_acc_wrap;
+    }
+}
+
+/* 直接累加已换算成累计器单位的能量（INA228 片上 ENERGY 的差值） */
+static inline void pdm_calc_energy_add_units(uint64_t *acc, uint64_t units, const pdm_scale_t *sc)
+{
+    *acc += units;
+    while (*acc >= sc->energy_acc_wrap)
+    {
+        *acc -= sc->energy_acc_wrap;
+    }
+}
+
+/* 梯形法积分：raw 是芯片在 window_us 内的平均功率，覆盖区间末尾的 window_us；
+ * 剩余 dt_us - window_us 的时间没有被芯片测到，用前后两次的平均值补上 */
+static inline void pdm_calc_energy_add_trapz(uint64_t *acc, uint16_t prev_raw, uint16_t raw,
+                                             uint32_t dt_us, uint32_t window_us,
+                                             const pdm_scale_t *sc)
+{
+    uint32_t covered = (dt_us < window_us) ? dt_us : window_us;
+    uint32_t gap = dt_us - covered;
+
+    *acc += (uint64_t)raw * covered;
+    *acc += ((uint64_t)((uint32_t)prev_raw + raw) * gap) / 2;
+    if (*acc >= sc->energy_acc_wrap)
+    {
+        *acc -= sc->energy_acc_wrap;
+    }
+}
+
+/* 有符号功率：电流寄存器 x 总线电压寄存器，单位为功率 LSB 的 1/20000
+ * （功率寄存器 = |电流| x 电压 / 20000，不带方向），不需要另外读寄存器 */
+#define PDM_POWER_SIGNED_PER_RAW    20000
+
+static inline int32_t pdm_calc_power_signed(int16_t raw_current, uint16_t raw_bus)
+{
+    return (int32_t)raw_current * (int32_t)raw_bus;
+}
+
+/* 按方向累加一个采样区间的能量：放电（正）加到 dis，充电（负）加到 chg，
+ * 单位和回绕与 pdm_calc_energy_add() 相同。积分方式同 pdm_calc_energy_add_trapz()，
+ * window_us 不小于 dt_us 时就是矩形法 */
+static inline void pdm_calc_energy_add_dir(uint64_t *dis, uint64_t *chg, int32_t prev_p, int32_t p,
+                                           uint32_t dt_us, uint32_t window_us,
+                                           const pdm_scale_t *sc)
+{
+    uint32_t covered = (dt_us < window_us) ? dt_us : window_us;
+    uint32_t gap = dt_us - covered;
+    int64_t e = (int64_t)p * covered + ((int64_t)prev_p + p) * gap / 2;
+    uint64_t *acc = dis;
+
+    if (e < 0)
+    {
+        e = -e;
+        acc = chg;
+    }
+    *acc += (uint64_t)e / PDM_POWER_SIGNED_PER_RAW;
+    if (*acc >= sc->energy_acc_wrap)
+    {
+        *acc -= sc->energy_acc_wrap;
+    }
+}
+
+static inline uint32_t pdm_calc_energy_uWh(uint64_t acc, const pdm_scale_t *sc)
+{
+    return (uint32_t)(acc / sc->energy_acc_per_uwh);
+}
+
+/* 电荷累计器（电流 LSB x us，有符号）换算为 0.1 mAh（1 mAh = 3.6e12 uA*us，0.1 mAh = 3.6e11） */
+static inline int32_t pdm_calc_charge_100uAh(int64_t acc, const pdm_scale_t *sc)
+{
+    return (int32_t)(acc * (int64_t)sc->current_ua_per_lsb / 360000000000LL);
+}
+
+/* INA226 平均次数编码 (ina226_avg_t) 对应的次数 */
+static inline uint32_t pdm_calc_avg_count(uint8_t code)
+{
+    static const uint16_t count[8] = {1, 4, 16, 64, 128, 256, 512, 1024};
+    return count[code & 0x07];
+}
+
+/* INA226 转换时间编码 (ina226_conversion_time_t) 对应的微秒数 */
+static inline uint32_t pdm_calc_conv_time_us(uint8_t code)
+{
+    static const uint16_t us[8] = {140, 204, 332, 588, 1100, 2116, 4156, 8244};
+    return us[code & 0x07];
+}
+
+/* 连续模式下一个平均结果覆盖的时间：平均次数 x (总线转换 + 分流转换) */
+static inline uint32_t pdm_calc_window_us(uint8_t avg, uint8_t bus_ct, uint8_t shunt_ct)
+{
+    return pdm_calc_avg_count(avg) * (pdm_calc_conv_time_us(bus_ct) + pdm_calc_conv_time_us(shunt_ct));
+}
+
+/* 配置寄存器值：bit14 保留（上电值为 1），AVG 11:9，VBUSCT 8:6，VSHCT 5:3，MODE 2:0。
+ * 一次写入整个寄存器，不用驱动的读-改-写 */
+static inline uint16_t pdm_calc_conf(uint8_t avg, uint8_t bus_ct, uint8_t shunt_ct, uint8_t mode)
+{
+    return (uint16_t)(0x4000u | (uint16_t)(avg & 0x07u) << 9 | (uint16_t)(bus_ct & 0x07u) << 6 |
+                      (uint16_t)(shunt_ct & 0x07u) << 3 | (mode & 0x07u));
+}
+
+/* 饱和转换，与原先的浮点钳位行为一致（向零取整）。Cortex-M3 上用一条 SSAT 指令 */
+static inline int16_t pdm_calc_sat_i16(int32_t v)
+{
+#if defined(__ARM_FEATURE_SAT)
+    return (int16_t)__ssat(v, 16);
+#else
+    if (v > 32767) return 32767;
+    if (v < -32768) return -32768;
+    return (int16_t)v;
+#endif
+}
+
+static inline uint16_t pdm_calc_sat_u16(uint32_t v)
+{
+    return (v > 65535u) ? 65535u : (uint16_t)v;
+}
+
+/* 零点修正：分流电压寄存器减去 offset（2.5 uV/LSB）。芯片的电流寄存器 = 分流 x CAL / 2048，
+ * 修正量按同样的乘法右移算出；功率寄存器按修正后的电流重新计算（|电流| x 总线电压 / 20000），
+ * 与芯片的算法一致，后面的换算和积分不用改。增益修正折算到采样电阻里，由校准寄存器完成 */
+static inline void pdm_calc_trim_offset(int16_t *shunt, int16_t *current, uint16_t *power, uint16_t bus,
+                                        int16_t offset, uint16_t cal)
+{
+    int32_t i = pdm_calc_sat_i16((int32_t)*current - (((int32_t)offset * (int32_t)cal) >> 11));
+
+    *shunt = pdm_calc_sat_i16((int32_t)*shunt - offset);
+    *current = (int16_t)i;
+    *power = pdm_calc_sat_u16((uint32_t)((i < 0) ? -i : i) * bus / PDM_POWER_SIGNED_PER_RAW);
+}
+
+/* CRC16-CCITT（初值 0xFFFF，不反转），flash 记录和 UART 采样流共用 */
+static inline uint16_t pdm_calc_crc16(const uint8_t *p, uint32_t len)
+{
+    uint16_t crc = 0xFFFF;
+
+    while (len--)
+    {
+        crc ^= (uint16_t)(*p++) << 8;
+        for (uint8_t i = 0; i < 8; i++)
+        {
+            crc = (crc & 0x8000u) ? (uint16_t)((crc << 1) ^ 0x1021u) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+#endif /* PDM_CALC_H */
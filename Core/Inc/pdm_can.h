@@ -0,0 +1,138 @@
+#ifndef PDM_CAN_H
+#define PDM_CAN_H
+
+#include <stdint.h>
+#include "pdm_config.h"
+
+/*
+ * CAN 报文发送与周期管理。
+ * 报文表由使用者静态定义，每条报文可以单独设置发送周期，
+ * 也可以设置为每得到一组新采样就立即发送。同时统计本节点占用的总线负载。
+ * 设置了 keepalive_ms 的报文每次编码后与上次发出的内容比较，相同时不发送，
+ * 超过 keepalive_ms 没有发送时仍发一次，接收方据此判断节点在线。
+ * 有 changed 回调的报文可以改为按变化发送（max_ms 非 0）：不再按周期，每组新采样后编码一次，
+ * 回调判断与上次发出的内容相比超过死区、且距上次发送不少于 min_ms 时发送；
+ * 变化时还没到 min_ms 的，由 PDM_Can_Run() 在到时后补发；超过 max_ms 没有发送时总是发送。
+ * 所有帧先进入按 ID 排序的软件队列，由 TX 邮箱空中断依次送出。
+ * 接收只开 FIFO0，中断中把通过过滤器的帧复制到接收队列，由主循环取出处理。
+ * 多节点时发送和接收的 ID 在这里按节点号换算（pdm_node.h），报文表和使用者都只用节点 0 的 ID。
+ */
+
+typedef struct {
+    uint32_t id;
+    uint8_t dlc;
+    void (*encode)(uint8_t *data, const void *arg);    /* 填充 dlc 字节数据 */
+    const void *arg;
+    uint16_t period_ms;         /* 默认周期，0 表示不按周期发送 */
+    uint8_t on_sample;          /* 默认是否在每组新采样后立即发送 */
+    uint16_t keepalive_ms;      /* 0：每次都发送；非 0：内容不变时不发送，最长间隔该时间仍发一次 */
+    /* 按变化发送：data 与上次发出的 last 相比是否超过死区（1 发送）；NULL 表示不支持 */
+    uint8_t (*changed)(const uint8_t *data, const uint8_t *last, const void *arg);
+    uint16_t min_ms;            /* 按变化发送的默认最短/最长间隔，max_ms 为 0 时按周期发送 */
+    uint16_t max_ms;
+} pdm_can_msg_t;
+
+/* 收到的一帧标准数据帧 */
+typedef struct {
+    uint16_t id;
+    uint8_t dlc;
+    uint8_t data[8];
+    uint32_t t_us;              /* 接收中断中的 PDM_Sched_NowUs() */
+} pdm_can_frame_t;
+
+typedef struct {
+    uint32_t rx_frames;         /* 通过过滤器收到的帧数 */
+    uint32_t rx_drops;          /* 接收队列满丢弃的帧数 */
+    uint32_t tx_frames;         /* 已放入硬件邮箱的帧数 */
+    uint32_t tx_drops;          /* 发送队列满丢弃的帧数 */
+    uint32_t bits_last_s;       /* 上一秒发送的位数（按最坏位填充估算） */
+    uint16_t load_permille;     /* 上一秒本节点总线负载（千分比） */
+    uint16_t plan_permille;     /* 按当前周期配置估算的负载（千分比） */
+    uint8_t txq_hwm;            /* 发送队列最大深度 */
+    uint16_t busy_permille;     /* 上一秒其他节点占用总线的估计（千分比），见 PDM_CFG_CAN_LATENCY */
+    uint32_t tx_delayed;        /* 邮箱全空时放入、但等过其他节点的帧（仲裁失败或总线正忙）的帧数 */
+    uint32_t tx_unchanged;      /* 内容不变（或变化在死区内）没有发送的次数 */
+} pdm_can_stats_t;
+
+/* 一条报文的发送延迟：入队到发送完成 */
+typedef struct {
+    uint32_t n;
+    uint64_t sum_us;
+    uint32_t max_us;
+} pdm_can_lat_t;
+
+/* 报文表最多条数 */
+#define PDM_CAN_MAX_MSGS        20
+
+/* 发送延迟分档数：档 0 < 256 us，之后每档加倍，最后一档 >= 65536 us */
+#define PDM_CAN_LAT_BINS        10
+
+/* 放入邮箱到发送完成超过自身帧长 + 该值 (us) 时，认为放入时总线正忙（留给中断响应的余量） */
+#define PDM_CAN_LAT_SLACK_US    50
+
+/* 最短发送周期 (ms) */
+#define PDM_CAN_MIN_PERIOD_MS   10
+
+void PDM_Can_Init(const pdm_can_msg_t *msgs, uint8_t count, uint32_t now);
+
+/* 发送到期的周期报文，由调度器周期调用 */
+void PDM_Can_Run(uint32_t now);
+
+/* 新一组采样完成时调用，立即发送设置为“采样后发送”的报文 */
+void PDM_Can_OnSample(void);
+
+/* 修改报文发送方式，period_ms 为 0 关闭周期发送；返回 0 成功，1 报文不存在 */
+uint8_t PDM_Can_SetSchedule(uint32_t id, uint16_t period_ms, uint8_t on_sample);
+
+/* 修改按变化发送的最短/最长间隔，max_ms 为 0 回到按周期发送；
+ * 返回 0 成功，1 报文不存在或没有 changed 回调 */
+uint8_t PDM_Can_SetChange(uint32_t id, uint16_t min_ms, uint16_t max_ms);
+
+/* 立即发送一次周期报文（内容不变也发送），下一次周期发送从 now 重新计时；返回 0 成功，1 报文不存在 */
+uint8_t PDM_Can_SendNow(uint32_t id, uint32_t now);
+
+/* 发送一帧标准数据帧：放入按 ID 排序的软件队列，邮箱空出时在中断中继续发送。
+ * 队列满时丢弃优先级最低的帧；返回 0 已放入队列，1 新帧被丢弃 */
+uint8_t PDM_Can_Send(uint32_t id, const uint8_t *data, uint8_t dlc);
+
+/* 同 PDM_Can_Send，可在中断中调用（不打印日志，丢弃只计数） */
+uint8_t PDM_Can_SendFromIsr(uint32_t id, const uint8_t *data, uint8_t dlc);
+
+/* 接收过滤器的组数（F103 单 CAN）和每组在 16 位列表模式下的 ID 数 */
+#define PDM_CAN_FILTER_BANKS    14
+#define PDM_CAN_FILTER_PER_BANK 4
+
+/* 按 ID 表配置接收过滤器：ids 为总线上的标准数据帧 ID，16 位列表模式每组放 4 个（IDE、RTR 也比较，
+ * 扩展帧和远程帧不通过），重复的 ID 只放一次，组内剩余位置重复本组第一个 ID，其余组关闭；
+ * 不在表中的帧由硬件丢弃，不进入中断。返回 0 成功，1 ID 超过 14 x 4 个（超出的不接收） */
+uint8_t PDM_Can_SetRxFilter(const uint16_t *ids, uint8_t n);
+
+/* 取出一帧收到的报文（RX FIFO0 中断放入接收队列）；返回 0 成功，1 队列为空 */
+uint8_t PDM_Can_Read(pdm_can_frame_t *frame);
+
+/* 当前发送队列中等待的帧数 */
+uint8_t PDM_Can_TxQueueLen(void);
+
+const pdm_can_stats_t *PDM_Can_GetStats(void);
+
+/* 一帧标准数据帧在最坏位填充下的位数 */
+uint32_t PDM_Can_FrameBits(uint8_t dlc);
+
+#if PDM_CFG_CAN_LATENCY
+/*
+ * 本节点各帧的发送延迟（PDM_CFG_CAN_LATENCY=1）。入队时记录时间，邮箱发送完成中断中计算入队到完成的时间，
+ * 按报文表逐条统计（次数、平均、最大），所有帧另计入对数分档。
+ * 总线占用估计：放入邮箱时三个邮箱都空的帧（不排在本节点自己的帧后面）中，
+ * 放入到完成超过自身帧长的比例即为放入时刻总线被其他节点占用（或仲裁失败）的概率，
+ * 本节点的帧随采样和周期发出，与其他节点的帧时间上不相关，这个比例近似为其他节点的总线负载。
+ * 自动重发时 TSR.ALSTx 只反映最后一次（成功的）尝试，仲裁失败不单独计数，包含在上面的等待里。
+ */
+
+/* 清零延迟统计 */
+void PDM_Can_LatReset(void);
+
+/* 命令行 canlat：各报文的次数、平均和最大延迟，延迟分档，其他节点负载估计和等待过的帧数 */
+void PDM_Can_LatPrint(void);
+#endif
+
+#endif /* PDM_CAN_H */
@@ -0,0 +1,75 @@
+#ifndef PDM_CANHEALTH_H
+#define PDM_CANHEALTH_H
+
+#include <stdint.h>
+#include "pdm_config.h"
+
+/*
+ * CAN 总线错误统计。打开 bxCAN 的错误中断（SCE），在 HAL_CAN_ErrorCallback 中读 ESR：
+ * 按最近错误代码（LEC）分类计数错误帧，记录进入错误警告、错误被动、离线（bus-off）的次数；
+ * 离线恢复时间为进入离线到下一帧发送成功（AutoBusOff 自动恢复，至少 128 x 11 个隐性位，500 kbps 约 2.8 ms）。
+ * 离开错误被动和离线没有中断，由 PDM_CanHealth_Poll() 读 ESR 判断，同时更新 TEC/REC 和最大值。
+ * 线束干扰严重时每个错误帧都会进中断，1 s 内超过 PDM_CFG_CANH_LEC_LIMIT 个后暂停 LEC 中断到下一秒，
+ * 该秒的错误帧数按上限计。
+ * PDM_CANH_CAN_ID 帧（1 s）：[TEC, REC, 最近错误代码 << 4 | 状态, 离线次数, 错误被动次数, 上一秒错误帧数,
+ *   最近一次离线恢复时间 (2, 0.1 ms/LSB)]，次数到 255 保持，大端。
+ * 状态 bit0 错误警告，bit1 错误被动，bit2 离线，bit3 LEC 中断已暂停。
+ */
+
+#if PDM_CFG_CANH
+
+#define PDM_CANH_CAN_ID         0x30A
+
+#define PDM_CANH_WARNING        0x01
+#define PDM_CANH_PASSIVE        0x02
+#define PDM_CANH_BUSOFF         0x04
+#define PDM_CANH_THROTTLED      0x08
+
+/* 最近错误代码（ESR.LEC） */
+#define PDM_CANH_LEC_STUFF      1
+#define PDM_CANH_LEC_FORM       2
+#define PDM_CANH_LEC_ACK        3
+#define PDM_CANH_LEC_BIT1       4       /* 发送隐性位读回显性 */
+#define PDM_CANH_LEC_BIT0       5       /* 发送显性位读回隐性 */
+#define PDM_CANH_LEC_CRC        6
+
+typedef struct {
+    uint8_t tec;                /* 发送错误计数 */
+    uint8_t rec;                /* 接收错误计数 */
+    uint8_t tec_max;
+    uint8_t rec_max;
+    uint8_t state;              /* PDM_CANH_* */
+    uint8_t lec;                /* 最近错误代码 */
+    uint16_t err_last_s;        /* 上一秒的错误帧数 */
+    uint32_t lec_count[7];      /* 按错误代码分类的错误帧数，下标为错误代码（0 不用） */
+    uint16_t warnings;          /* 进入错误警告的次数 */
+    uint16_t passives;          /* 进入错误被动的次数 */
+    uint16_t busoffs;           /* 进入离线的次数 */
+    uint32_t rx_overruns;       /* 接收 FIFO0 溢出次数 */
+    uint32_t passive_ms;        /* 累计错误被动时间 (ms) */
+    uint32_t passive_max_ms;    /* 最长一次错误被动 (ms) */
+    uint32_t busoff_last_us;    /* 最近一次离线恢复时间 (us) */
+    uint32_t busoff_max_us;
+} pdm_canh_stats_t;
+
+/* 打开错误中断，在 PDM_Can_Init() 之后调用 */
+void PDM_CanHealth_Init(uint32_t now);
+
+/* 发送邮箱完成一帧（中断中调用） */
+void PDM_CanHealth_OnTxDone(void);
+
+/* 读 ESR，判断离开错误被动/离线，每秒更新错误帧数，由 CAN 任务周期调用 */
+void PDM_CanHealth_Poll(uint32_t now);
+
+/* 复制当前统计 */
+void PDM_CanHealth_Get(pdm_canh_stats_t *out);
+
+/* CAN 帧编码（报文表回调） */
+void PDM_CanHealth_Encode(uint8_t *data, const void *arg);
+
+/* 通过 UART 输出统计 */
+void PDM_CanHealth_Print(void);
+
+#endif /* PDM_CFG_CANH */
+
+#endif /* PDM_CANHEALTH_H */
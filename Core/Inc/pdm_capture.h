@@ -0,0 +1,114 @@
+#ifndef PDM_CAPTURE_H
+#define PDM_CAPTURE_H
+
+#include <stdint.h>
+#include "pdm_config.h"
+#include "driver_ina226.h"
+#include "pdm_calc.h"
+
+/*
+ * 瞬态高速采集（风扇、水泵启动电流等）。
+ * 武装后采集通道以最快速度转换，I2C 完成中断中连续读取分流电压寄存器，
+ * 样本（电流原始值 + 与上一样本的时间间隔）写入环形缓冲区。
+ * 电流超过门限时芯片拉低 ALERT（SOL 功能），记录触发位置，
+ * 再采满触发后的样本后停止，恢复正常配置，通过 CAN 发出：
+ *   PDM_CAPTURE_HDR_ID  [通道, 样本数(2), 触发前样本数(2), 触发来源, 格式, 0]
+ *   PDM_CAPTURE_DATA_ID 格式 0：每帧两个样本 [电流(2), 间隔us(2), 电流(2), 间隔us(2)]
+ *                       格式 1 (PDM_CFG_CAPTURE_PACK)：[序号, 压缩数据最多 7 字节]，去掉序号后依次拼接，
+ *                       每 16 个样本为电流块 + 间隔块（块格式见 pdm_pack.h）
+ * 电流原始值为分流电压寄存器，625 uA/LSB，有符号大端。
+ *
+ * 只测电流的高速采样流（PDM_CFG_CAPTURE_FAST，命令 0x0C / 命令行 fast 1 开始、fast 0 停止）：
+ * 采集通道改为只转换分流电压（140 us、不平均、连续转换），I2C 完成中断中连续读分流电压寄存器
+ * （PDM_CFG_I2C_STICKY，不写寄存器地址），与上一个样本间隔不到 PDM_CFG_CAPTURE_FAST_MIN_US 的读取
+ * 读到的是同一次转换，不输出。样本放入同一个缓冲区（作 FIFO），主循环每攒满 PDM_CFG_CAPTURE_FAST_BLOCK 个
+ * 经 UART 二进制采样流输出一个电流帧（pdm_stream.h 类型 0x05）。停止前一直占用采集通道，其他通道照常采样。
+ * 最高速率由转换时间决定：140 us 一次，约 7.1 kS/s；每次读取在 400 kHz 下约 70 us，读到新转换的时刻
+ * 比转换完成晚 0~1 次读取，实际输出约 5.5 kS/s（接近 1 / (140 us + 半次读取)），同一总线上其他通道的读取会再降低一些。
+ * 丢弃的样本：缓冲区满（主循环来不及取出）和 UART 日志缓冲区满（整帧）两种，累计数写在每个电流帧中，
+ * 停止时和命令行 fast 输出读取次数、样本数、实际速率和两种丢弃数。
+ *
+ * 上电冲击电流采集（PDM_CFG_CAPTURE_BOOT）：main() 中 I2C 初始化后立即调用 PDM_Capture_Boot()，
+ * 写一次配置寄存器（140 us、不平均、只转换分流电压）后开始连续读取，其余初始化照常进行。
+ * 主循环的阻塞读写（器件初始化、保护门限等）期间读取在完成回调中停下，由 SysTick 中断在总线释放后继续，
+ * 间隔记在样本中。前 PDM_CFG_CAPTURE_BOOT_FULL 个样本全速记录，之后把剩余时间平均分给剩余位置，
+ * 每段保存绝对值最大的一个样本（时间为它自己的读取时间），PDM_CFG_CAPTURE_BOOT_MS 后结束，
+ * 恢复正常配置并按上面的格式发送，触发来源 PDM_CAPTURE_TRIG_BOOT，触发前样本数为 0。
+ */
+
+#define PDM_CAPTURE_HDR_ID      0x320
+#define PDM_CAPTURE_DATA_ID     0x321
+
+/* 数据帧格式 */
+#define PDM_CAPTURE_FMT_RAW     0
+#define PDM_CAPTURE_FMT_PACK    1
+
+/* 触发来源 */
+#define PDM_CAPTURE_TRIG_ALERT  1
+#define PDM_CAPTURE_TRIG_MANUAL 2
+#define PDM_CAPTURE_TRIG_BOOT   3
+
+#if PDM_CFG_CAPTURE
+
+#if PDM_CFG_SAMPLE_ON_ALERT
+#error "PDM_CFG_CAPTURE uses the ALERT pin for the current limit, it cannot be combined with PDM_CFG_SAMPLE_ON_ALERT"
+#endif
+#if PDM_CFG_CAPTURE_PRE >= PDM_CFG_CAPTURE_SAMPLES
+#error "PDM_CFG_CAPTURE_PRE must be smaller than PDM_CFG_CAPTURE_SAMPLES"
+#endif
+
+/* h: 采集通道的句柄（已完成初始化），avg: 该通道正常采样时的平均次数，采集结束后恢复，
+ * scale: 该通道的换算常量（触发门限换算用） */
+void PDM_Capture_Init(ina226_handle_t *h, ina226_avg_t avg, const pdm_scale_t *scale);
+
+#if PDM_CFG_CAPTURE_BOOT
+#if PDM_CFG_CAPTURE_BOOT_FULL >= PDM_CFG_CAPTURE_SAMPLES
+#error "PDM_CFG_CAPTURE_BOOT_FULL must be smaller than PDM_CFG_CAPTURE_SAMPLES"
+#endif
+
+/* 上电采集：iic_addr 为采集通道的器件地址，在 PDM_Capture_Init() 之前调用；返回 0 开始，1 写配置失败 */
+uint8_t PDM_Capture_Boot(uint8_t iic_addr);
+
+/* SysTick 中断调用：阻塞读写结束后继续读取，到时间后结束 */
+void PDM_Capture_Tick(void);
+
+/* 第一个样本的时间（PDM_Sched_NowUs()），还没有样本时为 0 */
+uint32_t PDM_Capture_BootFirstUs(void);
+
+/* 命令行 startup：样本数、读取次数和停下等待总线的次数 */
+void PDM_Capture_PrintBoot(void);
+#endif
+
+/* 正常采样的平均次数已修改（运行参数），下一次采集结束后恢复为新值；触发门限在下一次武装时按 scale 重新换算 */
+void PDM_Capture_SetAvg(ina226_avg_t avg);
+
+/* 未武装时武装；已武装时立即手动触发。返回 0 成功，1 正在采集或发送 */
+uint8_t PDM_Capture_Arm(void);
+
+/* 1: 采集通道正处于高速采集配置（已武装、采集中或还没恢复），其他模块不要改它的配置 */
+uint8_t PDM_Capture_Active(void);
+
+/* ALERT 引脚下降沿（EXTI 中断中调用），ch: 0 ALERT1，1 ALERT2 */
+void PDM_Capture_OnAlert(uint8_t ch);
+
+/* 主循环调用：采集结束后恢复配置并分批发送 */
+void PDM_Capture_Run(void);
+
+/* 最近一次采集的字节数：6 字节头 [通道, 样本数(2), 触发前样本数(2), 触发来源]
+ * 加每样本 4 字节 [电流(2), 间隔 us(2)]，格式同 CAN 帧；没有可读数据（未采集或已重新武装）时为 0 */
+uint32_t PDM_Capture_Size(void);
+
+/* 按上面的格式复制 [off, off + n) 到 buf；返回 0 成功，1 越界或数据已失效 */
+uint8_t PDM_Capture_Read(uint32_t off, uint8_t *buf, uint8_t n);
+
+#if PDM_CFG_CAPTURE_FAST
+/* 开始 (on = 1，空闲或已武装时) 或停止高速采样流；返回 0 成功，1 正在采集/发送或配置失败 */
+uint8_t PDM_Capture_Fast(uint8_t on);
+
+/* 命令行 fast：读取次数、样本数、速率和丢弃数 */
+void PDM_Capture_PrintFast(void);
+#endif
+
+#endif /* PDM_CFG_CAPTURE */
+
+#endif /* PDM_CAPTURE_H */
@@ -0,0 +1,36 @@
+#ifndef PDM_CLOCK_H
+#define PDM_CLOCK_H
+
+#include <stdint.h>
+#include "pdm_config.h"
+
+/*
+ * 空闲时降低时钟：主循环（或 RTOS 空闲任务）休眠前把 AHB 分频从 1 改为 2（HCLK 72 -> 36 MHz），
+ * 醒来后、处理唤醒它的中断之前恢复，采集、CAN 和其他任务都在 72 MHz 下运行。
+ * 休眠期间外设和 DMA 照常工作，时钟按下面的方式保持不变或补偿：
+ *   APB1  分频同时从 2 改为 1，PCLK1 保持 36 MHz，CAN 位时间和 I2C 时序不变；
+ *         先降 AHB 再改 APB1（恢复时相反），切换中间 PCLK1 只会短暂低于 36 MHz，不会超过
+ *   APB2  PCLK2 随 HCLK 减半，USART1 的 BRR 同时减半，波特率不变（BRR 小于 32 时不降频）
+ *   SysTick  当前 1 ms 剩下的计数和重装值按时钟换算，HAL_GetTick() 和 PDM_Sched_NowUs() 不变
+ * APB1 定时器的时钟会从 72 MHz 变为 36 MHz，PDM_TIMER_US（TIM2/3/4）开启时不能使用。
+ * ADC 时钟在休眠期间也减半，只影响 MCU 自监测转换的间隔。
+ * 命令行 clock 显示降频时间占比、切换次数和按 PDM_CFG_CLOCK_SAVE_UA 估算的平均节省电流。
+ */
+
+#if PDM_CFG_CLOCK_SCALE
+
+/* 中断关闭时调用：降频，返回 1 成功、0 没有降频（必须配对调用 PDM_Clock_Fast()） */
+uint8_t PDM_Clock_Slow(void);
+
+/* 中断关闭时调用：恢复 72 MHz */
+void PDM_Clock_Fast(void);
+
+/* 记录一次降频休眠的时间（恢复中断后按 PDM_Sched_NowUs() 量出） */
+void PDM_Clock_AddSlowUs(uint32_t us);
+
+/* 命令行 clock：距上次输出的降频时间占比和估算的节省电流 */
+void PDM_Clock_Print(void);
+
+#endif /* PDM_CFG_CLOCK_SCALE */
+
+#endif /* PDM_CLOCK_H */
@@ -0,0 +1,53 @@
+#ifndef PDM_CMD_H
+#define PDM_CMD_H
+
+#include <stdint.h>
+
+/*
+ * CAN 命令通道。
+ * VCU 向 PDM_CMD_CAN_ID 发送命令帧，PDM 处理后在 PDM_CMD_REPLY_ID 回复。
+ * 命令帧 data[0] 为命令码，回复帧 data[0] 为命令码，data[1] 为结果。
+ */
+
+#define PDM_CMD_CAN_ID          0x310
+#define PDM_CMD_REPLY_ID        0x311
+
+/* 命令码 */
+#define PDM_CMD_RESET_ENERGY    0x01    /* data[1]: 通道位 (bit0 BUS, bit1 BAT) */
+#define PDM_CMD_SET_SAMPLE      0x02    /* data[1..2]: 采样周期 ms，大端 */
+#define PDM_CMD_SET_CAN_PERIOD  0x03    /* data[1..2]: CAN ID, data[3..4]: 周期 ms, data[5]: 采样后发送 */
+#define PDM_CMD_CAPTURE         0x04    /* 触发一次高速采集 */
+#define PDM_CMD_LAP             0x05    /* 结束每圈统计窗口，data[1] = 1 时同时结束当前节（可省略） */
+#define PDM_CMD_BLACKBOX        0x06    /* data[1]: 0 冻结黑匣子, 1 清空并重新开始记录 */
+#define PDM_CMD_SET_FILTER      0x07    /* data[1]: 通道, data[2..3]: IIR alpha (Q15)，大端, data[4]: 1 中值滤波 */
+#define PDM_CMD_RESET_HIST      0x08    /* data[1]: 通道位，电流分布计数清零 */
+#define PDM_CMD_PARAM           0x09    /* data[1]: 操作；设置时 data[2]: 参数 ID（pdm_param.h），data[3..6]: 值，大端 */
+#define PDM_CMD_CAL             0x0A    /* data[1]: 通道, data[2]: 0 零点 / 1 参考点, data[3..6]: 参考电流 mA（有符号），大端 */
+#define PDM_CMD_TRIP_RESET      0x0B    /* data[1]: 通道位，复位过流/欠压切断（pdm_trip.h） */
+#define PDM_CMD_FAST            0x0C    /* data[1]: 1 开始、0 停止只测电流的高速采样流（PDM_CFG_CAPTURE_FAST） */
+#define PDM_CMD_SET_DECIM       0x0D    /* data[1]: 通道, data[2]: 抽取比 2^n 的 n（0 关闭，最大 8） */
+#define PDM_CMD_BOOT            0x0E    /* data[1..2]: 0xB0 0x07，回复后复位进入 CAN 引导程序（PDM_CFG_BOOT，pdm_boot.h） */
+
+/* PDM_CMD_PARAM 的操作 */
+#define PDM_PARAM_OP_SET        0       /* 修改 RAM 中的参数并立即应用 */
+#define PDM_PARAM_OP_SAVE       1       /* 保存到 flash（需要擦页时 CPU 停 20~40 ms） */
+#define PDM_PARAM_OP_DEFAULTS   2       /* 恢复默认值（flash 中的记录不变） */
+#define PDM_PARAM_OP_LOAD       3       /* 重新读入 flash 中的参数 */
+
+/* 回复结果 */
+#define PDM_CMD_OK              0x00
+#define PDM_CMD_ERR_ARG         0x01    /* 参数错误或当前不支持 */
+#define PDM_CMD_ERR_UNKNOWN     0x02    /* 未知命令码 */
+
+/* 执行一条命令（data[0] 命令码，格式同 CAN 命令帧，len >= 1），返回结果码。
+ * CAN 命令通道和 UART 命令行共用 */
+uint8_t PDM_Cmd_Exec(const uint8_t *data, uint8_t len);
+
+/* 配置 CAN 接收过滤器：按 pdm_cmd.c 中的接收 ID 表（命令帧和各个打开的功能，发给本节点的按节点号偏移），
+ * 16 位列表模式每个过滤器组 4 个 ID，其他报文由硬件丢弃，不进入中断。在 PDM_Monitor_Init() 确定节点号之后调用 */
+void PDM_Cmd_Init(void);
+
+/* 处理接收队列中的全部命令，由主循环调用 */
+void PDM_Cmd_Poll(void);
+
+#endif /* PDM_CMD_H */
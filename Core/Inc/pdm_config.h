@@ -0,0 +1,901 @@
+#ifndef PDM_CONFIG_H
+#define PDM_CONFIG_H
+
+/*
+ * PDM 编译期配置。
+ * 所有可选功能的开关和参数集中放在这里，可以在 Makefile 中用 -D 覆盖。
+ */
+
+/* 采样触发方式
+ * 0: 主循环按 INTERVAL_READ 定时读取
+ * 1: INA226 转换完成后通过 ALERT 引脚通知，收到通知立即读取 */
+#ifndef PDM_CFG_SAMPLE_ON_ALERT
+#define PDM_CFG_SAMPLE_ON_ALERT     0
+#endif
+
+/* 定时采样的时钟来源（PDM_CFG_SAMPLE_ON_ALERT 为 0 时）
+ * 0: 主循环按 HAL_GetTick() 判断 INTERVAL_READ 是否到期
+ * 1: TIM3 更新中断按周期发起读取，不受主循环中其他任务的耗时影响；
+ *    同时用 TIM2 + TIM4 提供 32 位微秒时间戳（PDM_Sched_NowUs()），见 pdm_timer.h */
+#ifndef PDM_CFG_SAMPLE_TIMER
+#define PDM_CFG_SAMPLE_TIMER        0
+#endif
+
+/* ALERT 边沿的硬件时间戳：PA1/PA3 同时设为 TIM2_CH2/CH4 下降沿输入捕获，
+ * ALERT 采样的样本时间取转换完成的边沿，ALERT 切断记录边沿到输出动作的时间；
+ * 开启时 TIM2 + TIM4 微秒计数器也作为 PDM_Sched_NowUs() 的来源（不需要 PDM_CFG_SAMPLE_TIMER），见 pdm_timer.h */
+#ifndef PDM_CFG_ALERT_CAPTURE
+#define PDM_CFG_ALERT_CAPTURE       0
+#endif
+
+/* ALERT 采样模式下，超过该时间 (ms) 未收到通知就主动读一次，防止漏掉边沿后停住 */
+#ifndef PDM_CFG_ALERT_FALLBACK_MS
+#define PDM_CFG_ALERT_FALLBACK_MS   200
+#endif
+
+/* 同步触发测量（只用于定时采样模式）
+ * 0: 各芯片连续转换，依次读出的结果属于不同的平均窗口
+ * 1: 每个采样周期把所有芯片背靠背写成单次触发模式，同时开始转换，
+ *    等一个平均窗口后作为一组读出，总线侧和电池侧的结果属于同一时间段 */
+#ifndef PDM_CFG_SYNC_TRIGGER
+#define PDM_CFG_SYNC_TRIGGER        0
+#endif
+
+/* INA226 数量，与 pdm_monitor.c 中的通道表一致。
+ * 通道 0、1 分别接 ALERT1、ALERT2，硬件保护和高速采集只用这两路 */
+#ifndef PDM_CFG_CHANNELS
+#define PDM_CFG_CHANNELS            2
+#endif
+
+/* INA226 采样配置（driver_ina226.h 中的枚举），也是运行参数（pdm_param.h）的默认值 */
+#ifndef PDM_CFG_INA226_AVG
+#define PDM_CFG_INA226_AVG          INA226_AVG_16
+#endif
+#ifndef PDM_CFG_INA226_BUS_CT
+#define PDM_CFG_INA226_BUS_CT       INA226_CONVERSION_TIME_1P1_MS
+#endif
+#ifndef PDM_CFG_INA226_SHUNT_CT
+#define PDM_CFG_INA226_SHUNT_CT     INA226_CONVERSION_TIME_1P1_MS
+#endif
+
+/* 第二条传感器总线 I2C2（PB10/PB11）
+ * 0: 所有 INA226 在 I2C1 上
+ * 1: 通道表中总线为 1 的器件在 I2C2 上，两条总线的事务队列各自在中断中执行、同时传输，
+ *    通道较多时一轮读取的时间减半 */
+#ifndef PDM_CFG_I2C2
+#define PDM_CFG_I2C2                0
+#endif
+
+/* INA226 配置类寄存器（CONF、校准、MASK、报警门限）在接口层保留 RAM 副本，
+ * 驱动对 CONF、校准、报警门限的读-改-写和查询不再读总线；数据寄存器和 MASK 总是从器件读取
+ * （读 MASK 清除告警和转换完成标志），副本中的 MASK 使能位用于配置检查和写回 */
+#ifndef PDM_CFG_INA226_SHADOW
+#define PDM_CFG_INA226_SHADOW       1
+#endif
+
+/* 后台配置检查：每隔该时间 (ms) 在一组采样之后读一个通道的 CALIBRATION 或 CONF（各通道、两个寄存器轮流），
+ * 与寄存器副本不同时（电源跌落使器件复位回默认值）按副本重新写入；0 关闭，需要 PDM_CFG_INA226_SHADOW */
+#ifndef PDM_CFG_INA226_CHECK_MS
+#define PDM_CFG_INA226_CHECK_MS     (PDM_CFG_INA226_SHADOW ? 250 : 0)
+#endif
+
+/* 异步 2 字节读取（INA226 的全部采样读取）不经过 HAL_I2C_Mem_Read_IT() 的通用流程，
+ * 由接口层用 LL 寄存器操作完成，每个事务 6 次短中断；其他长度和阻塞读写仍用 HAL */
+#ifndef PDM_CFG_I2C_LL
+#define PDM_CFG_I2C_LL              0
+#endif
+
+/* 记录每片器件当前的寄存器指针（INA226 保留最近一次写入的指针），连续读同一寄存器时
+ * （高速采集只读分流电压）省略写寄存器地址，只发读地址和 2 字节数据。
+ * 每连续省略 PDM_CFG_I2C_STICKY_REFRESH 次重新写一次指针，器件意外复位（指针回到 CONF）时最多读错这么多次。
+ * 默认随高速电流流 PDM_CFG_CAPTURE_FAST 打开 */
+#ifndef PDM_CFG_I2C_STICKY
+#define PDM_CFG_I2C_STICKY          PDM_CFG_CAPTURE_FAST
+#endif
+#ifndef PDM_CFG_I2C_STICKY_REFRESH
+#define PDM_CFG_I2C_STICKY_REFRESH  64
+#endif
+
+/* INA228 通道每隔多少次采样读一次片上 ENERGY/CHARGE（各 5 字节），期间的采样只读状态、电压和电流。
+ * 累计寄存器在芯片内按每次转换积分，读得少不丢能量，只是能量和 SOC 的更新间隔变长 */
+#ifndef PDM_CFG_INA228_ACC_EVERY
+#define PDM_CFG_INA228_ACC_EVERY    10
+#endif
+
+/* 按负载变化自动调整 INA226 平均次数，见 pdm_adapt.h
+ * 0: 始终使用通道表中的平均次数
+ * 1: 电流变化快时减少平均（捕捉瞬态），长时间平稳时增加平均（降低噪声，减少读取次数） */
+#ifndef PDM_CFG_ADAPT
+#define PDM_CFG_ADAPT               0
+#endif
+/* 电流变化率 (mA/s) 达到该值时切换到快速档 */
+#ifndef PDM_CFG_ADAPT_FAST_MA_S
+#define PDM_CFG_ADAPT_FAST_MA_S     20000
+#endif
+/* 电流变化率 (mA/s) 低于该值并持续 PDM_CFG_ADAPT_STEADY_MS 时切换到平稳档 */
+#ifndef PDM_CFG_ADAPT_STEADY_MA_S
+#define PDM_CFG_ADAPT_STEADY_MA_S   2000
+#endif
+#ifndef PDM_CFG_ADAPT_STEADY_MS
+#define PDM_CFG_ADAPT_STEADY_MS     3000
+#endif
+/* 快速档至少保持的时间 (ms)，其间没有新的快速变化才回到正常档 */
+#ifndef PDM_CFG_ADAPT_HOLD_MS
+#define PDM_CFG_ADAPT_HOLD_MS       500
+#endif
+
+/* 定时统计窗口长度 (ms)：最小/最大/平均/RMS 电流、峰值功率等，见 pdm_stats.h */
+#ifndef PDM_CFG_STATS_FAST_MS
+#define PDM_CFG_STATS_FAST_MS       100
+#endif
+#ifndef PDM_CFG_STATS_SLOW_MS
+#define PDM_CFG_STATS_SLOW_MS       1000
+#endif
+
+/* 每圈/每节分段能量（见 pdm_lap.h），结束时在 0x307 发出 */
+#ifndef PDM_CFG_LAP
+#define PDM_CFG_LAP                 1
+#endif
+/* 保存最近几段 */
+#ifndef PDM_CFG_LAP_RING
+#define PDM_CFG_LAP_RING            8
+#endif
+/* 计圈报文的 CAN ID（计时系统或仪表过线时发出，内容不限），收到即结束一圈；0 表示只用命令 0x05 */
+#ifndef PDM_CFG_LAP_TRIGGER_ID
+#define PDM_CFG_LAP_TRIGGER_ID      0
+#endif
+/* 计圈报文去抖：距上一圈结束不足该时间 (ms) 的计圈报文忽略（同一次过线重复发送） */
+#ifndef PDM_CFG_LAP_MIN_MS
+#define PDM_CFG_LAP_MIN_MS          10000
+#endif
+
+/* 能量积分方式
+ * 0: 矩形法，每个采样的功率乘以距上次采样的时间
+ * 1: 按 INA226 平均窗口的梯形法：最新结果覆盖其平均窗口内的时间，
+ *    窗口之外未被测到的时间用前后两次结果的平均值 */
+#ifndef PDM_CFG_ENERGY_TRAPEZOID
+#define PDM_CFG_ENERGY_TRAPEZOID    0
+#endif
+
+/* 每通道电流分布计数（对数分档，见 pdm_hist.h），随能量保存到 flash，ISO-TP 来源 4 下载。
+ * 打开后每条 flash 记录默认改为 256 字节，PVD 中断中的写入时间约为 64 字节时的 4 倍（约 7 ms） */
+#ifndef PDM_CFG_HIST
+#define PDM_CFG_HIST                0
+#endif
+
+/* 采样滤波（3 点中值 + 一阶 IIR，见 pdm_filter.h），结果在 0x304 第 4 页发送，
+ * 通道帧、能量和统计仍用未滤波的值。0: 不滤波，0x304 只有 4 页 */
+#ifndef PDM_CFG_FILTER
+#define PDM_CFG_FILTER              1
+#endif
+/* 各通道启动时的 IIR 系数 (Q15，32768 = 不做 IIR)，运行中可用命令修改 */
+#ifndef PDM_CFG_FILTER_ALPHA
+#define PDM_CFG_FILTER_ALPHA        32768
+#endif
+/* 各通道启动时是否做 3 点中值 */
+#ifndef PDM_CFG_FILTER_MEDIAN
+#define PDM_CFG_FILTER_MEDIAN       1
+#endif
+
+/* 软件抽取（见 pdm_decim.h）：每通道 2^shift 个采样的分流值相加，得到更低速率、更细分辨率的电流，
+ * 在 0x30F 发送；运行中可用命令 0x0D 修改各通道的 shift */
+#ifndef PDM_CFG_DECIM
+#define PDM_CFG_DECIM               1
+#endif
+/* 启动时打开抽取的通道（bitN 通道 N，默认电池侧）和抽取比 2^PDM_CFG_DECIM_SHIFT (0~8) */
+#ifndef PDM_CFG_DECIM_MASK
+#define PDM_CFG_DECIM_MASK          0x02
+#endif
+#ifndef PDM_CFG_DECIM_SHIFT
+#define PDM_CFG_DECIM_SHIFT         6
+#endif
+#ifndef PDM_CFG_DECIM_PERIOD_MS
+#define PDM_CFG_DECIM_PERIOD_MS     250
+#endif
+
+/* 负载阶跃检测（见 pdm_step.h）：每通道按低通后的电流判断阶跃，每次阶跃在 0x312 发一帧事件，
+ * 门限为运行参数 step_ma（0 不检测） */
+#ifndef PDM_CFG_STEP
+#define PDM_CFG_STEP                1
+#endif
+#ifndef PDM_CFG_STEP_MA
+#define PDM_CFG_STEP_MA             1000
+#endif
+/* 电流和电压的低通系数 1/2^n (0~4)，0 不滤波 */
+#ifndef PDM_CFG_STEP_FILTER
+#define PDM_CFG_STEP_FILTER         1
+#endif
+/* 变化中连续多少个采样变化不大算作稳定，最多等多少个采样 */
+#ifndef PDM_CFG_STEP_SETTLE
+#define PDM_CFG_STEP_SETTLE         3
+#endif
+#ifndef PDM_CFG_STEP_MAX_N
+#define PDM_CFG_STEP_MAX_N          32
+#endif
+/* RAM 中保留的最近阶跃数 */
+#ifndef PDM_CFG_STEP_RING
+#define PDM_CFG_STEP_RING           8
+#endif
+
+/* 电池内阻估计（见 pdm_rint.h）：按电池侧的负载阶跃计算 dV/dI，在 0x313 发送，平均值随能量保存 */
+#ifndef PDM_CFG_RINT
+#define PDM_CFG_RINT                PDM_CFG_STEP
+#endif
+#ifndef PDM_CFG_RINT_CH
+#define PDM_CFG_RINT_CH             1
+#endif
+#ifndef PDM_CFG_RINT_PERIOD_MS
+#define PDM_CFG_RINT_PERIOD_MS      1000
+#endif
+/* 使用的阶跃：电流变化不小于 MIN_MA，上升时间不超过 MAX_RISE_MS，结果在 MIN_UOHM ~ MAX_UOHM 之间 */
+#ifndef PDM_CFG_RINT_MIN_MA
+#define PDM_CFG_RINT_MIN_MA         2000
+#endif
+#ifndef PDM_CFG_RINT_MAX_RISE_MS
+#define PDM_CFG_RINT_MAX_RISE_MS    50
+#endif
+#ifndef PDM_CFG_RINT_MIN_UOHM
+#define PDM_CFG_RINT_MIN_UOHM       1000
+#endif
+#ifndef PDM_CFG_RINT_MAX_UOHM
+#define PDM_CFG_RINT_MAX_UOHM       500000
+#endif
+/* 平均的结果数（之后为 1/N 的一阶滤波），至少多少个结果时平均值有效 */
+#ifndef PDM_CFG_RINT_AVG_N
+#define PDM_CFG_RINT_AVG_N          16
+#endif
+#ifndef PDM_CFG_RINT_VALID_N
+#define PDM_CFG_RINT_VALID_N        4
+#endif
+
+/* 两点标定（见 pdm_cal.h）：命令触发，零点和参考电流各平均 PDM_CFG_CAL_SAMPLES 个采样，结果写入运行参数 */
+#ifndef PDM_CFG_CAL
+#define PDM_CFG_CAL                 1
+#endif
+#ifndef PDM_CFG_CAL_SAMPLES
+#define PDM_CFG_CAL_SAMPLES         64
+#endif
+
+/* 采样周期 (ms)，定时采样模式下的读取间隔 */
+#ifndef PDM_CFG_SAMPLE_PERIOD_MS
+#define PDM_CFG_SAMPLE_PERIOD_MS    50
+#endif
+
+/* 空闲时休眠：主循环一轮没有到期任务时执行 WFI（睡眠模式，外设和 DMA 继续运行），
+ * 由 SysTick、EXTI、I2C、CAN、DMA 等任一中断唤醒 */
+#ifndef PDM_CFG_IDLE_SLEEP
+#define PDM_CFG_IDLE_SLEEP          1
+#endif
+/* 无节拍休眠：没有 I2C 读取进行时，把 SysTick 临时重装为到下一个任务到期的时间，
+ * 中途不再每 1 ms 唤醒，醒来后补上经过的 tick（需要 PDM_CFG_IDLE_SLEEP） */
+#ifndef PDM_CFG_IDLE_TICKLESS
+#define PDM_CFG_IDLE_TICKLESS       0
+#endif
+/* 休眠期间 HCLK 降为 36 MHz，醒来后恢复 72 MHz，CAN、I2C、UART 时序不变（见 pdm_clock.h）；
+ * 需要 PDM_CFG_IDLE_SLEEP，不能与 PDM_CFG_SAMPLE_TIMER / PDM_CFG_ALERT_CAPTURE 同时使用 */
+#ifndef PDM_CFG_CLOCK_SCALE
+#define PDM_CFG_CLOCK_SCALE         0
+#endif
+/* 降频休眠时 MCU 电流的减少量 (uA)，只用于命令行 clock 的估算；
+ * 默认按数据手册睡眠模式（外设时钟开）72 MHz 与 36 MHz 的典型值之差，可按实测修改 */
+#ifndef PDM_CFG_CLOCK_SAVE_UA
+#define PDM_CFG_CLOCK_SAVE_UA       7000
+#endif
+/* CPU 负载、主循环轮数和任务份额（见 pdm_load.h），每秒在 0x316 发送；需要 PDM_CFG_IDLE_SLEEP */
+#ifndef PDM_CFG_LOAD
+#define PDM_CFG_LOAD                1
+#endif
+/* 统计窗口 (ms) */
+#ifndef PDM_CFG_LOAD_WINDOW_MS
+#define PDM_CFG_LOAD_WINDOW_MS      1000
+#endif
+
+/* 0x300/0x301 通道报文的默认发送周期 (ms)，0 表示不按周期发送，最短 10 ms */
+#ifndef PDM_CFG_CAN_PERIOD_MS
+#define PDM_CFG_CAN_PERIOD_MS       500
+#endif
+
+/* 通道报文内容（按 CAN 分辨率换算后）与上次发送相同时不发送，最长该时间 (ms) 仍发送一次；
+ * 0 表示每次都发送。通道上线后的第一帧总是发送 */
+#ifndef PDM_CFG_CAN_KEEPALIVE_MS
+#define PDM_CFG_CAN_KEEPALIVE_MS    0
+#endif
+
+/* 通道报文按变化发送（运行参数 0x06~0x08、0x90 + 通道的默认值）：CHANGE_MAX_MS 非 0 时不再按周期，
+ * 电压或电流与上次发出的值相差超过死区、且距上次发送不少于 CHANGE_MIN_MS 时发送，
+ * 超过 CHANGE_MAX_MS 没有发送时总是发送一次；CHANGE_MAX_MS 为 0 时按 PDM_CFG_CAN_PERIOD_MS 发送 */
+#ifndef PDM_CFG_CAN_CHANGE_MIN_MS
+#define PDM_CFG_CAN_CHANGE_MIN_MS   20
+#endif
+#ifndef PDM_CFG_CAN_CHANGE_MAX_MS
+#define PDM_CFG_CAN_CHANGE_MAX_MS   0
+#endif
+#ifndef PDM_CFG_CAN_DEADBAND_MV
+#define PDM_CFG_CAN_DEADBAND_MV     50
+#endif
+#ifndef PDM_CFG_CAN_DEADBAND_MA
+#define PDM_CFG_CAN_DEADBAND_MA     200
+#endif
+
+/* 0x304 扩展遥测帧（各通道轮流发送窗口统计）的发送周期 (ms)，0 表示默认不发送 */
+#ifndef PDM_CFG_CAN_EXT_PERIOD_MS
+#define PDM_CFG_CAN_EXT_PERIOD_MS   100
+#endif
+
+/* 0x314 32 位能量帧（能量 10 uWh/LSB、净电荷 0.1 mAh/LSB，各通道轮流）的发送周期 (ms)，0 表示不发送 */
+#ifndef PDM_CFG_CAN_ENERGY32_MS
+#define PDM_CFG_CAN_ENERGY32_MS     1000
+#endif
+
+/* 1: 每得到一组新的采样结果就立即发送通道报文 */
+#ifndef PDM_CFG_CAN_ON_SAMPLE
+#define PDM_CFG_CAN_ON_SAMPLE       0
+#endif
+
+/* 本节点允许占用的 CAN 总线负载上限（千分比），按配置估算超出时启动打印警告 */
+#ifndef PDM_CFG_CAN_LOAD_BUDGET
+#define PDM_CFG_CAN_LOAD_BUDGET     100
+#endif
+
+/* 1: 从发送队列直接写 bxCAN 邮箱寄存器，不经过 HAL_CAN_AddTxMessage()；
+ * 0: 使用 HAL 接口（调试 CAN 问题时对照用） */
+#ifndef PDM_CFG_CAN_DIRECT_TX
+#define PDM_CFG_CAN_DIRECT_TX       1
+#endif
+
+/* CAN 软件发送队列最多的帧数，队列项从共享内存池中分配 */
+#ifndef PDM_CFG_CAN_TXQ_LEN
+#define PDM_CFG_CAN_TXQ_LEN         16
+#endif
+
+/* 本节点各帧入队到发送完成的延迟统计和其他节点总线负载估计（见 pdm_can.h），命令行 canlat 输出 */
+#ifndef PDM_CFG_CAN_LATENCY
+#define PDM_CFG_CAN_LATENCY         1
+#endif
+
+/* CAN 总线错误统计（TEC/REC、错误帧分类、错误被动和离线恢复时间，见 pdm_canhealth.h），每秒在 0x30A 发送 */
+#ifndef PDM_CFG_CANH
+#define PDM_CFG_CANH                1
+#endif
+/* 每秒最多处理的错误帧中断数，超过后暂停 LEC 中断到下一秒 */
+#ifndef PDM_CFG_CANH_LEC_LIMIT
+#define PDM_CFG_CANH_LEC_LIMIT      1000
+#endif
+
+/* MCU 自监测（见 pdm_mcu.h）：ADC1 扫描 + DMA 循环转换内部温度、VREFINT 和备用模拟输入，每秒在 0x30C 发送 */
+#ifndef PDM_CFG_MCU
+#define PDM_CFG_MCU                 1
+#endif
+/* 备用模拟输入个数 0~2，依次为 PB0 (IN8)、PB1 (IN9) */
+#ifndef PDM_CFG_MCU_EXT
+#define PDM_CFG_MCU_EXT             2
+#endif
+/* 温度传感器 25 °C 时的输出电压 (mV)，手册典型值，按实测校正 */
+#ifndef PDM_CFG_MCU_V25_MV
+#define PDM_CFG_MCU_V25_MV          1430
+#endif
+
+/* 栈使用量（见 pdm_stack.h）：启动时填充栈区，每秒在 0x30D 发送最大深度 */
+#ifndef PDM_CFG_STACK
+#define PDM_CFG_STACK               1
+#endif
+/* 剩余栈空间低于该值（字节）时打印警告 */
+#ifndef PDM_CFG_STACK_WARN
+#define PDM_CFG_STACK_WARN          1024
+#endif
+
+/* 硬件门限保护：INA226 比较每个转换结果，超限时拉低 ALERT，
+ * EXTI 中断中立即发出 CAN 故障帧。总线侧监视功率上限，电池侧监视欠压 */
+#ifndef PDM_CFG_PROTECT
+#if PDM_CFG_SAMPLE_ON_ALERT
+#define PDM_CFG_PROTECT             0       /* ALERT 引脚已用于转换完成通知 */
+#else
+#define PDM_CFG_PROTECT             1
+#endif
+#endif
+
+/* 总线侧功率上限 (mW) */
+#ifndef PDM_CFG_PROT_BUS_POWER_MW
+#define PDM_CFG_PROT_BUS_POWER_MW   400000
+#endif
+
+/* 电池侧欠压门限 (mV) */
+#ifndef PDM_CFG_PROT_BAT_UV_MV
+#define PDM_CFG_PROT_BAT_UV_MV      20000   /* 7 串磷酸铁锂，约 2.86 V/串 */
+#endif
+
+/* 过流/欠压切断（见 pdm_trip.h）：每个采样在 I2C 中断中与门限比较，超限时驱动负载开关输出并发故障帧 */
+#ifndef PDM_CFG_TRIP
+#define PDM_CFG_TRIP                1
+#endif
+/* 负载开关控制引脚和切断时的电平（正常时为相反电平，开关使能） */
+#ifndef PDM_CFG_TRIP_PORT
+#define PDM_CFG_TRIP_PORT           GPIOB
+#endif
+#ifndef PDM_CFG_TRIP_PIN
+#define PDM_CFG_TRIP_PIN            GPIO_PIN_12
+#endif
+#ifndef PDM_CFG_TRIP_LEVEL
+#define PDM_CFG_TRIP_LEVEL          0
+#endif
+/* 硬件门限保护（PDM_CFG_PROTECT）的 ALERT 也在 EXTI 中断中切断输出 */
+#ifndef PDM_CFG_TRIP_ON_ALERT
+#define PDM_CFG_TRIP_ON_ALERT       1
+#endif
+/* 各通道门限的默认值（运行参数 0x50~0x80 + 通道），0 表示不检查该项 */
+#ifndef PDM_CFG_TRIP_OC_MA
+#define PDM_CFG_TRIP_OC_MA          18000   /* 瞬时过流 (mA)，量程 20.48 A */
+#endif
+#ifndef PDM_CFG_TRIP_NOM_MA
+#define PDM_CFG_TRIP_NOM_MA         10000   /* 额定电流 (mA)，I2t 只累计超出部分 */
+#endif
+#ifndef PDM_CFG_TRIP_I2T
+#define PDM_CFG_TRIP_I2T            30000   /* I2t 门限 (A^2 ms)：20 A 约 100 ms，15 A 约 240 ms */
+#endif
+#ifndef PDM_CFG_TRIP_UV_MV
+#define PDM_CFG_TRIP_UV_MV          0       /* 欠压 (mV) */
+#endif
+
+/* 电池侧（通道 1）库仑计数与剩余电量估算 */
+#ifndef PDM_CFG_SOC
+#define PDM_CFG_SOC                 1
+#endif
+
+/* 电池额定容量 (mAh) 和串数，按实际电池修改 */
+#ifndef PDM_CFG_BAT_CAPACITY_MAH
+#define PDM_CFG_BAT_CAPACITY_MAH    5000
+#endif
+#ifndef PDM_CFG_BAT_CELLS
+#define PDM_CFG_BAT_CELLS           7
+#endif
+
+/* 电流绝对值低于 PDM_CFG_SOC_REST_MA 持续 PDM_CFG_SOC_REST_S 后，按开路电压表修正剩余电量 */
+#ifndef PDM_CFG_SOC_REST_MA
+#define PDM_CFG_SOC_REST_MA         300
+#endif
+#ifndef PDM_CFG_SOC_REST_S
+#define PDM_CFG_SOC_REST_S          60
+#endif
+
+/* 总线侧（通道 0）和电池侧（通道 1）配对计算的派生量（DCDC 输出、OR-RING 损耗、电池占比，见 pdm_derived.h） */
+#ifndef PDM_CFG_DERIVED
+#define PDM_CFG_DERIVED             1
+#endif
+/* 派生量帧 0x308 的周期 (ms)，帧内为本周期所有配对采样的平均 */
+#ifndef PDM_CFG_DERIVED_PERIOD_MS
+#define PDM_CFG_DERIVED_PERIOD_MS   100
+#endif
+/* 两个通道的读取时间相差超过该值 (us) 时不配对（ALERT 采样模式下两路各自转换） */
+#ifndef PDM_CFG_DERIVED_SKEW_US
+#define PDM_CFG_DERIVED_SKEW_US     2000
+#endif
+
+/* 每个采样的读数可信度检查（见 pdm_plaus.h），结果在 0x309 发送 */
+#ifndef PDM_CFG_PLAUS
+#define PDM_CFG_PLAUS               1
+#endif
+/* 检查结果连续相同多少个采样后标志才改变 */
+#ifndef PDM_CFG_PLAUS_COUNT
+#define PDM_CFG_PLAUS_COUNT         3
+#endif
+/* 连续多少次新转换的读数都不变时判为卡死 */
+#ifndef PDM_CFG_PLAUS_STUCK_N
+#define PDM_CFG_PLAUS_STUCK_N       250
+#endif
+/* 电池放电电流不低于 PDM_CFG_PLAUS_VREL_MIN_MA 时检查总线电压：
+ * 不高于电池电压 + PDM_CFG_PLAUS_VREL_TOL_MV（两片测量误差），不低于电池电压 - PDM_CFG_PLAUS_DROP_MV（OR-RING 和线路压降） */
+#ifndef PDM_CFG_PLAUS_VREL_MIN_MA
+#define PDM_CFG_PLAUS_VREL_MIN_MA   500
+#endif
+#ifndef PDM_CFG_PLAUS_VREL_TOL_MV
+#define PDM_CFG_PLAUS_VREL_TOL_MV   200
+#endif
+#ifndef PDM_CFG_PLAUS_DROP_MV
+#define PDM_CFG_PLAUS_DROP_MV       1500
+#endif
+
+/* 带计数器和 CRC 的通道帧（见 pdm_e2e.h），与原通道帧同周期另外发送，原通道帧不变 */
+#ifndef PDM_CFG_E2E
+#define PDM_CFG_E2E                 0
+#endif
+/* 带校验通道帧的 ID = 通道帧 ID + 该值（默认 0x380/0x381） */
+#ifndef PDM_CFG_E2E_ID_OFFSET
+#define PDM_CFG_E2E_ID_OFFSET       0x80
+#endif
+
+/* 与 VCU 的时间同步（见 pdm_timesync.h），车辆时间帧在 0x30B 发送；需要 VCU 发送 SYNC/FUP */
+#ifndef PDM_CFG_TIMESYNC
+#define PDM_CFG_TIMESYNC            0
+#endif
+/* SYNC/FUP 报文的 CAN ID 和时间域 */
+#ifndef PDM_CFG_TIMESYNC_ID
+#define PDM_CFG_TIMESYNC_ID         0x0E0
+#endif
+#ifndef PDM_CFG_TIMESYNC_DOMAIN
+#define PDM_CFG_TIMESYNC_DOMAIN     0
+#endif
+/* FUP 必须在 SYNC 之后该时间 (ms) 内到达 */
+#ifndef PDM_CFG_TIMESYNC_FUP_MS
+#define PDM_CFG_TIMESYNC_FUP_MS     100
+#endif
+/* 超过该时间 (ms) 没有同步时状态为保持 */
+#ifndef PDM_CFG_TIMESYNC_TIMEOUT_MS
+#define PDM_CFG_TIMESYNC_TIMEOUT_MS 3000
+#endif
+/* 同步点与外推值相差超过该值 (us) 时直接跳变 */
+#ifndef PDM_CFG_TIMESYNC_STEP_US
+#define PDM_CFG_TIMESYNC_STEP_US    10000
+#endif
+/* 频差测量值的上限 (ppm)，超出的同步点只更新偏移 */
+#ifndef PDM_CFG_TIMESYNC_MAX_PPM
+#define PDM_CFG_TIMESYNC_MAX_PPM    500
+#endif
+
+/* 瞬态高速采集，默认不编译：缓冲区占 PDM_CFG_CAPTURE_SAMPLES 个样本的 RAM，不能与 PDM_CFG_SAMPLE_ON_ALERT 同时打开
+ * 0: 不编译
+ * 1: 收到武装命令（或 PDM_CFG_CAPTURE_AUTO_ARM）后，采集通道切换到最快转换、不平均，
+ *    连续读取分流电压放入环形缓冲区；电流超过门限时 INA226 拉低 ALERT 触发，
+ *    填满触发后的样本后恢复正常配置，并通过 CAN 发出整段波形 */
+#ifndef PDM_CFG_CAPTURE
+#define PDM_CFG_CAPTURE             0
+#endif
+
+/* 采集通道：0 总线侧 (ALERT1)，1 电池侧 (ALERT2) */
+#ifndef PDM_CFG_CAPTURE_CH
+#define PDM_CFG_CAPTURE_CH          0
+#endif
+
+/* 缓冲区样本数（每个样本 4 字节）和其中触发前的样本数 */
+#ifndef PDM_CFG_CAPTURE_SAMPLES
+#define PDM_CFG_CAPTURE_SAMPLES     512
+#endif
+#ifndef PDM_CFG_CAPTURE_PRE
+#define PDM_CFG_CAPTURE_PRE         128
+#endif
+
+/* 触发门限 (mA) */
+#ifndef PDM_CFG_CAPTURE_TRIG_MA
+#define PDM_CFG_CAPTURE_TRIG_MA     15000
+#endif
+
+/* 1: 启动时自动武装，每次发送完成后重新武装 */
+#ifndef PDM_CFG_CAPTURE_AUTO_ARM
+#define PDM_CFG_CAPTURE_AUTO_ARM    0
+#endif
+
+/* 采集数据帧压缩（见 pdm_pack.h）：0 每帧两个原始样本，1 差分位打包后连续发送，
+ * 冲击电流波形一般每样本约 1.2 字节，约为原来的三分之一帧数 */
+#ifndef PDM_CFG_CAPTURE_PACK
+#define PDM_CFG_CAPTURE_PACK        0
+#endif
+
+/* 只测电流的高速采样流（命令 0x0C 或命令行 fast 1 开始），需要 PDM_CFG_CAPTURE 和 PDM_CFG_UART_STREAM：
+ * 采集通道只转换分流电压，140 us、不平均，连续读分流电压寄存器，经 UART 二进制采样流输出（类型 0x05） */
+#ifndef PDM_CFG_CAPTURE_FAST
+#define PDM_CFG_CAPTURE_FAST        0
+#endif
+/* 与上一个样本的间隔小于该值 (us) 的读取读到的是同一次转换，不输出 */
+#ifndef PDM_CFG_CAPTURE_FAST_MIN_US
+#define PDM_CFG_CAPTURE_FAST_MIN_US 140
+#endif
+/* 每个流帧的样本数 (1~60) */
+#ifndef PDM_CFG_CAPTURE_FAST_BLOCK
+#define PDM_CFG_CAPTURE_FAST_BLOCK  16
+#endif
+
+/* 上电冲击电流采集（见 pdm_capture.h）：I2C 初始化后立即把采集通道改为 140 us、不平均、只转换分流电压，
+ * 记录上电后 PDM_CFG_CAPTURE_BOOT_MS 内的电流，前 PDM_CFG_CAPTURE_BOOT_FULL 个样本全速，之后按剩余时间抽取，
+ * 结束后与高速采集一样通过 CAN 发出（触发来源 3）。期间采集通道不做正常采样；需要 SysTick 时间基准 */
+#ifndef PDM_CFG_CAPTURE_BOOT
+#define PDM_CFG_CAPTURE_BOOT        0
+#endif
+#ifndef PDM_CFG_CAPTURE_BOOT_MS
+#define PDM_CFG_CAPTURE_BOOT_MS     1000
+#endif
+#ifndef PDM_CFG_CAPTURE_BOOT_FULL
+#define PDM_CFG_CAPTURE_BOOT_FULL   256
+#endif
+
+/* flash 记录存储占用的页数（flash 最后几页，每页 1 KB）。
+ * 存储区、参数区、事件记录区和趋势记录区共 PDM_BOOT_DATA_PAGES 页，程序超过剩余空间时链接失败（Core/pdm_flash_check.ld） */
+#ifndef PDM_CFG_STORE_PAGES
+#define PDM_CFG_STORE_PAGES         4
+#endif
+
+/* 每条 flash 记录的字节数（64、128 或 256），数据部分比它少 12 字节。
+ * 超过 3 个通道时一条 64 字节的记录放不下，PVD 中断中的写入时间也随之加倍 */
+#ifndef PDM_CFG_STORE_REC_SIZE
+#if PDM_CFG_HIST
+#define PDM_CFG_STORE_REC_SIZE      256
+#elif PDM_CFG_CHANNELS > 3
+#define PDM_CFG_STORE_REC_SIZE      128
+#else
+#define PDM_CFG_STORE_REC_SIZE      64
+#endif
+#endif
+
+/* 故障/事件记录（切断、ALERT、传感器离线、CAN 离线、启动，见 pdm_evlog.h），写在参数区之前的 flash 页中 */
+#ifndef PDM_CFG_EVLOG
+#define PDM_CFG_EVLOG               1
+#endif
+/* 事件记录占用的页数（每页 64 条，至少 2 页） */
+#ifndef PDM_CFG_EVLOG_PAGES
+#define PDM_CFG_EVLOG_PAGES         2
+#endif
+/* RAM 中等待写入 flash 的事件数，擦页等待期间的事件放在这里 */
+#ifndef PDM_CFG_EVLOG_RAM
+#define PDM_CFG_EVLOG_RAM           16
+#endif
+
+/* 长时间趋势记录（每通道平均/最大电流、最低电压、能量，压缩后写入 flash，见 pdm_trend.h），在事件记录区之前。
+ * 默认不编译：占 PDM_CFG_TREND_PAGES 页 flash，读出需要 PDM_CFG_ISOTP */
+#ifndef PDM_CFG_TREND
+#define PDM_CFG_TREND               0
+#endif
+/* 趋势记录周期 (s) */
+#ifndef PDM_CFG_TREND_S
+#define PDM_CFG_TREND_S             5
+#endif
+/* 趋势记录占用的页数：默认 16 KB，5 s 周期约可保存 2~3 小时（视负载变化），其他数据页合计 8 KB，程序需小于 40 KB */
+#ifndef PDM_CFG_TREND_PAGES
+#define PDM_CFG_TREND_PAGES         16
+#endif
+
+/* 掉电前保存：VDD 跌到 PVD 门限时在中断中立即写一条记录 */
+#ifndef PDM_CFG_PVD_SAVE
+#define PDM_CFG_PVD_SAVE            1
+#endif
+
+/* PVD 门限（stm32f1xx_hal_pwr.h 中的 PWR_PVDLEVEL_x），取最高档留出最长的写入时间 */
+#ifndef PDM_CFG_PVD_LEVEL
+#define PDM_CFG_PVD_LEVEL           PWR_PVDLEVEL_7      /* 2.9 V */
+#endif
+
+/* 能量、电压极值和运行时间的定期保存周期 (s)，0 表示不定期保存。
+ * 有掉电前保存时定期保存只作为后备，周期放长以减少 flash 擦写 */
+#ifndef PDM_CFG_STORE_PERIOD_S
+#if PDM_CFG_PVD_SAVE
+#define PDM_CFG_STORE_PERIOD_S      600
+#else
+#define PDM_CFG_STORE_PERIOD_S      60
+#endif
+#endif
+
+/* 独立看门狗：所有被监视任务都按时报到才喂狗，否则超时后复位 */
+#ifndef PDM_CFG_WDG
+#define PDM_CFG_WDG                 1
+#endif
+
+/* 看门狗超时 (ms)，要大于最长的阻塞操作（flash 页擦除约 40 ms） */
+#ifndef PDM_CFG_WDG_TIMEOUT_MS
+#define PDM_CFG_WDG_TIMEOUT_MS      1000
+#endif
+
+/* 把标记为 PDM_RAMFUNC 的热点函数（采样中断链、报文发送补充、通道数据更新）放到 SRAM 中执行，
+ * 避开 72 MHz 时 flash 的 2 个等待周期和预取缓冲未命中；每个函数占用等量的 RAM 和 flash（启动时复制），
+ * 用 make ramfunc-report 查看，见 pdm_ramfunc.h */
+#ifndef PDM_CFG_RAMFUNC
+#define PDM_CFG_RAMFUNC             0
+#endif
+
+/* FreeRTOS 版本：采集、通信、日志三个任务代替主循环，见 pdm_rtos.h；由 make RTOS=1 定义，
+ * 需要 FreeRTOS 源码（FREERTOS_DIR） */
+#ifndef PDM_CFG_RTOS
+#define PDM_CFG_RTOS                0
+#endif
+
+/* 启动时把中断向量表复制到 SRAM（256 字节）并改 VTOR；PDM_CFG_RTOS 时必须打开（SVC/PendSV 向量改为内核的处理函数） */
+#ifndef PDM_CFG_RAM_VECTORS
+#define PDM_CFG_RAM_VECTORS         PDM_CFG_RTOS
+#endif
+
+/* 黑匣子：RAM 中循环记录最近一段时间每个采样的电流、电压（压缩），热复位后保留，
+ * 故障、看门狗复位或掉电时冻结，之后可下载，见 pdm_blackbox.h。默认不编译：缓冲区占 PDM_CFG_BLACKBOX_BYTES 字节 RAM */
+#ifndef PDM_CFG_BLACKBOX
+#define PDM_CFG_BLACKBOX            0
+#endif
+
+/* 黑匣子缓冲区字节数：50 ms 采样、两个通道时每秒约 100~120 字节，2048 字节约保存最近 15~20 s */
+#ifndef PDM_CFG_BLACKBOX_BYTES
+#define PDM_CFG_BLACKBOX_BYTES      2048
+#endif
+
+/* 故障后继续记录的时间 (ms)，看门狗复位和掉电时立即冻结 */
+#ifndef PDM_CFG_BLACKBOX_POST_MS
+#define PDM_CFG_BLACKBOX_POST_MS    500
+#endif
+
+/* XCP on CAN 测量从站（静态 DAQ 列表），见 pdm_xcp.h */
+#ifndef PDM_CFG_XCP
+#define PDM_CFG_XCP                 0
+#endif
+
+/* XCP 命令 (CRO) 和回复/数据 (DTO) 的 CAN ID */
+#ifndef PDM_CFG_XCP_RX_ID
+#define PDM_CFG_XCP_RX_ID           0x330
+#endif
+#ifndef PDM_CFG_XCP_TX_ID
+#define PDM_CFG_XCP_TX_ID           0x331
+#endif
+
+/* 静态 DAQ 列表数和每个列表的 ODT 数（每个 ODT 一帧，最多 7 字节数据），PID 总数不超过 0xFC */
+#ifndef PDM_CFG_XCP_DAQ_LISTS
+#define PDM_CFG_XCP_DAQ_LISTS       2
+#endif
+#ifndef PDM_CFG_XCP_ODTS
+#define PDM_CFG_XCP_ODTS            4
+#endif
+
+/* ISO-TP (ISO 15765-2) 批量下载：采集缓冲区、flash 记录区、运行时间测量表等，见 pdm_isotp.h */
+#ifndef PDM_CFG_ISOTP
+#define PDM_CFG_ISOTP               0
+#endif
+
+/* ISO-TP 请求（上位机发送，含流控帧）和响应的 CAN ID */
+#ifndef PDM_CFG_ISOTP_RX_ID
+#define PDM_CFG_ISOTP_RX_ID         0x340
+#endif
+#ifndef PDM_CFG_ISOTP_TX_ID
+#define PDM_CFG_ISOTP_TX_ID         0x341
+#endif
+
+/* CAN 往返延迟测试（见 pdm_ping.h）：请求 ID（按节点号偏移），回复为请求 ID + 1（原样）和 + 2（内部时间） */
+#ifndef PDM_CFG_PING
+#define PDM_CFG_PING                1
+#endif
+#ifndef PDM_CFG_PING_ID
+#define PDM_CFG_PING_ID             0x360
+#endif
+
+/* 应用程序链接在 CAN 引导程序之后（make BOOT=1 时为 1，见 pdm_boot.h）：命令 PDM_CMD_BOOT 复位进入引导程序 */
+#ifndef PDM_CFG_BOOT
+#define PDM_CFG_BOOT                0
+#endif
+/* 收到进入引导程序的命令后等待回复发出的时间 (ms) */
+#ifndef PDM_CFG_BOOT_DELAY_MS
+#define PDM_CFG_BOOT_DELAY_MS       50
+#endif
+
+/* HardFault、NMI、Error_Handler() 的现场写入 .noinit 后复位，下次启动时在 0x315 发送（见 pdm_crash.h） */
+#ifndef PDM_CFG_CRASH
+#define PDM_CFG_CRASH               1
+#endif
+
+/* 启动时间：第一帧、第一个转换结果、第一个通道帧等时间点，得到后在 0x317 发送一次，命令行 startup 查看 */
+#ifndef PDM_CFG_STARTUP
+#define PDM_CFG_STARTUP             1
+#endif
+
+/* 回放模式（见 pdm_replay.h）：虚拟 INA226 代替传感器，数据来自 CAN 上发送的实车记录；实车固件必须为 0 */
+#ifndef PDM_CFG_REPLAY
+#define PDM_CFG_REPLAY              0
+#endif
+/* 记录帧（上位机发送）的 CAN ID */
+#ifndef PDM_CFG_REPLAY_ID
+#define PDM_CFG_REPLAY_ID           0x350
+#endif
+/* 每个通道的记录队列长度（可用 PDM_CFG_REPLAY_FIFO - 1 条），2..255 */
+#ifndef PDM_CFG_REPLAY_FIFO
+#define PDM_CFG_REPLAY_FIFO         32
+#endif
+
+/* 同一总线上的多块 PDM（见 pdm_node.h）：按节点号偏移所有 CAN ID，心跳帧 0x31F + 偏移 */
+#ifndef PDM_CFG_NODE
+#define PDM_CFG_NODE                1
+#endif
+/* 节点数和每个节点的 ID 间隔：节点 n 的 ID = 节点 0 的 ID + n x 间隔 */
+#ifndef PDM_CFG_NODE_MAX
+#define PDM_CFG_NODE_MAX            4
+#endif
+#ifndef PDM_CFG_NODE_STRIDE
+#define PDM_CFG_NODE_STRIDE         0x100
+#endif
+/* 运行参数 node 的默认值；PDM_NODE_FROM_STRAP (0xFF) 读跳线 */
+#ifndef PDM_CFG_NODE_ID
+#define PDM_CFG_NODE_ID             0
+#endif
+/* 节点号跳线位数 0~2（0 没有跳线），引脚内部上拉，接地为 1，PIN0 为最低位 */
+#ifndef PDM_CFG_NODE_STRAP
+#define PDM_CFG_NODE_STRAP          0
+#endif
+#ifndef PDM_CFG_NODE_STRAP_PORT
+#define PDM_CFG_NODE_STRAP_PORT     GPIOB
+#endif
+#ifndef PDM_CFG_NODE_STRAP_PIN0
+#define PDM_CFG_NODE_STRAP_PIN0     GPIO_PIN_14
+#endif
+#ifndef PDM_CFG_NODE_STRAP_PIN1
+#define PDM_CFG_NODE_STRAP_PIN1     GPIO_PIN_15
+#endif
+/* 心跳帧周期 (ms)，0 只在上电和收到查询时发送 */
+#ifndef PDM_CFG_NODE_HB_MS
+#define PDM_CFG_NODE_HB_MS          1000
+#endif
+/* VCU 广播的节点查询帧 ID（不加偏移） */
+#ifndef PDM_CFG_NODE_DISCOVER_ID
+#define PDM_CFG_NODE_DISCOVER_ID    0x0E1
+#endif
+
+/* 共享内存池（见 pdm_pool.h）的块数，每块 40 字节；CAN 发送队列、UART 日志和高速采集发送共用 */
+#ifndef PDM_CFG_POOL_BLOCKS
+#define PDM_CFG_POOL_BLOCKS         24
+#endif
+/* CAN 发送队列保证可用的帧数（最多 PDM_CFG_CAN_TXQ_LEN 帧） */
+#ifndef PDM_CFG_POOL_CAN_RESERVE
+#define PDM_CFG_POOL_CAN_RESERVE    8
+#endif
+/* UART 日志保证可用和最多可用的块数，每块 32 字节文本；二进制采样流全速记录时可增大 */
+#ifndef PDM_CFG_POOL_LOG_RESERVE
+#define PDM_CFG_POOL_LOG_RESERVE    8
+#endif
+#ifndef PDM_CFG_POOL_LOG_MAX
+#define PDM_CFG_POOL_LOG_MAX        16
+#endif
+
+/* UART 二进制采样流，见 pdm_stream.h
+ * 0: 每秒输出一行文本测量结果（115200 baud）
+ * 1: 每次读取都输出一个 COBS 帧（原始寄存器值 + 微秒时间戳 + CRC），不再输出每秒的文本行，
+ *    USART1 改为 PDM_CFG_UART_STREAM_BAUD；其他文本日志照常输出，由上位机按帧分开 */
+#ifndef PDM_CFG_UART_STREAM
+#define PDM_CFG_UART_STREAM         0
+#endif
+
+/* 采样流压缩：每通道每 16 个采样输出一个压缩帧（类型 0x03），代替逐个采样帧 */
+#ifndef PDM_CFG_UART_STREAM_PACK
+#define PDM_CFG_UART_STREAM_PACK    0
+#endif
+
+/* 采样流波特率：72 MHz 下 921600 误差 0.16%，2000000 无误差（F103 USART1 最高 4.5 Mbaud） */
+#ifndef PDM_CFG_UART_STREAM_BAUD
+#define PDM_CFG_UART_STREAM_BAUD    921600
+#endif
+
+/* UART 命令行：USART1 RX 用 DMA 循环接收，空闲线中断通知，按行解析，见 pdm_shell.h */
+#ifndef PDM_CFG_SHELL
+#define PDM_CFG_SHELL               1
+#endif
+
+/* DWT 运行时间测量，调试版本默认打开，比赛版本（不定义 DEBUG）完全去掉 */
+#ifndef PDM_CFG_PROFILE
+#ifdef DEBUG
+#define PDM_CFG_PROFILE             1
+#else
+#define PDM_CFG_PROFILE             0
+#endif
+#endif
+
+/* 周期性通过 UART 输出测量结果的间隔 (ms)，0 表示只在请求时输出 */
+#ifndef PDM_CFG_PROFILE_DUMP_MS
+#define PDM_CFG_PROFILE_DUMP_MS     0
+#endif
+
+/* LibDriver 驱动错误信息的处理（见 pdm_diag.h）：
+ * 0: 只按器件和信息计数，命令行 diag 查看（比赛版本默认）
+ * 1: 计数，并由 1 s 的 UART 任务限速输出新增的次数（调试版本默认）
+ * 2: 每条立即格式化写入日志（原来的方式，逐条排查驱动问题时用） */
+#ifndef PDM_CFG_DIAG_LEVEL
+#ifdef DEBUG
+#define PDM_CFG_DIAG_LEVEL          1
+#else
+#define PDM_CFG_DIAG_LEVEL          0
+#endif
+#endif
+/* 计数表的条数（器件 x 信息），满了以后新的信息只计入 overflow */
+#ifndef PDM_CFG_DIAG_EVENTS
+#define PDM_CFG_DIAG_EVENTS         8
+#endif
+/* 级别 1 时每秒最多输出的行数 */
+#ifndef PDM_CFG_DIAG_LINES
+#define PDM_CFG_DIAG_LINES          2
+#endif
+
+/* 板上基准测试：启动时运行一组固定操作并输出周期数表格，见 pdm_bench.h；由 make bench 定义 */
+#ifndef PDM_CFG_BENCH
+#define PDM_CFG_BENCH               0
+#endif
+/* 每项的运行次数 */
+#ifndef PDM_CFG_BENCH_ITER
+#define PDM_CFG_BENCH_ITER          1000
+#endif
+
+#endif /* PDM_CONFIG_H */
@@ -0,0 +1,102 @@
+#ifndef PDM_CRASH_H
+#define PDM_CRASH_H
+
+#include <stdint.h>
+#include "pdm_config.h"
+
+/*
+ * 崩溃记录：HardFault、NMI 和 Error_Handler() 不再停在死循环里，把现场写入 .noinit 段后立即复位，
+ * 下次启动时发送到 CAN 并记入事件记录（PDM_EV_CRASH）。平时的开销只有调度器每个任务前后各一次字节写入。
+ * HardFault_Handler 为 naked 函数，按 EXC_RETURN 选择 MSP 或 PSP（RTOS 线程），把异常栈帧地址交给
+ * PDM_Crash_Fault()，记录栈帧中的 r0~r3、r12、lr、pc、xPSR，异常前的 SP 和 SCB 的 CFSR/HFSR/BFAR/MMFAR。
+ * MemManage/BusFault/UsageFault 没有使能，都升级为 HardFault；栈指针已经超出 RAM 时内核锁死，由看门狗复位。
+ * 另记录当时正在运行的调度器任务和最近运行的 PDM_CRASH_TRACE 个任务（任务序号，见 pdm_sched.h；
+ * RTOS 配置下为最近开始运行的任务）。
+ * 记录带 CRC，上电时内容无效；复位后保留到下一次崩溃或 crash clear，只在第一次启动时发送。
+ * 调试器连接时先执行断点停在现场，继续运行后再复位。
+ * PDM_CRASH_CAN_ID 帧共 PDM_CRASH_PAGES 帧，每 5 ms 发送一帧：
+ *   页 0~14  [页号, 类型, 值 (4, 大端), 任务, 次数]，值按 PDM_CRASH_V_* 的顺序
+ *   页 15~16 [页号, 类型, 最近运行的任务 x 6]，页 15 第一个最新，没有的为 0xFF
+ * 解码见 Tools/pdm_crash.py。
+ */
+
+#if PDM_CFG_CRASH
+
+#define PDM_CRASH_CAN_ID        0x315
+
+/* 类型 */
+#define PDM_CRASH_HARDFAULT     1
+#define PDM_CRASH_NMI           2       /* 时钟安全系统（HSE 失效） */
+#define PDM_CRASH_ERROR         3       /* Error_Handler()：只有 pc（调用处）、任务和任务记录 */
+
+#define PDM_CRASH_NO_TASK       0xFF
+#define PDM_CRASH_TRACE         12
+
+/* 值的序号 */
+#define PDM_CRASH_V_TICK        0       /* HAL_GetTick() */
+#define PDM_CRASH_V_PC          1
+#define PDM_CRASH_V_LR          2
+#define PDM_CRASH_V_XPSR        3       /* 低 9 位不为 0 时崩溃发生在中断中 */
+#define PDM_CRASH_V_SP          4
+#define PDM_CRASH_V_CFSR        5
+#define PDM_CRASH_V_HFSR        6
+#define PDM_CRASH_V_BFAR        7
+#define PDM_CRASH_V_MMFAR       8
+#define PDM_CRASH_V_R0          9       /* r0 r1 r2 r3 r12 */
+#define PDM_CRASH_V_EXC_RETURN  14
+#define PDM_CRASH_VALUES        15
+
+#define PDM_CRASH_PAGES         (PDM_CRASH_VALUES + (PDM_CRASH_TRACE + 5u) / 6u)
+
+typedef struct {
+    uint8_t type;                       /* PDM_CRASH_* */
+    uint8_t task;                       /* 崩溃时正在运行的任务，PDM_CRASH_NO_TASK 不在任务中 */
+    uint8_t count;                      /* 上电以来的崩溃次数（到 255 保持） */
+    uint8_t trace[PDM_CRASH_TRACE];     /* 最近运行的任务，[0] 最新 */
+    uint32_t v[PDM_CRASH_VALUES];       /* PDM_CRASH_V_*，没有的为 0 */
+} pdm_crash_t;
+
+/* 调度器写入：当前任务和任务记录（不在 .noinit，崩溃时复制） */
+extern volatile uint8_t g_pdm_crash_task;
+extern uint8_t g_pdm_crash_trace[PDM_CRASH_TRACE];
+extern uint8_t g_pdm_crash_pos;
+
+static inline void PDM_Crash_TaskBegin(uint8_t task)
+{
+    g_pdm_crash_trace[g_pdm_crash_pos] = task;
+    if (++g_pdm_crash_pos >= PDM_CRASH_TRACE)
+    {
+        g_pdm_crash_pos = 0;
+    }
+    g_pdm_crash_task = task;
+}
+
+static inline void PDM_Crash_TaskEnd(void)
+{
+    g_pdm_crash_task = PDM_CRASH_NO_TASK;
+}
+
+/* HardFault_Handler 跳转到这里：frame 为异常栈帧，exc_return 为进入异常时的 LR；记录后复位 */
+void PDM_Crash_Fault(const uint32_t *frame, uint32_t exc_return) __attribute__((noreturn));
+
+/* Error_Handler() 和 NMI 调用：记录类型和调用处后复位 */
+void PDM_Crash_Error(uint8_t type, uint32_t pc) __attribute__((noreturn));
+
+/* 启动时检查上次复位前的记录；返回 1 为新的崩溃记录（准备发送），0 没有或已经发送过 */
+uint8_t PDM_Crash_Init(void);
+
+/* CAN 任务调用：逐帧发送新的崩溃记录 */
+void PDM_Crash_Poll(void);
+
+/* 保留下来的最近一次崩溃，没有时返回 NULL */
+const pdm_crash_t *PDM_Crash_Last(void);
+
+/* 清除保留的记录 */
+void PDM_Crash_Clear(void);
+
+/* 命令行 crash：保留的记录，任务显示名称 */
+void PDM_Crash_Print(void);
+
+#endif /* PDM_CFG_CRASH */
+
+#endif /* PDM_CRASH_H */
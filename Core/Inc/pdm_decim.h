@@ -0,0 +1,50 @@
+#ifndef PDM_DECIM_H
+#define PDM_DECIM_H
+
+#include <stdint.h>
+#include "pdm_config.h"
+#include "pdm_calc.h"
+
+/*
+ * 每通道的软件抽取（分流电压寄存器值，整数运算），用于电池侧等接近零电流时需要更细分辨率的通道。
+ * INA226 的硬件平均最多 1024 次，结果截成 16 位寄存器，低于 1 LSB（2.5 uV）的部分丢失；
+ * 这里把 2^shift 个连续采样的寄存器值相加（一阶 CIC，即不重叠的矩形窗），和保留全部小数位，
+ * 每组输出一次，输出率为采样率 / 2^shift。噪声大于 1 LSB 时相当于抖动，分辨率约提高 shift / 2 位。
+ * 输入为零点修正之后的分流值（采样事件中的 snap），所以漂移修正不受影响。
+ * 要得到收益，通道应以较快的速度提供新的转换：缩短采样周期（命令 0x02）、减小该通道的平均次数（运行参数），
+ * 让每次读取都是一次新的转换；抽取比越大，输出越慢、越细。
+ * 输出为分流值 x 256（Q8），按采样电阻换算成 uA。shift 为 0 时该通道不抽取。
+ * 只在采集中调用 PDM_Decim_Add()（采样事件），其余函数在主循环（通信任务）中调用，读取的都是 32 位整字。
+ * CAN 帧 PDM_DECIM_CAN_ID（PDM_CFG_DECIM_PERIOD_MS，每次一个打开抽取的通道，轮流发送，大端）：
+ *   [通道, shift, 输出次数 (低 8 位), 有效 (1 已有输出), 电流 uA (4, 有符号)]
+ */
+
+#if PDM_CFG_DECIM
+
+#define PDM_DECIM_CAN_ID        0x30F
+#define PDM_DECIM_MAX_SHIFT     8       /* 最多 256 个采样一组，和的 Q8 不超过 int32 */
+
+/* 按 PDM_CFG_DECIM_MASK / PDM_CFG_DECIM_SHIFT 设置通道并清除状态，sc 为该通道的换算常量 */
+void PDM_Decim_Init(uint8_t ch, const pdm_scale_t *sc);
+
+/* 清除状态，丢弃未满一组的采样（器件重新初始化后调用） */
+void PDM_Decim_Reset(uint8_t ch);
+
+/* 修改通道的抽取比 2^shift（0 关闭，最大 PDM_DECIM_MAX_SHIFT）并清除状态；返回 0 成功，1 参数错误 */
+uint8_t PDM_Decim_Set(uint8_t ch, uint8_t shift);
+
+/* 加入一个采样（分流电压寄存器值） */
+void PDM_Decim_Add(uint8_t ch, int16_t shunt);
+
+/* 最近一次输出；返回 0 成功，1 该通道不抽取或还没有输出。shunt_q8 为分流值 x 256，可为 NULL */
+uint8_t PDM_Decim_Get(uint8_t ch, int32_t *shunt_q8, int32_t *current_ua);
+
+/* CAN 报文表的编码函数 */
+void PDM_Decim_Encode(uint8_t *data, const void *arg);
+
+/* 命令行 decim：每通道的抽取比、输出次数和最近的输出 */
+void PDM_Decim_Print(void);
+
+#endif /* PDM_CFG_DECIM */
+
+#endif /* PDM_DECIM_H */
@@ -0,0 +1,34 @@
+#ifndef PDM_DERIVED_H
+#define PDM_DERIVED_H
+
+#include <stdint.h>
+#include "pdm_config.h"
+
+/*
+ * 总线侧和电池侧的派生量。总线侧测量 DCDC 和电池经 OR-RING 汇合后的总输出，电池侧只测电池支路，
+ * 两路时间相近的采样（同一组读取）配对后计算，不再由下游用两帧时间不同的数值相减：
+ *   DCDC 电流       I_bus - I_bat（电池回充时包括回充电流）
+ *   DCDC 功率       V_bus x (I_bus - I_bat)
+ *   OR-RING 损耗    (V_bat - V_bus) x I_bat，只在电池放电时计入
+ *   电池占比        I_bat / I_bus，DCDC 占比 = 100% - 电池占比
+ *   损耗占比        损耗 / (P_bus + 损耗)，OR-RING 效率 = 100% - 损耗占比
+ * DCDC 输入侧没有测量，这里不给出 DCDC 本身的效率。
+ * 每个 PDM_CFG_DERIVED_PERIOD_MS 在 PDM_DERIVED_CAN_ID 发出本周期所有配对采样的平均，大端：
+ *   [DCDC 电流 (2, 10 mA/LSB, 有符号), DCDC 功率 (2, 100 mW/LSB, 有符号), OR-RING 损耗 (2, 1 mW/LSB),
+ *    电池占比 (0.5%/LSB, 0~200), 损耗占比 (0.1%/LSB)]
+ * 本周期没有配对采样时为 0x7FFF/0x7FFF/0xFFFF/0xFF/0xFF；总线电流低于 100 mA 时占比为 0xFF。
+ */
+
+#if PDM_CFG_DERIVED
+
+#define PDM_DERIVED_CAN_ID      0x308
+
+/* 计入一对采样：电压 mV，电流 uA（放电为正） */
+void PDM_Derived_Add(int32_t bus_mV, int32_t bus_uA, int32_t bat_mV, int32_t bat_uA);
+
+/* CAN 帧编码（报文表回调），输出本周期平均并开始下一周期 */
+void PDM_Derived_Encode(uint8_t *data, const void *arg);
+
+#endif /* PDM_CFG_DERIVED */
+
+#endif /* PDM_DERIVED_H */
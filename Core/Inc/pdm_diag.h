@@ -0,0 +1,29 @@
+#ifndef PDM_DIAG_H
+#define PDM_DIAG_H
+
+#include <stdint.h>
+#include "pdm_config.h"
+
+/*
+ * LibDriver 驱动的错误信息（handle->debug_print，如 "ina226: read mask register failed.\n"）。
+ * 器件掉线时驱动每次读取失败都打印一条，原来每条都在采集任务中经过 vsnprintf 写入日志，
+ * 还会占满日志块、挤掉其他信息。这里驱动的信息只记为一个事件：器件地址（接口层最近一次访问的器件）、
+ * 信息字符串的地址（驱动中的常量，不复制、不格式化）和次数，一次记录只有查表和加 1。
+ * 输出按 PDM_CFG_DIAG_LEVEL：0 不输出，1 由 UART 任务每秒最多输出 PDM_CFG_DIAG_LINES 行新增的次数，
+ * 2 立即格式化输出（与原来相同）。命令行 diag 列出全部计数。
+ * 驱动的信息都不带参数，级别 0、1 忽略可变参数。
+ */
+
+/* 驱动的 debug_print（由接口层 ina226_interface_driver_print 转入），addr 为器件地址 */
+void PDM_Diag_Note(uint8_t addr, const char *msg);
+
+/* 输出新增的事件，级别 1 时由 1 s 的 UART 任务调用 */
+void PDM_Diag_Poll(void);
+
+/* 清零计数表 */
+void PDM_Diag_Clear(void);
+
+/* 命令行 diag：每个事件的器件、信息、次数和最近一次的时间 */
+void PDM_Diag_Print(void);
+
+#endif /* PDM_DIAG_H */
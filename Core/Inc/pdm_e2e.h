@@ -0,0 +1,29 @@
+#ifndef PDM_E2E_H
+#define PDM_E2E_H
+
+#include <stdint.h>
+#include "pdm_config.h"
+
+/*
+ * 通道帧的端到端保护（PDM_CFG_E2E=1）。原有 0x300/0x301 不变，另在 通道帧 ID + PDM_CFG_E2E_ID_OFFSET 发送：
+ *   [电压 (2), 电流 (2), 功率 (2), 状态 << 4 | 计数器, CRC]，前三个字段与原通道帧相同
+ * 计数器每发送一帧加 1（0~15 循环），接收方看到计数器不变即为重复的旧帧；
+ * 状态 bit0（data[6] bit4）为 1 表示该通道有可信度标志（见 pdm_plaus.h）。
+ * CRC 用 STM32F1 的 CRC 外设计算：CRC-32/MPEG-2（多项式 0x04C11DB7，初值 0xFFFFFFFF，不反转，不异或），
+ * 输入为 3 个 32 位字 [CAN ID, data[0:3], data[4:6] << 8]（大端组字），取结果的低 8 位。
+ * CAN ID 参与计算，其他 ID 的帧不会被误认为该帧。
+ */
+
+#if PDM_CFG_E2E
+
+#define PDM_E2E_STATUS_PLAUS    0x01
+
+/* 打开 CRC 外设时钟 */
+void PDM_E2E_Init(void);
+
+/* 填写 data[6] 的计数器和 data[7] 的 CRC；data[6] 高 4 位为状态，alive 为该帧的计数器 */
+void PDM_E2E_Protect(uint32_t id, uint8_t *alive, uint8_t *data);
+
+#endif /* PDM_CFG_E2E */
+
+#endif /* PDM_E2E_H */
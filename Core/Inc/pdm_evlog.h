@@ -0,0 +1,77 @@
+#ifndef PDM_EVLOG_H
+#define PDM_EVLOG_H
+
+#include <stdint.h>
+#include "pdm_config.h"
+
+/*
+ * 故障/事件记录：切断、ALERT、传感器离线和恢复、CAN 离线、启动（含看门狗复位）、崩溃各记一条，断电后保留。
+ * 使用参数区（pdm_param.h）之前的 PDM_CFG_EVLOG_PAGES 页，每条 16 字节，每页 64 条，按顺序追加，
+ * 写满后擦除最旧的一页继续写（最多保留 PDM_CFG_EVLOG_PAGES x 64 条，至少 (PDM_CFG_EVLOG_PAGES - 1) x 64 条）。
+ * 记录（小端，与 flash 中相同）：
+ *   [序号 4][时间 ms 4 (HAL_GetTick())][类型][通道 (0xFF 不对应通道)][参数 2][值 2][CRC16 2]
+ *   序号在所有启动之间连续递增，时间从每次启动开始，同一次启动的记录从前一条启动记录算起。
+ *   CRC 最后写入，写到一半掉电的记录 CRC 为 0xFFFF，读出时跳过。
+ * PDM_Evlog_Add() 只把事件放入 RAM 中的 PDM_CFG_EVLOG_RAM 条待写队列（关中断几 us，可以在任何中断中调用），
+ * 主循环中 PDM_Evlog_Run() 每次编程一条（8 个半字，约 0.5 ms），需要擦页（20~40 ms）时只在调用者允许时进行，
+ * 等待期间事件留在队列中；队列满时新事件丢弃并计数（命令行 events 显示）。
+ * 启动时只读各槽的序号和 CRC 字段找出最新一条，之后在 RAM 中保存最新一条的槽号和序号，
+ * 按序号直接算出槽号，读取最近 N 条不需要扫描 flash。
+ * ISO-TP 下载（来源 5）：[0x01, 5] 全部记录，[0x01, 5, N] 最近 N 条；从最新一条开始，每条 16 字节，
+ * 包括还在待写队列中的事件。解码见 Tools/pdm_evlog.py。
+ */
+
+/* 事件类型，参数和值的含义 */
+#define PDM_EV_BOOT         1   /* 启动：参数 = 复位原因（PDM_RESET_*），值 = 上电次数（低 16 位） */
+#define PDM_EV_TRIP         2   /* 软件切断：参数 = 故障类型（PDM_PROT_*），值 = 该通道切断次数 */
+#define PDM_EV_ALERT        3   /* 硬件门限 ALERT：参数 = 故障类型，值 = 该通道 ALERT 次数 */
+#define PDM_EV_OFFLINE      4   /* 传感器连续读取失败判为离线：值 = 该通道读取失败总次数（低 16 位） */
+#define PDM_EV_ONLINE       5   /* 传感器重新初始化成功：值 = 该通道重新初始化次数 */
+#define PDM_EV_BUSOFF       6   /* CAN 离线：参数 = TEC，值 = 离线次数 */
+#define PDM_EV_CRASH        7   /* 复位前崩溃（pdm_crash.h）：通道 = 任务序号，参数 = 类型，值 = pc 低 16 位 */
+
+#define PDM_EV_NO_CH        0xFF
+
+#if PDM_CFG_EVLOG
+
+#define PDM_EVLOG_REC_SIZE  16u
+
+typedef struct {
+    uint32_t seq;
+    uint32_t tick_ms;
+    uint8_t type;               /* PDM_EV_* */
+    uint8_t ch;
+    uint16_t arg;
+    uint16_t value;
+    uint16_t crc;
+} pdm_event_t;
+
+/* 扫描记录区，在第一个 PDM_Evlog_Add() 之前调用（之前加入的事件在此之后才分配序号）；
+ * 返回 0 成功，1 记录区与程序重叠，不可用（事件只在 RAM 中，不写入） */
+uint8_t PDM_Evlog_Init(void);
+
+/* 记录一个事件（可以在中断中调用） */
+void PDM_Evlog_Add(uint8_t type, uint8_t ch, uint16_t arg, uint16_t value);
+
+/* 推进写入；erase_ok 非 0 时允许在本次调用中擦除一页 */
+void PDM_Evlog_Run(uint8_t erase_ok);
+
+/* 可读出的事件数（flash 中的加上待写的） */
+uint16_t PDM_Evlog_Count(void);
+
+/* 最近第 k 个事件（0 为最近一个）；返回 0 成功，1 没有或记录损坏 */
+uint8_t PDM_Evlog_Get(uint16_t k, pdm_event_t *out);
+
+/* 固定下载的范围（最近 n 个，0 为全部），返回下载内容的字节数；
+ * 下载期间新增的事件不影响已固定的范围 */
+uint32_t PDM_Evlog_Latch(uint16_t n);
+
+/* 复制下载内容 [off, off + n) 到 buf；返回 0 成功，1 越界或记录已被擦除 */
+uint8_t PDM_Evlog_Read(uint32_t off, uint8_t *buf, uint8_t n);
+
+/* 命令行 events：最近 n 个事件和丢弃次数 */
+void PDM_Evlog_Print(uint16_t n);
+
+#endif /* PDM_CFG_EVLOG */
+
+#endif /* PDM_EVLOG_H */
@@ -0,0 +1,39 @@
+#ifndef PDM_FILTER_H
+#define PDM_FILTER_H
+
+#include <stdint.h>
+#include "pdm_config.h"
+#include "ina226_async.h"
+
+/*
+ * 每通道的采样滤波（电流、总线电压、功率寄存器值，整数运算）。
+ * 先做 3 点中值（去掉单个采样的尖峰，例如电机控制器的干扰），再做一阶 IIR 低通：
+ *   y += alpha x (x - y)，alpha 为 Q15（32768 = 1.0，即不做 IIR）
+ * 状态为 32 位、15 位小数，乘法用 64 位，每个采样的开销固定（3 个量各一次中值和一次乘法）。
+ * 中值让输出晚一个采样；IIR 的时间常数约为 采样周期 x 32768 / alpha。
+ * 滤波结果只用于 pdm_channel_t 的 *_f_* 字段和 0x304 第 4 页；
+ * 通道帧 0x300/0x301、能量、SOC、统计、保护、UART 采样流都使用未滤波的值。
+ */
+
+#if PDM_CFG_FILTER
+
+#define PDM_FILTER_ALPHA_ONE    32768u
+
+/* 按 PDM_CFG_FILTER_ALPHA / PDM_CFG_FILTER_MEDIAN 设置通道并清除状态 */
+void PDM_Filter_Init(uint8_t ch);
+
+/* 清除状态，下一个采样直接作为输出（器件重新初始化后调用） */
+void PDM_Filter_Reset(uint8_t ch);
+
+/* 修改通道的 alpha（1..32768）和中值开关并清除状态；返回 0 成功，1 参数错误 */
+uint8_t PDM_Filter_Set(uint8_t ch, uint16_t alpha_q15, uint8_t median);
+
+/* 当前设置 */
+void PDM_Filter_Get(uint8_t ch, uint16_t *alpha_q15, uint8_t *median);
+
+/* 滤波一个采样：out 的 current/bus/power 为滤波结果，mask/shunt 照抄 */
+void PDM_Filter_Apply(uint8_t ch, const ina226_regs_t *in, ina226_regs_t *out);
+
+#endif /* PDM_CFG_FILTER */
+
+#endif /* PDM_FILTER_H */
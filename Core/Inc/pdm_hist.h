@@ -0,0 +1,49 @@
+#ifndef PDM_HIST_H
+#define PDM_HIST_H
+
+#include <stdint.h>
+#include "pdm_config.h"
+
+/*
+ * 每通道电流分布（负载谱），选保险丝和 DCDC 用。
+ * 每个有效采样按电流寄存器原始值的绝对值（不分方向）计入一档，32 位计数，到最大值后不再增加：
+ *   档 0       |raw| < 256
+ *   档 1..14   每倍频程两档，下限依次为 256, 384, 512, 768, 1024 ... 16384, 24576
+ *   档 15      |raw| >= 32767（电流寄存器限幅，实际电流可能更大）
+ * 电流值 = 原始值 x 通道电流 LSB，默认 625 uA 时档 0 为 160 mA 以下，档 14 为 15.36~20.48 A。
+ * 查档只用一次前导零计数，每个采样开销固定。计数随能量一起保存到 flash（见 pdm_persist.h）。
+ *
+ * ISO-TP 下载（来源 4）格式，大端：
+ *   头 [通道数, 档数, 0, 0, 每通道电流 LSB uA (4)...]，后接各通道各档计数 (4)，通道 0 在前。
+ * 解码见 Tools/pdm_hist.py。
+ */
+
+#if PDM_CFG_HIST
+
+#define PDM_HIST_BINS           16
+
+/* 设置各通道电流 LSB（下载头中给出） */
+void PDM_Hist_Init(const uint32_t *current_ua_per_lsb);
+
+/* 计入一个采样 */
+void PDM_Hist_Add(uint8_t ch, int16_t current_raw);
+
+/* 清零，mask: bitN 对应通道 N */
+void PDM_Hist_Reset(uint8_t mask);
+
+/* 复制一个通道的计数（可以在中断中调用）/ 从 flash 记录恢复 */
+void PDM_Hist_Get(uint8_t ch, uint32_t *bins);
+void PDM_Hist_Restore(uint8_t ch, const uint32_t *bins);
+
+/* 档 bin 的下限（电流寄存器原始值） */
+uint16_t PDM_Hist_EdgeRaw(uint8_t bin);
+
+/* 复制一份当前计数供下载（传输期间计数仍在增加，下载内容不跟着变），返回下载内容的字节数 */
+uint32_t PDM_Hist_Latch(void);
+
+/* 复制下载内容 [off, off + n) 到 buf；返回 0 成功，1 越界 */
+uint8_t PDM_Hist_Read(uint32_t off, uint8_t *buf, uint8_t n);
+
+#endif /* PDM_CFG_HIST */
+
+#endif /* PDM_HIST_H */
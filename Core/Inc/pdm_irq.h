@@ -0,0 +1,37 @@
+#ifndef PDM_IRQ_H
+#define PDM_IRQ_H
+
+#include <stdint.h>
+#include "pdm_config.h"
+
+/*
+ * 中断优先级分配。NVIC 分组 4（4 位抢占优先级，无子优先级），数字小的可以打断数字大的：
+ *   0 故障    EXTI1/EXTI3（ALERT 门限故障、高速采集触发）、PVD（掉电前保存）
+ *   1 采样    TIM3 采样时钟（发起一组读取）
+ *   2 I2C     I2C1/I2C2 事件/错误（读取完成、启动下一个事务）
+ *   3 CAN     发送邮箱补充、接收 FIFO0
+ *   4 UART    日志 TX DMA、命令行 RX DMA、USART1 空闲线
+ *   5 RTOS    EXTI4 软件触发，唤醒 RTOS 任务（PDM_CFG_RTOS，见 pdm_rtos.h）；0~4 级不被内核屏蔽，不能调用内核函数
+ *  15 SysTick（HAL_Init() 中按 TICK_INT_PRIORITY 设置）、PDM_CFG_RTOS 时的 PendSV
+ * CubeMX 生成的初始化代码仍把 I2C、CAN 接收、EXTI 设为 0，PDM_Irq_Init() 在外设初始化之后统一改写，
+ * 重新生成代码不影响；模块中自己打开的中断（PVD、TIM3、USART1 DMA 等）直接使用下面的常量。
+ * 不同优先级的中断共享的数据都在关中断的短代码段中修改（CAN 发送队列、I2C 事务队列、冻结请求等）。
+ */
+
+#define PDM_IRQ_PRIO_FAULT      0
+#define PDM_IRQ_PRIO_SAMPLE     1
+#define PDM_IRQ_PRIO_I2C        2
+#define PDM_IRQ_PRIO_CAN        3
+#define PDM_IRQ_PRIO_UART       4
+#define PDM_IRQ_PRIO_RTOS       5
+
+/* 设置分组和所有外设中断的优先级，在 MX_xxx_Init() 之后、打开 CAN 通知之前调用 */
+void PDM_Irq_Init(void);
+
+#if PDM_CFG_PROFILE
+/* 输出每一级中断的最长执行时间（测量点 *_isr）和由此估算的最长响应延迟：
+ * 同级中已有一个中断在执行，再加上所有更高级中断各执行一次 */
+void PDM_Irq_Dump(void);
+#endif
+
+#endif /* PDM_IRQ_H */
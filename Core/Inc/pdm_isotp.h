@@ -0,0 +1,43 @@
+#ifndef PDM_ISOTP_H
+#define PDM_ISOTP_H
+
+#include <stdint.h>
+#include "pdm_config.h"
+
+/*
+ * ISO-TP (ISO 15765-2) 批量下载，经典 CAN，帧长固定 8 字节（不足时填 0xCC）。
+ * 上位机在 PDM_CFG_ISOTP_RX_ID 发送单帧请求和流控帧，PDM 在 PDM_CFG_ISOTP_TX_ID 回复：
+ * 首帧 + 连续帧，按上位机流控帧的块大小 (BS) 和最小间隔 (STmin) 发送；
+ * 超过 4095 字节时首帧使用 32 位长度格式。等待流控帧超过 1 s 放弃本次传输。
+ * 连续帧由主循环放入 CAN 发送队列，队列中最多同时 PDM_ISOTP_TXQ_LIMIT 帧，不挤占周期报文。
+ *
+ * 请求（单帧） / 肯定响应：
+ *   [0x01, 来源]                       -> [0x41, 来源, 数据...]
+ *       来源 0: 最近一次高速采集（格式见 PDM_Capture_Read()）
+ *       来源 1: flash 记录区原始内容（PDM_CFG_STORE_PAGES KB）
+ *       来源 2: 运行时间测量表（pdm_prof_stat_t 数组，小端）
+ *       来源 3: 已冻结的黑匣子（格式见 pdm_blackbox.h）
+ *       来源 4: 电流分布计数（格式见 pdm_hist.h），请求时的值
+ *       来源 6: 长时间趋势记录区（格式见 pdm_trend.h），RAM 中没写满的一组先写入 flash
+ *   [0x01, 5 (, N)]                    -> [0x41, 5, 事件...]，最近 N 个（省略时全部）故障/事件记录，格式见 pdm_evlog.h
+ *   [0x02, 地址 (4), 长度 (2)]，大端   -> [0x42, 数据...]，只允许 SRAM 和 flash
+ * 否定响应：[0x7F, 请求码, 原因]，原因 0x11 不支持，0x13 长度错误，0x22 数据不可用，0x31 超出范围。
+ * 传输进行中收到的新请求不处理。
+ */
+
+#if PDM_CFG_ISOTP
+
+#define PDM_ISOTP_TXQ_LIMIT     4
+
+/* 处理一帧收到的请求或流控帧（由 CAN 接收处理调用） */
+void PDM_Isotp_Rx(const uint8_t *data, uint8_t dlc);
+
+/* 发送连续帧、检查流控超时，由主循环每轮调用 */
+void PDM_Isotp_Run(void);
+
+/* 1: 有传输在进行 */
+uint8_t PDM_Isotp_Busy(void);
+
+#endif /* PDM_CFG_ISOTP */
+
+#endif /* PDM_ISOTP_H */
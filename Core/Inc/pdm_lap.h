@@ -0,0 +1,52 @@
+#ifndef PDM_LAP_H
+#define PDM_LAP_H
+
+#include <stdint.h>
+#include "pdm_config.h"
+#include "pdm_calc.h"
+
+/*
+ * 分段能量：每圈（lap）和每节（stint，若干圈，换车手/换电池）的能量、峰值电流和时长。
+ * 圈由 CAN 命令 0x05 或计圈报文 PDM_CFG_LAP_TRIGGER_ID 结束，节由命令 0x05 data[1] = 1 结束（同时结束当前圈）。
+ * 段能量直接用能量累计器（功率 LSB x us）的差值计算，能量清零时把已累计的部分带入当前段，
+ * 不受 CAN 能量字段 655.36 Wh 回绕和 10 mWh 分辨率的影响。峰值电流取每圈统计窗口的极值，节的峰值为各圈峰值的最大者。
+ * 最近 PDM_CFG_LAP_RING 段保存在 RAM 中，命令行 laps 输出。每段结束时在 PDM_LAP_CAN_ID 发出：
+ *   时长帧 [段类型 << 4 | 0xF, 段号, 时长 ms (4), 0, 0]
+ *   每通道 [段类型 << 4 | 通道, 段号, 能量 uWh (4), 峰值电流 10 mA/LSB (2，有符号)]，大端
+ * 段类型 0 圈，1 节；段号为本次上电起的序号（低 8 位），圈和节各自计数。
+ */
+
+#if PDM_CFG_LAP
+
+#define PDM_LAP_CAN_ID          0x307
+
+#define PDM_LAP_LAP             0
+#define PDM_LAP_STINT           1
+
+typedef struct {
+    uint8_t kind;                           /* PDM_LAP_LAP / PDM_LAP_STINT */
+    uint16_t seq;                           /* 段号，从 1 开始 */
+    uint32_t duration_ms;
+    uint32_t energy_uWh[PDM_CFG_CHANNELS];
+    int32_t peak_uA[PDM_CFG_CHANNELS];      /* 绝对值最大的电流（带方向） */
+} pdm_lap_seg_t;
+
+/* 设置通道换算常量，acc 为当前能量累计器，圈和节都从现在开始 */
+void PDM_Lap_Init(uint8_t ch, const pdm_scale_t *scale, uint64_t acc, uint32_t now);
+
+/* 通道能量累计器即将清零，old_acc 为清零前的值 */
+void PDM_Lap_Rebase(uint8_t ch, uint64_t old_acc);
+
+/* 1: 距上一圈结束已超过 PDM_CFG_LAP_MIN_MS（计圈报文去抖） */
+uint8_t PDM_Lap_Due(uint32_t now);
+
+/* 结束一圈（kind 为 PDM_LAP_STINT 时同时结束当前节）并发出 CAN 帧。
+ * acc: 各通道当前能量累计器，peak_uA: 各通道本圈峰值电流；返回本次记录的段数 */
+uint8_t PDM_Lap_End(uint8_t kind, uint32_t now, const uint64_t *acc, const int32_t *peak_uA);
+
+/* 取最近的第 back 段（0 最新）；返回 0 成功，1 没有 */
+uint8_t PDM_Lap_Get(uint8_t back, pdm_lap_seg_t *out);
+
+#endif /* PDM_CFG_LAP */
+
+#endif /* PDM_LAP_H */
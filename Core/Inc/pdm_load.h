@@ -0,0 +1,74 @@
+#ifndef PDM_LOAD_H
+#define PDM_LOAD_H
+
+#include <stdint.h>
+#include "pdm_config.h"
+
+/*
+ * CPU 负载：空闲路径（PDM_Sched_Idle() 的 WFI、RTOS 空闲任务）在休眠前和醒来后各读一次 DWT CYCCNT，
+ * 累计醒着的周期数，每 PDM_CFG_LOAD_WINDOW_MS 按 HAL_GetTick() 经过的时间结束一个窗口：
+ *   负载      醒着的周期数 / (窗口 ms x SystemCoreClock / 1000)，包括任务、中断和调度器本身
+ *   轮数      窗口内 PDM_Sched_Run() 的调用次数，换算为每秒（超级循环；RTOS 时为 0）
+ *   任务份额  窗口内该任务的运行时间（PDM_Sched_NowUs() 测量，含其间的中断）/ 窗口时间
+ * 只累计醒着的区间，休眠期间 CYCCNT 是否计数（与调试器设置有关）不影响结果；窗口按 1 ms tick 计，
+ * 1 s 窗口的误差在 0.1% 以内。平时的开销是每次休眠两次寄存器读和一次加法。
+ * 需要 PDM_CFG_IDLE_SLEEP：不休眠时主循环一直醒着，负载总是 100%。
+ * PDM_LOAD_CAN_ID 帧（1 s）：[负载 0.1% (2), 每秒轮数 (2), 任务序号, 该任务份额 0.1% (2), 上电以来最高负载 %]，
+ * 大端，每帧一个任务，各任务轮流。命令行 cpu 显示全部任务。
+ */
+
+#if PDM_CFG_LOAD
+
+#include "stm32f1xx.h"
+
+#define PDM_LOAD_CAN_ID         0x316
+
+typedef struct {
+    uint16_t load_pm;           /* 最近一个窗口的负载，千分比 */
+    uint16_t peak_pm;           /* 上电以来最高的窗口负载 */
+    uint32_t loops_per_s;
+    uint32_t window_ms;         /* 最近一个窗口的长度，0 为还没有结果 */
+} pdm_load_t;
+
+/* 空闲路径写入：醒着的周期数累计（回绕）和最近一次醒来时的 CYCCNT */
+extern uint32_t g_pdm_load_busy;
+extern uint32_t g_pdm_load_wake;
+extern uint32_t g_pdm_load_loops;
+
+/* 关中断后、WFI 之前 */
+static inline void PDM_Load_IdleEnter(void)
+{
+    g_pdm_load_busy += DWT->CYCCNT - g_pdm_load_wake;
+}
+
+/* WFI 之后、开中断之前 */
+static inline void PDM_Load_IdleExit(void)
+{
+    g_pdm_load_wake = DWT->CYCCNT;
+}
+
+static inline void PDM_Load_Loop(void)
+{
+    g_pdm_load_loops++;
+}
+
+/* 打开 CYCCNT 并开始第一个窗口（PDM_Prof_Init() 之后调用，它会把 CYCCNT 清零） */
+void PDM_Load_Init(void);
+
+/* 窗口到时间时计算结果，任务中调用 */
+void PDM_Load_Poll(uint32_t now);
+
+void PDM_Load_Get(pdm_load_t *out);
+
+/* 任务 index 在最近一个窗口中的份额，千分比 */
+uint16_t PDM_Load_TaskPm(uint8_t index);
+
+/* CAN 帧编码（报文表回调） */
+void PDM_Load_Encode(uint8_t *data, const void *arg);
+
+/* 命令行 cpu */
+void PDM_Load_Print(void);
+
+#endif /* PDM_CFG_LOAD */
+
+#endif /* PDM_LOAD_H */
@@ -0,0 +1,49 @@
+#ifndef PDM_LOG_H
+#define PDM_LOG_H
+
+#include <stdint.h>
+#include <stdarg.h>
+
+/*
+ * UART 日志输出。
+ * 写入共享内存池（pdm_pool.h）中按顺序串起的 32 字节块后立即返回，由 USART1 TX DMA 在后台逐块发送，
+ * 发完的块在 DMA 完成中断中归还。日志最多占 PDM_CFG_POOL_LOG_MAX 块。
+ * 只允许在主循环中写入（单写入者），DMA 完成中断负责读出。
+ */
+
+void PDM_Log_Init(void);
+
+/* 写入原始数据，空间不足时整条丢弃并计数；返回 0 成功，1 丢弃 */
+uint8_t PDM_Log_Write(const char *buf, uint16_t len);
+
+/*
+ * 逐段写入：PDM_Log_Begin() 之后的各段直接写进日志块，PDM_Log_End() 时整条提交，
+ * 空间不足时整条丢弃并计数（返回 1）。只做整数运算，不经过 vsnprintf，
+ * 用于周期性的测量输出；其他日志仍可用 PDM_Log_Printf()，但不要插在 Begin/End 之间。
+ */
+void PDM_Log_Begin(void);
+void PDM_Log_Char(char c);
+void PDM_Log_Str(const char *s);
+void PDM_Log_Int(int32_t v);
+void PDM_Log_Uint(uint32_t v);
+
+/* 定点数：v / div，保留 decimals 位小数，四舍五入（远离 0）；
+ * div 必须是 10^decimals 的整数倍，如 uA 按 mA 保留 1 位：PDM_Log_Fixed(uA, 1000, 1) */
+void PDM_Log_Fixed(int32_t v, uint32_t div, uint8_t decimals);
+
+uint8_t PDM_Log_End(void);
+
+/* 放弃 PDM_Log_Begin() 之后写入的内容，不输出（测量格式化耗时用，见 pdm_bench.h） */
+void PDM_Log_Cancel(void);
+
+/* 格式化写入 */
+void PDM_Log_Printf(const char *fmt, ...);
+void PDM_Log_VPrintf(const char *fmt, va_list args);
+
+/* 因缓冲区满被丢弃的消息条数 */
+uint32_t PDM_Log_GetDropCount(void);
+
+/* 阻塞等待缓冲区发送完毕（复位前使用） */
+void PDM_Log_Flush(uint32_t timeout_ms);
+
+#endif /* PDM_LOG_H */
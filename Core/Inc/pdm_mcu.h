@@ -0,0 +1,45 @@
+#ifndef PDM_MCU_H
+#define PDM_MCU_H
+
+#include <stdint.h>
+#include "pdm_config.h"
+
+/*
+ * MCU 自监测：ADC1 扫描模式连续转换内部温度传感器 (IN16)、VREFINT (IN17) 和备用模拟输入
+ * （PB0 IN8、PB1 IN9，PDM_CFG_MCU_EXT 个），DMA1 通道 1 循环写入 PDM_MCU_SCANS 组结果，
+ * 不开中断，CPU 只在取结果时对缓冲区求平均，主循环中没有等待转换的代码。
+ * 时钟 72 MHz / 6 = 12 MHz，每个通道采样 239.5 周期（温度传感器至少 17.1 us），转换约 21 us。
+ * VDDA 由 VREFINT 反推（F103 没有出厂校准值，用手册典型值 1.20 V），其他通道按 VDDA 换算。
+ * 温度 = (V25 - Vsense) / 4.3 mV/°C + 25，V25 芯片间差别大（1.34~1.52 V），绝对值误差可达十几度，
+ * 用于看温升趋势；用 PDM_CFG_MCU_V25_MV 按实测校正。
+ * PDM_MCU_CAN_ID 帧（1 s）：[温度 (2, 0.1 °C，有符号), VDDA (2, mV), IN8 (2, mV), IN9 (2, mV)]，大端，
+ * 未使用的输入为 0；ADC 未启动或还没有结果时全部为 0。
+ */
+
+#if PDM_CFG_MCU
+
+#define PDM_MCU_CAN_ID          0x30C
+#define PDM_MCU_SCANS           16      /* 平均的扫描组数 */
+
+typedef struct {
+    uint8_t ok;                 /* 1: 结果有效 */
+    int16_t temp_dC;            /* 0.1 °C */
+    uint16_t vdda_mV;
+    uint16_t ext_mV[2];
+} pdm_mcu_t;
+
+/* 配置 ADC1 和 DMA 并开始连续转换（自校准约 100 us）；返回 0 成功，1 ADC 没有响应 */
+uint8_t PDM_Mcu_Init(void);
+
+/* 对 DMA 缓冲区求平均并换算 */
+void PDM_Mcu_Get(pdm_mcu_t *out);
+
+/* CAN 报文表的编码函数 */
+void PDM_Mcu_Encode(uint8_t *data, const void *arg);
+
+/* 命令行 mcu */
+void PDM_Mcu_Print(void);
+
+#endif /* PDM_CFG_MCU */
+
+#endif /* PDM_MCU_H */
@@ -2,19 +2,103 @@
 #define PDM_MONITOR_H
 
 #include <stdint.h>
+#include "pdm_config.h"
+#include "pdm_calc.h"
+#include "driver_ina226.h"
+
+/*
+ * 采集流程：按通道表初始化传感器，按采样周期（或 ALERT、采样时钟、同步触发）发起异步读取，
+ * 读完后换算成通道数据、积分能量并发布，交给订阅采样事件的模块（pdm_bus.h）；离线器件按指数退避探测并重新初始化。
+ * CAN 报文见 pdm_telem.h，运行参数的应用见 pdm_apply.h，断电保存见 pdm_persist.h，UART 输出见 pdm_report.h。
+ */
+
+/* 器件状态：连续失败数次后判为离线，按指数退避探测，恢复后重新初始化 */
+#define PDM_DEV_ONLINE      0
+#define PDM_DEV_SUSPECT     1       /* 有失败，尚未判为离线 */
+#define PDM_DEV_OFFLINE     2
+
+/* 允许通过命令和运行参数设置的采样周期范围 (ms) */
+#define PDM_MONITOR_PERIOD_MIN  10
+#define PDM_MONITOR_PERIOD_MAX  1000
+
+/* 通道表中的一项；表中的采样电阻、平均次数和 CAN ID 为默认值，运行参数（pdm_param.h）为当前值 */
+typedef struct {
+    const char *name;           /* UART 输出用 */
+    uint8_t type;               /* pdm_sensor_type_t */
+    uint8_t bus;                /* 0: I2C1，1: I2C2 */
+    ina226_address_t addr;
+    uint16_t can_id;
+    ina226_avg_t avg;
+    pdm_scale_t scale;
+} pdm_channel_cfg_t;
 
 typedef struct {
     uint8_t online;
-    float voltage_mV;
-    float current_mA;
-    float power_mW;
-    float energy_mWh;
+    int32_t voltage_mV;     /* 总线电压 (mV) */
+    int32_t current_uA;     /* 电流 (uA)，放电为正 */
+    uint32_t power_uW;      /* 功率 (uW) */
+    uint64_t energy_acc;    /* 能量累计器（功率 LSB x us），见 pdm_calc.h */
+    uint32_t energy_uWh;    /* 累计耗电量 (uWh)，655.36 Wh 回绕 */
+    uint64_t energy_dis_acc;    /* 按方向的能量累计器（单位同上），本次上电起累计 */
+    uint64_t energy_chg_acc;
+    uint32_t energy_dis_uWh;    /* 放电（电流为正）能量 (uWh)，655.36 Wh 回绕 */
+    uint32_t energy_chg_uWh;    /* 充电（电流为负，如 DCDC 回充）能量 (uWh)，655.36 Wh 回绕 */
+    uint8_t energy_wraps;   /* energy_uWh 的回绕次数（低 8 位），断电保存 */
+    int64_t charge_acc;     /* 净电荷累计器（电流 LSB x us），放电为正，本次上电起累计 */
+    int32_t v_min_mV;       /* 历史最低电压 (mV)，断电保存 */
+    int32_t v_max_mV;       /* 历史最高电压 (mV)，断电保存 */
+    int16_t shunt_raw;      /* 最近一次分流电压寄存器值 (2.5 uV/LSB) */
+    int32_t voltage_f_mV;   /* 滤波后的电压、电流、功率（见 pdm_filter.h），不滤波时等于上面的值 */
+    int32_t current_f_uA;
+    uint32_t power_f_uW;
+    uint32_t sample_us;     /* 本次采样开始读取的时间（PDM_Sched_NowUs()），换算车辆时间见 pdm_timesync.h */
 } pdm_channel_t;
 
-extern volatile uint8_t g_alert1_flag;
-extern volatile uint8_t g_alert2_flag;
-
 void PDM_Monitor_Init(void);
 void PDM_Monitor_Update(void);
 
+/* 取一个通道的完整数据（同一次采样的 V/I/P/E），主循环和中断里都可以调用，不关中断；
+ * 返回 0 成功，1 通道号错误（*out 清零） */
+uint8_t PDM_Monitor_GetChannel(uint8_t ch, pdm_channel_t *out);
+
+/* 已发布数据的序号，每发布一份加 1（编码时判断有没有新的采样） */
+uint32_t PDM_Monitor_Seq(uint8_t ch);
+
+/* 通道表中的一项，ch 小于 PDM_CFG_CHANNELS；校准值按当前的运行参数 */
+const pdm_channel_cfg_t *PDM_Monitor_Config(uint8_t ch);
+
+/* 一个通道的器件状态 */
+typedef struct {
+    uint8_t health;             /* PDM_DEV_* */
+    uint8_t level;              /* 平均档位（pdm_adapt.h），关闭自动调整时始终为正常档 */
+    uint32_t errors;            /* 读取失败总次数 */
+    uint16_t reinits;           /* 恢复后重新初始化的次数 */
+    uint16_t restores;          /* 配置检查发现器件复位、按副本重新写入的次数 */
+} pdm_dev_status_t;
+
+void PDM_Monitor_GetStatus(uint8_t ch, pdm_dev_status_t *out);
+
+/* 运行参数中的采样电阻、平均次数或转换时间已修改：一组采样完成、I2C 空闲时按新参数重新配置该通道的器件 */
+void PDM_Monitor_Reconfigure(uint8_t ch);
+
+/* 启动时恢复断电保存的累计值（pdm_persist.h），只在 PDM_Monitor_Init() 发布第一份数据之前调用 */
+void PDM_Monitor_Restore(uint8_t ch, uint64_t energy_acc, uint8_t energy_wraps, int32_t v_min_mV, int32_t v_max_mV);
+
+/* 能量清零，mask: bitN 对应通道表中的通道 N（bit0 BUS, bit1 BAT） */
+void PDM_Monitor_ResetEnergy(uint8_t mask);
+
+/* 修改定时采样周期 (ms)；返回 0 成功，1 参数超出范围或处于 ALERT 采样模式 */
+uint8_t PDM_Monitor_SetSamplePeriod(uint16_t period_ms);
+
+/* 武装高速采集，已武装时立即触发；返回 0 成功，1 未编译或正在采集/发送 */
+uint8_t PDM_Monitor_StartCapture(void);
+
+/* 开始 (on = 1) 或停止只测电流的高速采样流；返回 0 成功，1 未编译或采集通道正忙 */
+uint8_t PDM_Monitor_FastStream(uint8_t on);
+
+#if PDM_CFG_CAPTURE && PDM_CFG_CAPTURE_BOOT
+/* 上电冲击电流采集（见 pdm_capture.h）：main() 中 I2C 初始化后、PDM_Monitor_Init() 之前调用 */
+void PDM_Monitor_BootCapture(void);
+#endif
+
 #endif /* PDM_MONITOR_H */
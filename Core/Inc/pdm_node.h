@@ -0,0 +1,62 @@
+#ifndef PDM_NODE_H
+#define PDM_NODE_H
+
+#include <stdint.h>
+#include "pdm_config.h"
+
+/*
+ * 同一条总线上的多块 PDM（前、后）。每块有一个节点号 0 ~ PDM_CFG_NODE_MAX-1，由运行参数 node 给出，
+ * 或 node 为 PDM_NODE_FROM_STRAP 时启动时读跳线（PDM_CFG_NODE_STRAP 位，内部上拉，接地为 1），同一个程序镜像用于所有节点。
+ * 程序中的 CAN ID 都按节点 0 编写，发送时加上 节点号 x PDM_CFG_NODE_STRIDE（在发送队列入队时换算），
+ * 节点 0 与原来完全相同；发给本节点的命令、XCP、ISO-TP 和回放帧同样加上偏移，接收过滤器按本节点的 ID 配置，
+ * 取出的帧已经换回节点 0 的 ID。VCU 广播的帧（时间同步、计圈、查询）所有节点都接收，不加偏移。
+ * 节点号只在启动时确定，修改参数 node 并保存后复位生效。
+ * 心跳帧 PDM_NODE_HB_CAN_ID（同样加偏移，PDM_CFG_NODE_HB_MS，0 不按周期发送）：
+ *   [节点号, 来源 (0 参数 / 1 跳线), 通道数, 通道在线位, 累计运行时间 s (4)]，大端
+ * 收到 PDM_CFG_NODE_DISCOVER_ID（广播，内容不解析）时所有节点立即各发一帧心跳，VCU 据此找到总线上的节点。
+ */
+
+#define PDM_NODE_FROM_STRAP     0xFF    /* 运行参数 node 取此值时读跳线 */
+
+#if PDM_CFG_NODE
+
+#define PDM_NODE_HB_CAN_ID      0x31F
+
+#define PDM_NODE_SRC_PARAM      0
+#define PDM_NODE_SRC_STRAP      1
+
+/* 启动时确定节点号，param 为运行参数 node；在发送任何 CAN 帧和配置接收过滤器之前调用 */
+void PDM_Node_Init(uint8_t param);
+
+uint8_t PDM_Node_Id(void);
+
+/* 节点 0 的 ID 换算为本节点在总线上的 ID（发送和接收过滤器） */
+uint32_t PDM_Node_TxId(uint32_t id);
+
+/* 收到的 ID 换回节点 0 的 ID，广播帧不变 */
+uint32_t PDM_Node_RxId(uint32_t id);
+
+/* 收到查询帧：下一次 PDM_Node_Poll() 立即发送心跳 */
+void PDM_Node_Discover(void);
+
+/* CAN 任务调用：按周期或查询发送心跳 */
+void PDM_Node_Poll(uint32_t now);
+
+/* 命令行 node：节点号、来源、ID 偏移、跳线读数 */
+void PDM_Node_Print(void);
+
+#else
+
+static inline uint32_t PDM_Node_TxId(uint32_t id)
+{
+    return id;
+}
+
+static inline uint32_t PDM_Node_RxId(uint32_t id)
+{
+    return id;
+}
+
+#endif /* PDM_CFG_NODE */
+
+#endif /* PDM_NODE_H */
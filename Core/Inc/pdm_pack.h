@@ -0,0 +1,44 @@
+#ifndef PDM_PACK_H
+#define PDM_PACK_H
+
+#include <stdint.h>
+
+/*
+ * 采样序列压缩：按块做差分 + zigzag + 定宽位打包，边采样边编码，不需要对整段数据再扫描一遍。
+ * 每个字段（如电流原始值、时间戳）单独一个编码器，每 PDM_PACK_BLOCK 个值编码为一块：
+ *   [值个数 n][位宽 w][第一个值：zigzag 后的变长整数 (LEB128)][后 n-1 个差分：zigzag 后每个 w 位，高位在前，末尾补 0 到整字节]
+ * 差分按 32 位有符号计算，16 位寄存器值的差分最多 17 位；相邻采样只差几个 LSB 时 w 只有 2~5 位。
+ * 解码见 Tools/pdm_pack.py。
+ */
+
+#define PDM_PACK_BLOCK          16u
+
+/* 一块编码后的最大字节数：2 + 5 + (PDM_PACK_BLOCK - 1) x 32 / 8 */
+#define PDM_PACK_MAX_BYTES      (7u + ((PDM_PACK_BLOCK - 1u) * 32u + 7u) / 8u)
+
+/* 16 位字段（差分最多 17 位）一块的最大字节数 */
+#define PDM_PACK_MAX_BYTES_16   (5u + ((PDM_PACK_BLOCK - 1u) * 17u + 7u) / 8u)
+
+typedef struct {
+    uint8_t n;                          /* 本块已有的值 */
+    uint32_t first;                     /* 本块第一个值 */
+    uint32_t prev;
+    uint32_t zz[PDM_PACK_BLOCK - 1u];   /* 差分的 zigzag 值 */
+    uint32_t or_all;                    /* 所有 zigzag 值按位或，决定位宽 */
+} pdm_pack_t;
+
+void PDM_Pack_Init(pdm_pack_t *p);
+
+/* 加入一个值（有符号字段先转换为 int32 再转 uint32）；返回 1 本块已满，应调用 PDM_Pack_Flush() */
+uint8_t PDM_Pack_Put(pdm_pack_t *p, uint32_t v);
+
+/* 本块的值个数 */
+static inline uint8_t PDM_Pack_Count(const pdm_pack_t *p)
+{
+    return p->n;
+}
+
+/* 输出本块（不足一块也可以输出），清空以便编码下一块；返回写入 out 的字节数，本块为空时为 0 */
+uint8_t PDM_Pack_Flush(pdm_pack_t *p, uint8_t *out);
+
+#endif /* PDM_PACK_H */
@@ -0,0 +1,20 @@
+#ifndef PDM_PAIR_H
+#define PDM_PAIR_H
+
+#include <stdint.h>
+#include "pdm_config.h"
+
+/*
+ * 总线侧（通道 0）和电池侧（通道 1）的采样配对：两路各有一个新采样后，计入派生量（pdm_derived.h）
+ * 并检查两路电压的关系（pdm_plaus.h）。同步触发和定时采样时两路在同一组读取中；
+ * ALERT 采样模式下两路各自转换，采样时间相差超过 PDM_CFG_DERIVED_SKEW_US 或有一路离线时不配对。
+ */
+
+#if PDM_CFG_DERIVED || PDM_CFG_PLAUS
+
+/* 采样任务每次处理完读取后调用，fresh 第 i 位为通道 i 刚发布了新采样；返回 1 可信度标志有变化 */
+uint8_t PDM_Pair_Add(uint8_t fresh);
+
+#endif
+
+#endif /* PDM_PAIR_H */
@@ -0,0 +1,103 @@
+#ifndef PDM_PARAM_H
+#define PDM_PARAM_H
+
+#include <stdint.h>
+#include "pdm_config.h"
+
+/*
+ * 运行参数：采样电阻、平均次数、转换时间、通道帧 CAN ID 和发送方式、采样周期。
+ * 编译期的值（pdm_config.h、通道表）作为默认值；修改后的参数保存在 flash 中，启动时读入 RAM，不需要重新编译。
+ * 参数区为存储区（pdm_store.h）之前的 PDM_PARAM_PAGES 页，记录按顺序追加，一页写满后擦除另一页继续写，
+ * 擦除时旧页上的记录还在，任何时候掉电都至少有一条完整记录。每条记录 PDM_PARAM_REC_SIZE 字节：
+ *   [版本 2][长度 2][参数][序号 4][CRC16 2][标志 2]
+ * 启动时只读各槽的标志和序号，CRC 只校验最新的一条，不影响启动时间。
+ * 每个版本只在 pdm_param_t 末尾增加字段：旧版本的记录读入该版本已有的字段，新字段取默认值；
+ * 比当前程序新的版本、长度不符、CRC 错误、参数值不合法时使用默认值（不改写 flash）。
+ *
+ * 运行中修改（CAN 命令 0x09 或命令行 param）立即作用于 RAM 中的参数，由使用者的 apply 回调只重新配置受影响的部分
+ * （见 pdm_apply.h：采样电阻和平均次数只重新配置该通道的芯片，转换时间重新配置所有通道）；
+ * 保存到 flash 需要单独的 save 操作。保存时需要擦页则 CPU 停止 20~40 ms，应在停车时进行。
+ */
+
+#define PDM_PARAM_VERSION       6       /* 2: 增加零点修正 offset，3: 增加切断门限，4: 增加按变化发送，5: 增加阶跃门限，6: 增加节点号 */
+#define PDM_PARAM_PAGES         2
+#define PDM_PARAM_REC_SIZE      128u
+
+/* 参数 ID：全局参数，以及每通道参数（ID + 通道号） */
+#define PDM_PARAM_SAMPLE_MS     0x01    /* 采样周期 (ms) */
+#define PDM_PARAM_CAN_MS        0x02    /* 通道帧周期 (ms)，0 不按周期发送 */
+#define PDM_PARAM_CAN_ON_SAMPLE 0x03    /* 1: 每组采样后立即发送通道帧 */
+#define PDM_PARAM_BUS_CT        0x04    /* 总线电压转换时间（ina226_conversion_time_t） */
+#define PDM_PARAM_SHUNT_CT      0x05    /* 分流电压转换时间 */
+#define PDM_PARAM_CAN_MIN_MS    0x06    /* 通道帧按变化发送的最短间隔 (ms) */
+#define PDM_PARAM_CAN_MAX_MS    0x07    /* 通道帧按变化发送的最长间隔 (ms)，0 按周期发送 */
+#define PDM_PARAM_CAN_DB_MV     0x08    /* 按变化发送的电压死区 (mV) */
+#define PDM_PARAM_NODE          0x09    /* 节点号（0xFF 读跳线），复位后生效，见 pdm_node.h */
+#define PDM_PARAM_SHUNT_UOHM    0x10    /* 采样电阻 (uOhm)，电流 LSB 不变，只重算校准寄存器 */
+#define PDM_PARAM_AVG           0x20    /* 平均次数（ina226_avg_t） */
+#define PDM_PARAM_CAN_ID        0x30    /* 通道帧 CAN ID */
+#define PDM_PARAM_OFFSET        0x40    /* 零点修正（分流电压寄存器 LSB 2.5 uV，有符号），见 pdm_cal.h */
+#define PDM_PARAM_TRIP_OC       0x50    /* 瞬时过流门限 (mA)，见 pdm_trip.h */
+#define PDM_PARAM_TRIP_NOM      0x60    /* I2t 额定电流 (mA) */
+#define PDM_PARAM_TRIP_I2T      0x70    /* I2t 门限 (A^2 ms) */
+#define PDM_PARAM_TRIP_UV       0x80    /* 欠压门限 (mV) */
+#define PDM_PARAM_CAN_DB_MA     0x90    /* 按变化发送的电流死区 (mA) */
+#define PDM_PARAM_STEP_MA       0xA0    /* 负载阶跃检测门限 (mA)，0 不检测，见 pdm_step.h */
+
+/* 参数来源 */
+#define PDM_PARAM_SRC_FLASH     0
+#define PDM_PARAM_SRC_DEFAULT   1       /* flash 中没有记录 */
+#define PDM_PARAM_SRC_INVALID   2       /* 有记录但版本不符或校验失败，使用默认值 */
+
+typedef struct {
+    uint32_t shunt_uohm[PDM_CFG_CHANNELS];
+    uint16_t can_id[PDM_CFG_CHANNELS];
+    uint8_t avg[PDM_CFG_CHANNELS];
+    uint8_t bus_ct;
+    uint8_t shunt_ct;
+    uint16_t sample_ms;
+    uint16_t can_ms;
+    uint8_t can_on_sample;
+    /* 版本 2 */
+    int16_t offset[PDM_CFG_CHANNELS];
+    /* 版本 3 */
+    uint32_t trip_i2t[PDM_CFG_CHANNELS];
+    uint16_t trip_oc_ma[PDM_CFG_CHANNELS];
+    uint16_t trip_nom_ma[PDM_CFG_CHANNELS];
+    uint16_t trip_uv_mv[PDM_CFG_CHANNELS];
+    /* 版本 4 */
+    uint16_t can_min_ms;
+    uint16_t can_max_ms;
+    uint16_t can_db_mv;
+    uint16_t can_db_ma[PDM_CFG_CHANNELS];
+    /* 版本 5 */
+    uint16_t step_ma[PDM_CFG_CHANNELS];
+    /* 版本 6 */
+    uint8_t node;
+} pdm_param_t;
+
+/* 读入参数。check 检查一组参数是否可用（0 可用），用于 flash 中的记录和每次修改；
+ * apply 在 RAM 中的参数改变后调用，old 为改变前的参数。返回参数来源 PDM_PARAM_SRC_* */
+uint8_t PDM_Param_Init(const pdm_param_t *defaults, uint8_t (*check)(const pdm_param_t *p),
+                       void (*apply)(const pdm_param_t *old));
+
+/* 当前参数（RAM） */
+const pdm_param_t *PDM_Param_Get(void);
+
+/* 修改一个参数并立即应用，有符号参数按 32 位补码传入；返回 0 成功，1 ID 不存在或值不合法 */
+uint8_t PDM_Param_Set(uint8_t id, uint32_t value);
+
+/* 读一个参数（有符号参数为补码）；返回 0 成功，1 ID 不存在 */
+uint8_t PDM_Param_Value(uint8_t id, uint32_t *value);
+
+/* 当前参数写入 flash；返回 0 成功，1 参数区不可用或写入失败 */
+uint8_t PDM_Param_Save(void);
+
+/* 恢复默认值 / 重新读入 flash 中的参数，并立即应用；返回 0 成功，1 flash 中没有可用记录 */
+void PDM_Param_Defaults(void);
+uint8_t PDM_Param_Reload(void);
+
+/* 命令行 param：各参数的 ID、名称和值，参数来源和记录序号 */
+void PDM_Param_Print(void);
+
+#endif /* PDM_PARAM_H */
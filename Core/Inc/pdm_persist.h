@@ -0,0 +1,37 @@
+#ifndef PDM_PERSIST_H
+#define PDM_PERSIST_H
+
+#include <stdint.h>
+#include "pdm_config.h"
+
+/*
+ * 断电保存的累计数据：各通道累计能量和回绕次数、电压极值、电流分布计数（PDM_CFG_HIST），
+ * 上电次数、累计运行时间、电池剩余电量（PDM_CFG_SOC）、电池内阻（PDM_CFG_RINT）。
+ * 每 PDM_CFG_STORE_PERIOD_S 秒追加一条 flash 记录（pdm_store.h），PDM_CFG_PVD_SAVE 时 VDD 跌落的 PVD 中断中再写一条；
+ * 启动时读入最新的一条，上电后在 PDM_PERSIST_BOOT_ID 报告一次：
+ *   [标志, 复位原因, 上电次数(2), 累计运行时间 s(4)]，大端；标志 bit0 从 flash 恢复了累计数据，bit1 上次断电前成功保存
+ */
+
+#define PDM_PERSIST_BOOT_ID     0x302
+
+/* 启动时读入最新的记录并交给各模块，上电次数加 1；在 PDM_Monitor_Init() 清零通道数据之后、发布之前调用 */
+void PDM_Persist_Init(void);
+
+/* 存储任务中调用：到保存周期时追加一条记录 */
+void PDM_Persist_Poll(uint32_t now);
+
+/* 发送启动帧 */
+void PDM_Persist_SendBoot(void);
+
+/* 上电次数，包括本次 */
+uint32_t PDM_Persist_Boots(void);
+
+/* 累计运行时间 (s)，包括之前各次上电 */
+uint32_t PDM_Persist_UptimeS(void);
+
+#if PDM_CFG_PVD_SAVE
+/* 打开 PVD 中断：VDD 低于 PDM_CFG_PVD_LEVEL 时立即写一条记录，恢复后下次跌落再写 */
+void PDM_Persist_PvdInit(void);
+#endif
+
+#endif /* PDM_PERSIST_H */
@@ -0,0 +1,33 @@
+#ifndef PDM_PING_H
+#define PDM_PING_H
+
+#include <stdint.h>
+#include "pdm_config.h"
+#include "pdm_can.h"
+
+/*
+ * CAN 往返延迟测试：上位机在 PDM_CFG_PING_ID（按节点号偏移）发送任意 1~8 字节，第一个字节作为序号。
+ * 命令任务取出请求后立即在 PDM_PING_ECHO_ID 原样回复（DLC 相同），接着在 PDM_PING_TIME_ID 发送内部时间：
+ *   [序号, 取出 - 接收 (2), 入队 - 接收 (2), 接收时间低 24 位 (3)]，单位 us，大端，差值到 0xFFFF 保持
+ *   接收   RX 中断中的 PDM_Sched_NowUs()（与所有接收帧相同）
+ *   取出   PDM_Cmd_Poll() 从接收队列取出（等待 CAN 任务的时间）
+ *   入队   回复放入发送队列之后（之后到上总线的时间见命令行 canlat）
+ * 上位机的往返时间减去这两段就是总线和发送队列的时间。测试工具见 Tools/pdm_ping.py，命令行 ping 显示统计。
+ */
+
+#if PDM_CFG_PING
+
+#define PDM_PING_ECHO_ID        (PDM_CFG_PING_ID + 1u)
+#define PDM_PING_TIME_ID        (PDM_CFG_PING_ID + 2u)
+
+/* PDM_Cmd_Poll() 收到 PDM_CFG_PING_ID 时调用 */
+void PDM_Ping_Rx(const pdm_can_frame_t *f);
+
+/* 命令行 ping：请求数、回复失败次数和取出、入队延迟的最小/平均/最大值 */
+void PDM_Ping_Print(void);
+
+void PDM_Ping_Reset(void);
+
+#endif /* PDM_CFG_PING */
+
+#endif /* PDM_PING_H */
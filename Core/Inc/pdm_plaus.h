@@ -0,0 +1,52 @@
+#ifndef PDM_PLAUS_H
+#define PDM_PLAUS_H
+
+#include <stdint.h>
+#include "pdm_config.h"
+#include "ina226_async.h"
+
+/*
+ * 每个采样的读数可信度检查。读取成功（online）只说明 I2C 通信正常，下面的检查发现读数本身的问题：
+ *   OVF    数学溢出（MASK 寄存器 OVF 位），电流、功率寄存器不可用，本次采样丢弃
+ *   SHUNT  电流寄存器与 分流电压寄存器 x CAL / 2048 不符（校准寄存器被改写、两次读取跨了一次转换）
+ *   POWER  功率寄存器与 |电流寄存器| x 总线电压寄存器 / 20000 不符
+ *   STUCK  连续 PDM_CFG_PLAUS_STUCK_N 次新转换（CVRF 置位）的分流电压、总线电压、电流寄存器都不变
+ *   VREL   电池放电时总线电压不在 [电池电压 - PDM_CFG_PLAUS_DROP_MV, 电池电压 + PDM_CFG_PLAUS_VREL_TOL_MV]
+ *          之间（OR-RING 之后的总线电压不会比电池高，压降也有上限），同时标记总线侧和电池侧
+ * 除 OVF 外，不符（或恢复）连续 PDM_CFG_PLAUS_COUNT 个采样后标志才改变，单个采样跨转换不会误报。
+ * 标志只是提示，读数照常更新和发送；VCU 根据标志决定是否采用该通道的数据。
+ * PDM_PLAUS_CAN_ID 帧：[通道 0~3 的标志, 通道 0~3 有标志的采样数（到 255 保持）]，
+ * 与通道帧同周期发送，标志变化时立即发送一次。
+ */
+
+#if PDM_CFG_PLAUS
+
+#define PDM_PLAUS_CAN_ID        0x309
+
+#define PDM_PLAUS_OVF           0x01
+#define PDM_PLAUS_SHUNT         0x02
+#define PDM_PLAUS_POWER         0x04
+#define PDM_PLAUS_STUCK         0x08
+#define PDM_PLAUS_VREL          0x10
+
+/* 设置通道校准寄存器值并清除状态（器件初始化后调用） */
+void PDM_Plaus_Init(uint8_t ch, uint16_t cal);
+
+/* 本次读取数学溢出 */
+void PDM_Plaus_Overflow(uint8_t ch);
+
+/* 检查一个成功读取的采样 */
+void PDM_Plaus_Check(uint8_t ch, const ina226_regs_t *snap);
+
+/* 检查一对时间相近的总线侧（通道 0）和电池侧（通道 1）采样：电压 mV，电池电流 uA（放电为正） */
+void PDM_Plaus_Pair(int32_t bus_mV, int32_t bat_mV, int32_t bat_uA);
+
+/* 通道当前的标志 PDM_PLAUS_* */
+uint8_t PDM_Plaus_Flags(uint8_t ch);
+
+/* CAN 帧编码（报文表回调） */
+void PDM_Plaus_Encode(uint8_t *data, const void *arg);
+
+#endif /* PDM_CFG_PLAUS */
+
+#endif /* PDM_PLAUS_H */
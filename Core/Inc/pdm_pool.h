@@ -0,0 +1,53 @@
+#ifndef PDM_POOL_H
+#define PDM_POOL_H
+
+#include <stdint.h>
+#include "pdm_config.h"
+
+/*
+ * 共享内存池：PDM_CFG_POOL_BLOCKS 个固定大小的块，CAN 发送队列（每帧一块）、UART 日志（每块 32 字节文本）
+ * 和高速采集压缩发送（发送期间两块）从这里取用，不再各自按最坏情况占一个静态数组。
+ * 空闲块串成单向链表，分配和释放都是取/放链表头，O(1)，短暂关中断，中断中也可以调用；不使用 malloc。
+ * 每个使用者有两个限制：
+ *   reserve：保证可用的块数，其他使用者分配时为它留出（CAN 发送队列的故障帧不会因为日志突发而丢失）
+ *   quota：  最多持有的块数
+ * 超出 reserve 的部分谁先用谁得，各自的突发不同时出现时，同样的 RAM 可以容纳更大的突发。
+ * 命令行 pool 输出每个使用者的当前、最大用量和分配失败次数，据此调整块数。
+ */
+
+#define PDM_POOL_BLOCK_SIZE     40      /* 字节，4 的倍数 */
+
+enum {
+    PDM_POOL_CAN = 0,
+    PDM_POOL_LOG,
+    PDM_POOL_CAPTURE,
+    PDM_POOL_USERS
+};
+
+typedef struct {
+    uint8_t used;
+    uint8_t peak;
+    uint8_t reserve;
+    uint8_t quota;
+    uint32_t fails;             /* 分配失败次数 */
+} pdm_pool_stat_t;
+
+/* 在第一次使用（日志、CAN 初始化）之前调用 */
+void PDM_Pool_Init(void);
+
+/* 返回一块（PDM_POOL_BLOCK_SIZE 字节，4 字节对齐，内容不清零）；没有可用块时返回 NULL 并计数 */
+void *PDM_Pool_Alloc(uint8_t user);
+
+/* 归还 PDM_Pool_Alloc() 得到的块 */
+void PDM_Pool_Free(uint8_t user, void *blk);
+
+/* 空闲块数和上电以来的最小值 */
+uint8_t PDM_Pool_FreeCount(void);
+uint8_t PDM_Pool_FreeMin(void);
+
+void PDM_Pool_GetStat(uint8_t user, pdm_pool_stat_t *st);
+
+/* 命令行 pool */
+void PDM_Pool_Print(void);
+
+#endif /* PDM_POOL_H */
@@ -0,0 +1,72 @@
+#ifndef PDM_PROF_H
+#define PDM_PROF_H
+
+#include <stdint.h>
+#include "pdm_config.h"
+
+/*
+ * 基于 DWT CYCCNT 的运行时间测量。
+ * 在代码中用 PDM_PROF_BEGIN/END 包住要测量的一段，记录最小/最大/平均周期数。
+ * PDM_CFG_PROFILE 为 0 时所有宏为空，不占用任何代码和内存。
+ */
+
+/* 测量点列表：X(枚举名, 显示名) */
+#define PDM_PROF_LIST(X)                    \
+    X(PDM_PROF_SAMPLE,   "sample")          \
+    X(PDM_PROF_CAN_SEND, "can_send")        \
+    X(PDM_PROF_PRINT,    "print")           \
+    X(PDM_PROF_I2C_ISR,  "i2c_isr")         \
+    X(PDM_PROF_TRIP,       "trip")          \
+    X(PDM_PROF_TRIP_ALERT, "trip_alert")    \
+    X(PDM_PROF_TRIP_EVAL,  "trip_eval")     \
+    X(PDM_PROF_IRQ_FAULT,  "irq_fault")     \
+    X(PDM_PROF_IRQ_SAMPLE, "irq_sample")    \
+    X(PDM_PROF_IRQ_I2C,    "irq_i2c")       \
+    X(PDM_PROF_IRQ_CAN,    "irq_can")       \
+    X(PDM_PROF_IRQ_UART,   "irq_uart")
+
+#define PDM_PROF_ENUM(id, name) id,
+typedef enum {
+    PDM_PROF_LIST(PDM_PROF_ENUM)
+    PDM_PROF_COUNT
+} pdm_prof_id_t;
+#undef PDM_PROF_ENUM
+
+typedef struct {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+} pdm_prof_stat_t;
+
+#if PDM_CFG_PROFILE
+
+#include "stm32f1xx.h"
+
+void PDM_Prof_Init(void);
+void PDM_Prof_Record(pdm_prof_id_t id, uint32_t cycles);
+const pdm_prof_stat_t *PDM_Prof_Get(pdm_prof_id_t id);
+const char *PDM_Prof_Name(pdm_prof_id_t id);
+void PDM_Prof_Reset(void);
+/* 通过 UART 日志输出所有测量点（单位：CPU 周期和 us） */
+void PDM_Prof_Dump(void);
+
+static inline uint32_t PDM_Prof_Now(void)
+{
+    return DWT->CYCCNT;
+}
+
+#define PDM_PROF_BEGIN(id)  const uint32_t pdm_prof_t0_##id = PDM_Prof_Now()
+#define PDM_PROF_END(id)    PDM_Prof_Record((id), PDM_Prof_Now() - pdm_prof_t0_##id)
+
+#else
+
+#define PDM_Prof_Init()     do { } while (0)
+#define PDM_Prof_Reset()    do { } while (0)
+#define PDM_Prof_Dump()     do { } while (0)
+#define PDM_PROF_BEGIN(id)  do { } while (0)
+#define PDM_PROF_END(id)    do { } while (0)
+
+#endif /* PDM_CFG_PROFILE */
+
+#endif /* PDM_PROF_H */
@@ -0,0 +1,57 @@
+#ifndef PDM_PROTECT_H
+#define PDM_PROTECT_H
+
+#include <stdint.h>
+#include "pdm_config.h"
+#include "driver_ina226.h"
+#include "pdm_calc.h"
+
+/*
+ * 硬件门限保护。
+ * 总线侧 INA226 设置功率上限 (POL)，电池侧设置总线欠压 (BUL)，并打开 ALERT 锁存。
+ * 芯片每个转换结果都和门限比较，超限时拉低 ALERT，EXTI 中断中立即发出
+ * PDM_PROT_FAULT_ID 故障帧，不经过主循环：
+ *   [通道, 故障类型, 次数(2), 时间 ms(4)]，大端
+ * 锁存在下一次读 MASK 寄存器（每次采样）时清除，故障持续时每个采样周期会再发一帧。
+ */
+
+#define PDM_PROT_FAULT_ID       0x0F0   /* 高于所有通道报文的优先级 */
+
+/* 故障类型 */
+#define PDM_PROT_BUS_OVER_POWER 1
+#define PDM_PROT_BAT_UNDER_VOLT 2
+/* 软件门限切断（pdm_trip.h） */
+#define PDM_PROT_OVER_CURRENT   3
+#define PDM_PROT_I2T            4
+#define PDM_PROT_UNDER_VOLT     5
+
+#if PDM_CFG_PROTECT
+
+#if PDM_CFG_SAMPLE_ON_ALERT
+#error "PDM_CFG_PROTECT uses the ALERT pins for limits, it cannot be combined with PDM_CFG_SAMPLE_ON_ALERT"
+#endif
+
+typedef struct {
+    uint16_t count;             /* 故障次数 */
+    uint32_t last_tick;         /* 最近一次故障的时间 */
+} pdm_protect_stat_t;
+
+/* 写入两路门限，h_bus / h_bat 为已初始化的句柄，bus_scale 为总线侧通道的换算常量 */
+void PDM_Protect_Init(ina226_handle_t *h_bus, const pdm_scale_t *bus_scale, ina226_handle_t *h_bat);
+
+/* 暂停 / 恢复一路的门限（该芯片 ALERT 临时用于其他功能时），ch: 0 总线侧，1 电池侧。
+ * 会阻塞写芯片寄存器，只能在主循环中调用；返回 0 成功，1 失败 */
+uint8_t PDM_Protect_Suspend(uint8_t ch);
+uint8_t PDM_Protect_Resume(uint8_t ch);
+
+/* ALERT 引脚下降沿（EXTI 中断中调用） */
+void PDM_Protect_OnAlert(uint8_t ch);
+
+/* 主循环调用：打印新的故障 */
+void PDM_Protect_Run(void);
+
+const pdm_protect_stat_t *PDM_Protect_GetStat(uint8_t ch);
+
+#endif /* PDM_CFG_PROTECT */
+
+#endif /* PDM_PROTECT_H */
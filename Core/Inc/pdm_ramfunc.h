@@ -0,0 +1,35 @@
+#ifndef PDM_RAMFUNC_H
+#define PDM_RAMFUNC_H
+
+#include <stdint.h>
+#include "pdm_config.h"
+
+/*
+ * 在 SRAM 中执行的函数和中断向量表。
+ * PDM_RAMFUNC 把函数放进 .RamFunc 段：CubeIDE 生成的链接脚本把 .RamFunc 放在 .data 中
+ * （RAM 地址，加载地址在 flash），启动代码复制 .data 时一起复制，不需要另外的复制代码。
+ * 使用时注意：
+ *   - 加 noinline，否则 static 函数被内联进 flash 中的调用者，标记无效；
+ *   - flash 与 SRAM 之间的调用超出 BL 的范围，链接器自动插入长跳转桩（每次调用多几个周期），
+ *     被调用的函数（HAL、memcpy 等）仍在 flash 中执行，只标记循环集中、调用少的函数；
+ *   - 函数内的 const 表仍在 flash 中。
+ * 占用的 RAM 用 make ramfunc-report 查看（Tools/ramfunc_report.py 解析链接 map 文件）。
+ */
+
+#if PDM_CFG_RAMFUNC
+#define PDM_RAMFUNC     __attribute__((section(".RamFunc"), noinline))
+#else
+#define PDM_RAMFUNC
+#endif
+
+#if PDM_CFG_RAM_VECTORS
+/* 把当前向量表复制到 SRAM 并切换 VTOR；在 HAL_Init() 之前（中断打开之前）调用。
+ * Cortex-M3 从 SRAM 取向量与压栈都经过系统总线，不能并行，中断延迟不一定缩短，
+ * 开启前用 DWT 测量（PDM_PROF_I2C_ISR 等）比较 */
+void PDM_RamVectors_Init(void);
+
+/* 改写 SRAM 向量表中的一项，irqn 为 IRQn_Type（系统异常为负数） */
+void PDM_RamVectors_Set(int32_t irqn, void (*handler)(void));
+#endif
+
+#endif /* PDM_RAMFUNC_H */
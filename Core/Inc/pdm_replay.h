@@ -0,0 +1,55 @@
+#ifndef PDM_REPLAY_H
+#define PDM_REPLAY_H
+
+#include <stdint.h>
+#include "pdm_config.h"
+
+/*
+ * 回放模式（PDM_CFG_REPLAY=1，make REPLAY=1）：接口层不访问 I2C 总线，每个通道由一片虚拟 INA226 代替，
+ * 分流和总线电压来自上位机在 CAN 上发送的记录（Tools/pdm_replay.py 读取 pdm_stream.py 保存的 CSV），
+ * 之后的处理（零点修正、能量积分、切断判断、保护、CAN/UART 输出、flash 记录）与实车相同，
+ * 用于在板上用实车数据验证能量积分和保护逻辑，并测量处理能力。
+ * 虚拟器件：
+ *   CONF、校准、MASK/ALERT 设置、报警门限可读写，CONF 的复位位恢复上电默认值；ID 寄存器返回 TI / 0x2260。
+ *   读 MASK 相当于一次转换：通道的记录队列中有数据时取出一条，更新数据寄存器并置 CVRF，没有时数据不变、
+ *   CVRF 为 0（计入 stale，这次采样不处理）。电流 = 分流 x 校准 / 2048，功率 = |电流| x 总线 / 20000，与器件相同，
+ *   所以回放使用本机的校准值。ALERT 引脚不动作：硬件门限保护和高速采集不会触发，只能用定时采样。
+ *   INA228 通道（寄存器表不同）读 ID 失败，保持离线。
+ * 时间：每条记录带有与上一条的间隔，能量积分、I2t 等用这个间隔而不是本机的采样间隔，
+ * 本机采样周期（命令 0x02）比记录间隔短时即为加速回放，发送速度只受 CAN 和处理能力限制；
+ * 1 s 窗口统计、超时等仍按本机时间。
+ * 记录帧 PDM_CFG_REPLAY_ID（上位机发送，8 字节，大端）：
+ *   [标志 | 通道号 (bit3..0), 分流原始值 (2, 有符号), 总线原始值 (2), 间隔 (2, 100 us/LSB), 序号]
+ *   标志 bit7 为回放开始：清空所有通道的队列和统计；序号每帧加 1，不连续时计入 lost。
+ * 状态帧 PDM_REPLAY_CAN_ID（100 ms）：[各通道队列剩余空位的最小值, lost (饱和), served (2), stale (2), overflow (2)]，
+ * 上位机按剩余空位发送，队列满时丢弃的记录计入 overflow。
+ */
+
+#if PDM_CFG_REPLAY
+
+#define PDM_REPLAY_CAN_ID       0x30E
+#define PDM_REPLAY_START        0x80    /* 记录帧标志：回放开始 */
+#define PDM_REPLAY_DT_US        100u    /* 间隔的单位 */
+
+/* 把通道号和器件地址对应起来，通道初始化前调用 */
+void PDM_Replay_Bind(uint8_t ch, uint8_t addr);
+
+/* 代替总线读写（接口层调用）；返回 0 成功，1 无此器件或寄存器 */
+uint8_t PDM_Replay_Read(uint8_t addr, uint8_t reg, uint8_t *buf, uint16_t len);
+uint8_t PDM_Replay_Write(uint8_t addr, uint8_t reg, const uint8_t *buf, uint16_t len);
+
+/* 通道最近一次读 MASK 取出的记录的间隔 (us)，没有新记录时为 0 */
+uint32_t PDM_Replay_Dt(uint8_t ch);
+
+/* 收到记录帧（PDM_Cmd_Poll 中调用） */
+void PDM_Replay_Rx(const uint8_t *data, uint8_t len);
+
+/* CAN 报文表的编码函数 */
+void PDM_Replay_Encode(uint8_t *data, const void *arg);
+
+/* 命令行 replay：各通道队列和回放统计 */
+void PDM_Replay_Print(void);
+
+#endif /* PDM_CFG_REPLAY */
+
+#endif /* PDM_REPLAY_H */
@@ -0,0 +1,30 @@
+#ifndef PDM_REPORT_H
+#define PDM_REPORT_H
+
+#include <stdint.h>
+#include "pdm_config.h"
+
+/*
+ * UART 文本输出：每秒一行的通道数据，命令行 stats / laps / dbc，以及每圈统计。
+ * 统计来自 pdm_stats 的统计窗口，通道数据来自 PDM_Monitor_GetChannel()。
+ */
+
+/* 每秒一行："%s: %ldmV %.1fmA %.1fmW %.1fmWh (1s rms %.1fmA pk %.1fmW) | ..."，整数定点输出 */
+void PDM_Report_PrintLine(void);
+
+/* 各通道最近 1 s 的统计（min/mean/max、RMS、功率、读取错误数） */
+void PDM_Report_PrintStats(void);
+
+/* 结束所有通道的每圈统计窗口并输出结果；
+ * kind 为 1 时同时结束当前节（分段能量见 pdm_lap.h，未编译时忽略） */
+void PDM_Report_Lap(uint8_t kind);
+
+#if PDM_CFG_LAP
+/* 最近的各段能量 */
+void PDM_Report_PrintLaps(void);
+#endif
+
+/* 各通道帧的 DBC 定义（本节点的 ID，信号见 pdm_signals.h） */
+void PDM_Report_PrintSignals(void);
+
+#endif /* PDM_REPORT_H */
@@ -0,0 +1,47 @@
+#ifndef PDM_RINT_H
+#define PDM_RINT_H
+
+#include <stdint.h>
+#include "pdm_config.h"
+
+/*
+ * 电池内阻在线估计（电池侧通道，需要 PDM_CFG_STEP）。
+ * 每次负载阶跃（pdm_step.h）给出同一片 INA226 读出的阶跃前后电流和总线电压，两者来自同一次读取，
+ * 内阻 = -(后电压 - 前电压) / (后电流 - 前电流)（放电电流为正，放电增大时电压下降）。
+ * 不使用的阶跃：
+ *   电流变化小于 PDM_CFG_RINT_MIN_MA（电压变化只有几个 LSB，误差太大）
+ *   上升时间超过 PDM_CFG_RINT_MAX_RISE_MS（缓慢变化时电压中还有极化和电量变化）
+ *   结果不在 PDM_CFG_RINT_MIN_UOHM ~ PDM_CFG_RINT_MAX_UOHM 之间（包括符号相反）
+ *   已有 PDM_CFG_RINT_AVG_N 个结果后，与平均值相差超过一半（离群值）；
+ *   连续 8 个离群值时认为内阻确实变了（换电池、温度），平均值从下一个结果重新开始
+ * 平均：前 PDM_CFG_RINT_AVG_N 个结果为算术平均，之后为 1/PDM_CFG_RINT_AVG_N 的一阶滤波，随温度和老化缓慢变化。
+ * 平均值和结果数随能量一起保存到 flash，上电后从保存的值继续。
+ * 在主循环（CAN 任务）中查看新的阶跃，不在采集中计算。
+ * CAN 帧 PDM_RINT_CAN_ID（PDM_CFG_RINT_PERIOD_MS，大端）：
+ *   [平均内阻 (2, 10 uOhm/LSB), 最近一次结果 (2, 10 uOhm/LSB), 使用的阶跃数 (2), 不使用的阶跃数 (1, 饱和), 状态]
+ *   状态 bit0 平均值有效（至少 PDM_CFG_RINT_VALID_N 个结果，或从 flash 恢复），bit1 从 flash 恢复；
+ *   没有结果时内阻字段为 0xFFFF
+ */
+
+#if PDM_CFG_RINT
+
+#define PDM_RINT_CAN_ID         0x313
+
+#define PDM_RINT_FLAG_VALID     0x01
+#define PDM_RINT_FLAG_RESTORED  0x02
+
+/* 上电后从 flash 恢复（persist 记录中没有时不调用） */
+void PDM_Rint_Restore(uint32_t avg_uohm, uint16_t n);
+
+/* 主循环调用：处理新的阶跃，到周期时发送 CAN 帧 */
+void PDM_Rint_Run(uint32_t now);
+
+/* 平均内阻 (uOhm) 和结果数，断电保存用；没有结果时返回 0 */
+uint32_t PDM_Rint_Get(uint16_t *n);
+
+/* 命令行 rint：平均值、最近一次结果和各类不使用的次数 */
+void PDM_Rint_Print(void);
+
+#endif /* PDM_CFG_RINT */
+
+#endif /* PDM_RINT_H */
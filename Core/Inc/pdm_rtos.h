@@ -0,0 +1,58 @@
+#ifndef PDM_RTOS_H
+#define PDM_RTOS_H
+
+#include <stdint.h>
+#include "pdm_config.h"
+#include "pdm_sched.h"
+
+/*
+ * FreeRTOS 版本（make RTOS=1）：主循环改为三个任务，各自运行任务表中一组（pdm_task_t.group）：
+ *   acq    优先级 3  sample、capture、read；I2C 读取完成和 ALERT 时唤醒
+ *   comms  优先级 2  cmd、isotp、can、protect、shell；CAN 接收时唤醒
+ *   log    优先级 1  uart、store、wdg、led、prof
+ * 每个任务运行到期的任务后等待通知，超时为本组最近的到期时间（有上限，见 pdm_rtos.c）。
+ * 中断只改标志和队列（CAN 接收队列、I2C 事务队列、采样结果），与超级循环版本相同，任务间不另外传数据。
+ *
+ * 中断优先级：内核只屏蔽 5~15 级（PDM_IRQ_PRIO_RTOS 及更低）的中断，0~4 级（故障、采样、I2C、CAN、UART）
+ * 的响应不受内核影响，但也不能调用内核函数；它们调用 PDM_Rtos_Wake()，置位后软件触发 EXTI4（5 级），
+ * 由 EXTI4 中断发通知。SVC/PendSV 向量在启动时改为内核的处理函数（需要 PDM_CFG_RAM_VECTORS），
+ * SysTick 中断中 HAL_IncTick() 之后调用 PDM_Rtos_Tick()，内核节拍与 HAL 节拍都是 1 ms。
+ *
+ * 互斥：标记 PDM_SCHED_EXCL 的任务读写采集的数据（通道值、累计量、运行参数），运行期间持有同一个互斥量，
+ * 一次只有一个在运行；互斥量有优先级继承，log 任务中的 uart、store 持有时 acq 任务要等它运行完，
+ * 与超级循环中一样会推迟采集处理（读取本身在中断中进行，不受影响）。
+ * 日志从 PDM_Log_Begin() 到 PDM_Log_End() 持有日志互斥量，不同任务输出的行不会交错；先取任务互斥量再取日志互斥量。
+ *
+ * 命令行 rtos 输出距上次输出期间每个任务的 CPU 占用（运行时间统计，1 us 计数）和栈的最小剩余，
+ * 超级循环版本对应的是 stats（各任务运行时间）和 stack（主栈最大用量）。
+ */
+
+#if PDM_CFG_RTOS
+
+#define PDM_RTOS_WAKE_ACQ       (1u << PDM_SCHED_GROUP_ACQ)
+#define PDM_RTOS_WAKE_COMMS     (1u << PDM_SCHED_GROUP_COMMS)
+#define PDM_RTOS_WAKE_LOG       (1u << PDM_SCHED_GROUP_LOG)
+
+/* 创建任务并启动调度器，不返回；在 main() 中所有初始化之后调用 */
+void PDM_Rtos_Start(void);
+
+/* 唤醒 mask 中的任务，任意优先级的中断和任务中都可以调用 */
+void PDM_Rtos_Wake(uint8_t mask);
+
+/* SysTick 中断中调用 */
+void PDM_Rtos_Tick(void);
+
+/* 任务互斥量，调度器启动前不做任何事 */
+void PDM_Rtos_Lock(void);
+void PDM_Rtos_Unlock(void);
+
+/* 日志互斥量，调度器启动前和中断中不做任何事 */
+void PDM_Rtos_LogLock(void);
+void PDM_Rtos_LogUnlock(void);
+
+/* 命令行 rtos：输出各任务的 CPU 占用和栈剩余 */
+void PDM_Rtos_Print(void);
+
+#endif /* PDM_CFG_RTOS */
+
+#endif /* PDM_RTOS_H */
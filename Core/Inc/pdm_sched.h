@@ -0,0 +1,72 @@
+#ifndef PDM_SCHED_H
+#define PDM_SCHED_H
+
+#include <stdint.h>
+
+/*
+ * 协作式周期任务调度。
+ * 任务表由使用者静态定义，调度器按优先级顺序运行到期的任务，
+ * 并统计每个任务的延迟、最长运行时间和错过的周期数。
+ */
+
+typedef struct {
+    const char *name;
+    void (*run)(uint32_t now);
+    uint32_t period_ms;         /* 0: 每次调度都运行（后台任务，不统计超时） */
+    uint32_t phase_ms;          /* 相对启动时间的偏移，用于错开各任务 */
+    uint8_t priority;           /* 数值越小越先运行 */
+    uint8_t group;              /* PDM_CFG_RTOS 时所在的 RTOS 任务（PDM_SCHED_GROUP_*），可或上 PDM_SCHED_EXCL */
+} pdm_task_t;
+
+/* RTOS 任务分组（见 pdm_rtos.h），超级循环中不使用 */
+#define PDM_SCHED_GROUP_ACQ     0       /* 采集：读取完成时唤醒，最高优先级 */
+#define PDM_SCHED_GROUP_COMMS   1       /* CAN 收发与命令 */
+#define PDM_SCHED_GROUP_LOG     2       /* UART 输出、保存、心跳等后台工作 */
+#define PDM_SCHED_GROUPS        3
+#define PDM_SCHED_GROUP_MASK    0x0F
+#define PDM_SCHED_EXCL          0x80    /* 访问采集的数据，运行期间与采集任务互斥 */
+
+typedef struct {
+    uint32_t next_due;          /* 下一次到期的 tick */
+    uint32_t runs;              /* 运行次数 */
+    uint32_t missed;            /* 错过的周期数（启动时已晚于下一周期） */
+    uint32_t max_late_ms;       /* 最大启动延迟 */
+    uint32_t sum_late_ms;       /* 启动延迟累计，除以 runs 得平均值 */
+    uint32_t max_run_us;        /* 最长运行时间 */
+    uint32_t last_run_us;       /* 最近一次运行时间 */
+    uint32_t sum_run_us;        /* 运行时间累计（回绕），两次读取之差为期间的运行时间 */
+} pdm_task_stats_t;
+
+#define PDM_SCHED_MAX_TASKS     16
+
+/* tasks 必须按 priority 从小到大排列，调度器按表顺序运行 */
+void PDM_Sched_Init(const pdm_task_t *tasks, uint8_t count, uint32_t now);
+void PDM_Sched_Run(void);
+
+/* 只运行一组的任务（PDM_CFG_RTOS 时每个 RTOS 任务调用自己的一组） */
+void PDM_Sched_RunGroup(uint8_t group);
+
+uint8_t PDM_Sched_TaskCount(void);
+const pdm_task_t *PDM_Sched_GetTask(uint8_t index);
+const pdm_task_stats_t *PDM_Sched_GetStats(uint8_t index);
+void PDM_Sched_ResetStats(void);
+
+/* 修改任务周期，从下一次运行开始生效 */
+void PDM_Sched_SetPeriod(uint8_t index, uint32_t period_ms);
+
+/* 微秒计时（SysTick 插值），用于测量任务运行时间 */
+uint32_t PDM_Sched_NowUs(void);
+
+/* 距最近一个周期任务到期的时间 (ms)，已到期时为 0 */
+uint32_t PDM_Sched_IdleMs(void);
+uint32_t PDM_Sched_IdleMsGroup(uint8_t group);
+
+/* 一轮调度之后调用：没有到期任务时休眠到下一个中断（PDM_CFG_IDLE_SLEEP）。
+ * allow_long 非 0 且打开 PDM_CFG_IDLE_TICKLESS 时一直睡到下一个任务到期，除非被其他中断提前唤醒；
+ * 有中断驱动的工作在进行（I2C 读取等）时传 0，完成后最多 1 ms 内处理 */
+void PDM_Sched_Idle(uint8_t allow_long);
+
+/* 累计休眠时间 (us)，与运行时间相比可得 CPU 负载 */
+uint32_t PDM_Sched_SleepUs(void);
+
+#endif /* PDM_SCHED_H */
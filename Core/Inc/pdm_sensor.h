@@ -0,0 +1,56 @@
+#ifndef PDM_SENSOR_H
+#define PDM_SENSOR_H
+
+#include <stdint.h>
+#include "pdm_calc.h"
+#include "driver_ina226.h"
+#include "ina226_async.h"
+
+/*
+ * 电流传感器抽象：通道表中每个通道可以是 INA226 或 INA228。
+ * 采样结果统一换算成 INA226 寄存器格式（同一电流 LSB、1.25 mV 总线 LSB、2.5 uV 分流 LSB），
+ * 下游的换算、统计、CAN/UART 编码不区分器件。
+ * INA228 另有片上 ENERGY/CHARGE 累计寄存器（芯片按每次转换积分，不受 MCU 采样间隔影响），
+ * 带累计值的采样直接用它们的差值更新能量和电量，不再由 MCU 积分。
+ * INA229 是同一芯片的 SPI 版本，本板没有 SPI 传感器接口，不支持。
+ */
+
+typedef enum {
+    PDM_SENSOR_INA226 = 0,
+    PDM_SENSOR_INA228 = 1,
+} pdm_sensor_type_t;
+
+/* INA228 ENERGY 的 1 LSB 折合能量累计器（功率 LSB x 1 us）的单位数。
+ * 电流 LSB 设为通道电流 LSB 的 1/16（20 位电流的高 16 位即 INA226 格式），
+ * ENERGY LSB = 16 x 3.2 x 电流 LSB / 16 = 3.2 x 电流 LSB (J) = 3.2e6 / 25 个功率 LSB x 1 us */
+#define PDM_SENSOR_ENERGY_ACC_PER_LSB   128000u
+/* ENERGY / CHARGE 为 40 位 */
+#define PDM_SENSOR_ACC_MASK             0xFFFFFFFFFFULL
+
+typedef struct {
+    ina226_regs_t reg;          /* INA226 格式；INA228 的功率由电流和总线电压算出 */
+    uint8_t has_acc;            /* 1: 本次读了片上累计寄存器 */
+    uint64_t energy;            /* ENERGY 原始值（40 位，无符号） */
+    int64_t charge;             /* CHARGE 原始值（40 位，有符号），LSB = 电流 LSB / 16 (C) */
+} pdm_sensor_sample_t;
+
+/* 初始化一片 INA228：检查 ID、软件复位、写分流校准和 ADC 配置并清零累计寄存器。
+ * avg、bus_ct、shunt_ct 使用 INA226 的枚举，转换时间取 INA228 中最接近的一档；
+ * cnvr_alert 非 0 时转换完成拉低 ALERT。返回 0 成功 */
+uint8_t PDM_Sensor_Ina228Init(uint8_t addr, const pdm_scale_t *sc, ina226_avg_t avg,
+                              ina226_conversion_time_t bus_ct, ina226_conversion_time_t shunt_ct,
+                              uint8_t cnvr_alert);
+
+/* 厂商 ID 寄存器地址（离线探测用），两种器件的 ID 值相同 */
+uint8_t PDM_Sensor_IdReg(pdm_sensor_type_t type);
+
+/* 发起一次采样读取；with_acc 非 0 时 INA228 同时读 ENERGY/CHARGE（INA226 忽略）。
+ * done 在读完后的 I2C 中断中调用，可以为 NULL。返回 0 已入队，1 队列已满 */
+uint8_t PDM_Sensor_ReadAsync(pdm_sensor_type_t type, uint8_t addr, ina226_read_job_t *job,
+                             uint8_t with_acc, ina226_interface_iic_done_t done, void *ctx);
+
+/* 解析读完的采样；返回值与 ina226_interface_channel_decode() 相同：0 成功，1 读失败，4 数学溢出 */
+uint8_t PDM_Sensor_Decode(pdm_sensor_type_t type, const ina226_read_job_t *job,
+                          pdm_sensor_sample_t *out);
+
+#endif /* PDM_SENSOR_H */
@@ -0,0 +1,41 @@
+#ifndef PDM_SHELL_H
+#define PDM_SHELL_H
+
+#include <stdint.h>
+#include "pdm_config.h"
+
+/*
+ * UART 命令行（USART1，与日志同一个串口）。
+ * RX 由 DMA 循环写入接收缓冲区，空闲线、半满、满中断只记一个标志；
+ * 解析由主循环中的低优先级周期任务完成，不影响采样。
+ * 一行一条命令，以 CR 或 LF 结束，参数用空格分开，数字可写十进制或 0x 十六进制：
+ *   help                    命令列表
+ *   stats                   各通道最近 1 s 统计
+ *   sample <ms>             修改采样周期
+ *   can <id> <ms> [0|1]     修改报文周期，第三个参数为 1 时采样后立即发送
+ *   capture                 触发一次高速采集
+ *   lap [1]                 结束每圈统计窗口并输出，参数为 1 时同时结束当前节
+ *   laps                    输出最近的各段能量
+ *   reset <mask>            能量清零（bit0 BUS, bit1 BAT）
+ *   prof [reset]            输出（或清零）运行时间测量
+ *   filter [<ch> <alpha> <median>]  输出滤波设置和滤波前后的值，或修改一个通道的设置
+ *   hist [reset <mask>]     输出各通道电流分布计数，或清零
+ *   bus                     CAN 总线错误统计
+ *   canlat [reset]          输出（或清零）本节点各帧的发送延迟和其他节点总线负载估计
+ *   time                    与 VCU 的时间同步状态
+ *   param [<id> <value>|save|defaults|load]  输出运行参数，或修改一个参数、保存到 flash、恢复默认值、重新读入 flash 中的参数
+ *   cal [<ch> zero|<mA>]    输出标定状态，或开始一个通道的零点 / 参考电流标定
+ * 执行结果回复 "OK"、"ERR arg" 或 "ERR unknown"，和 CAN 命令通道的结果码一致。
+ */
+
+#if PDM_CFG_SHELL
+
+/* 启动 DMA 接收，在 USART1 初始化（包括采样流改波特率）之后调用 */
+void PDM_Shell_Init(void);
+
+/* 处理已收到的字符，执行完整的命令行，由主循环周期调用 */
+void PDM_Shell_Poll(void);
+
+#endif /* PDM_CFG_SHELL */
+
+#endif /* PDM_SHELL_H */
@@ -0,0 +1,81 @@
+#ifndef PDM_SIGNALS_H
+#define PDM_SIGNALS_H
+
+#include <stdint.h>
+#include "pdm_calc.h"
+
+/*
+ * 通道帧（0x300/0x301）的信号定义。编码函数、分辨率常量、失效值和信号描述表都由下面这一张表展开，
+ * 修改分辨率或增加字段只改这里，编码、变化判断、命令行 signals 输出的 DBC 和 README 中的帧格式表不会互相对不上。
+ * X(名称, 描述表中的名称, pdm_channel_t 中的来源字段, 来源类型, 起始字节, 每 LSB 的来源单位数,
+ *   每物理单位的来源单位数, 物理单位, 失效值)
+ * 每个信号 16 位大端；来源类型为 int32_t 的字段按 int16 饱和，uint32_t 的按 uint16 饱和（由类型在编译时选择，没有运行时分支）。
+ * 失效值在通道离线时填入；int16 字段在线时饱和到 0x7FFF 与失效值相同，接收方同样按失效处理（与原来一致）。
+ */
+#define PDM_CHANNEL_SIGNALS(X) \
+    X(VOLTAGE, "voltage", voltage_mV,   int32_t,  0, 1,      1,    "mV",  0x7FFF) \
+    X(CURRENT, "current", current_uA,   int32_t,  2, 10000,  1000, "mA",  0x7FFF) \
+    X(POWER,   "power",   power_uW,     uint32_t, 4, 100000, 1000, "mW",  0xFFFF) \
+    X(ENERGY,  "energy",  energy_uWh,   uint32_t, 6, 10000,  1000, "mWh", 0xFFFF)
+
+/* 来源类型决定饱和方式和 DBC 中的符号 */
+#define PDM_SIG_SAT_int32_t(v)      ((uint16_t)pdm_calc_sat_i16(v))
+#define PDM_SIG_SAT_uint32_t(v)     pdm_calc_sat_u16(v)
+#define PDM_SIG_SIGNED_int32_t      1
+#define PDM_SIG_SIGNED_uint32_t     0
+
+enum {
+#define PDM_SIG_CONST(n, str, src, type, pos, lsb, div, unit, inv) \
+    PDM_SIG_##n##_POS = (pos), PDM_SIG_##n##_PER_LSB = (lsb), PDM_SIG_##n##_INVALID = (inv),
+    PDM_CHANNEL_SIGNALS(PDM_SIG_CONST)
+#undef PDM_SIG_CONST
+};
+
+enum {
+#define PDM_SIG_INDEX(n, str, src, type, pos, lsb, div, unit, inv) PDM_SIG_##n,
+    PDM_CHANNEL_SIGNALS(PDM_SIG_INDEX)
+#undef PDM_SIG_INDEX
+    PDM_SIG_COUNT
+};
+
+/* 其他帧（扩展遥测、能量、导出量、计圈）沿用通道帧的分辨率 */
+#define PDM_CAN_VOLTAGE_MV_PER_LSB  PDM_SIG_VOLTAGE_PER_LSB
+#define PDM_CAN_CURRENT_UA_PER_LSB  PDM_SIG_CURRENT_PER_LSB
+#define PDM_CAN_POWER_UW_PER_LSB    PDM_SIG_POWER_PER_LSB
+#define PDM_CAN_ENERGY_UWH_PER_LSB  PDM_SIG_ENERGY_PER_LSB
+
+/* 编码函数 pdm_sig_encode_VOLTAGE() 等：来源值 -> 字段值，整数除法后饱和 */
+#define PDM_SIG_ENCODER(n, str, src, type, pos, lsb, div, unit, inv) \
+    static inline uint16_t pdm_sig_encode_##n(type v) \
+    { \
+        return PDM_SIG_SAT_##type(v / (type)(lsb)); \
+    }
+PDM_CHANNEL_SIGNALS(PDM_SIG_ENCODER)
+#undef PDM_SIG_ENCODER
+
+#define PDM_SIG_CHECK(n, str, src, type, pos, lsb, div, unit, inv) \
+    _Static_assert((pos) % 2 == 0 && (pos) <= 6, "signal " str " must be a 16-bit field inside the frame"); \
+    _Static_assert((lsb) % (div) == 0, "signal " str " factor must be an integer in its physical unit");
+PDM_CHANNEL_SIGNALS(PDM_SIG_CHECK)
+#undef PDM_SIG_CHECK
+
+_Static_assert(PDM_ENERGY_WRAP_UWH == 65536ULL * PDM_SIG_ENERGY_PER_LSB,
+               "PDM_ENERGY_WRAP_UWH must match the energy field resolution");
+
+/* 信号描述表，命令行 signals 按此输出 DBC，上位机据此解码 */
+typedef struct {
+    const char *name;
+    const char *unit;
+    uint8_t pos;                /* 起始字节 */
+    uint8_t is_signed;
+    uint32_t per_lsb;           /* 来源单位 */
+    uint16_t factor;            /* 物理单位/LSB */
+    uint16_t invalid;
+} pdm_signal_desc_t;
+
+extern const pdm_signal_desc_t g_pdm_channel_signals[PDM_SIG_COUNT];
+
+/* 输出一个通道帧的 DBC 定义（BO_、SG_ 和失效值的 VAL_） */
+void PDM_Signal_PrintDbc(uint32_t can_id, const char *msg_name);
+
+#endif /* PDM_SIGNALS_H */
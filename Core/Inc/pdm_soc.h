@@ -0,0 +1,51 @@
+#ifndef PDM_SOC_H
+#define PDM_SOC_H
+
+#include <stdint.h>
+#include "pdm_config.h"
+
+/*
+ * 电池剩余电量估算（7 串磷酸铁锂，电池侧通道）。
+ * 每个采样按电流和采样间隔做整数库仑计数（放电为正），与采样同频率积分。
+ * 电流长时间接近 0 时，用单体开路电压查表修正；磷酸铁锂 20%~95% 之间电压几乎不变，
+ * 只在查表曲线足够陡的区间修正，平坦区间完全依靠计数。
+ */
+
+#define PDM_SOC_CAN_ID          0x305
+
+/* 状态位（CAN 帧 data[6]） */
+#define PDM_SOC_FLAG_FROM_OCV   0x01    /* 启动时按开路电压初始化（没有保存的计数） */
+#define PDM_SOC_FLAG_CORRECTED  0x02    /* 本次上电后做过开路电压修正 */
+#define PDM_SOC_FLAG_REST       0x04    /* 当前处于静置状态 */
+
+/* 得到第一个电池侧采样后调用一次：
+ * restored 非 0 时从保存的剩余电量 charge_mAs 开始，否则按电池电压 bat_mV 查表 */
+void PDM_Soc_Init(uint8_t restored, int32_t charge_mAs, int32_t bat_mV);
+
+/* 每个电池侧采样调用：current_uA 放电为正，dt_us 为本次积分时间 */
+void PDM_Soc_Add(int32_t current_uA, uint32_t dt_us, int32_t bat_mV);
+
+/* 启动时从 flash 读到保存的剩余电量后调用，第一个电池侧采样时从这个值开始 */
+void PDM_Soc_Restore(int32_t charge_mAs);
+
+/* 每个电池侧采样调用：第一个采样时初始化（有 PDM_Soc_Restore() 的值时从该值开始，否则查表），
+ * 之后按 PDM_Soc_Add() 计数；dt_us 为 0（INA228 还没有新的累计差值）时不计数 */
+void PDM_Soc_Sample(int32_t current_uA, uint32_t dt_us, int32_t bat_mV);
+
+/* 断电保存用的剩余电量 (mAs)：初始化之后为当前值，之前为恢复的值；返回 0 没有可保存的值 */
+uint8_t PDM_Soc_Saved(int32_t *charge_mAs);
+
+/* 1: 已经初始化（得到第一个电池侧采样之后） */
+uint8_t PDM_Soc_Ready(void);
+
+/* 剩余电量 (mAs)，断电保存用 */
+int32_t PDM_Soc_ChargeMAs(void);
+
+/* 剩余电量 (0.1%) */
+uint16_t PDM_Soc_Permille(void);
+
+/* CAN 帧：[SoC 0.1%(2), 剩余 mAh(2), 剩余时间 min(2), 状态, 单体电压 (mV - 2000) / 10] 大端。
+ * 剩余时间按约 1 分钟平均的放电电流计算，没有放电时为 0xFFFF；初始化之前前三个字段都是 0xFFFF */
+void PDM_Soc_Encode(uint8_t *data, const void *arg);
+
+#endif /* PDM_SOC_H */
@@ -0,0 +1,53 @@
+#ifndef PDM_STACK_H
+#define PDM_STACK_H
+
+#include <stdint.h>
+#include "pdm_config.h"
+
+/*
+ * 栈使用量：启动时把栈区未使用的部分填充为固定值，之后从栈区底部向上找第一个被改写的字，
+ * 得到上电以来的最大深度（包括中断嵌套时的瞬间峰值，定时检查看不到的深度也能记录）。
+ * 栈区按 CubeIDE 链接脚本的符号计算：堆预留区之后（_end + _Min_Heap_Size）到 _estack，
+ * 即 .data/.bss 和堆预留之外的全部 SRAM；_Min_Stack_Size 只是链接时的最小保证。
+ * 栈区最底部的 PDM_STACK_GUARD 字节被改写说明栈已经进入堆预留区（溢出）。
+ * 扫描从栈区底部向上，到第一个被改写的字为止，只读 RAM，耗时与剩余空间成正比（16 KB 约 60 us）。
+ * 编译时各函数的栈帧和最坏调用链用 make stack-report 查看（Tools/stack_report.py）。
+ * PDM_STACK_CAN_ID 帧（1 s）：[峰值 (2), 栈区大小 (2), 静态 RAM .data + .bss (2), 状态, 0]，单位字节，大端；
+ * 状态 bit0 剩余不足 PDM_CFG_STACK_WARN，bit1 溢出，bit2 启动时没有填充（栈区为空）。
+ */
+
+#if PDM_CFG_STACK
+
+#define PDM_STACK_CAN_ID        0x30D
+#define PDM_STACK_GUARD         32      /* 溢出检测字节数 */
+#define PDM_STACK_FILL          0xA5A5A5A5u
+
+#define PDM_STACK_LOW           0x01    /* 剩余不足 */
+#define PDM_STACK_OVERFLOW      0x02
+#define PDM_STACK_UNPAINTED     0x04
+
+typedef struct {
+    uint32_t size;              /* 栈区字节数 */
+    uint32_t peak;              /* 上电以来的最大使用量 */
+    uint32_t static_ram;        /* .data + .bss，含 .RamFunc 和 SRAM 向量表 */
+    uint8_t status;             /* PDM_STACK_* */
+} pdm_stack_t;
+
+/* 填充栈区，在 main() 最前面（中断打开之前）调用 */
+void PDM_Stack_Paint(void);
+
+/* 扫描并返回使用量 */
+void PDM_Stack_Get(pdm_stack_t *out);
+
+/* CAN 报文表的编码函数 */
+void PDM_Stack_Encode(uint8_t *data, const void *arg);
+
+/* 主循环调用：剩余低于警告值或溢出时打印一次 */
+void PDM_Stack_Run(void);
+
+/* 命令行 stack */
+void PDM_Stack_Print(void);
+
+#endif /* PDM_CFG_STACK */
+
+#endif /* PDM_STACK_H */
@@ -0,0 +1,40 @@
+#ifndef PDM_STARTUP_H
+#define PDM_STARTUP_H
+
+#include <stdint.h>
+#include "pdm_config.h"
+
+/*
+ * 启动时间：HAL_Init() 起到第一帧（启动帧）放入发送队列、PDM_Monitor_Init() 完成、第一个通道得到第一个转换结果、
+ * 第一个通道帧放入发送队列的时间。第一个通道帧之后（器件都离线时为上电后 PDM_STARTUP_GIVEUP_MS）在 PDM_STARTUP_CAN_ID 发送一次：
+ *   [上电采集第一个样本, 第一帧, 第一个转换结果, 第一个通道帧]，各 2 字节 0.1 ms，大端，FFFF 为没有，
+ * 同时通过 UART 输出一行。
+ */
+
+#if PDM_CFG_STARTUP
+
+#define PDM_STARTUP_CAN_ID      0x317
+#define PDM_STARTUP_GIVEUP_MS   5000
+
+/* 时间点 */
+#define PDM_STARTUP_FRAME       0       /* 第一帧（启动帧）放入发送队列 */
+#define PDM_STARTUP_INIT        1       /* PDM_Monitor_Init() 完成 */
+#define PDM_STARTUP_SAMPLE      2       /* 第一个通道得到第一个转换结果 */
+#define PDM_STARTUP_DATA        3       /* 第一个通道帧放入发送队列 */
+#define PDM_STARTUP_POINTS      4
+
+/* 在 PDM_Timer_Init() 之后调用：定时器时间基准时记下 HAL_Init() 对应的 PDM_Sched_NowUs() */
+void PDM_Startup_Init(void);
+
+/* 记下时间点 point（PDM_STARTUP_*），只记第一次 */
+void PDM_Startup_Mark(uint8_t point);
+
+/* CAN 任务中调用：得到第一个通道帧或超时后发送启动时间帧 */
+void PDM_Startup_Poll(uint32_t now);
+
+/* 通过 UART 输出启动时间（ms），打开上电采集时另外输出上电采集的统计 */
+void PDM_Startup_Print(void);
+
+#endif /* PDM_CFG_STARTUP */
+
+#endif /* PDM_STARTUP_H */
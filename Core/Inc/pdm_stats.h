@@ -0,0 +1,58 @@
+#ifndef PDM_STATS_H
+#define PDM_STATS_H
+
+#include <stdint.h>
+#include "pdm_config.h"
+#include "pdm_calc.h"
+
+/*
+ * 每通道的滑动统计（按窗口分段）。
+ * 每个采样调用一次 PDM_Stats_Add()，只做整数累加，不保存样本，每个窗口占用固定内存。
+ * 窗口到时间（或手动结束）时把累加结果整体保留下来供读取，然后从零重新开始。
+ * 累加使用寄存器原始值：电流、功率的和与平方和都是精确整数，
+ * 不需要 Welford 算法回避的浮点相减误差，读取时才换算为物理量。
+ */
+
+/* 窗口 */
+#define PDM_STATS_WIN_FAST      0       /* PDM_CFG_STATS_FAST_MS */
+#define PDM_STATS_WIN_SLOW      1       /* PDM_CFG_STATS_SLOW_MS */
+#define PDM_STATS_WIN_LAP       2       /* 手动结束（每圈一次，CAN 命令） */
+#define PDM_STATS_WIN_TELEM     3       /* 手动结束（扩展遥测帧发送时） */
+#define PDM_STATS_WIN_TREND     4       /* 手动结束（趋势记录，PDM_CFG_TREND） */
+#if PDM_CFG_TREND
+#define PDM_STATS_WINDOWS       5
+#else
+#define PDM_STATS_WINDOWS       4
+#endif
+
+typedef struct {
+    uint32_t n;                 /* 有效采样数 */
+    uint32_t duration_ms;       /* 窗口实际长度 */
+    int32_t i_min_uA;
+    int32_t i_max_uA;
+    int32_t i_mean_uA;
+    int32_t i_std_uA;           /* 标准差 */
+    int32_t i_rms_uA;
+    int32_t v_min_mV;
+    int32_t v_max_mV;
+    int32_t v_mean_mV;
+    uint32_t p_mean_uW;
+    uint32_t p_peak_uW;
+} pdm_stats_result_t;
+
+/* 设置通道的换算常量，清零所有窗口 */
+void PDM_Stats_Init(uint8_t ch, const pdm_scale_t *scale, uint32_t now);
+
+/* 加入一个采样（寄存器原始值），加到该通道所有窗口 */
+void PDM_Stats_Add(uint8_t ch, int16_t current, uint16_t bus, uint16_t power);
+
+/* 结束已到时间的定时窗口（没有采样时也按时结束），由主循环调用 */
+void PDM_Stats_Tick(uint32_t now);
+
+/* 立即结束一个窗口（手动窗口用），结果可用 PDM_Stats_Get() 读取 */
+void PDM_Stats_Close(uint8_t ch, uint8_t win, uint32_t now);
+
+/* 读取上一个已结束窗口的结果；返回 0 成功，1 参数错误或窗口内没有采样 */
+uint8_t PDM_Stats_Get(uint8_t ch, uint8_t win, pdm_stats_result_t *res);
+
+#endif /* PDM_STATS_H */
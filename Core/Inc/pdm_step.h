@@ -0,0 +1,62 @@
+#ifndef PDM_STEP_H
+#define PDM_STEP_H
+
+#include <stdint.h>
+#include "pdm_config.h"
+#include "pdm_calc.h"
+
+/*
+ * 负载阶跃检测（水泵、风扇、刹车灯等的接通和断开），每个通道在采样事件中用整数运算判断，
+ * 只在有阶跃时发一帧 CAN 事件，不需要为了抓这些事件输出全速率的采样流。
+ * 电流寄存器值（零点修正后）x 16 先做一阶低通（1/2^PDM_CFG_STEP_FILTER），另有一个慢速的基线（1/16）：
+ *   等待：低通值与基线之差达到门限（运行参数 step_ma，0 不检测）时，以基线为阶跃前的值、本采样的时间为开始，
+ *         进入变化中；否则基线跟随低通值
+ *   变化中：相邻两个低通值之差连续 PDM_CFG_STEP_SETTLE 个采样不超过门限的 1/4（或已经过 PDM_CFG_STEP_MAX_N 个采样）
+ *           时认为稳定，低通值为阶跃后的值；前后之差仍达到门限才算一次阶跃（单个尖峰回到原值时不报），
+ *           基线直接取阶跃后的值，回到等待
+ * 总线电压用同样的低通和基线，阶跃前后的电压与电流一起记录（电池内阻估计使用）。
+ * 开始时间为越过门限的那个采样开始读取的时间，检测延迟约为 PDM_CFG_STEP_SETTLE 个采样，不影响时间戳。
+ * 只在采集中调用 PDM_Step_Add()（采样事件），其余函数在主循环中调用。
+ * CAN 帧 PDM_STEP_CAN_ID（每次阶跃一帧，大端）：
+ *   [通道 << 4 | 序号 (低 4 位), 开始时间 ms (3, HAL_GetTick() 低 24 位), 阶跃前 (2), 阶跃后 (2)]
+ *   电流 10 mA/LSB 有符号，阶跃大小 = 阶跃后 - 阶跃前；序号每个通道分别计数，接收方据此发现丢帧。
+ * 最近 PDM_CFG_STEP_RING 次阶跃保存在 RAM 中，命令行 steps 输出。
+ */
+
+#if PDM_CFG_STEP
+
+#define PDM_STEP_CAN_ID         0x312
+
+typedef struct {
+    uint8_t ch;
+    uint8_t seq;                /* 该通道的阶跃序号 */
+    uint32_t tick_ms;           /* 开始时间（HAL_GetTick()） */
+    uint32_t t_us;              /* 开始时间（PDM_Sched_NowUs()） */
+    uint32_t rise_us;           /* 开始到最后一个变化较大的采样 */
+    int32_t pre_ua;             /* 阶跃前后的电流 (uA) 和总线电压 (uV) */
+    int32_t post_ua;
+    int32_t pre_uv;
+    int32_t post_uv;
+} pdm_step_event_t;
+
+/* 设置通道并清除状态，sc 为该通道的换算常量；门限取运行参数，参数或校准值改变后再次调用 */
+void PDM_Step_Init(uint8_t ch, const pdm_scale_t *sc);
+
+/* 清除状态，下一个采样重新开始（器件重新初始化后调用） */
+void PDM_Step_Reset(uint8_t ch);
+
+/* 加入一个采样：电流寄存器值（零点修正后）、总线电压寄存器值、开始读取的时间 */
+void PDM_Step_Add(uint8_t ch, int16_t current, uint16_t bus, uint32_t ts_us);
+
+/* 上电以来所有通道的阶跃总数，使用者据此查看有没有新的阶跃 */
+uint32_t PDM_Step_Count(void);
+
+/* 最近第 k 次阶跃（0 为最近一次）；返回 0 成功，1 没有 */
+uint8_t PDM_Step_Get(uint8_t k, pdm_step_event_t *out);
+
+/* 命令行 steps：每通道的门限和次数，最近几次阶跃 */
+void PDM_Step_Print(void);
+
+#endif /* PDM_CFG_STEP */
+
+#endif /* PDM_STEP_H */
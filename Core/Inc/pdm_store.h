@@ -0,0 +1,55 @@
+#ifndef PDM_STORE_H
+#define PDM_STORE_H
+
+#include <stdint.h>
+#include "pdm_config.h"
+
+/*
+ * 内部 flash 记录存储。
+ * 使用 flash 最后 PDM_CFG_STORE_PAGES 页（每页 1 KB），记录按顺序追加，
+ * 写满一页后进入下一页，各页轮流擦除（磨损均衡）。每条记录 PDM_CFG_STORE_REC_SIZE 字节：
+ *   [数据][序号 4][CRC16 2][标志 2]
+ * 标志最后写入，写到一半掉电的记录没有标志，启动时跳过。
+ * 启动时只读各槽的标志和序号，找出序号最大的有效记录。
+ *
+ * 写入分步进行：PDM_Store_Append() 只复制数据，PDM_Store_Run() 每次编程几个半字；
+ * 页擦除（20~40 ms，期间 CPU 停止取指）只在调用者允许时进行，并提前擦好下一页。
+ */
+
+#define PDM_STORE_PAGE_SIZE     1024u
+#define PDM_STORE_REC_SIZE      ((uint32_t)PDM_CFG_STORE_REC_SIZE)
+#define PDM_STORE_PAYLOAD       (PDM_STORE_REC_SIZE - 12u)
+
+#if PDM_CFG_STORE_REC_SIZE != 64 && PDM_CFG_STORE_REC_SIZE != 128 && PDM_CFG_STORE_REC_SIZE != 256
+#error "PDM_CFG_STORE_REC_SIZE must be 64, 128 or 256"
+#endif
+#if PDM_CFG_STORE_PAGES < 2
+#error "PDM_CFG_STORE_PAGES must be at least 2"
+#endif
+
+/* 扫描存储区；返回 0 成功，1 存储区与程序重叠，不可用 */
+uint8_t PDM_Store_Init(void);
+
+/* 读出最新一条记录的数据；返回 0 成功，1 没有有效记录 */
+uint8_t PDM_Store_Load(void *buf, uint16_t len);
+
+/* 请求写入一条记录（上一条还没写完时用新数据替换）；返回 0 成功，1 不可用或过长 */
+uint8_t PDM_Store_Append(const void *buf, uint16_t len);
+
+/* 推进写入；erase_ok 非 0 时允许在本次调用中擦除一页 */
+void PDM_Store_Run(uint8_t erase_ok);
+
+/* 立即写入一条记录（掉电前在 PVD 中断中调用），直接操作 flash 寄存器，约 2 ms。
+ * 正在分步写入的记录放弃；返回 0 成功，1 不可用或没有擦好的槽 */
+uint8_t PDM_Store_WriteNow(const void *buf, uint16_t len);
+
+/* 1: 有写入或擦除尚未完成 */
+uint8_t PDM_Store_Busy(void);
+
+/* 最新记录的序号，没有记录时为 0 */
+uint32_t PDM_Store_Seq(void);
+
+/* 存储区起始地址（可直接读），size 返回字节数 */
+const uint8_t *PDM_Store_Area(uint32_t *size);
+
+#endif /* PDM_STORE_H */
@@ -0,0 +1,55 @@
+#ifndef PDM_STREAM_H
+#define PDM_STREAM_H
+
+#include <stdint.h>
+#include "pdm_config.h"
+
+/*
+ * UART 二进制采样流，用于台架长时间记录全速率数据。
+ * 每次读取输出一帧原始寄存器值，不做格式化；帧经 UART 日志环形缓冲区由 DMA 发送。
+ * 帧格式：0x00 + COBS(数据 + CRC16) + 0x00。开头的 0x00 用于和之前的文本日志分开，
+ * 上位机按 0x00 切分，CRC 正确的是数据帧，其余按文本显示（解码见 Tools/pdm_stream.py）。
+ * 数据为小端序：
+ *   采样帧：[类型 0x01][通道][序号][时间戳 us (4)][总线 (2)][分流 (2, 有符号)][电流 (2, 有符号)][功率 (2)]
+ *   信息帧：[类型 0x02][通道数][每通道电流 LSB uA (4)]...，启动时和之后每秒一次，换算物理量用
+ *   时间帧 (PDM_CFG_TIMESYNC)：[类型 0x04][状态][本地时间 us (4)][车辆时间 us (8)]，随信息帧发送，
+ *           上位机按最近的一帧把采样时间戳换算成车辆时间（状态见 pdm_timesync.h，0 表示未同步）
+ *   压缩帧 (PDM_CFG_UART_STREAM_PACK)：[类型 0x03][通道][序号][时间戳块][总线块][分流块][电流块][功率块]，
+ *           每通道攒满 16 个采样输出一帧，块格式见 pdm_pack.h，代替采样帧
+ *   电流帧 (PDM_CFG_CAPTURE_FAST)：[类型 0x05][通道][序号][第一个样本的时间戳 us (4)][累计丢弃样本数 (4)][样本数 n]
+ *           [分流 (2, 有符号) + 与上一样本的间隔 us (2)] x n，只测电流的高速采样流，见 pdm_capture.h
+ * 序号每个采样帧（或压缩帧）加一（所有通道共用），缓冲区满时整帧丢弃，上位机按序号统计丢帧。
+ * 只允许在主循环中调用（与 PDM_Log_Write() 相同）。
+ */
+
+#if PDM_CFG_UART_STREAM
+
+#define PDM_STREAM_TYPE_SAMPLE  0x01u
+#define PDM_STREAM_TYPE_INFO    0x02u
+#define PDM_STREAM_TYPE_PACKED  0x03u
+#define PDM_STREAM_TYPE_TIME    0x04u
+#define PDM_STREAM_TYPE_FAST    0x05u
+
+/* 把 USART1 切换到 PDM_CFG_UART_STREAM_BAUD，应在输出任何日志之前调用 */
+void PDM_Stream_Init(void);
+
+/* 输出一个采样帧（寄存器原始值），ts_us 为读取开始时的微秒时间戳 */
+void PDM_Stream_Sample(uint8_t ch, uint32_t ts_us, uint16_t bus, int16_t shunt,
+                       int16_t current, uint16_t power);
+
+/* 输出信息帧：ch_count 个通道的电流 LSB (uA) */
+void PDM_Stream_Info(uint8_t ch_count, const uint32_t *current_ua_per_lsb);
+
+/* 输出时间帧：本地时间 local_us 对应车辆时间 vehicle_us */
+void PDM_Stream_Time(uint8_t state, uint32_t local_us, uint64_t vehicle_us);
+
+#if PDM_CFG_CAPTURE_FAST
+/* 输出电流帧：n 个样本（分流原始值和间隔），t0_us 为第一个样本的时间戳，dropped 为累计丢弃的样本数；
+ * 返回 0 成功，1 缓冲区满整帧丢弃 */
+uint8_t PDM_Stream_Fast(uint8_t ch, uint32_t t0_us, uint32_t dropped,
+                        const int16_t *shunt, const uint16_t *dt_us, uint8_t n);
+#endif
+
+#endif /* PDM_CFG_UART_STREAM */
+
+#endif /* PDM_STREAM_H */
@@ -0,0 +1,39 @@
+#ifndef PDM_TELEM_H
+#define PDM_TELEM_H
+
+#include <stdint.h>
+#include "pdm_config.h"
+
+/*
+ * CAN 报文表：每通道一帧通道帧（ID 为运行参数，默认见通道表），然后是器件状态帧、扩展遥测帧、
+ * 充放电能量帧、32 位能量帧，以及各模块自己编码的报文（SoC、派生量、可信度、CAN 健康、E2E、车辆时间、
+ * MCU、栈、回放、抽取、CPU 负载），启动时按编译配置和运行参数填写，交给 pdm_can 按周期或按变化发送。
+ * 通道帧的信号见 pdm_signals.h，各帧格式见 README。
+ */
+
+#define PDM_TELEM_HEALTH_ID     0x303   /* 器件状态与错误计数 */
+#define PDM_TELEM_EXT_ID        0x304   /* 扩展遥测，多路复用 */
+#define PDM_TELEM_ENERGY_ID     0x306   /* 充放电能量，各通道轮流 */
+#define PDM_TELEM_ENERGY32_ID   0x314   /* 32 位能量和净电荷，各通道轮流 */
+
+/* 填写报文表并初始化 pdm_can；在运行参数读入、各模块初始化之后调用 */
+void PDM_Telem_Init(uint32_t now);
+
+/* id 是否已被通道帧（及其 E2E 帧）以外的报文使用：1 是；报文表还没有填写时总是 0 */
+uint8_t PDM_Telem_IdUsed(uint32_t id);
+
+/* 通道帧改用新的 ID（E2E 帧随之改变），立即生效 */
+void PDM_Telem_SetChannelId(uint8_t ch, uint16_t id);
+
+/* 与通道帧同周期的报文（通道帧、可信度帧、E2E 帧、车辆时间帧）改用新的周期和发送方式 */
+void PDM_Telem_FollowChannel(uint16_t period_ms, uint8_t on_sample);
+
+/* 通道帧按变化发送的最短/最长间隔 */
+void PDM_Telem_SetChange(uint16_t min_ms, uint16_t max_ms);
+
+#if PDM_CFG_BENCH
+/* 按通道帧格式编码一个通道的发布数据（基准测试用，见 pdm_bench.h）；full 为 1 时不用上次的结果 */
+void PDM_Telem_EncodeChannel(uint8_t ch, uint8_t *data, uint8_t full);
+#endif
+
+#endif /* PDM_TELEM_H */
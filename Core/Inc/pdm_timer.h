@@ -0,0 +1,57 @@
+#ifndef PDM_TIMER_H
+#define PDM_TIMER_H
+
+#include <stdint.h>
+#include "pdm_config.h"
+
+/*
+ * 硬件采样时钟与微秒时间戳（直接操作寄存器，没有启用 HAL TIM 模块）。
+ * TIM2 按 1 MHz 计数，每次溢出通过 TRGO 让 TIM4 加一，两者组成 32 位微秒计数器，
+ * 读取时不需要中断，约 71.6 分钟回绕。
+ * TIM3 按采样周期产生更新中断，在中断中发起一组读取，周期不受主循环中 UART、CAN 等任务的影响。
+ * ALERT 边沿捕获（PDM_CFG_ALERT_CAPTURE）：PA1/PA3 同时是 TIM2_CH2/CH4，两路设为下降沿输入捕获，
+ * 边沿到来时硬件把 TIM2 计数值锁存到 CCR2/CCR4，EXTI 中断仍照常处理（保护、切断、采样通知），
+ * 在回调入口读出锁存值，配上高 16 位得到边沿的微秒时间戳，不含中断响应和前面中断占用的时间。
+ * 分辨率为计数器的 1 us，与其他时间戳同一时钟，可以直接相减；中断在边沿后 65 ms 内处理时有效。
+ */
+
+/* 微秒计数器在采样时钟或 ALERT 捕获任一开启时运行 */
+#define PDM_TIMER_US    (PDM_CFG_SAMPLE_TIMER || PDM_CFG_ALERT_CAPTURE)
+
+#if PDM_TIMER_US
+
+/* 启动 32 位微秒计数器（以及 ALERT 捕获），应在其他模块使用 PDM_Sched_NowUs() 之前调用 */
+void PDM_Timer_Init(void);
+
+/* 32 位微秒时间戳 */
+uint32_t PDM_Timer_NowUs(void);
+
+#endif /* PDM_TIMER_US */
+
+#if PDM_CFG_ALERT_CAPTURE
+
+/* ALERT n (0: PA1, 1: PA3) 的 EXTI 回调入口调用：取出捕获的边沿时间；没有捕获到时用当前时间 */
+void PDM_Timer_OnAlert(uint8_t n);
+
+/* ALERT n 最近一个边沿的微秒时间戳（PDM_Timer_OnAlert() 取出的值） */
+uint32_t PDM_Timer_AlertUs(uint8_t n);
+
+/* 回调时没有捕获标志的次数（边沿太窄被滤掉，或捕获未运行） */
+uint32_t PDM_Timer_AlertMiss(void);
+
+#endif /* PDM_CFG_ALERT_CAPTURE */
+
+#if PDM_CFG_SAMPLE_TIMER
+
+/* 启动采样时钟：每 period_ms 在 TIM3 中断中调用一次 on_sample(当前微秒时间戳) */
+void PDM_Timer_StartSample(uint32_t period_ms, void (*on_sample)(uint32_t now_us));
+
+/* 修改采样周期 (1~6553 ms)，从下一个周期开始生效 */
+void PDM_Timer_SetPeriod(uint32_t period_ms);
+
+/* TIM3_IRQHandler 中调用 */
+void PDM_Timer_IRQHandler(void);
+
+#endif /* PDM_CFG_SAMPLE_TIMER */
+
+#endif /* PDM_TIMER_H */
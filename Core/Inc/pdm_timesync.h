@@ -0,0 +1,63 @@
+#ifndef PDM_TIMESYNC_H
+#define PDM_TIMESYNC_H
+
+#include <stdint.h>
+#include "pdm_config.h"
+#include "pdm_can.h"
+
+/*
+ * 与 VCU 的时间同步：把本地微秒时间（PDM_Sched_NowUs()）换算成车辆时间，采样可以和逆变器、BMS 的记录对齐。
+ * VCU 在 PDM_CFG_TIMESYNC_ID 上按 AUTOSAR CanTSyn 的不带 CRC 格式发送 SYNC/FUP 对（大端）：
+ *   SYNC [0x10, 0, 时间域 << 4 | 序号, 0, 秒 (4)]
+ *   FUP  [0x18, 0, 时间域 << 4 | 序号, 秒溢出 (bit1:0), 纳秒 (4)]
+ * 秒 + 秒溢出 + 纳秒为 SYNC 发送完成时刻的车辆时间；本节点在 RX 中断中给 SYNC 打本地时间戳，
+ * 两者组成一对同步点。只接受时间域为 PDM_CFG_TIMESYNC_DOMAIN、序号相同且 FUP 在 PDM_CFG_TIMESYNC_FUP_MS 内到达的对。
+ * 每个同步点更新偏移；相邻同步点之间本地与车辆时间的差得到频差，一阶滤波（1/16）后用于两次同步之间的外推。
+ * 预测偏差超过 PDM_CFG_TIMESYNC_STEP_US（VCU 时间跳变或长时间没有同步）时直接跳到新时间，频差估计保留。
+ * 超过 PDM_CFG_TIMESYNC_TIMEOUT_MS 没有同步时状态为保持（按最后的偏移和频差继续外推），超过 1000 s 回到未同步。
+ *
+ * 车辆时间帧 PDM_TIMESYNC_CAN_ID：[类型 << 4 | 通道, 状态, 秒 (4), 秒内 1/65536 s (2)]，大端
+ *   类型 0：该通道最新一组采样（即同一周期发出的通道帧）开始读取的时刻，与通道帧同周期，各通道轮流
+ *   类型 1：高速采集发出的第一个样本的时刻，采集头帧之后发送一次
+ * 状态 0 未同步（时间为 0），1 已同步，2 保持。UART 采样流中另有时间帧（见 pdm_stream.h），上位机按它换算采样时间戳。
+ */
+
+#if PDM_CFG_TIMESYNC
+
+#define PDM_TIMESYNC_CAN_ID     0x30B
+
+#define PDM_TSYNC_NONE          0
+#define PDM_TSYNC_SYNCED        1
+#define PDM_TSYNC_HOLDOVER      2
+
+#define PDM_TSYNC_KIND_SAMPLE   0
+#define PDM_TSYNC_KIND_CAPTURE  1
+
+typedef struct {
+    uint8_t state;              /* PDM_TSYNC_* */
+    uint32_t syncs;             /* 接受的同步点数 */
+    uint32_t steps;             /* 跳变次数（包括第一次同步） */
+    uint32_t rejected;          /* 丢弃的 SYNC/FUP（缺 FUP、序号不符、FUP 超时） */
+    int32_t last_err_us;        /* 最近一次同步点与外推值之差 */
+    uint32_t max_err_us;        /* 不含跳变的最大偏差绝对值 */
+    int32_t drift_ppb;          /* 车辆时间相对本地时钟的频差 (1e-9)，正数为本地偏慢 */
+    uint32_t age_ms;            /* 距最近一次同步的时间 */
+} pdm_tsync_stats_t;
+
+/* 处理一帧 PDM_CFG_TIMESYNC_ID 报文（主循环中调用，f->t_us 为接收时间戳） */
+void PDM_TimeSync_Rx(const pdm_can_frame_t *f);
+
+/* 本地时间换算成车辆时间 (us)；返回状态，未同步时 *vehicle_us 为 0 */
+uint8_t PDM_TimeSync_ToVehicle(uint32_t local_us, uint64_t *vehicle_us);
+
+/* 按上面的格式编码一帧车辆时间帧 */
+void PDM_TimeSync_Encode(uint8_t kind, uint8_t ch, uint32_t local_us, uint8_t *data);
+
+void PDM_TimeSync_Get(pdm_tsync_stats_t *out);
+
+/* 命令行 time：状态、偏差、频差和当前车辆时间 */
+void PDM_TimeSync_Print(void);
+
+#endif /* PDM_CFG_TIMESYNC */
+
+#endif /* PDM_TIMESYNC_H */
@@ -0,0 +1,56 @@
+#ifndef PDM_TREND_H
+#define PDM_TREND_H
+
+#include <stdint.h>
+#include "pdm_config.h"
+
+/*
+ * 长时间趋势记录：每 PDM_CFG_TREND_S 秒每个通道一条记录，整场耐久赛都保存在 flash 中，
+ * 黑匣子（pdm_blackbox.h）只有最近几秒，这里给出整场的负载和能量分布。
+ * 每条记录每通道 4 个字段（int16）：
+ *   平均电流 (10 mA/LSB)、最大电流 (10 mA/LSB，有符号)、最低总线电压 (mV)、本段能量 (mWh，无符号，饱和)
+ * 本段没有有效采样（离线）时前三个字段为 0x7FFF；能量按累计器的差值计算，不丢失不足 1 mWh 的部分。
+ * 每 PDM_TREND_GROUP 条记录压缩为一组（每个通道每个字段一个 pdm_pack 块，差分 + 定宽位打包），
+ * 写入存储区、参数区和事件记录区之前的 PDM_CFG_TREND_PAGES 页，写满后擦除最旧的一页。
+ * 组格式（小端）：
+ *   [标志 0x5447 (2)][组长度 (2，含头和 CRC，偶数)][组序号 (4)][最后一条记录时的累计运行时间 s (4)]
+ *   [上电次数 (2)][记录周期 s (2)][记录数][通道数][字段数][0xFF]
+ *   [通道 0 字段 0 块][通道 0 字段 1 块]...[通道 N 字段 3 块][补齐到偶数字节][CRC16 (2)]
+ *   CRC 从组长度算到 CRC 之前，标志最后写入，写到一半掉电的组没有标志。组不跨页。
+ * 没写满一组的记录在 RAM 中，掉电时丢失（最多 PDM_TREND_GROUP 个周期）；下载前先写入 flash。
+ * 写入分步进行（PDM_Trend_Run() 每次 8 个半字），擦页只在调用者允许时进行。
+ * ISO-TP 下载（来源 6）：整个记录区，从最旧的一页开始按时间顺序排列，每页 1 KB，页中组后面为 0xFF。
+ * 解码见 Tools/pdm_trend.py。
+ */
+
+#if PDM_CFG_TREND
+
+#define PDM_TREND_GROUP         16u     /* 每组的记录数（pdm_pack 一块） */
+#define PDM_TREND_FIELDS        4u
+#define PDM_TREND_INVALID       0x7FFF
+
+/* 扫描记录区；返回 0 成功，1 记录区与程序重叠，不可用 */
+uint8_t PDM_Trend_Init(void);
+
+/* 加入一条记录：values 为 通道数 x PDM_TREND_FIELDS 个字段（通道 0 在前），
+ * uptime_s / boots 写入组头（主循环中调用） */
+void PDM_Trend_Add(const int16_t *values, uint32_t uptime_s, uint16_t boots);
+
+/* 推进写入；erase_ok 非 0 时允许在本次调用中擦除一页 */
+void PDM_Trend_Run(uint8_t erase_ok);
+
+/* 存储任务中调用：每 PDM_CFG_TREND_S 秒结束各通道的趋势统计窗口（pdm_stats.h），加入一条记录 */
+void PDM_Trend_Poll(uint32_t now);
+
+/* 下载前调用：把没写满的一组立即写入 flash（约 10 ms，需要擦页时不写），返回下载内容的字节数 */
+uint32_t PDM_Trend_Latch(void);
+
+/* 复制下载内容 [off, off + n) 到 buf；返回 0 成功，1 越界或下载期间擦除过一页 */
+uint8_t PDM_Trend_Read(uint32_t off, uint8_t *buf, uint8_t n);
+
+/* 命令行 trend：已用页数、组数、记录数和覆盖的时间 */
+void PDM_Trend_Print(void);
+
+#endif /* PDM_CFG_TREND */
+
+#endif /* PDM_TREND_H */
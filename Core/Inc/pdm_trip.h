@@ -0,0 +1,76 @@
+#ifndef PDM_TRIP_H
+#define PDM_TRIP_H
+
+#include <stdint.h>
+#include "pdm_config.h"
+#include "pdm_calc.h"
+#include "pdm_sensor.h"
+
+/*
+ * 过流/欠压切断。每个通道三项门限（运行参数，0 表示不检查）：
+ *   瞬时过流：|电流| 达到门限
+ *   I2t：累计 (I^2 - 额定^2) x dt，电流低于额定值时按同样的式子减少（不低于 0），累计值达到门限
+ *   欠压：总线电压低于门限（只适用于测量点在负载开关上游的通道）
+ * 读取完成的 I2C 中断中直接用寄存器值比较（门限在参数修改时换算成寄存器单位，中断中只有乘加和比较），
+ * 不等主循环处理；另外硬件门限保护（pdm_protect.h）的 ALERT 在 EXTI 中断中直接切断（PDM_CFG_TRIP_ON_ALERT）。
+ * 任一通道超限时把 PDM_CFG_TRIP_PIN 置为切断电平并保持（锁存），同时在 PDM_PROT_FAULT_ID 发故障帧
+ * （格式同 pdm_protect.h，类型 3 瞬时过流、4 I2t、5 欠压；ALERT 切断时的故障帧由 pdm_protect 发出）。
+ * 复位用 CAN 命令 0x0B 或命令行 trip reset；I2t 切断后累计值降到门限一半以下才能复位（冷却）。
+ *
+ * 响应时间：
+ *   采样：阈值被越过到输出动作 = 芯片平均窗口内的延迟 + 距下一次读取的等待（不超过采样周期）
+ *         + I2C 读取 (400 kHz 时约 0.3 ms) + 判断，后两项由本模块测量（读取开始到输出动作，react_us）；
+ *         要求 1 ms 以内时采样周期和平均窗口需相应缩短，或使用 ALERT 路径
+ *   ALERT：芯片每个转换结果都比较，EXTI 入口到输出动作为几 us
+ * PDM_CFG_ALERT_CAPTURE 时 react_us 从 ALERT 边沿的捕获时间算起：ALERT 切断为边沿到输出动作（含中断响应），
+ * ALERT 采样时样本的时间就是转换完成的边沿，采样切断为转换完成到输出动作
+ * 测量点 trip（判断开始到输出动作）和 trip_alert（ALERT 回调入口到输出动作）只在切断时记录，
+ * trip_eval 为每个采样判断的耗时，见 pdm_prof.h。
+ */
+
+#if PDM_CFG_TRIP
+
+typedef struct {
+    uint8_t cause;              /* 0 未切断，否则为故障类型 PDM_PROT_* */
+    uint16_t count;             /* 切断次数 */
+    uint32_t last_tick;         /* 最近一次切断的时间 */
+    uint32_t react_us;          /* 最近一次采样切断：读取开始到输出动作（ALERT 捕获见上） */
+    uint32_t react_max_us;
+    uint8_t i2t_pct;            /* I2t 累计值占门限的百分比 */
+} pdm_trip_stat_t;
+
+/* 初始化输出引脚，输出为开关使能电平 */
+void PDM_Trip_Init(void);
+
+/* 按运行参数换算一路的门限：启动时，以及运行参数或校准值改变后调用（主循环中） */
+void PDM_Trip_Config(uint8_t ch, const pdm_scale_t *sc);
+
+/* 一个采样的判断（I2C 中断中调用）：current/bus 为零点修正前的寄存器值，
+ * dt_us 为距上一采样的时间，ts_us 为本次读取开始的时间 */
+void PDM_Trip_Check(uint8_t ch, int16_t current, uint16_t bus, uint32_t dt_us, uint32_t ts_us);
+
+/* 一次通道读取完成（I2C 中断中调用）：按传感器类型解出 job 中的寄存器值后判断，同 PDM_Trip_Check()；
+ * 读取失败或溢出时不判断（由主循环的读取处理计入失败） */
+void PDM_Trip_OnRead(uint8_t ch, pdm_sensor_type_t type, const ina226_read_job_t *job,
+                     uint32_t dt_us, uint32_t ts_us);
+
+/* 硬件门限保护 ALERT（EXTI 中断中调用），type 为 PDM_PROT_* */
+void PDM_Trip_OnAlert(uint8_t ch, uint8_t type);
+
+/* 复位 mask 中的通道，全部复位后输出恢复；返回 0 成功，1 有通道仍在冷却（其余照常复位） */
+uint8_t PDM_Trip_Reset(uint8_t mask);
+
+/* 已切断的通道位 */
+uint8_t PDM_Trip_Active(void);
+
+/* 主循环调用：打印新的切断 */
+void PDM_Trip_Run(void);
+
+void PDM_Trip_GetStat(uint8_t ch, pdm_trip_stat_t *st);
+
+/* 命令行 trip：输出状态、各通道门限和统计 */
+void PDM_Trip_Print(void);
+
+#endif /* PDM_CFG_TRIP */
+
+#endif /* PDM_TRIP_H */
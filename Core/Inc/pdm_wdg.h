@@ -0,0 +1,39 @@
+#ifndef PDM_WDG_H
+#define PDM_WDG_H
+
+#include <stdint.h>
+#include "pdm_config.h"
+
+/*
+ * 独立看门狗 (IWDG) 与任务存活检查。
+ * 每个被监视的任务在完成一次有效工作后调用 PDM_Wdg_CheckIn()，
+ * PDM_Wdg_Run() 只有在所有任务都在各自期限内报到过时才喂狗，
+ * 任何一个任务卡住，IWDG 在 PDM_CFG_WDG_TIMEOUT_MS 后复位 MCU。
+ */
+
+/* 复位原因（RCC_CSR），启动帧中报告 */
+#define PDM_RESET_POR       0x01    /* 上电 / 掉电复位 */
+#define PDM_RESET_PIN       0x02    /* NRST 引脚（其他复位也会置位） */
+#define PDM_RESET_SOFT      0x04    /* 软件复位 */
+#define PDM_RESET_IWDG      0x08    /* 独立看门狗 */
+#define PDM_RESET_WWDG      0x10    /* 窗口看门狗 */
+#define PDM_RESET_LPWR      0x20    /* 低功耗复位 */
+
+#define PDM_WDG_MAX_SLOTS   8
+
+/* 读出并清除 RCC 复位标志，只在启动时调用一次，之后返回缓存的值 */
+uint8_t PDM_Wdg_ResetCause(void);
+
+/* 登记一个被监视的任务，返回槽号；deadline_ms 内必须报到一次 */
+uint8_t PDM_Wdg_Register(const char *name, uint32_t deadline_ms);
+
+/* 任务报到 */
+void PDM_Wdg_CheckIn(uint8_t slot);
+
+/* 启动 IWDG（启动后不能停止） */
+void PDM_Wdg_Start(void);
+
+/* 周期调用：所有任务都按时报到才喂狗 */
+void PDM_Wdg_Run(uint32_t now);
+
+#endif /* PDM_WDG_H */
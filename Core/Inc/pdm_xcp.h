@@ -0,0 +1,33 @@
+#ifndef PDM_XCP_H
+#define PDM_XCP_H
+
+#include <stdint.h>
+#include "pdm_config.h"
+
+/*
+ * XCP on CAN 测量从站（ASAM XCP 1.x，只做测量，不做标定写入）。
+ * 主站在 PDM_CFG_XCP_RX_ID 发送命令，回复和 DAQ 数据在 PDM_CFG_XCP_TX_ID 发出。
+ * 字节序 Intel，地址粒度 1 字节，MAX_CTO = MAX_DTO = 8，地址扩展只支持 0。
+ * 变量地址从编译产物（.map / .elf）中取得，只允许读取 SRAM 和 flash。
+ *
+ * DAQ 为静态配置：PDM_CFG_XCP_DAQ_LISTS 个列表，每个 PDM_CFG_XCP_ODTS 个 ODT，
+ * 每个 ODT 最多 7 个条目、合计 7 字节；主站用 SET_DAQ_PTR / WRITE_DAQ 填写条目。
+ * PID 为绝对 ODT 号（列表 n 的第一个 PID 为 n x PDM_CFG_XCP_ODTS）。
+ * 事件通道 0 "sample"：每组采样完成时由主循环调用 PDM_Xcp_Event()，
+ * 同一组采样的数据在同一次事件中复制发出；支持分频。
+ */
+
+#if PDM_CFG_XCP
+
+#define PDM_XCP_EVENT_SAMPLE    0
+#define PDM_XCP_EVENTS          1
+
+/* 处理一条收到的命令帧（由 CAN 接收处理调用） */
+void PDM_Xcp_Rx(const uint8_t *data, uint8_t dlc);
+
+/* 事件发生：发送该事件上已启动的 DAQ 列表，只在主循环中调用 */
+void PDM_Xcp_Event(uint8_t event);
+
+#endif /* PDM_CFG_XCP */
+
+#endif /* PDM_XCP_H */
@@ -29,13 +29,17 @@ extern "C" {
 #include "main.h"
 
 /* USER CODE BEGIN Includes */
+#include "pdm_config.h"
 
 /* USER CODE END Includes */
 
 extern UART_HandleTypeDef huart1;
 
 /* USER CODE BEGIN Private defines */
-
+extern DMA_HandleTypeDef hdma_usart1_tx;
+#if PDM_CFG_SHELL
+extern DMA_HandleTypeDef hdma_usart1_rx;
+#endif
 /* USER CODE END Private defines */
 
 void MX_USART1_UART_Init(void);
@@ -21,7 +21,7 @@
 #include "can.h"
 
 /* USER CODE BEGIN 0 */
-
+#include "pdm_irq.h"
 /* USER CODE END 0 */
 
 CAN_HandleTypeDef hcan;
@@ -90,6 +90,9 @@ void HAL_CAN_MspInit(CAN_HandleTypeDef* canHandle)
     HAL_NVIC_SetPriority(USB_LP_CAN1_RX0_IRQn, 0, 0);
     HAL_NVIC_EnableIRQ(USB_LP_CAN1_RX0_IRQn);
   /* USER CODE BEGIN CAN1_MspInit 1 */
+    /* 邮箱发送完成中断，用于从软件队列补充邮箱 */
+    HAL_NVIC_SetPriority(USB_HP_CAN1_TX_IRQn, PDM_IRQ_PRIO_CAN, 0);
+    HAL_NVIC_EnableIRQ(USB_HP_CAN1_TX_IRQn);
 
   /* USER CODE END CAN1_MspInit 1 */
   }
@@ -115,6 +118,7 @@ void HAL_CAN_MspDeInit(CAN_HandleTypeDef* canHandle)
     /* CAN1 interrupt Deinit */
     HAL_NVIC_DisableIRQ(USB_LP_CAN1_RX0_IRQn);
   /* USER CODE BEGIN CAN1_MspDeInit 1 */
+    HAL_NVIC_DisableIRQ(USB_HP_CAN1_TX_IRQn);
 
   /* USER CODE END CAN1_MspDeInit 1 */
   }
@@ -119,5 +119,34 @@ void HAL_I2C_MspDeInit(I2C_HandleTypeDef* i2cHandle)
 }
 
 /* USER CODE BEGIN 1 */
+#if PDM_CFG_I2C2
+#include "pdm_irq.h"
 
+I2C_HandleTypeDef hi2c2;
+
+void PDM_I2C2_Init(void)
+{
+  GPIO_InitTypeDef GPIO_InitStruct = {0};
+
+  /* HAL_I2C_MspInit() 只处理 I2C1，引脚、时钟和中断在调用 HAL_I2C_Init() 之前配置 */
+  __HAL_RCC_GPIOB_CLK_ENABLE();
+  GPIO_InitStruct.Pin = GPIO_PIN_10|GPIO_PIN_11;
+  GPIO_InitStruct.Mode = GPIO_MODE_AF_OD;
+  GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_HIGH;
+  HAL_GPIO_Init(GPIOB, &GPIO_InitStruct);
+  __HAL_RCC_I2C2_CLK_ENABLE();
+
+  hi2c2.Instance = I2C2;
+  hi2c2.Init = hi2c1.Init;          /* 与 I2C1 相同：400 kHz，7 位地址 */
+  if (HAL_I2C_Init(&hi2c2) != HAL_OK)
+  {
+    Error_Handler();
+  }
+
+  HAL_NVIC_SetPriority(I2C2_EV_IRQn, PDM_IRQ_PRIO_I2C, 0);
+  HAL_NVIC_EnableIRQ(I2C2_EV_IRQn);
+  HAL_NVIC_SetPriority(I2C2_ER_IRQn, PDM_IRQ_PRIO_I2C, 0);
+  HAL_NVIC_EnableIRQ(I2C2_ER_IRQn);
+}
+#endif
 /* USER CODE END 1 */
@@ -1,8 +1,435 @@
 #include "driver_ina226_interface.h"
+#include "ina226_async.h"
 #include "i2c.h"
-#include "usart.h"
+#include "pdm_config.h"
+#include "pdm_diag.h"
+#include "pdm_log.h"
+#include "pdm_prof.h"
+#include "pdm_ramfunc.h"
+#include "pdm_replay.h"
+#include "pdm_rtos.h"
 #include <stdarg.h>
 #include <stdio.h>
+#if PDM_CFG_I2C_LL
+#include "stm32f1xx_ll_i2c.h"
+#endif
+
+/* 异步 I2C 事务队列深度：每片 INA226 每轮读取 5 个寄存器，另留探测和高速采集用的位置 */
+#define IIC_QUEUE_LEN       (PDM_CFG_CHANNELS * INA226_JOB_MAX_REGS + 6)
+/* 单个异步事务的超时时间 (ms)，超时后复位 I2C 外设 */
+#define IIC_XFER_TIMEOUT    5
+/* 阻塞读写前等待异步队列清空的最长时间 (ms) */
+#define IIC_IDLE_TIMEOUT    20
+/* 交给 HAL 的器件地址：去掉选择总线用的 bit0 */
+#define IIC_DEV(addr)       ((uint16_t)((addr) & (uint8_t)~INA226_IIC_BUS_BIT))
+
+/* 总线数：PDM_CFG_I2C2 打开时地址 bit0 为 1 的器件在 I2C2 上 */
+#define IIC_BUSES           (PDM_CFG_I2C2 ? 2 : 1)
+/* LL 读取开始前等待上一个事务的 STOP 发完（BUSY 清除）的次数，约 10 us */
+#define IIC_LL_BUSY_WAIT    150
+/* CONF 的软件复位位 */
+#define CONF_RESET_BIT      0x8000u
+
+/* PDM_CFG_I2C_LL：2 字节读取的步骤，0 表示当前事务由 HAL 处理 */
+#define LL_IDLE             0
+#define LL_START            1       /* 等 SB，发器件地址（写） */
+#define LL_ADDR_W           2       /* 等 ADDR，发寄存器地址 */
+#define LL_REG              3       /* 等 TXE（寄存器地址已移入移位寄存器），请求重复起始 */
+#define LL_RESTART          4       /* 等 SB，发器件地址（读） */
+#define LL_ADDR_R           5       /* 等 ADDR，NACK + POS 后清除 ADDR */
+#define LL_DATA             6       /* 等 BTF（两个字节都已收到），STOP 后读出 */
+
+typedef struct {
+    uint8_t addr;
+    uint8_t reg;
+    uint8_t *buf;
+    uint16_t len;
+    ina226_interface_iic_done_t done;
+    void *ctx;
+    uint8_t bare;                       /* 1: 省略写寄存器地址，PDM_CFG_I2C_STICKY */
+} iic_xfer_t;
+
+/* 每条总线一个事务队列，各自在自己的中断中依次执行，两条总线同时传输 */
+typedef struct {
+    I2C_HandleTypeDef *hi2c;
+    GPIO_TypeDef *port;                 /* 总线恢复时直接操作的引脚 */
+    uint16_t scl;
+    uint16_t sda;
+    iic_xfer_t queue[IIC_QUEUE_LEN];
+    volatile uint8_t head;              /* 主循环写入位置 */
+    volatile uint8_t tail;              /* 当前/下一个要执行的事务 */
+    volatile uint8_t running;           /* 1: 有事务正在总线上传输 */
+    volatile uint8_t ll_state;          /* LL_*，PDM_CFG_I2C_LL */
+    volatile uint32_t start_tick;       /* 当前事务开始的时间 */
+    volatile uint8_t hold;              /* 1: 主循环的阻塞读写在等待或使用总线 */
+    volatile uint8_t recover;           /* 1: 总线被占住，等 ina226_interface_iic_poll() 恢复，期间事务直接失败 */
+} iic_bus_t;
+
+static iic_bus_t g_bus[IIC_BUSES] = {
+    { .hi2c = &hi2c1, .port = GPIOB, .scl = GPIO_PIN_6, .sda = GPIO_PIN_7 },
+#if PDM_CFG_I2C2
+    { .hi2c = &hi2c2, .port = GPIOB, .scl = GPIO_PIN_10, .sda = GPIO_PIN_11 },
+#endif
+};
+static volatile uint16_t g_iic_recoveries;  /* 总线恢复次数 */
+static uint8_t g_drv_addr;      /* 驱动最近一次阻塞读写的器件，驱动随后的错误信息记到这个器件 */
+
+/* --- 器件所在的总线 --- */
+static iic_bus_t *iic_bus(uint8_t addr)
+{
+#if PDM_CFG_I2C2
+    return &g_bus[addr & INA226_IIC_BUS_BIT];
+#else
+    (void)addr;
+    return &g_bus[0];
+#endif
+}
+
+#if PDM_CFG_INA226_SHADOW
+/* 配置、校准、MASK、报警门限寄存器的 RAM 副本，按器件地址分配。
+ * CONF、CALIBRATION、ALERT_LIMIT 只在写入时改变，驱动 ina226_set_xxx() 的读-改-写和 ina226_get_xxx()
+ * 直接读副本，只有写入经过总线。MASK 的状态位（AFF、CVRF、OVF）由器件更新，读 MASK 才清除 AFF 和 CVRF，
+ * 所以驱动读 MASK 时总是从总线读；副本只保存写入或读到的使能位，用于配置检查和恢复。 */
+#define SHADOW_REGS         4
+#define MASK_STATUS_BITS    0x001Cu
+
+typedef struct {
+    uint8_t addr;                       /* 0: 未分配 */
+    uint8_t exclude;                    /* 1: 寄存器表与 INA226 不同的器件，不使用副本 */
+    uint8_t valid;                      /* 第 i 位: val[i] 有效 */
+    uint16_t val[SHADOW_REGS];
+} iic_shadow_t;
+
+static iic_shadow_t g_shadow[PDM_CFG_CHANNELS];
+
+/* --- 寄存器在副本中的位置，不需要副本的寄存器返回 -1 --- */
+static int8_t shadow_index(uint8_t reg)
+{
+    switch (reg)
+    {
+        case INA226_REG_CONF:           return 0;
+        case INA226_REG_CALIBRATION:    return 1;
+        case INA226_REG_MASK:           return 2;
+        case INA226_REG_ALERT_LIMIT:    return 3;
+        default:                        return -1;
+    }
+}
+
+/* --- 查找器件的副本，alloc 非 0 时为新地址分配一项 --- */
+static iic_shadow_t *shadow_find(uint8_t addr, uint8_t alloc)
+{
+    for (uint8_t i = 0; i < PDM_CFG_CHANNELS; i++)
+    {
+        if (g_shadow[i].addr == addr)
+        {
+            return &g_shadow[i];
+        }
+    }
+    for (uint8_t i = 0; alloc && i < PDM_CFG_CHANNELS; i++)
+    {
+        if (g_shadow[i].addr == 0)
+        {
+            g_shadow[i].valid = 0;
+            g_shadow[i].addr = addr;
+            return &g_shadow[i];
+        }
+    }
+    return NULL;
+}
+
+/* --- 需要使用副本的器件 --- */
+static iic_shadow_t *shadow_get(uint8_t addr, int8_t i)
+{
+    iic_shadow_t *s = (i >= 0) ? shadow_find(addr, 1) : NULL;
+
+    return (s != NULL && !s->exclude) ? s : NULL;
+}
+
+/* --- 总线读写成功后更新副本 --- */
+static void shadow_store(iic_shadow_t *s, int8_t i, uint16_t v)
+{
+    if (i == 2)
+    {
+        v &= (uint16_t)~MASK_STATUS_BITS;
+    }
+    if (i == 0 && (v & CONF_RESET_BIT) != 0)
+    {
+        s->valid &= (uint8_t)~1u;       /* 复位尚未完成，读到的不是最终值 */
+        return;
+    }
+    s->val[i] = v;
+    s->valid |= (uint8_t)(1u << i);
+}
+#endif /* PDM_CFG_INA226_SHADOW */
+
+#if PDM_CFG_I2C_STICKY
+/* 每片器件的寄存器指针：读写成功后等于这次的寄存器，失败、总线恢复或软件复位后不确定。
+ * 按器件地址分配，同一器件只在所在总线的事务中更新（该总线的中断或阻塞读写） */
+#define PTR_UNKNOWN         0xFFu
+
+typedef struct {
+    uint8_t addr;                       /* 0: 未分配 */
+    uint8_t reg;                        /* 当前指针，PTR_UNKNOWN: 不确定 */
+    uint8_t bare;                       /* 连续省略指针写入的次数 */
+} iic_ptr_t;
+
+static iic_ptr_t g_ptr[PDM_CFG_CHANNELS];
+
+/* --- 查找器件的指针记录，alloc 非 0 时为新地址分配一项（两条总线的中断都会调用，分配时关中断） --- */
+static PDM_RAMFUNC iic_ptr_t *ptr_find(uint8_t addr, uint8_t alloc)
+{
+    iic_ptr_t *p = NULL;
+    uint32_t primask;
+
+    for (uint8_t i = 0; i < PDM_CFG_CHANNELS; i++)
+    {
+        if (g_ptr[i].addr == addr)
+        {
+            return &g_ptr[i];
+        }
+    }
+    primask = __get_PRIMASK();
+    __disable_irq();
+    for (uint8_t i = 0; alloc && p == NULL && i < PDM_CFG_CHANNELS; i++)
+    {
+        if (g_ptr[i].addr == addr)
+        {
+            p = &g_ptr[i];
+        }
+        else if (g_ptr[i].addr == 0)
+        {
+            g_ptr[i].reg = PTR_UNKNOWN;
+            g_ptr[i].addr = addr;
+            p = &g_ptr[i];
+        }
+    }
+    __set_PRIMASK(primask);
+    return p;
+}
+
+/* --- 这次读取可以省略写寄存器地址 --- */
+static PDM_RAMFUNC uint8_t ptr_sticky(uint8_t addr, uint8_t reg)
+{
+    const iic_ptr_t *p = ptr_find(addr, 0);
+
+    return (uint8_t)(p != NULL && p->reg == reg && p->bare < PDM_CFG_I2C_STICKY_REFRESH);
+}
+
+/* --- 事务结束后更新指针 --- */
+static PDM_RAMFUNC void ptr_update(uint8_t addr, uint8_t reg, uint8_t bare, uint8_t res)
+{
+    iic_ptr_t *p = ptr_find(addr, res == 0);
+
+    if (p == NULL)
+    {
+        return;
+    }
+    if (res != 0)
+    {
+        p->reg = PTR_UNKNOWN;
+        return;
+    }
+    p->reg = reg;
+    p->bare = bare ? (uint8_t)(p->bare + 1u) : 0;
+}
+
+/* --- 总线恢复：打断的事务可能已经写了一半指针，这条总线上的器件都重新写指针 --- */
+static void ptr_forget_bus(const iic_bus_t *b)
+{
+    for (uint8_t i = 0; i < PDM_CFG_CHANNELS; i++)
+    {
+        if (g_ptr[i].addr != 0 && iic_bus(g_ptr[i].addr) == b)
+        {
+            g_ptr[i].reg = PTR_UNKNOWN;
+        }
+    }
+}
+#endif /* PDM_CFG_I2C_STICKY */
+
+#if !PDM_CFG_REPLAY
+/* --- 约 5 us 延时（72 MHz），总线恢复时产生 SCL 用 --- */
+static void iic_delay_5us(void)
+{
+    for (volatile uint32_t i = 0; i < 60; i++) { }
+}
+
+/* --- 总线恢复：从机在读到一半时被打断可能一直拉住 SDA。
+ *     把 SCL 改成普通输出，最多打 9 个时钟让从机把剩下的位送完，再发一个 STOP --- */
+static void iic_bus_clear(iic_bus_t *b)
+{
+    GPIO_InitTypeDef gpio = {0};
+
+    HAL_I2C_DeInit(b->hi2c);
+
+    __HAL_RCC_GPIOB_CLK_ENABLE();
+    HAL_GPIO_WritePin(b->port, b->scl | b->sda, GPIO_PIN_SET);
+    gpio.Pin = b->scl | b->sda;
+    gpio.Mode = GPIO_MODE_OUTPUT_OD;
+    gpio.Speed = GPIO_SPEED_FREQ_HIGH;
+    HAL_GPIO_Init(b->port, &gpio);
+
+    for (uint8_t i = 0; i < 9 && HAL_GPIO_ReadPin(b->port, b->sda) == GPIO_PIN_RESET; i++)
+    {
+        HAL_GPIO_WritePin(b->port, b->scl, GPIO_PIN_RESET);
+        iic_delay_5us();
+        HAL_GPIO_WritePin(b->port, b->scl, GPIO_PIN_SET);
+        iic_delay_5us();
+    }
+
+    /* STOP：SCL 高时 SDA 由低变高 */
+    HAL_GPIO_WritePin(b->port, b->sda, GPIO_PIN_RESET);
+    iic_delay_5us();
+    HAL_GPIO_WritePin(b->port, b->sda, GPIO_PIN_SET);
+    iic_delay_5us();
+
+    /* I2C1 由 HAL_I2C_Init（CubeMX 的 MspInit）重新配置引脚；I2C2 不在 CubeMX 中，这里自己改回复用开漏 */
+    gpio.Mode = GPIO_MODE_AF_OD;
+    HAL_GPIO_Init(b->port, &gpio);
+
+    /* HAL_I2C_Init 同时软件复位外设，清掉卡住的 BUSY 标志 */
+    HAL_I2C_Init(b->hi2c);
+    b->ll_state = LL_IDLE;
+#if PDM_CFG_I2C_STICKY
+    ptr_forget_bus(b);
+#endif
+    g_iic_recoveries++;
+}
+#endif /* !PDM_CFG_REPLAY */
+
+#if PDM_CFG_I2C_LL
+/* --- LL 读取：只做“写寄存器地址、重复起始、读 2 字节”，各步骤直接操作寄存器，
+ *     每个事务 6 次中断（SB、ADDR、TXE、SB、ADDR、BTF），每次只检查当前步骤等待的标志；
+ *     bare 为 1 时不写寄存器地址，从读地址开始（SB、ADDR、BTF 3 次）。
+ *     返回 1 时总线仍忙，交给 HAL 处理 --- */
+static PDM_RAMFUNC uint8_t iic_ll_start(iic_bus_t *b, uint8_t bare)
+{
+    I2C_TypeDef *i2c = b->hi2c->Instance;
+
+    for (uint16_t n = 0; n < IIC_LL_BUSY_WAIT && LL_I2C_IsActiveFlag_BUSY(i2c); n++)
+    {
+    }
+    if (LL_I2C_IsActiveFlag_BUSY(i2c))
+    {
+        return 1;
+    }
+    LL_I2C_DisableBitPOS(i2c);
+    LL_I2C_AcknowledgeNextData(i2c, LL_I2C_ACK);
+    b->ll_state = bare ? LL_RESTART : LL_START;
+    LL_I2C_EnableIT_EVT(i2c);
+    LL_I2C_EnableIT_ERR(i2c);
+    LL_I2C_GenerateStartCondition(i2c);
+    return 0;
+}
+#endif
+
+/* --- 启动队首事务，没有事务时清除运行标志（中断和主循环都会调用） --- */
+static PDM_RAMFUNC void iic_start_next(iic_bus_t *b)
+{
+    for (;;)
+    {
+        iic_xfer_t *x = &b->queue[b->tail];
+        uint32_t primask = __get_PRIMASK();
+
+        /* 采样时钟中断优先级更高，可能在这里入队：判断队列为空和清除 running 要一起完成，
+         * 否则它看到 running 仍为 1 不启动，这里又已经退出，新事务一直等到超时 */
+        __disable_irq();
+        if (b->tail == b->head)
+        {
+            b->running = 0;
+            __set_PRIMASK(primask);
+            return;
+        }
+        __set_PRIMASK(primask);
+
+        b->running = 1;
+        b->start_tick = HAL_GetTick();
+#if PDM_CFG_I2C_STICKY
+        x->bare = ptr_sticky(x->addr, x->reg);
+#else
+        x->bare = 0;
+#endif
+#if PDM_CFG_REPLAY
+        (void)x;
+        return;                         /* 回放：由 ina226_interface_iic_poll() 从虚拟器件读取 */
+#else
+        if (!b->recover)
+        {
+#if PDM_CFG_I2C_LL
+            if (x->len == 2 && iic_ll_start(b, x->bare) == 0)
+            {
+                return;
+            }
+#endif
+            if (x->bare)
+            {
+                if (HAL_I2C_Master_Receive_IT(b->hi2c, IIC_DEV(x->addr), x->buf, x->len) == HAL_OK)
+                {
+                    return;             /* 完成时为 HAL_I2C_MasterRxCpltCallback */
+                }
+            }
+            else if (HAL_I2C_Mem_Read_IT(b->hi2c, IIC_DEV(x->addr), x->reg, I2C_MEMADD_SIZE_8BIT,
+                                         x->buf, x->len) == HAL_OK)
+            {
+                return;
+            }
+
+            /* 启动失败：总线被占住时记下要恢复。恢复要重新初始化外设并忙等约 100 us，
+             * 这里可能在中断中，交给主循环的 ina226_interface_iic_poll() */
+            if (__HAL_I2C_GET_FLAG(b->hi2c, I2C_FLAG_BUSY))
+            {
+                b->recover = 1;
+            }
+        }
+
+        /* 本事务报告错误，继续下一个（等待恢复时队列中的事务都这样结束） */
+#if PDM_CFG_I2C_STICKY
+        ptr_update(x->addr, x->reg, x->bare, 1);
+#endif
+        b->tail = (uint8_t)((b->tail + 1) % IIC_QUEUE_LEN);
+        if (x->done != NULL)
+        {
+            x->done(1, x->ctx);
+        }
+#endif
+    }
+}
+
+/* --- 结束当前事务并启动下一个 --- */
+static PDM_RAMFUNC void iic_finish_current(iic_bus_t *b, uint8_t res)
+{
+    iic_xfer_t *x = &b->queue[b->tail];
+    ina226_interface_iic_done_t done = x->done;
+    void *ctx = x->ctx;
+
+#if PDM_CFG_I2C_STICKY
+    ptr_update(x->addr, x->reg, x->bare, res);
+#endif
+    b->tail = (uint8_t)((b->tail + 1) % IIC_QUEUE_LEN);
+    if (done != NULL)
+    {
+        done(res, ctx);
+    }
+    iic_start_next(b);
+#if PDM_CFG_RTOS
+    PDM_Rtos_Wake(PDM_RTOS_WAKE_ACQ);       /* 采集任务处理结果 */
+#endif
+}
+
+/* --- 阻塞读写前等待同一总线上的异步事务全部完成 --- */
+static uint8_t iic_wait_idle(const iic_bus_t *b)
+{
+    uint32_t start = HAL_GetTick();
+
+    while (b->running || (b->tail != b->head))
+    {
+        ina226_interface_iic_poll();
+        if (HAL_GetTick() - start > IIC_IDLE_TIMEOUT)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
 
 uint8_t ina226_interface_iic_init(void)
 {
@@ -14,38 +441,641 @@ uint8_t ina226_interface_iic_deinit(void)
     return 0;
 }
 
-uint8_t ina226_interface_iic_read(uint8_t addr, uint8_t reg, uint8_t *buf, uint16_t len)
+static uint8_t iic_read_blocking(uint8_t addr, uint8_t reg, uint8_t *buf, uint16_t len)
 {
-    if (HAL_I2C_Master_Transmit(&hi2c1, addr, &reg, 1, 10) != HAL_OK)
+    g_drv_addr = addr;
+#if PDM_CFG_INA226_SHADOW
+    int8_t i = (len == 2) ? shadow_index(reg) : -1;
+    iic_shadow_t *s = shadow_get(addr, i);
+
+    if (s != NULL && i != 2 && (s->valid & (1u << i)) != 0)
+    {
+        buf[0] = (uint8_t)(s->val[i] >> 8);
+        buf[1] = (uint8_t)s->val[i];
+        return 0;
+    }
+#endif
+    iic_bus_t *b = iic_bus(addr);
+
+    if (iic_wait_idle(b) != 0)
     {
         return 1;
     }
-    if (HAL_I2C_Master_Receive(&hi2c1, addr, buf, len, 10) != HAL_OK)
+#if PDM_CFG_REPLAY
+    if (PDM_Replay_Read(addr, reg, buf, len) != 0)
     {
         return 1;
     }
+#else
+#if PDM_CFG_I2C_STICKY
+    uint8_t bare = ptr_sticky(addr, reg);
+#else
+    uint8_t bare = 0;
+#endif
+
+    if ((!bare && HAL_I2C_Master_Transmit(b->hi2c, IIC_DEV(addr), &reg, 1, 10) != HAL_OK)
+        || HAL_I2C_Master_Receive(b->hi2c, IIC_DEV(addr), buf, len, 10) != HAL_OK)
+    {
+#if PDM_CFG_I2C_STICKY
+        ptr_update(addr, reg, bare, 1);
+#endif
+        return 1;
+    }
+#if PDM_CFG_I2C_STICKY
+    ptr_update(addr, reg, bare, 0);
+#endif
+#endif
+#if PDM_CFG_INA226_SHADOW
+    if (s != NULL)
+    {
+        shadow_store(s, i, (uint16_t)((uint16_t)buf[0] << 8 | buf[1]));
+    }
+#endif
     return 0;
 }
 
-uint8_t ina226_interface_iic_write(uint8_t addr, uint8_t reg, uint8_t *buf, uint16_t len)
+static uint8_t iic_write_blocking(uint8_t addr, uint8_t reg, uint8_t *buf, uint16_t len)
 {
     uint8_t tmp[3];
+    iic_bus_t *b = iic_bus(addr);
+
+    g_drv_addr = addr;
     tmp[0] = reg;
     if (len > 2)
     {
         return 1;
     }
+    if (iic_wait_idle(b) != 0)
+    {
+        return 1;
+    }
     for (uint16_t i = 0; i < len; i++)
     {
         tmp[1 + i] = buf[i];
     }
-    if (HAL_I2C_Master_Transmit(&hi2c1, addr, tmp, (uint16_t)(1 + len), 10) != HAL_OK)
+#if PDM_CFG_INA226_SHADOW
+    int8_t i = (len == 2) ? shadow_index(reg) : -1;
+    iic_shadow_t *s = shadow_get(addr, i);
+#endif
+#if PDM_CFG_REPLAY
+    if (PDM_Replay_Write(addr, tmp[0], &tmp[1], len) != 0)
+#else
+    if (HAL_I2C_Master_Transmit(b->hi2c, IIC_DEV(addr), tmp, (uint16_t)(1 + len), 10) != HAL_OK)
+#endif
+    {
+#if PDM_CFG_INA226_SHADOW
+        if (s != NULL)
+        {
+            s->valid &= (uint8_t)~(1u << i);    /* 不确定是否已写入，下次从总线读 */
+        }
+#endif
+#if PDM_CFG_I2C_STICKY
+        ptr_update(addr, reg, 0, 1);
+#endif
+        return 1;
+    }
+#if PDM_CFG_I2C_STICKY
+    /* 写入同样设置指针；CONF 软件复位后指针回到默认值，按不确定处理 */
+    ptr_update(addr, reg, 0, (reg == INA226_REG_CONF && len == 2 && (((uint16_t)buf[0] << 8) & CONF_RESET_BIT) != 0) ? 1 : 0);
+#endif
+#if PDM_CFG_INA226_SHADOW
+    if (s != NULL)
+    {
+        uint16_t v = (uint16_t)((uint16_t)buf[0] << 8 | buf[1]);
+
+        if (i == 0 && (v & CONF_RESET_BIT) != 0)
+        {
+            s->valid = 0;               /* 软件复位：所有寄存器恢复默认值，重新从总线读 */
+        }
+        else
+        {
+            shadow_store(s, i, v);
+        }
+    }
+#endif
+    return 0;
+}
+
+/* --- 阻塞读写期间标记总线，完成回调中自己续读的事务（上电采集）看到后停下 --- */
+uint8_t ina226_interface_iic_read(uint8_t addr, uint8_t reg, uint8_t *buf, uint16_t len)
+{
+    iic_bus_t *b = iic_bus(addr);
+    uint8_t res;
+
+    b->hold = 1;
+    res = iic_read_blocking(addr, reg, buf, len);
+    b->hold = 0;
+    return res;
+}
+
+uint8_t ina226_interface_iic_write(uint8_t addr, uint8_t reg, uint8_t *buf, uint16_t len)
+{
+    iic_bus_t *b = iic_bus(addr);
+    uint8_t res;
+
+    b->hold = 1;
+    res = iic_write_blocking(addr, reg, buf, len);
+    b->hold = 0;
+    return res;
+}
+
+uint8_t ina226_interface_iic_held(uint8_t addr)
+{
+    return iic_bus(addr)->hold;
+}
+
+/* --- 队列剩余空位 --- */
+static uint8_t iic_queue_free(const iic_bus_t *b)
+{
+    return (uint8_t)(IIC_QUEUE_LEN - 1 - (uint8_t)((b->head + IIC_QUEUE_LEN - b->tail) % IIC_QUEUE_LEN));
+}
+
+/* --- 写入一个事务但不移动 head，调用者保证有空位 --- */
+static void iic_fill(iic_bus_t *b, uint8_t slot, uint8_t addr, uint8_t reg, uint8_t *buf, uint16_t len,
+                     ina226_interface_iic_done_t done, void *ctx)
+{
+    iic_xfer_t *x = &b->queue[slot];
+
+    x->addr = addr;
+    x->reg = reg;
+    x->buf = buf;
+    x->len = len;
+    x->done = done;
+    x->ctx = ctx;
+}
+
+/* --- 提交已写入的事务并在空闲时启动 --- */
+static void iic_commit(iic_bus_t *b, uint8_t new_head)
+{
+    uint32_t primask;
+
+    /* 入队和“是否需要启动”的判断要一起完成，否则可能和完成中断错开导致队列停住 */
+    primask = __get_PRIMASK();
+    __disable_irq();
+    b->head = new_head;
+    if (!b->running)
+    {
+        iic_start_next(b);
+    }
+    __set_PRIMASK(primask);
+}
+
+uint8_t ina226_interface_iic_read_async(uint8_t addr, uint8_t reg, uint8_t *buf, uint16_t len,
+                                       ina226_interface_iic_done_t done, void *ctx)
+{
+    iic_bus_t *b = iic_bus(addr);
+    uint32_t primask;
+
+    /* 完成回调中也会继续入队（高速采集），入队过程关中断 */
+    primask = __get_PRIMASK();
+    __disable_irq();
+    if (iic_queue_free(b) < 1)
+    {
+        __set_PRIMASK(primask);
+        return 1;                       /* 队列已满 */
+    }
+
+    iic_fill(b, b->head, addr, reg, buf, len, done, ctx);
+    iic_commit(b, (uint8_t)((b->head + 1) % IIC_QUEUE_LEN));
+    __set_PRIMASK(primask);
+
+    return 0;
+}
+
+/* 一轮读取中各寄存器的顺序，MASK 最先读，用于判断溢出和转换完成 */
+static const uint8_t g_channel_regs[INA226_READ_REGS] = {
+    INA226_REG_MASK,
+    INA226_REG_SHUNT_VOLTAGE,
+    INA226_REG_BUS_VOLTAGE,
+    INA226_REG_CURRENT,
+    INA226_REG_POWER,
+};
+
+/* 一轮读取中每个寄存器读完后调用（I2C 中断中） */
+static void job_reg_done(uint8_t res, void *ctx)
+{
+    ina226_read_job_t *job = (ina226_read_job_t *)ctx;
+
+    if (res != 0)
+    {
+        job->failed = 1;
+    }
+    if (--job->pending == 0 && job->done != NULL)
+    {
+        job->done(job->failed, job->ctx);
+    }
+}
+
+uint8_t ina226_interface_read_regs_async(uint8_t addr, ina226_read_job_t *job,
+                                         const uint8_t *regs, const uint8_t *lens, uint8_t n,
+                                         ina226_interface_iic_done_t done, void *ctx)
+{
+    iic_bus_t *b = iic_bus(addr);
+    uint8_t slot;
+    uint32_t primask;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    slot = b->head;
+    if (n == 0 || n > INA226_JOB_MAX_REGS || iic_queue_free(b) < n)
     {
+        __set_PRIMASK(primask);
         return 1;
     }
+
+    job->n = n;
+    job->failed = 0;
+    job->pending = n;
+    job->done = done;
+    job->ctx = ctx;
+
+    /* 所有读事务一次性入队，中断里读完一个立即开始下一个，中间不回主循环 */
+    for (uint8_t i = 0; i < n; i++)
+    {
+        iic_fill(b, slot, addr, regs[i], job->raw[i], lens[i], job_reg_done, job);
+        slot = (uint8_t)((slot + 1) % IIC_QUEUE_LEN);
+    }
+    iic_commit(b, slot);
+    __set_PRIMASK(primask);
+
+    return 0;
+}
+
+uint8_t ina226_interface_read_channel_async(uint8_t addr, ina226_read_job_t *job,
+                                            ina226_interface_iic_done_t done, void *ctx)
+{
+    static const uint8_t lens[INA226_READ_REGS] = { 2, 2, 2, 2, 2 };
+
+    return ina226_interface_read_regs_async(addr, job, g_channel_regs, lens, INA226_READ_REGS,
+                                            done, ctx);
+}
+
+uint8_t ina226_interface_job_busy(const ina226_read_job_t *job)
+{
+    return (uint8_t)(job->pending != 0);
+}
+
+uint8_t ina226_interface_channel_decode(const ina226_read_job_t *job, ina226_regs_t *snap)
+{
+    if (job->failed)
+    {
+        return 1;
+    }
+
+    snap->mask    = (uint16_t)((uint16_t)job->raw[0][0] << 8 | job->raw[0][1]);
+    snap->shunt   = (int16_t)((uint16_t)job->raw[1][0] << 8 | job->raw[1][1]);
+    snap->bus     = (uint16_t)((uint16_t)job->raw[2][0] << 8 | job->raw[2][1]);
+    snap->current = (int16_t)((uint16_t)job->raw[3][0] << 8 | job->raw[3][1]);
+    snap->power   = (uint16_t)((uint16_t)job->raw[4][0] << 8 | job->raw[4][1]);
+
+    if ((snap->mask & (1 << 2)) != 0)                /* 数学溢出，与驱动的返回码 4 一致 */
+    {
+        return 4;
+    }
+    return 0;
+}
+
+uint8_t ina226_interface_read_channel(uint8_t addr, ina226_regs_t *snap)
+{
+    ina226_read_job_t job;
+
+    if (ina226_interface_read_channel_async(addr, &job, NULL, NULL) != 0)
+    {
+        return 1;
+    }
+    while (job.pending != 0)
+    {
+        ina226_interface_iic_poll();
+    }
+    return ina226_interface_channel_decode(&job, snap);
+}
+
+void ina226_interface_shadow_exclude(uint8_t addr)
+{
+#if PDM_CFG_INA226_SHADOW
+    iic_shadow_t *s = shadow_find(addr, 1);
+
+    if (s != NULL)
+    {
+        s->exclude = 1;
+    }
+#else
+    (void)addr;
+#endif
+}
+
+uint8_t ina226_interface_shadow_differs(uint8_t addr, uint8_t reg, uint16_t value)
+{
+#if PDM_CFG_INA226_SHADOW
+    int8_t i = shadow_index(reg);
+    iic_shadow_t *s = shadow_get(addr, i);
+
+    if (s == NULL || (s->valid & (1u << i)) == 0)
+    {
+        return 0;
+    }
+    if (i == 2)
+    {
+        value &= (uint16_t)~MASK_STATUS_BITS;
+    }
+    return (uint8_t)(s->val[i] != value);
+#else
+    (void)addr;
+    (void)reg;
+    (void)value;
+    return 0;
+#endif
+}
+
+uint8_t ina226_interface_shadow_restore(uint8_t addr)
+{
+#if PDM_CFG_INA226_SHADOW
+    /* CONF 最后写，写入后按恢复的配置开始转换 */
+    static const uint8_t order[SHADOW_REGS] = {
+        INA226_REG_CALIBRATION, INA226_REG_ALERT_LIMIT, INA226_REG_MASK, INA226_REG_CONF
+    };
+    iic_shadow_t *s = shadow_find(addr, 0);
+
+    if (s == NULL || s->exclude)
+    {
+        return 1;
+    }
+    for (uint8_t k = 0; k < SHADOW_REGS; k++)
+    {
+        int8_t i = shadow_index(order[k]);
+        uint8_t buf[2];
+
+        if ((s->valid & (1u << i)) == 0)
+        {
+            continue;                   /* 从未写过或读过，器件上是默认值 */
+        }
+        buf[0] = (uint8_t)(s->val[i] >> 8);
+        buf[1] = (uint8_t)s->val[i];
+        if (ina226_interface_iic_write(addr, order[k], buf, 2) != 0)
+        {
+            return 1;
+        }
+    }
+    return 0;
+#else
+    (void)addr;
+    return 1;
+#endif
+}
+
+uint16_t ina226_interface_iic_recoveries(void)
+{
+    return g_iic_recoveries;
+}
+
+uint8_t ina226_interface_iic_busy(void)
+{
+    for (uint8_t i = 0; i < IIC_BUSES; i++)
+    {
+        if (g_bus[i].running || (g_bus[i].tail != g_bus[i].head))
+        {
+            return 1;
+        }
+    }
     return 0;
 }
 
+#if PDM_CFG_REPLAY
+/* 回放：依次完成队列中的事务。与 I2C 中断中一样关中断执行完成回调，回调中入队的事务在同一次调用中完成 */
+void ina226_interface_iic_poll(void)
+{
+    for (uint8_t i = 0; i < IIC_BUSES; i++)
+    {
+        iic_bus_t *b = &g_bus[i];
+
+        while (b->running)
+        {
+            uint32_t primask = __get_PRIMASK();
+
+            __disable_irq();
+            if (b->running)
+            {
+                iic_xfer_t *x = &b->queue[b->tail];
+
+                iic_finish_current(b, PDM_Replay_Read(x->addr, x->reg, x->buf, x->len));
+            }
+            __set_PRIMASK(primask);
+        }
+    }
+}
+#else
+void ina226_interface_iic_poll(void)
+{
+    for (uint8_t i = 0; i < IIC_BUSES; i++)
+    {
+        iic_bus_t *b = &g_bus[i];
+        uint32_t primask;
+
+        /* 事务超时（总线被占住或器件无响应）：关闭这条总线的 I2C 中断，当前事务按失败处理，下面恢复总线 */
+        if (b->running && HAL_GetTick() - b->start_tick > IIC_XFER_TIMEOUT)
+        {
+            primask = __get_PRIMASK();
+            __disable_irq();
+            if (b->running && (HAL_GetTick() - b->start_tick > IIC_XFER_TIMEOUT))
+            {
+                __HAL_I2C_DISABLE_IT(b->hi2c, I2C_IT_EVT | I2C_IT_BUF | I2C_IT_ERR);
+                b->recover = 1;
+                iic_finish_current(b, 1);
+            }
+            __set_PRIMASK(primask);
+        }
+
+        /* 恢复总线并复位外设，不关中断。设置 recover 之后不再启动事务，总线上没有传输；
+         * 恢复期间中断里入队的事务直接报告失败 */
+        if (b->recover && !b->running)
+        {
+            iic_bus_clear(b);
+            b->recover = 0;
+        }
+    }
+}
+#endif /* PDM_CFG_REPLAY */
+
+/* --- 中断回调对应的总线 --- */
+static PDM_RAMFUNC iic_bus_t *iic_bus_of(const I2C_HandleTypeDef *hi2c)
+{
+    for (uint8_t i = 0; i < IIC_BUSES; i++)
+    {
+        if (g_bus[i].hi2c == hi2c)
+        {
+            return &g_bus[i];
+        }
+    }
+    return NULL;
+}
+
+#if PDM_CFG_I2C_LL
+/* --- LL 读取结束：恢复 POS/ACK，关闭中断，结束事务并启动下一个 --- */
+static PDM_RAMFUNC void iic_ll_end(iic_bus_t *b, I2C_TypeDef *i2c, uint8_t res)
+{
+    LL_I2C_DisableBitPOS(i2c);
+    LL_I2C_AcknowledgeNextData(i2c, LL_I2C_ACK);
+    LL_I2C_DisableIT_EVT(i2c);
+    LL_I2C_DisableIT_BUF(i2c);
+    LL_I2C_DisableIT_ERR(i2c);
+    b->ll_state = LL_IDLE;
+    PDM_PROF_BEGIN(PDM_PROF_I2C_ISR);
+    iic_finish_current(b, res);
+    PDM_PROF_END(PDM_PROF_I2C_ISR);
+}
+
+/* --- LL 读取的事件中断，不是当前步骤等待的事件时直接返回
+ *     （请求重复起始后到 SB 置位前 BTF 可能短暂置位，进入几次中断不做处理） --- */
+static PDM_RAMFUNC void iic_ll_ev(iic_bus_t *b)
+{
+    I2C_TypeDef *i2c = b->hi2c->Instance;
+    const iic_xfer_t *x = &b->queue[b->tail];
+    uint32_t sr1 = i2c->SR1;
+    uint32_t primask;
+
+    switch (b->ll_state)
+    {
+    case LL_START:
+        if (sr1 & I2C_SR1_SB)
+        {
+            LL_I2C_TransmitData8(i2c, (uint8_t)IIC_DEV(x->addr));      /* 读 SR1 后写 DR 清除 SB */
+            b->ll_state = LL_ADDR_W;
+        }
+        break;
+    case LL_ADDR_W:
+        if (sr1 & I2C_SR1_ADDR)
+        {
+            (void)i2c->SR2;                                 /* 读 SR1、SR2 清除 ADDR */
+            LL_I2C_TransmitData8(i2c, x->reg);
+            LL_I2C_EnableIT_BUF(i2c);
+            b->ll_state = LL_REG;
+        }
+        break;
+    case LL_REG:
+        if (sr1 & I2C_SR1_TXE)
+        {
+            /* 寄存器地址已在移位寄存器中：此时置 START，发完这个字节后产生重复起始，不用等 BTF */
+            LL_I2C_DisableIT_BUF(i2c);
+            LL_I2C_GenerateStartCondition(i2c);
+            b->ll_state = LL_RESTART;
+        }
+        break;
+    case LL_RESTART:
+        if (sr1 & I2C_SR1_SB)
+        {
+            LL_I2C_TransmitData8(i2c, (uint8_t)(IIC_DEV(x->addr) | 1u));
+            b->ll_state = LL_ADDR_R;
+        }
+        break;
+    case LL_ADDR_R:
+        if (sr1 & I2C_SR1_ADDR)
+        {
+            /* 2 字节接收（RM0008 I2C 主接收）：清除 ADDR 之前 ACK=0、POS=1，第 2 个字节之后发 NACK。
+             * 勘误 ES096（I2C 的软件步骤须在当前字节传输结束前完成）：这几步不能被更高优先级的中断推迟，关中断完成 */
+            primask = __get_PRIMASK();
+            __disable_irq();
+            LL_I2C_AcknowledgeNextData(i2c, LL_I2C_NACK);
+            LL_I2C_EnableBitPOS(i2c);
+            (void)i2c->SR2;
+            __set_PRIMASK(primask);
+            b->ll_state = LL_DATA;
+        }
+        break;
+    case LL_DATA:
+        if (sr1 & I2C_SR1_BTF)
+        {
+            /* 第 1 个字节在 DR、第 2 个在移位寄存器，SCL 被拉低：先置 STOP 再读出，
+             * 置 STOP 和读第 1 个字节之间同样不能被打断 */
+            primask = __get_PRIMASK();
+            __disable_irq();
+            LL_I2C_GenerateStopCondition(i2c);
+            x->buf[0] = LL_I2C_ReceiveData8(i2c);
+            __set_PRIMASK(primask);
+            x->buf[1] = LL_I2C_ReceiveData8(i2c);
+            iic_ll_end(b, i2c, 0);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+/* --- LL 读取的错误中断：无应答、总线错误、仲裁失败、溢出，本事务报告失败 --- */
+static void iic_ll_er(iic_bus_t *b)
+{
+    I2C_TypeDef *i2c = b->hi2c->Instance;
+    uint8_t arlo = (uint8_t)LL_I2C_IsActiveFlag_ARLO(i2c);
+
+    LL_I2C_ClearFlag_AF(i2c);
+    LL_I2C_ClearFlag_BERR(i2c);
+    LL_I2C_ClearFlag_ARLO(i2c);
+    LL_I2C_ClearFlag_OVR(i2c);
+    if (!arlo)
+    {
+        LL_I2C_GenerateStopCondition(i2c);      /* 仲裁失败时已不是主机，不发 STOP */
+    }
+    iic_ll_end(b, i2c, 1);
+}
+#endif /* PDM_CFG_I2C_LL */
+
+PDM_RAMFUNC void ina226_interface_i2c_ev_irq(uint8_t bus)
+{
+    iic_bus_t *b = &g_bus[(bus < IIC_BUSES) ? bus : 0];
+
+#if PDM_CFG_I2C_LL
+    if (b->ll_state != LL_IDLE)
+    {
+        iic_ll_ev(b);
+        return;
+    }
+#endif
+    HAL_I2C_EV_IRQHandler(b->hi2c);
+}
+
+void ina226_interface_i2c_er_irq(uint8_t bus)
+{
+    iic_bus_t *b = &g_bus[(bus < IIC_BUSES) ? bus : 0];
+
+#if PDM_CFG_I2C_LL
+    if (b->ll_state != LL_IDLE)
+    {
+        iic_ll_er(b);
+        return;
+    }
+#endif
+    HAL_I2C_ER_IRQHandler(b->hi2c);
+}
+
+PDM_RAMFUNC void HAL_I2C_MemRxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+    iic_bus_t *b = iic_bus_of(hi2c);
+
+    if (b != NULL && b->running)
+    {
+        PDM_PROF_BEGIN(PDM_PROF_I2C_ISR);
+        iic_finish_current(b, 0);
+        PDM_PROF_END(PDM_PROF_I2C_ISR);
+    }
+}
+
+#if PDM_CFG_I2C_STICKY
+/* 省略写寄存器地址的读取由 HAL_I2C_Master_Receive_IT() 完成 */
+PDM_RAMFUNC void HAL_I2C_MasterRxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+    HAL_I2C_MemRxCpltCallback(hi2c);
+}
+#endif
+
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c)
+{
+    iic_bus_t *b = iic_bus_of(hi2c);
+
+    if (b != NULL && b->running)
+    {
+        iic_finish_current(b, 1);
+    }
+}
+
 void ina226_interface_delay_ms(uint32_t ms)
 {
     HAL_Delay(ms);
@@ -53,16 +1083,21 @@ void ina226_interface_delay_ms(uint32_t ms)
 
 void ina226_interface_debug_print(const char *const fmt, ...)
 {
-    char buf[128];
     va_list args;
     va_start(args, fmt);
-    int len = vsnprintf(buf, sizeof(buf), fmt, args);
+    PDM_Log_VPrintf(fmt, args);
     va_end(args);
-    if (len > 0)
-    {
-        int send_len = (len < sizeof(buf)) ? len : (sizeof(buf) - 1);
-        HAL_UART_Transmit(&huart1, (uint8_t *)buf, (uint16_t)send_len, 100);
-    }
+}
+
+void ina226_interface_driver_print(const char *const fmt, ...)
+{
+    PDM_Diag_Note(g_drv_addr, fmt);
+#if PDM_CFG_DIAG_LEVEL >= 2
+    va_list args;
+    va_start(args, fmt);
+    PDM_Log_VPrintf(fmt, args);
+    va_end(args);
+#endif
 }
 
 void ina226_interface_receive_callback(uint8_t type)
@@ -26,6 +26,18 @@
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
 #include "pdm_monitor.h"
+#include "pdm_log.h"
+#include "pdm_pool.h"
+#include "pdm_cmd.h"
+#include "pdm_irq.h"
+#include "pdm_isotp.h"
+#include "pdm_bench.h"
+#include "pdm_boot.h"
+#include "pdm_crash.h"
+#include "pdm_ramfunc.h"
+#include "pdm_rtos.h"
+#include "pdm_stack.h"
+#include "pdm_xcp.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -68,7 +80,15 @@ int main(void)
 {
 
   /* USER CODE BEGIN 1 */
-
+#if PDM_CFG_BOOT
+  SCB->VTOR = PDM_BOOT_APP_BASE;    // 引导程序跳转前已设置，这里用调试器直接从应用程序启动时也正确
+#endif
+#if PDM_CFG_STACK
+  PDM_Stack_Paint();        // 最先执行，之后的初始化代码用到的栈也计入峰值
+#endif
+#if PDM_CFG_RAM_VECTORS
+  PDM_RamVectors_Init();    // 中断打开之前切换到 SRAM 中的向量表
+#endif
   /* USER CODE END 1 */
 
   /* MCU Configuration--------------------------------------------------------*/
@@ -93,35 +113,37 @@ int main(void)
   MX_I2C1_Init();
   MX_USART1_UART_Init();
   /* USER CODE BEGIN 2 */
-    CAN_FilterTypeDef sFilterConfig;
-
-    // 配置过滤器参数（此处配置为接收所有标准数据帧，以满足硬件要求）
-    sFilterConfig.FilterBank = 0;                       // 使用过滤器组0
-    sFilterConfig.FilterMode = CAN_FILTERMODE_IDMASK;   // 掩码模式
-    sFilterConfig.FilterScale = CAN_FILTERSCALE_32BIT;  // 32位宽
-    sFilterConfig.FilterIdHigh = 0x0000;                // ID高位
-    sFilterConfig.FilterIdLow = 0x0000;                 // ID低位
-    sFilterConfig.FilterMaskIdHigh = 0x0000;            // 掩码高位（全0表示不校验，接收所有）
-    sFilterConfig.FilterMaskIdLow = 0x0000;             // 掩码低位
-    sFilterConfig.FilterFIFOAssignment = CAN_RX_FIFO0;  // 分配到FIFO0
-    sFilterConfig.FilterActivation = ENABLE;            // 激活该过滤器
-    sFilterConfig.SlaveStartFilterBank = 14;            // 从属CAN的起始过滤器（单CAN MCU填14即可）
-
-    // 1. 初始化过滤器
-    if (HAL_CAN_ConfigFilter(&hcan, &sFilterConfig) != HAL_OK)
-    {
-      Error_Handler(); // 初始化失败则进入错误处理
-    }
+#if PDM_CFG_I2C2
+    PDM_I2C2_Init();            // 第二条传感器总线，CubeMX 中没有配置
+#endif
+
+    // 按故障 > 采样 > I2C > CAN > UART 重新设置中断优先级（CubeMX 生成的代码全部为 0）
+    PDM_Irq_Init();
+#if PDM_CFG_CAPTURE && PDM_CFG_CAPTURE_BOOT
+    PDM_Monitor_BootCapture();  // 上电冲击电流：I2C 可用后立即开始，与后面的初始化同时进行
+#endif
+
+    // 接收过滤器在 PDM_Cmd_Init() 中按节点号配置（节点号在 PDM_Monitor_Init() 中确定），
+    // 配置之前没有启用的过滤器组，所有报文由硬件丢弃
 
-    // 2. 启动CAN外设进入正常工作模式
+    // 启动CAN外设进入正常工作模式
     if (HAL_CAN_Start(&hcan) != HAL_OK)
     {
       Error_Handler();
     }
 
-    // 注意：因为不需要接收数据，所以在此处不需要调用 HAL_CAN_ActivateNotification 开启接收中断。
+    // 接收中断在 PDM_Can_Init() 中开启
 
+    PDM_Pool_Init();            // 日志和 CAN 发送队列从内存池取块
+    PDM_Log_Init();
+#if PDM_CFG_BENCH
+    PDM_Bench_Run(PDM_CFG_BENCH_ITER);  // 在采集启动之前运行，见 pdm_bench.h
+#endif
     PDM_Monitor_Init();
+    PDM_Cmd_Init();             // 接收过滤器
+#if PDM_CFG_RTOS
+    PDM_Rtos_Start();           // 不返回，主循环由三个任务代替
+#endif
   /* USER CODE END 2 */
 
   /* Infinite loop */
@@ -191,6 +213,9 @@ void Error_Handler(void)
 {
   /* USER CODE BEGIN Error_Handler_Debug */
   /* User can add his own implementation to report the HAL error return state */
+#if PDM_CFG_CRASH
+  PDM_Crash_Error(PDM_CRASH_ERROR, (uint32_t)__builtin_return_address(0));
+#endif
   __disable_irq();
   while (1)
   {
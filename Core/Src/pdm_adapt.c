@@ -0,0 +1,154 @@
+#include "pdm_adapt.h"
+
+#if PDM_CFG_ADAPT
+
+#include "pdm_calc.h"
+#include "pdm_param.h"
+#include "ina226_async.h"
+
+typedef struct {
+    uint8_t level;              /* 芯片当前的档位 */
+    uint8_t target;             /* 需要切换到的档位 */
+    uint8_t max_level;
+    uint8_t have_prev;
+    ina226_avg_t normal_avg;
+    int32_t prev_uA;
+    uint32_t calm_ms;           /* 变化率连续低于平稳门限的时间 */
+    uint32_t hold_ms;           /* 距上一次快速变化的时间 */
+} adapt_t;
+
+static adapt_t g_adapt[PDM_CFG_CHANNELS];
+
+static ina226_avg_t level_avg(const adapt_t *a, uint8_t level)
+{
+    switch (level)
+    {
+    case PDM_ADAPT_FAST:
+        return INA226_AVG_4;
+    case PDM_ADAPT_STEADY:
+        return INA226_AVG_64;
+    default:
+        return a->normal_avg;
+    }
+}
+
+void PDM_Adapt_Init(uint8_t ch, ina226_avg_t normal_avg, uint8_t max_level)
+{
+    adapt_t *a = &g_adapt[ch];
+
+    a->normal_avg = normal_avg;
+    a->max_level = max_level;
+    PDM_Adapt_Reset(ch);
+}
+
+void PDM_Adapt_Reset(uint8_t ch)
+{
+    adapt_t *a = &g_adapt[ch];
+
+    a->level = PDM_ADAPT_NORMAL;
+    a->target = PDM_ADAPT_NORMAL;
+    a->have_prev = 0;
+    a->calm_ms = 0;
+    a->hold_ms = 0;
+}
+
+static uint32_t add_sat(uint32_t t, uint32_t dt)
+{
+    return (t > UINT32_MAX - dt) ? UINT32_MAX : t + dt;
+}
+
+uint8_t PDM_Adapt_Add(uint8_t ch, int32_t current_uA, uint32_t dt_ms)
+{
+    adapt_t *a = &g_adapt[ch];
+    uint32_t diff, rate;
+
+    if (!a->have_prev)
+    {
+        a->have_prev = 1;
+        a->prev_uA = current_uA;
+        return (uint8_t)(a->target != a->level);
+    }
+
+    diff = (current_uA > a->prev_uA) ? (uint32_t)(current_uA - a->prev_uA)
+                                     : (uint32_t)(a->prev_uA - current_uA);
+    a->prev_uA = current_uA;
+    rate = diff / (dt_ms ? dt_ms : 1u);         /* uA/ms 即 mA/s */
+
+    if (rate >= PDM_CFG_ADAPT_FAST_MA_S)
+    {
+        a->target = PDM_ADAPT_FAST;
+        a->hold_ms = 0;
+        a->calm_ms = 0;
+    }
+    else
+    {
+        a->hold_ms = add_sat(a->hold_ms, dt_ms);
+        a->calm_ms = (rate < PDM_CFG_ADAPT_STEADY_MA_S) ? add_sat(a->calm_ms, dt_ms) : 0;
+
+        if (a->target == PDM_ADAPT_FAST)
+        {
+            if (a->hold_ms >= PDM_CFG_ADAPT_HOLD_MS)
+            {
+                a->target = PDM_ADAPT_NORMAL;
+            }
+        }
+        else if (a->calm_ms >= PDM_CFG_ADAPT_STEADY_MS)
+        {
+            a->target = (a->max_level >= PDM_ADAPT_STEADY) ? PDM_ADAPT_STEADY : PDM_ADAPT_NORMAL;
+        }
+        else if (a->calm_ms == 0)
+        {
+            a->target = PDM_ADAPT_NORMAL;
+        }
+    }
+    return (uint8_t)(a->target != a->level);
+}
+
+uint8_t PDM_Adapt_Apply(uint8_t ch, const ina226_handle_t *h)
+{
+    adapt_t *a = &g_adapt[ch];
+    uint16_t conf;
+    uint8_t buf[2];
+
+    if (a->target == a->level)
+    {
+        return 0;
+    }
+
+    /* 只改平均次数，转换时间和测量模式不变。同步触发模式下这次写入会多启动一次转换，
+     * 下一次触发时重新开始，不影响结果 */
+    conf = pdm_calc_conf(level_avg(a, a->target), (ina226_conversion_time_t)PDM_Param_Get()->bus_ct,
+                         (ina226_conversion_time_t)PDM_Param_Get()->shunt_ct,
+                         PDM_CFG_SYNC_TRIGGER ? INA226_MODE_SHUNT_BUS_VOLTAGE_TRIGGERED
+                                              : INA226_MODE_SHUNT_BUS_VOLTAGE_CONTINUOUS);
+    buf[0] = (uint8_t)(conf >> 8);
+    buf[1] = (uint8_t)(conf & 0xFF);
+    if (ina226_interface_iic_write(h->iic_addr, INA226_REG_CONF, buf, 2) != 0)
+    {
+        return 1;
+    }
+    a->level = a->target;
+    return 0;
+}
+
+uint8_t PDM_Adapt_Level(uint8_t ch)
+{
+    return g_adapt[ch].level;
+}
+
+ina226_avg_t PDM_Adapt_Avg(uint8_t ch)
+{
+    const adapt_t *a = &g_adapt[ch];
+
+    return level_avg(a, a->level);
+}
+
+uint32_t PDM_Adapt_WindowUs(uint8_t ch)
+{
+    const adapt_t *a = &g_adapt[ch];
+
+    return pdm_calc_window_us(level_avg(a, a->level), (ina226_conversion_time_t)PDM_Param_Get()->bus_ct,
+                              (ina226_conversion_time_t)PDM_Param_Get()->shunt_ct);
+}
+
+#endif /* PDM_CFG_ADAPT */
@@ -0,0 +1,52 @@
+#include "pdm_alert.h"
+#include "pdm_capture.h"
+#include "pdm_protect.h"
+#include "pdm_rtos.h"
+#include "pdm_timer.h"
+
+/* 转换完成通知（EXTI 中断中置位） */
+static volatile uint8_t g_flag[PDM_ALERT_PINS];
+
+void PDM_Alert_OnEdge(uint8_t n)
+{
+    if (n >= PDM_ALERT_PINS)
+    {
+        return;
+    }
+#if PDM_CFG_ALERT_CAPTURE
+    PDM_Timer_OnAlert(n);               /* 先取边沿时间，保护和采样都会用到 */
+#endif
+    g_flag[n] = 1;
+#if PDM_CFG_PROTECT
+    PDM_Protect_OnAlert(n);
+#endif
+#if PDM_CFG_CAPTURE
+    PDM_Capture_OnAlert(n);
+#endif
+#if PDM_CFG_RTOS
+    PDM_Rtos_Wake(PDM_RTOS_WAKE_ACQ);
+#endif
+}
+
+uint8_t PDM_Alert_Take(uint8_t ch, uint32_t *ts_us)
+{
+    if (ch >= PDM_ALERT_PINS || !g_flag[ch])
+    {
+        return 0;
+    }
+#if PDM_CFG_ALERT_CAPTURE
+    *ts_us = PDM_Timer_AlertUs(ch);
+#else
+    (void)ts_us;
+#endif
+    g_flag[ch] = 0;
+    return 1;
+}
+
+void PDM_Alert_Clear(void)
+{
+    for (uint8_t i = 0; i < PDM_ALERT_PINS; i++)
+    {
+        g_flag[i] = 0;
+    }
+}
@@ -0,0 +1,136 @@
+#include "pdm_apply.h"
+#include "pdm_calc.h"
+#include "pdm_can.h"
+#include "pdm_cmd.h"
+#include "pdm_monitor.h"
+#include "pdm_node.h"
+#include "pdm_param.h"
+#include "pdm_step.h"
+#include "pdm_telem.h"
+#include "pdm_trip.h"
+#include <string.h>
+
+#define CH_COUNT    PDM_CFG_CHANNELS
+
+/* --- 运行参数的默认值：通道表和 pdm_config.h --- */
+static void param_defaults(pdm_param_t *p)
+{
+    memset(p, 0, sizeof(*p));
+    for (uint8_t i = 0; i < CH_COUNT; i++)
+    {
+        const pdm_channel_cfg_t *cfg = PDM_Monitor_Config(i);
+
+        p->shunt_uohm[i] = cfg->scale.shunt_uohm;
+        p->can_id[i] = cfg->can_id;
+        p->avg[i] = (uint8_t)cfg->avg;
+        p->trip_oc_ma[i] = PDM_CFG_TRIP_OC_MA;
+        p->trip_nom_ma[i] = PDM_CFG_TRIP_NOM_MA;
+        p->trip_i2t[i] = PDM_CFG_TRIP_I2T;
+        p->trip_uv_mv[i] = PDM_CFG_TRIP_UV_MV;
+        p->can_db_ma[i] = PDM_CFG_CAN_DEADBAND_MA;
+        p->step_ma[i] = PDM_CFG_STEP_MA;
+    }
+    p->bus_ct = (uint8_t)PDM_CFG_INA226_BUS_CT;
+    p->shunt_ct = (uint8_t)PDM_CFG_INA226_SHUNT_CT;
+    p->sample_ms = PDM_CFG_SAMPLE_PERIOD_MS;
+    p->can_ms = PDM_CFG_CAN_PERIOD_MS;
+    p->can_on_sample = PDM_CFG_CAN_ON_SAMPLE;
+    p->can_min_ms = PDM_CFG_CAN_CHANGE_MIN_MS;
+    p->can_max_ms = PDM_CFG_CAN_CHANGE_MAX_MS;
+    p->can_db_mv = PDM_CFG_CAN_DEADBAND_MV;
+    p->node = PDM_CFG_NODE_ID;
+}
+
+/* --- 参数整体检查：校准值在寄存器范围内，通道帧 ID 不与其他报文重复，加上节点偏移后仍是 11 位 --- */
+static uint8_t param_check(const pdm_param_t *p)
+{
+    uint32_t id_max = 0x7FFu;
+
+#if PDM_CFG_NODE
+    if (p->node == PDM_NODE_FROM_STRAP ? !PDM_CFG_NODE_STRAP : p->node >= PDM_CFG_NODE_MAX)
+    {
+        return 1;
+    }
+    /* 读跳线时按最大的跳线值 */
+    id_max -= (p->node == PDM_NODE_FROM_STRAP ? (1u << PDM_CFG_NODE_STRAP) - 1u : p->node) * PDM_CFG_NODE_STRIDE;
+#endif
+    for (uint8_t i = 0; i < CH_COUNT; i++)
+    {
+        uint64_t cal = PDM_CALC_CAL(p->shunt_uohm[i], PDM_Monitor_Config(i)->scale.current_ua_per_lsb);
+
+        if (cal < 1u || cal > 32767u || p->avg[i] > INA226_AVG_1024 || p->can_id[i] == 0 || p->can_id[i] > id_max)
+        {
+            return 1;
+        }
+        for (uint8_t j = 0; j < CH_COUNT; j++)
+        {
+            if (j != i && p->can_id[j] == p->can_id[i])
+            {
+                return 1;
+            }
+        }
+        /* 启动时报文表还是空的；运行中与通道帧及其 E2E 帧以外的报文比较 */
+        if (PDM_Telem_IdUsed(p->can_id[i]) || p->can_id[i] == PDM_CMD_CAN_ID || p->can_id[i] == PDM_CMD_REPLY_ID)
+        {
+            return 1;
+        }
+    }
+    return (uint8_t)(p->sample_ms < PDM_MONITOR_PERIOD_MIN || p->sample_ms > PDM_MONITOR_PERIOD_MAX ||
+                     (p->can_ms != 0 && p->can_ms < PDM_CAN_MIN_PERIOD_MS) ||
+                     (p->can_max_ms != 0 && (p->can_max_ms < PDM_CAN_MIN_PERIOD_MS || p->can_max_ms < p->can_min_ms)) ||
+                     p->bus_ct > INA226_CONVERSION_TIME_8P244_MS || p->shunt_ct > INA226_CONVERSION_TIME_8P244_MS);
+}
+
+/* --- 运行参数已修改：器件配置在下一组采样后写入，CAN 报文立即生效 --- */
+static void param_apply(const pdm_param_t *old)
+{
+    const pdm_param_t *p = PDM_Param_Get();
+    uint8_t ct = (uint8_t)(p->bus_ct != old->bus_ct || p->shunt_ct != old->shunt_ct);
+
+    for (uint8_t i = 0; i < CH_COUNT; i++)
+    {
+        if (ct || p->shunt_uohm[i] != old->shunt_uohm[i] || p->avg[i] != old->avg[i])
+        {
+            PDM_Monitor_Reconfigure(i);
+        }
+        if (p->can_id[i] != old->can_id[i])
+        {
+            PDM_Telem_SetChannelId(i, p->can_id[i]);
+        }
+    }
+#if PDM_CFG_TRIP
+    for (uint8_t i = 0; i < CH_COUNT; i++)
+    {
+        PDM_Trip_Config(i, &PDM_Monitor_Config(i)->scale);
+    }
+#endif
+#if PDM_CFG_STEP
+    for (uint8_t i = 0; i < CH_COUNT; i++)
+    {
+        if (p->step_ma[i] != old->step_ma[i])
+        {
+            PDM_Step_Init(i, &PDM_Monitor_Config(i)->scale);
+        }
+    }
+#endif
+    if (p->sample_ms != old->sample_ms)
+    {
+        (void)PDM_Monitor_SetSamplePeriod(p->sample_ms);
+    }
+    if (p->can_ms != old->can_ms || p->can_on_sample != old->can_on_sample)
+    {
+        PDM_Telem_FollowChannel(p->can_ms, p->can_on_sample);
+    }
+    if (p->can_min_ms != old->can_min_ms || p->can_max_ms != old->can_max_ms)
+    {
+        PDM_Telem_SetChange(p->can_min_ms, p->can_max_ms);
+    }
+}
+
+void PDM_Apply_Init(void)
+{
+    pdm_param_t def;
+
+    param_defaults(&def);
+    (void)PDM_Param_Init(&def, param_check, param_apply);
+}
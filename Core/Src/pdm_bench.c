@@ -0,0 +1,231 @@
+#include "pdm_bench.h"
+
+#if PDM_CFG_BENCH
+
+#include "pdm_calc.h"
+#include "pdm_filter.h"
+#include "pdm_log.h"
+#include "pdm_monitor.h"
+#include "pdm_sensor.h"
+#include "pdm_stats.h"
+#include "pdm_store.h"
+#include "pdm_telem.h"
+#include "stm32f1xx_hal.h"
+#include <stdio.h>
+#include <string.h>
+
+#define FLUSH_MS        50              /* 每行输出后等待发送，表格不受日志块上限影响 */
+
+/* make bench 传入实际的优化选项 */
+#ifndef PDM_BENCH_OPT
+#define PDM_BENCH_OPT   "?"
+#endif
+
+typedef struct {
+    const char *name;
+    void (*op)(void);
+} bench_op_t;
+
+/* 默认采样电阻下约 12 V、2 A：分流 8 mV，电流寄存器 4000，功率 = 电流 x 总线 / 20000 */
+static const uint8_t g_raw[INA226_READ_REGS][2] = {
+    { 0x04, 0x08 },                     /* MASK：CVRF */
+    { 0x0C, 0x80 },                     /* 分流 3200 x 2.5 uV */
+    { 0x25, 0x80 },                     /* 总线 9600 x 1.25 mV */
+    { 0x0F, 0xA0 },                     /* 电流 4000 */
+    { 0x07, 0x80 },                     /* 功率 1920 */
+};
+
+static const pdm_scale_t g_sc = PDM_CALC_SCALE(PDM_SHUNT_UOHM, PDM_CURRENT_UA_PER_LSB);
+
+static ina226_read_job_t g_job;
+static pdm_sensor_sample_t g_smp;
+static ina226_regs_t g_filt;
+static uint64_t g_e, g_dis, g_chg;
+static uint8_t g_frame[8];
+static char g_text[96];
+static uint8_t g_rec[PDM_STORE_REC_SIZE];
+static uint8_t g_payload[PDM_STORE_PAYLOAD];
+static volatile int32_t g_sink;         /* 防止结果不用时整段被优化掉 */
+
+static void op_empty(void)
+{
+}
+
+static void op_decode(void)
+{
+    g_sink = PDM_Sensor_Decode(PDM_SENSOR_INA226, &g_job, &g_smp);
+}
+
+static void op_convert(void)
+{
+    ina226_regs_t s = g_smp.reg;
+    int32_t p;
+
+    pdm_calc_trim_offset(&s.shunt, &s.current, &s.power, s.bus, 3, g_sc.cal);
+    p = pdm_calc_power_signed(s.current, s.bus);
+    pdm_calc_energy_add(&g_e, s.power, 1000u, &g_sc);
+    pdm_calc_energy_add_dir(&g_dis, &g_chg, p, p, 1000u, UINT32_MAX, &g_sc);
+    g_sink = pdm_calc_bus_mV(s.bus) + pdm_calc_current_uA(s.current, &g_sc)
+             + (int32_t)pdm_calc_power_uW(s.power, &g_sc) + (int32_t)pdm_calc_energy_uWh(g_e, &g_sc)
+             + (int32_t)pdm_calc_energy_uWh(g_dis, &g_sc);
+}
+
+static void op_filter(void)
+{
+#if PDM_CFG_FILTER
+    PDM_Filter_Apply(0, &g_smp.reg, &g_filt);
+#else
+    g_filt = g_smp.reg;
+#endif
+}
+
+static void op_stats(void)
+{
+    PDM_Stats_Add(0, g_smp.reg.current, g_smp.reg.bus, g_smp.reg.power);
+}
+
+static void op_sample(void)
+{
+    op_decode();
+    op_convert();
+    op_filter();
+    op_stats();
+}
+
+static void op_can_encode(void)
+{
+    PDM_Telem_EncodeChannel(0, g_frame, 1);
+}
+
+static void op_can_cached(void)
+{
+    PDM_Telem_EncodeChannel(0, g_frame, 0);
+}
+
+static void op_line_fixed(void)
+{
+    PDM_Log_Begin();
+    PDM_Log_Str("BUS: ");
+    PDM_Log_Int(12000);
+    PDM_Log_Str("mV ");
+    PDM_Log_Fixed(2000000, 1000, 1);
+    PDM_Log_Str("mA ");
+    PDM_Log_Fixed(24000000, 1000, 1);
+    PDM_Log_Str("mW ");
+    PDM_Log_Fixed(18000, 1000, 1);
+    PDM_Log_Str("mWh (1s rms ");
+    PDM_Log_Fixed(2010000, 1000, 1);
+    PDM_Log_Str("mA pk ");
+    PDM_Log_Fixed(24500000, 1000, 1);
+    PDM_Log_Str("mW)\r\n");
+    PDM_Log_Cancel();
+}
+
+static void op_line_printf(void)
+{
+    g_sink = snprintf(g_text, sizeof(g_text), "%s: %ldmV %ld.%ldmA %ld.%ldmW %ld.%ldmWh (1s rms %ld.%ldmA pk %ld.%ldmW)\r\n",
+                      "BUS", 12000L, 2000L, 0L, 24000L, 0L, 18L, 0L, 2010L, 0L, 24500L, 0L);
+}
+
+static void op_record(void)
+{
+    memset(g_rec, 0xFF, sizeof(g_rec));
+    memcpy(g_rec, g_payload, sizeof(g_payload));
+    g_sink = pdm_calc_crc16(g_rec, PDM_STORE_PAYLOAD + 4u);
+}
+
+static const bench_op_t g_ops[] = {
+    { "decode",      op_decode },
+    { "convert",     op_convert },
+    { "filter",      op_filter },
+    { "stats",       op_stats },
+    { "sample",      op_sample },
+    { "can_encode",  op_can_encode },
+    { "can_cached",  op_can_cached },
+    { "line_fixed",  op_line_fixed },
+    { "line_printf", op_line_printf },
+    { "record",      op_record },
+};
+
+/* --- n 次中每次的周期数（已扣除 overhead），*sum 为总和 --- */
+static void measure(void (*op)(void), uint32_t n, uint32_t overhead,
+                    uint32_t *min, uint32_t *max, uint64_t *sum)
+{
+    *min = UINT32_MAX;
+    *max = 0;
+    *sum = 0;
+    for (uint32_t k = 0; k < n; k++)
+    {
+        uint32_t primask = __get_PRIMASK();
+        uint32_t t0;
+        uint32_t c;
+
+        __disable_irq();
+        t0 = DWT->CYCCNT;
+        op();
+        c = DWT->CYCCNT - t0;
+        __set_PRIMASK(primask);
+
+        c = (c > overhead) ? c - overhead : 0;
+        if (c < *min) *min = c;
+        if (c > *max) *max = c;
+        *sum += c;
+    }
+}
+
+static void setup(void)
+{
+    memset(&g_job, 0, sizeof(g_job));
+    for (uint8_t r = 0; r < INA226_READ_REGS; r++)
+    {
+        g_job.raw[r][0] = g_raw[r][0];
+        g_job.raw[r][1] = g_raw[r][1];
+    }
+    g_job.n = INA226_READ_REGS;
+    (void)PDM_Sensor_Decode(PDM_SENSOR_INA226, &g_job, &g_smp);
+    g_e = g_dis = g_chg = 0;
+    for (uint32_t i = 0; i < sizeof(g_payload); i++)
+    {
+        g_payload[i] = (uint8_t)i;
+    }
+#if PDM_CFG_FILTER
+    PDM_Filter_Init(0);
+#endif
+    PDM_Stats_Init(0, &g_sc, HAL_GetTick());
+}
+
+void PDM_Bench_Run(uint32_t n)
+{
+    uint32_t overhead;
+    uint32_t max;
+    uint64_t sum;
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    if (n == 0)
+    {
+        n = 1;
+    }
+    setup();
+    measure(op_empty, n, 0, &overhead, &max, &sum);     /* 最小值为测量本身的开销 */
+
+    PDM_Log_Printf("bench gcc %s opt %s ramfunc %u flash ws %lu prefetch %u n %lu\r\n", __VERSION__,
+                   PDM_BENCH_OPT, (unsigned)PDM_CFG_RAMFUNC, (unsigned long)(FLASH->ACR & FLASH_ACR_LATENCY),
+                   (unsigned)((FLASH->ACR & FLASH_ACR_PRFTBS) != 0), (unsigned long)n);
+    PDM_Log_Printf("%-12s %8s %8s %8s %9s\r\n", "op", "min", "avg", "max", "avg_ns");
+    PDM_Log_Flush(FLUSH_MS);
+    for (uint8_t i = 0; i < sizeof(g_ops) / sizeof(g_ops[0]); i++)
+    {
+        uint32_t min;
+        uint32_t avg;
+
+        measure(g_ops[i].op, n, overhead, &min, &max, &sum);
+        avg = (uint32_t)(sum / n);
+        PDM_Log_Printf("%-12s %8lu %8lu %8lu %9lu\r\n", g_ops[i].name, (unsigned long)min, (unsigned long)avg,
+                       (unsigned long)max, (unsigned long)((uint64_t)avg * 1000000000u / SystemCoreClock));
+        PDM_Log_Flush(FLUSH_MS);
+    }
+}
+
+#endif /* PDM_CFG_BENCH */
@@ -0,0 +1,295 @@
+#include "pdm_blackbox.h"
+
+#if PDM_CFG_BLACKBOX
+
+#include "pdm_pack.h"
+#include "pdm_wdg.h"
+#include "stm32f1xx_hal.h"
+#include <string.h>
+
+#define BB_MAGIC        0x42424F58u     /* "BBOX" */
+#define BB_FIELDS       3u              /* 时间、电流、总线电压 */
+#define BB_HDR_LEN      (10u + 4u * PDM_CFG_CHANNELS)
+
+/* 一条记录的最大长度：长度、通道 + 时间块 + 两个 16 位字段块 */
+#define BB_REC_MAX      (2u + PDM_PACK_MAX_BYTES + 2u * PDM_PACK_MAX_BYTES_16)
+
+_Static_assert(BB_REC_MAX <= 255u, "record length must fit in one byte");
+_Static_assert(PDM_CFG_BLACKBOX_BYTES >= 4u * BB_REC_MAX && PDM_CFG_BLACKBOX_BYTES <= 0xFFFFu,
+               "PDM_CFG_BLACKBOX_BYTES out of range");
+
+/* 整个结构放在 .noinit：启动代码只清零 .bss、复制 .data，这里的内容在热复位后保留。
+ * 链接脚本中没有单独定义时作为孤立段放在 .bss 之后（NOBITS，不占 flash） */
+typedef struct {
+    uint32_t magic;
+    uint16_t tail;                      /* 最旧记录的位置 */
+    uint16_t used;
+    uint8_t state;
+    uint8_t reason;
+    volatile uint8_t req;               /* 冻结请求（中断中写入），主循环完成冻结 */
+    uint32_t req_ms;
+    uint32_t lsb[PDM_CFG_CHANNELS];
+    pdm_pack_t enc[PDM_CFG_CHANNELS][BB_FIELDS];
+    uint8_t buf[PDM_CFG_BLACKBOX_BYTES];
+} bb_t;
+
+static bb_t g_bb __attribute__((section(".noinit")));
+static uint32_t g_lsb[PDM_CFG_CHANNELS];       /* 本次启动的电流 LSB，重新开始时写入 */
+
+static void put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)(v >> 8);
+    p[1] = (uint8_t)(v & 0xFF);
+}
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+    put_u16(p, (uint16_t)(v >> 16));
+    put_u16(p + 2, (uint16_t)(v & 0xFFFF));
+}
+
+static void bb_clear(void)
+{
+    g_bb.tail = 0;
+    g_bb.used = 0;
+    g_bb.state = PDM_BB_RECORDING;
+    g_bb.reason = PDM_BB_REASON_NONE;
+    g_bb.req = PDM_BB_REASON_NONE;
+    for (uint8_t ch = 0; ch < PDM_CFG_CHANNELS; ch++)
+    {
+        for (uint8_t f = 0; f < BB_FIELDS; f++)
+        {
+            PDM_Pack_Init(&g_bb.enc[ch][f]);
+        }
+    }
+    g_bb.magic = BB_MAGIC;
+}
+
+/* --- 检查保留下来的内容：位置在范围内，记录长度首尾相接正好等于 used --- */
+static uint8_t bb_valid(void)
+{
+    uint16_t pos;
+    uint32_t sum = 0;
+
+    if (g_bb.magic != BB_MAGIC || g_bb.tail >= PDM_CFG_BLACKBOX_BYTES ||
+        g_bb.used > PDM_CFG_BLACKBOX_BYTES || g_bb.state > PDM_BB_FROZEN)
+    {
+        return 0;
+    }
+    for (uint8_t ch = 0; ch < PDM_CFG_CHANNELS; ch++)
+    {
+        for (uint8_t f = 0; f < BB_FIELDS; f++)
+        {
+            if (PDM_Pack_Count(&g_bb.enc[ch][f]) > PDM_PACK_BLOCK)
+            {
+                return 0;
+            }
+        }
+    }
+    pos = g_bb.tail;
+    while (sum < g_bb.used)
+    {
+        uint8_t len = g_bb.buf[pos];
+
+        if (len < 2u || len > BB_REC_MAX)
+        {
+            return 0;
+        }
+        sum += len;
+        pos = (uint16_t)((pos + len) % PDM_CFG_BLACKBOX_BYTES);
+    }
+    return (uint8_t)(sum == g_bb.used);
+}
+
+/* --- 写入一条记录，空间不够时丢掉最旧的记录 --- */
+static void ring_put(const uint8_t *rec, uint8_t len)
+{
+    uint16_t head;
+    uint16_t first;
+
+    while (PDM_CFG_BLACKBOX_BYTES - g_bb.used < len)
+    {
+        uint8_t old = g_bb.buf[g_bb.tail];
+
+        g_bb.tail = (uint16_t)((g_bb.tail + old) % PDM_CFG_BLACKBOX_BYTES);
+        g_bb.used = (uint16_t)(g_bb.used - old);
+    }
+    head = (uint16_t)((g_bb.tail + g_bb.used) % PDM_CFG_BLACKBOX_BYTES);
+    first = (uint16_t)(PDM_CFG_BLACKBOX_BYTES - head);
+    if (first > len)
+    {
+        first = len;
+    }
+    memcpy(&g_bb.buf[head], rec, first);
+    memcpy(&g_bb.buf[0], &rec[first], (size_t)(len - first));
+    g_bb.used = (uint16_t)(g_bb.used + len);
+}
+
+/* --- 把一个通道编码器中的样本（满一块或不足一块）写成一条记录 --- */
+static void flush_channel(uint8_t ch)
+{
+    uint8_t rec[BB_REC_MAX];
+    uint8_t len = 2;
+
+    if (PDM_Pack_Count(&g_bb.enc[ch][0]) == 0)
+    {
+        return;
+    }
+    for (uint8_t f = 0; f < BB_FIELDS; f++)
+    {
+        len = (uint8_t)(len + PDM_Pack_Flush(&g_bb.enc[ch][f], &rec[len]));
+    }
+    rec[0] = len;
+    rec[1] = ch;
+    ring_put(rec, len);
+}
+
+/* --- 完成冻结：写出各通道不足一块的样本 --- */
+static void bb_freeze_now(uint8_t reason)
+{
+    for (uint8_t ch = 0; ch < PDM_CFG_CHANNELS; ch++)
+    {
+        flush_channel(ch);
+    }
+    g_bb.reason = reason;
+    g_bb.state = PDM_BB_FROZEN;
+}
+
+/* --- 有冻结请求且已过了故障后的记录时间时冻结 --- */
+static void bb_check_req(void)
+{
+    uint8_t req = g_bb.req;
+
+    if (g_bb.state != PDM_BB_RECORDING || req == PDM_BB_REASON_NONE)
+    {
+        return;
+    }
+    if (req != PDM_BB_REASON_FAULT || HAL_GetTick() - g_bb.req_ms >= PDM_CFG_BLACKBOX_POST_MS)
+    {
+        bb_freeze_now(req);
+    }
+}
+
+/* --- Public API --- */
+
+void PDM_Blackbox_Init(const uint32_t *current_ua_per_lsb, uint8_t reset_cause)
+{
+    memcpy(g_lsb, current_ua_per_lsb, sizeof(g_lsb));
+    if (bb_valid())
+    {
+        if (g_bb.state == PDM_BB_RECORDING)
+        {
+            if (g_bb.req != PDM_BB_REASON_NONE)
+            {
+                bb_freeze_now(g_bb.req);        /* 请求后、冻结前就复位了 */
+            }
+            else if (reset_cause & (PDM_RESET_IWDG | PDM_RESET_WWDG))
+            {
+                g_bb.req_ms = 0xFFFFFFFFu;      /* 复位前的时间未知（最后一条记录即复位时刻） */
+                bb_freeze_now(PDM_BB_REASON_WDG);
+            }
+        }
+        if (g_bb.state == PDM_BB_FROZEN)
+        {
+            return;
+        }
+    }
+    bb_clear();
+    memcpy(g_bb.lsb, g_lsb, sizeof(g_bb.lsb));
+}
+
+void PDM_Blackbox_Add(uint8_t ch, uint32_t tick_ms, int16_t current, uint16_t bus)
+{
+    pdm_pack_t *enc;
+
+    bb_check_req();
+    if (g_bb.state != PDM_BB_RECORDING || ch >= PDM_CFG_CHANNELS)
+    {
+        return;
+    }
+    enc = g_bb.enc[ch];
+    (void)PDM_Pack_Put(&enc[0], tick_ms);
+    (void)PDM_Pack_Put(&enc[1], (uint32_t)(int32_t)current);
+    if (PDM_Pack_Put(&enc[2], bus))
+    {
+        flush_channel(ch);
+    }
+}
+
+void PDM_Blackbox_Freeze(uint8_t reason)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    if (g_bb.state == PDM_BB_RECORDING && g_bb.req == PDM_BB_REASON_NONE)
+    {
+        g_bb.req_ms = HAL_GetTick();
+        g_bb.req = reason;
+    }
+    __set_PRIMASK(primask);
+}
+
+void PDM_Blackbox_Restart(void)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    bb_clear();
+    memcpy(g_bb.lsb, g_lsb, sizeof(g_bb.lsb));
+    __set_PRIMASK(primask);
+}
+
+void PDM_Blackbox_GetStatus(pdm_bb_status_t *st)
+{
+    bb_check_req();
+    st->state = g_bb.state;
+    st->reason = (g_bb.state == PDM_BB_FROZEN) ? g_bb.reason : g_bb.req;
+    st->used = g_bb.used;
+    st->freeze_ms = g_bb.req_ms;
+}
+
+uint32_t PDM_Blackbox_Size(void)
+{
+    bb_check_req();
+    if (g_bb.state != PDM_BB_FROZEN)
+    {
+        return 0;
+    }
+    return BB_HDR_LEN + g_bb.used;
+}
+
+uint8_t PDM_Blackbox_Read(uint32_t off, uint8_t *buf, uint8_t n)
+{
+    uint32_t size = PDM_Blackbox_Size();
+    uint8_t hdr[BB_HDR_LEN];
+
+    if (size == 0 || off > size || n > size - off)
+    {
+        return 1;
+    }
+    hdr[0] = g_bb.state;
+    hdr[1] = g_bb.reason;
+    hdr[2] = PDM_CFG_CHANNELS;
+    hdr[3] = 0;
+    put_u32(&hdr[4], g_bb.req_ms);
+    put_u16(&hdr[8], g_bb.used);
+    for (uint8_t ch = 0; ch < PDM_CFG_CHANNELS; ch++)
+    {
+        put_u32(&hdr[10 + 4 * ch], g_bb.lsb[ch]);
+    }
+
+    for (uint8_t k = 0; k < n; k++, off++)
+    {
+        if (off < BB_HDR_LEN)
+        {
+            buf[k] = hdr[off];
+        }
+        else
+        {
+            buf[k] = g_bb.buf[(g_bb.tail + off - BB_HDR_LEN) % PDM_CFG_BLACKBOX_BYTES];
+        }
+    }
+    return 0;
+}
+
+#endif /* PDM_CFG_BLACKBOX */
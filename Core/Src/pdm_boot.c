@@ -0,0 +1,38 @@
+#include "pdm_boot.h"
+
+#if PDM_CFG_BOOT
+
+#include "pdm_node.h"
+#include "stm32f1xx_hal.h"
+
+static volatile uint8_t g_req;
+static uint32_t g_req_ms;
+
+void PDM_Boot_Request(void)
+{
+    g_req_ms = HAL_GetTick();
+    g_req = 1;
+}
+
+void PDM_Boot_Poll(uint32_t now)
+{
+    if (!g_req || now - g_req_ms < PDM_CFG_BOOT_DELAY_MS)
+    {
+        return;
+    }
+
+    /* 备份寄存器在复位后保留，引导程序按其中的节点号收发 */
+    __HAL_RCC_PWR_CLK_ENABLE();
+    __HAL_RCC_BKP_CLK_ENABLE();
+    HAL_PWR_EnableBkUpAccess();
+    BKP->DR1 = PDM_BOOT_REQ_MAGIC;
+#if PDM_CFG_NODE
+    BKP->DR2 = PDM_Node_Id();
+#else
+    BKP->DR2 = 0;
+#endif
+    HAL_PWR_DisableBkUpAccess();
+    NVIC_SystemReset();
+}
+
+#endif /* PDM_CFG_BOOT */
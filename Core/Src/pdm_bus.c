@@ -0,0 +1,94 @@
+#include "pdm_bus.h"
+#include "pdm_log.h"
+#include "pdm_ramfunc.h"
+#include "pdm_sched.h"
+#include <string.h>
+
+static const pdm_bus_sub_t *g_subs;
+static uint8_t g_sub_count;
+static uint8_t g_decim[PDM_BUS_MAX_SUBS];
+static uint8_t g_left[PDM_BUS_MAX_SUBS][PDM_CFG_CHANNELS];     /* 距下一次调用的事件数，GROUP 只用 [0] */
+static pdm_bus_stat_t g_stat[PDM_BUS_MAX_SUBS];
+
+static const char *const g_type_name[] = { "sample", "group" };
+
+void PDM_Bus_Init(const pdm_bus_sub_t *subs, uint8_t count)
+{
+    if (count > PDM_BUS_MAX_SUBS)
+    {
+        count = PDM_BUS_MAX_SUBS;
+    }
+    g_subs = subs;
+    g_sub_count = count;
+    memset(g_stat, 0, sizeof(g_stat));
+    memset(g_left, 0, sizeof(g_left));              /* 第一个事件就调用 */
+    for (uint8_t i = 0; i < count; i++)
+    {
+        g_decim[i] = subs[i].decim;
+    }
+}
+
+PDM_RAMFUNC void PDM_Bus_Publish(const pdm_bus_event_t *ev)
+{
+    uint8_t key = (ev->type == PDM_BUS_EV_SAMPLE && ev->ch < PDM_CFG_CHANNELS) ? ev->ch : 0;
+
+    for (uint8_t i = 0; i < g_sub_count; i++)
+    {
+        const pdm_bus_sub_t *s = &g_subs[i];
+        uint32_t t0;
+        uint32_t dt;
+
+        if (s->type != ev->type || g_decim[i] == 0)
+        {
+            continue;
+        }
+        if (g_left[i][key] != 0)
+        {
+            g_left[i][key]--;
+            continue;
+        }
+        g_left[i][key] = (uint8_t)(g_decim[i] - 1u);
+
+        t0 = PDM_Sched_NowUs();
+        s->on_event(ev);
+        dt = PDM_Sched_NowUs() - t0;
+        g_stat[i].calls++;
+        if (dt > g_stat[i].max_us)
+        {
+            g_stat[i].max_us = dt;
+        }
+    }
+}
+
+uint8_t PDM_Bus_SetDecim(uint8_t i, uint8_t decim)
+{
+    if (i >= g_sub_count)
+    {
+        return 1;
+    }
+    g_decim[i] = decim;
+    memset(g_left[i], 0, sizeof(g_left[i]));
+    return 0;
+}
+
+uint8_t PDM_Bus_Find(const char *name)
+{
+    for (uint8_t i = 0; i < g_sub_count; i++)
+    {
+        if (strcmp(g_subs[i].name, name) == 0)
+        {
+            return i;
+        }
+    }
+    return 0xFF;
+}
+
+void PDM_Bus_Print(void)
+{
+    for (uint8_t i = 0; i < g_sub_count; i++)
+    {
+        PDM_Log_Printf("%u %s on %s decim %u calls %lu max %lu us\r\n", i, g_subs[i].name,
+                       g_type_name[g_subs[i].type], g_decim[i], (unsigned long)g_stat[i].calls,
+                       (unsigned long)g_stat[i].max_us);
+    }
+}
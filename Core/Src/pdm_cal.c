@@ -0,0 +1,152 @@
+#include "pdm_cal.h"
+
+#if PDM_CFG_CAL
+
+#include "pdm_calc.h"
+#include "pdm_can.h"
+#include "pdm_cmd.h"
+#include "pdm_log.h"
+#include "pdm_param.h"
+
+#define REF_MIN_RAW         400         /* 参考点平均分流电压至少 1 mV */
+#define REF_MAX_DEV_PCT     20          /* 与当前电阻的最大偏差 */
+
+typedef struct {
+    uint8_t busy;
+    uint8_t point;
+    uint16_t n;
+    int32_t ref_mA;
+    int32_t sum;
+    uint8_t done;               /* 1: 有最近一次结果 */
+    uint8_t last_point;
+    uint8_t last_res;
+    int32_t last_value;
+} cal_t;
+
+static cal_t g_cal[PDM_CFG_CHANNELS];
+
+static void put_be32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+/* --- 平均值四舍五入（向远离 0 的方向进位） --- */
+static int32_t avg_round(int32_t sum, int32_t n)
+{
+    return (sum >= 0) ? (sum + n / 2) / n : (sum - n / 2) / n;
+}
+
+/* --- 零点：平均值即为修正量 --- */
+static uint8_t finish_zero(uint8_t ch, const cal_t *c, int32_t *value)
+{
+    *value = avg_round(c->sum, c->n);
+    return PDM_Param_Set((uint8_t)(PDM_PARAM_OFFSET + ch), (uint32_t)*value);
+}
+
+/* --- 参考点：R (uOhm) = 分流电压 (nV) / 电流 (mA) --- */
+static uint8_t finish_ref(uint8_t ch, const cal_t *c, int32_t *value)
+{
+    const pdm_param_t *p = PDM_Param_Get();
+    int64_t net = (int64_t)c->sum - (int64_t)p->offset[ch] * c->n;
+    int64_t r;
+    uint32_t cur = p->shunt_uohm[ch];
+
+    *value = 0;
+    if ((net < 0 ? -net : net) < (int64_t)REF_MIN_RAW * c->n)
+    {
+        return 1;
+    }
+    r = (net * PDM_SHUNT_NV_PER_LSB + (int64_t)c->n * c->ref_mA / 2) / ((int64_t)c->n * c->ref_mA);
+    if (r <= 0 || (uint64_t)r * 100u < (uint64_t)cur * (100u - REF_MAX_DEV_PCT) ||
+        (uint64_t)r * 100u > (uint64_t)cur * (100u + REF_MAX_DEV_PCT))
+    {
+        return 1;
+    }
+    *value = (int32_t)r;
+    return PDM_Param_Set((uint8_t)(PDM_PARAM_SHUNT_UOHM + ch), (uint32_t)r);
+}
+
+uint8_t PDM_Cal_Start(uint8_t ch, uint8_t point, int32_t ref_mA)
+{
+    cal_t *c;
+
+    if (ch >= PDM_CFG_CHANNELS || point > PDM_CAL_REF || (point == PDM_CAL_REF && ref_mA == 0))
+    {
+        return 1;
+    }
+    c = &g_cal[ch];
+    if (c->busy)
+    {
+        return 1;
+    }
+    c->point = point;
+    c->ref_mA = ref_mA;
+    c->sum = 0;
+    c->n = 0;
+    c->busy = 1;
+    return 0;
+}
+
+void PDM_Cal_Add(uint8_t ch, int16_t shunt_raw)
+{
+    cal_t *c = &g_cal[ch];
+    uint8_t data[8];
+    int32_t value;
+
+    if (!c->busy)
+    {
+        return;
+    }
+    c->sum += shunt_raw;
+    if (++c->n < PDM_CFG_CAL_SAMPLES)
+    {
+        return;
+    }
+
+    c->busy = 0;
+    c->last_res = (c->point == PDM_CAL_ZERO) ? finish_zero(ch, c, &value) : finish_ref(ch, c, &value);
+    c->last_point = c->point;
+    c->last_value = value;
+    c->done = 1;
+
+    data[0] = PDM_CMD_CAL;
+    data[1] = c->last_res;
+    data[2] = ch;
+    data[3] = c->point;
+    put_be32(&data[4], (uint32_t)value);
+    (void)PDM_Can_Send(PDM_CMD_REPLY_ID, data, 8);
+    PDM_Log_Printf("cal %u %s: %s %ld\r\n", ch, (c->point == PDM_CAL_ZERO) ? "zero" : "ref",
+                   c->last_res ? "FAIL" : "OK", (long)value);
+}
+
+void PDM_Cal_Print(void)
+{
+    const pdm_param_t *p = PDM_Param_Get();
+
+    for (uint8_t i = 0; i < PDM_CFG_CHANNELS; i++)
+    {
+        const cal_t *c = &g_cal[i];
+
+        if (c->busy)
+        {
+            PDM_Log_Printf("cal %u offset %d shunt %lu uOhm, %s running %u/%u\r\n", i, p->offset[i],
+                           (unsigned long)p->shunt_uohm[i], (c->point == PDM_CAL_ZERO) ? "zero" : "ref",
+                           c->n, (unsigned)PDM_CFG_CAL_SAMPLES);
+        }
+        else if (c->done)
+        {
+            PDM_Log_Printf("cal %u offset %d shunt %lu uOhm, last %s %s %ld\r\n", i, p->offset[i],
+                           (unsigned long)p->shunt_uohm[i], (c->last_point == PDM_CAL_ZERO) ? "zero" : "ref",
+                           c->last_res ? "FAIL" : "OK", (long)c->last_value);
+        }
+        else
+        {
+            PDM_Log_Printf("cal %u offset %d shunt %lu uOhm\r\n", i, p->offset[i], (unsigned long)p->shunt_uohm[i]);
+        }
+    }
+}
+
+#endif /* PDM_CFG_CAL */
@@ -0,0 +1,812 @@
+#include "pdm_can.h"
+#include "pdm_config.h"
+#include "can.h"
+#include "pdm_canhealth.h"
+#include "pdm_log.h"
+#include "pdm_node.h"
+#include "pdm_pool.h"
+#include "pdm_ramfunc.h"
+#include "pdm_rtos.h"
+#include "pdm_sched.h"
+#include <string.h>
+
+#define LOAD_WINDOW_MS      1000
+#define RXQ_LEN             (PDM_CFG_REPLAY ? 16 : 4)      /* 2 的幂；回放时记录帧连续到达 */
+
+/* 软件发送队列项（共享内存池的一块）：标识符寄存器值在入队时算好（已加上节点偏移，id 仍为节点 0 的 ID），
+ * 数据按邮箱寄存器的两个字保存 */
+typedef struct tx_item {
+    struct tx_item *next;
+    uint16_t id;
+    uint8_t dlc;
+    uint32_t tir;               /* STID << 21，标准数据帧 */
+#if PDM_CFG_CAN_LATENCY
+    uint32_t t_us;              /* 入队时间 */
+#endif
+    union {
+        uint8_t b[8];
+        uint32_t w[2];          /* 小端：b[0] 在 TDLR 低 8 位 */
+    } data;
+} tx_item_t;
+
+typedef struct {
+    uint16_t period_ms;
+    uint8_t on_sample;
+    uint8_t have_last;          /* last 有效 */
+    uint16_t min_ms;            /* 按变化发送的最短/最长间隔，max_ms 为 0 时按周期发送 */
+    uint16_t max_ms;
+    uint32_t next_due;
+    uint32_t last_ms;           /* 上次放入发送队列的时间 */
+    uint32_t last[2];           /* 上次放入发送队列的内容（keepalive_ms 非 0 时） */
+} msg_state_t;
+
+static const pdm_can_msg_t *g_msgs;
+static uint8_t g_msg_count;
+static msg_state_t g_state[PDM_CAN_MAX_MSGS];
+
+_Static_assert(sizeof(tx_item_t) <= PDM_POOL_BLOCK_SIZE, "tx_item_t larger than pool block");
+
+/* 发送队列链表，按 ID 从小到大排列（ID 小优先级高），相同 ID 按先后顺序 */
+static tx_item_t *g_txq;
+static volatile uint8_t g_txq_len;
+
+/* 接收队列，中断写 head，主循环写 tail */
+static pdm_can_frame_t g_rxq[RXQ_LEN];
+static volatile uint8_t g_rxq_head;
+static volatile uint8_t g_rxq_tail;
+
+static pdm_can_stats_t g_can_stats;
+static uint32_t g_bitrate;
+static uint32_t g_window_start;
+static uint32_t g_window_bits;
+
+#if PDM_CFG_CAN_LATENCY
+/* 放入邮箱的帧：入队时间、放入时间，probe 为放入时三个邮箱都空（不排在自己的帧后面） */
+typedef struct {
+    uint32_t t_enq;
+    uint32_t t_put;
+    uint16_t id;
+    uint8_t dlc;
+    uint8_t probe;
+} mb_slot_t;
+
+static mb_slot_t g_mb[3];
+static pdm_can_lat_t g_lat[PDM_CAN_MAX_MSGS + 1];      /* 最后一项为报文表以外的帧 */
+static uint32_t g_lat_hist[PDM_CAN_LAT_BINS];
+static uint16_t g_probe_n;      /* 本秒的 probe 帧数和其中等待过总线的帧数 */
+static uint16_t g_probe_busy;
+static uint32_t g_bit_ns;       /* 一位的时间 (ns) */
+#endif
+
+/* --- 由 MX_CAN_Init 的配置计算位速率 --- */
+static uint32_t can_bitrate(void)
+{
+    uint32_t tq = 1u + ((hcan.Init.TimeSeg1 >> CAN_BTR_TS1_Pos) + 1u) +
+                  ((hcan.Init.TimeSeg2 >> CAN_BTR_TS2_Pos) + 1u);
+
+    return HAL_RCC_GetPCLK1Freq() / (hcan.Init.Prescaler * tq);
+}
+
+/* --- 按当前配置估算负载，采样后发送的报文按采样周期计 --- */
+static void update_plan(void)
+{
+    uint32_t bits_per_s = 0;
+
+    for (uint8_t i = 0; i < g_msg_count; i++)
+    {
+        uint32_t bits = PDM_Can_FrameBits(g_msgs[i].dlc);
+
+        if (g_state[i].max_ms != 0)
+        {
+            /* 按变化发送：最坏每个采样或每 min_ms 一帧 */
+            uint32_t ms = (g_state[i].min_ms > PDM_CFG_SAMPLE_PERIOD_MS) ? g_state[i].min_ms : PDM_CFG_SAMPLE_PERIOD_MS;
+
+            bits_per_s += bits * 1000u / ms;
+            continue;
+        }
+        if (g_state[i].period_ms != 0)
+        {
+            bits_per_s += bits * 1000u / g_state[i].period_ms;
+        }
+        if (g_state[i].on_sample)
+        {
+            bits_per_s += bits * 1000u / PDM_CFG_SAMPLE_PERIOD_MS;
+        }
+    }
+    g_can_stats.plan_permille = (uint16_t)(bits_per_s * 1000u / g_bitrate);
+}
+
+/* send_msg() 的调用方式 */
+#define SEND_DUE            0       /* 周期到期或新采样 */
+#define SEND_FORCE          1       /* 总是发送 */
+#define SEND_POLL           2       /* CAN 任务检查按变化发送的报文的最短/最长间隔，不发送时不计数 */
+
+/* --- 编码并发送。按变化发送时由 changed 回调和最短/最长间隔决定；否则 keepalive_ms 非 0 时
+ * 内容与上次相同且未到保活时间不发送 --- */
+static void send_msg(uint8_t i, uint32_t now, uint8_t how)
+{
+    const pdm_can_msg_t *m = &g_msgs[i];
+    msg_state_t *st = &g_state[i];
+    uint32_t elapsed = now - st->last_ms;
+    uint8_t send;
+    union {
+        uint8_t b[8];
+        uint32_t w[2];
+    } data;
+
+    m->encode(data.b, m->arg);
+    if (m->keepalive_ms == 0 && st->max_ms == 0)
+    {
+        (void)PDM_Can_Send(m->id, data.b, m->dlc);
+        return;
+    }
+    if (m->dlc < 8)
+    {
+        memset(&data.b[m->dlc], 0, 8u - m->dlc);
+    }
+    if (how == SEND_FORCE || !st->have_last)
+    {
+        send = 1;
+    }
+    else if (st->max_ms != 0)
+    {
+        send = (uint8_t)(elapsed >= st->max_ms ||
+                         (elapsed >= st->min_ms && m->changed(data.b, (const uint8_t *)st->last, m->arg)));
+    }
+    else
+    {
+        send = (uint8_t)(data.w[0] != st->last[0] || data.w[1] != st->last[1] || elapsed >= m->keepalive_ms);
+    }
+    if (!send)
+    {
+        if (how != SEND_POLL)
+        {
+            g_can_stats.tx_unchanged++;
+        }
+        return;
+    }
+    if (PDM_Can_Send(m->id, data.b, m->dlc) == 0)
+    {
+        st->last[0] = data.w[0];
+        st->last[1] = data.w[1];
+        st->last_ms = now;
+        st->have_last = 1;
+    }
+}
+
+uint32_t PDM_Can_FrameBits(uint8_t dlc)
+{
+    /* 标准帧：SOF~CRC 共 34 + 8n 位参与填充，最坏每 4 位插 1 位；再加 CRC 界定符、ACK、EOF、帧间隔 13 位 */
+    uint32_t stuffed = 34u + 8u * dlc;
+
+    return stuffed + (stuffed - 1u) / 4u + 13u;
+}
+
+void PDM_Can_Init(const pdm_can_msg_t *msgs, uint8_t count, uint32_t now)
+{
+    if (count > PDM_CAN_MAX_MSGS)
+    {
+        count = PDM_CAN_MAX_MSGS;
+    }
+
+    g_msgs = msgs;
+    g_msg_count = count;
+    memset(&g_can_stats, 0, sizeof(g_can_stats));
+    while (g_txq != NULL)
+    {
+        tx_item_t *it = g_txq;
+
+        g_txq = it->next;
+        PDM_Pool_Free(PDM_POOL_CAN, it);
+    }
+    g_txq_len = 0;
+    g_rxq_head = 0;
+    g_rxq_tail = 0;
+    g_bitrate = can_bitrate();
+    g_window_start = now;
+    g_window_bits = 0;
+#if PDM_CFG_CAN_LATENCY
+    g_bit_ns = 1000000000u / g_bitrate;
+    PDM_Can_LatReset();
+#endif
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        g_state[i].period_ms = msgs[i].period_ms;
+        g_state[i].on_sample = msgs[i].on_sample;
+        g_state[i].next_due = now + msgs[i].period_ms;
+        g_state[i].have_last = 0;
+        g_state[i].min_ms = msgs[i].min_ms;
+        g_state[i].max_ms = (msgs[i].changed != NULL) ? msgs[i].max_ms : 0;
+    }
+    update_plan();
+
+    /* 邮箱发送完成时从队列补充；FIFO0 收到报文时放入接收队列 */
+    HAL_CAN_ActivateNotification(&hcan, CAN_IT_TX_MAILBOX_EMPTY | CAN_IT_RX_FIFO0_MSG_PENDING);
+
+    if (g_can_stats.plan_permille > PDM_CFG_CAN_LOAD_BUDGET)
+    {
+        PDM_Log_Printf("CAN plan load %u/1000 over budget %u\r\n",
+                       g_can_stats.plan_permille, (unsigned)PDM_CFG_CAN_LOAD_BUDGET);
+    }
+}
+
+void PDM_Can_Run(uint32_t now)
+{
+    for (uint8_t i = 0; i < g_msg_count; i++)
+    {
+        msg_state_t *st = &g_state[i];
+
+        if (st->max_ms != 0)
+        {
+            send_msg(i, now, SEND_POLL);
+            continue;
+        }
+        if (st->period_ms == 0 || (int32_t)(now - st->next_due) < 0)
+        {
+            continue;
+        }
+
+        st->next_due += st->period_ms;
+        if ((int32_t)(now - st->next_due) >= 0)
+        {
+            st->next_due = now + st->period_ms;     /* 落后一个周期以上时重新对齐，不补发 */
+        }
+        send_msg(i, now, SEND_DUE);
+    }
+
+    if (now - g_window_start >= LOAD_WINDOW_MS)
+    {
+        g_can_stats.bits_last_s = g_window_bits * LOAD_WINDOW_MS / (now - g_window_start);
+        g_can_stats.load_permille = (uint16_t)(g_can_stats.bits_last_s * 1000u / g_bitrate);
+        g_window_bits = 0;
+        g_window_start = now;
+#if PDM_CFG_CAN_LATENCY
+        {
+            uint32_t primask = __get_PRIMASK();
+
+            __disable_irq();
+            g_can_stats.busy_permille = (g_probe_n != 0) ? (uint16_t)(g_probe_busy * 1000u / g_probe_n) : 0;
+            g_probe_n = 0;
+            g_probe_busy = 0;
+            __set_PRIMASK(primask);
+        }
+#endif
+    }
+}
+
+void PDM_Can_OnSample(void)
+{
+    uint32_t now = HAL_GetTick();
+
+    for (uint8_t i = 0; i < g_msg_count; i++)
+    {
+        if (g_state[i].on_sample || g_state[i].max_ms != 0)
+        {
+            send_msg(i, now, SEND_DUE);
+        }
+    }
+}
+
+uint8_t PDM_Can_SetSchedule(uint32_t id, uint16_t period_ms, uint8_t on_sample)
+{
+    for (uint8_t i = 0; i < g_msg_count; i++)
+    {
+        if (g_msgs[i].id == id)
+        {
+            if (period_ms != 0 && period_ms < PDM_CAN_MIN_PERIOD_MS)
+            {
+                period_ms = PDM_CAN_MIN_PERIOD_MS;
+            }
+            g_state[i].period_ms = period_ms;
+            g_state[i].on_sample = on_sample;
+            g_state[i].next_due = HAL_GetTick() + period_ms;
+            update_plan();
+            return 0;
+        }
+    }
+    return 1;
+}
+
+uint8_t PDM_Can_SetChange(uint32_t id, uint16_t min_ms, uint16_t max_ms)
+{
+    for (uint8_t i = 0; i < g_msg_count; i++)
+    {
+        if (g_msgs[i].id == id)
+        {
+            if (g_msgs[i].changed == NULL)
+            {
+                return 1;
+            }
+            if (max_ms != 0 && max_ms < PDM_CAN_MIN_PERIOD_MS)
+            {
+                max_ms = PDM_CAN_MIN_PERIOD_MS;
+            }
+            g_state[i].min_ms = min_ms;
+            g_state[i].max_ms = max_ms;
+            update_plan();
+            return 0;
+        }
+    }
+    return 1;
+}
+
+uint8_t PDM_Can_SendNow(uint32_t id, uint32_t now)
+{
+    for (uint8_t i = 0; i < g_msg_count; i++)
+    {
+        if (g_msgs[i].id == id)
+        {
+            if (g_state[i].period_ms != 0)
+            {
+                g_state[i].next_due = now + g_state[i].period_ms;
+            }
+            send_msg(i, now, SEND_FORCE);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+#if PDM_CFG_CAN_DIRECT_TX
+/* --- 直接写空闲邮箱：TSR.CODE 给出下一个空邮箱，最后写 TIR 置 TXRQ 请求发送；*n 为邮箱号 --- */
+static PDM_RAMFUNC uint8_t mailbox_put(const tx_item_t *it, uint8_t *n)
+{
+    CAN_TypeDef *can = hcan.Instance;
+    uint32_t tsr = can->TSR;
+    CAN_TxMailBox_TypeDef *mb;
+
+    if ((tsr & (CAN_TSR_TME0 | CAN_TSR_TME1 | CAN_TSR_TME2)) == 0)
+    {
+        return 1;
+    }
+    *n = (uint8_t)((tsr & CAN_TSR_CODE) >> CAN_TSR_CODE_Pos);
+    mb = &can->sTxMailBox[*n];
+    mb->TDTR = it->dlc;
+    mb->TDLR = it->data.w[0];
+    mb->TDHR = it->data.w[1];
+    mb->TIR = it->tir | CAN_TI0R_TXRQ;
+    return 0;
+}
+#else
+static uint8_t mailbox_put(const tx_item_t *it, uint8_t *n)
+{
+    CAN_TxHeaderTypeDef hdr;
+    uint32_t mailbox;
+
+    if (HAL_CAN_GetTxMailboxesFreeLevel(&hcan) == 0)
+    {
+        return 1;
+    }
+    hdr.StdId = it->tir >> CAN_TI0R_STID_Pos;
+    hdr.ExtId = 0;
+    hdr.IDE = CAN_ID_STD;
+    hdr.RTR = CAN_RTR_DATA;
+    hdr.DLC = it->dlc;
+    hdr.TransmitGlobalTime = DISABLE;
+    if (HAL_CAN_AddTxMessage(&hcan, &hdr, it->data.b, &mailbox) != HAL_OK)
+    {
+        return 1;
+    }
+    *n = (uint8_t)(mailbox >> 1);       /* CAN_TX_MAILBOX0/1/2 = 1/2/4 */
+    return 0;
+}
+#endif
+
+/* --- 把队首的帧放入空闲邮箱，调用时必须关中断或在 CAN 中断中 --- */
+static PDM_RAMFUNC void txq_refill(void)
+{
+    while (g_txq != NULL)
+    {
+        tx_item_t *it = g_txq;
+        uint8_t n;
+#if PDM_CFG_CAN_LATENCY
+        uint8_t idle = (uint8_t)((hcan.Instance->TSR & (CAN_TSR_TME0 | CAN_TSR_TME1 | CAN_TSR_TME2)) ==
+                                 (CAN_TSR_TME0 | CAN_TSR_TME1 | CAN_TSR_TME2));
+#endif
+
+        if (mailbox_put(it, &n) != 0)
+        {
+            break;
+        }
+        g_can_stats.tx_frames++;
+#if PDM_CFG_CAN_LATENCY
+        g_mb[n].t_enq = it->t_us;
+        g_mb[n].t_put = PDM_Sched_NowUs();
+        g_mb[n].id = it->id;
+        g_mb[n].dlc = it->dlc;
+        g_mb[n].probe = idle;
+#else
+        (void)n;
+#endif
+
+        g_txq = it->next;
+        g_txq_len--;
+        PDM_Pool_Free(PDM_POOL_CAN, it);
+    }
+}
+
+/* --- 按 ID 插入发送队列并尝试立即放入邮箱；返回 0 成功，1 新帧被丢弃，2 挤掉了队尾 --- */
+static PDM_RAMFUNC uint8_t txq_push(uint32_t id, const uint8_t *data, uint8_t dlc)
+{
+    uint8_t res = 0;
+    tx_item_t *it;
+    tx_item_t **pp;
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+
+    it = (tx_item_t *)PDM_Pool_Alloc(PDM_POOL_CAN);
+    if (it == NULL)
+    {
+        /* 队列满或内存池没有可用块：新帧优先级比队尾高则挤掉队尾并用它的块，否则丢弃新帧 */
+        g_can_stats.tx_drops++;
+        pp = &g_txq;
+        while (*pp != NULL && (*pp)->next != NULL)
+        {
+            pp = &(*pp)->next;
+        }
+        if (*pp == NULL || id >= (*pp)->id)
+        {
+            __set_PRIMASK(primask);
+            return 1;
+        }
+        it = *pp;
+        *pp = NULL;
+        g_txq_len--;
+        res = 2;
+    }
+
+    it->id = (uint16_t)id;
+    it->dlc = dlc;
+    it->tir = (PDM_Node_TxId(id) << CAN_TI0R_STID_Pos) & CAN_TI0R_STID_Msk;
+#if PDM_CFG_CAN_LATENCY
+    it->t_us = PDM_Sched_NowUs();
+#endif
+    it->data.w[0] = 0;
+    it->data.w[1] = 0;
+    memcpy(it->data.b, data, dlc);
+
+    pp = &g_txq;
+    while (*pp != NULL && (*pp)->id <= id)
+    {
+        pp = &(*pp)->next;
+    }
+    it->next = *pp;
+    *pp = it;
+    g_txq_len++;
+
+    if (g_txq_len > g_can_stats.txq_hwm)
+    {
+        g_can_stats.txq_hwm = g_txq_len;
+    }
+    g_window_bits += PDM_Can_FrameBits(dlc);
+
+    txq_refill();
+    __set_PRIMASK(primask);
+    return res;
+}
+
+uint8_t PDM_Can_Send(uint32_t id, const uint8_t *data, uint8_t dlc)
+{
+    uint8_t res = txq_push(id, data, dlc);
+
+    if (res == 1)
+    {
+        PDM_Log_Printf("CAN TXQ full, drop 0x%03lX\r\n", (unsigned long)id);
+        return 1;
+    }
+    if (res == 2)
+    {
+        PDM_Log_Printf("CAN TXQ full, evict lower priority frame\r\n");
+    }
+    return 0;
+}
+
+uint8_t PDM_Can_SendFromIsr(uint32_t id, const uint8_t *data, uint8_t dlc)
+{
+    return (uint8_t)(txq_push(id, data, dlc) == 1);
+}
+
+/* --- 一个过滤器组：16 位列表模式，4 个 ID（STID 在 [15:5]，IDE = RTR = 0） --- */
+static void filter_bank(uint8_t bank, const uint16_t *id, uint8_t n)
+{
+    CAN_FilterTypeDef f;
+    uint32_t v[PDM_CAN_FILTER_PER_BANK];
+
+    for (uint8_t k = 0; k < PDM_CAN_FILTER_PER_BANK; k++)
+    {
+        v[k] = (uint32_t)id[(k < n) ? k : 0] << 5;
+    }
+    f.FilterBank = bank;
+    f.FilterMode = CAN_FILTERMODE_IDLIST;
+    f.FilterScale = CAN_FILTERSCALE_16BIT;
+    f.FilterIdLow = v[0];               /* 列表模式下掩码寄存器也是 ID */
+    f.FilterIdHigh = v[1];
+    f.FilterMaskIdLow = v[2];
+    f.FilterMaskIdHigh = v[3];
+    f.FilterFIFOAssignment = CAN_RX_FIFO0;
+    f.FilterActivation = (n != 0) ? ENABLE : DISABLE;
+    f.SlaveStartFilterBank = PDM_CAN_FILTER_BANKS;
+    if (HAL_CAN_ConfigFilter(&hcan, &f) != HAL_OK)
+    {
+        Error_Handler();
+    }
+}
+
+uint8_t PDM_Can_SetRxFilter(const uint16_t *ids, uint8_t n)
+{
+    uint16_t list[PDM_CAN_FILTER_BANKS * PDM_CAN_FILTER_PER_BANK];
+    uint8_t count = 0;
+    uint8_t res = 0;
+
+    for (uint8_t i = 0; i < n; i++)
+    {
+        uint8_t j = 0;
+
+        while (j < count && list[j] != (ids[i] & 0x7FFu))
+        {
+            j++;
+        }
+        if (j < count)
+        {
+            continue;                   /* 重复 */
+        }
+        if (count == sizeof(list) / sizeof(list[0]))
+        {
+            res = 1;
+            break;
+        }
+        list[count++] = (uint16_t)(ids[i] & 0x7FFu);
+    }
+    for (uint8_t b = 0; b < PDM_CAN_FILTER_BANKS; b++)
+    {
+        uint8_t first = (uint8_t)(b * PDM_CAN_FILTER_PER_BANK);
+        uint8_t in_bank = (count > first) ? (uint8_t)(count - first) : 0u;
+
+        if (in_bank > PDM_CAN_FILTER_PER_BANK)
+        {
+            in_bank = PDM_CAN_FILTER_PER_BANK;
+        }
+        filter_bank(b, &list[(in_bank != 0) ? first : 0], in_bank);
+    }
+    return res;
+}
+
+uint8_t PDM_Can_Read(pdm_can_frame_t *frame)
+{
+    uint8_t tail = g_rxq_tail;
+
+    if (tail == g_rxq_head)
+    {
+        return 1;
+    }
+    *frame = g_rxq[tail];
+    g_rxq_tail = (uint8_t)((tail + 1u) & (RXQ_LEN - 1u));
+    return 0;
+}
+
+uint8_t PDM_Can_TxQueueLen(void)
+{
+    return g_txq_len;
+}
+
+const pdm_can_stats_t *PDM_Can_GetStats(void)
+{
+    return &g_can_stats;
+}
+
+#if PDM_CFG_CAN_LATENCY
+/* --- 延迟分档：档 0 < 256 us，之后每档加倍，最后一档 >= 64 ms --- */
+static uint8_t lat_bin(uint32_t us)
+{
+    uint8_t b = 0;
+
+    us >>= 8;
+    while (us != 0 && b < PDM_CAN_LAT_BINS - 1u)
+    {
+        us >>= 1;
+        b++;
+    }
+    return b;
+}
+
+/* --- 邮箱 n 发送成功：入队到完成的延迟计入该报文和总分档，
+ * probe 帧放入邮箱到完成的时间超过自身帧长说明放入时总线正忙或仲裁失败过 --- */
+static void lat_done(uint8_t n)
+{
+    const mb_slot_t *mb = &g_mb[n];
+    uint32_t now = PDM_Sched_NowUs();
+    uint32_t lat = now - mb->t_enq;
+    uint8_t i = 0;
+    pdm_can_lat_t *l;
+
+    while (i < g_msg_count && g_msgs[i].id != mb->id)
+    {
+        i++;
+    }
+    l = &g_lat[(i < g_msg_count) ? i : PDM_CAN_MAX_MSGS];
+    l->n++;
+    l->sum_us += lat;
+    if (lat > l->max_us) l->max_us = lat;
+    g_lat_hist[lat_bin(lat)]++;
+
+    if (mb->probe)
+    {
+        uint32_t own_us = PDM_Can_FrameBits(mb->dlc) * g_bit_ns / 1000u;
+
+        g_probe_n++;
+        if (now - mb->t_put > own_us + PDM_CAN_LAT_SLACK_US)
+        {
+            g_probe_busy++;
+            g_can_stats.tx_delayed++;
+        }
+    }
+}
+
+void PDM_Can_LatReset(void)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    memset(g_lat, 0, sizeof(g_lat));
+    memset(g_lat_hist, 0, sizeof(g_lat_hist));
+    g_can_stats.tx_delayed = 0;
+    __set_PRIMASK(primask);
+}
+
+void PDM_Can_LatPrint(void)
+{
+    pdm_can_lat_t l;
+    uint32_t hist[PDM_CAN_LAT_BINS];
+    uint32_t primask;
+
+    for (uint8_t i = 0; i <= g_msg_count; i++)
+    {
+        uint8_t k = (i < g_msg_count) ? i : PDM_CAN_MAX_MSGS;
+
+        primask = __get_PRIMASK();
+        __disable_irq();
+        l = g_lat[k];
+        __set_PRIMASK(primask);
+        if (l.n == 0)
+        {
+            continue;
+        }
+        if (i < g_msg_count)
+        {
+            PDM_Log_Printf("0x%03lX n %lu mean %lu us max %lu us\r\n", (unsigned long)g_msgs[i].id,
+                           (unsigned long)l.n, (unsigned long)(l.sum_us / l.n), (unsigned long)l.max_us);
+        }
+        else
+        {
+            PDM_Log_Printf("other n %lu mean %lu us max %lu us\r\n",
+                           (unsigned long)l.n, (unsigned long)(l.sum_us / l.n), (unsigned long)l.max_us);
+        }
+    }
+
+    /* 分档按上限（us）输出，最后一档为 >= 65536 */
+    primask = __get_PRIMASK();
+    __disable_irq();
+    memcpy(hist, g_lat_hist, sizeof(hist));
+    __set_PRIMASK(primask);
+    PDM_Log_Begin();
+    PDM_Log_Str("lat");
+    for (uint8_t b = 0; b < PDM_CAN_LAT_BINS; b++)
+    {
+        PDM_Log_Str((b + 1u < PDM_CAN_LAT_BINS) ? " <" : " >=");
+        PDM_Log_Uint((b + 1u < PDM_CAN_LAT_BINS) ? (256u << b) : (256u << (b - 1u)));
+        PDM_Log_Char(':');
+        PDM_Log_Uint(hist[b]);
+    }
+    PDM_Log_Str("\r\n");
+    (void)PDM_Log_End();
+    PDM_Log_Printf("busy %u.%u%% delayed %lu\r\n", g_can_stats.busy_permille / 10u,
+                   g_can_stats.busy_permille % 10u, (unsigned long)g_can_stats.tx_delayed);
+}
+#endif
+
+/* --- HAL CAN TX callbacks --- */
+
+/* 故障中断优先级更高，可能在补充邮箱的中途插入新帧，补充过程关中断 */
+static void txq_refill_isr(void)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    txq_refill();
+    __set_PRIMASK(primask);
+}
+
+void HAL_CAN_TxMailbox0CompleteCallback(CAN_HandleTypeDef *hcan_)
+{
+    (void)hcan_;
+#if PDM_CFG_CAN_LATENCY
+    lat_done(0);
+#endif
+#if PDM_CFG_CANH
+    PDM_CanHealth_OnTxDone();
+#endif
+    txq_refill_isr();
+}
+
+void HAL_CAN_TxMailbox1CompleteCallback(CAN_HandleTypeDef *hcan_)
+{
+    (void)hcan_;
+#if PDM_CFG_CAN_LATENCY
+    lat_done(1);
+#endif
+#if PDM_CFG_CANH
+    PDM_CanHealth_OnTxDone();
+#endif
+    txq_refill_isr();
+}
+
+void HAL_CAN_TxMailbox2CompleteCallback(CAN_HandleTypeDef *hcan_)
+{
+    (void)hcan_;
+#if PDM_CFG_CAN_LATENCY
+    lat_done(2);
+#endif
+#if PDM_CFG_CANH
+    PDM_CanHealth_OnTxDone();
+#endif
+    txq_refill_isr();
+}
+
+void HAL_CAN_TxMailbox0AbortCallback(CAN_HandleTypeDef *hcan_)
+{
+    (void)hcan_;
+    txq_refill_isr();
+}
+
+void HAL_CAN_TxMailbox1AbortCallback(CAN_HandleTypeDef *hcan_)
+{
+    (void)hcan_;
+    txq_refill_isr();
+}
+
+void HAL_CAN_TxMailbox2AbortCallback(CAN_HandleTypeDef *hcan_)
+{
+    (void)hcan_;
+    txq_refill_isr();
+}
+
+/* --- HAL CAN RX callback --- */
+
+void HAL_CAN_RxFifo0MsgPendingCallback(CAN_HandleTypeDef *hcan_)
+{
+    CAN_RxHeaderTypeDef hdr;
+    uint8_t data[8];
+
+    /* 每次中断把 FIFO 中的帧全部取出，接收队列满时丢弃 */
+    while (HAL_CAN_GetRxFifoFillLevel(hcan_, CAN_RX_FIFO0) != 0)
+    {
+        if (HAL_CAN_GetRxMessage(hcan_, CAN_RX_FIFO0, &hdr, data) != HAL_OK)
+        {
+            break;
+        }
+        if (hdr.IDE != CAN_ID_STD || hdr.RTR != CAN_RTR_DATA)
+        {
+            continue;
+        }
+
+        uint8_t head = g_rxq_head;
+        uint8_t next = (uint8_t)((head + 1u) & (RXQ_LEN - 1u));
+
+        if (next == g_rxq_tail)
+        {
+            g_can_stats.rx_drops++;
+            continue;
+        }
+        g_rxq[head].id = (uint16_t)PDM_Node_RxId(hdr.StdId);
+        g_rxq[head].dlc = (uint8_t)hdr.DLC;
+        memcpy(g_rxq[head].data, data, 8);
+        g_rxq[head].t_us = PDM_Sched_NowUs();
+        g_rxq_head = next;
+        g_can_stats.rx_frames++;
+    }
+#if PDM_CFG_RTOS
+    PDM_Rtos_Wake(PDM_RTOS_WAKE_COMMS);
+#endif
+}
@@ -0,0 +1,197 @@
+#include "pdm_canhealth.h"
+
+#if PDM_CFG_CANH
+
+#include "can.h"
+#include "pdm_evlog.h"
+#include "pdm_log.h"
+#include "pdm_sched.h"
+#include <string.h>
+
+#define ERR_IT  (CAN_IT_ERROR_WARNING | CAN_IT_ERROR_PASSIVE | CAN_IT_BUSOFF | CAN_IT_LAST_ERROR_CODE | \
+                 CAN_IT_ERROR | CAN_IT_RX_FIFO0_OVERRUN)
+
+static pdm_canh_stats_t g_st;
+static uint16_t g_lec_window;       /* 本秒的错误帧数 */
+static uint32_t g_window_start;
+static uint32_t g_busoff_start_us;
+static uint32_t g_passive_start;
+
+/* --- ESR 中的错误状态 --- */
+static uint8_t esr_state(uint32_t esr)
+{
+    return (uint8_t)(((esr & CAN_ESR_EWGF) ? PDM_CANH_WARNING : 0) |
+                     ((esr & CAN_ESR_EPVF) ? PDM_CANH_PASSIVE : 0) |
+                     ((esr & CAN_ESR_BOFF) ? PDM_CANH_BUSOFF : 0));
+}
+
+static void update_tec_rec(uint32_t esr)
+{
+    g_st.tec = (uint8_t)((esr & CAN_ESR_TEC) >> CAN_ESR_TEC_Pos);
+    g_st.rec = (uint8_t)((esr & CAN_ESR_REC) >> CAN_ESR_REC_Pos);
+    if (g_st.tec > g_st.tec_max) g_st.tec_max = g_st.tec;
+    if (g_st.rec > g_st.rec_max) g_st.rec_max = g_st.rec;
+}
+
+void PDM_CanHealth_Init(uint32_t now)
+{
+    memset(&g_st, 0, sizeof(g_st));
+    g_lec_window = 0;
+    g_window_start = now;
+    HAL_CAN_ActivateNotification(&hcan, ERR_IT);
+    HAL_NVIC_EnableIRQ(CAN1_SCE_IRQn);
+}
+
+/* --- HAL 在错误中断（SCE）和接收 FIFO 溢出时调用，状态位只在变为 1 时计数 --- */
+void HAL_CAN_ErrorCallback(CAN_HandleTypeDef *hcan_)
+{
+    uint32_t code = hcan_->ErrorCode;
+    uint32_t esr = hcan_->Instance->ESR;
+    uint8_t state = esr_state(esr);
+    uint8_t rise = (uint8_t)(state & ~g_st.state);
+
+    hcan_->ErrorCode = HAL_CAN_ERROR_NONE;
+    update_tec_rec(esr);
+
+    if (rise & PDM_CANH_WARNING)
+    {
+        g_st.warnings++;
+    }
+    if (rise & PDM_CANH_PASSIVE)
+    {
+        g_st.passives++;
+        g_passive_start = HAL_GetTick();
+    }
+    if (rise & PDM_CANH_BUSOFF)
+    {
+        g_st.busoffs++;
+        g_busoff_start_us = PDM_Sched_NowUs();
+#if PDM_CFG_EVLOG
+        PDM_Evlog_Add(PDM_EV_BUSOFF, PDM_EV_NO_CH, (uint16_t)((esr & CAN_ESR_TEC) >> CAN_ESR_TEC_Pos), g_st.busoffs);
+#endif
+    }
+    g_st.state = (uint8_t)((g_st.state & (PDM_CANH_THROTTLED | PDM_CANH_PASSIVE | PDM_CANH_BUSOFF)) | state);
+
+    if (code & (HAL_CAN_ERROR_STF | HAL_CAN_ERROR_FOR | HAL_CAN_ERROR_ACK |
+                HAL_CAN_ERROR_BR | HAL_CAN_ERROR_BD | HAL_CAN_ERROR_CRC))
+    {
+        /* HAL 读过 ESR 后已清除 LEC，错误代码从 HAL 的错误码还原 */
+        uint8_t lec = (code & HAL_CAN_ERROR_STF) ? PDM_CANH_LEC_STUFF :
+                      (code & HAL_CAN_ERROR_FOR) ? PDM_CANH_LEC_FORM :
+                      (code & HAL_CAN_ERROR_ACK) ? PDM_CANH_LEC_ACK :
+                      (code & HAL_CAN_ERROR_BR) ? PDM_CANH_LEC_BIT1 :
+                      (code & HAL_CAN_ERROR_BD) ? PDM_CANH_LEC_BIT0 : PDM_CANH_LEC_CRC;
+
+        g_st.lec = lec;
+        g_st.lec_count[lec]++;
+        if (++g_lec_window >= PDM_CFG_CANH_LEC_LIMIT)
+        {
+            __HAL_CAN_DISABLE_IT(hcan_, CAN_IT_LAST_ERROR_CODE);
+            g_st.state |= PDM_CANH_THROTTLED;
+        }
+    }
+    if (code & HAL_CAN_ERROR_RX_FOV0)
+    {
+        g_st.rx_overruns++;
+    }
+}
+
+void PDM_CanHealth_OnTxDone(void)
+{
+    /* 离线后第一帧发送成功，恢复完成 */
+    if (g_st.state & PDM_CANH_BUSOFF)
+    {
+        uint32_t us = PDM_Sched_NowUs() - g_busoff_start_us;
+
+        g_st.busoff_last_us = us;
+        if (us > g_st.busoff_max_us) g_st.busoff_max_us = us;
+        g_st.state &= (uint8_t)~PDM_CANH_BUSOFF;
+    }
+}
+
+void PDM_CanHealth_Poll(uint32_t now)
+{
+    uint32_t primask = __get_PRIMASK();
+    uint32_t esr;
+    uint8_t state;
+
+    __disable_irq();
+    esr = hcan.Instance->ESR;
+    state = esr_state(esr);
+    update_tec_rec(esr);
+    if ((g_st.state & PDM_CANH_PASSIVE) && !(state & PDM_CANH_PASSIVE))
+    {
+        uint32_t ms = now - g_passive_start;
+
+        g_st.passive_ms += ms;
+        if (ms > g_st.passive_max_ms) g_st.passive_max_ms = ms;
+    }
+    /* 离线标志保留到下一帧发送成功（PDM_CanHealth_OnTxDone） */
+    g_st.state = (uint8_t)((g_st.state & (PDM_CANH_THROTTLED | PDM_CANH_BUSOFF)) | state);
+
+    if (now - g_window_start >= 1000u)
+    {
+        g_window_start = now;
+        g_st.err_last_s = g_lec_window;
+        g_lec_window = 0;
+        if (g_st.state & PDM_CANH_THROTTLED)
+        {
+            g_st.state &= (uint8_t)~PDM_CANH_THROTTLED;
+            __HAL_CAN_ENABLE_IT(&hcan, CAN_IT_LAST_ERROR_CODE);
+        }
+    }
+    __set_PRIMASK(primask);
+}
+
+void PDM_CanHealth_Get(pdm_canh_stats_t *out)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    *out = g_st;
+    __set_PRIMASK(primask);
+}
+
+static uint8_t sat_u8(uint32_t v)
+{
+    return (uint8_t)((v > 255u) ? 255u : v);
+}
+
+void PDM_CanHealth_Encode(uint8_t *data, const void *arg)
+{
+    pdm_canh_stats_t s;
+    uint32_t rec;
+
+    (void)arg;
+    PDM_CanHealth_Get(&s);
+    rec = s.busoff_last_us / 100u;
+    if (rec > 0xFFFFu) rec = 0xFFFFu;
+
+    data[0] = s.tec;
+    data[1] = s.rec;
+    data[2] = (uint8_t)(s.lec << 4 | s.state);
+    data[3] = sat_u8(s.busoffs);
+    data[4] = sat_u8(s.passives);
+    data[5] = sat_u8(s.err_last_s);
+    data[6] = (uint8_t)(rec >> 8);
+    data[7] = (uint8_t)(rec & 0xFF);
+}
+
+void PDM_CanHealth_Print(void)
+{
+    pdm_canh_stats_t s;
+
+    PDM_CanHealth_Get(&s);
+    PDM_Log_Printf("CAN tec %u/%u rec %u/%u state 0x%02X lec %u err/s %u\r\n",
+                   s.tec, s.tec_max, s.rec, s.rec_max, s.state, s.lec, s.err_last_s);
+    PDM_Log_Printf("CAN stuff %lu form %lu ack %lu bit1 %lu bit0 %lu crc %lu ovr %lu\r\n",
+                   (unsigned long)s.lec_count[PDM_CANH_LEC_STUFF], (unsigned long)s.lec_count[PDM_CANH_LEC_FORM],
+                   (unsigned long)s.lec_count[PDM_CANH_LEC_ACK], (unsigned long)s.lec_count[PDM_CANH_LEC_BIT1],
+                   (unsigned long)s.lec_count[PDM_CANH_LEC_BIT0], (unsigned long)s.lec_count[PDM_CANH_LEC_CRC],
+                   (unsigned long)s.rx_overruns);
+    PDM_Log_Printf("CAN warn %u passive %u (%lu ms, max %lu) busoff %u (last %lu us, max %lu)\r\n",
+                   s.warnings, s.passives, (unsigned long)s.passive_ms, (unsigned long)s.passive_max_ms,
+                   s.busoffs, (unsigned long)s.busoff_last_us, (unsigned long)s.busoff_max_us);
+}
+
+#endif /* PDM_CFG_CANH */
@@ -0,0 +1,900 @@
+#include "pdm_capture.h"
+
+#if PDM_CFG_CAPTURE
+
+#include "pdm_calc.h"
+#include "pdm_can.h"
+#include "pdm_log.h"
+#include "pdm_pack.h"
+#include "pdm_param.h"
+#include "pdm_pool.h"
+#include "pdm_sched.h"
+#include "pdm_protect.h"
+#include "pdm_stream.h"
+#include "pdm_timer.h"
+#include "pdm_timesync.h"
+#include "ina226_async.h"
+#include "stm32f1xx_hal.h"
+#include <string.h>
+
+/* 发送时 CAN 队列中最多留几帧，给通道报文留出位置 */
+#define STREAM_TXQ_LIMIT    4
+
+typedef enum {
+    CAP_IDLE = 0,
+    CAP_ARMED,          /* 连续采集，等待触发 */
+    CAP_POST,           /* 已触发，采集触发后的样本 */
+    CAP_DONE,           /* 采集结束，等待主循环恢复配置 */
+    CAP_STREAM,         /* 通过 CAN 发送 */
+    CAP_FAST,           /* 只测电流的高速采样流，缓冲区为 FIFO，主循环取出后经 UART 输出 */
+    CAP_FAST_END,       /* 采样流停止，等待主循环输出剩余样本并恢复配置 */
+    CAP_BOOT,           /* 上电采集，结束后进入 CAP_DONE */
+} cap_state_t;
+
+typedef struct {
+    int16_t raw;        /* 分流电压寄存器 */
+    uint16_t dt_us;     /* 与上一样本的间隔 */
+} cap_sample_t;
+
+static cap_sample_t g_cap_buf[PDM_CFG_CAPTURE_SAMPLES];
+static uint8_t g_cap_rx[2];
+
+static ina226_handle_t *g_cap_h;
+static ina226_avg_t g_cap_avg;     /* 正常采样时的平均次数 */
+static const pdm_scale_t *g_cap_scale;
+static volatile cap_state_t g_cap_state;
+static volatile uint32_t g_cap_count;       /* 已写入的样本总数 */
+static volatile uint32_t g_cap_trig;        /* 触发时的样本总数 */
+static volatile uint32_t g_cap_end;         /* 采集结束时的样本总数 */
+static volatile uint8_t g_cap_source;
+static uint32_t g_cap_last_us;
+
+/* 发送进度 */
+static uint8_t g_tx_hdr[6];             /* 头帧前 6 字节，也用于 PDM_Capture_Read() */
+static uint32_t g_tx_start;
+static uint32_t g_tx_n;
+static uint32_t g_tx_pos;
+#if PDM_CFG_CAPTURE_PACK
+static pdm_pack_t g_pk_cur;
+static pdm_pack_t g_pk_dt;
+static uint8_t *g_pk_out[2];           /* 当前一块电流和间隔的编码，发送期间从共享内存池取用 */
+static uint8_t g_pk_len[2];
+static uint8_t g_pk_part;              /* 正在发送 g_pk_out[g_pk_part] */
+static uint8_t g_pk_pos;
+static uint8_t g_pk_seq;
+#endif
+
+#if PDM_CFG_CAPTURE_FAST
+#if !PDM_CFG_UART_STREAM
+#error "PDM_CFG_CAPTURE_FAST outputs through the UART stream, enable PDM_CFG_UART_STREAM"
+#endif
+#if PDM_CFG_CAPTURE_FAST_BLOCK < 1 || PDM_CFG_CAPTURE_FAST_BLOCK > 60
+#error "PDM_CFG_CAPTURE_FAST_BLOCK must be 1..60"
+#endif
+
+typedef struct {
+    uint32_t reads;                     /* 完成的读取 */
+    uint32_t same;                      /* 与上一样本间隔太短，读到的是同一次转换 */
+    uint32_t samples;                   /* 写入缓冲区的样本 */
+    uint32_t drop_buf;                  /* 缓冲区满丢弃 */
+    uint32_t drop_uart;                 /* UART 日志缓冲区满，随整帧丢弃 */
+    uint32_t errors;                    /* 读取失败（之后停止） */
+    uint32_t start_ms;
+    uint32_t stop_ms;
+} fast_stat_t;
+
+static fast_stat_t g_fast;
+static volatile uint32_t g_fast_rd;     /* 主循环已取出的样本总数 */
+static uint32_t g_fast_store_us;        /* 最近一个写入缓冲区的样本的时间 */
+static uint32_t g_fast_t_us;            /* 最近一个取出的样本的时间 */
+static void fast_read_done(uint8_t res, uint32_t now);
+#endif
+
+#if PDM_CFG_CAPTURE_BOOT
+#if PDM_TIMER_US
+#error "PDM_CFG_CAPTURE_BOOT starts before the TIM2/TIM4 timebase, it needs the SysTick timebase"
+#endif
+
+#define BOOT_US     ((uint32_t)PDM_CFG_CAPTURE_BOOT_MS * 1000u)
+
+static uint8_t g_boot_addr;
+static volatile uint8_t g_boot_paused;  /* 阻塞读写占用总线，等 SysTick 继续 */
+static uint32_t g_boot_start_us;        /* PDM_Capture_Boot() 的时间，采集时长从这里算 */
+static uint32_t g_boot_first_us;
+static uint32_t g_boot_step_us;         /* 抽取阶段每段的时间，0 为全速阶段 */
+static uint32_t g_boot_next_us;         /* 当前段结束的时间 */
+static int16_t g_boot_peak;             /* 当前段绝对值最大的样本和它的读取时间 */
+static uint32_t g_boot_peak_us;
+static uint8_t g_boot_have;
+static uint32_t g_boot_samples;         /* 结束时的样本数 */
+static uint32_t g_boot_reads;
+static uint32_t g_boot_pauses;
+static void boot_read_done(uint8_t res, uint32_t now);
+#endif
+
+static void cap_read_done(uint8_t res, void *ctx);
+
+/* --- 发起下一次读取（中断和主循环都会调用） --- */
+static void cap_read_next(void)
+{
+    if (ina226_interface_iic_read_async(g_cap_h->iic_addr, INA226_REG_SHUNT_VOLTAGE,
+                                        g_cap_rx, 2, cap_read_done, NULL) != 0)
+    {
+#if PDM_CFG_CAPTURE_FAST
+        if (g_cap_state == CAP_FAST)
+        {
+            g_fast.errors++;
+            g_cap_state = CAP_FAST_END;
+            return;
+        }
+#endif
+        g_cap_end = g_cap_count;                /* 队列满，提前结束 */
+        g_cap_state = CAP_DONE;
+    }
+}
+
+/* --- 一个样本读完（I2C 中断中） --- */
+static void cap_read_done(uint8_t res, void *ctx)
+{
+    uint32_t now = PDM_Sched_NowUs();
+    uint32_t dt = now - g_cap_last_us;
+
+    (void)ctx;
+#if PDM_CFG_CAPTURE_FAST
+    if (g_cap_state == CAP_FAST)
+    {
+        fast_read_done(res, now);
+        return;
+    }
+#endif
+#if PDM_CFG_CAPTURE_BOOT
+    if (g_cap_state == CAP_BOOT)
+    {
+        boot_read_done(res, now);
+        return;
+    }
+#endif
+    if (g_cap_state != CAP_ARMED && g_cap_state != CAP_POST)
+    {
+        return;
+    }
+    if (res != 0)
+    {
+        g_cap_end = g_cap_count;
+        g_cap_state = CAP_DONE;
+        return;
+    }
+
+    cap_sample_t *s = &g_cap_buf[g_cap_count % PDM_CFG_CAPTURE_SAMPLES];
+    s->raw = (int16_t)((uint16_t)g_cap_rx[0] << 8 | g_cap_rx[1]);
+    s->dt_us = (g_cap_count == 0) ? 0 : (uint16_t)pdm_calc_sat_u16(dt);
+    g_cap_last_us = now;
+    g_cap_count++;
+
+    if (g_cap_state == CAP_POST &&
+        g_cap_count - g_cap_trig >= PDM_CFG_CAPTURE_SAMPLES - PDM_CFG_CAPTURE_PRE)
+    {
+        g_cap_end = g_cap_count;
+        g_cap_state = CAP_DONE;
+        return;
+    }
+    cap_read_next();
+}
+
+static void cap_trigger(uint8_t source)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    if (g_cap_state == CAP_ARMED)
+    {
+        g_cap_trig = g_cap_count;
+        g_cap_source = source;
+        g_cap_state = CAP_POST;
+    }
+    __set_PRIMASK(primask);
+}
+
+/* --- 切换到高速采集配置：不平均，140 us 转换，电流超过门限时拉低 ALERT --- */
+static uint8_t cap_config_fast(void)
+{
+    int32_t limit = pdm_calc_shunt_raw_from_mA(PDM_CFG_CAPTURE_TRIG_MA, g_cap_scale);
+
+#if PDM_CFG_PROTECT
+    if (PDM_Protect_Suspend(PDM_CFG_CAPTURE_CH) != 0) return 1;
+#endif
+#if PDM_CFG_SYNC_TRIGGER
+    /* 同步触发模式下芯片平时是单次转换，采集期间改为连续转换，结束后由下一次触发恢复 */
+    if (ina226_set_mode(g_cap_h, INA226_MODE_SHUNT_BUS_VOLTAGE_CONTINUOUS) != 0) return 1;
+#endif
+    if (ina226_set_average_mode(g_cap_h, INA226_AVG_1) != 0) return 1;
+    if (ina226_set_bus_voltage_conversion_time(g_cap_h, INA226_CONVERSION_TIME_140_US) != 0) return 1;
+    if (ina226_set_shunt_voltage_conversion_time(g_cap_h, INA226_CONVERSION_TIME_140_US) != 0) return 1;
+    if (ina226_set_alert_limit(g_cap_h, (uint16_t)pdm_calc_sat_i16(limit)) != 0) return 1;
+    return ina226_set_mask(g_cap_h, INA226_MASK_SHUNT_VOLTAGE_OVER_VOLTAGE, INA226_BOOL_TRUE);
+}
+
+/* --- 恢复正常采样配置 --- */
+static uint8_t cap_config_normal(void)
+{
+    if (ina226_set_mask(g_cap_h, INA226_MASK_SHUNT_VOLTAGE_OVER_VOLTAGE, INA226_BOOL_FALSE) != 0) return 1;
+    if (ina226_set_average_mode(g_cap_h, g_cap_avg) != 0) return 1;
+    if (ina226_set_bus_voltage_conversion_time(g_cap_h, (ina226_conversion_time_t)PDM_Param_Get()->bus_ct) != 0) return 1;
+    if (ina226_set_shunt_voltage_conversion_time(g_cap_h, (ina226_conversion_time_t)PDM_Param_Get()->shunt_ct) != 0) return 1;
+#if PDM_CFG_PROTECT
+    return PDM_Protect_Resume(PDM_CFG_CAPTURE_CH);
+#else
+    return 0;
+#endif
+}
+
+static uint8_t cap_arm(void)
+{
+    if (g_cap_h == NULL || g_cap_h->inited != 1 || cap_config_fast() != 0)
+    {
+        PDM_Log_Printf("capture arm FAIL\r\n");
+        (void)cap_config_normal();
+        return 1;
+    }
+
+    g_cap_count = 0;
+    g_cap_source = 0;
+    g_cap_last_us = PDM_Sched_NowUs();
+    g_cap_state = CAP_ARMED;
+    cap_read_next();
+    return 0;
+}
+
+static void put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)(v >> 8);
+    p[1] = (uint8_t)(v & 0xFF);
+}
+
+/* --- 采集结束：恢复配置，准备发送 --- */
+static void cap_finish(void)
+{
+    uint8_t hdr[8] = { 0 };
+    uint32_t end = g_cap_end;
+    uint8_t res = cap_config_normal();
+
+#if PDM_CFG_CAPTURE_BOOT && !PDM_CFG_SYNC_TRIGGER
+    /* 上电采集只转换分流电压；同步触发模式下转换方式由下一次触发恢复 */
+    if (g_cap_source == PDM_CAPTURE_TRIG_BOOT &&
+        ina226_set_mode(g_cap_h, INA226_MODE_SHUNT_BUS_VOLTAGE_CONTINUOUS) != 0)
+    {
+        res = 1;
+    }
+#endif
+    if (res != 0)
+    {
+        PDM_Log_Printf("capture restore FAIL\r\n");
+    }
+
+    g_tx_start = (end > PDM_CFG_CAPTURE_SAMPLES) ? end - PDM_CFG_CAPTURE_SAMPLES : 0;
+    g_tx_n = end - g_tx_start;
+    g_tx_pos = 0;
+
+    g_tx_hdr[0] = PDM_CFG_CAPTURE_CH;
+    put_u16(&g_tx_hdr[1], (uint16_t)g_tx_n);
+    put_u16(&g_tx_hdr[3], (uint16_t)((g_cap_source != 0 && g_cap_trig >= g_tx_start) ? g_cap_trig - g_tx_start : 0));
+    g_tx_hdr[5] = g_cap_source;
+    memcpy(hdr, g_tx_hdr, sizeof(g_tx_hdr));
+#if PDM_CFG_CAPTURE_PACK
+    hdr[6] = PDM_CAPTURE_FMT_PACK;
+    PDM_Pack_Init(&g_pk_cur);
+    PDM_Pack_Init(&g_pk_dt);
+    g_pk_len[0] = 0;
+    g_pk_len[1] = 0;
+    g_pk_part = 1;
+    g_pk_pos = 0;
+    g_pk_seq = 0;
+#endif
+    (void)PDM_Can_Send(PDM_CAPTURE_HDR_ID, hdr, sizeof(hdr));
+#if PDM_CFG_TIMESYNC
+    if (g_tx_n != 0)
+    {
+        /* 最后一个样本的时间往前减去各样本间隔，得到第一个发出样本的时间 */
+        uint32_t t_us = g_cap_last_us;
+
+        for (uint32_t k = g_tx_start + 1u; k < end; k++)
+        {
+            t_us -= g_cap_buf[k % PDM_CFG_CAPTURE_SAMPLES].dt_us;
+        }
+        PDM_TimeSync_Encode(PDM_TSYNC_KIND_CAPTURE, PDM_CFG_CAPTURE_CH, t_us, hdr);
+        (void)PDM_Can_Send(PDM_TIMESYNC_CAN_ID, hdr, sizeof(hdr));
+    }
+#endif
+
+    /* 第一个发出的样本没有上一样本，间隔记 0 */
+    if (g_tx_n != 0)
+    {
+        g_cap_buf[g_tx_start % PDM_CFG_CAPTURE_SAMPLES].dt_us = 0;
+    }
+    g_cap_state = CAP_STREAM;
+}
+
+#if PDM_CFG_CAPTURE_PACK
+_Static_assert(PDM_PACK_MAX_BYTES_16 <= PDM_POOL_BLOCK_SIZE, "packed block larger than pool block");
+
+/* --- 取得两个输出块；内存池暂时没有可用块时返回 1，下次再试 --- */
+static uint8_t cap_pack_alloc(void)
+{
+    for (uint8_t k = 0; k < 2; k++)
+    {
+        if (g_pk_out[k] == NULL)
+        {
+            g_pk_out[k] = (uint8_t *)PDM_Pool_Alloc(PDM_POOL_CAPTURE);
+            if (g_pk_out[k] == NULL)
+            {
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+static void cap_pack_release(void)
+{
+    for (uint8_t k = 0; k < 2; k++)
+    {
+        if (g_pk_out[k] != NULL)
+        {
+            PDM_Pool_Free(PDM_POOL_CAPTURE, g_pk_out[k]);
+            g_pk_out[k] = NULL;
+        }
+    }
+}
+
+/* --- 编码下一块样本（每个样本只读一次），电流块在前、间隔块在后 --- */
+static void cap_pack_next(void)
+{
+    while (g_tx_pos < g_tx_n)
+    {
+        const cap_sample_t *s = &g_cap_buf[(g_tx_start + g_tx_pos) % PDM_CFG_CAPTURE_SAMPLES];
+        uint8_t full;
+
+        full = PDM_Pack_Put(&g_pk_cur, (uint32_t)(int32_t)s->raw);
+        (void)PDM_Pack_Put(&g_pk_dt, s->dt_us);
+        g_tx_pos++;
+        if (full)
+        {
+            break;
+        }
+    }
+    g_pk_len[0] = PDM_Pack_Flush(&g_pk_cur, g_pk_out[0]);
+    g_pk_len[1] = PDM_Pack_Flush(&g_pk_dt, g_pk_out[1]);
+    g_pk_part = 0;
+    g_pk_pos = 0;
+}
+
+/* --- 分批发送压缩数据，每帧 [序号, 最多 7 字节]，块可以跨帧 --- */
+static void cap_stream(void)
+{
+    uint8_t data[8];
+
+    if (cap_pack_alloc() != 0)
+    {
+        return;
+    }
+    while (PDM_Can_TxQueueLen() < STREAM_TXQ_LIMIT)
+    {
+        uint8_t n = 0;
+
+        /* 电流块发完接着发间隔块，两块之间不留空字节 */
+        while (n < 7u)
+        {
+            uint8_t k;
+
+            if (g_pk_pos >= g_pk_len[g_pk_part])
+            {
+                if (g_pk_part == 0)
+                {
+                    g_pk_part = 1;
+                    g_pk_pos = 0;
+                    continue;
+                }
+                if (n != 0 || g_tx_pos >= g_tx_n)
+                {
+                    break;
+                }
+                cap_pack_next();
+                continue;
+            }
+            k = (uint8_t)(g_pk_len[g_pk_part] - g_pk_pos);
+            if (k > 7u - n)
+            {
+                k = (uint8_t)(7u - n);
+            }
+            memcpy(&data[1u + n], &g_pk_out[g_pk_part][g_pk_pos], k);
+            g_pk_pos = (uint8_t)(g_pk_pos + k);
+            n = (uint8_t)(n + k);
+        }
+        if (n == 0)
+        {
+            break;
+        }
+        data[0] = g_pk_seq++;
+        (void)PDM_Can_Send(PDM_CAPTURE_DATA_ID, data, (uint8_t)(1u + n));
+    }
+
+    if (g_tx_pos >= g_tx_n && g_pk_part == 1 && g_pk_pos >= g_pk_len[1])
+    {
+        cap_pack_release();
+        g_cap_state = CAP_IDLE;
+#if PDM_CFG_CAPTURE_AUTO_ARM
+        (void)cap_arm();
+#endif
+    }
+}
+#else
+/* --- 分批发送，每帧两个样本 --- */
+static void cap_stream(void)
+{
+    uint8_t data[8];
+
+    while (g_tx_pos < g_tx_n && PDM_Can_TxQueueLen() < STREAM_TXQ_LIMIT)
+    {
+        uint8_t len = 0;
+
+        for (uint8_t k = 0; k < 2 && g_tx_pos < g_tx_n; k++)
+        {
+            const cap_sample_t *s = &g_cap_buf[(g_tx_start + g_tx_pos) % PDM_CFG_CAPTURE_SAMPLES];
+
+            put_u16(&data[len], (uint16_t)s->raw);
+            put_u16(&data[len + 2], s->dt_us);
+            len += 4;
+            g_tx_pos++;
+        }
+        (void)PDM_Can_Send(PDM_CAPTURE_DATA_ID, data, len);
+    }
+
+    if (g_tx_pos >= g_tx_n)
+    {
+        g_cap_state = CAP_IDLE;
+#if PDM_CFG_CAPTURE_AUTO_ARM
+        (void)cap_arm();
+#endif
+    }
+}
+#endif /* PDM_CFG_CAPTURE_PACK */
+
+#if PDM_CFG_CAPTURE_FAST
+/* --- 一次读取完成（I2C 中断中）：距上一个样本不到一次转换时间的读取不输出，接着读下一次 --- */
+static void fast_read_done(uint8_t res, uint32_t now)
+{
+    if (res != 0)
+    {
+        g_fast.errors++;
+        g_cap_state = CAP_FAST_END;
+        return;
+    }
+    g_fast.reads++;
+    if (now - g_cap_last_us < PDM_CFG_CAPTURE_FAST_MIN_US)
+    {
+        g_fast.same++;
+    }
+    else
+    {
+        g_cap_last_us = now;
+        if (g_cap_count - g_fast_rd >= PDM_CFG_CAPTURE_SAMPLES)
+        {
+            g_fast.drop_buf++;          /* 主循环来不及取出 */
+        }
+        else
+        {
+            cap_sample_t *s = &g_cap_buf[g_cap_count % PDM_CFG_CAPTURE_SAMPLES];
+
+            s->raw = (int16_t)((uint16_t)g_cap_rx[0] << 8 | g_cap_rx[1]);
+            s->dt_us = (uint16_t)pdm_calc_sat_u16(now - g_fast_store_us);
+            g_fast_store_us = now;
+            g_cap_count++;
+            g_fast.samples++;
+        }
+    }
+    cap_read_next();
+}
+
+/* --- 采集通道改为只转换分流电压：140 us、不平均、连续转换 --- */
+static uint8_t fast_config(void)
+{
+#if PDM_CFG_PROTECT
+    if (PDM_Protect_Suspend(PDM_CFG_CAPTURE_CH) != 0) return 1;
+#endif
+    if (ina226_set_average_mode(g_cap_h, INA226_AVG_1) != 0) return 1;
+    if (ina226_set_shunt_voltage_conversion_time(g_cap_h, INA226_CONVERSION_TIME_140_US) != 0) return 1;
+    return ina226_set_mode(g_cap_h, INA226_MODE_SHUNT_VOLTAGE_CONTINUOUS);
+}
+
+/* --- 恢复正常采样配置，同步触发模式下转换方式由下一次触发恢复 --- */
+static uint8_t fast_config_normal(void)
+{
+    uint8_t res = cap_config_normal();
+
+#if !PDM_CFG_SYNC_TRIGGER
+    if (ina226_set_mode(g_cap_h, INA226_MODE_SHUNT_BUS_VOLTAGE_CONTINUOUS) != 0)
+    {
+        res = 1;
+    }
+#endif
+    return res;
+}
+
+/* --- 取出缓冲区中的样本，每 PDM_CFG_CAPTURE_FAST_BLOCK 个输出一帧；all 非 0 时不足一帧也输出 --- */
+static void fast_drain(uint8_t all)
+{
+    int16_t raw[PDM_CFG_CAPTURE_FAST_BLOCK];
+    uint16_t dt[PDM_CFG_CAPTURE_FAST_BLOCK];
+
+    for (;;)
+    {
+        uint32_t avail = g_cap_count - g_fast_rd;
+        uint32_t t0 = 0;
+        uint8_t n;
+
+        if (avail == 0 || (avail < PDM_CFG_CAPTURE_FAST_BLOCK && !all))
+        {
+            return;
+        }
+        n = (uint8_t)((avail < PDM_CFG_CAPTURE_FAST_BLOCK) ? avail : PDM_CFG_CAPTURE_FAST_BLOCK);
+        for (uint8_t k = 0; k < n; k++)
+        {
+            const cap_sample_t *s = &g_cap_buf[(g_fast_rd + k) % PDM_CFG_CAPTURE_SAMPLES];
+
+            raw[k] = s->raw;
+            dt[k] = s->dt_us;
+            g_fast_t_us += s->dt_us;
+            if (k == 0)
+            {
+                t0 = g_fast_t_us;
+            }
+        }
+        g_fast_rd += n;                 /* 复制完才释放位置 */
+        if (PDM_Stream_Fast(PDM_CFG_CAPTURE_CH, t0, g_fast.drop_buf + g_fast.drop_uart, raw, dt, n) != 0)
+        {
+            g_fast.drop_uart += n;
+        }
+    }
+}
+
+static uint8_t fast_start(void)
+{
+    if (g_cap_h == NULL || g_cap_h->inited != 1 || fast_config() != 0)
+    {
+        PDM_Log_Printf("fast start FAIL\r\n");
+        (void)fast_config_normal();
+        return 1;
+    }
+    memset(&g_fast, 0, sizeof(g_fast));
+    g_fast.start_ms = HAL_GetTick();
+    g_cap_count = 0;
+    g_fast_rd = 0;
+    g_cap_last_us = PDM_Sched_NowUs();
+    g_fast_store_us = g_cap_last_us;
+    g_fast_t_us = g_cap_last_us;
+    g_cap_state = CAP_FAST;
+    cap_read_next();
+    return 0;
+}
+
+/* --- 停止后（主循环）：输出剩余样本，恢复配置 --- */
+static void fast_finish(void)
+{
+    fast_drain(1);
+    g_fast.stop_ms = HAL_GetTick();
+    if (fast_config_normal() != 0)
+    {
+        PDM_Log_Printf("fast restore FAIL\r\n");
+    }
+    g_cap_state = CAP_IDLE;
+    PDM_Capture_PrintFast();
+#if PDM_CFG_CAPTURE_AUTO_ARM
+    (void)cap_arm();
+#endif
+}
+
+uint8_t PDM_Capture_Fast(uint8_t on)
+{
+    if (on)
+    {
+        if (g_cap_state == CAP_ARMED)
+        {
+            g_cap_state = CAP_IDLE;     /* 放弃等待触发；正在进行的读取在改配置前完成，不再继续 */
+        }
+        return (g_cap_state == CAP_IDLE) ? fast_start() : 1;
+    }
+    if (g_cap_state == CAP_FAST)
+    {
+        g_cap_state = CAP_FAST_END;     /* 正在进行的读取完成后不再继续 */
+    }
+    return 0;
+}
+
+void PDM_Capture_PrintFast(void)
+{
+    cap_state_t st = g_cap_state;
+    uint32_t ms = ((st == CAP_FAST || st == CAP_FAST_END) ? HAL_GetTick() : g_fast.stop_ms) - g_fast.start_ms;
+
+    PDM_Log_Printf("fast %s reads %lu same %lu samples %lu rate %lu/s\r\n",
+                   (st == CAP_FAST) ? "on" : "off", (unsigned long)g_fast.reads, (unsigned long)g_fast.same,
+                   (unsigned long)g_fast.samples,
+                   (unsigned long)((ms != 0) ? (uint64_t)g_fast.samples * 1000u / ms : 0u));
+    PDM_Log_Printf("fast drop buf %lu uart %lu err %lu\r\n", (unsigned long)g_fast.drop_buf,
+                   (unsigned long)g_fast.drop_uart, (unsigned long)g_fast.errors);
+}
+#endif /* PDM_CFG_CAPTURE_FAST */
+
+#if PDM_CFG_CAPTURE_BOOT
+static void boot_store(int16_t raw, uint32_t t_us)
+{
+    cap_sample_t *s = &g_cap_buf[g_cap_count];
+
+    s->raw = raw;
+    s->dt_us = (g_cap_count == 0) ? 0 : (uint16_t)pdm_calc_sat_u16(t_us - g_cap_last_us);
+    g_cap_last_us = t_us;
+    g_cap_count++;
+}
+
+static uint16_t abs16(int16_t v)
+{
+    return (uint16_t)((v < 0) ? -(int32_t)v : v);
+}
+
+static void boot_end(void)
+{
+    g_boot_samples = g_cap_count;
+    g_cap_end = g_cap_count;
+    g_cap_state = CAP_DONE;
+}
+
+/* --- 发起下一次读取；主循环在阻塞读写时停下（中断中调用） --- */
+static void boot_next(void)
+{
+    if (ina226_interface_iic_held(g_boot_addr))
+    {
+        g_boot_paused = 1;
+        g_boot_pauses++;
+        return;
+    }
+    if (ina226_interface_iic_read_async(g_boot_addr, INA226_REG_SHUNT_VOLTAGE, g_cap_rx, 2,
+                                        cap_read_done, NULL) != 0)
+    {
+        boot_end();
+    }
+}
+
+/* --- 一次读取完成（I2C 中断中）：全速阶段每次都记录，抽取阶段每段记录绝对值最大的一个 --- */
+static void boot_read_done(uint8_t res, uint32_t now)
+{
+    int16_t raw = (int16_t)((uint16_t)g_cap_rx[0] << 8 | g_cap_rx[1]);
+
+    if (res != 0)
+    {
+        boot_end();
+        return;
+    }
+    g_boot_reads++;
+    if (g_cap_count == 0)
+    {
+        g_boot_first_us = now;
+    }
+
+    if (g_boot_step_us == 0)
+    {
+        if (g_cap_count != 0 && now - g_cap_last_us < PDM_CFG_CAPTURE_FAST_MIN_US)
+        {
+            boot_next();                /* 读到的是同一次转换 */
+            return;
+        }
+        boot_store(raw, now);
+        if (g_cap_count >= PDM_CFG_CAPTURE_BOOT_FULL)
+        {
+            uint32_t used = now - g_boot_start_us;
+            uint32_t left = (used < BOOT_US) ? BOOT_US - used : 0u;
+
+            g_boot_step_us = left / (PDM_CFG_CAPTURE_SAMPLES - g_cap_count) + 1u;
+            g_boot_next_us = now + g_boot_step_us;
+            g_boot_have = 0;
+        }
+    }
+    else
+    {
+        if (!g_boot_have || abs16(raw) > abs16(g_boot_peak))
+        {
+            g_boot_peak = raw;
+            g_boot_peak_us = now;
+            g_boot_have = 1;
+        }
+        if ((int32_t)(now - g_boot_next_us) >= 0)
+        {
+            boot_store(g_boot_peak, g_boot_peak_us);
+            g_boot_have = 0;
+            g_boot_next_us += g_boot_step_us;
+            if ((int32_t)(now - g_boot_next_us) >= 0)
+            {
+                g_boot_next_us = now + g_boot_step_us;      /* 停下等待总线超过一段 */
+            }
+        }
+    }
+
+    if (g_cap_count >= PDM_CFG_CAPTURE_SAMPLES || now - g_boot_start_us >= BOOT_US)
+    {
+        boot_end();
+        return;
+    }
+    boot_next();
+}
+
+uint8_t PDM_Capture_Boot(uint8_t iic_addr)
+{
+    uint16_t conf = pdm_calc_conf(INA226_AVG_1, INA226_CONVERSION_TIME_140_US, INA226_CONVERSION_TIME_140_US,
+                                  INA226_MODE_SHUNT_VOLTAGE_CONTINUOUS);
+    uint8_t buf[2] = { (uint8_t)(conf >> 8), (uint8_t)(conf & 0xFF) };
+
+    if (ina226_interface_iic_write(iic_addr, INA226_REG_CONF, buf, 2) != 0)
+    {
+        return 1;
+    }
+    g_boot_addr = iic_addr;
+    g_cap_count = 0;
+    g_cap_trig = 0;
+    g_cap_source = PDM_CAPTURE_TRIG_BOOT;
+    g_boot_start_us = PDM_Sched_NowUs();
+    g_cap_last_us = g_boot_start_us;
+    g_cap_state = CAP_BOOT;
+    boot_next();
+    return 0;
+}
+
+void PDM_Capture_Tick(void)
+{
+    if (g_cap_state != CAP_BOOT || !g_boot_paused)
+    {
+        return;
+    }
+    if (PDM_Sched_NowUs() - g_boot_start_us >= BOOT_US)
+    {
+        boot_end();
+        return;
+    }
+    if (!ina226_interface_iic_held(g_boot_addr))
+    {
+        g_boot_paused = 0;
+        boot_next();
+    }
+}
+
+uint32_t PDM_Capture_BootFirstUs(void)
+{
+    return g_boot_first_us;
+}
+
+void PDM_Capture_PrintBoot(void)
+{
+    uint8_t running = (uint8_t)(g_cap_state == CAP_BOOT);
+
+    if (!running && g_boot_reads == 0)
+    {
+        PDM_Log_Printf("boot capture: no samples\r\n");
+        return;
+    }
+    PDM_Log_Printf("boot capture %s: %lu samples, %lu reads, %lu pauses\r\n", running ? "running" : "done",
+                   (unsigned long)(running ? g_cap_count : g_boot_samples), (unsigned long)g_boot_reads,
+                   (unsigned long)g_boot_pauses);
+}
+#endif /* PDM_CFG_CAPTURE_BOOT */
+
+void PDM_Capture_Init(ina226_handle_t *h, ina226_avg_t avg, const pdm_scale_t *scale)
+{
+    g_cap_h = h;
+    g_cap_avg = avg;
+    g_cap_scale = scale;
+#if PDM_CFG_CAPTURE_BOOT
+    if (g_cap_state != CAP_IDLE)
+    {
+        return;                 /* 上电采集还没发送完，之后按 PDM_CFG_CAPTURE_AUTO_ARM 武装 */
+    }
+#endif
+    g_cap_state = CAP_IDLE;
+#if PDM_CFG_CAPTURE_AUTO_ARM
+    (void)cap_arm();
+#endif
+}
+
+void PDM_Capture_SetAvg(ina226_avg_t avg)
+{
+    g_cap_avg = avg;
+}
+
+uint8_t PDM_Capture_Active(void)
+{
+    cap_state_t st = g_cap_state;
+
+    return (uint8_t)(st == CAP_ARMED || st == CAP_POST || st == CAP_DONE || st == CAP_FAST || st == CAP_FAST_END ||
+                     st == CAP_BOOT);
+}
+
+uint8_t PDM_Capture_Arm(void)
+{
+    switch (g_cap_state)
+    {
+    case CAP_IDLE:
+        return cap_arm();
+    case CAP_ARMED:
+        cap_trigger(PDM_CAPTURE_TRIG_MANUAL);
+        return 0;
+    default:
+        return 1;
+    }
+}
+
+void PDM_Capture_OnAlert(uint8_t ch)
+{
+    if (ch == PDM_CFG_CAPTURE_CH)
+    {
+        cap_trigger(PDM_CAPTURE_TRIG_ALERT);
+    }
+}
+
+void PDM_Capture_Run(void)
+{
+#if PDM_CFG_CAPTURE_FAST
+    if (g_cap_state == CAP_FAST)
+    {
+        fast_drain(0);
+    }
+    if (g_cap_state == CAP_FAST_END)
+    {
+        fast_finish();
+    }
+#endif
+    if (g_cap_state == CAP_DONE)
+    {
+        cap_finish();
+    }
+    if (g_cap_state == CAP_STREAM)
+    {
+        cap_stream();
+    }
+}
+
+uint32_t PDM_Capture_Size(void)
+{
+    cap_state_t st = g_cap_state;
+
+    if ((st != CAP_IDLE && st != CAP_STREAM) || g_tx_n == 0)
+    {
+        return 0;
+    }
+    return sizeof(g_tx_hdr) + 4u * g_tx_n;
+}
+
+uint8_t PDM_Capture_Read(uint32_t off, uint8_t *buf, uint8_t n)
+{
+    uint32_t size = PDM_Capture_Size();
+
+    if (size == 0 || off > size || n > size - off)
+    {
+        return 1;
+    }
+    for (uint8_t k = 0; k < n; k++, off++)
+    {
+        if (off < sizeof(g_tx_hdr))
+        {
+            buf[k] = g_tx_hdr[off];
+        }
+        else
+        {
+            uint32_t idx = (off - sizeof(g_tx_hdr)) / 4u;
+            const cap_sample_t *s = &g_cap_buf[(g_tx_start + idx) % PDM_CFG_CAPTURE_SAMPLES];
+            uint8_t b[4];
+
+            put_u16(&b[0], (uint16_t)s->raw);
+            put_u16(&b[2], s->dt_us);
+            buf[k] = b[(off - sizeof(g_tx_hdr)) % 4u];
+        }
+    }
+    return 0;
+}
+
+#endif /* PDM_CFG_CAPTURE */
@@ -0,0 +1,121 @@
+#include "pdm_clock.h"
+
+#if PDM_CFG_CLOCK_SCALE
+
+#include "pdm_log.h"
+#include "pdm_timer.h"
+#include "stm32f1xx_hal.h"
+
+#if PDM_TIMER_US
+#error "PDM_CFG_CLOCK_SCALE changes the APB1 timer clock, not usable with the TIM2/TIM3/TIM4 timebase"
+#endif
+#if !PDM_CFG_IDLE_SLEEP
+#error "PDM_CFG_CLOCK_SCALE needs PDM_CFG_IDLE_SLEEP"
+#endif
+
+#define CFGR_FAST_HPRE      RCC_CFGR_HPRE_DIV1
+#define CFGR_FAST_PPRE1     RCC_CFGR_PPRE1_DIV2
+#define CFGR_SLOW_HPRE      RCC_CFGR_HPRE_DIV2
+#define CFGR_SLOW_PPRE1     RCC_CFGR_PPRE1_DIV1
+
+static uint8_t g_slow;
+static uint16_t g_brr;                  /* 72 MHz 下的 USART1 BRR，恢复时写回 */
+static uint32_t g_switches;
+static uint32_t g_skipped;              /* BRR 太小或预取缓冲关闭，没有降频 */
+static uint64_t g_slow_us;
+static uint64_t g_last_slow_us;
+static uint32_t g_last_ms;
+
+/* --- SysTick 改为每 1 ms per_ms 个计数：当前 1 ms 剩下的计数按比例换算后继续 --- */
+static void systick_rescale(uint32_t per_ms)
+{
+    uint32_t old = SysTick->LOAD + 1u;
+    uint32_t left;
+    uint32_t spin = 64;
+
+    SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
+    left = (uint32_t)((uint64_t)SysTick->VAL * per_ms / old);
+    if (left < 2u)
+    {
+        left = 2u;
+    }
+    SysTick->LOAD = left - 1u;
+    SysTick->VAL = 0;
+    SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+    /* 计数器在下一个时钟装入 LOAD 之后才能改回正常重装值 */
+    while (SysTick->VAL == 0 && --spin != 0) { }
+    SysTick->LOAD = per_ms - 1u;
+}
+
+static void cfgr_set(uint32_t mask, uint32_t value)
+{
+    RCC->CFGR = (RCC->CFGR & ~mask) | value;
+}
+
+uint8_t PDM_Clock_Slow(void)
+{
+    uint16_t brr = (uint16_t)USART1->BRR;
+
+    /* AHB 分频不为 1 时必须开着预取缓冲（RM0008 3.3.3） */
+    if (g_slow || brr < 32u || (FLASH->ACR & FLASH_ACR_PRFTBS) == 0)
+    {
+        g_skipped++;
+        return 0;
+    }
+
+    g_brr = brr;
+    cfgr_set(RCC_CFGR_HPRE, CFGR_SLOW_HPRE);
+    cfgr_set(RCC_CFGR_PPRE1, CFGR_SLOW_PPRE1);
+    USART1->BRR = (uint16_t)((brr + 1u) / 2u);
+    systick_rescale((SysTick->LOAD + 1u) / 2u);
+
+    g_slow = 1;
+    g_switches++;
+    return 1;
+}
+
+void PDM_Clock_Fast(void)
+{
+    if (!g_slow)
+    {
+        return;
+    }
+
+    cfgr_set(RCC_CFGR_PPRE1, CFGR_FAST_PPRE1);
+    cfgr_set(RCC_CFGR_HPRE, CFGR_FAST_HPRE);
+    USART1->BRR = g_brr;
+    systick_rescale((SysTick->LOAD + 1u) * 2u);
+    g_slow = 0;
+}
+
+void PDM_Clock_AddSlowUs(uint32_t us)
+{
+    g_slow_us += us;
+}
+
+void PDM_Clock_Print(void)
+{
+    uint32_t now = HAL_GetTick();
+    uint32_t window_ms = now - g_last_ms;
+    uint64_t slow_us = g_slow_us - g_last_slow_us;
+    uint32_t pm = 0;                    /* 千分比 */
+
+    if (window_ms != 0)
+    {
+        pm = (uint32_t)(slow_us / window_ms);
+        if (pm > 1000u)
+        {
+            pm = 1000u;
+        }
+    }
+    PDM_Log_Printf("clock 36 MHz %lu.%lu%% of %lu ms, %lu switches, %lu skipped\r\n",
+                   (unsigned long)(pm / 10u), (unsigned long)(pm % 10u), (unsigned long)window_ms,
+                   (unsigned long)g_switches, (unsigned long)g_skipped);
+    PDM_Log_Printf("estimated saving %lu uA (%lu uA while slow)\r\n",
+                   (unsigned long)((uint64_t)PDM_CFG_CLOCK_SAVE_UA * pm / 1000u),
+                   (unsigned long)PDM_CFG_CLOCK_SAVE_UA);
+    g_last_ms = now;
+    g_last_slow_us = g_slow_us;
+}
+
+#endif /* PDM_CFG_CLOCK_SCALE */
@@ -0,0 +1,293 @@
+#include "pdm_cmd.h"
+#include "pdm_blackbox.h"
+#include "pdm_boot.h"
+#include "pdm_cal.h"
+#include "pdm_can.h"
+#include "pdm_decim.h"
+#include "pdm_filter.h"
+#include "pdm_hist.h"
+#include "pdm_isotp.h"
+#include "pdm_lap.h"
+#include "pdm_monitor.h"
+#include "pdm_node.h"
+#include "pdm_param.h"
+#include "pdm_ping.h"
+#include "pdm_replay.h"
+#include "pdm_report.h"
+#include "pdm_timesync.h"
+#include "pdm_trip.h"
+#include "pdm_xcp.h"
+#include "stm32f1xx_hal.h"
+#include <string.h>
+
+static uint16_t get_u16(const uint8_t *p)
+{
+    return (uint16_t)(((uint16_t)p[0] << 8) | p[1]);
+}
+
+uint8_t PDM_Cmd_Exec(const uint8_t *data, uint8_t len)
+{
+    switch (data[0])
+    {
+    case PDM_CMD_RESET_ENERGY:
+        if (len < 2)
+        {
+            return PDM_CMD_ERR_ARG;
+        }
+        PDM_Monitor_ResetEnergy(data[1]);
+        return PDM_CMD_OK;
+
+    case PDM_CMD_SET_SAMPLE:
+        if (len < 3)
+        {
+            return PDM_CMD_ERR_ARG;
+        }
+        return PDM_Monitor_SetSamplePeriod(get_u16(&data[1])) == 0 ? PDM_CMD_OK : PDM_CMD_ERR_ARG;
+
+    case PDM_CMD_SET_CAN_PERIOD:
+        if (len < 6)
+        {
+            return PDM_CMD_ERR_ARG;
+        }
+        return PDM_Can_SetSchedule(get_u16(&data[1]), get_u16(&data[3]), data[5] != 0) == 0 ?
+               PDM_CMD_OK : PDM_CMD_ERR_ARG;
+
+    case PDM_CMD_CAPTURE:
+        return PDM_Monitor_StartCapture() == 0 ? PDM_CMD_OK : PDM_CMD_ERR_ARG;
+
+    case PDM_CMD_FAST:
+        if (len < 2 || data[1] > 1)
+        {
+            return PDM_CMD_ERR_ARG;
+        }
+        return PDM_Monitor_FastStream(data[1]) == 0 ? PDM_CMD_OK : PDM_CMD_ERR_ARG;
+
+    case PDM_CMD_LAP:
+        if (len > 1 && data[1] > 1)
+        {
+            return PDM_CMD_ERR_ARG;
+        }
+        PDM_Report_Lap((len > 1) ? data[1] : 0);
+        return PDM_CMD_OK;
+
+#if PDM_CFG_BLACKBOX
+    case PDM_CMD_BLACKBOX:
+        if (len < 2 || data[1] > 1)
+        {
+            return PDM_CMD_ERR_ARG;
+        }
+        if (data[1] == 0)
+        {
+            PDM_Blackbox_Freeze(PDM_BB_REASON_MANUAL);
+        }
+        else
+        {
+            PDM_Blackbox_Restart();
+        }
+        return PDM_CMD_OK;
+#endif
+
+#if PDM_CFG_FILTER
+    case PDM_CMD_SET_FILTER:
+        if (len < 5)
+        {
+            return PDM_CMD_ERR_ARG;
+        }
+        return PDM_Filter_Set(data[1], get_u16(&data[2]), data[4]) == 0 ? PDM_CMD_OK : PDM_CMD_ERR_ARG;
+#endif
+
+#if PDM_CFG_HIST
+    case PDM_CMD_RESET_HIST:
+        if (len < 2)
+        {
+            return PDM_CMD_ERR_ARG;
+        }
+        PDM_Hist_Reset(data[1]);
+        return PDM_CMD_OK;
+#endif
+
+    case PDM_CMD_PARAM:
+        if (len < 2)
+        {
+            return PDM_CMD_ERR_ARG;
+        }
+        switch (data[1])
+        {
+        case PDM_PARAM_OP_SET:
+            if (len < 7)
+            {
+                return PDM_CMD_ERR_ARG;
+            }
+            return PDM_Param_Set(data[2], ((uint32_t)get_u16(&data[3]) << 16) | get_u16(&data[5])) == 0 ?
+                   PDM_CMD_OK : PDM_CMD_ERR_ARG;
+        case PDM_PARAM_OP_SAVE:
+            return PDM_Param_Save() == 0 ? PDM_CMD_OK : PDM_CMD_ERR_ARG;
+        case PDM_PARAM_OP_DEFAULTS:
+            PDM_Param_Defaults();
+            return PDM_CMD_OK;
+        case PDM_PARAM_OP_LOAD:
+            return PDM_Param_Reload() == 0 ? PDM_CMD_OK : PDM_CMD_ERR_ARG;
+        default:
+            return PDM_CMD_ERR_ARG;
+        }
+
+#if PDM_CFG_CAL
+    case PDM_CMD_CAL:
+        if (len < 3 || (data[2] == PDM_CAL_REF && len < 7))
+        {
+            return PDM_CMD_ERR_ARG;
+        }
+        return PDM_Cal_Start(data[1], data[2], (int32_t)(((uint32_t)get_u16(&data[3]) << 16) | get_u16(&data[5]))) == 0 ?
+               PDM_CMD_OK : PDM_CMD_ERR_ARG;
+#endif
+
+#if PDM_CFG_TRIP
+    case PDM_CMD_TRIP_RESET:
+        if (len < 2)
+        {
+            return PDM_CMD_ERR_ARG;
+        }
+        return PDM_Trip_Reset(data[1]) == 0 ? PDM_CMD_OK : PDM_CMD_ERR_ARG;
+#endif
+
+#if PDM_CFG_DECIM
+    case PDM_CMD_SET_DECIM:
+        if (len < 3)
+        {
+            return PDM_CMD_ERR_ARG;
+        }
+        return PDM_Decim_Set(data[1], data[2]) == 0 ? PDM_CMD_OK : PDM_CMD_ERR_ARG;
+#endif
+
+#if PDM_CFG_BOOT
+    case PDM_CMD_BOOT:
+        if (len < 3 || get_u16(&data[1]) != PDM_BOOT_REQ_MAGIC)
+        {
+            return PDM_CMD_ERR_ARG;
+        }
+        PDM_Boot_Request();
+        return PDM_CMD_OK;
+#endif
+
+    default:
+        return PDM_CMD_ERR_UNKNOWN;
+    }
+}
+
+/* 接收的 ID（节点 0 的 ID）：node 为 1 时加上本节点的偏移，为 0 时是所有节点共用的 VCU 广播。
+ * 增加接收的报文时在这里加一项，并在 PDM_Cmd_Poll() 中分发 */
+typedef struct {
+    uint16_t id;
+    uint8_t node;
+} rx_id_t;
+
+static const rx_id_t g_rx_ids[] = {
+    { PDM_CMD_CAN_ID, 1 },
+#if PDM_CFG_XCP
+    { PDM_CFG_XCP_RX_ID, 1 },
+#endif
+#if PDM_CFG_ISOTP
+    { PDM_CFG_ISOTP_RX_ID, 1 },         /* 请求和流控帧 */
+#endif
+#if PDM_CFG_PING
+    { PDM_CFG_PING_ID, 1 },
+#endif
+#if PDM_CFG_REPLAY
+    { PDM_CFG_REPLAY_ID, 1 },
+#endif
+#if PDM_CFG_LAP && PDM_CFG_LAP_TRIGGER_ID
+    { PDM_CFG_LAP_TRIGGER_ID, 0 },
+#endif
+#if PDM_CFG_TIMESYNC
+    { PDM_CFG_TIMESYNC_ID, 0 },         /* SYNC/FUP */
+#endif
+#if PDM_CFG_NODE
+    { PDM_CFG_NODE_DISCOVER_ID, 0 },
+#endif
+};
+
+#define RX_ID_COUNT     (sizeof(g_rx_ids) / sizeof(g_rx_ids[0]))
+
+_Static_assert(RX_ID_COUNT <= PDM_CAN_FILTER_BANKS * PDM_CAN_FILTER_PER_BANK, "too many CAN RX IDs for the filter banks");
+
+void PDM_Cmd_Init(void)
+{
+    uint16_t ids[RX_ID_COUNT];
+
+    for (uint8_t i = 0; i < RX_ID_COUNT; i++)
+    {
+        ids[i] = (uint16_t)(g_rx_ids[i].node ? PDM_Node_TxId(g_rx_ids[i].id) : g_rx_ids[i].id);
+    }
+    (void)PDM_Can_SetRxFilter(ids, (uint8_t)RX_ID_COUNT);
+}
+
+void PDM_Cmd_Poll(void)
+{
+    pdm_can_frame_t f;
+    uint8_t reply[2];
+
+    while (PDM_Can_Read(&f) == 0)
+    {
+#if PDM_CFG_PING
+        if (f.id == PDM_CFG_PING_ID)
+        {
+            PDM_Ping_Rx(&f);
+            continue;
+        }
+#endif
+#if PDM_CFG_XCP
+        if (f.id == PDM_CFG_XCP_RX_ID)
+        {
+            PDM_Xcp_Rx(f.data, f.dlc);
+            continue;
+        }
+#endif
+#if PDM_CFG_ISOTP
+        if (f.id == PDM_CFG_ISOTP_RX_ID)
+        {
+            PDM_Isotp_Rx(f.data, f.dlc);
+            continue;
+        }
+#endif
+#if PDM_CFG_LAP && PDM_CFG_LAP_TRIGGER_ID
+        if (f.id == PDM_CFG_LAP_TRIGGER_ID)
+        {
+            /* 计圈报文：内容不解析，停车区内重复触发在 PDM_CFG_LAP_MIN_MS 内忽略 */
+            if (PDM_Lap_Due(HAL_GetTick()))
+            {
+                PDM_Report_Lap(PDM_LAP_LAP);
+            }
+            continue;
+        }
+#endif
+#if PDM_CFG_TIMESYNC
+        if (f.id == PDM_CFG_TIMESYNC_ID)
+        {
+            PDM_TimeSync_Rx(&f);
+            continue;
+        }
+#endif
+#if PDM_CFG_REPLAY
+        if (f.id == PDM_CFG_REPLAY_ID)
+        {
+            PDM_Replay_Rx(f.data, f.dlc);
+            continue;
+        }
+#endif
+#if PDM_CFG_NODE
+        if (f.id == PDM_CFG_NODE_DISCOVER_ID)
+        {
+            PDM_Node_Discover();
+            continue;
+        }
+#endif
+        if (f.id != PDM_CMD_CAN_ID || f.dlc == 0)
+        {
+            continue;
+        }
+
+        reply[0] = f.data[0];
+        reply[1] = PDM_Cmd_Exec(f.data, f.dlc);
+        (void)PDM_Can_Send(PDM_CMD_REPLY_ID, reply, sizeof(reply));
+    }
+}
@@ -0,0 +1,215 @@
+#include "pdm_crash.h"
+
+#if PDM_CFG_CRASH
+
+#include "pdm_calc.h"
+#include "pdm_can.h"
+#include "pdm_log.h"
+#include "pdm_sched.h"
+#include "stm32f1xx_hal.h"
+#include <stddef.h>
+#include <string.h>
+
+#define CRASH_MAGIC_NEW     0x43524153u     /* "CRAS"：复位后还没有发送 */
+#define CRASH_MAGIC_SEEN    0x43524144u     /* 已经发送过，保留给命令行 */
+
+/* 与黑匣子相同放在 .noinit，热复位后保留 */
+typedef struct {
+    uint32_t magic;
+    uint16_t crc;                       /* rec 的 CRC16 */
+    pdm_crash_t rec;
+} crash_nv_t;
+
+static crash_nv_t g_nv __attribute__((section(".noinit")));
+
+volatile uint8_t g_pdm_crash_task = PDM_CRASH_NO_TASK;
+uint8_t g_pdm_crash_trace[PDM_CRASH_TRACE] = { [0 ... PDM_CRASH_TRACE - 1] = PDM_CRASH_NO_TASK };
+uint8_t g_pdm_crash_pos;
+
+static uint8_t g_have;                  /* g_nv.rec 有效 */
+static uint8_t g_page = PDM_CRASH_PAGES;    /* 下一个要发送的页，PDM_CRASH_PAGES 为不发送 */
+
+extern uint32_t _estack;
+
+static uint8_t nv_valid(void)
+{
+    return (g_nv.magic == CRASH_MAGIC_NEW || g_nv.magic == CRASH_MAGIC_SEEN) &&
+           g_nv.crc == pdm_calc_crc16((const uint8_t *)&g_nv.rec, sizeof(g_nv.rec));
+}
+
+/* --- 公共部分：次数、任务、记录和故障寄存器；写完后复位 --- */
+static void __attribute__((noreturn)) crash_save(pdm_crash_t *r, uint8_t type)
+{
+    uint8_t count = nv_valid() ? g_nv.rec.count : 0;
+    uint8_t pos = g_pdm_crash_pos;
+
+    r->type = type;
+    r->task = g_pdm_crash_task;
+    r->count = (count < 0xFF) ? (uint8_t)(count + 1u) : count;
+    for (uint8_t k = 0; k < PDM_CRASH_TRACE; k++)
+    {
+        pos = (pos == 0) ? (uint8_t)(PDM_CRASH_TRACE - 1) : (uint8_t)(pos - 1);
+        r->trace[k] = g_pdm_crash_trace[pos];
+    }
+    r->v[PDM_CRASH_V_TICK] = HAL_GetTick();
+    r->v[PDM_CRASH_V_CFSR] = SCB->CFSR;
+    r->v[PDM_CRASH_V_HFSR] = SCB->HFSR;
+    r->v[PDM_CRASH_V_BFAR] = SCB->BFAR;
+    r->v[PDM_CRASH_V_MMFAR] = SCB->MMFAR;
+
+    g_nv.rec = *r;
+    g_nv.crc = pdm_calc_crc16((const uint8_t *)&g_nv.rec, sizeof(g_nv.rec));
+    g_nv.magic = CRASH_MAGIC_NEW;
+
+    if (CoreDebug->DHCSR & CoreDebug_DHCSR_C_DEBUGEN_Msk)
+    {
+        __BKPT(0);
+    }
+    NVIC_SystemReset();
+}
+
+void PDM_Crash_Fault(const uint32_t *frame, uint32_t exc_return)
+{
+    pdm_crash_t r;
+    uint32_t addr = (uint32_t)frame;
+
+    __disable_irq();
+    memset(&r, 0, sizeof(r));
+    r.v[PDM_CRASH_V_EXC_RETURN] = exc_return;
+    r.v[PDM_CRASH_V_SP] = addr;
+    /* 栈指针不在 RAM 中时不读栈帧，只记录 SP */
+    if ((addr & 3u) == 0 && addr >= SRAM_BASE && addr <= (uint32_t)&_estack - 32u)
+    {
+        for (uint8_t k = 0; k < 5; k++)
+        {
+            r.v[PDM_CRASH_V_R0 + k] = frame[k];     /* r0 r1 r2 r3 r12 */
+        }
+        r.v[PDM_CRASH_V_LR] = frame[5];
+        r.v[PDM_CRASH_V_PC] = frame[6];
+        r.v[PDM_CRASH_V_XPSR] = frame[7];
+        /* 异常前的 SP：栈帧 8 个字，xPSR 第 9 位表示进入时为对齐补了一个字 */
+        r.v[PDM_CRASH_V_SP] = addr + 32u + ((frame[7] & (1u << 9)) ? 4u : 0u);
+    }
+    crash_save(&r, PDM_CRASH_HARDFAULT);
+}
+
+void PDM_Crash_Error(uint8_t type, uint32_t pc)
+{
+    pdm_crash_t r;
+
+    __disable_irq();
+    memset(&r, 0, sizeof(r));
+    r.v[PDM_CRASH_V_PC] = pc;
+    r.v[PDM_CRASH_V_SP] = __get_MSP();
+    r.v[PDM_CRASH_V_XPSR] = __get_xPSR();
+    crash_save(&r, type);
+}
+
+uint8_t PDM_Crash_Init(void)
+{
+    g_have = nv_valid();
+    if (!g_have)
+    {
+        g_nv.magic = 0;
+        return 0;
+    }
+    if (g_nv.magic != CRASH_MAGIC_NEW)
+    {
+        return 0;
+    }
+    g_nv.magic = CRASH_MAGIC_SEEN;   /* 之后的复位不再发送 */
+    g_page = 0;
+    return 1;
+}
+
+void PDM_Crash_Poll(void)
+{
+    const pdm_crash_t *r = &g_nv.rec;
+    uint8_t data[8];
+
+    if (g_page >= PDM_CRASH_PAGES)
+    {
+        return;
+    }
+
+    data[0] = g_page;
+    data[1] = r->type;
+    if (g_page < PDM_CRASH_VALUES)
+    {
+        uint32_t v = r->v[g_page];
+
+        data[2] = (uint8_t)(v >> 24);
+        data[3] = (uint8_t)(v >> 16);
+        data[4] = (uint8_t)(v >> 8);
+        data[5] = (uint8_t)(v & 0xFF);
+        data[6] = r->task;
+        data[7] = r->count;
+    }
+    else
+    {
+        uint8_t first = (uint8_t)((g_page - PDM_CRASH_VALUES) * 6u);
+
+        for (uint8_t k = 0; k < 6; k++)
+        {
+            data[2 + k] = (first + k < PDM_CRASH_TRACE) ? r->trace[first + k] : PDM_CRASH_NO_TASK;
+        }
+    }
+    /* 队列满时下次再发同一页 */
+    if (PDM_Can_Send(PDM_CRASH_CAN_ID, data, sizeof(data)) == 0)
+    {
+        g_page++;
+    }
+}
+
+const pdm_crash_t *PDM_Crash_Last(void)
+{
+    return g_have ? &g_nv.rec : NULL;
+}
+
+void PDM_Crash_Clear(void)
+{
+    g_have = 0;
+    g_page = PDM_CRASH_PAGES;
+    g_nv.magic = 0;
+}
+
+static const char *task_name(uint8_t task)
+{
+    const pdm_task_t *t = PDM_Sched_GetTask(task);
+
+    return (t != NULL) ? t->name : "-";
+}
+
+void PDM_Crash_Print(void)
+{
+    static const char *const types[] = { "?", "hardfault", "nmi", "error handler" };
+    const pdm_crash_t *r = PDM_Crash_Last();
+
+    if (r == NULL)
+    {
+        PDM_Log_Printf("no crash since power-on\r\n");
+        return;
+    }
+    PDM_Log_Printf("crash %u: %s at %lu ms, task %s%s\r\n", r->count,
+                   types[(r->type < 4u) ? r->type : 0], (unsigned long)r->v[PDM_CRASH_V_TICK],
+                   task_name(r->task), (r->v[PDM_CRASH_V_XPSR] & 0x1FFu) ? " (in interrupt)" : "");
+    PDM_Log_Printf("pc %08lX lr %08lX sp %08lX xpsr %08lX exc %08lX\r\n",
+                   (unsigned long)r->v[PDM_CRASH_V_PC], (unsigned long)r->v[PDM_CRASH_V_LR],
+                   (unsigned long)r->v[PDM_CRASH_V_SP], (unsigned long)r->v[PDM_CRASH_V_XPSR],
+                   (unsigned long)r->v[PDM_CRASH_V_EXC_RETURN]);
+    PDM_Log_Printf("r0 %08lX r1 %08lX r2 %08lX r3 %08lX r12 %08lX\r\n",
+                   (unsigned long)r->v[PDM_CRASH_V_R0], (unsigned long)r->v[PDM_CRASH_V_R0 + 1],
+                   (unsigned long)r->v[PDM_CRASH_V_R0 + 2], (unsigned long)r->v[PDM_CRASH_V_R0 + 3],
+                   (unsigned long)r->v[PDM_CRASH_V_R0 + 4]);
+    PDM_Log_Printf("cfsr %08lX hfsr %08lX bfar %08lX mmfar %08lX\r\n",
+                   (unsigned long)r->v[PDM_CRASH_V_CFSR], (unsigned long)r->v[PDM_CRASH_V_HFSR],
+                   (unsigned long)r->v[PDM_CRASH_V_BFAR], (unsigned long)r->v[PDM_CRASH_V_MMFAR]);
+    PDM_Log_Printf("recent tasks:");
+    for (uint8_t k = 0; k < PDM_CRASH_TRACE && r->trace[k] != PDM_CRASH_NO_TASK; k++)
+    {
+        PDM_Log_Printf(" %s", task_name(r->trace[k]));
+    }
+    PDM_Log_Printf("\r\n");
+}
+
+#endif /* PDM_CFG_CRASH */
@@ -0,0 +1,165 @@
+#include "pdm_decim.h"
+
+#if PDM_CFG_DECIM
+
+#include "pdm_log.h"
+#include "stm32f1xx_hal.h"
+
+#if PDM_CFG_DECIM_SHIFT > PDM_DECIM_MAX_SHIFT
+#error "PDM_CFG_DECIM_SHIFT must be 0..8"
+#endif
+
+#define OUT_FRAC_BITS   8       /* 输出的小数位 */
+
+typedef struct {
+    uint8_t shift;              /* 一组 2^shift 个采样，0 关闭 */
+    uint16_t n;                 /* 本组已加入的采样数 */
+    int32_t sum;
+    volatile int32_t out_q8;    /* 最近一次输出 */
+    volatile uint32_t outputs;  /* 输出次数，0 表示还没有输出 */
+    const pdm_scale_t *sc;
+} ch_decim_t;
+
+static ch_decim_t g_decim[PDM_CFG_CHANNELS];
+static uint8_t g_tx_ch;         /* CAN 帧下一次从这个通道开始找 */
+
+static void decim_clear(ch_decim_t *d)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    /* 采集和命令在 FreeRTOS 版本中是不同的任务，清除时不能插入一次 Add */
+    __disable_irq();
+    d->n = 0;
+    d->sum = 0;
+    d->outputs = 0;
+    __set_PRIMASK(primask);
+}
+
+void PDM_Decim_Init(uint8_t ch, const pdm_scale_t *sc)
+{
+    if (ch >= PDM_CFG_CHANNELS)
+    {
+        return;
+    }
+    g_decim[ch].sc = sc;
+    g_decim[ch].shift = ((PDM_CFG_DECIM_MASK >> ch) & 1u) ? PDM_CFG_DECIM_SHIFT : 0;
+    decim_clear(&g_decim[ch]);
+}
+
+void PDM_Decim_Reset(uint8_t ch)
+{
+    if (ch < PDM_CFG_CHANNELS)
+    {
+        decim_clear(&g_decim[ch]);
+    }
+}
+
+uint8_t PDM_Decim_Set(uint8_t ch, uint8_t shift)
+{
+    if (ch >= PDM_CFG_CHANNELS || shift > PDM_DECIM_MAX_SHIFT)
+    {
+        return 1;
+    }
+    g_decim[ch].shift = shift;
+    decim_clear(&g_decim[ch]);
+    return 0;
+}
+
+void PDM_Decim_Add(uint8_t ch, int16_t shunt)
+{
+    ch_decim_t *d;
+
+    if (ch >= PDM_CFG_CHANNELS || g_decim[ch].shift == 0)
+    {
+        return;
+    }
+    d = &g_decim[ch];
+    d->sum += shunt;
+    if (++d->n < (1u << d->shift))
+    {
+        return;
+    }
+    /* 和的绝对值最多 32768 x 256，左移到 Q8 后仍在 int32 范围内 */
+    d->out_q8 = d->sum * (int32_t)(1u << (OUT_FRAC_BITS - d->shift));
+    d->outputs++;
+    d->sum = 0;
+    d->n = 0;
+}
+
+uint8_t PDM_Decim_Get(uint8_t ch, int32_t *shunt_q8, int32_t *current_ua)
+{
+    const ch_decim_t *d;
+    int32_t q8;
+
+    if (ch >= PDM_CFG_CHANNELS || g_decim[ch].shift == 0 || g_decim[ch].outputs == 0)
+    {
+        return 1;
+    }
+    d = &g_decim[ch];
+    q8 = d->out_q8;
+    if (shunt_q8 != NULL)
+    {
+        *shunt_q8 = q8;
+    }
+    if (current_ua != NULL)
+    {
+        /* nV / uOhm = mA，再乘 1000 得 uA */
+        *current_ua = (int32_t)((int64_t)q8 * (PDM_SHUNT_NV_PER_LSB * 1000) /
+                                ((int64_t)d->sc->shunt_uohm << OUT_FRAC_BITS));
+    }
+    return 0;
+}
+
+void PDM_Decim_Encode(uint8_t *data, const void *arg)
+{
+    int32_t ua = 0;
+    uint8_t ch = g_tx_ch;
+
+    (void)arg;
+    /* 从上次的下一个通道开始找打开抽取的通道，都没有时发通道 g_tx_ch、无效 */
+    for (uint8_t k = 0; k < PDM_CFG_CHANNELS; k++)
+    {
+        uint8_t c = (uint8_t)((g_tx_ch + k) % PDM_CFG_CHANNELS);
+
+        if (g_decim[c].shift != 0)
+        {
+            ch = c;
+            break;
+        }
+    }
+    g_tx_ch = (uint8_t)((ch + 1u) % PDM_CFG_CHANNELS);
+
+    data[0] = ch;
+    data[1] = g_decim[ch].shift;
+    data[2] = (uint8_t)g_decim[ch].outputs;
+    data[3] = (uint8_t)(PDM_Decim_Get(ch, NULL, &ua) == 0);
+    data[4] = (uint8_t)((uint32_t)ua >> 24);
+    data[5] = (uint8_t)((uint32_t)ua >> 16);
+    data[6] = (uint8_t)((uint32_t)ua >> 8);
+    data[7] = (uint8_t)ua;
+}
+
+void PDM_Decim_Print(void)
+{
+    for (uint8_t ch = 0; ch < PDM_CFG_CHANNELS; ch++)
+    {
+        const ch_decim_t *d = &g_decim[ch];
+        int32_t q8 = 0;
+        int32_t ua = 0;
+
+        if (d->sc == NULL)
+        {
+            continue;
+        }
+        if (PDM_Decim_Get(ch, &q8, &ua) != 0)
+        {
+            PDM_Log_Printf("decim ch%u n %u outputs %lu\r\n", ch, (unsigned)(d->shift ? (1u << d->shift) : 0u),
+                           (unsigned long)d->outputs);
+            continue;
+        }
+        PDM_Log_Printf("decim ch%u n %u outputs %lu shunt %ld/256 LSB current %ld uA\r\n", ch,
+                       (unsigned)(1u << d->shift), (unsigned long)d->outputs, (long)q8, (long)ua);
+    }
+}
+
+#endif /* PDM_CFG_DECIM */
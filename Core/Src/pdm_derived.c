@@ -0,0 +1,83 @@
+#include "pdm_derived.h"
+
+#if PDM_CFG_DERIVED
+
+#include "pdm_calc.h"
+#include "pdm_signals.h"
+#include <string.h>
+
+#define SHARE_MIN_UA    100000  /* 总线电流低于 100 mA 时不计算占比 */
+
+typedef struct {
+    int64_t bus_uA;
+    int64_t bat_uA;
+    int64_t dcdc_uW;
+    int64_t bus_uW;
+    int64_t loss_uW;
+    uint32_t n;
+} derived_sum_t;
+
+static derived_sum_t g_sum;
+
+void PDM_Derived_Add(int32_t bus_mV, int32_t bus_uA, int32_t bat_mV, int32_t bat_uA)
+{
+    int32_t dcdc_uA = bus_uA - bat_uA;
+
+    g_sum.bus_uA += bus_uA;
+    g_sum.bat_uA += bat_uA;
+    g_sum.dcdc_uW += (int64_t)bus_mV * dcdc_uA / 1000;
+    g_sum.bus_uW += (int64_t)bus_mV * bus_uA / 1000;
+    if (bat_uA > 0)
+    {
+        g_sum.loss_uW += (int64_t)(bat_mV - bus_mV) * bat_uA / 1000;
+    }
+    g_sum.n++;
+}
+
+static void put_be16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)(v >> 8);
+    p[1] = (uint8_t)(v & 0xFF);
+}
+
+void PDM_Derived_Encode(uint8_t *data, const void *arg)
+{
+    int64_t n = g_sum.n;
+    int16_t dcdc_i = 0x7FFF, dcdc_p = 0x7FFF;
+    uint16_t loss = 0xFFFF;
+    uint8_t share = 0xFF, loss_pm = 0xFF;
+
+    (void)arg;
+    if (n != 0)
+    {
+        int64_t loss_uW = (g_sum.loss_uW > 0) ? g_sum.loss_uW : 0;      /* 两片电压测量误差可能使压降为负 */
+        int64_t in_uW = g_sum.bus_uW + loss_uW;
+
+        dcdc_i = pdm_calc_sat_i16((int32_t)((g_sum.bus_uA - g_sum.bat_uA) / n / PDM_CAN_CURRENT_UA_PER_LSB));
+        dcdc_p = pdm_calc_sat_i16((int32_t)(g_sum.dcdc_uW / n / PDM_CAN_POWER_UW_PER_LSB));
+        loss = pdm_calc_sat_u16((uint32_t)(loss_uW / n / 1000));
+        /* 占比用和之比（按电流加权），不是各采样比值的平均 */
+        if (g_sum.bus_uA >= SHARE_MIN_UA * n)
+        {
+            int64_t s = g_sum.bat_uA * 200 / g_sum.bus_uA;
+
+            share = (uint8_t)((s < 0) ? 0 : (s > 200) ? 200 : s);
+            if (in_uW > 0)
+            {
+                int64_t pm = loss_uW * 1000 / in_uW;
+
+                loss_pm = (uint8_t)((pm > 254) ? 254 : pm);
+            }
+        }
+    }
+
+    put_be16(&data[0], (uint16_t)dcdc_i);
+    put_be16(&data[2], (uint16_t)dcdc_p);
+    put_be16(&data[4], loss);
+    data[6] = share;
+    data[7] = loss_pm;
+
+    memset(&g_sum, 0, sizeof(g_sum));
+}
+
+#endif /* PDM_CFG_DERIVED */
@@ -0,0 +1,120 @@
+#include "pdm_diag.h"
+#include "pdm_log.h"
+#include "stm32f1xx_hal.h"
+#include <string.h>
+
+typedef struct {
+    const char *msg;            /* NULL: 空项 */
+    uint8_t addr;
+    uint32_t count;
+    uint32_t shown;             /* 已输出的次数（级别 1） */
+    uint32_t last_ms;
+} diag_ev_t;
+
+static diag_ev_t g_ev[PDM_CFG_DIAG_EVENTS];
+static uint32_t g_overflow;     /* 表满时没有记下的次数 */
+#if PDM_CFG_DIAG_LEVEL == 1
+static uint8_t g_next;          /* 下一次输出从这一项开始，各项轮流 */
+#endif
+
+/* --- 信息长度，不含末尾的换行 --- */
+static int msg_len(const char *msg)
+{
+    size_t n = strlen(msg);
+
+    while (n > 0 && (msg[n - 1] == '\n' || msg[n - 1] == '\r'))
+    {
+        n--;
+    }
+    return (int)n;
+}
+
+void PDM_Diag_Note(uint8_t addr, const char *msg)
+{
+    uint32_t primask = __get_PRIMASK();
+    diag_ev_t *free_ev = NULL;
+    uint32_t now = HAL_GetTick();
+
+    __disable_irq();
+    for (uint8_t i = 0; i < PDM_CFG_DIAG_EVENTS; i++)
+    {
+        diag_ev_t *e = &g_ev[i];
+
+        if (e->msg == msg && e->addr == addr)
+        {
+            e->count++;
+            e->last_ms = now;
+            __set_PRIMASK(primask);
+            return;
+        }
+        if (e->msg == NULL && free_ev == NULL)
+        {
+            free_ev = e;
+        }
+    }
+    if (free_ev != NULL)
+    {
+        free_ev->msg = msg;
+        free_ev->addr = addr;
+        free_ev->count = 1;
+        free_ev->shown = 0;
+        free_ev->last_ms = now;
+    }
+    else
+    {
+        g_overflow++;
+    }
+    __set_PRIMASK(primask);
+}
+
+void PDM_Diag_Poll(void)
+{
+#if PDM_CFG_DIAG_LEVEL == 1
+    uint8_t start = g_next;
+    uint8_t lines = 0;
+
+    for (uint8_t k = 0; k < PDM_CFG_DIAG_EVENTS && lines < PDM_CFG_DIAG_LINES; k++)
+    {
+        uint8_t idx = (uint8_t)((start + k) % PDM_CFG_DIAG_EVENTS);
+        diag_ev_t *e = &g_ev[idx];
+        uint32_t count = e->count;
+
+        if (e->msg == NULL || count == e->shown)
+        {
+            continue;
+        }
+        PDM_Log_Printf("[0x%02X] %.*s x%lu (total %lu)\r\n", e->addr, msg_len(e->msg), e->msg,
+                       (unsigned long)(count - e->shown), (unsigned long)count);
+        e->shown = count;
+        lines++;
+        g_next = (uint8_t)((idx + 1u) % PDM_CFG_DIAG_EVENTS);
+    }
+#endif
+}
+
+void PDM_Diag_Clear(void)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    memset(g_ev, 0, sizeof(g_ev));
+    g_overflow = 0;
+    __set_PRIMASK(primask);
+}
+
+void PDM_Diag_Print(void)
+{
+    uint32_t now = HAL_GetTick();
+
+    PDM_Log_Printf("diag level %u overflow %lu\r\n", (unsigned)PDM_CFG_DIAG_LEVEL, (unsigned long)g_overflow);
+    for (uint8_t i = 0; i < PDM_CFG_DIAG_EVENTS; i++)
+    {
+        const diag_ev_t *e = &g_ev[i];
+
+        if (e->msg != NULL)
+        {
+            PDM_Log_Printf("[0x%02X] %.*s x%lu, %lu ms ago\r\n", e->addr, msg_len(e->msg), e->msg,
+                           (unsigned long)e->count, (unsigned long)(now - e->last_ms));
+        }
+    }
+}
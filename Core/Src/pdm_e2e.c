@@ -0,0 +1,38 @@
+#include "pdm_e2e.h"
+
+#if PDM_CFG_E2E
+
+#include "stm32f1xx_hal.h"
+
+void PDM_E2E_Init(void)
+{
+    __HAL_RCC_CRC_CLK_ENABLE();
+}
+
+static uint32_t get_be32(const uint8_t *p)
+{
+    return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+}
+
+void PDM_E2E_Protect(uint32_t id, uint8_t *alive, uint8_t *data)
+{
+    uint32_t primask;
+    uint32_t crc;
+
+    data[6] = (uint8_t)((data[6] & 0xF0u) | (*alive & 0x0Fu));
+    *alive = (uint8_t)((*alive + 1u) & 0x0Fu);
+
+    /* 每个字写入 DR 后 CRC 外设用 4 个 AHB 周期算完，读 DR 时自动等待 */
+    primask = __get_PRIMASK();
+    __disable_irq();
+    CRC->CR = CRC_CR_RESET;
+    CRC->DR = id;
+    CRC->DR = get_be32(&data[0]);
+    CRC->DR = (uint32_t)data[4] << 24 | (uint32_t)data[5] << 16 | (uint32_t)data[6] << 8;
+    crc = CRC->DR;
+    __set_PRIMASK(primask);
+
+    data[7] = (uint8_t)(crc & 0xFFu);
+}
+
+#endif /* PDM_CFG_E2E */
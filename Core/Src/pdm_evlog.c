@@ -0,0 +1,394 @@
+#include "pdm_evlog.h"
+
+#if PDM_CFG_EVLOG
+
+#include "pdm_calc.h"
+#include "pdm_log.h"
+#include "pdm_param.h"
+#include "pdm_store.h"
+#include "stm32f1xx_hal.h"
+#include <stddef.h>
+#include <string.h>
+
+#if PDM_CFG_EVLOG_PAGES < 2
+#error "PDM_CFG_EVLOG_PAGES must be at least 2 (one page is erased while the other keeps the newest events)"
+#endif
+#if PDM_CFG_EVLOG_RAM < 1 || PDM_CFG_EVLOG_RAM > 255
+#error "PDM_CFG_EVLOG_RAM must be 1..255"
+#endif
+
+/* 记录区在参数区之前（STM32F103C8: 64 KB flash） */
+#define EV_BASE             (FLASH_BASE + 0x10000u - \
+                             (PDM_CFG_STORE_PAGES + PDM_PARAM_PAGES + PDM_CFG_EVLOG_PAGES) * PDM_STORE_PAGE_SIZE)
+#define EV_SLOTS_PAGE       (PDM_STORE_PAGE_SIZE / PDM_EVLOG_REC_SIZE)
+#define EV_SLOTS            (PDM_CFG_EVLOG_PAGES * EV_SLOTS_PAGE)
+#define EV_HALFWORDS        (PDM_EVLOG_REC_SIZE / 2u)
+#define EV_CRC_LEN          offsetof(pdm_event_t, crc)
+
+_Static_assert(sizeof(pdm_event_t) == PDM_EVLOG_REC_SIZE, "event record size");
+
+/* 程序镜像结束位置（链接脚本中的符号） */
+extern uint32_t _sidata;
+extern uint32_t _sdata;
+extern uint32_t _edata;
+
+static uint8_t g_ok;
+static uint16_t g_fl_slot;          /* flash 中最新一条的槽号 */
+static uint32_t g_fl_seq;           /* flash 中最新一条的序号，没有记录时为 0 */
+static uint16_t g_fl_n;             /* flash 中从最新一条往前连续可读的条数 */
+static uint16_t g_next;             /* 下一条写入的槽号 */
+static int16_t g_erase_page = -1;   /* 写入前必须擦除的页号 */
+
+/* 待写队列：中断中加入，主循环写入 flash 后取出；序号按 g_fl_seq 顺延，不存在队列中 */
+static pdm_event_t g_q[PDM_CFG_EVLOG_RAM];
+static uint8_t g_q_head;            /* 下一个加入位置 */
+static volatile uint8_t g_q_n;
+static uint32_t g_dropped;
+
+/* 下载范围 */
+static uint32_t g_lat_seq;
+static uint16_t g_lat_n;
+static pdm_event_t g_lat_rec;       /* 最近读出的一条，连续帧逐段取同一条时不重复查找 */
+static int32_t g_lat_k = -1;
+
+static const pdm_event_t *slot_rec(uint16_t slot)
+{
+    return (const pdm_event_t *)(EV_BASE + (uint32_t)slot * PDM_EVLOG_REC_SIZE);
+}
+
+static uint8_t slot_erased(uint16_t slot)
+{
+    const uint32_t *p = (const uint32_t *)slot_rec(slot);
+
+    return (uint8_t)(p[0] == 0xFFFFFFFFu && p[1] == 0xFFFFFFFFu && p[2] == 0xFFFFFFFFu && p[3] == 0xFFFFFFFFu);
+}
+
+static uint8_t page_erased(uint16_t page)
+{
+    for (uint16_t i = 0; i < EV_SLOTS_PAGE; i++)
+    {
+        if (!slot_erased((uint16_t)(page * EV_SLOTS_PAGE + i)))
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static uint16_t slot_back(uint16_t slot, uint32_t d)
+{
+    return (uint16_t)((slot + EV_SLOTS - d % EV_SLOTS) % EV_SLOTS);
+}
+
+/* --- 从最新一条往前数序号连续的记录（启动时和擦页后） --- */
+static void count_back(void)
+{
+    g_fl_n = 0;
+    if (g_fl_seq == 0)
+    {
+        return;
+    }
+    while (g_fl_n < EV_SLOTS && g_fl_n < g_fl_seq)
+    {
+        const pdm_event_t *r = slot_rec(slot_back(g_fl_slot, g_fl_n));
+
+        if (r->seq != g_fl_seq - g_fl_n || r->crc == 0xFFFFu)
+        {
+            break;
+        }
+        g_fl_n++;
+    }
+}
+
+/* --- 找到下一个可写的槽：进入没有擦除的页时先擦除，跳过写到一半的槽 --- */
+static void advance_next(void)
+{
+    for (uint16_t n = 0; n < EV_SLOTS; n++)
+    {
+        if (g_next % EV_SLOTS_PAGE == 0 && !page_erased((uint16_t)(g_next / EV_SLOTS_PAGE)))
+        {
+            g_erase_page = (int16_t)(g_next / EV_SLOTS_PAGE);
+            return;
+        }
+        if (slot_erased(g_next))
+        {
+            return;
+        }
+        g_next = (uint16_t)((g_next + 1u) % EV_SLOTS);
+    }
+}
+
+uint8_t PDM_Evlog_Init(void)
+{
+    uint32_t image_end = (uint32_t)&_sidata + ((uint32_t)&_edata - (uint32_t)&_sdata);
+    int16_t newest = -1;
+
+    g_ok = 0;
+    g_fl_seq = 0;
+    g_erase_page = -1;
+    if (image_end > EV_BASE)
+    {
+        return 1;
+    }
+
+    /* 只看序号和 CRC 字段找最新一条，CRC 在读出时校验 */
+    for (uint16_t i = 0; i < EV_SLOTS; i++)
+    {
+        const pdm_event_t *r = slot_rec(i);
+
+        if (r->crc != 0xFFFFu && r->seq != 0xFFFFFFFFu && r->seq != 0 &&
+            (newest < 0 || (int32_t)(r->seq - g_fl_seq) > 0))
+        {
+            newest = (int16_t)i;
+            g_fl_seq = r->seq;
+        }
+    }
+    g_fl_slot = (newest < 0) ? (uint16_t)(EV_SLOTS - 1u) : (uint16_t)newest;
+    count_back();
+
+    g_next = (uint16_t)((g_fl_slot + 1u) % EV_SLOTS);
+    g_ok = 1;
+    advance_next();
+    return 0;
+}
+
+void PDM_Evlog_Add(uint8_t type, uint8_t ch, uint16_t arg, uint16_t value)
+{
+    uint32_t tick = HAL_GetTick();
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    if (g_q_n >= PDM_CFG_EVLOG_RAM)
+    {
+        g_dropped++;
+    }
+    else
+    {
+        pdm_event_t *e = &g_q[g_q_head];
+
+        e->tick_ms = tick;
+        e->type = type;
+        e->ch = ch;
+        e->arg = arg;
+        e->value = value;
+        g_q_head = (uint8_t)((g_q_head + 1u) % PDM_CFG_EVLOG_RAM);
+        g_q_n++;
+    }
+    __set_PRIMASK(primask);
+}
+
+/* --- 待写队列中第 i 个（0 最旧），填好序号和 CRC；调用者已关中断 --- */
+static void queue_get(uint8_t i, pdm_event_t *out)
+{
+    *out = g_q[(g_q_head + PDM_CFG_EVLOG_RAM - g_q_n + i) % PDM_CFG_EVLOG_RAM];
+    out->seq = g_fl_seq + 1u + i;
+    out->crc = pdm_calc_crc16((const uint8_t *)out, EV_CRC_LEN);
+}
+
+void PDM_Evlog_Run(uint8_t erase_ok)
+{
+    pdm_event_t rec;
+    uint32_t primask;
+    uint32_t dst;
+    const uint16_t *src = (const uint16_t *)&rec;
+    uint8_t failed = 0;
+
+    if (!g_ok)
+    {
+        return;
+    }
+    if (g_erase_page >= 0)
+    {
+        FLASH_EraseInitTypeDef er;
+        uint32_t err;
+
+        if (!erase_ok)
+        {
+            return;
+        }
+        er.TypeErase = FLASH_TYPEERASE_PAGES;
+        er.Banks = FLASH_BANK_1;
+        er.PageAddress = EV_BASE + (uint32_t)g_erase_page * PDM_STORE_PAGE_SIZE;
+        er.NbPages = 1;
+
+        HAL_FLASH_Unlock();
+        (void)HAL_FLASHEx_Erase(&er, &err);
+        HAL_FLASH_Lock();
+
+        g_erase_page = -1;
+        count_back();                   /* 最旧的一页没有了 */
+        advance_next();
+        return;                         /* 本次已占用较长时间 */
+    }
+    if (g_q_n == 0)
+    {
+        return;
+    }
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    queue_get(0, &rec);
+    __set_PRIMASK(primask);
+
+    /* CRC 在最后一个半字，最后写入 */
+    dst = (uint32_t)slot_rec(g_next);
+    HAL_FLASH_Unlock();
+    for (uint8_t i = 0; i < EV_HALFWORDS; i++)
+    {
+        if (HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD, dst + 2u * i, src[i]) != HAL_OK)
+        {
+            failed = 1;
+            break;
+        }
+    }
+    HAL_FLASH_Lock();
+
+    if (!failed && memcmp(slot_rec(g_next), &rec, sizeof(rec)) == 0)
+    {
+        g_fl_slot = g_next;
+        g_fl_seq = rec.seq;
+        if (g_fl_n < EV_SLOTS)
+        {
+            g_fl_n++;
+        }
+        primask = __get_PRIMASK();
+        __disable_irq();
+        g_q_n--;
+        __set_PRIMASK(primask);
+    }
+    else
+    {
+        /* 编程失败（槽不干净）：放弃这个槽，同一条下次换到下一个槽重写；
+         * 中间隔了一个坏槽，更早的记录不再按序号连续，不再读出 */
+        g_fl_n = 0;
+    }
+    g_next = (uint16_t)((g_next + 1u) % EV_SLOTS);
+    advance_next();
+}
+
+/* --- 按序号取一条：待写队列中的，或 flash 中按槽号直接找到的 --- */
+static uint8_t find_seq(uint32_t seq, pdm_event_t *out)
+{
+    const pdm_event_t *r;
+    uint32_t d;
+
+    if (seq == 0)
+    {
+        return 1;
+    }
+    if ((int32_t)(seq - g_fl_seq) > 0)
+    {
+        uint32_t primask = __get_PRIMASK();
+        uint32_t i = seq - g_fl_seq - 1u;
+        uint8_t res = 1;
+
+        __disable_irq();
+        if (i < g_q_n)
+        {
+            queue_get((uint8_t)i, out);
+            res = 0;
+        }
+        __set_PRIMASK(primask);
+        return res;
+    }
+    d = g_fl_seq - seq;
+    if (d >= g_fl_n)
+    {
+        return 1;
+    }
+    r = slot_rec(slot_back(g_fl_slot, d));
+    if (r->seq != seq || r->crc != pdm_calc_crc16((const uint8_t *)r, EV_CRC_LEN))
+    {
+        return 1;
+    }
+    *out = *r;
+    return 0;
+}
+
+uint16_t PDM_Evlog_Count(void)
+{
+    return (uint16_t)(g_fl_n + g_q_n);
+}
+
+uint8_t PDM_Evlog_Get(uint16_t k, pdm_event_t *out)
+{
+    return find_seq(g_fl_seq + g_q_n - k, out);
+}
+
+uint32_t PDM_Evlog_Latch(uint16_t n)
+{
+    uint32_t primask = __get_PRIMASK();
+    uint16_t count;
+
+    __disable_irq();
+    g_lat_seq = g_fl_seq + g_q_n;
+    count = (uint16_t)(g_fl_n + g_q_n);
+    __set_PRIMASK(primask);
+
+    g_lat_n = (n != 0 && n < count) ? n : count;
+    g_lat_k = -1;
+    return (uint32_t)g_lat_n * PDM_EVLOG_REC_SIZE;
+}
+
+uint8_t PDM_Evlog_Read(uint32_t off, uint8_t *buf, uint8_t n)
+{
+    while (n > 0)
+    {
+        uint32_t k = off / PDM_EVLOG_REC_SIZE;
+        uint32_t o = off % PDM_EVLOG_REC_SIZE;
+        uint8_t m = (uint8_t)((PDM_EVLOG_REC_SIZE - o < n) ? PDM_EVLOG_REC_SIZE - o : n);
+
+        if (k >= g_lat_n)
+        {
+            return 1;
+        }
+        if ((int32_t)k != g_lat_k)
+        {
+            if (find_seq(g_lat_seq - k, &g_lat_rec) != 0)
+            {
+                return 1;               /* 下载期间这一页被擦除 */
+            }
+            g_lat_k = (int32_t)k;
+        }
+        memcpy(buf, (const uint8_t *)&g_lat_rec + o, m);
+        buf += m;
+        off += m;
+        n = (uint8_t)(n - m);
+    }
+    return 0;
+}
+
+static const char *type_name(uint8_t type)
+{
+    static const char *const names[] = { "?", "boot", "trip", "alert", "offline", "online", "busoff" };
+
+    return (type < sizeof(names) / sizeof(names[0])) ? names[type] : "?";
+}
+
+void PDM_Evlog_Print(uint16_t n)
+{
+    uint16_t count = PDM_Evlog_Count();
+    pdm_event_t e;
+
+    PDM_Log_Printf("events %u (flash %u, pending %u), dropped %lu%s\r\n", count, g_fl_n, g_q_n,
+                   (unsigned long)g_dropped, g_ok ? "" : ", flash area not usable");
+    for (uint16_t k = 0; k < n && k < count; k++)
+    {
+        if (PDM_Evlog_Get(k, &e) != 0)
+        {
+            continue;
+        }
+        if (e.ch == PDM_EV_NO_CH)
+        {
+            PDM_Log_Printf("#%lu %lu ms %s arg %u value %u\r\n", (unsigned long)e.seq, (unsigned long)e.tick_ms,
+                           type_name(e.type), e.arg, e.value);
+        }
+        else
+        {
+            PDM_Log_Printf("#%lu %lu ms %s ch%u arg %u value %u\r\n", (unsigned long)e.seq,
+                           (unsigned long)e.tick_ms, type_name(e.type), e.ch, e.arg, e.value);
+        }
+    }
+}
+
+#endif /* PDM_CFG_EVLOG */
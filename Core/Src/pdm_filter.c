@@ -0,0 +1,116 @@
+#include "pdm_filter.h"
+
+#if PDM_CFG_FILTER
+
+#include "pdm_ramfunc.h"
+#include "stm32f1xx_hal.h"
+
+#define FRAC_BITS       15      /* 状态的小数位：65535 << 15 仍在 int32 范围内 */
+#define QTY             3       /* 电流、总线电压、功率 */
+
+typedef struct {
+    int32_t x1;                 /* 前两次输入，中值用 */
+    int32_t x2;
+    int32_t y;                  /* 输出，FRAC_BITS 位小数 */
+} filt_t;
+
+typedef struct {
+    uint16_t alpha;
+    uint8_t median;
+    uint8_t n;                  /* 已有的输入个数，到 2 为止 */
+    filt_t q[QTY];
+} ch_filter_t;
+
+static ch_filter_t g_filter[PDM_CFG_CHANNELS];
+
+static int32_t med3(int32_t a, int32_t b, int32_t c)
+{
+    if (a > b)
+    {
+        int32_t t = a;
+
+        a = b;
+        b = t;
+    }
+    /* a <= b */
+    if (c <= a) return a;
+    if (c >= b) return b;
+    return c;
+}
+
+static PDM_RAMFUNC int32_t step(const ch_filter_t *c, filt_t *f, int32_t x)
+{
+    int32_t m = x;
+
+    if (c->median && c->n >= 2)
+    {
+        m = med3(x, f->x1, f->x2);
+    }
+    f->x2 = f->x1;
+    f->x1 = x;
+
+    if (c->n == 0)
+    {
+        f->y = m * (1 << FRAC_BITS);
+    }
+    else
+    {
+        int64_t d = (int64_t)m * (1 << FRAC_BITS) - f->y;
+
+        f->y += (int32_t)((d * c->alpha) >> 15);
+    }
+    return (f->y + (1 << (FRAC_BITS - 1))) >> FRAC_BITS;
+}
+
+void PDM_Filter_Init(uint8_t ch)
+{
+    (void)PDM_Filter_Set(ch, PDM_CFG_FILTER_ALPHA, PDM_CFG_FILTER_MEDIAN);
+}
+
+void PDM_Filter_Reset(uint8_t ch)
+{
+    g_filter[ch].n = 0;
+}
+
+uint8_t PDM_Filter_Set(uint8_t ch, uint16_t alpha_q15, uint8_t median)
+{
+    ch_filter_t *c;
+    uint32_t primask;
+
+    if (ch >= PDM_CFG_CHANNELS || alpha_q15 == 0 || alpha_q15 > PDM_FILTER_ALPHA_ONE)
+    {
+        return 1;
+    }
+    c = &g_filter[ch];
+    /* 采样时钟模式下 PDM_Filter_Apply() 在中断中运行 */
+    primask = __get_PRIMASK();
+    __disable_irq();
+    c->alpha = alpha_q15;
+    c->median = (uint8_t)(median != 0);
+    c->n = 0;
+    __set_PRIMASK(primask);
+    return 0;
+}
+
+void PDM_Filter_Get(uint8_t ch, uint16_t *alpha_q15, uint8_t *median)
+{
+    *alpha_q15 = g_filter[ch].alpha;
+    *median = g_filter[ch].median;
+}
+
+PDM_RAMFUNC void PDM_Filter_Apply(uint8_t ch, const ina226_regs_t *in, ina226_regs_t *out)
+{
+    ch_filter_t *c = &g_filter[ch];
+
+    out->mask = in->mask;
+    out->shunt = in->shunt;
+    out->current = (int16_t)step(c, &c->q[0], in->current);
+    out->bus = (uint16_t)step(c, &c->q[1], in->bus);
+    out->power = (uint16_t)step(c, &c->q[2], in->power);
+    if (c->n < 2)
+    {
+        c->n++;
+    }
+}
+
+#endif /* PDM_CFG_FILTER */
@@ -0,0 +1,144 @@
+#include "pdm_hist.h"
+
+#if PDM_CFG_HIST
+
+#include "stm32f1xx_hal.h"
+#include <string.h>
+
+#define FLOOR_BITS      8       /* 档 1 的下限 2^8 */
+#define HDR_FIXED       4u
+#define HDR_SIZE        (HDR_FIXED + 4u * PDM_CFG_CHANNELS)
+#define DL_SIZE         (HDR_SIZE + 4u * PDM_CFG_CHANNELS * PDM_HIST_BINS)
+
+_Static_assert(PDM_HIST_BINS == 2 * (15 - FLOOR_BITS) + 2, "bins must cover 2^FLOOR_BITS .. 2^15");
+
+static uint32_t g_hist[PDM_CFG_CHANNELS][PDM_HIST_BINS];
+static uint32_t g_lsb[PDM_CFG_CHANNELS];
+static uint32_t g_latched[PDM_CFG_CHANNELS][PDM_HIST_BINS];  /* 下载用 */
+
+static uint8_t bin_of(int16_t raw)
+{
+    uint32_t m = (raw < 0) ? (uint32_t)(-(int32_t)raw) : (uint32_t)raw;
+    uint32_t msb;
+
+    if (m >= 0x7FFFu)
+    {
+        return PDM_HIST_BINS - 1;
+    }
+    if (m < (1u << FLOOR_BITS))
+    {
+        return 0;
+    }
+    /* 最高位决定倍频程，次高位决定前后半档 */
+    msb = 31u - __CLZ(m);
+    return (uint8_t)(1u + 2u * (msb - FLOOR_BITS) + ((m >> (msb - 1u)) & 1u));
+}
+
+void PDM_Hist_Init(const uint32_t *current_ua_per_lsb)
+{
+    memcpy(g_lsb, current_ua_per_lsb, sizeof(g_lsb));
+}
+
+void PDM_Hist_Add(uint8_t ch, int16_t current_raw)
+{
+    uint32_t *c = &g_hist[ch][bin_of(current_raw)];
+
+    if (*c != UINT32_MAX)
+    {
+        (*c)++;
+    }
+}
+
+void PDM_Hist_Reset(uint8_t mask)
+{
+    for (uint8_t i = 0; i < PDM_CFG_CHANNELS; i++)
+    {
+        if (mask & (1u << i))
+        {
+            memset(g_hist[i], 0, sizeof(g_hist[i]));
+        }
+    }
+}
+
+void PDM_Hist_Get(uint8_t ch, uint32_t *bins)
+{
+    /* 逐个 32 位复制，每个计数都是完整的 */
+    for (uint8_t b = 0; b < PDM_HIST_BINS; b++)
+    {
+        bins[b] = g_hist[ch][b];
+    }
+}
+
+void PDM_Hist_Restore(uint8_t ch, const uint32_t *bins)
+{
+    memcpy(g_hist[ch], bins, sizeof(g_hist[ch]));
+}
+
+uint16_t PDM_Hist_EdgeRaw(uint8_t bin)
+{
+    if (bin == 0)
+    {
+        return 0;
+    }
+    if (bin >= PDM_HIST_BINS - 1)
+    {
+        return 0x7FFF;
+    }
+    /* 档 1: 2 << 7 = 256，档 2: 3 << 7 = 384，档 3: 2 << 8 = 512 ... */
+    return (uint16_t)((2u + ((bin - 1u) & 1u)) << (FLOOR_BITS - 1u + (bin - 1u) / 2u));
+}
+
+uint32_t PDM_Hist_Latch(void)
+{
+    memcpy(g_latched, g_hist, sizeof(g_latched));
+    return DL_SIZE;
+}
+
+static void put_be32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+/* --- 生成下载内容的第 idx 个 32 位字 --- */
+static void word_at(uint32_t idx, uint8_t *w)
+{
+    if (idx == 0)
+    {
+        w[0] = PDM_CFG_CHANNELS;
+        w[1] = PDM_HIST_BINS;
+        w[2] = 0;
+        w[3] = 0;
+    }
+    else if (idx <= PDM_CFG_CHANNELS)
+    {
+        put_be32(w, g_lsb[idx - 1u]);
+    }
+    else
+    {
+        idx -= 1u + PDM_CFG_CHANNELS;
+        put_be32(w, g_latched[idx / PDM_HIST_BINS][idx % PDM_HIST_BINS]);
+    }
+}
+
+uint8_t PDM_Hist_Read(uint32_t off, uint8_t *buf, uint8_t n)
+{
+    uint8_t w[4];
+
+    if (off > DL_SIZE || n > DL_SIZE - off)
+    {
+        return 1;
+    }
+    while (n > 0)
+    {
+        word_at(off / 4u, w);
+        *buf++ = w[off % 4u];
+        off++;
+        n--;
+    }
+    return 0;
+}
+
+#endif /* PDM_CFG_HIST */
@@ -0,0 +1,72 @@
+#include "pdm_irq.h"
+#include "pdm_prof.h"
+#include "stm32f1xx_hal.h"
+
+#if PDM_CFG_PROFILE
+#include "pdm_log.h"
+#endif
+
+static const struct {
+    IRQn_Type irq;
+    uint8_t prio;
+} g_irq_plan[] = {
+    { EXTI1_IRQn,           PDM_IRQ_PRIO_FAULT },
+    { EXTI3_IRQn,           PDM_IRQ_PRIO_FAULT },
+    { PVD_IRQn,             PDM_IRQ_PRIO_FAULT },
+    { TIM3_IRQn,            PDM_IRQ_PRIO_SAMPLE },
+    { I2C1_EV_IRQn,         PDM_IRQ_PRIO_I2C },
+    { I2C1_ER_IRQn,         PDM_IRQ_PRIO_I2C },
+#if PDM_CFG_I2C2
+    { I2C2_EV_IRQn,         PDM_IRQ_PRIO_I2C },
+    { I2C2_ER_IRQn,         PDM_IRQ_PRIO_I2C },
+#endif
+    { USB_HP_CAN1_TX_IRQn,  PDM_IRQ_PRIO_CAN },
+    { USB_LP_CAN1_RX0_IRQn, PDM_IRQ_PRIO_CAN },
+#if PDM_CFG_CANH
+    { CAN1_SCE_IRQn,        PDM_IRQ_PRIO_CAN },
+#endif
+    { DMA1_Channel4_IRQn,   PDM_IRQ_PRIO_UART },
+    { DMA1_Channel5_IRQn,   PDM_IRQ_PRIO_UART },
+    { USART1_IRQn,          PDM_IRQ_PRIO_UART },
+};
+
+void PDM_Irq_Init(void)
+{
+    HAL_NVIC_SetPriorityGrouping(NVIC_PRIORITYGROUP_4);
+    for (uint8_t i = 0; i < sizeof(g_irq_plan) / sizeof(g_irq_plan[0]); i++)
+    {
+        HAL_NVIC_SetPriority(g_irq_plan[i].irq, g_irq_plan[i].prio, 0);
+    }
+}
+
+#if PDM_CFG_PROFILE
+/* 按优先级从高到低 */
+static const struct {
+    const char *name;
+    pdm_prof_id_t prof;
+} g_levels[] = {
+    { "fault",  PDM_PROF_IRQ_FAULT },
+    { "sample", PDM_PROF_IRQ_SAMPLE },
+    { "i2c",    PDM_PROF_IRQ_I2C },
+    { "can",    PDM_PROF_IRQ_CAN },
+    { "uart",   PDM_PROF_IRQ_UART },
+};
+
+void PDM_Irq_Dump(void)
+{
+    uint32_t mhz = SystemCoreClock / 1000000u;
+    uint32_t higher = 0;            /* 更高级中断的最长执行时间之和 */
+
+    PDM_Log_Printf("IRQ level count max_us latency_us\r\n");
+    for (uint8_t i = 0; i < sizeof(g_levels) / sizeof(g_levels[0]); i++)
+    {
+        const pdm_prof_stat_t *p = PDM_Prof_Get(g_levels[i].prof);
+
+        /* 测量值包含被更高级打断的时间，估算偏大 */
+        PDM_Log_Printf("IRQ %u %s %lu %lu %lu\r\n", (unsigned)i, g_levels[i].name,
+                       (unsigned long)p->count, (unsigned long)(p->max / mhz),
+                       (unsigned long)((higher + p->max) / mhz));
+        higher += p->max;
+    }
+}
+#endif
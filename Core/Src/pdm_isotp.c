@@ -0,0 +1,366 @@
+#include "pdm_isotp.h"
+
+#if PDM_CFG_ISOTP
+
+#include "pdm_blackbox.h"
+#include "pdm_can.h"
+#include "pdm_capture.h"
+#include "pdm_evlog.h"
+#include "pdm_hist.h"
+#include "pdm_prof.h"
+#include "pdm_sched.h"
+#include "pdm_store.h"
+#include "pdm_trend.h"
+#include "stm32f1xx_hal.h"
+#include <string.h>
+
+/* STM32F103C8: 64 KB flash, 20 KB SRAM */
+#define TP_FLASH_END        (FLASH_BASE + 0x10000u)
+#define TP_SRAM_END         (SRAM_BASE + 0x5000u)
+
+#define TP_PAD              0xCCu
+#define TP_FC_TIMEOUT_MS    1000u       /* N_Bs */
+#define TP_HDR_MAX          2u
+
+/* 协议控制信息（PCI）类型，data[0] 高 4 位 */
+#define PCI_SF              0x0u
+#define PCI_FF              0x1u
+#define PCI_CF              0x2u
+#define PCI_FC              0x3u
+
+#define FC_CTS              0x0u
+#define FC_WAIT             0x1u
+#define FC_OVFLW            0x2u
+
+/* 请求码和否定响应原因 */
+#define REQ_DOWNLOAD        0x01
+#define REQ_READ_MEM        0x02
+#define RSP_POSITIVE        0x40
+#define RSP_NEGATIVE        0x7F
+#define NRC_NOT_SUPPORTED   0x11
+#define NRC_LENGTH          0x13
+#define NRC_CONDITIONS      0x22
+#define NRC_RANGE           0x31
+
+#define SRC_CAPTURE         0
+#define SRC_STORE           1
+#define SRC_PROF            2
+#define SRC_BLACKBOX        3
+#define SRC_HIST            4
+#define SRC_EVLOG           5
+#define SRC_TREND           6
+
+typedef enum {
+    TP_IDLE = 0,
+    TP_WAIT_FC,         /* 已发首帧或一个块，等待流控帧 */
+    TP_SEND,            /* 发送连续帧 */
+} tp_state_t;
+
+static tp_state_t g_state;
+static uint8_t g_hdr[TP_HDR_MAX];       /* 响应头（响应码、来源），在数据之前发送 */
+static uint8_t g_hdr_len;
+static const uint8_t *g_src;            /* 内存来源，g_read 为 NULL 时使用 */
+static uint8_t (*g_read)(uint32_t off, uint8_t *buf, uint8_t n);
+static uint32_t g_total;                /* 响应总长（含响应头） */
+static uint32_t g_pos;
+static uint8_t g_sn;
+static uint8_t g_bs;                    /* 流控帧给出的块大小，0 表示不分块 */
+static uint8_t g_bs_left;
+static uint32_t g_stmin_us;
+static uint32_t g_next_us;
+static uint32_t g_fc_deadline;
+
+static uint8_t addr_ok(uint32_t addr, uint32_t len)
+{
+    return (addr >= SRAM_BASE && addr <= TP_SRAM_END && len <= TP_SRAM_END - addr) ||
+           (addr >= FLASH_BASE && addr <= TP_FLASH_END && len <= TP_FLASH_END - addr);
+}
+
+static void send_frame(uint8_t *f, uint8_t len)
+{
+    memset(&f[len], TP_PAD, 8u - len);
+    (void)PDM_Can_Send(PDM_CFG_ISOTP_TX_ID, f, 8);
+}
+
+static void send_negative(uint8_t req, uint8_t nrc)
+{
+    uint8_t f[8] = { (uint8_t)(PCI_SF << 4 | 3u), RSP_NEGATIVE, req, nrc };
+
+    send_frame(f, 4);
+}
+
+/* --- 从响应 off 处取 n 字节；返回 0 成功，1 来源已失效 --- */
+static uint8_t fetch(uint32_t off, uint8_t *buf, uint8_t n)
+{
+    while (n > 0 && off < g_hdr_len)
+    {
+        *buf++ = g_hdr[off++];
+        n--;
+    }
+    if (n == 0)
+    {
+        return 0;
+    }
+    off -= g_hdr_len;
+    if (g_read != NULL)
+    {
+        return g_read(off, buf, n);
+    }
+    memcpy(buf, g_src + off, n);
+    return 0;
+}
+
+static uint32_t stmin_us(uint8_t v)
+{
+    if (v <= 0x7Fu)
+    {
+        return (uint32_t)v * 1000u;
+    }
+    if (v >= 0xF1u && v <= 0xF9u)
+    {
+        return (uint32_t)(v - 0xF0u) * 100u;
+    }
+    return 127000u;                     /* 保留值按最大间隔处理 */
+}
+
+/* --- 发出响应：不超过 7 字节用单帧，否则发首帧并等待流控 --- */
+static void start(uint32_t len)
+{
+    uint8_t f[8];
+    uint8_t n;
+
+    g_total = g_hdr_len + len;
+    if (g_total <= 7u)
+    {
+        f[0] = (uint8_t)(PCI_SF << 4 | g_total);
+        if (fetch(0, &f[1], (uint8_t)g_total) == 0)
+        {
+            send_frame(f, (uint8_t)(1u + g_total));
+        }
+        return;
+    }
+
+    if (g_total <= 0xFFFu)
+    {
+        f[0] = (uint8_t)(PCI_FF << 4 | (g_total >> 8));
+        f[1] = (uint8_t)(g_total & 0xFF);
+        n = 6;
+    }
+    else
+    {
+        f[0] = (uint8_t)(PCI_FF << 4);
+        f[1] = 0;
+        f[2] = (uint8_t)(g_total >> 24);
+        f[3] = (uint8_t)(g_total >> 16);
+        f[4] = (uint8_t)(g_total >> 8);
+        f[5] = (uint8_t)(g_total & 0xFF);
+        n = 2;
+    }
+    if (fetch(0, &f[8u - n], n) != 0)
+    {
+        return;
+    }
+    send_frame(f, 8);
+    g_pos = n;
+    g_sn = 1;
+    g_state = TP_WAIT_FC;
+    g_fc_deadline = HAL_GetTick() + TP_FC_TIMEOUT_MS;
+}
+
+static void handle_request(const uint8_t *req, uint8_t len)
+{
+    uint32_t size = 0;
+
+    g_read = NULL;
+    g_src = NULL;
+    g_hdr[0] = (uint8_t)(req[0] | RSP_POSITIVE);
+    g_hdr_len = 1;
+
+    switch (req[0])
+    {
+    case REQ_DOWNLOAD:
+        if (len != 2 && !(len == 3 && req[1] == SRC_EVLOG))
+        {
+            send_negative(req[0], NRC_LENGTH);
+            return;
+        }
+        g_hdr[1] = req[1];
+        g_hdr_len = 2;
+        switch (req[1])
+        {
+#if PDM_CFG_CAPTURE
+        case SRC_CAPTURE:
+            size = PDM_Capture_Size();
+            g_read = PDM_Capture_Read;
+            break;
+#endif
+        case SRC_STORE:
+            g_src = PDM_Store_Area(&size);
+            break;
+#if PDM_CFG_PROFILE
+        case SRC_PROF:
+            g_src = (const uint8_t *)PDM_Prof_Get((pdm_prof_id_t)0);
+            size = PDM_PROF_COUNT * sizeof(pdm_prof_stat_t);
+            break;
+#endif
+#if PDM_CFG_BLACKBOX
+        case SRC_BLACKBOX:
+            size = PDM_Blackbox_Size();
+            g_read = PDM_Blackbox_Read;
+            break;
+#endif
+#if PDM_CFG_HIST
+        case SRC_HIST:
+            size = PDM_Hist_Latch();
+            g_read = PDM_Hist_Read;
+            break;
+#endif
+#if PDM_CFG_EVLOG
+        case SRC_EVLOG:
+            size = PDM_Evlog_Latch((len == 3) ? req[2] : 0u);
+            g_read = PDM_Evlog_Read;
+            break;
+#endif
+#if PDM_CFG_TREND
+        case SRC_TREND:
+            size = PDM_Trend_Latch();
+            g_read = PDM_Trend_Read;
+            break;
+#endif
+        default:
+            send_negative(req[0], NRC_RANGE);
+            return;
+        }
+        if (size == 0)
+        {
+            send_negative(req[0], NRC_CONDITIONS);
+            return;
+        }
+        break;
+
+    case REQ_READ_MEM:
+    {
+        uint32_t addr;
+
+        if (len != 7)
+        {
+            send_negative(req[0], NRC_LENGTH);
+            return;
+        }
+        addr = (uint32_t)req[1] << 24 | (uint32_t)req[2] << 16 | (uint32_t)req[3] << 8 | req[4];
+        size = (uint32_t)req[5] << 8 | req[6];
+        if (size == 0 || !addr_ok(addr, size))
+        {
+            send_negative(req[0], NRC_RANGE);
+            return;
+        }
+        g_src = (const uint8_t *)addr;
+        break;
+    }
+
+    default:
+        send_negative(req[0], NRC_NOT_SUPPORTED);
+        return;
+    }
+
+    start(size);
+}
+
+void PDM_Isotp_Rx(const uint8_t *d, uint8_t dlc)
+{
+    uint8_t pci;
+
+    if (dlc == 0)
+    {
+        return;
+    }
+    pci = (uint8_t)(d[0] >> 4);
+
+    if (pci == PCI_FC)
+    {
+        if (g_state != TP_WAIT_FC || dlc < 3)
+        {
+            return;
+        }
+        switch (d[0] & 0x0Fu)
+        {
+        case FC_CTS:
+            g_bs = d[1];
+            g_bs_left = d[1];
+            g_stmin_us = stmin_us(d[2]);
+            g_next_us = PDM_Sched_NowUs();
+            g_state = TP_SEND;
+            break;
+        case FC_WAIT:
+            g_fc_deadline = HAL_GetTick() + TP_FC_TIMEOUT_MS;
+            break;
+        default:
+            g_state = TP_IDLE;          /* 溢出或无效，放弃 */
+            break;
+        }
+        return;
+    }
+
+    /* 只接受单帧请求，传输进行中不处理新请求 */
+    if (pci == PCI_SF && g_state == TP_IDLE)
+    {
+        uint8_t len = (uint8_t)(d[0] & 0x0Fu);
+
+        if (len >= 1u && len <= 7u && len < dlc)
+        {
+            handle_request(&d[1], len);
+        }
+    }
+}
+
+void PDM_Isotp_Run(void)
+{
+    uint8_t f[8];
+
+    if (g_state == TP_WAIT_FC)
+    {
+        if ((int32_t)(HAL_GetTick() - g_fc_deadline) >= 0)
+        {
+            g_state = TP_IDLE;
+        }
+        return;
+    }
+
+    while (g_state == TP_SEND && PDM_Can_TxQueueLen() < PDM_ISOTP_TXQ_LIMIT)
+    {
+        uint32_t now = PDM_Sched_NowUs();
+        uint8_t n = (g_total - g_pos > 7u) ? 7u : (uint8_t)(g_total - g_pos);
+
+        if (g_stmin_us != 0 && (int32_t)(now - g_next_us) < 0)
+        {
+            return;
+        }
+        f[0] = (uint8_t)(PCI_CF << 4 | g_sn);
+        if (fetch(g_pos, &f[1], n) != 0)
+        {
+            g_state = TP_IDLE;          /* 来源已失效（采集重新武装），上位机按 N_Cr 超时处理 */
+            return;
+        }
+        send_frame(f, (uint8_t)(1u + n));
+        g_pos += n;
+        g_sn = (uint8_t)((g_sn + 1u) & 0x0Fu);
+        g_next_us = now + g_stmin_us;
+
+        if (g_pos >= g_total)
+        {
+            g_state = TP_IDLE;
+        }
+        else if (g_bs != 0 && --g_bs_left == 0)
+        {
+            g_state = TP_WAIT_FC;
+            g_fc_deadline = HAL_GetTick() + TP_FC_TIMEOUT_MS;
+        }
+    }
+}
+
+uint8_t PDM_Isotp_Busy(void)
+{
+    return (uint8_t)(g_state != TP_IDLE);
+}
+
+#endif /* PDM_CFG_ISOTP */
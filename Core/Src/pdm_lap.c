@@ -0,0 +1,150 @@
+#include "pdm_lap.h"
+
+#if PDM_CFG_LAP
+
+#include "pdm_can.h"
+#include "pdm_signals.h"
+
+typedef struct {
+    uint64_t start;             /* 段开始时的能量累计器 */
+    uint64_t carry;             /* 段内能量清零前已累计的部分 */
+} seg_acc_t;
+
+typedef struct {
+    seg_acc_t acc[PDM_CFG_CHANNELS];
+    uint32_t start_ms;
+    uint16_t seq;
+} seg_state_t;
+
+static const pdm_scale_t *g_scale[PDM_CFG_CHANNELS];
+static seg_state_t g_lap;
+static seg_state_t g_stint;
+static int32_t g_stint_peak[PDM_CFG_CHANNELS];
+static uint8_t g_started;       /* 1: 已经结束过一圈（PDM_Lap_Due 用） */
+
+static pdm_lap_seg_t g_ring[PDM_CFG_LAP_RING];
+static uint8_t g_ring_head;     /* 下一个写入位置 */
+static uint8_t g_ring_count;
+
+static uint64_t seg_delta(const seg_acc_t *s, uint64_t acc, const pdm_scale_t *sc)
+{
+    /* 段内累计器最多回绕一次（655.36 Wh） */
+    return s->carry + ((acc >= s->start) ? acc - s->start : acc + sc->energy_acc_wrap - s->start);
+}
+
+static int32_t peak_of(int32_t a, int32_t b)
+{
+    uint32_t ma = (a < 0) ? (uint32_t)-(int64_t)a : (uint32_t)a;
+    uint32_t mb = (b < 0) ? (uint32_t)-(int64_t)b : (uint32_t)b;
+
+    return (mb > ma) ? b : a;
+}
+
+void PDM_Lap_Init(uint8_t ch, const pdm_scale_t *scale, uint64_t acc, uint32_t now)
+{
+    g_scale[ch] = scale;
+    g_lap.acc[ch].start = acc;
+    g_lap.acc[ch].carry = 0;
+    g_stint.acc[ch] = g_lap.acc[ch];
+    g_stint_peak[ch] = 0;
+    g_lap.start_ms = now;
+    g_stint.start_ms = now;
+}
+
+void PDM_Lap_Rebase(uint8_t ch, uint64_t old_acc)
+{
+    const pdm_scale_t *sc = g_scale[ch];
+
+    g_lap.acc[ch].carry = seg_delta(&g_lap.acc[ch], old_acc, sc);
+    g_lap.acc[ch].start = 0;
+    g_stint.acc[ch].carry = seg_delta(&g_stint.acc[ch], old_acc, sc);
+    g_stint.acc[ch].start = 0;
+}
+
+uint8_t PDM_Lap_Due(uint32_t now)
+{
+    return (uint8_t)(!g_started || now - g_lap.start_ms >= PDM_CFG_LAP_MIN_MS);
+}
+
+static void put_be32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+static void send_seg(const pdm_lap_seg_t *seg)
+{
+    uint8_t data[8] = { (uint8_t)(seg->kind << 4 | 0x0Fu), (uint8_t)seg->seq };
+
+    put_be32(&data[2], seg->duration_ms);
+    (void)PDM_Can_Send(PDM_LAP_CAN_ID, data, 8);
+    for (uint8_t i = 0; i < PDM_CFG_CHANNELS; i++)
+    {
+        int16_t pk = pdm_calc_sat_i16(seg->peak_uA[i] / PDM_CAN_CURRENT_UA_PER_LSB);
+
+        data[0] = (uint8_t)(seg->kind << 4 | i);
+        put_be32(&data[2], seg->energy_uWh[i]);
+        data[6] = (uint8_t)((uint16_t)pk >> 8);
+        data[7] = (uint8_t)((uint16_t)pk & 0xFF);
+        (void)PDM_Can_Send(PDM_LAP_CAN_ID, data, 8);
+    }
+}
+
+/* --- 结束一段：写入环形记录，新段从 now 开始 --- */
+static void close_seg(seg_state_t *s, uint8_t kind, uint32_t now, const uint64_t *acc, const int32_t *peak_uA)
+{
+    pdm_lap_seg_t *seg = &g_ring[g_ring_head];
+
+    seg->kind = kind;
+    seg->seq = ++s->seq;
+    seg->duration_ms = now - s->start_ms;
+    for (uint8_t i = 0; i < PDM_CFG_CHANNELS; i++)
+    {
+        seg->energy_uWh[i] = pdm_calc_energy_uWh(seg_delta(&s->acc[i], acc[i], g_scale[i]), g_scale[i]);
+        seg->peak_uA[i] = peak_uA[i];
+        s->acc[i].start = acc[i];
+        s->acc[i].carry = 0;
+    }
+    s->start_ms = now;
+
+    g_ring_head = (uint8_t)((g_ring_head + 1u) % PDM_CFG_LAP_RING);
+    if (g_ring_count < PDM_CFG_LAP_RING)
+    {
+        g_ring_count++;
+    }
+    send_seg(seg);
+}
+
+uint8_t PDM_Lap_End(uint8_t kind, uint32_t now, const uint64_t *acc, const int32_t *peak_uA)
+{
+    for (uint8_t i = 0; i < PDM_CFG_CHANNELS; i++)
+    {
+        g_stint_peak[i] = peak_of(g_stint_peak[i], peak_uA[i]);
+    }
+    g_started = 1;
+    close_seg(&g_lap, PDM_LAP_LAP, now, acc, peak_uA);
+    if (kind != PDM_LAP_STINT)
+    {
+        return 1;
+    }
+    close_seg(&g_stint, PDM_LAP_STINT, now, acc, g_stint_peak);
+    for (uint8_t i = 0; i < PDM_CFG_CHANNELS; i++)
+    {
+        g_stint_peak[i] = 0;
+    }
+    return 2;
+}
+
+uint8_t PDM_Lap_Get(uint8_t back, pdm_lap_seg_t *out)
+{
+    if (back >= g_ring_count)
+    {
+        return 1;
+    }
+    *out = g_ring[(g_ring_head + PDM_CFG_LAP_RING - 1u - back) % PDM_CFG_LAP_RING];
+    return 0;
+}
+
+#endif /* PDM_CFG_LAP */
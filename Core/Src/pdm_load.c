@@ -0,0 +1,139 @@
+#include "pdm_load.h"
+
+#if PDM_CFG_LOAD
+
+#include "pdm_log.h"
+#include "pdm_sched.h"
+#include "stm32f1xx_hal.h"
+
+#if !PDM_CFG_IDLE_SLEEP
+#error "PDM_CFG_LOAD needs PDM_CFG_IDLE_SLEEP"
+#endif
+
+uint32_t g_pdm_load_busy;
+uint32_t g_pdm_load_wake;
+uint32_t g_pdm_load_loops;
+
+static uint32_t g_win_ms;               /* 当前窗口开始的 tick */
+static uint32_t g_win_busy;
+static uint32_t g_win_loops;
+static uint32_t g_task_us[PDM_SCHED_MAX_TASKS];
+static uint16_t g_task_pm[PDM_SCHED_MAX_TASKS];
+static pdm_load_t g_res;
+
+static void window_start(uint32_t now)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    g_win_busy = g_pdm_load_busy + (DWT->CYCCNT - g_pdm_load_wake);
+    g_win_loops = g_pdm_load_loops;
+    __set_PRIMASK(primask);
+    g_win_ms = now;
+    for (uint8_t i = 0; i < PDM_Sched_TaskCount(); i++)
+    {
+        g_task_us[i] = PDM_Sched_GetStats(i)->sum_run_us;
+    }
+}
+
+void PDM_Load_Init(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    g_pdm_load_wake = DWT->CYCCNT;
+    window_start(HAL_GetTick());
+}
+
+void PDM_Load_Poll(uint32_t now)
+{
+    uint32_t ms = now - g_win_ms;
+    uint32_t busy, loops, cycles, pm;
+    uint32_t primask;
+
+    if (ms < PDM_CFG_LOAD_WINDOW_MS)
+    {
+        return;
+    }
+
+    /* 本次醒着的区间还没有计入，加上到现在为止的部分 */
+    primask = __get_PRIMASK();
+    __disable_irq();
+    busy = g_pdm_load_busy + (DWT->CYCCNT - g_pdm_load_wake) - g_win_busy;
+    loops = g_pdm_load_loops - g_win_loops;
+    __set_PRIMASK(primask);
+
+    cycles = ms * (SystemCoreClock / 1000u);
+    pm = (uint32_t)((uint64_t)busy * 1000u / cycles);
+    if (pm > 1000u)
+    {
+        pm = 1000u;
+    }
+    g_res.load_pm = (uint16_t)pm;
+    if (pm > g_res.peak_pm)
+    {
+        g_res.peak_pm = (uint16_t)pm;
+    }
+    g_res.loops_per_s = (uint32_t)((uint64_t)loops * 1000u / ms);
+    g_res.window_ms = ms;
+
+    for (uint8_t i = 0; i < PDM_Sched_TaskCount(); i++)
+    {
+        uint32_t us = PDM_Sched_GetStats(i)->sum_run_us - g_task_us[i];
+
+        /* 超过窗口时间说明期间统计被清零，这个窗口不算 */
+        g_task_pm[i] = (uint16_t)((us <= ms * 1000u) ? us / ms : 0u);
+    }
+
+    window_start(now);
+}
+
+void PDM_Load_Get(pdm_load_t *out)
+{
+    *out = g_res;
+}
+
+uint16_t PDM_Load_TaskPm(uint8_t index)
+{
+    return (index < PDM_SCHED_MAX_TASKS) ? g_task_pm[index] : 0u;
+}
+
+void PDM_Load_Encode(uint8_t *data, const void *arg)
+{
+    static uint8_t task;
+    uint32_t loops = (g_res.loops_per_s > 0xFFFFu) ? 0xFFFFu : g_res.loops_per_s;
+    uint16_t share;
+
+    (void)arg;
+    if (task >= PDM_Sched_TaskCount())
+    {
+        task = 0;
+    }
+    share = g_task_pm[task];
+    data[0] = (uint8_t)(g_res.load_pm >> 8);
+    data[1] = (uint8_t)(g_res.load_pm & 0xFF);
+    data[2] = (uint8_t)(loops >> 8);
+    data[3] = (uint8_t)(loops & 0xFF);
+    data[4] = task;
+    data[5] = (uint8_t)(share >> 8);
+    data[6] = (uint8_t)(share & 0xFF);
+    data[7] = (uint8_t)(g_res.peak_pm / 10u);
+    task++;
+}
+
+void PDM_Load_Print(void)
+{
+    if (g_res.window_ms == 0)
+    {
+        PDM_Log_Printf("cpu: first window not finished\r\n");
+        return;
+    }
+    PDM_Log_Printf("cpu %u.%u%% (peak %u.%u%%), %lu loops/s, window %lu ms\r\n",
+                   g_res.load_pm / 10u, g_res.load_pm % 10u, g_res.peak_pm / 10u, g_res.peak_pm % 10u,
+                   (unsigned long)g_res.loops_per_s, (unsigned long)g_res.window_ms);
+    for (uint8_t i = 0; i < PDM_Sched_TaskCount(); i++)
+    {
+        PDM_Log_Printf("  %-8s %u.%u%%\r\n", PDM_Sched_GetTask(i)->name, g_task_pm[i] / 10u, g_task_pm[i] % 10u);
+    }
+}
+
+#endif /* PDM_CFG_LOAD */
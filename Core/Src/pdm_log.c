@@ -0,0 +1,337 @@
+#include "pdm_log.h"
+#include "pdm_config.h"
+#include "pdm_pool.h"
+#include "pdm_prof.h"
+#include "pdm_rtos.h"
+#include "usart.h"
+#include <stdio.h>
+
+/* 日志块：从共享内存池分配，按写入顺序串成链表，DMA 逐块发送，发完的块归还 */
+#define LOG_BLK_DATA    (PDM_POOL_BLOCK_SIZE - sizeof(void *) - 4u)     /* Cortex-M3 上为 32 */
+
+typedef struct log_blk {
+    struct log_blk *next;
+    volatile uint8_t len;       /* 已提交的字节数（主循环关中断修改） */
+    volatile uint8_t sent;      /* 已发送的字节数（只由 DMA 相关代码修改） */
+    char data[LOG_BLK_DATA];
+} log_blk_t;
+
+_Static_assert(sizeof(log_blk_t) <= PDM_POOL_BLOCK_SIZE, "log block larger than pool block");
+
+static log_blk_t *volatile g_log_head;      /* 最早的块，由 DMA 完成中断推进 */
+static log_blk_t *volatile g_log_wr;        /* 最后一个已提交的块，之后的文字接着写在这里 */
+static volatile uint8_t g_log_dma_len;      /* 正在发送的字节数，0 表示 DMA 空闲 */
+static uint32_t g_log_committed;            /* 提交和发送的总字节数，相等时全部发完 */
+static volatile uint32_t g_log_sent;
+static uint32_t g_log_drops;
+
+/* 逐段写入的状态，PDM_Log_End() 时才提交：新分配的块先串在 g_line_first 上，提交时接到链表末尾 */
+static log_blk_t *g_line_blk;               /* 正在写的块 */
+static uint8_t g_line_pos;
+static log_blk_t *g_line_first;
+static uint16_t g_line_n;                   /* 本条的字节数 */
+static uint8_t g_line_over;                 /* 逐段写入时空间不足 */
+
+/* --- 从 head 开始发送下一段已提交的数据，发完的块归还（调用时关中断或在完成中断中） --- */
+static void log_start_dma(void)
+{
+    log_blk_t *b = g_log_head;
+
+    while (b != NULL)
+    {
+        uint8_t n = (uint8_t)(b->len - b->sent);
+
+        if (n != 0)
+        {
+            g_log_dma_len = n;
+            if (HAL_UART_Transmit_DMA(&huart1, (uint8_t *)&b->data[b->sent], n) != HAL_OK)
+            {
+                g_log_dma_len = 0;
+            }
+            return;
+        }
+        if (b == g_log_wr)
+        {
+            break;                      /* 最后一块留着继续写 */
+        }
+        g_log_head = b->next;
+        PDM_Pool_Free(PDM_POOL_LOG, b);
+        b = g_log_head;
+    }
+    g_log_dma_len = 0;
+}
+
+/* --- 一段 DMA 结束（完成或出错丢弃）：推进并发送下一段 --- */
+static void log_dma_done(void)
+{
+    g_log_head->sent = (uint8_t)(g_log_head->sent + g_log_dma_len);
+    g_log_sent += g_log_dma_len;
+    log_start_dma();
+}
+
+void PDM_Log_Init(void)
+{
+    g_log_head = NULL;
+    g_log_wr = NULL;
+    g_log_dma_len = 0;
+    g_log_committed = 0;
+    g_log_sent = 0;
+    g_log_drops = 0;
+}
+
+void PDM_Log_Begin(void)
+{
+#if PDM_CFG_RTOS
+    PDM_Rtos_LogLock();                 /* 到 PDM_Log_End() 为止，其他任务的行不会插进来 */
+#endif
+    g_line_blk = g_log_wr;
+    g_line_pos = (g_log_wr != NULL) ? g_log_wr->len : LOG_BLK_DATA;
+    g_line_first = NULL;
+    g_line_n = 0;
+    g_line_over = 0;
+}
+
+void PDM_Log_Char(char c)
+{
+    if (g_line_over)
+    {
+        return;
+    }
+    if (g_line_pos == LOG_BLK_DATA)
+    {
+        log_blk_t *b = (log_blk_t *)PDM_Pool_Alloc(PDM_POOL_LOG);
+
+        if (b == NULL)
+        {
+            g_line_over = 1;
+            return;
+        }
+        b->next = NULL;
+        b->len = 0;
+        b->sent = 0;
+        if (g_line_first == NULL)
+        {
+            g_line_first = b;           /* 已提交的块在提交时才连上 */
+        }
+        else
+        {
+            g_line_blk->next = b;
+        }
+        g_line_blk = b;
+        g_line_pos = 0;
+    }
+    g_line_blk->data[g_line_pos++] = c;
+    g_line_n++;
+}
+
+/* --- 归还本条新分配的块；写在已提交块剩余空间中的文字不计入长度，不用处理 --- */
+static void line_free(void)
+{
+    while (g_line_first != NULL)
+    {
+        log_blk_t *b = g_line_first;
+
+        g_line_first = b->next;
+        PDM_Pool_Free(PDM_POOL_LOG, b);
+    }
+}
+
+uint8_t PDM_Log_End(void)
+{
+    uint32_t primask;
+
+    if (g_line_over)
+    {
+        line_free();
+        g_log_drops++;
+#if PDM_CFG_RTOS
+        PDM_Rtos_LogUnlock();
+#endif
+        return 1;
+    }
+    if (g_line_n == 0)
+    {
+#if PDM_CFG_RTOS
+        PDM_Rtos_LogUnlock();
+#endif
+        return 0;
+    }
+
+    /* 和完成中断同时判断会错过启动，这里短暂关中断 */
+    primask = __get_PRIMASK();
+    __disable_irq();
+    if (g_line_first != NULL)
+    {
+        for (log_blk_t *b = g_line_first; b != g_line_blk; b = b->next)
+        {
+            b->len = LOG_BLK_DATA;
+        }
+        if (g_log_wr != NULL)
+        {
+            g_log_wr->len = LOG_BLK_DATA;
+            g_log_wr->next = g_line_first;
+        }
+        else
+        {
+            g_log_head = g_line_first;
+        }
+        g_log_wr = g_line_blk;
+    }
+    g_log_wr->len = g_line_pos;
+    g_log_committed += g_line_n;
+    if (g_log_dma_len == 0)
+    {
+        log_start_dma();
+    }
+    __set_PRIMASK(primask);
+#if PDM_CFG_RTOS
+    PDM_Rtos_LogUnlock();
+#endif
+    return 0;
+}
+
+void PDM_Log_Cancel(void)
+{
+    line_free();
+#if PDM_CFG_RTOS
+    PDM_Rtos_LogUnlock();
+#endif
+}
+
+uint8_t PDM_Log_Write(const char *buf, uint16_t len)
+{
+    PDM_Log_Begin();
+    for (uint16_t i = 0; i < len; i++)
+    {
+        PDM_Log_Char(buf[i]);
+    }
+    return PDM_Log_End();
+}
+
+void PDM_Log_Str(const char *s)
+{
+    while (*s != '\0')
+    {
+        PDM_Log_Char(*s++);
+    }
+}
+
+/* --- 无符号十进制，最多 10 位，位数不足 min_digits 时前面补 0 --- */
+static void log_digits(uint32_t v, uint8_t min_digits)
+{
+    char d[10];
+    uint8_t n = 0;
+
+    do
+    {
+        d[n++] = (char)('0' + v % 10u);
+        v /= 10u;
+    } while (v != 0 && n < sizeof(d));
+    while (n < min_digits && n < sizeof(d))
+    {
+        d[n++] = '0';
+    }
+    while (n > 0)
+    {
+        PDM_Log_Char(d[--n]);
+    }
+}
+
+void PDM_Log_Int(int32_t v)
+{
+    if (v < 0)
+    {
+        PDM_Log_Char('-');
+        log_digits(0u - (uint32_t)v, 1);
+    }
+    else
+    {
+        log_digits((uint32_t)v, 1);
+    }
+}
+
+void PDM_Log_Uint(uint32_t v)
+{
+    log_digits(v, 1);
+}
+
+void PDM_Log_Fixed(int32_t v, uint32_t div, uint8_t decimals)
+{
+    uint32_t mag = (v < 0) ? 0u - (uint32_t)v : (uint32_t)v;
+    uint32_t pow10 = 1;
+    uint32_t q;
+
+    for (uint8_t i = 0; i < decimals; i++)
+    {
+        pow10 *= 10u;
+    }
+    /* 先换算到最后一位小数再四舍五入，div 是 pow10 的整数倍 */
+    div /= pow10;
+    q = (uint32_t)(((uint64_t)mag + div / 2u) / div);
+
+    if (v < 0)
+    {
+        PDM_Log_Char('-');              /* 与 printf 相同，舍入为 0 的负数显示 -0.0 */
+    }
+    log_digits(q / pow10, 1);
+    if (decimals > 0)
+    {
+        PDM_Log_Char('.');
+        log_digits(q % pow10, decimals);
+    }
+}
+
+void PDM_Log_VPrintf(const char *fmt, va_list args)
+{
+    char buf[128];
+    PDM_PROF_BEGIN(PDM_PROF_PRINT);
+    int len = vsnprintf(buf, sizeof(buf), fmt, args);
+    PDM_PROF_END(PDM_PROF_PRINT);
+
+    if (len > 0)
+    {
+        uint16_t send_len = (len < (int)sizeof(buf)) ? (uint16_t)len : (uint16_t)(sizeof(buf) - 1);
+        (void)PDM_Log_Write(buf, send_len);
+    }
+}
+
+void PDM_Log_Printf(const char *fmt, ...)
+{
+    va_list args;
+
+    va_start(args, fmt);
+    PDM_Log_VPrintf(fmt, args);
+    va_end(args);
+}
+
+uint32_t PDM_Log_GetDropCount(void)
+{
+    return g_log_drops;
+}
+
+void PDM_Log_Flush(uint32_t timeout_ms)
+{
+    uint32_t start = HAL_GetTick();
+
+    while (g_log_sent != g_log_committed && HAL_GetTick() - start < timeout_ms)
+    {
+    }
+}
+
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+    if (huart == &huart1)
+    {
+        log_dma_done();
+    }
+}
+
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+    /* 接收错误（溢出、噪声）时发送 DMA 仍在进行，只在发送确实停止后处理 */
+    if (huart == &huart1 && g_log_dma_len != 0 && huart->gState == HAL_UART_STATE_READY)
+    {
+        /* 发送出错时丢掉这一段，继续发后面的 */
+        log_dma_done();
+    }
+}
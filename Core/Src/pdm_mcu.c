@@ -0,0 +1,172 @@
+#include "pdm_mcu.h"
+
+#if PDM_CFG_MCU
+
+#include "pdm_log.h"
+#include "stm32f1xx_hal.h"
+
+#if PDM_CFG_MCU_EXT > 2
+#error "PDM_CFG_MCU_EXT: only PB0 and PB1 are free analog inputs"
+#endif
+
+#define N_CH                (2 + PDM_CFG_MCU_EXT)
+#define ADC_CH_TEMP         16
+#define ADC_CH_VREF         17
+#define ADC_SMP_239         7u          /* 239.5 周期 */
+#define ADC_FULL            4095u
+#define VREFINT_MV          1200u
+#define SLOPE_UV_PER_C      4300
+#define WAIT_MS             2
+
+/* 扫描顺序：温度、VREFINT、IN8、IN9 */
+static const uint8_t g_seq[4] = { ADC_CH_TEMP, ADC_CH_VREF, 8, 9 };
+
+static volatile uint16_t g_buf[PDM_MCU_SCANS][N_CH];
+static uint8_t g_running;
+
+/* --- 等待 CR2 中的位被硬件清除 --- */
+static uint8_t wait_clear(uint32_t bit)
+{
+    uint32_t t0 = HAL_GetTick();
+
+    while (ADC1->CR2 & bit)
+    {
+        if (HAL_GetTick() - t0 > WAIT_MS)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+uint8_t PDM_Mcu_Init(void)
+{
+    uint32_t sqr3 = 0;
+
+#if PDM_CFG_MCU_EXT > 0
+    {
+        GPIO_InitTypeDef gpio = {0};
+
+        __HAL_RCC_GPIOB_CLK_ENABLE();
+        gpio.Pin = (PDM_CFG_MCU_EXT > 1) ? (GPIO_PIN_0 | GPIO_PIN_1) : GPIO_PIN_0;
+        gpio.Mode = GPIO_MODE_ANALOG;
+        HAL_GPIO_Init(GPIOB, &gpio);
+    }
+#endif
+
+    MODIFY_REG(RCC->CFGR, RCC_CFGR_ADCPRE, RCC_CFGR_ADCPRE_DIV6);   /* ADC 时钟不超过 14 MHz */
+    __HAL_RCC_ADC1_CLK_ENABLE();
+    __HAL_RCC_DMA1_CLK_ENABLE();
+
+    /* DMA：外设 DR 半字 -> 缓冲区，循环，不开中断 */
+    DMA1_Channel1->CCR = 0;
+    DMA1_Channel1->CPAR = (uint32_t)&ADC1->DR;
+    DMA1_Channel1->CMAR = (uint32_t)g_buf;
+    DMA1_Channel1->CNDTR = PDM_MCU_SCANS * N_CH;
+    DMA1_Channel1->CCR = DMA_CCR_MINC | DMA_CCR_CIRC | DMA_CCR_PSIZE_0 | DMA_CCR_MSIZE_0 | DMA_CCR_EN;
+
+    for (uint8_t i = 0; i < N_CH; i++)
+    {
+        sqr3 |= (uint32_t)g_seq[i] << (5u * i);
+    }
+    ADC1->CR1 = ADC_CR1_SCAN;
+    ADC1->SMPR1 = ADC_SMP_239 << ADC_SMPR1_SMP16_Pos | ADC_SMP_239 << ADC_SMPR1_SMP17_Pos;
+    ADC1->SMPR2 = ADC_SMP_239 << ADC_SMPR2_SMP8_Pos | ADC_SMP_239 << ADC_SMPR2_SMP9_Pos;
+    ADC1->SQR1 = (uint32_t)(N_CH - 1) << ADC_SQR1_L_Pos;
+    ADC1->SQR3 = sqr3;
+
+    /* 上电，等待稳定（tSTAB 1 us）后自校准 */
+    ADC1->CR2 = ADC_CR2_ADON | ADC_CR2_TSVREFE;
+    HAL_Delay(1);
+    ADC1->CR2 |= ADC_CR2_RSTCAL;
+    if (wait_clear(ADC_CR2_RSTCAL) != 0)
+    {
+        return 1;
+    }
+    ADC1->CR2 |= ADC_CR2_CAL;
+    if (wait_clear(ADC_CR2_CAL) != 0)
+    {
+        return 1;
+    }
+
+    /* 连续扫描，软件触发一次后一直运行；ADON 以外的位和 ADON 同时写不会启动转换 */
+    ADC1->CR2 |= ADC_CR2_CONT | ADC_CR2_DMA | ADC_CR2_EXTSEL | ADC_CR2_EXTTRIG;
+    ADC1->CR2 |= ADC_CR2_SWSTART;
+    g_running = 1;
+    return 0;
+}
+
+void PDM_Mcu_Get(pdm_mcu_t *out)
+{
+    uint32_t sum[N_CH] = {0};
+    uint32_t vdda;
+    int32_t vs_uV;
+
+    out->ok = 0;
+    out->temp_dC = 0;
+    out->vdda_mV = 0;
+    out->ext_mV[0] = 0;
+    out->ext_mV[1] = 0;
+    if (!g_running)
+    {
+        return;
+    }
+    for (uint8_t s = 0; s < PDM_MCU_SCANS; s++)
+    {
+        for (uint8_t i = 0; i < N_CH; i++)
+        {
+            sum[i] += g_buf[s][i];
+        }
+    }
+    if (sum[1] == 0)
+    {
+        return;                         /* 第一轮扫描还没写完 */
+    }
+
+    /* 各和为 PDM_MCU_SCANS 次之和，在比值中约掉 */
+    vdda = (VREFINT_MV * ADC_FULL * PDM_MCU_SCANS + sum[1] / 2) / sum[1];
+    vs_uV = (int32_t)((uint64_t)sum[0] * vdda * 1000u / (ADC_FULL * PDM_MCU_SCANS));
+    out->temp_dC = (int16_t)(((int32_t)PDM_CFG_MCU_V25_MV * 1000 - vs_uV) * 10 / SLOPE_UV_PER_C + 250);
+    out->vdda_mV = (uint16_t)vdda;
+    for (uint8_t i = 2; i < N_CH; i++)
+    {
+        out->ext_mV[i - 2] = (uint16_t)((uint64_t)sum[i] * vdda / (ADC_FULL * PDM_MCU_SCANS));
+    }
+    out->ok = 1;
+}
+
+static void put_be16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)(v >> 8);
+    p[1] = (uint8_t)v;
+}
+
+void PDM_Mcu_Encode(uint8_t *data, const void *arg)
+{
+    pdm_mcu_t m;
+
+    (void)arg;
+    PDM_Mcu_Get(&m);
+    put_be16(&data[0], (uint16_t)m.temp_dC);
+    put_be16(&data[2], m.vdda_mV);
+    put_be16(&data[4], m.ext_mV[0]);
+    put_be16(&data[6], m.ext_mV[1]);
+}
+
+void PDM_Mcu_Print(void)
+{
+    pdm_mcu_t m;
+    int32_t t;
+
+    PDM_Mcu_Get(&m);
+    if (!m.ok)
+    {
+        PDM_Log_Printf("mcu adc %s\r\n", g_running ? "no result yet" : "not running");
+        return;
+    }
+    t = (m.temp_dC < 0) ? -m.temp_dC : m.temp_dC;
+    PDM_Log_Printf("mcu temp %s%ld.%ld C vdda %u mV in8 %u mV in9 %u mV\r\n", (m.temp_dC < 0) ? "-" : "",
+                   (long)(t / 10), (long)(t % 10), m.vdda_mV, m.ext_mV[0], m.ext_mV[1]);
+}
+
+#endif /* PDM_CFG_MCU */
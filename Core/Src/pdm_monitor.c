@@ -1,37 +1,163 @@
 #include "pdm_monitor.h"
+#include "pdm_config.h"
+#include "pdm_calc.h"
+#include "pdm_adapt.h"
+#include "pdm_alert.h"
+#include "pdm_apply.h"
+#include "pdm_blackbox.h"
+#include "pdm_boot.h"
+#include "pdm_bus.h"
+#include "pdm_sched.h"
+#include "pdm_sensor.h"
+#include "pdm_shell.h"
+#include "pdm_prof.h"
+#include "pdm_can.h"
+#include "pdm_filter.h"
+#include "pdm_hist.h"
+#include "pdm_cmd.h"
+#include "pdm_cal.h"
+#include "pdm_capture.h"
+#include "pdm_decim.h"
+#include "pdm_diag.h"
+#include "pdm_isotp.h"
+#include "pdm_canhealth.h"
+#include "pdm_crash.h"
+#include "pdm_e2e.h"
+#include "pdm_evlog.h"
+#include "pdm_trend.h"
+#include "pdm_lap.h"
+#include "pdm_load.h"
+#include "pdm_mcu.h"
+#include "pdm_node.h"
+#include "pdm_pair.h"
+#include "pdm_param.h"
+#include "pdm_persist.h"
+#include "pdm_plaus.h"
+#include "pdm_protect.h"
+#include "pdm_ramfunc.h"
+#include "pdm_replay.h"
+#include "pdm_report.h"
+#include "pdm_rint.h"
+#include "pdm_soc.h"
+#include "pdm_stack.h"
+#include "pdm_startup.h"
+#include "pdm_step.h"
+#include "pdm_stats.h"
+#include "pdm_store.h"
+#include "pdm_stream.h"
+#include "pdm_telem.h"
+#include "pdm_timer.h"
+#include "pdm_timesync.h"
+#include "pdm_trip.h"
+#include "pdm_wdg.h"
+#include "pdm_xcp.h"
 #include "driver_ina226.h"
-#include "driver_ina226_interface.h"
+#include "ina226_async.h"
 #include "stm32f1xx_hal.h"
-#include "can.h"
 #include "main.h"
-#include <stdio.h>
 #include <string.h>
 
-/* CAN IDs */
-#define CAN_ID_BUS    0x300
-#define CAN_ID_BAT    0x301
-
 /* Timing intervals (ms) */
-#define INTERVAL_READ   50
-#define INTERVAL_CAN    500
+#define INTERVAL_READ   PDM_CFG_SAMPLE_PERIOD_MS
+#define INTERVAL_CAN    5           /* 检查报文是否到期 */
+#define INTERVAL_LED    500
+#define INTERVAL_PROTECT 100
+#define INTERVAL_STORE  10
+#define INTERVAL_WDG    100
 #define INTERVAL_UART   1000
+#define INTERVAL_SHELL  20
+
+/* PDM_CFG_RTOS 时的任务分组 */
+#define GRP_ACQ         PDM_SCHED_GROUP_ACQ
+#define GRP_COMMS       PDM_SCHED_GROUP_COMMS
+#define GRP_LOG         PDM_SCHED_GROUP_LOG
+
+/* 连续失败 OFFLINE_AFTER 次后判为离线，按指数退避探测（器件状态见 pdm_monitor.h） */
+#define OFFLINE_AFTER   3
+#define BACKOFF_MIN_MS  100
+#define BACKOFF_MAX_MS  5000
+
+/* INA226 寄存器位 */
+#define CONF_RESET      0x8000u     /* CONF bit15: 软件复位，完成后自动清零 */
+#define MASK_CNVR       0x0400u     /* MASK bit10: 转换完成时拉低 ALERT */
+#define MASK_CVRF       0x0008u     /* MASK bit3: 转换完成标志，读 MASK 后清除 */
+#define INIT_RESET_MS   10          /* 启动时等待软件复位完成的最长时间 */
+
+/* 转换时间来自运行参数，默认为 PDM_CFG_INA226_BUS_CT / PDM_CFG_INA226_SHUNT_CT */
+#define BUS_CT          ((ina226_conversion_time_t)PDM_Param_Get()->bus_ct)
+#define SHUNT_CT        ((ina226_conversion_time_t)PDM_Param_Get()->shunt_ct)
+
+/* Phase offsets (ms)，错开各任务，避免在同一个 tick 上同时运行 */
+#define PHASE_READ      0
+#define PHASE_CAN       10
+#define PHASE_LED       15
+#define PHASE_PROTECT   20
+#define PHASE_STORE     5
+#define PHASE_WDG       30
+#define PHASE_UART      25
+#define PHASE_SHELL     8
+
+/* --- 通道表：每片传感器一项，初始化、读取、CAN 和 UART 都按这张表循环。
+ * X(名称, 器件, I2C 总线, I2C 地址, 采样电阻 uOhm, 电流 LSB uA, CAN ID, 平均次数)
+ * 器件为 PDM_SENSOR_INA226 或 PDM_SENSOR_INA228（见 pdm_sensor.h），INA228 的地址引脚编码与 INA226 相同。
+ * 总线 0 为 I2C1，1 为 I2C2（需要 PDM_CFG_I2C2），两条总线上可以使用相同的地址。
+ * 电流 LSB 决定量程和分辨率：电流寄存器满量程 32767 x LSB，同时受分流电压 81.92 mV 限制。
+ * 换算常量和校准寄存器值在编译期算出 --- */
+#define CHANNEL_TABLE(X) \
+    X("BUS", PDM_SENSOR_INA226, 0, INA226_ADDRESS_0, PDM_SHUNT_UOHM, PDM_CURRENT_UA_PER_LSB, 0x300, PDM_CFG_INA226_AVG) /* ALERT1 */ \
+    X("BAT", PDM_SENSOR_INA226, 0, INA226_ADDRESS_1, PDM_SHUNT_UOHM, PDM_CURRENT_UA_PER_LSB, 0x301, PDM_CFG_INA226_AVG) /* ALERT2 */
+
+#define CH_CFG_ENTRY(name, type, bus, addr, shunt, lsb, id, avg) { name, type, bus, addr, id, avg, PDM_CALC_SCALE(shunt, lsb) },
+#define CH_CFG_CHECK(name, type, bus, addr, shunt, lsb, id, avg) \
+    _Static_assert(PDM_CALC_SCALE_OK(shunt, lsb), "channel " name ": calibration out of range or inexact energy unit"); \
+    _Static_assert((bus) == 0 || ((bus) == 1 && PDM_CFG_I2C2), "channel " name ": bus 1 needs PDM_CFG_I2C2"); \
+    _Static_assert((type) == PDM_SENSOR_INA226 || !PDM_CFG_SYNC_TRIGGER, "channel " name ": PDM_CFG_SYNC_TRIGGER needs INA226");
 
-/* Two INA226 handles */
-static ina226_handle_t g_ina226_bus;
-static ina226_handle_t g_ina226_bat;
+/* 表中的采样电阻、平均次数和 CAN ID 为默认值，启动时和参数修改后按运行参数（pdm_param.h）改写 */
+static pdm_channel_cfg_t g_ch_cfg[] = { CHANNEL_TABLE(CH_CFG_ENTRY) };
+CHANNEL_TABLE(CH_CFG_CHECK)
 
-/* Channel data */
-static pdm_channel_t g_ch_bus;
-static pdm_channel_t g_ch_bat;
+#define CH_COUNT    PDM_CFG_CHANNELS
+#define CH_BUS      0           /* 总线侧：功率保护 */
+#define CH_BAT      1           /* 电池侧：欠压保护 */
 
-/* Timing */
-static uint32_t g_last_read_tick;
-static uint32_t g_last_can_tick;
-static uint32_t g_last_uart_tick;
+/* 保护通道的硬件过流响应时间取决于平均窗口，不使用平稳档 */
+#define ADAPT_MAX_LEVEL(i)  ((PDM_CFG_PROTECT && (i) == CH_BUS) ? PDM_ADAPT_NORMAL : PDM_ADAPT_STEADY)
 
-/* Alert flags (set in EXTI callback) */
-volatile uint8_t g_alert1_flag = 0;
-volatile uint8_t g_alert2_flag = 0;
+_Static_assert(sizeof(g_ch_cfg) / sizeof(g_ch_cfg[0]) == CH_COUNT, "PDM_CFG_CHANNELS must match CHANNEL_TABLE");
+
+#if (PDM_CFG_PROTECT || PDM_CFG_SOC || PDM_CFG_DERIVED || PDM_CFG_PLAUS) && CH_COUNT < 2
+#error "PDM_CFG_PROTECT, PDM_CFG_SOC, PDM_CFG_DERIVED and PDM_CFG_PLAUS need channel 0 (bus) and channel 1 (battery)"
+#endif
+#if PDM_CFG_CAPTURE && PDM_CFG_CAPTURE_CH > 1
+#error "PDM_CFG_CAPTURE_CH must be 0 or 1 (channels with an ALERT pin)"
+#endif
+#if PDM_CFG_INA228_ACC_EVERY < 1 || PDM_CFG_INA228_ACC_EVERY > 255
+#error "PDM_CFG_INA228_ACC_EVERY must be 1..255"
+#endif
+#if PDM_CFG_SYNC_TRIGGER && PDM_CFG_SAMPLE_ON_ALERT
+#error "PDM_CFG_SYNC_TRIGGER works with timed sampling only"
+#endif
+#if PDM_CFG_SAMPLE_TIMER && (PDM_CFG_SAMPLE_ON_ALERT || PDM_CFG_SYNC_TRIGGER)
+#error "PDM_CFG_SAMPLE_TIMER replaces the main loop read task, it cannot be combined with ALERT or triggered sampling"
+#endif
+#if PDM_CFG_REPLAY && PDM_CFG_SAMPLE_ON_ALERT
+#error "PDM_CFG_REPLAY has no ALERT pin, use timed sampling"
+#endif
+
+static ina226_handle_t g_ina226[CH_COUNT];
+static pdm_channel_t g_ch[CH_COUNT];
+
+/* 对外发布的通道数据：每通道两份，轮流写入，写完一份再增加序号。
+ * g_ch 只由主循环修改；读者（CAN/UART 编码、PVD 中断里的断电保存）
+ * 通过 PDM_Monitor_GetChannel() 取已写完的一份，不需要关中断 */
+static pdm_channel_t g_ch_pub[CH_COUNT][2];
+static volatile uint32_t g_ch_seq[CH_COUNT];
+
+/* 看门狗报到槽 */
+static uint8_t g_wdg_sample;
+static uint8_t g_wdg_can;
+static uint8_t g_wdg_uart;
 
 /* --- Helper: link interface functions to a handle --- */
 static void link_handle(ina226_handle_t *h)
@@ -42,213 +168,1779 @@ static void link_handle(ina226_handle_t *h)
     DRIVER_INA226_LINK_IIC_READ(h, ina226_interface_iic_read);
     DRIVER_INA226_LINK_IIC_WRITE(h, ina226_interface_iic_write);
     DRIVER_INA226_LINK_DELAY_MS(h, ina226_interface_delay_ms);
-    DRIVER_INA226_LINK_DEBUG_PRINT(h, ina226_interface_debug_print);
+    DRIVER_INA226_LINK_DEBUG_PRINT(h, ina226_interface_driver_print);
     DRIVER_INA226_LINK_RECEIVE_CALLBACK(h, ina226_interface_receive_callback);
 }
 
-/* --- Init one INA226 --- */
-static uint8_t init_one(ina226_handle_t *h, ina226_address_t addr)
+/* --- 器件地址：I2C2 上的器件在地址 bit0 做标记，接口层据此选择总线 --- */
+static void set_addr(ina226_handle_t *h, const pdm_channel_cfg_t *cfg)
 {
-    uint8_t res;
-    uint16_t cal;
+    ina226_set_addr_pin(h, cfg->addr);
+    if (cfg->bus != 0)
+    {
+        h->iic_addr |= INA226_IIC_BUS_BIT;
+    }
+#if PDM_CFG_REPLAY
+    PDM_Replay_Bind((uint8_t)(h - g_ina226), h->iic_addr);
+#endif
+}
+
+/* --- INA228：不经过 LibDriver 驱动，handle 只用于保存地址，inited 保持 0，
+ * 使用驱动的模块（保护门限、高速采集、平均档位调整）对该通道不起作用 --- */
+static uint8_t init_228(const ina226_handle_t *h, const pdm_channel_cfg_t *cfg)
+{
+    return PDM_Sensor_Ina228Init(h->iic_addr, &cfg->scale, cfg->avg, BUS_CT, SHUNT_CT, PDM_CFG_SAMPLE_ON_ALERT);
+}
 
-    ina226_set_addr_pin(h, addr);
-    ina226_set_resistance(h, 0.004);
+/* --- 平均次数、转换时间和校准值（INA226），测量模式不变 --- */
+static uint8_t config_one(ina226_handle_t *h, const pdm_channel_cfg_t *cfg)
+{
+    uint8_t res;
 
-    res = ina226_init(h);
+    res = ina226_set_average_mode(h, cfg->avg);
     if (res != 0) return res;
 
-    res = ina226_set_average_mode(h, INA226_AVG_16);
+    res = ina226_set_bus_voltage_conversion_time(h, BUS_CT);
     if (res != 0) return res;
 
-    res = ina226_set_bus_voltage_conversion_time(h, INA226_CONVERSION_TIME_1P1_MS);
+    res = ina226_set_shunt_voltage_conversion_time(h, SHUNT_CT);
     if (res != 0) return res;
 
-    res = ina226_set_shunt_voltage_conversion_time(h, INA226_CONVERSION_TIME_1P1_MS);
+    /* 校准值已按采样电阻算好，不调用 ina226_calculate_calibration()（双精度浮点）。
+     * 换算全部在 pdm_calc.h 中完成，驱动的浮点换算函数不使用 */
+    return ina226_set_calibration(h, cfg->scale.cal);
+}
+
+/* --- Init one INA226 --- */
+static uint8_t init_one(ina226_handle_t *h, const pdm_channel_cfg_t *cfg)
+{
+    uint8_t res;
+
+    set_addr(h, cfg);
+    if (cfg->type == PDM_SENSOR_INA228)
+    {
+        return init_228(h, cfg);
+    }
+
+    res = ina226_init(h);
     if (res != 0) return res;
 
-    res = ina226_calculate_calibration(h, &cal);
+    res = config_one(h, cfg);
     if (res != 0) return res;
 
-    res = ina226_set_calibration(h, cal);
+#if PDM_CFG_SAMPLE_ON_ALERT
+    /* 每次平均结果更新后拉低 ALERT，读 MASK 寄存器时清除 */
+    res = ina226_set_conversion_ready_alert_pin(h, INA226_BOOL_TRUE);
     if (res != 0) return res;
+#endif
 
     res = ina226_set_mode(h, INA226_MODE_SHUNT_BUS_VOLTAGE_CONTINUOUS);
     return res;
 }
 
-/* --- Read one channel --- */
-static void read_channel(ina226_handle_t *h, pdm_channel_t *ch, float dt_h)
+/* --- Async read context of one channel --- */
+typedef struct {
+    ina226_read_job_t job;      /* 一次读取 5 个寄存器 (mask/shunt/bus/current/power) */
+    volatile uint8_t active;    /* 1: 读取已发出，等待结果（采样时钟中断中也会置位） */
+    uint32_t last_us;           /* 上一次发起读取的时间戳 */
+    uint32_t dt_us;             /* 本次读取对应的积分时间 */
+    uint32_t lost_us;           /* 之前读取失败的时间，并入下一次成功读取的积分时间 */
+    uint32_t window_us;         /* 芯片一个平均结果覆盖的时间 */
+    uint16_t prev_power;        /* 上一次的功率寄存器值，梯形积分用 */
+    int32_t prev_power_signed;  /* 上一次的有符号功率，见 pdm_calc_power_signed() */
+
+    uint8_t index;              /* 通道表中的序号 */
+    uint8_t health;             /* PDM_DEV_ONLINE / PDM_DEV_SUSPECT / PDM_DEV_OFFLINE */
+    uint8_t fails;              /* 连续失败次数 */
+    uint16_t backoff_ms;        /* 离线时的探测间隔 */
+    uint32_t next_try;          /* 下一次探测的时间 */
+    uint8_t probing;            /* 1: 探测读取已发出 */
+    volatile uint8_t probe_pending;
+    volatile uint8_t probe_res;
+    uint8_t probe_buf[2];       /* 厂商 ID 寄存器 */
+    uint32_t errors;            /* 读取失败总次数 */
+    uint16_t reinits;           /* 恢复后重新初始化的次数 */
+    uint16_t restores;          /* 配置检查发现器件复位、按副本重新写入的次数 */
+    uint8_t first;              /* 1: 启动后还没有得到第一个转换结果 */
+    uint8_t ready;              /* 1: 器件已初始化，可以发起读取 */
+    uint8_t acc_n;              /* INA228：距下一次读累计寄存器的采样次数 */
+    uint8_t acc_valid;          /* INA228：acc_energy/acc_charge 已有基准值 */
+    uint32_t acc_dt_us;         /* INA228：上次读累计寄存器以来的时间 */
+    uint64_t acc_energy;        /* INA228：上次读到的 ENERGY */
+    int64_t acc_charge;         /* INA228：上次读到的 CHARGE */
+#if PDM_CFG_ADAPT
+    uint8_t adapt_pending;      /* 1: 需要切换平均档位 */
+#endif
+    uint8_t reconfig;           /* 1: 运行参数已修改，需要重新配置器件 */
+} read_ctx_t;
+
+static read_ctx_t g_rd[CH_COUNT];
+/* 第 i 位: 通道 i 刚得到第一个有效结果，由 CAN 任务立即发送一次通道帧 */
+static volatile uint8_t g_first_frames;
+#if PDM_CFG_PLAUS
+/* 可信度标志有变化，由 CAN 任务立即发送一次可信度帧 */
+static volatile uint8_t g_plaus_changed;
+#endif
+/* --- 离线器件探测：读厂商 ID 寄存器（I2C 中断中完成） --- */
+static void probe_done(uint8_t res, void *ctx)
 {
-    uint16_t raw_v, raw_p;
-    int16_t raw_i;
-    float v, i, p;
-    uint8_t success = 1;
+    read_ctx_t *rd = (read_ctx_t *)ctx;
+
+    rd->probe_res = res;
+    rd->probe_pending = 0;
+}
 
-    if (ina226_read_bus_voltage(h, &raw_v, &v) == 0)
-        ch->voltage_mV = v;
+static void mark_offline(read_ctx_t *rd, uint32_t now)
+{
+    rd->health = PDM_DEV_OFFLINE;
+    rd->backoff_ms = BACKOFF_MIN_MS;
+    rd->next_try = now + rd->backoff_ms;
+}
+
+/* --- 读取失败：连续失败达到次数后判为离线 --- */
+static void read_failed(read_ctx_t *rd)
+{
+    rd->errors++;
+    if (rd->health == PDM_DEV_OFFLINE)
+    {
+        return;
+    }
+    if (++rd->fails >= OFFLINE_AFTER)
+    {
+        mark_offline(rd, HAL_GetTick());
+        ina226_interface_debug_print("INA226 %s offline\r\n", g_ch_cfg[rd->index].name);
+#if PDM_CFG_EVLOG
+        PDM_Evlog_Add(PDM_EV_OFFLINE, rd->index, 0, (uint16_t)rd->errors);
+#endif
+    }
     else
-        success = 0;
+    {
+        rd->health = PDM_DEV_SUSPECT;
+    }
+}
+
+/* --- 探测结果：器件应答且厂商 ID 正确时重新初始化，否则加倍退避 --- */
+static void poll_probe(read_ctx_t *rd, uint32_t now)
+{
+    if (!rd->probing || rd->probe_pending)
+    {
+        return;
+    }
+    rd->probing = 0;
+
+    if (rd->probe_res == 0 &&
+        (uint16_t)((uint16_t)rd->probe_buf[0] << 8 | rd->probe_buf[1]) == INA226_MANUFACTURER_ID &&
+        init_one(&g_ina226[rd->index], &g_ch_cfg[rd->index]) == 0)
+    {
+        rd->ready = 1;
+        rd->acc_n = 0;
+        rd->acc_valid = 0;              /* INA228 初始化清零了累计寄存器 */
+#if PDM_CFG_FILTER
+        PDM_Filter_Reset(rd->index);    /* 不和离线前的采样一起滤波 */
+#endif
+#if PDM_CFG_DECIM
+        PDM_Decim_Reset(rd->index);
+#endif
+#if PDM_CFG_STEP
+        PDM_Step_Reset(rd->index);
+#endif
+#if PDM_CFG_PLAUS
+        PDM_Plaus_Init(rd->index, g_ch_cfg[rd->index].scale.cal);
+#endif
+        rd->last_us = PDM_Sched_NowUs();    /* 离线期间不积分，先于状态更新（采样时钟中断按状态发起读取） */
+        rd->lost_us = 0;
+        __DMB();
+        rd->health = PDM_DEV_ONLINE;
+        rd->fails = 0;
+        rd->reinits++;
+#if PDM_CFG_EVLOG
+        PDM_Evlog_Add(PDM_EV_ONLINE, rd->index, 0, (uint16_t)rd->reinits);
+#endif
+#if PDM_CFG_ADAPT
+        PDM_Adapt_Reset(rd->index);     /* init_one() 写的是正常档配置 */
+        rd->adapt_pending = 0;
+        rd->window_us = PDM_Adapt_WindowUs(rd->index);
+#endif
+#if PDM_CFG_PROTECT
+        (void)PDM_Protect_Resume(rd->index);
+#endif
+        ina226_interface_debug_print("INA226 %s back online\r\n", g_ch_cfg[rd->index].name);
+        return;
+    }
+
+    rd->backoff_ms = (rd->backoff_ms >= BACKOFF_MAX_MS / 2) ? BACKOFF_MAX_MS : (uint16_t)(rd->backoff_ms * 2u);
+    rd->next_try = now + rd->backoff_ms;
+}
+
+/* --- 离线通道：不读数据，到时间后发一次探测 --- */
+static void start_probe(read_ctx_t *rd, uint32_t now)
+{
+    const ina226_handle_t *h = &g_ina226[rd->index];
+
+    if (!rd->probing && (int32_t)(now - rd->next_try) >= 0)
+    {
+        rd->probing = 1;
+        rd->probe_pending = 1;
+        if (ina226_interface_iic_read_async(h->iic_addr, PDM_Sensor_IdReg(g_ch_cfg[rd->index].type),
+                                            rd->probe_buf, 2, probe_done, rd) != 0)
+        {
+            rd->probe_res = 1;
+            rd->probe_pending = 0;
+        }
+    }
+}
+
+#if PDM_CFG_TRIP
+/* --- 读取完成（I2C 中断）：立即做切断判断，其余处理仍在主循环中 --- */
+static PDM_RAMFUNC void read_done(uint8_t res, void *ctx)
+{
+    read_ctx_t *rd = (read_ctx_t *)ctx;
+
+    if (res != 0 || rd->first)
+    {
+        return;                         /* 第一次转换前数据寄存器是复位值 */
+    }
+#if PDM_CFG_REPLAY
+    PDM_Trip_OnRead(rd->index, (pdm_sensor_type_t)g_ch_cfg[rd->index].type, &rd->job,
+                    PDM_Replay_Dt(rd->index), rd->last_us);
+#else
+    PDM_Trip_OnRead(rd->index, (pdm_sensor_type_t)g_ch_cfg[rd->index].type, &rd->job, rd->dt_us, rd->last_us);
+#endif
+}
+#define READ_DONE   read_done
+#else
+#define READ_DONE   NULL
+#endif
+
+/* --- 发起一轮读取（5 个寄存器），ts_us 为本次采样的时间戳（也可在采样时钟中断中调用） --- */
+static void read_begin(read_ctx_t *rd, uint32_t ts_us)
+{
+    const ina226_handle_t *h = &g_ina226[rd->index];
+    pdm_sensor_type_t type = (pdm_sensor_type_t)g_ch_cfg[rd->index].type;
+    uint8_t with_acc = 0;
+
+    rd->dt_us = ts_us - rd->last_us;
+    rd->last_us = ts_us;
+    rd->active = 1;
+
+    if (type == PDM_SENSOR_INA228)
+    {
+        with_acc = (uint8_t)(rd->acc_n == 0);
+        rd->acc_n = (uint8_t)((rd->acc_n + 1u) % PDM_CFG_INA228_ACC_EVERY);
+    }
+    if (!rd->ready || PDM_Sensor_ReadAsync(type, h->iic_addr, &rd->job, with_acc, READ_DONE, rd) != 0)
+    {
+        rd->job.failed = 1;
+        rd->job.pending = 0;
+    }
+}
+
+/* --- 开始读取一个通道的寄存器，ts_us 为样本的时间戳 --- */
+static void start_read_channel(read_ctx_t *rd, uint32_t now, uint32_t ts_us)
+{
+    if (rd->health == PDM_DEV_OFFLINE)
+    {
+        start_probe(rd, now);
+        return;
+    }
+    read_begin(rd, ts_us);
+}
+
+/* --- 当前平均档位，关闭自动调整时始终为正常档 --- */
+static uint8_t ch_level(uint8_t idx)
+{
+#if PDM_CFG_ADAPT
+    return PDM_Adapt_Level(idx);
+#else
+    (void)idx;
+    return PDM_ADAPT_NORMAL;
+#endif
+}
+
+/* --- 高速采集期间采集通道的配置由 pdm_capture 管理，结束时恢复为正常配置 --- */
+static uint8_t capture_owns(uint8_t idx)
+{
+#if PDM_CFG_CAPTURE
+    return (uint8_t)(idx == PDM_CFG_CAPTURE_CH && PDM_Capture_Active());
+#else
+    (void)idx;
+    return 0;
+#endif
+}
+
+#if PDM_CFG_ADAPT
+
+/* --- 一组采样完成、I2C 空闲时切换平均档位 --- */
+static void adapt_apply(void)
+{
+    for (uint8_t i = 0; i < CH_COUNT; i++)
+    {
+        read_ctx_t *rd = &g_rd[i];
+
+        if (!rd->adapt_pending || rd->health == PDM_DEV_OFFLINE || capture_owns(i))
+        {
+            continue;
+        }
+        if (PDM_Adapt_Apply(i, &g_ina226[i]) == 0)
+        {
+            rd->adapt_pending = 0;
+            rd->window_us = PDM_Adapt_WindowUs(i);
+        }
+    }
+}
+#endif
+
+/* --- 按运行参数改写通道表中的平均次数、采样电阻和校准值 --- */
+static void cfg_from_param(uint8_t i)
+{
+    const pdm_param_t *p = PDM_Param_Get();
+    pdm_channel_cfg_t *cfg = &g_ch_cfg[i];
+
+    cfg->avg = (ina226_avg_t)p->avg[i];
+    cfg->scale.shunt_uohm = p->shunt_uohm[i];
+    cfg->scale.cal = (uint16_t)PDM_CALC_CAL(p->shunt_uohm[i], cfg->scale.current_ua_per_lsb);
+}
+
+/* --- 运行参数修改后重新配置器件：一组采样完成、I2C 空闲时进行，只写受影响的通道 --- */
+static void reconfig_apply(void)
+{
+    for (uint8_t i = 0; i < CH_COUNT; i++)
+    {
+        read_ctx_t *rd = &g_rd[i];
+        pdm_channel_cfg_t *cfg = &g_ch_cfg[i];
+        uint8_t owned = capture_owns(i);
+        uint8_t res;
+
+        if (!rd->reconfig)
+        {
+            continue;
+        }
+        rd->reconfig = 0;
+        cfg_from_param(i);
+        rd->window_us = pdm_calc_window_us(cfg->avg, BUS_CT, SHUNT_CT);
+#if PDM_CFG_TRIP
+        PDM_Trip_Config(i, &cfg->scale);    /* 零点修正按新的校准值折算 */
+#endif
+#if PDM_CFG_ADAPT
+        PDM_Adapt_Init(i, cfg->avg, ADAPT_MAX_LEVEL(i));
+        rd->adapt_pending = 0;
+#endif
+#if PDM_CFG_CAPTURE
+        if (i == PDM_CFG_CAPTURE_CH)
+        {
+            PDM_Capture_SetAvg(cfg->avg);
+        }
+#endif
+        if (rd->health == PDM_DEV_OFFLINE)
+        {
+            continue;                   /* 恢复时 init_one() 按新配置初始化 */
+        }
+
+        /* 采集通道的平均次数和转换时间由 pdm_capture 管理，只改校准值 */
+        if (cfg->type == PDM_SENSOR_INA228)
+        {
+            res = init_228(&g_ina226[i], cfg);
+        }
+        else
+        {
+            res = owned ? ina226_set_calibration(&g_ina226[i], cfg->scale.cal) : config_one(&g_ina226[i], cfg);
+        }
+        if (res != 0)
+        {
+            read_failed(rd);
+            rd->reconfig = 1;           /* 下一组再试，离线后由重新初始化完成 */
+            continue;
+        }
+        rd->acc_n = 0;
+        rd->acc_valid = 0;              /* INA228 初始化清零了累计寄存器 */
+#if PDM_CFG_FILTER
+        PDM_Filter_Reset(i);            /* 不和旧配置的采样一起滤波 */
+#endif
+#if PDM_CFG_DECIM
+        PDM_Decim_Reset(i);
+#endif
+#if PDM_CFG_STEP
+        PDM_Step_Init(i, &cfg->scale);  /* 门限按新的电流 LSB 换算 */
+#endif
+#if PDM_CFG_PLAUS
+        PDM_Plaus_Init(i, cfg->scale.cal);
+#endif
+        ina226_interface_debug_print("INA226 %s reconfigured\r\n", cfg->name);
+    }
+}
 
-    if (ina226_read_current(h, &raw_i, &i) == 0)
-        ch->current_mA = i;
+#if PDM_CFG_INA226_CHECK_MS
+#if !PDM_CFG_INA226_SHADOW
+#error "PDM_CFG_INA226_CHECK_MS compares against the register shadow, enable PDM_CFG_INA226_SHADOW"
+#endif
+
+/* 后台配置检查：一次只有一个读取，各通道轮流，每个通道 CALIBRATION 和 CONF 轮流 */
+static struct {
+    uint8_t ch;
+    uint8_t conf;               /* 1: 本次读 CONF，0: CALIBRATION */
+    uint8_t active;             /* 1: 读取已发出 */
+    volatile uint8_t pending;
+    volatile uint8_t res;
+    uint8_t buf[2];
+    uint32_t next_ms;
+} g_chk;
+
+static void check_done(uint8_t res, void *ctx)
+{
+    (void)ctx;
+    g_chk.res = res;
+    g_chk.pending = 0;
+}
+
+static void check_advance(void)
+{
+    if (++g_chk.ch >= CH_COUNT)
+    {
+        g_chk.ch = 0;
+        g_chk.conf ^= 1u;
+    }
+}
+
+/* --- 读到的寄存器与副本不同：器件复位回了默认值（校准值 0，电流、功率读数为 0），按副本重新写入 --- */
+static void check_result(read_ctx_t *rd, uint8_t reg)
+{
+    const ina226_handle_t *h = &g_ina226[rd->index];
+    uint16_t v = (uint16_t)((uint16_t)g_chk.buf[0] << 8 | g_chk.buf[1]);
+
+    if (g_chk.res != 0 || rd->health == PDM_DEV_OFFLINE || capture_owns(rd->index) ||
+        !ina226_interface_shadow_differs(h->iic_addr, reg, v))
+    {
+        return;                         /* 读取失败由采样读取判断离线 */
+    }
+    rd->restores++;
+    if (ina226_interface_shadow_restore(h->iic_addr) != 0)
+    {
+        read_failed(rd);
+        return;
+    }
+#if PDM_CFG_FILTER
+    PDM_Filter_Reset(rd->index);        /* 复位后的读数不参与滤波 */
+#endif
+#if PDM_CFG_DECIM
+    PDM_Decim_Reset(rd->index);
+#endif
+#if PDM_CFG_STEP
+    PDM_Step_Reset(rd->index);
+#endif
+    ina226_interface_debug_print("INA226 %s config lost (reg 0x%02X = 0x%04X), restored\r\n",
+                                 g_ch_cfg[rd->index].name, reg, v);
+}
+
+/* --- 一组采样完成时、修改配置之前处理上一次的结果（读取之后副本没有变过） --- */
+static void config_check_poll(void)
+{
+    if (!g_chk.active || g_chk.pending)
+    {
+        return;
+    }
+    g_chk.active = 0;
+    check_result(&g_rd[g_chk.ch], g_chk.conf ? INA226_REG_CONF : INA226_REG_CALIBRATION);
+    check_advance();
+}
+
+/* --- 一组采样完成、配置修改之后到时间时发出下一次读取 --- */
+static void config_check_start(uint32_t now)
+{
+    read_ctx_t *rd = &g_rd[g_chk.ch];
+
+    if (g_chk.active || (int32_t)(now - g_chk.next_ms) < 0)
+    {
+        return;
+    }
+    g_chk.next_ms = now + PDM_CFG_INA226_CHECK_MS;
+    if (rd->health == PDM_DEV_OFFLINE || !rd->ready || rd->reconfig || capture_owns(rd->index) ||
+        g_ch_cfg[rd->index].type != PDM_SENSOR_INA226)
+    {
+        check_advance();
+        return;
+    }
+    g_chk.active = 1;
+    g_chk.pending = 1;
+    if (ina226_interface_iic_read_async(g_ina226[rd->index].iic_addr,
+                                        g_chk.conf ? INA226_REG_CONF : INA226_REG_CALIBRATION,
+                                        g_chk.buf, 2, check_done, NULL) != 0)
+    {
+        g_chk.active = 0;
+        g_chk.pending = 0;
+        check_advance();
+    }
+}
+#endif
+
+/* --- Publish g_ch[i]: write the buffer readers are not using, then bump the sequence --- */
+static PDM_RAMFUNC void publish_channel(uint8_t i)
+{
+    uint32_t next = g_ch_seq[i] + 1u;
+
+    g_ch_pub[i][next & 1u] = g_ch[i];
+    __DMB();
+    g_ch_seq[i] = next;
+}
+
+/* --- MCU 按采样间隔积分能量（INA226） --- */
+static PDM_RAMFUNC void energy_integrate(read_ctx_t *rd, pdm_channel_t *ch, const ina226_regs_t *snap,
+                                         uint32_t dt_us, const pdm_scale_t *sc)
+{
+#if PDM_CFG_ENERGY_TRAPEZOID
+    pdm_calc_energy_add_trapz(&ch->energy_acc, rd->prev_power, snap->power,
+                              dt_us, rd->window_us, sc);
+    rd->prev_power = snap->power;
+#else
+    (void)rd;
+    pdm_calc_energy_add(&ch->energy_acc, snap->power, dt_us, sc);
+#endif
+    ch->charge_acc += (int64_t)snap->current * dt_us;
+
+    /* 功率寄存器不带方向，充放电分开用电流 x 电压另算 */
+    {
+        int32_t p = pdm_calc_power_signed(snap->current, snap->bus);
+
+#if PDM_CFG_ENERGY_TRAPEZOID
+        pdm_calc_energy_add_dir(&ch->energy_dis_acc, &ch->energy_chg_acc, rd->prev_power_signed, p,
+                                dt_us, rd->window_us, sc);
+        rd->prev_power_signed = p;
+#else
+        pdm_calc_energy_add_dir(&ch->energy_dis_acc, &ch->energy_chg_acc, p, p,
+                                dt_us, UINT32_MAX, sc);
+#endif
+    }
+}
+
+/* --- INA228：用片上 ENERGY/CHARGE 与上次读数的差值更新能量，第一次读数只作基准。
+ * ENERGY 不带方向，整段差值按本次电流方向计入放电或充电（段长为 PDM_CFG_INA228_ACC_EVERY 次采样）。
+ * 有新的差值时 *soc_dt_us 为这一段的时间，*soc_uA 为由 CHARGE 差值算出的平均电流，否则两者为 0 --- */
+static PDM_RAMFUNC void energy_from_acc(read_ctx_t *rd, pdm_channel_t *ch, const pdm_sensor_sample_t *smp,
+                                        uint32_t dt_us, const pdm_scale_t *sc,
+                                        int32_t *soc_uA, uint32_t *soc_dt_us)
+{
+    rd->acc_dt_us += dt_us;
+    *soc_uA = 0;
+    *soc_dt_us = 0;
+    if (!smp->has_acc)
+    {
+        return;
+    }
+    if (rd->acc_valid && rd->acc_dt_us != 0)
+    {
+        uint64_t e = ((smp->energy - rd->acc_energy) & PDM_SENSOR_ACC_MASK) * PDM_SENSOR_ENERGY_ACC_PER_LSB;
+        int64_t dq = smp->charge - rd->acc_charge;
+
+        pdm_calc_energy_add_units(&ch->energy_acc, e, sc);
+        pdm_calc_energy_add_units((ch->current_uA >= 0) ? &ch->energy_dis_acc : &ch->energy_chg_acc, e, sc);
+        /* CHARGE LSB = 电流 LSB / 16 (C) */
+        ch->charge_acc += dq * (1000000 / 16);
+        *soc_uA = (int32_t)(dq * (int64_t)sc->current_ua_per_lsb * 1000000 / 16 / (int64_t)rd->acc_dt_us);
+        *soc_dt_us = rd->acc_dt_us;
+    }
+    rd->acc_energy = smp->energy;
+    rd->acc_charge = smp->charge;
+    rd->acc_valid = 1;
+    rd->acc_dt_us = 0;
+}
+
+#if PDM_CFG_PLAUS
+/* --- 可信度检查：snap 为 NULL 表示数学溢出 --- */
+static void plaus_note(uint8_t i, const ina226_regs_t *snap)
+{
+    uint8_t before = PDM_Plaus_Flags(i);
+
+    if (snap == NULL)
+    {
+        PDM_Plaus_Overflow(i);
+    }
     else
-        success = 0;
+    {
+        PDM_Plaus_Check(i, snap);
+    }
+    if (PDM_Plaus_Flags(i) != before)
+    {
+        g_plaus_changed = 1;
+    }
+}
+#endif
 
-    if (ina226_read_power(h, &raw_p, &p) == 0)
+/* --- 把读完的一组寄存器换算成通道数据 --- */
+static PDM_RAMFUNC void update_channel(read_ctx_t *rd)
+{
+    pdm_channel_t *ch = &g_ch[rd->index];
+    const pdm_channel_cfg_t *cfg = &g_ch_cfg[rd->index];
+    const pdm_scale_t *sc = &cfg->scale;
+    pdm_sensor_sample_t smp;
+    ina226_regs_t snap;
+    uint32_t dt_us = rd->dt_us + rd->lost_us;
+    uint32_t ts_us = rd->last_us;
+    int32_t soc_uA;
+    uint32_t soc_dt_us;
+    uint8_t res;
+
+    /* 先取出结果和积分时间再清除 active，之后采样时钟中断可以发起下一次读取 */
+    res = PDM_Sensor_Decode((pdm_sensor_type_t)cfg->type, &rd->job, &smp);
+    __DMB();
+    rd->active = 0;
+    if (res == 1)                       /* 读失败 */
+    {
+        ch->online = 0;
+        rd->lost_us = dt_us;            /* 按上次的结果补到下一次成功的读取中；判为离线时丢弃 */
+        read_failed(rd);
+        return;
+    }
+    rd->fails = 0;
+    rd->health = PDM_DEV_ONLINE;
+    if (res != 0)                       /* 数学溢出 */
+    {
+        ch->online = 0;
+        rd->lost_us = dt_us;
+#if PDM_CFG_PLAUS
+        plaus_note(rd->index, NULL);
+#endif
+        return;
+    }
+    snap = smp.reg;
+#if PDM_CFG_REPLAY
+    dt_us = PDM_Replay_Dt(rd->index);   /* 积分时间用记录中的间隔 */
+    if (dt_us == 0)
     {
-        ch->power_mW = p;
-        ch->energy_mWh += ch->power_mW * dt_h;
-        if (ch->energy_mWh >= 655360.0f) {
-            ch->energy_mWh -= 655360.0f;
+        return;                         /* 没有新记录，数据寄存器仍是上一条 */
+    }
+#endif
+    rd->lost_us = 0;
+    if (rd->first)
+    {
+        if ((snap.mask & MASK_CVRF) == 0)
+        {
+            return;                     /* 第一次转换还没完成，数据寄存器仍是复位值 */
         }
+        rd->first = 0;
+        g_first_frames |= (uint8_t)(1u << rd->index);
+#if PDM_CFG_STARTUP
+        PDM_Startup_Mark(PDM_STARTUP_SAMPLE);
+#endif
+    }
+#if PDM_CFG_CAL
+    PDM_Cal_Add(rd->index, snap.shunt);     /* 标定用修正前的分流电压 */
+#endif
+    if (PDM_Param_Get()->offset[rd->index] != 0)
+    {
+        pdm_calc_trim_offset(&snap.shunt, &snap.current, &snap.power, snap.bus,
+                             PDM_Param_Get()->offset[rd->index], sc->cal);
+    }
+
+    ch->voltage_mV = pdm_calc_bus_mV(snap.bus);
+    if (ch->voltage_mV < ch->v_min_mV) ch->v_min_mV = ch->voltage_mV;
+    if (ch->voltage_mV > ch->v_max_mV) ch->v_max_mV = ch->voltage_mV;
+    ch->current_uA = pdm_calc_current_uA(snap.current, sc);
+    ch->power_uW = pdm_calc_power_uW(snap.power, sc);
+#if PDM_CFG_FILTER
+    {
+        ina226_regs_t f;
+
+        PDM_Filter_Apply(rd->index, &snap, &f);
+        ch->voltage_f_mV = pdm_calc_bus_mV(f.bus);
+        ch->current_f_uA = pdm_calc_current_uA(f.current, sc);
+        ch->power_f_uW = pdm_calc_power_uW(f.power, sc);
+    }
+#else
+    ch->voltage_f_mV = ch->voltage_mV;
+    ch->current_f_uA = ch->current_uA;
+    ch->power_f_uW = ch->power_uW;
+#endif
+
+    if (cfg->type == PDM_SENSOR_INA228)
+    {
+        energy_from_acc(rd, ch, &smp, dt_us, sc, &soc_uA, &soc_dt_us);
     }
     else
     {
-        success = 0;
+        energy_integrate(rd, ch, &snap, dt_us, sc);
+        soc_uA = ch->current_uA;
+        soc_dt_us = dt_us;
+    }
+    {
+        uint32_t e = pdm_calc_energy_uWh(ch->energy_acc, sc);
+
+        if (e < ch->energy_uWh)
+        {
+            ch->energy_wraps++;         /* 累计器只增加，变小就是回绕了（清零时 energy_uWh 同时为 0） */
+        }
+        ch->energy_uWh = e;
     }
-    
-    ch->online = success;
+    ch->energy_dis_uWh = pdm_calc_energy_uWh(ch->energy_dis_acc, sc);
+    ch->energy_chg_uWh = pdm_calc_energy_uWh(ch->energy_chg_acc, sc);
+
+    ch->shunt_raw = snap.shunt;
+    ch->sample_us = ts_us;
+    ch->online = 1;
+#if PDM_CFG_PLAUS
+    plaus_note(rd->index, &snap);
+#endif
+    {
+        pdm_bus_event_t ev = { PDM_BUS_EV_SAMPLE, rd->index, 0, ts_us, &snap };
+
+        PDM_Bus_Publish(&ev);           /* 统计、分布、黑匣子、采样流，见 g_subs */
+    }
+
+#if PDM_CFG_ADAPT
+    if (capture_owns(rd->index) || cfg->type != PDM_SENSOR_INA226)
+    {
+        PDM_Adapt_Reset(rd->index);
+        rd->adapt_pending = 0;
+    }
+    else
+    {
+        rd->adapt_pending = PDM_Adapt_Add(rd->index, ch->current_uA, dt_us / 1000u);
+    }
+#endif
+
+#if PDM_CFG_SOC
+    if (rd->index == CH_BAT)
+    {
+        PDM_Soc_Sample(soc_uA, soc_dt_us, ch->voltage_mV);
+    }
+#endif
 }
 
-/* --- Send one CAN frame --- */
-static void send_can_frame(uint32_t id, pdm_channel_t *ch)
+static void finish_read_channel(read_ctx_t *rd)
 {
-    if (HAL_CAN_GetTxMailboxesFreeLevel(&hcan) == 0)
+    update_channel(rd);
+    publish_channel(rd->index);
+}
+
+#if PDM_CFG_SYNC_TRIGGER
+/* 同步触发：各芯片依次写成单次触发模式（每次 I2C 写约 0.1 ms），几乎同时开始转换，
+ * 等最长的一个平均窗口结束后由 task_sample 作为一组读出，不轮询转换完成位 */
+static struct {
+    uint8_t wait;               /* 1: 已触发，等待转换完成 */
+    uint8_t mask;               /* 本组要读取的通道 */
+    uint32_t start_us;
+    uint32_t wait_us;
+} g_sync;
+
+static ina226_avg_t ch_avg(uint8_t idx)
+{
+#if PDM_CFG_ADAPT
+    return PDM_Adapt_Avg(idx);
+#else
+    return g_ch_cfg[idx].avg;
+#endif
+}
+
+static void sync_trigger(void)
+{
+    uint32_t wait_us = 0;
+
+    g_sync.mask = 0;
+    g_sync.start_us = PDM_Sched_NowUs();
+    for (uint8_t i = 0; i < CH_COUNT; i++)
+    {
+        read_ctx_t *rd = &g_rd[i];
+        const ina226_handle_t *h = &g_ina226[i];
+        uint16_t conf;
+        uint8_t buf[2];
+
+        /* 离线通道照常交给 start_read_channel() 探测；采集通道连续转换，直接读 */
+        if (rd->health != PDM_DEV_OFFLINE && h->inited == 1 && !capture_owns(i))
+        {
+            conf = pdm_calc_conf(ch_avg(i), BUS_CT, SHUNT_CT, INA226_MODE_SHUNT_BUS_VOLTAGE_TRIGGERED);
+            buf[0] = (uint8_t)(conf >> 8);
+            buf[1] = (uint8_t)(conf & 0xFF);
+            if (ina226_interface_iic_write(h->iic_addr, INA226_REG_CONF, buf, 2) != 0)
+            {
+                read_failed(rd);        /* 没有启动转换，本组不读（下次积分时间相应变长） */
+                continue;
+            }
+            if (rd->window_us > wait_us)
+            {
+                wait_us = rd->window_us;
+            }
+        }
+        g_sync.mask |= (uint8_t)(1u << i);
+    }
+    /* 内部时钟有偏差，多等 1/16 窗口再加 200 us */
+    g_sync.wait_us = (wait_us != 0) ? wait_us + wait_us / 16u + 200u : 0;
+    g_sync.wait = 1;
+}
+
+/* 转换时间到后一起读出 */
+static void sync_poll(uint32_t now)
+{
+    if (!g_sync.wait || PDM_Sched_NowUs() - g_sync.start_us < g_sync.wait_us)
     {
-        ina226_interface_debug_print("CAN TX full, drop 0x%03lX\r\n", id);
         return;
     }
+    g_sync.wait = 0;
+    for (uint8_t i = 0; i < CH_COUNT; i++)
+    {
+        if (g_sync.mask & (1u << i))
+        {
+            start_read_channel(&g_rd[i], now, PDM_Sched_NowUs());
+        }
+    }
+}
+#endif
+
+#if PDM_CFG_SAMPLE_TIMER
+/* 采样时钟（TIM3 中断）：与定时读取任务相同，上一组读完后各在线通道一起发起读取，
+ * 时间戳取中断发生的时刻。离线通道的探测和读取结果仍在主循环中处理 */
+static PDM_RAMFUNC void on_sample_clock(uint32_t now_us)
+{
+    for (uint8_t i = 0; i < CH_COUNT; i++)
+    {
+        if (g_rd[i].active)
+        {
+            return;
+        }
+    }
+    for (uint8_t i = 0; i < CH_COUNT; i++)
+    {
+        read_ctx_t *rd = &g_rd[i];
+
+        if (rd->health == PDM_DEV_OFFLINE)
+        {
+            continue;
+        }
+#if PDM_CFG_ADAPT
+        if (now_us - rd->last_us < rd->window_us)
+        {
+            continue;       /* 芯片还没有新的平均结果 */
+        }
+#endif
+        read_begin(rd, now_us);
+    }
+}
+#endif
+
+/* --- Scheduled tasks --- */
 
-    CAN_TxHeaderTypeDef hdr;
-    uint8_t data[8];
-    uint32_t mailbox;
+/* 每次调度都运行：检查 I2C 超时、处理已完成的读取 */
+static void task_sample(uint32_t now)
+{
+    uint8_t fresh = 0;
+    uint8_t busy = 0;
+    uint8_t offline = 0;
+
+    ina226_interface_iic_poll();
+    PDM_Stats_Tick(now);
 
-    hdr.StdId = id;
-    hdr.ExtId = 0;
-    hdr.IDE = CAN_ID_STD;
-    hdr.RTR = CAN_RTR_DATA;
-    hdr.DLC = 8;
-    hdr.TransmitGlobalTime = DISABLE;
+#if PDM_CFG_SAMPLE_ON_ALERT
+    /* Conversion ready: read each chip as soon as its ALERT fires */
+    for (uint8_t i = 0; i < CH_COUNT; i++)
+    {
+        uint32_t ts_us = PDM_Sched_NowUs();
 
-    int16_t voltage, current;
-    uint16_t power, energy;
+        /* 有 ALERT 时 ts_us 改为转换完成的边沿（PDM_CFG_ALERT_CAPTURE），不含等待主循环的时间 */
+        if (!g_rd[i].active &&
+            (PDM_Alert_Take(i, &ts_us) || ts_us - g_rd[i].last_us >= PDM_CFG_ALERT_FALLBACK_MS * 1000u))
+        {
+            start_read_channel(&g_rd[i], now, ts_us);
+        }
+    }
+#else
+    PDM_Alert_Clear();          /* 定时采样不使用 ALERT */
+#if PDM_CFG_SYNC_TRIGGER
+    sync_poll(now);
+#endif
+#endif
 
-    if (ch->online)
+    for (uint8_t i = 0; i < CH_COUNT; i++)
     {
-        /* Saturating casts */
-        float v_mv = ch->voltage_mV;
-        if (v_mv > 32767.0f) v_mv = 32767.0f;
-        if (v_mv < -32768.0f) v_mv = -32768.0f;
-        voltage = (int16_t)v_mv;
+        read_ctx_t *rd = &g_rd[i];
 
-        float i_scaled = ch->current_mA / 10.0f;
-        if (i_scaled > 32767.0f) i_scaled = 32767.0f;
-        if (i_scaled < -32768.0f) i_scaled = -32768.0f;
-        current = (int16_t)i_scaled;
+        poll_probe(rd, now);
+#if PDM_CFG_SAMPLE_TIMER
+        if (rd->health == PDM_DEV_OFFLINE)
+        {
+            start_probe(rd, now);
+        }
+#endif
+        if (rd->active && !ina226_interface_job_busy(&rd->job))
+        {
+            PDM_PROF_BEGIN(PDM_PROF_SAMPLE);
+            finish_read_channel(rd);
+            PDM_PROF_END(PDM_PROF_SAMPLE);
+            fresh |= (uint8_t)(1u << i);
+        }
+        busy |= rd->active;
+        offline += (uint8_t)(rd->health == PDM_DEV_OFFLINE);
+    }
+#if PDM_CFG_DERIVED || PDM_CFG_PLAUS
+    if (PDM_Pair_Add(fresh))
+    {
+#if PDM_CFG_PLAUS
+        g_plaus_changed = 1;
+#endif
+    }
+#endif
+
+    /* 所有通道都没有读取在进行时，本组采样完成 */
+    if (fresh && !busy)
+    {
+        PDM_Wdg_CheckIn(g_wdg_sample);
 
-        float p_scaled = ch->power_mW / 100.0f;
-        if (p_scaled > 65535.0f) p_scaled = 65535.0f;
-        if (p_scaled < 0.0f) p_scaled = 0.0f;
-        power = (uint16_t)p_scaled;
+        pdm_bus_event_t ev = { PDM_BUS_EV_GROUP, 0, fresh, PDM_Sched_NowUs(), NULL };
 
-        float e_scaled = ch->energy_mWh / 10.0f;
-        if (e_scaled > 65535.0f) e_scaled = 65535.0f;
-        if (e_scaled < 0.0f) e_scaled = 0.0f;
-        energy = (uint16_t)e_scaled;
+        PDM_PROF_BEGIN(PDM_PROF_CAN_SEND);
+        PDM_Bus_Publish(&ev);           /* 通道帧、XCP 事件 */
+        PDM_PROF_END(PDM_PROF_CAN_SEND);
+
+#if PDM_CFG_INA226_CHECK_MS
+        config_check_poll();
+#endif
+#if PDM_CFG_ADAPT
+        adapt_apply();
+#endif
+        reconfig_apply();
+#if PDM_CFG_INA226_CHECK_MS
+        config_check_start(now);
+#endif
+
+        /* 距下一次读取最远的时刻，I2C 空闲时才允许擦除 flash 页 */
+        PDM_Store_Run(!ina226_interface_iic_busy());
+#if PDM_CFG_EVLOG
+        PDM_Evlog_Run(!ina226_interface_iic_busy());
+#endif
+#if PDM_CFG_TREND
+        PDM_Trend_Run(!ina226_interface_iic_busy());
+#endif
     }
-    else
+
+    /* 全部离线时没有读取可完成，采样流程本身仍在运行 */
+    if (offline == CH_COUNT)
+    {
+        PDM_Wdg_CheckIn(g_wdg_sample);
+    }
+}
+
+/* 每次调度都运行：处理 CAN 命令 */
+static void task_cmd(uint32_t now)
+{
+    (void)now;
+    PDM_Cmd_Poll();
+}
+
+#if PDM_CFG_PROTECT || PDM_CFG_TRIP
+/* 100ms: 打印新的保护故障和切断（故障帧已在中断中发出） */
+static void task_protect(uint32_t now)
+{
+    (void)now;
+#if PDM_CFG_PROTECT
+    PDM_Protect_Run();
+#endif
+#if PDM_CFG_TRIP
+    PDM_Trip_Run();
+#endif
+}
+#endif
+
+#if PDM_CFG_CAPTURE
+/* 每次调度都运行：高速采集结束后的恢复和发送 */
+static void task_capture(uint32_t now)
+{
+    (void)now;
+    PDM_Capture_Run();
+}
+#endif
+
+#if PDM_CFG_ISOTP
+static void task_isotp(uint32_t now)
+{
+    (void)now;
+    PDM_Isotp_Run();
+}
+#endif
+
+#if !PDM_CFG_SAMPLE_ON_ALERT && !PDM_CFG_SAMPLE_TIMER
+/* 50ms: read sensors (interrupt driven, results handled in task_sample) */
+static void task_read(uint32_t now)
+{
+    for (uint8_t i = 0; i < CH_COUNT; i++)
+    {
+        if (g_rd[i].active)
+        {
+            return;             /* 上一组还没读完 */
+        }
+    }
+#if PDM_CFG_SYNC_TRIGGER
+    (void)now;
+    if (!g_sync.wait)
+    {
+        sync_trigger();         /* 转换结束后在 task_sample 中读取 */
+    }
+#else
+    /* 各通道的读取一起排入 I2C 队列，在总线上依次进行，不等待 */
+    for (uint8_t i = 0; i < CH_COUNT; i++)
+    {
+#if PDM_CFG_ADAPT
+        /* 芯片还没有新的平均结果（平稳档窗口比采样周期长），本周期不读 */
+        if (PDM_Sched_NowUs() - g_rd[i].last_us < g_rd[i].window_us)
+        {
+            continue;
+        }
+#endif
+        start_read_channel(&g_rd[i], now, PDM_Sched_NowUs());
+    }
+#endif
+}
+#endif
+
+/* 5ms: send CAN messages that are due */
+static void task_can(uint32_t now)
+{
+    uint8_t first = g_first_frames;
+
+    if (first != 0)
     {
-        voltage = 0x7FFF;
-        current = 0x7FFF;
-        power = 0xFFFF;
-        energy = 0xFFFF;
+        uint32_t primask = __get_PRIMASK();
+
+        __disable_irq();
+        g_first_frames &= (uint8_t)~first;
+        __set_PRIMASK(primask);
+        for (uint8_t i = 0; i < CH_COUNT; i++)
+        {
+            if (first & (1u << i))
+            {
+                (void)PDM_Can_SendNow(PDM_Param_Get()->can_id[i], now);
+            }
+        }
+#if PDM_CFG_STARTUP
+        PDM_Startup_Mark(PDM_STARTUP_DATA);
+#endif
+    }
+#if PDM_CFG_STARTUP
+    PDM_Startup_Poll(now);
+#endif
+#if PDM_CFG_PLAUS
+    if (g_plaus_changed)
+    {
+        g_plaus_changed = 0;
+        (void)PDM_Can_SendNow(PDM_PLAUS_CAN_ID, now);
+    }
+#endif
+#if PDM_CFG_CANH
+    PDM_CanHealth_Poll(now);
+#endif
+#if PDM_CFG_RINT
+    PDM_Rint_Run(now);
+#endif
+#if PDM_CFG_NODE
+    PDM_Node_Poll(now);
+#endif
+#if PDM_CFG_BOOT
+    PDM_Boot_Poll(now);
+#endif
+#if PDM_CFG_CRASH
+    PDM_Crash_Poll();
+#endif
+#if PDM_CFG_LOAD
+    PDM_Load_Poll(now);
+#endif
+    PDM_PROF_BEGIN(PDM_PROF_CAN_SEND);
+    PDM_Can_Run(now);
+    PDM_PROF_END(PDM_PROF_CAN_SEND);
+    PDM_Wdg_CheckIn(g_wdg_can);
+}
+
+/* 10ms: flash 记录分步写入，按周期保存 */
+static void task_store(uint32_t now)
+{
+    PDM_Persist_Poll(now);
+    PDM_Store_Run(0);
+#if PDM_CFG_EVLOG
+    PDM_Evlog_Run(0);
+#endif
+#if PDM_CFG_TREND
+    PDM_Trend_Poll(now);
+    PDM_Trend_Run(0);
+#endif
+}
+
+/* 100ms: 所有任务按时报到才喂狗 */
+static void task_wdg(uint32_t now)
+{
+    PDM_Wdg_Run(now);
+}
+
+/* 500ms: LED heartbeat */
+static void task_led(uint32_t now)
+{
+    (void)now;
+    HAL_GPIO_TogglePin(LED_GPIO_Port, LED_Pin);
+}
+
+#if PDM_CFG_UART_STREAM
+/* --- 采样流信息帧：各通道电流 LSB，上位机据此换算 --- */
+static void stream_info(void)
+{
+    uint32_t lsb[CH_COUNT];
+
+    for (uint8_t i = 0; i < CH_COUNT; i++)
+    {
+        lsb[i] = g_ch_cfg[i].scale.current_ua_per_lsb;
     }
+    PDM_Stream_Info(CH_COUNT, lsb);
+#if PDM_CFG_TIMESYNC
+    {
+        uint32_t now_us = PDM_Sched_NowUs();
+        uint64_t v;
+        uint8_t st = PDM_TimeSync_ToVehicle(now_us, &v);
+
+        PDM_Stream_Time(st, now_us, v);
+    }
+#endif
+}
+#endif
+
+#if PDM_CFG_SHELL
+/* 20ms: UART 命令行 */
+static void task_shell(uint32_t now)
+{
+    (void)now;
+    PDM_Shell_Poll();
+}
+#endif
+
+/* 1000ms: UART debug */
+static void task_uart(uint32_t now)
+{
+    (void)now;
+    PDM_Wdg_CheckIn(g_wdg_uart);
+    PDM_Diag_Poll();            /* 驱动错误信息，每秒限量 */
+#if PDM_CFG_STACK
+    PDM_Stack_Run();
+#endif
+#if PDM_CFG_UART_STREAM
+    stream_info();              /* 采样流模式下不输出文本行，只重发换算信息 */
+#else
+    PDM_Report_PrintLine();
+#endif
+}
+
+#if PDM_CFG_PROFILE && PDM_CFG_PROFILE_DUMP_MS
+static void task_prof(uint32_t now)
+{
+    (void)now;
+    PDM_Prof_Dump();
+}
+#endif
+
+/* 任务表，按优先级排列 */
+static const pdm_task_t g_tasks[] = {
+    { "sample", task_sample, 0,             0,          0, GRP_ACQ | PDM_SCHED_EXCL },
+    { "cmd",    task_cmd,    0,             0,          0, GRP_COMMS | PDM_SCHED_EXCL },
+#if PDM_CFG_CAPTURE
+    { "capture", task_capture, 0,           0,          0, GRP_ACQ | PDM_SCHED_EXCL },
+#endif
+#if PDM_CFG_ISOTP
+    { "isotp",  task_isotp,  0,             0,          0, GRP_COMMS | PDM_SCHED_EXCL },
+#endif
+#if !PDM_CFG_SAMPLE_ON_ALERT && !PDM_CFG_SAMPLE_TIMER
+    { "read",   task_read,   INTERVAL_READ, PHASE_READ, 1, GRP_ACQ | PDM_SCHED_EXCL },
+#endif
+    { "can",    task_can,    INTERVAL_CAN,  PHASE_CAN,  2, GRP_COMMS | PDM_SCHED_EXCL },
+    { "store",  task_store,  INTERVAL_STORE, PHASE_STORE, 3, GRP_LOG | PDM_SCHED_EXCL },
+    { "led",    task_led,    INTERVAL_LED,  PHASE_LED,  3, GRP_LOG },
+#if PDM_CFG_PROTECT || PDM_CFG_TRIP
+    { "protect", task_protect, INTERVAL_PROTECT, PHASE_PROTECT, 4, GRP_COMMS | PDM_SCHED_EXCL },
+#endif
+    { "uart",   task_uart,   INTERVAL_UART, PHASE_UART, 4, GRP_LOG | PDM_SCHED_EXCL },
+#if PDM_CFG_SHELL
+    { "shell",  task_shell,  INTERVAL_SHELL, PHASE_SHELL, 4, GRP_COMMS | PDM_SCHED_EXCL },
+#endif
+    { "wdg",    task_wdg,    INTERVAL_WDG,  PHASE_WDG,  4, GRP_LOG },
+#if PDM_CFG_PROFILE && PDM_CFG_PROFILE_DUMP_MS
+    { "prof",   task_prof,   PDM_CFG_PROFILE_DUMP_MS, 35, 5, GRP_LOG },
+#endif
+};
+_Static_assert(sizeof(g_tasks) / sizeof(g_tasks[0]) <= PDM_SCHED_MAX_TASKS,
+               "task table larger than PDM_SCHED_MAX_TASKS, tasks at the end would never run");
+
+/* --- 采样事件的使用者 --- */
+static void sub_stats(const pdm_bus_event_t *ev)
+{
+    PDM_Stats_Add(ev->ch, ev->snap->current, ev->snap->bus, ev->snap->power);
+}
+
+#if PDM_CFG_HIST
+static void sub_hist(const pdm_bus_event_t *ev)
+{
+    PDM_Hist_Add(ev->ch, ev->snap->current);
+}
+#endif
+
+#if PDM_CFG_BLACKBOX
+static void sub_blackbox(const pdm_bus_event_t *ev)
+{
+    PDM_Blackbox_Add(ev->ch, HAL_GetTick(), ev->snap->current, ev->snap->bus);
+}
+#endif
+
+#if PDM_CFG_DECIM
+static void sub_decim(const pdm_bus_event_t *ev)
+{
+    PDM_Decim_Add(ev->ch, ev->snap->shunt);
+}
+#endif
 
-    data[0] = (uint8_t)(voltage >> 8);
-    data[1] = (uint8_t)(voltage & 0xFF);
-    data[2] = (uint8_t)(current >> 8);
-    data[3] = (uint8_t)(current & 0xFF);
-    data[4] = (uint8_t)(power >> 8);
-    data[5] = (uint8_t)(power & 0xFF);
-    data[6] = (uint8_t)(energy >> 8);
-    data[7] = (uint8_t)(energy & 0xFF);
+#if PDM_CFG_STEP
+static void sub_step(const pdm_bus_event_t *ev)
+{
+    PDM_Step_Add(ev->ch, ev->snap->current, ev->snap->bus, ev->ts_us);
+}
+#endif
+
+#if PDM_CFG_UART_STREAM
+static void sub_stream(const pdm_bus_event_t *ev)
+{
+    PDM_Stream_Sample(ev->ch, ev->ts_us, ev->snap->bus, ev->snap->shunt, ev->snap->current, ev->snap->power);
+}
+#endif
+
+static void sub_can(const pdm_bus_event_t *ev)
+{
+    (void)ev;
+    PDM_Can_OnSample();
+}
 
-    if (HAL_CAN_AddTxMessage(&hcan, &hdr, data, &mailbox) != HAL_OK)
+#if PDM_CFG_XCP
+static void sub_xcp(const pdm_bus_event_t *ev)
+{
+    (void)ev;
+    PDM_Xcp_Event(PDM_XCP_EVENT_SAMPLE);
+}
+#endif
+
+/* 订阅表，按调用顺序排列：同一事件中先运行的不受后面的影响 */
+static const pdm_bus_sub_t g_subs[] = {
+    { "stats",    PDM_BUS_EV_SAMPLE, 1, sub_stats },
+#if PDM_CFG_HIST
+    { "hist",     PDM_BUS_EV_SAMPLE, 1, sub_hist },
+#endif
+#if PDM_CFG_BLACKBOX
+    { "blackbox", PDM_BUS_EV_SAMPLE, 1, sub_blackbox },
+#endif
+#if PDM_CFG_DECIM
+    { "decim",    PDM_BUS_EV_SAMPLE, 1, sub_decim },
+#endif
+#if PDM_CFG_STEP
+    { "step",     PDM_BUS_EV_SAMPLE, 1, sub_step },
+#endif
+#if PDM_CFG_UART_STREAM
+    { "stream",   PDM_BUS_EV_SAMPLE, 1, sub_stream },
+#endif
+    { "can",      PDM_BUS_EV_GROUP,  1, sub_can },
+#if PDM_CFG_XCP
+    { "xcp",      PDM_BUS_EV_GROUP,  1, sub_xcp },
+#endif
+};
+_Static_assert(sizeof(g_subs) / sizeof(g_subs[0]) <= PDM_BUS_MAX_SUBS,
+               "subscriber table larger than PDM_BUS_MAX_SUBS");
+
+/* --- 启动时初始化所有 INA226 ---
+ * 不逐片调用 ina226_init()（每片软件复位后固定等 10 ms，再做 6 次读-改-写）：
+ *   1. 依次读厂商 ID 和配置寄存器；非上电复位且配置寄存器与期望值相同时，器件一直在按原配置转换，
+ *      不复位，只重写 MASK 和校准（不会重新开始转换），数据寄存器中已有有效结果；
+ *   2. 其余器件背靠背写复位位，一起等复位完成；
+ *   3. 先写所有器件的校准和 MASK，再背靠背写配置寄存器，各器件几乎同时开始第一次转换。
+ * 初始化完成后补上驱动句柄的状态，后面照常使用驱动的 ina226_set_xxx()。 */
+static uint8_t reg_read(const ina226_handle_t *h, uint8_t reg, uint16_t *v)
+{
+    uint8_t buf[2];
+
+    if (ina226_interface_iic_read(h->iic_addr, reg, buf, 2) != 0)
     {
-        ina226_interface_debug_print("CAN TX err 0x%03lX\r\n", id);
+        return 1;
     }
+    *v = (uint16_t)((uint16_t)buf[0] << 8 | buf[1]);
+    return 0;
+}
+
+static uint8_t reg_write(const ina226_handle_t *h, uint8_t reg, uint16_t v)
+{
+    uint8_t buf[2] = { (uint8_t)(v >> 8), (uint8_t)(v & 0xFF) };
+
+    return ina226_interface_iic_write(h->iic_addr, reg, buf, 2);
+}
+
+#if PDM_CFG_CAPTURE && PDM_CFG_CAPTURE_BOOT
+static uint8_t g_boot_capture_fail;     /* 1: 上电采集写配置失败，初始化时打印 */
+
+void PDM_Monitor_BootCapture(void)
+{
+    ina226_handle_t *h = &g_ina226[PDM_CFG_CAPTURE_CH];
+
+    if (g_ch_cfg[PDM_CFG_CAPTURE_CH].type != PDM_SENSOR_INA226)
+    {
+        return;
+    }
+    link_handle(h);
+    set_addr(h, &g_ch_cfg[PDM_CFG_CAPTURE_CH]);
+    g_boot_capture_fail = PDM_Capture_Boot(h->iic_addr);
+}
+#endif
+
+static void init_all(uint8_t cause)
+{
+    uint16_t conf[CH_COUNT];
+    uint8_t ok = 0;             /* 第 i 位: 器件应答 */
+    uint8_t reset = 0;          /* 第 i 位: 需要软件复位并重新配置 */
+    uint8_t warm = (uint8_t)((cause & PDM_RESET_POR) == 0);
+
+    for (uint8_t i = 0; i < CH_COUNT; i++)
+    {
+        ina226_handle_t *h = &g_ina226[i];
+        uint16_t v;
+
+        link_handle(h);
+        set_addr(h, &g_ch_cfg[i]);
+        conf[i] = pdm_calc_conf(g_ch_cfg[i].avg, BUS_CT, SHUNT_CT, INA226_MODE_SHUNT_BUS_VOLTAGE_CONTINUOUS);
+        if (g_ch_cfg[i].type != PDM_SENSOR_INA226)
+        {
+            continue;                   /* INA228 在最后单独初始化 */
+        }
+        if (reg_read(h, INA226_REG_MANUFACTURER, &v) != 0 || v != INA226_MANUFACTURER_ID ||
+            reg_read(h, INA226_REG_CONF, &v) != 0)
+        {
+            continue;
+        }
+        ok |= (uint8_t)(1u << i);
+#if PDM_CFG_CAPTURE && PDM_CFG_CAPTURE_BOOT
+        if (i == PDM_CFG_CAPTURE_CH && PDM_Capture_Active())
+        {
+            continue;                   /* 上电采集正在读，不复位，结束后恢复正常配置 */
+        }
+#endif
+        if (!warm || v != conf[i])
+        {
+            reset |= (uint8_t)(1u << i);
+            if (reg_write(h, INA226_REG_CONF, CONF_RESET) != 0)
+            {
+                ok &= (uint8_t)~(1u << i);
+            }
+        }
+    }
+
+    /* 复位位自动清零后复位完成，最多等 INIT_RESET_MS */
+    uint8_t wait = (uint8_t)(reset & ok);
+    for (uint8_t t = 0; wait != 0 && t < INIT_RESET_MS; t++)
+    {
+        ina226_interface_delay_ms(1);
+        for (uint8_t i = 0; i < CH_COUNT; i++)
+        {
+            uint16_t v;
+
+            if ((wait & (1u << i)) && reg_read(&g_ina226[i], INA226_REG_CONF, &v) == 0 &&
+                (v & CONF_RESET) == 0)
+            {
+                wait &= (uint8_t)~(1u << i);
+            }
+        }
+    }
+    ok &= (uint8_t)~wait;
+
+    for (uint8_t i = 0; i < CH_COUNT; i++)
+    {
+        ina226_handle_t *h = &g_ina226[i];
+        uint16_t cal;
+
+        if ((ok & (1u << i)) == 0)
+        {
+            continue;
+        }
+        if (reg_write(h, INA226_REG_MASK, PDM_CFG_SAMPLE_ON_ALERT ? MASK_CNVR : 0) != 0 ||
+            reg_read(h, INA226_REG_CALIBRATION, &cal) != 0 ||
+            (cal != g_ch_cfg[i].scale.cal && reg_write(h, INA226_REG_CALIBRATION, g_ch_cfg[i].scale.cal) != 0))
+        {
+            ok &= (uint8_t)~(1u << i);
+        }
+    }
+
+    uint32_t now = HAL_GetTick();
+    for (uint8_t i = 0; i < CH_COUNT; i++)
+    {
+        ina226_handle_t *h = &g_ina226[i];
+
+        g_rd[i].index = i;
+        g_rd[i].first = 1;
+        if (g_ch_cfg[i].type == PDM_SENSOR_INA228)
+        {
+            reset |= (uint8_t)(1u << i);    /* 总是复位，累计寄存器从 0 开始 */
+            if (init_228(h, &g_ch_cfg[i]) == 0)
+            {
+                ok |= (uint8_t)(1u << i);
+            }
+        }
+        else if ((ok & (1u << i)) && (reset & (1u << i)) && reg_write(h, INA226_REG_CONF, conf[i]) != 0)
+        {
+            ok &= (uint8_t)~(1u << i);
+        }
+        if ((ok & (1u << i)) == 0)
+        {
+            ina226_interface_debug_print("INA226 %s init FAIL\r\n", g_ch_cfg[i].name);
+            mark_offline(&g_rd[i], now);
+            continue;
+        }
+        g_rd[i].ready = 1;
+        if (g_ch_cfg[i].type == PDM_SENSOR_INA226)
+        {
+            h->trigger = 0;
+            h->inited = 1;
+        }
+    }
+    ina226_interface_debug_print("INA226 init: reset 0x%02X warm 0x%02X\r\n",
+                                 (unsigned)(reset & ok), (unsigned)(ok & (uint8_t)~reset));
 }
 
 /* --- Public API --- */
 
 void PDM_Monitor_Init(void)
 {
-    memset(&g_ch_bus, 0, sizeof(g_ch_bus));
-    memset(&g_ch_bat, 0, sizeof(g_ch_bat));
+    uint8_t cause = PDM_Wdg_ResetCause();
+
+    PDM_Prof_Init();
+#if PDM_CFG_UART_STREAM
+    PDM_Stream_Init();          /* 改波特率，之后才输出日志 */
+#endif
+#if PDM_CFG_SHELL
+    PDM_Shell_Init();
+#endif
+#if PDM_TIMER_US
+    PDM_Timer_Init();           /* PDM_Sched_NowUs() 的时间来源 */
+#endif
+#if PDM_CFG_STARTUP
+    PDM_Startup_Init();
+#endif
+    if (cause & PDM_RESET_IWDG)
+    {
+        ina226_interface_debug_print("reset by watchdog\r\n");
+    }
 
-    link_handle(&g_ina226_bus);
-    link_handle(&g_ina226_bat);
+    PDM_Apply_Init();
+    for (uint8_t i = 0; i < CH_COUNT; i++)
+    {
+        cfg_from_param(i);      /* 器件在 init_all() 中按通道表初始化 */
+    }
+#if PDM_CFG_EVLOG
+    if (PDM_Evlog_Init() != 0)
+    {
+        ina226_interface_debug_print("event log area overlaps firmware, disabled\r\n");
+    }
+#endif
+#if PDM_CFG_TREND
+    if (PDM_Trend_Init() != 0)
+    {
+        ina226_interface_debug_print("trend log area overlaps firmware, disabled\r\n");
+    }
+#endif
+#if PDM_CFG_NODE
+    PDM_Node_Init(PDM_Param_Get()->node);   /* 之后发送的帧都按节点号偏移 */
+#endif
+#if PDM_CFG_TRIP
+    PDM_Trip_Init();            /* 尽早使能负载开关，门限按运行参数 */
+    for (uint8_t i = 0; i < CH_COUNT; i++)
+    {
+        PDM_Trip_Config(i, &g_ch_cfg[i].scale);
+    }
+#endif
+    memset(g_ch, 0, sizeof(g_ch));
+    for (uint8_t i = 0; i < CH_COUNT; i++)
+    {
+        g_ch[i].v_min_mV = INT32_MAX;     /* 没有保存的记录时从第一次采样开始 */
+    }
+    PDM_Persist_Init();
+    for (uint8_t i = 0; i < CH_COUNT; i++)
+    {
+        publish_channel(i);
+    }
+#if PDM_CFG_EVLOG
+    PDM_Evlog_Add(PDM_EV_BOOT, PDM_EV_NO_CH, cause, (uint16_t)PDM_Persist_Boots());
+#endif
+#if PDM_CFG_CRASH
+    if (PDM_Crash_Init())
+    {
+        const pdm_crash_t *c = PDM_Crash_Last();
+
+        ina226_interface_debug_print("crash before reset: type %u, pc 0x%08lX, cfsr 0x%08lX, task %u\r\n",
+                                     c->type, (unsigned long)c->v[PDM_CRASH_V_PC],
+                                     (unsigned long)c->v[PDM_CRASH_V_CFSR], c->task);
+#if PDM_CFG_EVLOG
+        PDM_Evlog_Add(PDM_EV_CRASH, (c->task == PDM_CRASH_NO_TASK) ? PDM_EV_NO_CH : c->task, c->type,
+                      (uint16_t)(c->v[PDM_CRASH_V_PC] & 0xFFFF));
+#endif
+    }
+#endif
 
-    if (init_one(&g_ina226_bus, INA226_ADDRESS_0) != 0)
+#if PDM_CFG_CAPTURE && PDM_CFG_CAPTURE_BOOT
+    if (g_boot_capture_fail)
     {
-        ina226_interface_debug_print("INA226 #1 (bus) init FAIL\r\n");
+        ina226_interface_debug_print("boot capture FAIL\r\n");
     }
-    if (init_one(&g_ina226_bat, INA226_ADDRESS_1) != 0)
+#endif
+    init_all(cause);
+    for (uint8_t i = 0; i < CH_COUNT; i++)
     {
-        ina226_interface_debug_print("INA226 #2 (bat) init FAIL\r\n");
+        g_rd[i].window_us = pdm_calc_window_us(g_ch_cfg[i].avg, BUS_CT, SHUNT_CT);
+#if PDM_CFG_ADAPT
+        PDM_Adapt_Init(i, g_ch_cfg[i].avg, ADAPT_MAX_LEVEL(i));
+#endif
     }
 
+#if PDM_CFG_PROTECT
+    PDM_Protect_Init(&g_ina226[CH_BUS], &g_ch_cfg[CH_BUS].scale, &g_ina226[CH_BAT]);
+#endif
+#if PDM_CFG_CAPTURE
+    PDM_Capture_Init(&g_ina226[PDM_CFG_CAPTURE_CH], g_ch_cfg[PDM_CFG_CAPTURE_CH].avg,
+                     &g_ch_cfg[PDM_CFG_CAPTURE_CH].scale);
+#endif
+#if PDM_CFG_BLACKBOX || PDM_CFG_HIST
+    {
+        uint32_t lsb[CH_COUNT];
+
+        for (uint8_t i = 0; i < CH_COUNT; i++)
+        {
+            lsb[i] = g_ch_cfg[i].scale.current_ua_per_lsb;
+        }
+#if PDM_CFG_BLACKBOX
+        PDM_Blackbox_Init(lsb, cause);
+#endif
+#if PDM_CFG_HIST
+        PDM_Hist_Init(lsb);
+#endif
+    }
+#endif
+
     uint32_t now = HAL_GetTick();
-    g_last_read_tick = now;
-    g_last_can_tick  = now;
-    g_last_uart_tick = now;
+    for (uint8_t i = 0; i < CH_COUNT; i++)
+    {
+        g_rd[i].last_us = PDM_Sched_NowUs();
+        PDM_Stats_Init(i, &g_ch_cfg[i].scale, now);
+#if PDM_CFG_LAP
+        PDM_Lap_Init(i, &g_ch_cfg[i].scale, g_ch[i].energy_acc, now);
+#endif
+#if PDM_CFG_FILTER
+        PDM_Filter_Init(i);
+#endif
+#if PDM_CFG_DECIM
+        PDM_Decim_Init(i, &g_ch_cfg[i].scale);
+#endif
+#if PDM_CFG_STEP
+        PDM_Step_Init(i, &g_ch_cfg[i].scale);
+#endif
+#if PDM_CFG_PLAUS
+        PDM_Plaus_Init(i, g_ch_cfg[i].scale.cal);
+#endif
+    }
+#if PDM_CFG_E2E
+    PDM_E2E_Init();
+#endif
+    PDM_Telem_Init(now);
+#if PDM_CFG_CANH
+    PDM_CanHealth_Init(now);
+#endif
+#if PDM_CFG_MCU
+    if (PDM_Mcu_Init() != 0)
+    {
+        ina226_interface_debug_print("mcu adc init FAIL\r\n");
+    }
+#endif
+    PDM_Persist_SendBoot();
+#if PDM_CFG_STARTUP
+    PDM_Startup_Mark(PDM_STARTUP_FRAME);
+#endif
+
+    /* 采样周期可通过命令放长到 PDM_MONITOR_PERIOD_MAX，期限按最长周期留余量 */
+    g_wdg_sample = PDM_Wdg_Register("sample", 2u * PDM_MONITOR_PERIOD_MAX + 500u);
+    g_wdg_can = PDM_Wdg_Register("can", 200);
+    g_wdg_uart = PDM_Wdg_Register("uart", 3u * INTERVAL_UART);
+#if PDM_CFG_PVD_SAVE
+    PDM_Persist_PvdInit();
+#endif
+    PDM_Bus_Init(g_subs, (uint8_t)(sizeof(g_subs) / sizeof(g_subs[0])));
+    PDM_Sched_Init(g_tasks, (uint8_t)(sizeof(g_tasks) / sizeof(g_tasks[0])), now);
+#if PDM_CFG_LOAD
+    PDM_Load_Init();
+#endif
+#if PDM_CFG_SAMPLE_TIMER
+    PDM_Timer_StartSample(PDM_Param_Get()->sample_ms, on_sample_clock);
+#elif !PDM_CFG_SAMPLE_ON_ALERT
+    if (PDM_Param_Get()->sample_ms != INTERVAL_READ)
+    {
+        (void)PDM_Monitor_SetSamplePeriod(PDM_Param_Get()->sample_ms);
+    }
+#endif
 
+    PDM_Wdg_Start();
+#if PDM_CFG_STARTUP
+    PDM_Startup_Mark(PDM_STARTUP_INIT);
+#endif
     ina226_interface_debug_print("PDM Monitor initialized\r\n");
+#if PDM_CFG_UART_STREAM
+    stream_info();
+#endif
 }
 
-void PDM_Monitor_Update(void)
+/* --- 是否有中断驱动的工作在进行，此时只休眠到下一个中断 --- */
+static uint8_t io_busy(void)
 {
-    uint32_t now = HAL_GetTick();
-
-    /* 50ms: read sensors */
-    if (now - g_last_read_tick >= INTERVAL_READ)
+    for (uint8_t i = 0; i < CH_COUNT; i++)
     {
-        float dt_h = (float)(now - g_last_read_tick) / 3600000.0f;
-        g_last_read_tick = now;
-        read_channel(&g_ina226_bus, &g_ch_bus, dt_h);
-        read_channel(&g_ina226_bat, &g_ch_bat, dt_h);
+        if (g_rd[i].active || g_rd[i].probing)
+        {
+            return 1;
+        }
+    }
+#if PDM_CFG_SYNC_TRIGGER
+    if (g_sync.wait)
+    {
+        return 1;
+    }
+#endif
+#if PDM_CFG_ISOTP
+    if (PDM_Isotp_Busy())
+    {
+        return 1;
+    }
+#endif
+#if PDM_CFG_CAPTURE
+    if (PDM_Capture_Active())
+    {
+        return 1;
     }
+#endif
+    return ina226_interface_iic_busy();
+}
 
-    /* 500ms: CAN + LED heartbeat */
-    if (now - g_last_can_tick >= INTERVAL_CAN)
+void PDM_Monitor_Update(void)
+{
+    PDM_Sched_Run();
+    PDM_Sched_Idle((uint8_t)!io_busy());
+}
+
+void PDM_Monitor_ResetEnergy(uint8_t mask)
+{
+    for (uint8_t i = 0; i < CH_COUNT && i < 8; i++)
     {
-        g_last_can_tick = now;
-        send_can_frame(CAN_ID_BUS, &g_ch_bus);
-        send_can_frame(CAN_ID_BAT, &g_ch_bat);
-        HAL_GPIO_TogglePin(LED_GPIO_Port, LED_Pin);
+        if (mask & (1u << i))
+        {
+#if PDM_CFG_LAP
+            PDM_Lap_Rebase(i, g_ch[i].energy_acc);
+#endif
+            g_ch[i].energy_acc = 0;
+            g_ch[i].energy_uWh = 0;
+            g_ch[i].energy_wraps = 0;
+            g_ch[i].charge_acc = 0;
+            g_ch[i].energy_dis_acc = 0;
+            g_ch[i].energy_chg_acc = 0;
+            g_ch[i].energy_dis_uWh = 0;
+            g_ch[i].energy_chg_uWh = 0;
+            publish_channel(i);
+        }
     }
+}
 
-    /* 1000ms: UART debug */
-    if (now - g_last_uart_tick >= INTERVAL_UART)
+uint8_t PDM_Monitor_GetChannel(uint8_t ch, pdm_channel_t *out)
+{
+    uint32_t seq;
+
+    if (ch >= CH_COUNT)
     {
-        g_last_uart_tick = now;
-        ina226_interface_debug_print(
-            "BUS: %.0fmV %.1fmA %.1fmW %.1fmWh | "
-            "BAT: %.0fmV %.1fmA %.1fmW %.1fmWh\r\n",
-            g_ch_bus.voltage_mV, g_ch_bus.current_mA,
-            g_ch_bus.power_mW, g_ch_bus.energy_mWh,
-            g_ch_bat.voltage_mV, g_ch_bat.current_mA,
-            g_ch_bat.power_mW, g_ch_bat.energy_mWh);
+        memset(out, 0, sizeof(*out));
+        return 1;
     }
+    /* 复制期间序号变了说明写者插进来写过（可能正写到这一份），重取。
+     * 中断里调用时主循环的写者不会在中途运行，不会重试 */
+    do
+    {
+        seq = g_ch_seq[ch];
+        __DMB();
+        *out = g_ch_pub[ch][seq & 1u];
+        __DMB();
+    } while (g_ch_seq[ch] != seq);
+    return 0;
+}
 
-    /* Alert handling (disabled as per requirement) */
-    if (g_alert1_flag)
+uint8_t PDM_Monitor_SetSamplePeriod(uint16_t period_ms)
+{
+#if PDM_CFG_SAMPLE_ON_ALERT
+    (void)period_ms;
+    return 1;       /* 采样节奏由芯片决定 */
+#else
+    if (period_ms < PDM_MONITOR_PERIOD_MIN || period_ms > PDM_MONITOR_PERIOD_MAX)
     {
-        g_alert1_flag = 0;
+        return 1;
     }
-    if (g_alert2_flag)
+#if PDM_CFG_SAMPLE_TIMER
+    PDM_Timer_SetPeriod(period_ms);
+    return 0;
+#else
+    for (uint8_t i = 0; i < PDM_Sched_TaskCount(); i++)
     {
-        g_alert2_flag = 0;
+        if (PDM_Sched_GetTask(i)->run == task_read)
+        {
+            PDM_Sched_SetPeriod(i, period_ms);
+            return 0;
+        }
     }
+    return 1;
+#endif
+#endif
+}
+
+uint32_t PDM_Monitor_Seq(uint8_t ch)
+{
+    return g_ch_seq[ch];
+}
+
+const pdm_channel_cfg_t *PDM_Monitor_Config(uint8_t ch)
+{
+    return &g_ch_cfg[ch];
+}
+
+void PDM_Monitor_GetStatus(uint8_t ch, pdm_dev_status_t *out)
+{
+    const read_ctx_t *rd = &g_rd[ch];
+
+    out->health = rd->health;
+    out->level = ch_level(ch);
+    out->errors = rd->errors;
+    out->reinits = rd->reinits;
+    out->restores = rd->restores;
+}
+
+void PDM_Monitor_Reconfigure(uint8_t ch)
+{
+    g_rd[ch].reconfig = 1;
+}
+
+void PDM_Monitor_Restore(uint8_t ch, uint64_t energy_acc, uint8_t energy_wraps, int32_t v_min_mV, int32_t v_max_mV)
+{
+    pdm_channel_t *c = &g_ch[ch];
+
+    c->energy_acc = energy_acc;
+    c->energy_uWh = pdm_calc_energy_uWh(energy_acc, &g_ch_cfg[ch].scale);
+    c->energy_wraps = energy_wraps;
+    c->v_min_mV = v_min_mV;
+    c->v_max_mV = v_max_mV;
+}
+
+uint8_t PDM_Monitor_StartCapture(void)
+{
+#if PDM_CFG_CAPTURE
+    return PDM_Capture_Arm();
+#else
+    return 1;
+#endif
+}
+
+uint8_t PDM_Monitor_FastStream(uint8_t on)
+{
+#if PDM_CFG_CAPTURE && PDM_CFG_CAPTURE_FAST
+    return PDM_Capture_Fast(on);
+#else
+    (void)on;
+    return 1;
+#endif
 }
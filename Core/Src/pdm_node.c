@@ -0,0 +1,138 @@
+#include "pdm_node.h"
+
+#if PDM_CFG_NODE
+
+#include "pdm_can.h"
+#include "pdm_log.h"
+#include "pdm_monitor.h"
+#include "pdm_persist.h"
+#include "stm32f1xx_hal.h"
+
+#if PDM_CFG_NODE_MAX < 1 || 0x3FFu + (PDM_CFG_NODE_MAX - 1u) * PDM_CFG_NODE_STRIDE > 0x7FFu
+#error "PDM_CFG_NODE_MAX x PDM_CFG_NODE_STRIDE does not fit in 11-bit IDs"
+#endif
+#if PDM_CFG_NODE_STRAP > 2 || (1u << PDM_CFG_NODE_STRAP) > PDM_CFG_NODE_MAX
+#error "PDM_CFG_NODE_STRAP must be 0..2 and give node IDs below PDM_CFG_NODE_MAX"
+#endif
+
+static uint8_t g_id;
+static uint8_t g_src;
+static uint8_t g_strap;                 /* 跳线读数，没有跳线时为 0 */
+static uint32_t g_offset;
+static volatile uint8_t g_discover;
+static uint32_t g_last_hb;
+
+#if PDM_CFG_NODE_STRAP
+static uint8_t strap_read(void)
+{
+    static const uint16_t pins[2] = { PDM_CFG_NODE_STRAP_PIN0, PDM_CFG_NODE_STRAP_PIN1 };
+    GPIO_InitTypeDef gpio = {0};
+    uint8_t v = 0;
+
+    __HAL_RCC_GPIOB_CLK_ENABLE();
+    for (uint8_t b = 0; b < PDM_CFG_NODE_STRAP; b++)
+    {
+        gpio.Pin |= pins[b];
+    }
+    gpio.Mode = GPIO_MODE_INPUT;
+    gpio.Pull = GPIO_PULLUP;
+    HAL_GPIO_Init(PDM_CFG_NODE_STRAP_PORT, &gpio);
+    HAL_Delay(2);                       /* 等上拉把引脚电容充上 */
+
+    for (uint8_t b = 0; b < PDM_CFG_NODE_STRAP; b++)
+    {
+        if (HAL_GPIO_ReadPin(PDM_CFG_NODE_STRAP_PORT, pins[b]) == GPIO_PIN_RESET)
+        {
+            v |= (uint8_t)(1u << b);
+        }
+    }
+    return v;
+}
+#endif
+
+void PDM_Node_Init(uint8_t param)
+{
+#if PDM_CFG_NODE_STRAP
+    g_strap = strap_read();
+#endif
+    if (param == PDM_NODE_FROM_STRAP)
+    {
+        g_id = g_strap;
+        g_src = PDM_NODE_SRC_STRAP;
+    }
+    else
+    {
+        g_id = (param < PDM_CFG_NODE_MAX) ? param : 0u;
+        g_src = PDM_NODE_SRC_PARAM;
+    }
+    g_offset = (uint32_t)g_id * PDM_CFG_NODE_STRIDE;
+    g_discover = 1;                     /* 上电后先发一帧心跳 */
+}
+
+uint8_t PDM_Node_Id(void)
+{
+    return g_id;
+}
+
+uint32_t PDM_Node_TxId(uint32_t id)
+{
+    return id + g_offset;
+}
+
+uint32_t PDM_Node_RxId(uint32_t id)
+{
+    if (id == PDM_CFG_NODE_DISCOVER_ID || id == PDM_CFG_TIMESYNC_ID ||
+        (PDM_CFG_LAP_TRIGGER_ID != 0 && id == PDM_CFG_LAP_TRIGGER_ID))
+    {
+        return id;
+    }
+    return id - g_offset;
+}
+
+void PDM_Node_Discover(void)
+{
+    g_discover = 1;
+}
+
+void PDM_Node_Poll(uint32_t now)
+{
+    uint8_t online = 0;
+    uint32_t up;
+    uint8_t data[8];
+
+    if (!g_discover && (PDM_CFG_NODE_HB_MS == 0 || now - g_last_hb < PDM_CFG_NODE_HB_MS))
+    {
+        return;
+    }
+    g_discover = 0;
+    g_last_hb = now;
+
+    for (uint8_t i = 0; i < PDM_CFG_CHANNELS && i < 8; i++)
+    {
+        pdm_channel_t c;
+
+        if (PDM_Monitor_GetChannel(i, &c) == 0 && c.online)
+        {
+            online |= (uint8_t)(1u << i);
+        }
+    }
+    up = PDM_Persist_UptimeS();
+    data[0] = g_id;
+    data[1] = g_src;
+    data[2] = PDM_CFG_CHANNELS;
+    data[3] = online;
+    data[4] = (uint8_t)(up >> 24);
+    data[5] = (uint8_t)(up >> 16);
+    data[6] = (uint8_t)(up >> 8);
+    data[7] = (uint8_t)up;
+    (void)PDM_Can_Send(PDM_NODE_HB_CAN_ID, data, sizeof(data));
+}
+
+void PDM_Node_Print(void)
+{
+    PDM_Log_Printf("node %u (%s) id offset 0x%03lX strap %u%s\r\n", g_id,
+                   (g_src == PDM_NODE_SRC_STRAP) ? "strap" : "param", (unsigned long)g_offset, g_strap,
+                   PDM_CFG_NODE_STRAP ? "" : " (no strap pins)");
+}
+
+#endif /* PDM_CFG_NODE */
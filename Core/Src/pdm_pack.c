@@ -0,0 +1,94 @@
+#include "pdm_pack.h"
+
+static uint32_t zigzag(int32_t v)
+{
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static uint8_t bit_width(uint32_t v)
+{
+    uint8_t w = 0;
+
+    while (v != 0)
+    {
+        w++;
+        v >>= 1;
+    }
+    return w;
+}
+
+void PDM_Pack_Init(pdm_pack_t *p)
+{
+    p->n = 0;
+    p->or_all = 0;
+}
+
+uint8_t PDM_Pack_Put(pdm_pack_t *p, uint32_t v)
+{
+    if (p->n == 0)
+    {
+        p->first = v;
+    }
+    else
+    {
+        uint32_t z = zigzag((int32_t)(v - p->prev));
+
+        p->zz[p->n - 1u] = z;
+        p->or_all |= z;
+    }
+    p->prev = v;
+    p->n++;
+    return (uint8_t)(p->n >= PDM_PACK_BLOCK);
+}
+
+uint8_t PDM_Pack_Flush(pdm_pack_t *p, uint8_t *out)
+{
+    uint8_t w = bit_width(p->or_all);
+    uint32_t first = zigzag((int32_t)p->first);
+    uint8_t len = 2;
+    uint32_t acc = 0;               /* 待输出的位，低 nbits 位有效 */
+    uint8_t nbits = 0;
+
+    if (p->n == 0)
+    {
+        return 0;
+    }
+    out[0] = p->n;
+    out[1] = w;
+    do
+    {
+        uint8_t b = (uint8_t)(first & 0x7Fu);
+
+        first >>= 7;
+        out[len++] = (uint8_t)(first != 0 ? (b | 0x80u) : b);
+    } while (first != 0);
+
+    /* w 最大 32 位：每次先放入高半再放低半，acc 中不会超过 23 位 */
+    for (uint8_t i = 0; w != 0 && i + 1u < p->n; i++)
+    {
+        uint32_t z = p->zz[i];
+        uint8_t rest = w;
+
+        while (rest > 0)
+        {
+            uint8_t take = (rest > 16u) ? (uint8_t)(rest - 16u) : rest;
+
+            rest = (uint8_t)(rest - take);
+            acc = (acc << take) | ((z >> rest) & ((1u << take) - 1u));
+            nbits = (uint8_t)(nbits + take);
+            while (nbits >= 8u)
+            {
+                nbits = (uint8_t)(nbits - 8u);
+                out[len++] = (uint8_t)(acc >> nbits);
+            }
+            acc &= (1u << nbits) - 1u;
+        }
+    }
+    if (nbits > 0)
+    {
+        out[len++] = (uint8_t)(acc << (8u - nbits));
+    }
+
+    PDM_Pack_Init(p);
+    return len;
+}
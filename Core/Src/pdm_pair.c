@@ -0,0 +1,48 @@
+#include "pdm_pair.h"
+
+#if PDM_CFG_DERIVED || PDM_CFG_PLAUS
+
+#include "pdm_derived.h"
+#include "pdm_monitor.h"
+#include "pdm_plaus.h"
+
+static uint8_t g_pending;           /* 第 i 位: 通道 i 的新采样还没有配对 */
+
+uint8_t PDM_Pair_Add(uint8_t fresh)
+{
+    pdm_channel_t bus, bat;
+    uint32_t skew;
+    uint8_t changed = 0;
+
+    g_pending |= (uint8_t)(fresh & 0x03u);
+    if (g_pending != 0x03u)
+    {
+        return 0;
+    }
+    g_pending = 0;
+    PDM_Monitor_GetChannel(0, &bus);
+    PDM_Monitor_GetChannel(1, &bat);
+    skew = bus.sample_us - bat.sample_us;
+    if ((int32_t)skew < 0)
+    {
+        skew = 0u - skew;
+    }
+    if (!bus.online || !bat.online || skew > PDM_CFG_DERIVED_SKEW_US)
+    {
+        return 0;
+    }
+#if PDM_CFG_DERIVED
+    PDM_Derived_Add(bus.voltage_mV, bus.current_uA, bat.voltage_mV, bat.current_uA);
+#endif
+#if PDM_CFG_PLAUS
+    {
+        uint8_t before = (uint8_t)(PDM_Plaus_Flags(0) | PDM_Plaus_Flags(1) << 4);
+
+        PDM_Plaus_Pair(bus.voltage_mV, bat.voltage_mV, bat.current_uA);
+        changed = (uint8_t)((uint8_t)(PDM_Plaus_Flags(0) | PDM_Plaus_Flags(1) << 4) != before);
+    }
+#endif
+    return changed;
+}
+
+#endif /* PDM_CFG_DERIVED || PDM_CFG_PLAUS */
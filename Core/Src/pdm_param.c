@@ -0,0 +1,415 @@
+#include "pdm_param.h"
+#include "pdm_calc.h"
+#include "pdm_log.h"
+#include "pdm_store.h"
+#include "stm32f1xx_hal.h"
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+/* 参数区在存储区之前（STM32F103C8: 64 KB flash） */
+#define PARAM_BASE          (FLASH_BASE + 0x10000u - (PDM_CFG_STORE_PAGES + PDM_PARAM_PAGES) * PDM_STORE_PAGE_SIZE)
+#define PARAM_SLOTS_PAGE    (PDM_STORE_PAGE_SIZE / PDM_PARAM_REC_SIZE)
+#define PARAM_SLOTS         (PDM_PARAM_PAGES * PARAM_SLOTS_PAGE)
+#define PARAM_DATA_MAX      (PDM_PARAM_REC_SIZE - 12u)
+
+#define REC_MAGIC           0x5251u     /* 记录从 64 字节改为 128 字节时由 0x5250 更换，旧记录不会按新格式解析 */
+#define REC_HALFWORDS       (PDM_PARAM_REC_SIZE / 2u)
+
+typedef struct {
+    uint16_t version;
+    uint16_t len;
+    uint8_t data[PARAM_DATA_MAX];
+    uint32_t seq;
+    uint16_t crc;
+    uint16_t magic;
+} param_rec_t;
+
+_Static_assert(sizeof(param_rec_t) == PDM_PARAM_REC_SIZE, "param record size");
+_Static_assert(sizeof(pdm_param_t) <= PARAM_DATA_MAX, "pdm_param_t does not fit in a param record");
+
+/* 参数描述：每通道参数的 ID 和偏移按通道号递增 */
+typedef struct {
+    uint8_t id;
+    uint8_t size;
+    uint8_t flags;
+    uint8_t offset;
+    int32_t min;
+    int32_t max;
+    const char *name;
+} param_desc_t;
+
+#define F_PER_CH            0x01
+#define F_SIGNED            0x02
+
+#define DESC(id, field, flags, min, max, name) \
+    { id, (uint8_t)sizeof(((pdm_param_t *)0)->field), flags, (uint8_t)offsetof(pdm_param_t, field), min, max, name }
+
+static const param_desc_t g_desc[] = {
+    DESC(PDM_PARAM_SAMPLE_MS,     sample_ms,     0, 10, 1000, "sample_ms"),
+    DESC(PDM_PARAM_CAN_MS,        can_ms,        0, 0, 60000, "can_ms"),
+    DESC(PDM_PARAM_CAN_ON_SAMPLE, can_on_sample, 0, 0, 1, "can_on_sample"),
+    DESC(PDM_PARAM_BUS_CT,        bus_ct,        0, 0, 7, "bus_ct"),
+    DESC(PDM_PARAM_SHUNT_CT,      shunt_ct,      0, 0, 7, "shunt_ct"),
+    DESC(PDM_PARAM_CAN_MIN_MS,    can_min_ms,    0, 0, 60000, "can_min_ms"),
+    DESC(PDM_PARAM_CAN_MAX_MS,    can_max_ms,    0, 0, 60000, "can_max_ms"),
+    DESC(PDM_PARAM_CAN_DB_MV,     can_db_mv,     0, 0, 60000, "can_db_mv"),
+    DESC(PDM_PARAM_NODE,          node,          0, 0, 0xFF, "node"),
+    DESC(PDM_PARAM_SHUNT_UOHM,    shunt_uohm[0], F_PER_CH, 1, 1000000, "shunt_uohm"),
+    DESC(PDM_PARAM_AVG,           avg[0],        F_PER_CH, 0, 7, "avg"),
+    DESC(PDM_PARAM_CAN_ID,        can_id[0],     F_PER_CH, 1, 0x7FF, "can_id"),
+    DESC(PDM_PARAM_OFFSET,        offset[0],     F_PER_CH | F_SIGNED, -4000, 4000, "offset"),
+    DESC(PDM_PARAM_TRIP_OC,       trip_oc_ma[0], F_PER_CH, 0, 65535, "trip_oc_ma"),
+    DESC(PDM_PARAM_TRIP_NOM,      trip_nom_ma[0], F_PER_CH, 0, 65535, "trip_nom_ma"),
+    DESC(PDM_PARAM_TRIP_I2T,      trip_i2t[0],   F_PER_CH, 0, 1000000, "trip_i2t"),
+    DESC(PDM_PARAM_TRIP_UV,       trip_uv_mv[0], F_PER_CH, 0, 60000, "trip_uv_mv"),
+    DESC(PDM_PARAM_CAN_DB_MA,     can_db_ma[0],  F_PER_CH, 0, 60000, "can_db_ma"),
+    DESC(PDM_PARAM_STEP_MA,       step_ma[0],    F_PER_CH, 0, 60000, "step_ma"),
+};
+
+#define DESC_COUNT          (sizeof(g_desc) / sizeof(g_desc[0]))
+
+/* 各版本记录中有效的参数长度，下标为版本号 */
+static const uint8_t g_ver_len[PDM_PARAM_VERSION + 1] = {
+    0,
+    (uint8_t)offsetof(pdm_param_t, offset),
+    (uint8_t)offsetof(pdm_param_t, trip_i2t),
+    (uint8_t)offsetof(pdm_param_t, can_min_ms),
+    (uint8_t)offsetof(pdm_param_t, step_ma),
+    (uint8_t)offsetof(pdm_param_t, node),
+    (uint8_t)sizeof(pdm_param_t),
+};
+
+/* 程序镜像结束位置（链接脚本中的符号） */
+extern uint32_t _sidata;
+extern uint32_t _sdata;
+extern uint32_t _edata;
+
+static pdm_param_t g_param;
+static pdm_param_t g_default;
+static uint8_t (*g_check)(const pdm_param_t *p);
+static void (*g_apply)(const pdm_param_t *old);
+
+static uint8_t g_area_ok;
+static uint8_t g_source;
+static int16_t g_newest = -1;       /* 最新有效记录的槽号 */
+static uint32_t g_seq;             /* 已用过的最大序号 */
+
+static const param_rec_t *slot_rec(uint16_t slot)
+{
+    return (const param_rec_t *)(PARAM_BASE + (uint32_t)slot * PDM_PARAM_REC_SIZE);
+}
+
+static uint8_t slot_erased(uint16_t slot)
+{
+    const uint32_t *p = (const uint32_t *)slot_rec(slot);
+
+    for (uint8_t i = 0; i < PDM_PARAM_REC_SIZE / 4u; i++)
+    {
+        if (p[i] != 0xFFFFFFFFu)
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static uint8_t rec_valid(const param_rec_t *r)
+{
+    return r->magic == REC_MAGIC &&
+           r->crc == pdm_calc_crc16((const uint8_t *)r, offsetof(param_rec_t, crc));
+}
+
+/* --- 找序号最大的记录：只看标志和序号，不校验 CRC --- */
+static void scan(void)
+{
+    g_newest = -1;
+    g_seq = 0;
+    for (uint16_t i = 0; i < PARAM_SLOTS; i++)
+    {
+        const param_rec_t *r = slot_rec(i);
+
+        if (r->magic == REC_MAGIC && r->seq != 0xFFFFFFFFu &&
+            (g_newest < 0 || (int32_t)(r->seq - g_seq) > 0))
+        {
+            g_newest = (int16_t)i;
+            g_seq = r->seq;
+        }
+    }
+}
+
+/* --- 最新记录读入 out；返回来源 PDM_PARAM_SRC_*，不是 FLASH 时 out 不变 --- */
+static uint8_t load(pdm_param_t *out)
+{
+    const param_rec_t *r;
+    pdm_param_t p;
+
+    if (!g_area_ok || g_newest < 0)
+    {
+        return PDM_PARAM_SRC_DEFAULT;
+    }
+    r = slot_rec((uint16_t)g_newest);
+    if (!rec_valid(r) || r->version == 0 || r->version > PDM_PARAM_VERSION ||
+        (r->version == PDM_PARAM_VERSION ? r->len != sizeof(pdm_param_t) : r->len < g_ver_len[r->version]))
+    {
+        return PDM_PARAM_SRC_INVALID;
+    }
+    p = g_default;
+    memcpy(&p, r->data, g_ver_len[r->version]);
+    if (g_check(&p) != 0)
+    {
+        return PDM_PARAM_SRC_INVALID;
+    }
+    *out = p;
+    return PDM_PARAM_SRC_FLASH;
+}
+
+static const param_desc_t *find_desc(uint8_t id, uint8_t *ch)
+{
+    for (uint8_t i = 0; i < DESC_COUNT; i++)
+    {
+        const param_desc_t *d = &g_desc[i];
+
+        if (id == d->id || ((d->flags & F_PER_CH) && id > d->id && id < d->id + PDM_CFG_CHANNELS))
+        {
+            *ch = (uint8_t)(id - d->id);
+            return d;
+        }
+    }
+    return NULL;
+}
+
+static uint32_t read_field(const pdm_param_t *p, const param_desc_t *d, uint8_t ch)
+{
+    const uint8_t *src = (const uint8_t *)p + d->offset + (uint32_t)ch * d->size;
+
+    switch (d->size)
+    {
+    case 1: return (d->flags & F_SIGNED) ? (uint32_t)(int32_t)*(const int8_t *)src : *src;
+    case 2: return (d->flags & F_SIGNED) ? (uint32_t)(int32_t)*(const int16_t *)src : *(const uint16_t *)src;
+    default: return *(const uint32_t *)src;
+    }
+}
+
+static uint8_t in_range(const param_desc_t *d, uint32_t v)
+{
+    if (d->flags & F_SIGNED)
+    {
+        return (int32_t)v >= d->min && (int32_t)v <= d->max;
+    }
+    return v >= (uint32_t)d->min && v <= (uint32_t)d->max;
+}
+
+static void write_field(pdm_param_t *p, const param_desc_t *d, uint8_t ch, uint32_t v)
+{
+    uint8_t *dst = (uint8_t *)p + d->offset + (uint32_t)ch * d->size;
+
+    switch (d->size)
+    {
+    case 1: *dst = (uint8_t)v; break;
+    case 2: *(uint16_t *)dst = (uint16_t)v; break;
+    default: *(uint32_t *)dst = v; break;
+    }
+}
+
+/* --- 换成新参数并通知使用者 --- */
+static void replace(const pdm_param_t *p)
+{
+    pdm_param_t old = g_param;
+
+    g_param = *p;
+    if (g_apply != NULL && memcmp(&old, &g_param, sizeof(old)) != 0)
+    {
+        g_apply(&old);
+    }
+}
+
+uint8_t PDM_Param_Init(const pdm_param_t *defaults, uint8_t (*check)(const pdm_param_t *p),
+                       void (*apply)(const pdm_param_t *old))
+{
+    uint32_t image_end = (uint32_t)&_sidata + ((uint32_t)&_edata - (uint32_t)&_sdata);
+
+    g_default = *defaults;
+    g_param = *defaults;
+    g_check = check;
+    g_apply = NULL;
+    g_area_ok = (image_end <= PARAM_BASE);
+    if (g_area_ok)
+    {
+        scan();
+    }
+    g_source = load(&g_param);
+    g_apply = apply;
+
+    if (g_source == PDM_PARAM_SRC_FLASH)
+    {
+        PDM_Log_Printf("param: loaded seq %lu v%u\r\n", (unsigned long)g_seq, slot_rec((uint16_t)g_newest)->version);
+    }
+    else
+    {
+        PDM_Log_Printf("param: %s, using defaults\r\n",
+                       !g_area_ok ? "no flash area" : (g_source == PDM_PARAM_SRC_INVALID) ? "record invalid" : "no record");
+    }
+    return g_source;
+}
+
+const pdm_param_t *PDM_Param_Get(void)
+{
+    return &g_param;
+}
+
+uint8_t PDM_Param_Set(uint8_t id, uint32_t value)
+{
+    const param_desc_t *d;
+    pdm_param_t p = g_param;
+    uint8_t ch;
+
+    d = find_desc(id, &ch);
+    if (d == NULL || !in_range(d, value))
+    {
+        return 1;
+    }
+    write_field(&p, d, ch, value);
+    if (g_check(&p) != 0)
+    {
+        return 1;
+    }
+    replace(&p);
+    return 0;
+}
+
+uint8_t PDM_Param_Value(uint8_t id, uint32_t *value)
+{
+    const param_desc_t *d;
+    uint8_t ch;
+
+    d = find_desc(id, &ch);
+    if (d == NULL)
+    {
+        return 1;
+    }
+    *value = read_field(&g_param, d, ch);
+    return 0;
+}
+
+uint8_t PDM_Param_Save(void)
+{
+    param_rec_t rec;
+    const uint16_t *src = (const uint16_t *)&rec;
+    uint16_t slot;
+    uint32_t dst;
+    uint8_t err = 0;
+
+    if (!g_area_ok)
+    {
+        return 1;
+    }
+
+    /* 下一个空槽；进入另一页时先擦除该页，当前页的记录保留到新记录写完 */
+    slot = (g_newest < 0) ? 0 : (uint16_t)((g_newest + 1) % PARAM_SLOTS);
+    for (uint16_t n = 0; n < PARAM_SLOTS && !slot_erased(slot); n++)
+    {
+        if (slot % PARAM_SLOTS_PAGE == 0 && (g_newest < 0 || slot / PARAM_SLOTS_PAGE != (uint16_t)g_newest / PARAM_SLOTS_PAGE))
+        {
+            FLASH_EraseInitTypeDef er;
+            uint32_t page_err;
+
+            er.TypeErase = FLASH_TYPEERASE_PAGES;
+            er.Banks = FLASH_BANK_1;
+            er.PageAddress = (uint32_t)slot_rec(slot);
+            er.NbPages = 1;
+            HAL_FLASH_Unlock();
+            (void)HAL_FLASHEx_Erase(&er, &page_err);
+            HAL_FLASH_Lock();
+            break;
+        }
+        slot = (uint16_t)((slot + 1u) % PARAM_SLOTS);
+    }
+    if (!slot_erased(slot))
+    {
+        return 1;
+    }
+
+    memset(&rec, 0xFF, sizeof(rec));
+    rec.version = PDM_PARAM_VERSION;
+    rec.len = sizeof(pdm_param_t);
+    memcpy(rec.data, &g_param, sizeof(g_param));
+    rec.seq = g_seq + 1u;
+    rec.crc = pdm_calc_crc16((const uint8_t *)&rec, offsetof(param_rec_t, crc));
+    rec.magic = REC_MAGIC;
+
+    /* 版本、参数、序号、CRC 先写，标志最后一个半字写入 */
+    dst = (uint32_t)slot_rec(slot);
+    HAL_FLASH_Unlock();
+    for (uint8_t i = 0; i < REC_HALFWORDS && !err; i++)
+    {
+        if (src[i] != 0xFFFFu && HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD, dst + 2u * i, src[i]) != HAL_OK)
+        {
+            err = 1;
+        }
+    }
+    HAL_FLASH_Lock();
+
+    if (err || !rec_valid(slot_rec(slot)))
+    {
+        PDM_Log_Printf("param: save failed at slot %u\r\n", slot);
+        return 1;
+    }
+    g_newest = (int16_t)slot;
+    g_seq = rec.seq;
+    g_source = PDM_PARAM_SRC_FLASH;
+    PDM_Log_Printf("param: saved seq %lu\r\n", (unsigned long)g_seq);
+    return 0;
+}
+
+void PDM_Param_Defaults(void)
+{
+    replace(&g_default);
+    g_source = PDM_PARAM_SRC_DEFAULT;
+}
+
+uint8_t PDM_Param_Reload(void)
+{
+    pdm_param_t p;
+
+    if (load(&p) != PDM_PARAM_SRC_FLASH)
+    {
+        return 1;
+    }
+    replace(&p);
+    g_source = PDM_PARAM_SRC_FLASH;
+    return 0;
+}
+
+void PDM_Param_Print(void)
+{
+    static const char *const src_name[] = { "flash", "default", "invalid record" };
+
+    PDM_Log_Printf("param source %s seq %lu v%u\r\n", src_name[g_source], (unsigned long)g_seq, PDM_PARAM_VERSION);
+    for (uint8_t i = 0; i < DESC_COUNT; i++)
+    {
+        const param_desc_t *d = &g_desc[i];
+
+        for (uint8_t ch = 0; ch < ((d->flags & F_PER_CH) ? PDM_CFG_CHANNELS : 1u); ch++)
+        {
+            uint32_t v = read_field(&g_param, d, ch);
+            uint32_t def = read_field(&g_default, d, ch);
+            char idx[6] = "";
+
+            if (d->flags & F_PER_CH)
+            {
+                (void)snprintf(idx, sizeof(idx), "[%u]", ch);
+            }
+            if (d->flags & F_SIGNED)
+            {
+                PDM_Log_Printf("  0x%02X %s%s = %ld%s\r\n", d->id + ch, d->name, idx, (long)(int32_t)v,
+                               (v != def) ? " *" : "");
+            }
+            else
+            {
+                PDM_Log_Printf("  0x%02X %s%s = %lu%s\r\n", d->id + ch, d->name, idx, (unsigned long)v,
+                               (v != def) ? " *" : "");
+            }
+        }
+    }
+}
@@ -0,0 +1,226 @@
+#include "pdm_persist.h"
+#include "pdm_blackbox.h"
+#include "pdm_calc.h"
+#include "pdm_can.h"
+#include "pdm_hist.h"
+#include "pdm_irq.h"
+#include "pdm_monitor.h"
+#include "pdm_rint.h"
+#include "pdm_soc.h"
+#include "pdm_store.h"
+#include "pdm_wdg.h"
+#include "ina226_async.h"
+#include "stm32f1xx_hal.h"
+#include <string.h>
+
+#define CH_COUNT    PDM_CFG_CHANNELS
+
+/* 启动帧 data[0] 标志位 */
+#define BOOT_FLAG_RESTORED      0x01    /* 从 flash 恢复了累计数据 */
+#define BOOT_FLAG_LAST_GASP     0x02    /* 上次断电前成功保存 */
+
+/* 保存到 flash 的数据（pdm_store 记录内容），改布局时增加版本号。
+ * 两通道时布局与版本 1 相同，通道数不同的记录不会被读入；电流分布计数附加在最后。
+ * 电池内阻和能量回绕次数附加在最后，由 flags 标明有效：旧记录中这些位为 0（记录的剩余部分为 0xFF），不需要改版本号 */
+#define PERSIST_VERSION     ((CH_COUNT == 2 ? 1u : 0x100u + CH_COUNT) + (PDM_CFG_HIST ? 0x1000u : 0u))
+
+#define PERSIST_PERIODIC    0
+#define PERSIST_LAST_GASP   1
+
+#define PERSIST_FLAG_SOC    0x01    /* soc_mAs 有效 */
+#define PERSIST_FLAG_RINT   0x02    /* rint_uohm、rint_n 有效 */
+#define PERSIST_FLAG_WRAPS  0x04    /* energy_wraps 有效 */
+
+typedef struct {
+    uint16_t version;
+    uint16_t v_min_mV[CH_COUNT];
+    uint16_t v_max_mV[CH_COUNT];
+    uint8_t reason;             /* PERSIST_PERIODIC / PERSIST_LAST_GASP */
+    uint8_t flags;              /* PERSIST_FLAG_* */
+    uint32_t boots;             /* 上电次数 */
+    uint32_t uptime_s;          /* 累计运行时间 */
+    int32_t soc_mAs;            /* 电池剩余电量 (mAs) */
+    uint64_t energy_acc[CH_COUNT];
+#if PDM_CFG_HIST
+    uint32_t hist[CH_COUNT][PDM_HIST_BINS];
+#endif
+    uint32_t rint_uohm;         /* 电池内阻平均值 */
+    uint16_t rint_n;
+    uint8_t energy_wraps[CH_COUNT];
+} persist_t;
+
+_Static_assert(sizeof(persist_t) <= PDM_STORE_PAYLOAD, "persist_t does not fit in one flash record");
+
+static uint32_t g_boots;
+static uint32_t g_uptime_base;  /* 之前各次上电的累计运行时间 */
+static uint8_t g_boot_flags;
+
+/* --- Restore counters from the newest flash record --- */
+static void persist_restore(void)
+{
+    persist_t p;
+
+    if (PDM_Store_Init() != 0)
+    {
+        ina226_interface_debug_print("store area overlaps firmware, disabled\r\n");
+        return;
+    }
+    if (PDM_Store_Load(&p, sizeof(p)) != 0 || p.version != PERSIST_VERSION)
+    {
+        return;
+    }
+
+    for (uint8_t i = 0; i < CH_COUNT; i++)
+    {
+        PDM_Monitor_Restore(i, p.energy_acc[i], (p.flags & PERSIST_FLAG_WRAPS) ? p.energy_wraps[i] : 0u,
+                            p.v_min_mV[i], p.v_max_mV[i]);
+#if PDM_CFG_HIST
+        PDM_Hist_Restore(i, p.hist[i]);
+#endif
+    }
+    g_boots = p.boots;
+    g_uptime_base = p.uptime_s;
+#if PDM_CFG_SOC
+    if (p.flags & PERSIST_FLAG_SOC)
+    {
+        PDM_Soc_Restore(p.soc_mAs);
+    }
+#endif
+#if PDM_CFG_RINT
+    if (p.flags & PERSIST_FLAG_RINT)
+    {
+        PDM_Rint_Restore(p.rint_uohm, p.rint_n);
+    }
+#endif
+
+    g_boot_flags |= BOOT_FLAG_RESTORED;
+    if (p.reason == PERSIST_LAST_GASP)
+    {
+        g_boot_flags |= BOOT_FLAG_LAST_GASP;
+    }
+}
+
+static void persist_fill(persist_t *p, uint8_t reason)
+{
+    memset(p, 0, sizeof(*p));
+    p->version = PERSIST_VERSION;
+    p->reason = reason;
+    for (uint8_t i = 0; i < CH_COUNT; i++)
+    {
+        pdm_channel_t c;
+
+        /* 可能在 PVD 中断里调用，主循环正在更新通道数据时也能取到完整的一份 */
+        PDM_Monitor_GetChannel(i, &c);
+        p->v_min_mV[i] = pdm_calc_sat_u16((uint32_t)(c.v_min_mV < 0 ? 0 : c.v_min_mV));
+        p->v_max_mV[i] = pdm_calc_sat_u16((uint32_t)(c.v_max_mV < 0 ? 0 : c.v_max_mV));
+        p->energy_acc[i] = c.energy_acc;
+        p->energy_wraps[i] = c.energy_wraps;
+#if PDM_CFG_HIST
+        PDM_Hist_Get(i, p->hist[i]);
+#endif
+    }
+    p->flags |= PERSIST_FLAG_WRAPS;
+    p->boots = g_boots;
+    p->uptime_s = PDM_Persist_UptimeS();
+#if PDM_CFG_SOC
+    if (PDM_Soc_Saved(&p->soc_mAs))
+    {
+        p->flags |= PERSIST_FLAG_SOC;
+    }
+#endif
+#if PDM_CFG_RINT
+    p->rint_uohm = PDM_Rint_Get(&p->rint_n);
+    if (p->rint_n != 0)
+    {
+        p->flags |= PERSIST_FLAG_RINT;
+    }
+#endif
+}
+
+void PDM_Persist_Init(void)
+{
+    persist_restore();
+    g_boots++;
+}
+
+void PDM_Persist_Poll(uint32_t now)
+{
+#if PDM_CFG_STORE_PERIOD_S
+    static uint32_t last_save;
+    persist_t p;
+
+    if (now - last_save >= PDM_CFG_STORE_PERIOD_S * 1000u)
+    {
+        last_save = now;
+        persist_fill(&p, PERSIST_PERIODIC);
+        (void)PDM_Store_Append(&p, sizeof(p));
+    }
+#else
+    (void)now;
+#endif
+}
+
+#if PDM_CFG_PVD_SAVE
+/* --- VDD 低于门限时产生中断（PVD 输出上升沿），恢复时也产生中断 --- */
+void PDM_Persist_PvdInit(void)
+{
+    PWR_PVDTypeDef cfg;
+
+    cfg.PVDLevel = PDM_CFG_PVD_LEVEL;
+    cfg.Mode = PWR_PVD_MODE_IT_RISING_FALLING;
+    HAL_PWR_ConfigPVD(&cfg);
+    HAL_PWR_EnablePVD();
+
+    HAL_NVIC_SetPriority(PVD_IRQn, PDM_IRQ_PRIO_FAULT, 0);
+    HAL_NVIC_EnableIRQ(PVD_IRQn);
+}
+
+void HAL_PWR_PVDCallback(void)
+{
+    static uint8_t saved;
+    persist_t p;
+
+    if ((PWR->CSR & PWR_CSR_PVDO) == 0)
+    {
+        saved = 0;              /* 电压恢复，下次跌落时再保存 */
+        return;
+    }
+    if (saved)
+    {
+        return;
+    }
+
+#if PDM_CFG_BLACKBOX
+    PDM_Blackbox_Freeze(PDM_BB_REASON_PVD);
+#endif
+    persist_fill(&p, PERSIST_LAST_GASP);
+    saved = (uint8_t)(PDM_Store_WriteNow(&p, sizeof(p)) == 0);
+}
+#endif
+
+/* --- 上电后报告一次：标志、上电次数、累计运行时间 --- */
+void PDM_Persist_SendBoot(void)
+{
+    uint8_t data[8];
+    uint32_t up = PDM_Persist_UptimeS();
+
+    data[0] = g_boot_flags;
+    data[1] = PDM_Wdg_ResetCause();
+    data[2] = (uint8_t)(g_boots >> 8);
+    data[3] = (uint8_t)(g_boots & 0xFF);
+    data[4] = (uint8_t)(up >> 24);
+    data[5] = (uint8_t)(up >> 16);
+    data[6] = (uint8_t)(up >> 8);
+    data[7] = (uint8_t)(up & 0xFF);
+    (void)PDM_Can_Send(PDM_PERSIST_BOOT_ID, data, sizeof(data));
+}
+
+uint32_t PDM_Persist_Boots(void)
+{
+    return g_boots;
+}
+
+uint32_t PDM_Persist_UptimeS(void)
+{
+    return g_uptime_base + HAL_GetTick() / 1000u;
+}
@@ -0,0 +1,95 @@
+#include "pdm_ping.h"
+
+#if PDM_CFG_PING
+
+#include "pdm_log.h"
+#include "pdm_sched.h"
+
+typedef struct {
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+} ping_stat_t;
+
+static uint32_t g_count;
+static uint32_t g_fail;                 /* 发送队列满，没有回复 */
+static ping_stat_t g_proc;
+static ping_stat_t g_enq;
+
+static void stat_add(ping_stat_t *s, uint32_t us)
+{
+    if (g_count == 1u || us < s->min)
+    {
+        s->min = us;
+    }
+    if (us > s->max)
+    {
+        s->max = us;
+    }
+    s->sum += us;
+}
+
+static void put_sat16(uint8_t *p, uint32_t v)
+{
+    if (v > 0xFFFFu)
+    {
+        v = 0xFFFFu;
+    }
+    p[0] = (uint8_t)(v >> 8);
+    p[1] = (uint8_t)(v & 0xFF);
+}
+
+void PDM_Ping_Rx(const pdm_can_frame_t *f)
+{
+    uint32_t proc_us = PDM_Sched_NowUs() - f->t_us;
+    uint32_t enq_us;
+    uint8_t data[8];
+
+    if (f->dlc == 0 || PDM_Can_Send(PDM_PING_ECHO_ID, f->data, f->dlc) != 0)
+    {
+        g_fail += (f->dlc != 0);
+        return;
+    }
+    enq_us = PDM_Sched_NowUs() - f->t_us;
+
+    g_count++;
+    stat_add(&g_proc, proc_us);
+    stat_add(&g_enq, enq_us);
+
+    data[0] = f->data[0];
+    put_sat16(&data[1], proc_us);
+    put_sat16(&data[3], enq_us);
+    data[5] = (uint8_t)(f->t_us >> 16);
+    data[6] = (uint8_t)(f->t_us >> 8);
+    data[7] = (uint8_t)(f->t_us & 0xFF);
+    if (PDM_Can_Send(PDM_PING_TIME_ID, data, sizeof(data)) != 0)
+    {
+        g_fail++;
+    }
+}
+
+void PDM_Ping_Print(void)
+{
+    uint32_t n = (g_count != 0) ? g_count : 1u;
+
+    PDM_Log_Printf("ping %lu, failed %lu\r\n", (unsigned long)g_count, (unsigned long)g_fail);
+    if (g_count == 0)
+    {
+        return;
+    }
+    PDM_Log_Printf("  rx->poll %lu/%lu/%lu us, rx->queued %lu/%lu/%lu us (min/avg/max)\r\n",
+                   (unsigned long)g_proc.min, (unsigned long)(g_proc.sum / n), (unsigned long)g_proc.max,
+                   (unsigned long)g_enq.min, (unsigned long)(g_enq.sum / n), (unsigned long)g_enq.max);
+}
+
+void PDM_Ping_Reset(void)
+{
+    g_count = 0;
+    g_fail = 0;
+    g_proc.max = 0;
+    g_proc.sum = 0;
+    g_enq.max = 0;
+    g_enq.sum = 0;
+}
+
+#endif /* PDM_CFG_PING */
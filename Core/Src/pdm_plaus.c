@@ -0,0 +1,147 @@
+#include "pdm_plaus.h"
+
+#if PDM_CFG_PLAUS
+
+#include <string.h>
+
+#define MASK_CVRF       0x0008u
+
+/* 连续计数的检查项 */
+#define K_SHUNT         0
+#define K_POWER         1
+#define K_VREL          2
+#define K_COUNT         3
+
+/* 允许的偏差：固定几个 LSB（取整）加读数的 1/32 */
+#define TOL_LSB         4
+
+typedef struct {
+    uint16_t cal;
+    uint8_t flags;
+    uint8_t streak[K_COUNT];    /* 与当前标志相反的连续采样数 */
+    uint16_t same;              /* 连续不变的新转换数 */
+    int16_t last_shunt;
+    uint16_t last_bus;
+    int16_t last_current;
+    uint8_t count;              /* 有标志的采样数，到 255 保持 */
+} plaus_t;
+
+static plaus_t g_pl[PDM_CFG_CHANNELS];
+
+static uint32_t abs_diff(int32_t a, int32_t b)
+{
+    return (a > b) ? (uint32_t)(a - b) : (uint32_t)(b - a);
+}
+
+static uint8_t mismatch(int32_t got, int32_t expect)
+{
+    uint32_t mag = (expect < 0) ? (uint32_t)-expect : (uint32_t)expect;
+
+    return (uint8_t)(abs_diff(got, expect) > TOL_LSB + mag / 32u);
+}
+
+/* --- 检查结果与当前标志不同的采样连续 PDM_CFG_PLAUS_COUNT 个后改变标志 --- */
+static void judge(plaus_t *p, uint8_t k, uint8_t bit, uint8_t bad)
+{
+    if (bad == ((p->flags & bit) != 0))
+    {
+        p->streak[k] = 0;
+        return;
+    }
+    if (++p->streak[k] >= PDM_CFG_PLAUS_COUNT)
+    {
+        p->flags ^= bit;
+        p->streak[k] = 0;
+    }
+}
+
+void PDM_Plaus_Init(uint8_t ch, uint16_t cal)
+{
+    memset(&g_pl[ch], 0, sizeof(g_pl[ch]));
+    g_pl[ch].cal = cal;
+}
+
+void PDM_Plaus_Overflow(uint8_t ch)
+{
+    plaus_t *p = &g_pl[ch];
+
+    p->flags |= PDM_PLAUS_OVF;
+    if (p->count < 255u)
+    {
+        p->count++;
+    }
+}
+
+void PDM_Plaus_Check(uint8_t ch, const ina226_regs_t *snap)
+{
+    plaus_t *p = &g_pl[ch];
+    int32_t i_expect = (int32_t)snap->shunt * p->cal / 2048;
+    uint32_t i_mag = (snap->current < 0) ? (uint32_t)-(int32_t)snap->current : (uint32_t)snap->current;
+
+    p->flags &= (uint8_t)~PDM_PLAUS_OVF;
+    judge(p, K_SHUNT, PDM_PLAUS_SHUNT, mismatch(snap->current, i_expect));
+    judge(p, K_POWER, PDM_PLAUS_POWER, mismatch(snap->power, (int32_t)(i_mag * snap->bus / 20000u)));
+
+    /* 没有新转换时寄存器不变是正常的，只数新转换 */
+    if (snap->mask & MASK_CVRF)
+    {
+        if (snap->shunt == p->last_shunt && snap->bus == p->last_bus && snap->current == p->last_current)
+        {
+            if (p->same < PDM_CFG_PLAUS_STUCK_N)
+            {
+                p->same++;
+            }
+        }
+        else
+        {
+            p->same = 0;
+        }
+        p->last_shunt = snap->shunt;
+        p->last_bus = snap->bus;
+        p->last_current = snap->current;
+        if (p->same >= PDM_CFG_PLAUS_STUCK_N)
+        {
+            p->flags |= PDM_PLAUS_STUCK;
+        }
+        else
+        {
+            p->flags &= (uint8_t)~PDM_PLAUS_STUCK;
+        }
+    }
+
+    if (p->flags != 0 && p->count < 255u)
+    {
+        p->count++;
+    }
+}
+
+void PDM_Plaus_Pair(int32_t bus_mV, int32_t bat_mV, int32_t bat_uA)
+{
+    uint8_t bad = 0;
+
+    /* 电池不放电时总线电压由 DCDC 决定，不检查（按符合计） */
+    if (bat_uA >= PDM_CFG_PLAUS_VREL_MIN_MA * 1000)
+    {
+        bad = (uint8_t)(bus_mV > bat_mV + PDM_CFG_PLAUS_VREL_TOL_MV || bus_mV < bat_mV - PDM_CFG_PLAUS_DROP_MV);
+    }
+    judge(&g_pl[0], K_VREL, PDM_PLAUS_VREL, bad);
+    judge(&g_pl[1], K_VREL, PDM_PLAUS_VREL, bad);
+}
+
+uint8_t PDM_Plaus_Flags(uint8_t ch)
+{
+    return g_pl[ch].flags;
+}
+
+void PDM_Plaus_Encode(uint8_t *data, const void *arg)
+{
+    (void)arg;
+    memset(data, 0, 8);
+    for (uint8_t i = 0; i < PDM_CFG_CHANNELS && i < 4; i++)
+    {
+        data[i] = g_pl[i].flags;
+        data[4 + i] = g_pl[i].count;
+    }
+}
+
+#endif /* PDM_CFG_PLAUS */
@@ -0,0 +1,151 @@
+#include "pdm_pool.h"
+#include "pdm_log.h"
+#include "pdm_ramfunc.h"
+#include "stm32f1xx_hal.h"
+#include <stddef.h>
+
+_Static_assert(PDM_POOL_BLOCK_SIZE % 4 == 0, "PDM_POOL_BLOCK_SIZE must be a multiple of 4");
+_Static_assert(PDM_CFG_POOL_BLOCKS <= 255, "PDM_CFG_POOL_BLOCKS must fit in uint8_t");
+_Static_assert(PDM_CFG_POOL_CAN_RESERVE + PDM_CFG_POOL_LOG_RESERVE <= PDM_CFG_POOL_BLOCKS,
+               "pool reserves exceed PDM_CFG_POOL_BLOCKS");
+_Static_assert(PDM_CFG_POOL_CAN_RESERVE <= PDM_CFG_CAN_TXQ_LEN && PDM_CFG_POOL_LOG_RESERVE <= PDM_CFG_POOL_LOG_MAX,
+               "pool reserve larger than quota");
+
+typedef union blk {
+    union blk *next;            /* 空闲时 */
+    uint32_t w[PDM_POOL_BLOCK_SIZE / 4];
+} blk_t;
+
+typedef struct {
+    uint8_t used;
+    uint8_t peak;
+    uint8_t reserve;
+    uint8_t quota;
+    uint32_t fails;
+} user_t;
+
+static blk_t g_mem[PDM_CFG_POOL_BLOCKS];
+static blk_t *g_free;
+static uint8_t g_nfree;
+static uint8_t g_nfree_min;
+static uint8_t g_held;          /* 各使用者还没用到的 reserve 之和 */
+
+static user_t g_user[PDM_POOL_USERS] = {
+    [PDM_POOL_CAN]     = { 0, 0, PDM_CFG_POOL_CAN_RESERVE, PDM_CFG_CAN_TXQ_LEN, 0 },
+    [PDM_POOL_LOG]     = { 0, 0, PDM_CFG_POOL_LOG_RESERVE, PDM_CFG_POOL_LOG_MAX, 0 },
+    [PDM_POOL_CAPTURE] = { 0, 0, 0, (PDM_CFG_CAPTURE && PDM_CFG_CAPTURE_PACK) ? 2 : 0, 0 },
+};
+
+static const char *const g_name[PDM_POOL_USERS] = { "can", "log", "capture" };
+
+void PDM_Pool_Init(void)
+{
+    g_free = NULL;
+    for (uint8_t i = 0; i < PDM_CFG_POOL_BLOCKS; i++)
+    {
+        g_mem[i].next = g_free;
+        g_free = &g_mem[i];
+    }
+    g_nfree = PDM_CFG_POOL_BLOCKS;
+    g_nfree_min = PDM_CFG_POOL_BLOCKS;
+    g_held = 0;
+    for (uint8_t u = 0; u < PDM_POOL_USERS; u++)
+    {
+        g_user[u].used = 0;
+        g_user[u].peak = 0;
+        g_user[u].fails = 0;
+        g_held = (uint8_t)(g_held + g_user[u].reserve);
+    }
+}
+
+PDM_RAMFUNC void *PDM_Pool_Alloc(uint8_t user)
+{
+    user_t *u = &g_user[user];
+    uint32_t primask = __get_PRIMASK();
+    uint8_t own;
+    blk_t *b;
+
+    __disable_irq();
+    /* 自己还有 reserve 时用自己的，否则只能用别人的 reserve 以外的部分 */
+    own = (uint8_t)(u->used < u->reserve);
+    if (u->used >= u->quota || g_free == NULL || (!own && g_nfree <= g_held))
+    {
+        u->fails++;
+        __set_PRIMASK(primask);
+        return NULL;
+    }
+    b = g_free;
+    g_free = b->next;
+    g_nfree--;
+    if (g_nfree < g_nfree_min)
+    {
+        g_nfree_min = g_nfree;
+    }
+    if (own)
+    {
+        g_held--;
+    }
+    u->used++;
+    if (u->used > u->peak)
+    {
+        u->peak = u->used;
+    }
+    __set_PRIMASK(primask);
+    return b;
+}
+
+PDM_RAMFUNC void PDM_Pool_Free(uint8_t user, void *blk)
+{
+    user_t *u = &g_user[user];
+    blk_t *b = (blk_t *)blk;
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    b->next = g_free;
+    g_free = b;
+    g_nfree++;
+    u->used--;
+    if (u->used < u->reserve)
+    {
+        g_held++;
+    }
+    __set_PRIMASK(primask);
+}
+
+uint8_t PDM_Pool_FreeCount(void)
+{
+    return g_nfree;
+}
+
+uint8_t PDM_Pool_FreeMin(void)
+{
+    return g_nfree_min;
+}
+
+void PDM_Pool_GetStat(uint8_t user, pdm_pool_stat_t *st)
+{
+    const user_t *u = &g_user[user];
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    st->used = u->used;
+    st->peak = u->peak;
+    st->reserve = u->reserve;
+    st->quota = u->quota;
+    st->fails = u->fails;
+    __set_PRIMASK(primask);
+}
+
+void PDM_Pool_Print(void)
+{
+    PDM_Log_Printf("pool %u x %u bytes, free %u (min %u)\r\n", (unsigned)PDM_CFG_POOL_BLOCKS,
+                   (unsigned)PDM_POOL_BLOCK_SIZE, g_nfree, g_nfree_min);
+    for (uint8_t i = 0; i < PDM_POOL_USERS; i++)
+    {
+        pdm_pool_stat_t st;
+
+        PDM_Pool_GetStat(i, &st);
+        PDM_Log_Printf("pool %-7s used %u peak %u reserve %u quota %u fails %lu\r\n", g_name[i], st.used, st.peak,
+                       st.reserve, st.quota, (unsigned long)st.fails);
+    }
+}
@@ -0,0 +1,77 @@
+#include "pdm_prof.h"
+
+#if PDM_CFG_PROFILE
+
+#include "pdm_log.h"
+#include <string.h>
+
+#define PDM_PROF_NAME(id, name) name,
+static const char *const g_prof_names[PDM_PROF_COUNT] = {
+    PDM_PROF_LIST(PDM_PROF_NAME)
+};
+#undef PDM_PROF_NAME
+
+static pdm_prof_stat_t g_prof[PDM_PROF_COUNT];
+
+void PDM_Prof_Init(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    PDM_Prof_Reset();
+}
+
+void PDM_Prof_Reset(void)
+{
+    memset(g_prof, 0, sizeof(g_prof));
+    for (uint8_t i = 0; i < PDM_PROF_COUNT; i++)
+    {
+        g_prof[i].min = UINT32_MAX;
+    }
+}
+
+void PDM_Prof_Record(pdm_prof_id_t id, uint32_t cycles)
+{
+    pdm_prof_stat_t *p = &g_prof[id];
+
+    p->count++;
+    p->sum += cycles;
+    if (cycles < p->min)
+    {
+        p->min = cycles;
+    }
+    if (cycles > p->max)
+    {
+        p->max = cycles;
+    }
+}
+
+const pdm_prof_stat_t *PDM_Prof_Get(pdm_prof_id_t id)
+{
+    return &g_prof[id];
+}
+
+const char *PDM_Prof_Name(pdm_prof_id_t id)
+{
+    return g_prof_names[id];
+}
+
+void PDM_Prof_Dump(void)
+{
+    uint32_t mhz = SystemCoreClock / 1000000u;
+
+    PDM_Log_Printf("PROF name count min max avg (cycles) | avg us\r\n");
+    for (uint8_t i = 0; i < PDM_PROF_COUNT; i++)
+    {
+        const pdm_prof_stat_t *p = &g_prof[i];
+        uint32_t avg = (p->count != 0) ? (uint32_t)(p->sum / p->count) : 0;
+
+        PDM_Log_Printf("PROF %s %lu %lu %lu %lu | %lu\r\n", g_prof_names[i],
+                       (unsigned long)p->count,
+                       (unsigned long)((p->count != 0) ? p->min : 0),
+                       (unsigned long)p->max, (unsigned long)avg,
+                       (unsigned long)(avg / mhz));
+    }
+}
+
+#endif /* PDM_CFG_PROFILE */
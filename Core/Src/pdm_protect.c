@@ -0,0 +1,136 @@
+#include "pdm_protect.h"
+
+#if PDM_CFG_PROTECT
+
+#include "pdm_blackbox.h"
+#include "pdm_calc.h"
+#include "pdm_can.h"
+#include "pdm_evlog.h"
+#include "pdm_log.h"
+#include "pdm_trip.h"
+#include "stm32f1xx_hal.h"
+
+typedef struct {
+    ina226_handle_t *h;
+    ina226_mask_t mask;         /* 使用的 ALERT 功能 */
+    uint16_t limit;             /* 门限寄存器值 */
+    uint8_t type;               /* 故障类型 */
+    volatile uint8_t active;    /* 0: 暂停或未设置 */
+    uint16_t reported;          /* 主循环已打印的次数 */
+} prot_ch_t;
+
+static prot_ch_t g_prot[2];
+static pdm_protect_stat_t g_prot_stat[2];
+
+/* --- 写入一路门限和 ALERT 功能 --- */
+static uint8_t prot_apply(prot_ch_t *p)
+{
+    if (p->h == NULL || p->h->inited != 1) return 1;
+    if (ina226_set_alert_limit(p->h, p->limit) != 0) return 1;
+    if (ina226_set_alert_latch(p->h, INA226_BOOL_TRUE) != 0) return 1;
+    return ina226_set_mask(p->h, p->mask, INA226_BOOL_TRUE);
+}
+
+void PDM_Protect_Init(ina226_handle_t *h_bus, const pdm_scale_t *bus_scale, ina226_handle_t *h_bat)
+{
+    g_prot[0].h = h_bus;
+    g_prot[0].mask = INA226_MASK_POWER_OVER_LIMIT;
+    g_prot[0].limit = pdm_calc_sat_u16(pdm_calc_power_raw_from_mW(PDM_CFG_PROT_BUS_POWER_MW, bus_scale));
+    g_prot[0].type = PDM_PROT_BUS_OVER_POWER;
+
+    g_prot[1].h = h_bat;
+    g_prot[1].mask = INA226_MASK_BUS_VOLTAGE_UNDER_VOLTAGE;
+    g_prot[1].limit = pdm_calc_sat_u16(pdm_calc_bus_raw_from_mV(PDM_CFG_PROT_BAT_UV_MV));
+    g_prot[1].type = PDM_PROT_BAT_UNDER_VOLT;
+
+    for (uint8_t ch = 0; ch < 2; ch++)
+    {
+        if (PDM_Protect_Resume(ch) != 0)
+        {
+            PDM_Log_Printf("protect #%u init FAIL\r\n", ch + 1u);
+        }
+    }
+}
+
+uint8_t PDM_Protect_Suspend(uint8_t ch)
+{
+    if (ch >= 2)
+    {
+        return 1;
+    }
+    g_prot[ch].active = 0;
+
+    /* 同时选中多个 ALERT 功能时芯片只用最高位的一个，先关掉本功能 */
+    if (g_prot[ch].h == NULL || g_prot[ch].h->inited != 1)
+    {
+        return 1;
+    }
+    return ina226_set_mask(g_prot[ch].h, g_prot[ch].mask, INA226_BOOL_FALSE);
+}
+
+uint8_t PDM_Protect_Resume(uint8_t ch)
+{
+    if (ch >= 2 || prot_apply(&g_prot[ch]) != 0)
+    {
+        return 1;
+    }
+    g_prot[ch].active = 1;
+    return 0;
+}
+
+void PDM_Protect_OnAlert(uint8_t ch)
+{
+    uint8_t data[8];
+    uint32_t now;
+
+    if (ch >= 2 || !g_prot[ch].active)
+    {
+        return;
+    }
+#if PDM_CFG_TRIP
+    PDM_Trip_OnAlert(ch, g_prot[ch].type);      /* 先切断输出，再发故障帧 */
+#endif
+
+    now = HAL_GetTick();
+    g_prot_stat[ch].count++;
+    g_prot_stat[ch].last_tick = now;
+
+    data[0] = ch;
+    data[1] = g_prot[ch].type;
+    data[2] = (uint8_t)(g_prot_stat[ch].count >> 8);
+    data[3] = (uint8_t)(g_prot_stat[ch].count & 0xFF);
+    data[4] = (uint8_t)(now >> 24);
+    data[5] = (uint8_t)(now >> 16);
+    data[6] = (uint8_t)(now >> 8);
+    data[7] = (uint8_t)(now & 0xFF);
+    (void)PDM_Can_SendFromIsr(PDM_PROT_FAULT_ID, data, sizeof(data));
+#if PDM_CFG_BLACKBOX
+    PDM_Blackbox_Freeze(PDM_BB_REASON_FAULT);
+#endif
+#if PDM_CFG_EVLOG
+    PDM_Evlog_Add(PDM_EV_ALERT, ch, g_prot[ch].type, g_prot_stat[ch].count);
+#endif
+}
+
+void PDM_Protect_Run(void)
+{
+    static const char *const names[] = { "BUS over power", "BAT under voltage" };
+
+    for (uint8_t ch = 0; ch < 2; ch++)
+    {
+        uint16_t count = g_prot_stat[ch].count;
+
+        if (count != g_prot[ch].reported)
+        {
+            g_prot[ch].reported = count;
+            PDM_Log_Printf("FAULT %s (%u)\r\n", names[ch], count);
+        }
+    }
+}
+
+const pdm_protect_stat_t *PDM_Protect_GetStat(uint8_t ch)
+{
+    return (ch < 2) ? &g_prot_stat[ch] : NULL;
+}
+
+#endif /* PDM_CFG_PROTECT */
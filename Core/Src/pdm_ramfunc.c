@@ -0,0 +1,34 @@
+#include "pdm_ramfunc.h"
+
+#if PDM_CFG_RAM_VECTORS
+
+#include "stm32f1xx_hal.h"
+
+/* 16 个系统异常 + 外设中断（中密度 F103 到 USBWakeUp_IRQn），VTOR 要求按表长向上取 2 的幂对齐 */
+#define RAM_VECTORS     (16u + (uint32_t)USBWakeUp_IRQn + 1u)
+
+_Static_assert(RAM_VECTORS <= 64u, "vector table larger than the 256-byte alignment");
+
+static uint32_t g_ram_vectors[RAM_VECTORS] __attribute__((aligned(256)));
+
+void PDM_RamVectors_Init(void)
+{
+    const uint32_t *src = (const uint32_t *)SCB->VTOR;
+
+    for (uint32_t i = 0; i < RAM_VECTORS; i++)
+    {
+        g_ram_vectors[i] = src[i];
+    }
+    __DSB();
+    SCB->VTOR = (uint32_t)g_ram_vectors;
+    __DSB();
+    __ISB();
+}
+
+void PDM_RamVectors_Set(int32_t irqn, void (*handler)(void))
+{
+    g_ram_vectors[16 + irqn] = (uint32_t)handler;
+    __DSB();
+}
+
+#endif /* PDM_CFG_RAM_VECTORS */
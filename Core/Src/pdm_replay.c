@@ -0,0 +1,305 @@
+#include "pdm_replay.h"
+
+#if PDM_CFG_REPLAY
+
+#include "ina226_async.h"
+#include "pdm_calc.h"
+#include "pdm_log.h"
+#include "stm32f1xx_hal.h"
+#include <string.h>
+
+#if PDM_CFG_REPLAY_FIFO < 2 || PDM_CFG_REPLAY_FIFO > 255
+#error "PDM_CFG_REPLAY_FIFO must be 2..255"
+#endif
+
+#define REG_DIE             0xFF
+#define DIE_ID              0x2260u
+#define CONF_DEFAULT        0x4127u     /* 上电默认：平均 1 次，1.1 ms，分流和总线连续转换 */
+#define CONF_RESET_BIT      0x8000u
+#define MASK_SET_BITS       0xFC03u     /* 可写的功能选择、极性和锁存位 */
+#define MASK_CVRF           0x0008u
+
+typedef struct {
+    int16_t shunt;
+    uint16_t bus;
+    uint16_t dt;                        /* 100 us */
+} replay_rec_t;
+
+typedef struct {
+    uint8_t addr;                       /* 0: 未绑定 */
+    uint16_t conf;
+    uint16_t cal;
+    uint16_t mask;
+    uint16_t alert;
+    int16_t shunt;
+    uint16_t bus;
+    int16_t current;
+    uint16_t power;
+    uint32_t dt_us;                     /* 最近一次转换取出的记录的间隔，没有新记录时为 0 */
+    replay_rec_t q[PDM_CFG_REPLAY_FIFO];
+    volatile uint8_t head;              /* CAN 接收写入位置 */
+    volatile uint8_t tail;              /* 下一次转换取出的位置 */
+    uint8_t peak;                       /* 队列中最多的记录数 */
+} vchip_t;
+
+typedef struct {
+    uint32_t rx;                        /* 收到的记录帧 */
+    uint32_t lost;                      /* 序号不连续 */
+    uint32_t overflow;                  /* 队列满时丢弃 */
+    uint32_t bad;                       /* 长度或通道号错误 */
+    uint32_t served;                    /* 取出的记录 */
+    uint32_t stale;                     /* 读 MASK 时没有新记录 */
+    uint32_t first_ms;                  /* 第一条和最近一条记录取出的时间 */
+    uint32_t last_ms;
+} replay_stat_t;
+
+static vchip_t g_chip[PDM_CFG_CHANNELS];
+static replay_stat_t g_stat;
+static uint8_t g_seq;
+static uint8_t g_have_seq;
+
+static vchip_t *chip_find(uint8_t addr)
+{
+    for (uint8_t i = 0; i < PDM_CFG_CHANNELS; i++)
+    {
+        if (g_chip[i].addr == addr && addr != 0)
+        {
+            return &g_chip[i];
+        }
+    }
+    return NULL;
+}
+
+static uint8_t queue_used(const vchip_t *c)
+{
+    return (uint8_t)((c->head + PDM_CFG_REPLAY_FIFO - c->tail) % PDM_CFG_REPLAY_FIFO);
+}
+
+/* --- 上电或 CONF 复位位：寄存器恢复默认值，数据寄存器在第一次转换前为 0 --- */
+static void chip_reset(vchip_t *c)
+{
+    c->conf = CONF_DEFAULT;
+    c->cal = 0;
+    c->mask = 0;
+    c->alert = 0;
+    c->shunt = 0;
+    c->bus = 0;
+    c->current = 0;
+    c->power = 0;
+    c->dt_us = 0;
+}
+
+/* --- 读 MASK：取出一条记录，按器件的方法算出电流和功率 --- */
+static uint16_t chip_convert(vchip_t *c)
+{
+    const replay_rec_t *r;
+    int32_t i;
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();                    /* 阻塞读取时不在关中断中调用 */
+    if (c->tail == c->head)
+    {
+        c->dt_us = 0;
+        g_stat.stale++;
+        __set_PRIMASK(primask);
+        return c->mask;
+    }
+    r = &c->q[c->tail];
+    c->shunt = r->shunt;
+    c->bus = r->bus;
+    c->dt_us = (uint32_t)r->dt * PDM_REPLAY_DT_US;
+    c->tail = (uint8_t)((c->tail + 1u) % PDM_CFG_REPLAY_FIFO);
+
+    i = pdm_calc_sat_i16(((int32_t)c->shunt * (int32_t)c->cal) / 2048);
+    c->current = (int16_t)i;
+    c->power = pdm_calc_sat_u16((uint32_t)((i < 0) ? -i : i) * c->bus / 20000u);
+
+    g_stat.last_ms = HAL_GetTick();
+    if (g_stat.served++ == 0)
+    {
+        g_stat.first_ms = g_stat.last_ms;
+    }
+    __set_PRIMASK(primask);
+    return (uint16_t)(c->mask | MASK_CVRF);
+}
+
+void PDM_Replay_Bind(uint8_t ch, uint8_t addr)
+{
+    if (ch < PDM_CFG_CHANNELS && g_chip[ch].addr != addr)
+    {
+        g_chip[ch].addr = addr;         /* 重新初始化通道时地址不变，寄存器保留 */
+        chip_reset(&g_chip[ch]);
+    }
+}
+
+uint8_t PDM_Replay_Read(uint8_t addr, uint8_t reg, uint8_t *buf, uint16_t len)
+{
+    vchip_t *c = chip_find(addr);
+    uint16_t v;
+
+    if (c == NULL || len != 2)
+    {
+        return 1;
+    }
+    switch (reg)
+    {
+        case INA226_REG_CONF:           v = c->conf; break;
+        case INA226_REG_SHUNT_VOLTAGE:  v = (uint16_t)c->shunt; break;
+        case INA226_REG_BUS_VOLTAGE:    v = c->bus; break;
+        case INA226_REG_POWER:          v = c->power; break;
+        case INA226_REG_CURRENT:        v = (uint16_t)c->current; break;
+        case INA226_REG_CALIBRATION:    v = c->cal; break;
+        case INA226_REG_MASK:           v = chip_convert(c); break;
+        case INA226_REG_ALERT_LIMIT:    v = c->alert; break;
+        case INA226_REG_MANUFACTURER:   v = INA226_MANUFACTURER_ID; break;
+        case REG_DIE:                   v = DIE_ID; break;
+        default:                        return 1;
+    }
+    buf[0] = (uint8_t)(v >> 8);
+    buf[1] = (uint8_t)v;
+    return 0;
+}
+
+uint8_t PDM_Replay_Write(uint8_t addr, uint8_t reg, const uint8_t *buf, uint16_t len)
+{
+    vchip_t *c = chip_find(addr);
+    uint16_t v;
+
+    if (c == NULL || len != 2)
+    {
+        return 1;
+    }
+    v = (uint16_t)((uint16_t)buf[0] << 8 | buf[1]);
+    switch (reg)
+    {
+        case INA226_REG_CONF:
+            if ((v & CONF_RESET_BIT) != 0)
+            {
+                chip_reset(c);
+            }
+            else
+            {
+                c->conf = v;
+            }
+            break;
+        case INA226_REG_CALIBRATION:    c->cal = (uint16_t)(v & 0x7FFFu); break;
+        case INA226_REG_MASK:           c->mask = (uint16_t)(v & MASK_SET_BITS); break;
+        case INA226_REG_ALERT_LIMIT:    c->alert = v; break;
+        default:                        return 1;       /* 只读寄存器 */
+    }
+    return 0;
+}
+
+uint32_t PDM_Replay_Dt(uint8_t ch)
+{
+    return (ch < PDM_CFG_CHANNELS) ? g_chip[ch].dt_us : 0;
+}
+
+void PDM_Replay_Rx(const uint8_t *data, uint8_t len)
+{
+    uint8_t ch = (uint8_t)(data[0] & 0x0Fu);
+    uint8_t seq = data[7];
+    vchip_t *c;
+    uint8_t next;
+    uint8_t used;
+    uint32_t primask;
+
+    if (len != 8 || ch >= PDM_CFG_CHANNELS || g_chip[ch].addr == 0)
+    {
+        g_stat.bad++;
+        return;
+    }
+    c = &g_chip[ch];
+
+    /* 转换在采集中进行（主循环或采集任务，关中断），队列的清空和写入同样关中断 */
+    primask = __get_PRIMASK();
+    __disable_irq();
+    if ((data[0] & PDM_REPLAY_START) != 0)
+    {
+        for (uint8_t i = 0; i < PDM_CFG_CHANNELS; i++)
+        {
+            g_chip[i].head = g_chip[i].tail = 0;
+            g_chip[i].peak = 0;
+        }
+        memset(&g_stat, 0, sizeof(g_stat));
+        g_have_seq = 0;
+    }
+    next = (uint8_t)((c->head + 1u) % PDM_CFG_REPLAY_FIFO);
+    if (next == c->tail)
+    {
+        g_stat.overflow++;
+    }
+    else
+    {
+        replay_rec_t *r = &c->q[c->head];
+
+        r->shunt = (int16_t)((uint16_t)data[1] << 8 | data[2]);
+        r->bus = (uint16_t)((uint16_t)data[3] << 8 | data[4]);
+        r->dt = (uint16_t)((uint16_t)data[5] << 8 | data[6]);
+        c->head = next;
+        used = queue_used(c);
+        if (used > c->peak)
+        {
+            c->peak = used;
+        }
+    }
+    __set_PRIMASK(primask);
+
+    if (g_have_seq && seq != g_seq)
+    {
+        g_stat.lost += (uint8_t)(seq - g_seq);
+    }
+    g_seq = (uint8_t)(seq + 1u);
+    g_have_seq = 1;
+    g_stat.rx++;
+}
+
+void PDM_Replay_Encode(uint8_t *data, const void *arg)
+{
+    uint8_t free_min = 0xFF;
+
+    (void)arg;
+    for (uint8_t i = 0; i < PDM_CFG_CHANNELS; i++)
+    {
+        if (g_chip[i].addr != 0)
+        {
+            uint8_t f = (uint8_t)(PDM_CFG_REPLAY_FIFO - 1u - queue_used(&g_chip[i]));
+
+            if (f < free_min)
+            {
+                free_min = f;
+            }
+        }
+    }
+    data[0] = free_min;
+    data[1] = (uint8_t)((g_stat.lost > 0xFFu) ? 0xFFu : g_stat.lost);
+    data[2] = (uint8_t)(pdm_calc_sat_u16(g_stat.served) >> 8);
+    data[3] = (uint8_t)pdm_calc_sat_u16(g_stat.served);
+    data[4] = (uint8_t)(pdm_calc_sat_u16(g_stat.stale) >> 8);
+    data[5] = (uint8_t)pdm_calc_sat_u16(g_stat.stale);
+    data[6] = (uint8_t)(pdm_calc_sat_u16(g_stat.overflow) >> 8);
+    data[7] = (uint8_t)pdm_calc_sat_u16(g_stat.overflow);
+}
+
+void PDM_Replay_Print(void)
+{
+    uint32_t span = g_stat.last_ms - g_stat.first_ms;
+
+    PDM_Log_Printf("replay rx %lu lost %lu overflow %lu bad %lu served %lu stale %lu rate %lu/s\r\n",
+                   (unsigned long)g_stat.rx, (unsigned long)g_stat.lost, (unsigned long)g_stat.overflow,
+                   (unsigned long)g_stat.bad, (unsigned long)g_stat.served, (unsigned long)g_stat.stale,
+                   (unsigned long)((span != 0) ? (uint64_t)(g_stat.served - 1u) * 1000u / span : 0u));
+    for (uint8_t i = 0; i < PDM_CFG_CHANNELS; i++)
+    {
+        const vchip_t *c = &g_chip[i];
+
+        if (c->addr == 0)
+        {
+            continue;
+        }
+        PDM_Log_Printf("ch%u addr 0x%02X queue %u/%u peak %u cal %u last dt %lu us\r\n", i, c->addr,
+                       queue_used(c), PDM_CFG_REPLAY_FIFO - 1u, c->peak, c->cal, (unsigned long)c->dt_us);
+    }
+}
+
+#endif /* PDM_CFG_REPLAY */
@@ -0,0 +1,211 @@
+#include "pdm_report.h"
+#include "pdm_lap.h"
+#include "pdm_log.h"
+#include "pdm_monitor.h"
+#include "pdm_node.h"
+#include "pdm_param.h"
+#include "pdm_plaus.h"
+#include "pdm_signals.h"
+#include "pdm_stats.h"
+#include "stm32f1xx_hal.h"
+#include <stdio.h>
+#include <string.h>
+
+#define CH_COUNT    PDM_CFG_CHANNELS
+
+void PDM_Report_PrintLine(void)
+{
+    PDM_Log_Begin();
+    for (uint8_t i = 0; i < CH_COUNT; i++)
+    {
+        pdm_stats_result_t st;
+        pdm_channel_t c;
+
+        if (PDM_Stats_Get(i, PDM_STATS_WIN_SLOW, &st) != 0)
+        {
+            memset(&st, 0, sizeof(st));
+        }
+        PDM_Monitor_GetChannel(i, &c);
+        PDM_Log_Str(PDM_Monitor_Config(i)->name);
+        PDM_Log_Str(": ");
+        PDM_Log_Int(c.voltage_mV);
+        PDM_Log_Str("mV ");
+        PDM_Log_Fixed(c.current_uA, 1000, 1);
+        PDM_Log_Str("mA ");
+        PDM_Log_Fixed((int32_t)c.power_uW, 1000, 1);
+        PDM_Log_Str("mW ");
+        PDM_Log_Fixed((int32_t)c.energy_uWh, 1000, 1);
+        PDM_Log_Str("mWh (1s rms ");
+        PDM_Log_Fixed(st.i_rms_uA, 1000, 1);
+        PDM_Log_Str("mA pk ");
+        PDM_Log_Fixed((int32_t)st.p_peak_uW, 1000, 1);
+        PDM_Log_Str("mW)");
+        PDM_Log_Str((i + 1u < CH_COUNT) ? " | " : "\r\n");
+    }
+    (void)PDM_Log_End();
+}
+
+#if PDM_CFG_LAP
+/* "SEG lap 3: 61234ms BUS 12.345Wh pk 15.2A | BAT ..." */
+static void print_seg(const pdm_lap_seg_t *seg)
+{
+    PDM_Log_Begin();
+    PDM_Log_Str(seg->kind == PDM_LAP_STINT ? "SEG stint " : "SEG lap ");
+    PDM_Log_Uint(seg->seq);
+    PDM_Log_Str(": ");
+    PDM_Log_Uint(seg->duration_ms);
+    PDM_Log_Str("ms");
+    for (uint8_t i = 0; i < CH_COUNT; i++)
+    {
+        PDM_Log_Str((i == 0) ? " " : " | ");
+        PDM_Log_Str(PDM_Monitor_Config(i)->name);
+        PDM_Log_Char(' ');
+        PDM_Log_Fixed((int32_t)(seg->energy_uWh[i] / 1000u), 1000, 3);
+        PDM_Log_Str("Wh pk ");
+        PDM_Log_Fixed(seg->peak_uA[i] / 1000, 1000, 1);
+        PDM_Log_Str("A");
+    }
+    PDM_Log_Str("\r\n");
+    (void)PDM_Log_End();
+}
+
+void PDM_Report_PrintLaps(void)
+{
+    pdm_lap_seg_t seg;
+
+    for (uint8_t back = PDM_CFG_LAP_RING; back-- > 0; )
+    {
+        if (PDM_Lap_Get(back, &seg) == 0)
+        {
+            print_seg(&seg);
+        }
+    }
+}
+#endif
+
+void PDM_Report_Lap(uint8_t kind)
+{
+    uint32_t now = HAL_GetTick();
+#if PDM_CFG_LAP
+    uint64_t acc[CH_COUNT];
+    int32_t peak[CH_COUNT];
+#endif
+
+    for (uint8_t i = 0; i < CH_COUNT; i++)
+    {
+        pdm_stats_result_t st;
+
+        PDM_Stats_Close(i, PDM_STATS_WIN_LAP, now);
+#if PDM_CFG_LAP
+        {
+            pdm_channel_t c;
+
+            PDM_Monitor_GetChannel(i, &c);
+            acc[i] = c.energy_acc;
+        }
+        peak[i] = 0;
+#endif
+        if (PDM_Stats_Get(i, PDM_STATS_WIN_LAP, &st) == 0)
+        {
+#if PDM_CFG_LAP
+            peak[i] = (st.i_max_uA >= -st.i_min_uA) ? st.i_max_uA : st.i_min_uA;
+#endif
+            /* "LAP %s: %lums mean %.1fmA rms %.1fmA max %.1fmA pk %.1fmW" */
+            PDM_Log_Begin();
+            PDM_Log_Str("LAP ");
+            PDM_Log_Str(PDM_Monitor_Config(i)->name);
+            PDM_Log_Str(": ");
+            PDM_Log_Uint(st.duration_ms);
+            PDM_Log_Str("ms mean ");
+            PDM_Log_Fixed(st.i_mean_uA, 1000, 1);
+            PDM_Log_Str("mA rms ");
+            PDM_Log_Fixed(st.i_rms_uA, 1000, 1);
+            PDM_Log_Str("mA max ");
+            PDM_Log_Fixed(st.i_max_uA, 1000, 1);
+            PDM_Log_Str("mA pk ");
+            PDM_Log_Fixed((int32_t)st.p_peak_uW, 1000, 1);
+            PDM_Log_Str("mW\r\n");
+            (void)PDM_Log_End();
+        }
+    }
+
+#if PDM_CFG_LAP
+    /* 结束的圈（和节）从新到旧取出 */
+    for (uint8_t n = PDM_Lap_End(kind, now, acc, peak); n-- > 0; )
+    {
+        pdm_lap_seg_t seg;
+
+        if (PDM_Lap_Get(n, &seg) == 0)
+        {
+            print_seg(&seg);
+        }
+    }
+#else
+    (void)kind;
+#endif
+}
+
+void PDM_Report_PrintSignals(void)
+{
+    for (uint8_t i = 0; i < CH_COUNT; i++)
+    {
+        char name[16];
+
+        snprintf(name, sizeof(name), "PDM_%s", PDM_Monitor_Config(i)->name);
+        PDM_Signal_PrintDbc(PDM_Node_TxId(PDM_Param_Get()->can_id[i]), name);
+    }
+}
+
+void PDM_Report_PrintStats(void)
+{
+    for (uint8_t i = 0; i < CH_COUNT; i++)
+    {
+        pdm_stats_result_t st;
+        pdm_dev_status_t dev;
+
+        PDM_Monitor_GetStatus(i, &dev);
+        PDM_Log_Begin();
+        PDM_Log_Str(PDM_Monitor_Config(i)->name);
+        if (PDM_Stats_Get(i, PDM_STATS_WIN_SLOW, &st) != 0)
+        {
+            PDM_Log_Str(": no samples\r\n");
+        }
+        else
+        {
+            PDM_Log_Str(": n ");
+            PDM_Log_Uint(st.n);
+            PDM_Log_Str(" I ");
+            PDM_Log_Fixed(st.i_min_uA, 1000, 1);
+            PDM_Log_Char('/');
+            PDM_Log_Fixed(st.i_mean_uA, 1000, 1);
+            PDM_Log_Char('/');
+            PDM_Log_Fixed(st.i_max_uA, 1000, 1);
+            PDM_Log_Str("mA std ");
+            PDM_Log_Fixed(st.i_std_uA, 1000, 1);
+            PDM_Log_Str(" rms ");
+            PDM_Log_Fixed(st.i_rms_uA, 1000, 1);
+            PDM_Log_Str("mA V ");
+            PDM_Log_Int(st.v_min_mV);
+            PDM_Log_Char('/');
+            PDM_Log_Int(st.v_mean_mV);
+            PDM_Log_Char('/');
+            PDM_Log_Int(st.v_max_mV);
+            PDM_Log_Str("mV P ");
+            PDM_Log_Fixed((int32_t)st.p_mean_uW, 1000, 1);
+            PDM_Log_Str(" pk ");
+            PDM_Log_Fixed((int32_t)st.p_peak_uW, 1000, 1);
+            PDM_Log_Str("mW err ");
+            PDM_Log_Uint(dev.errors);
+#if PDM_CFG_INA226_CHECK_MS
+            PDM_Log_Str(" restored ");
+            PDM_Log_Uint(dev.restores);
+#endif
+#if PDM_CFG_PLAUS
+            PDM_Log_Str(" plaus ");
+            PDM_Log_Uint(PDM_Plaus_Flags(i));
+#endif
+            PDM_Log_Str("\r\n");
+        }
+        (void)PDM_Log_End();
+    }
+}
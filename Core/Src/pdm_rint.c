@@ -0,0 +1,194 @@
+#include "pdm_rint.h"
+
+#if PDM_CFG_RINT
+
+#include "pdm_calc.h"
+#include "pdm_can.h"
+#include "pdm_log.h"
+#include "pdm_step.h"
+
+#if !PDM_CFG_STEP
+#error "PDM_CFG_RINT needs the load step detector (PDM_CFG_STEP)"
+#endif
+#if PDM_CFG_RINT_CH >= PDM_CFG_CHANNELS
+#error "PDM_CFG_RINT_CH must be one of the channels"
+#endif
+#if PDM_CFG_RINT_AVG_N < 1 || PDM_CFG_RINT_AVG_N > 256
+#error "PDM_CFG_RINT_AVG_N must be 1..256"
+#endif
+
+#define Q_BITS          4       /* 平均值用 uOhm x 16 */
+#define RESTART_N       8       /* 连续这么多个离群值时重新开始平均 */
+
+typedef struct {
+    int32_t avg_q4;
+    uint16_t n;                 /* 平均值中的结果数（到 65535 保持），0 没有结果 */
+    uint8_t restored;
+    uint8_t outliers;           /* 连续的离群值 */
+    uint32_t last_uohm;         /* 最近一次结果，0 没有 */
+    uint32_t used;
+    uint32_t small;             /* 电流变化太小 */
+    uint32_t slow;              /* 上升时间太长 */
+    uint32_t range;             /* 结果超出范围 */
+    uint32_t outlier;           /* 与平均值相差太大 */
+    uint32_t seen_total;        /* 已查看到的阶跃总数 */
+    uint32_t seen_us;           /* 最后处理的阶跃的开始时间 */
+    uint8_t have_seen;
+    uint32_t last_tx;
+} rint_t;
+
+static rint_t g_rint;
+
+static uint16_t field_10uohm(uint32_t uohm, uint8_t valid)
+{
+    uint32_t v = (uohm + 5u) / 10u;
+
+    return (uint16_t)(!valid ? 0xFFFFu : (v > 0xFFFEu) ? 0xFFFEu : v);
+}
+
+static uint8_t rint_valid(void)
+{
+    return (uint8_t)(g_rint.n != 0 && (g_rint.restored || g_rint.n >= PDM_CFG_RINT_VALID_N));
+}
+
+/* --- 一次阶跃的结果 --- */
+static void rint_add(const pdm_step_event_t *e)
+{
+    rint_t *r = &g_rint;
+    int32_t di = e->post_ua - e->pre_ua;
+    int32_t dv = e->post_uv - e->pre_uv;
+    int64_t uohm;
+    int32_t avg;
+
+    if (di > -(int32_t)PDM_CFG_RINT_MIN_MA * 1000 && di < (int32_t)PDM_CFG_RINT_MIN_MA * 1000)
+    {
+        r->small++;
+        return;
+    }
+    if (e->rise_us > PDM_CFG_RINT_MAX_RISE_MS * 1000u)
+    {
+        r->slow++;
+        return;
+    }
+    uohm = -(int64_t)dv * 1000000 / di;
+    if (uohm < PDM_CFG_RINT_MIN_UOHM || uohm > PDM_CFG_RINT_MAX_UOHM)
+    {
+        r->range++;
+        return;
+    }
+    r->last_uohm = (uint32_t)uohm;
+
+    avg = r->avg_q4 >> Q_BITS;
+    if (r->n >= PDM_CFG_RINT_AVG_N && (uohm - avg > avg / 2 || avg - uohm > avg / 2))
+    {
+        r->outlier++;
+        if (++r->outliers < RESTART_N)
+        {
+            return;
+        }
+        r->n = 0;                       /* 内阻确实变了，从这个结果重新开始 */
+        r->restored = 0;
+    }
+    r->outliers = 0;
+
+    if (r->n == 0)
+    {
+        r->avg_q4 = (int32_t)uohm << Q_BITS;
+    }
+    else
+    {
+        uint32_t k = (r->n < PDM_CFG_RINT_AVG_N) ? r->n + 1u : PDM_CFG_RINT_AVG_N;
+
+        r->avg_q4 += (((int32_t)uohm << Q_BITS) - r->avg_q4) / (int32_t)k;
+    }
+    if (r->n < 0xFFFFu)
+    {
+        r->n++;
+    }
+    r->used++;
+}
+
+static void rint_send(void)
+{
+    const rint_t *r = &g_rint;
+    uint16_t avg = field_10uohm((uint32_t)(r->avg_q4 >> Q_BITS), (uint8_t)(r->n != 0));
+    uint16_t last = field_10uohm(r->last_uohm, (uint8_t)(r->last_uohm != 0));
+    uint32_t rejected = r->small + r->slow + r->range + r->outlier;
+    uint8_t data[8];
+
+    data[0] = (uint8_t)(avg >> 8);
+    data[1] = (uint8_t)avg;
+    data[2] = (uint8_t)(last >> 8);
+    data[3] = (uint8_t)last;
+    data[4] = (uint8_t)(pdm_calc_sat_u16(r->used) >> 8);
+    data[5] = (uint8_t)pdm_calc_sat_u16(r->used);
+    data[6] = (uint8_t)((rejected > 0xFFu) ? 0xFFu : rejected);
+    data[7] = (uint8_t)((rint_valid() ? PDM_RINT_FLAG_VALID : 0u) | (r->restored ? PDM_RINT_FLAG_RESTORED : 0u));
+    (void)PDM_Can_Send(PDM_RINT_CAN_ID, data, sizeof(data));
+}
+
+void PDM_Rint_Restore(uint32_t avg_uohm, uint16_t n)
+{
+    if (n == 0 || avg_uohm < PDM_CFG_RINT_MIN_UOHM || avg_uohm > PDM_CFG_RINT_MAX_UOHM)
+    {
+        return;
+    }
+    g_rint.avg_q4 = (int32_t)avg_uohm << Q_BITS;
+    g_rint.n = n;
+    g_rint.restored = 1;
+}
+
+void PDM_Rint_Run(uint32_t now)
+{
+    uint32_t total = PDM_Step_Count();
+
+    if (total != g_rint.seen_total)
+    {
+        uint32_t fresh = total - g_rint.seen_total;
+        pdm_step_event_t e;
+
+        g_rint.seen_total = total;
+        if (fresh > PDM_CFG_STEP_RING)
+        {
+            fresh = PDM_CFG_STEP_RING;  /* 更早的已经被覆盖 */
+        }
+        /* 从旧到新；查看期间又有新阶跃时下标会错开，按开始时间跳过已处理的 */
+        while (fresh-- > 0)
+        {
+            if (PDM_Step_Get((uint8_t)fresh, &e) != 0 || e.ch != PDM_CFG_RINT_CH ||
+                (g_rint.have_seen && (int32_t)(e.t_us - g_rint.seen_us) <= 0))
+            {
+                continue;
+            }
+            g_rint.seen_us = e.t_us;
+            g_rint.have_seen = 1;
+            rint_add(&e);
+        }
+    }
+
+    if (PDM_CFG_RINT_PERIOD_MS != 0 && now - g_rint.last_tx >= PDM_CFG_RINT_PERIOD_MS)
+    {
+        g_rint.last_tx = now;
+        rint_send();
+    }
+}
+
+uint32_t PDM_Rint_Get(uint16_t *n)
+{
+    *n = g_rint.n;
+    return (g_rint.n != 0) ? (uint32_t)(g_rint.avg_q4 >> Q_BITS) : 0u;
+}
+
+void PDM_Rint_Print(void)
+{
+    const rint_t *r = &g_rint;
+
+    PDM_Log_Printf("rint ch%u avg %lu uOhm (n %u%s%s) last %lu uOhm\r\n", PDM_CFG_RINT_CH,
+                   (unsigned long)((r->n != 0) ? (uint32_t)(r->avg_q4 >> Q_BITS) : 0u), r->n,
+                   rint_valid() ? "" : ", not valid", r->restored ? ", restored" : "", (unsigned long)r->last_uohm);
+    PDM_Log_Printf("rint used %lu, rejected: small %lu slow %lu range %lu outlier %lu\r\n",
+                   (unsigned long)r->used, (unsigned long)r->small, (unsigned long)r->slow,
+                   (unsigned long)r->range, (unsigned long)r->outlier);
+}
+
+#endif /* PDM_CFG_RINT */
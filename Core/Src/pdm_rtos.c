@@ -0,0 +1,271 @@
+#include "pdm_rtos.h"
+
+#if PDM_CFG_RTOS
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#include "main.h"
+#include "pdm_clock.h"
+#include "pdm_irq.h"
+#include "pdm_load.h"
+#include "pdm_log.h"
+#include "pdm_ramfunc.h"
+#include "stm32f1xx_hal.h"
+
+#if !PDM_CFG_RAM_VECTORS
+#error "PDM_CFG_RTOS needs PDM_CFG_RAM_VECTORS (SVC/PendSV vectors are patched at start)"
+#endif
+
+/* 栈大小（字），用命令行 rtos 查看剩余后调整；输出日志的任务要留出 vsnprintf 的用量（几百字节） */
+#define STACK_ACQ       256
+#define STACK_COMMS     384
+#define STACK_LOG       384
+
+/* 等待通知的最长时间 (ms)：没有周期任务的组（零周期任务只靠唤醒）也定期检查一次 */
+#define CAP_ACQ         1
+#define CAP_COMMS       2
+#define CAP_LOG         10
+
+static StackType_t g_stack_acq[STACK_ACQ];
+static StackType_t g_stack_comms[STACK_COMMS];
+static StackType_t g_stack_log[STACK_LOG];
+static StackType_t g_stack_idle[configMINIMAL_STACK_SIZE];
+
+typedef struct {
+    const char *name;
+    uint8_t group;
+    UBaseType_t prio;
+    uint32_t cap_ms;
+    StackType_t *stack;
+    uint32_t depth;
+} rtos_task_t;
+
+static const rtos_task_t g_def[PDM_SCHED_GROUPS] = {
+    [PDM_SCHED_GROUP_ACQ]   = { "acq",   PDM_SCHED_GROUP_ACQ,   3, CAP_ACQ,   g_stack_acq,   STACK_ACQ },
+    [PDM_SCHED_GROUP_COMMS] = { "comms", PDM_SCHED_GROUP_COMMS, 2, CAP_COMMS, g_stack_comms, STACK_COMMS },
+    [PDM_SCHED_GROUP_LOG]   = { "log",   PDM_SCHED_GROUP_LOG,   1, CAP_LOG,   g_stack_log,   STACK_LOG },
+};
+static StaticTask_t g_tcb[PDM_SCHED_GROUPS];
+static StaticTask_t g_tcb_idle;
+static TaskHandle_t g_task[PDM_SCHED_GROUPS];
+
+static StaticSemaphore_t g_excl_buf;
+static StaticSemaphore_t g_log_buf;
+static SemaphoreHandle_t g_excl;
+static SemaphoreHandle_t g_log;
+
+static volatile uint8_t g_wake;             /* 待发的通知，EXTI4 中断中清除 */
+
+/* 上次 rtos 命令时各任务的运行时间，按任务编号存（按创建顺序：三个任务，最后是空闲任务） */
+#define MAX_STAT        (PDM_SCHED_GROUPS + 1)
+static uint32_t g_last_run[MAX_STAT];
+static uint32_t g_last_total;
+
+extern void vPortSVCHandler(void);
+extern void xPortPendSVHandler(void);
+extern void xPortSysTickHandler(void);
+
+static void task_main(void *arg)
+{
+    const rtos_task_t *d = (const rtos_task_t *)arg;
+
+    for (;;)
+    {
+        uint32_t wait;
+
+        PDM_Sched_RunGroup(d->group);
+        wait = PDM_Sched_IdleMsGroup(d->group);
+        if (wait > d->cap_ms)
+        {
+            wait = d->cap_ms;
+        }
+        if (wait != 0)
+        {
+            (void)ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wait));
+        }
+    }
+}
+
+static uint8_t in_task(void)
+{
+    return (uint8_t)(__get_IPSR() == 0 && xTaskGetSchedulerState() == taskSCHEDULER_RUNNING);
+}
+
+void PDM_Rtos_Start(void)
+{
+    g_excl = xSemaphoreCreateMutexStatic(&g_excl_buf);
+    g_log = xSemaphoreCreateMutexStatic(&g_log_buf);
+    for (uint8_t i = 0; i < PDM_SCHED_GROUPS; i++)
+    {
+        g_task[i] = xTaskCreateStatic(task_main, g_def[i].name, g_def[i].depth, (void *)&g_def[i],
+                                      g_def[i].prio, g_def[i].stack, &g_tcb[i]);
+    }
+
+    PDM_RamVectors_Set(SVCall_IRQn, vPortSVCHandler);
+    PDM_RamVectors_Set(PendSV_IRQn, xPortPendSVHandler);
+    HAL_NVIC_SetPriority(EXTI4_IRQn, PDM_IRQ_PRIO_RTOS, 0);
+    HAL_NVIC_EnableIRQ(EXTI4_IRQn);
+
+    vTaskStartScheduler();                  /* 静态分配，不会因内存不足返回 */
+    Error_Handler();
+}
+
+PDM_RAMFUNC void PDM_Rtos_Wake(uint8_t mask)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    g_wake |= mask;
+    __set_PRIMASK(primask);
+    NVIC_SetPendingIRQ(EXTI4_IRQn);
+}
+
+void EXTI4_IRQHandler(void)
+{
+    BaseType_t woken = pdFALSE;
+    uint8_t mask;
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    mask = g_wake;
+    g_wake = 0;
+    __set_PRIMASK(primask);
+
+    for (uint8_t i = 0; i < PDM_SCHED_GROUPS; i++)
+    {
+        if ((mask & (1u << i)) && g_task[i] != NULL)
+        {
+            vTaskNotifyGiveFromISR(g_task[i], &woken);
+        }
+    }
+    portYIELD_FROM_ISR(woken);
+}
+
+void PDM_Rtos_Tick(void)
+{
+    if (xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED)
+    {
+        xPortSysTickHandler();
+    }
+}
+
+void PDM_Rtos_Lock(void)
+{
+    if (in_task())
+    {
+        (void)xSemaphoreTake(g_excl, portMAX_DELAY);
+    }
+}
+
+void PDM_Rtos_Unlock(void)
+{
+    if (in_task())
+    {
+        (void)xSemaphoreGive(g_excl);
+    }
+}
+
+void PDM_Rtos_LogLock(void)
+{
+    if (in_task())
+    {
+        (void)xSemaphoreTake(g_log, portMAX_DELAY);
+    }
+}
+
+void PDM_Rtos_LogUnlock(void)
+{
+    if (in_task())
+    {
+        (void)xSemaphoreGive(g_log);
+    }
+}
+
+void PDM_Rtos_Print(void)
+{
+    TaskStatus_t st[MAX_STAT];
+    uint32_t total;
+    uint32_t window;
+    UBaseType_t n;
+
+    n = uxTaskGetSystemState(st, MAX_STAT, &total);
+    window = total - g_last_total;
+    g_last_total = total;
+    PDM_Log_Printf("rtos window %lu ms, tick %lu\r\n", (unsigned long)(window / 1000u),
+                   (unsigned long)xTaskGetTickCount());
+    for (UBaseType_t i = 0; i < n; i++)
+    {
+        UBaseType_t k = st[i].xTaskNumber - 1u;
+        uint32_t run = st[i].ulRunTimeCounter;
+        uint32_t d = 0;
+        uint32_t pm = 0;
+        uint32_t depth = (k < PDM_SCHED_GROUPS) ? g_def[k].depth : configMINIMAL_STACK_SIZE;
+
+        if (k < MAX_STAT)
+        {
+            d = run - g_last_run[k];
+            g_last_run[k] = run;
+        }
+        if (window != 0)
+        {
+            pm = (uint32_t)((uint64_t)d * 1000u / window);
+        }
+        PDM_Log_Printf("  %-6s prio %lu cpu %lu.%lu%% stack free %u/%u words\r\n", st[i].pcTaskName,
+                       (unsigned long)st[i].uxCurrentPriority, (unsigned long)(pm / 10u), (unsigned long)(pm % 10u),
+                       (unsigned)st[i].usStackHighWaterMark, (unsigned)depth);
+    }
+}
+
+/* --- 内核回调 --- */
+void vApplicationGetIdleTaskMemory(StaticTask_t **tcb, StackType_t **stack, uint32_t *depth)
+{
+    *tcb = &g_tcb_idle;
+    *stack = g_stack_idle;
+    *depth = configMINIMAL_STACK_SIZE;
+}
+
+void vApplicationIdleHook(void)
+{
+#if PDM_CFG_CLOCK_SCALE
+    uint32_t start_us = PDM_Sched_NowUs();
+    uint8_t slow;
+
+    /* 关中断休眠：唤醒的中断在恢复 72 MHz 后才执行 */
+    __disable_irq();
+#if PDM_CFG_LOAD
+    PDM_Load_IdleEnter();
+#endif
+    slow = PDM_Clock_Slow();
+    __DSB();
+    __WFI();
+    PDM_Clock_Fast();
+#if PDM_CFG_LOAD
+    PDM_Load_IdleExit();
+#endif
+    __enable_irq();
+    if (slow)
+    {
+        PDM_Clock_AddSlowUs(PDM_Sched_NowUs() - start_us);
+    }
+#elif PDM_CFG_LOAD
+    /* 关中断休眠，唤醒的中断在醒来的时间点之后才执行，计入负载 */
+    __disable_irq();
+    PDM_Load_IdleEnter();
+    __DSB();
+    __WFI();
+    PDM_Load_IdleExit();
+    __enable_irq();
+#elif PDM_CFG_IDLE_SLEEP
+    __WFI();                                /* 由 SysTick 或任一中断唤醒 */
+#endif
+}
+
+void vApplicationStackOverflowHook(TaskHandle_t task, char *name)
+{
+    (void)task;
+    (void)name;
+    Error_Handler();                        /* 关中断停住，看门狗复位 */
+}
+
+#endif /* PDM_CFG_RTOS */
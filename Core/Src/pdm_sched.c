@@ -0,0 +1,347 @@
+#include "pdm_sched.h"
+#include "pdm_config.h"
+#include "pdm_clock.h"
+#include "pdm_crash.h"
+#include "pdm_load.h"
+#include "pdm_rtos.h"
+#include "pdm_timer.h"
+#include "stm32f1xx_hal.h"
+#include <string.h>
+
+static const pdm_task_t *g_tasks;
+static uint8_t g_task_count;
+static uint32_t g_period[PDM_SCHED_MAX_TASKS];
+static pdm_task_stats_t g_stats[PDM_SCHED_MAX_TASKS];
+static uint32_t g_sleep_us;
+
+uint32_t PDM_Sched_NowUs(void)
+{
+#if PDM_TIMER_US
+    return PDM_Timer_NowUs();
+#else
+    uint32_t ms, val;
+    uint32_t load = SysTick->LOAD + 1;
+
+    /* 读 tick 和 SysTick 计数之间可能发生一次进位，读到的 tick 变化时重读 */
+    do
+    {
+        ms = HAL_GetTick();
+        val = SysTick->VAL;
+    } while (ms != HAL_GetTick());
+
+    return ms * 1000u + ((load - val) * 1000u) / load;
+#endif
+}
+
+void PDM_Sched_Init(const pdm_task_t *tasks, uint8_t count, uint32_t now)
+{
+    if (count > PDM_SCHED_MAX_TASKS)
+    {
+        count = PDM_SCHED_MAX_TASKS;
+    }
+
+    g_tasks = tasks;
+    g_task_count = count;
+    memset(g_stats, 0, sizeof(g_stats));
+#if PDM_CFG_IDLE_SLEEP
+    /* 休眠期间调试器仍可连接 */
+    DBGMCU->CR |= DBGMCU_CR_DBG_SLEEP;
+#endif
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        g_period[i] = tasks[i].period_ms;
+        g_stats[i].next_due = now + tasks[i].phase_ms + tasks[i].period_ms;
+    }
+}
+
+/* --- 到期时运行第 i 个任务 --- */
+static void run_task(uint8_t i)
+{
+    const pdm_task_t *t = &g_tasks[i];
+    pdm_task_stats_t *st = &g_stats[i];
+    uint32_t period = g_period[i];
+    uint32_t now = HAL_GetTick();
+    uint32_t start_us;
+
+    if (period != 0)
+    {
+        uint32_t late = now - st->next_due;
+
+        if ((int32_t)late < 0)
+        {
+            return;                             /* 未到期 */
+        }
+
+        if (late > st->max_late_ms)
+        {
+            st->max_late_ms = late;
+        }
+        st->sum_late_ms += late;
+
+        /* 按固定节拍推进，不随启动延迟漂移；整周期的延迟记为错过 */
+        if (late >= period)
+        {
+            st->missed += late / period;
+            st->next_due += (late / period) * period;
+        }
+        st->next_due += period;
+    }
+
+#if PDM_CFG_RTOS
+    if (t->group & PDM_SCHED_EXCL)
+    {
+        PDM_Rtos_Lock();
+    }
+#endif
+#if PDM_CFG_CRASH
+    PDM_Crash_TaskBegin(i);
+#endif
+    start_us = PDM_Sched_NowUs();
+    t->run(now);
+    st->last_run_us = PDM_Sched_NowUs() - start_us;
+    st->sum_run_us += st->last_run_us;
+#if PDM_CFG_CRASH
+    PDM_Crash_TaskEnd();
+#endif
+#if PDM_CFG_RTOS
+    if (t->group & PDM_SCHED_EXCL)
+    {
+        PDM_Rtos_Unlock();
+    }
+#endif
+    if (st->last_run_us > st->max_run_us)
+    {
+        st->max_run_us = st->last_run_us;
+    }
+    st->runs++;
+}
+
+void PDM_Sched_Run(void)
+{
+#if PDM_CFG_LOAD
+    PDM_Load_Loop();
+#endif
+    for (uint8_t i = 0; i < g_task_count; i++)
+    {
+        run_task(i);
+    }
+}
+
+void PDM_Sched_RunGroup(uint8_t group)
+{
+    for (uint8_t i = 0; i < g_task_count; i++)
+    {
+        if ((g_tasks[i].group & PDM_SCHED_GROUP_MASK) == group)
+        {
+            run_task(i);
+        }
+    }
+}
+
+/* --- group 为 0xFF 时包括所有任务 --- */
+static uint32_t idle_ms(uint8_t group)
+{
+    uint32_t now = HAL_GetTick();
+    uint32_t idle = UINT32_MAX;
+
+    for (uint8_t i = 0; i < g_task_count; i++)
+    {
+        int32_t left;
+
+        if (g_period[i] == 0 || (group != 0xFF && (g_tasks[i].group & PDM_SCHED_GROUP_MASK) != group))
+        {
+            continue;
+        }
+        left = (int32_t)(g_stats[i].next_due - now);
+        if (left <= 0)
+        {
+            return 0;
+        }
+        if ((uint32_t)left < idle)
+        {
+            idle = (uint32_t)left;
+        }
+    }
+    return idle;
+}
+
+uint32_t PDM_Sched_IdleMs(void)
+{
+    return idle_ms(0xFF);
+}
+
+uint32_t PDM_Sched_IdleMsGroup(uint8_t group)
+{
+    return idle_ms(group);
+}
+
+#if PDM_CFG_IDLE_SLEEP && PDM_CFG_IDLE_TICKLESS
+/* SysTick 从 0 开始按 count 个计数重新计时，之后恢复每 1 ms 一次 */
+static void systick_restart(uint32_t count, uint32_t per_ms)
+{
+    uint32_t spin = 64;
+
+    SysTick->LOAD = count - 1u;
+    SysTick->VAL = 0;
+    SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+    /* 计数器在下一个时钟装入 LOAD 之后才能改回正常重装值 */
+    while (SysTick->VAL == 0 && --spin != 0) { }
+    SysTick->LOAD = per_ms - 1u;
+}
+
+/* 无节拍休眠：SysTick 重装为 ms 个 tick 后到期，中间没有 SysTick 中断。
+ * 调用时中断已关闭；WFI 在关中断时也会被挂起的中断唤醒，醒来后按计数器补上 tick */
+static void sleep_tickless(uint32_t ms)
+{
+    uint32_t per_ms = SysTick->LOAD + 1u;
+    uint32_t max_ms = 0x00FFFFFFu / per_ms;
+    uint32_t left, load, done, ticks;
+
+    if (ms > max_ms)
+    {
+        ms = max_ms;
+    }
+    if ((SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) != 0)
+    {
+        return;                             /* 1 ms tick 已挂起，先去处理 */
+    }
+
+    SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
+    left = SysTick->VAL;                    /* 到下一个 1 ms 计时点还剩的计数 */
+    if (left == 0)
+    {
+        left = per_ms;
+    }
+    load = left + (ms - 1u) * per_ms;
+    SysTick->LOAD = load - 1u;
+    SysTick->VAL = 0;
+    SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+
+    __DSB();
+    __WFI();
+
+    SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
+    if ((SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) != 0)
+    {
+        /* 睡满：挂起的 SysTick 中断会再加 1，这里补 ms - 1；计数器又已按 load 重装 */
+        ticks = ms - 1u;
+        done = load - SysTick->VAL;         /* 到期后又经过的计数 */
+    }
+    else
+    {
+        /* 被其他中断提前唤醒 */
+        done = load - SysTick->VAL;
+        if (done < left)
+        {
+            ticks = 0;
+            done = per_ms - (left - done);  /* 当前 1 ms 内已经过的计数 */
+        }
+        else
+        {
+            done -= left;
+            ticks = 1u + done / per_ms;
+            done %= per_ms;
+        }
+    }
+    ticks += done / per_ms;
+    done %= per_ms;
+    uwTick += ticks;
+    systick_restart(per_ms - done, per_ms);
+}
+#endif
+
+void PDM_Sched_Idle(uint8_t allow_long)
+{
+#if PDM_CFG_IDLE_SLEEP
+    uint32_t idle_ms = PDM_Sched_IdleMs();
+    uint32_t primask, start_us, us;
+#if PDM_CFG_CLOCK_SCALE
+    uint8_t slow;
+#endif
+
+    if (idle_ms == 0)
+    {
+        return;
+    }
+    start_us = PDM_Sched_NowUs();
+    /* 关中断后再判断和休眠：此后到来的中断保持挂起，WFI 立即返回，不会睡过头 */
+    primask = __get_PRIMASK();
+    __disable_irq();
+#if PDM_CFG_LOAD
+    PDM_Load_IdleEnter();
+#endif
+#if PDM_CFG_CLOCK_SCALE
+    slow = PDM_Clock_Slow();            /* 之后 SysTick 每 ms 的计数减半，无节拍休眠按新的计数计算 */
+#endif
+#if PDM_CFG_IDLE_TICKLESS
+    if (allow_long && idle_ms > 1u)
+    {
+        sleep_tickless(idle_ms);
+    }
+    else
+#endif
+    {
+        (void)allow_long;
+        __DSB();
+        __WFI();
+    }
+#if PDM_CFG_CLOCK_SCALE
+    PDM_Clock_Fast();                   /* 唤醒的中断在恢复 72 MHz 后才执行 */
+#endif
+#if PDM_CFG_LOAD
+    PDM_Load_IdleExit();                /* 唤醒的中断从这里开始计入负载 */
+#endif
+    __set_PRIMASK(primask);
+    us = PDM_Sched_NowUs() - start_us;
+    g_sleep_us += us;
+#if PDM_CFG_CLOCK_SCALE
+    if (slow)
+    {
+        PDM_Clock_AddSlowUs(us);
+    }
+#endif
+#else
+    (void)allow_long;
+#endif
+}
+
+uint32_t PDM_Sched_SleepUs(void)
+{
+    return g_sleep_us;
+}
+
+uint8_t PDM_Sched_TaskCount(void)
+{
+    return g_task_count;
+}
+
+const pdm_task_t *PDM_Sched_GetTask(uint8_t index)
+{
+    return (index < g_task_count) ? &g_tasks[index] : NULL;
+}
+
+const pdm_task_stats_t *PDM_Sched_GetStats(uint8_t index)
+{
+    return (index < g_task_count) ? &g_stats[index] : NULL;
+}
+
+void PDM_Sched_ResetStats(void)
+{
+    for (uint8_t i = 0; i < g_task_count; i++)
+    {
+        uint32_t next_due = g_stats[i].next_due;
+
+        memset(&g_stats[i], 0, sizeof(g_stats[i]));
+        g_stats[i].next_due = next_due;
+    }
+}
+
+void PDM_Sched_SetPeriod(uint8_t index, uint32_t period_ms)
+{
+    if (index < g_task_count)
+    {
+        g_period[index] = period_ms;
+        g_stats[index].next_due = HAL_GetTick() + period_ms;
+    }
+}
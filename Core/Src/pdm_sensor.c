@@ -0,0 +1,192 @@
+#include "pdm_sensor.h"
+
+/* INA228 寄存器（手册 SBOSA20） */
+#define INA228_REG_CONFIG       0x00    /* bit15 RST，bit14 RSTACC，bit4 ADCRANGE */
+#define INA228_REG_ADC_CONFIG   0x01    /* MODE 15:12，VBUSCT 11:9，VSHCT 8:6，VTCT 5:3，AVG 2:0 */
+#define INA228_REG_SHUNT_CAL    0x02
+#define INA228_REG_VSHUNT       0x04    /* 24 位，高 20 位有效，312.5 nV/LSB（ADCRANGE=0） */
+#define INA228_REG_VBUS         0x05    /* 24 位，高 20 位有效，195.3125 uV/LSB */
+#define INA228_REG_CURRENT      0x07    /* 24 位，高 20 位有效 */
+#define INA228_REG_ENERGY       0x09    /* 40 位 */
+#define INA228_REG_CHARGE       0x0A    /* 40 位 */
+#define INA228_REG_DIAG_ALRT    0x0B
+#define INA228_REG_MANUFACTURER 0x3E
+#define INA228_REG_DEVICE_ID    0x3F    /* 15:4 = 0x228 */
+
+#define INA228_CONFIG_RST       0x8000u
+#define INA228_CONFIG_RSTACC    0x4000u
+#define INA228_MODE_CONT_ALL    0xFu    /* 总线、分流、温度连续转换 */
+#define INA228_DIAG_CNVR        0x4000u /* 转换完成时拉低 ALERT */
+#define INA228_DIAG_MATHOF      0x0200u
+#define INA228_DIAG_ALERTS      0x00FCu /* 温度/分流/总线/功率超限 */
+#define INA228_DIAG_CNVRF       0x0002u
+#define INA228_DEVICE_ID        0x228u
+#define INA228_RESET_MS         10
+
+/* INA226 MASK 中的对应位 */
+#define MASK_AFF                0x0010u
+#define MASK_CVRF               0x0008u
+#define MASK_OVF                0x0004u
+
+/* 每次采样读的寄存器；带累计值时多读最后两个 */
+static const uint8_t g_228_regs[INA226_JOB_MAX_REGS] = {
+    INA228_REG_DIAG_ALRT,
+    INA228_REG_VSHUNT,
+    INA228_REG_VBUS,
+    INA228_REG_CURRENT,
+    INA228_REG_ENERGY,
+    INA228_REG_CHARGE,
+};
+static const uint8_t g_228_lens[INA226_JOB_MAX_REGS] = { 2, 3, 3, 3, 5, 5 };
+#define INA228_SAMPLE_REGS      4
+
+static uint8_t reg_read16(uint8_t addr, uint8_t reg, uint16_t *v)
+{
+    uint8_t buf[2];
+
+    if (ina226_interface_iic_read(addr, reg, buf, 2) != 0)
+    {
+        return 1;
+    }
+    *v = (uint16_t)((uint16_t)buf[0] << 8 | buf[1]);
+    return 0;
+}
+
+static uint8_t reg_write16(uint8_t addr, uint8_t reg, uint16_t v)
+{
+    uint8_t buf[2] = { (uint8_t)(v >> 8), (uint8_t)(v & 0xFF) };
+
+    return ina226_interface_iic_write(addr, reg, buf, 2);
+}
+
+/* --- INA226 转换时间编码换成 INA228 中最接近的一档（140 us -> 150 us，1.1 ms -> 1052 us …） --- */
+static uint16_t ct_228(ina226_conversion_time_t ct)
+{
+    return (uint16_t)((ct < 7) ? ct + 1 : 7);
+}
+
+uint8_t PDM_Sensor_Ina228Init(uint8_t addr, const pdm_scale_t *sc, ina226_avg_t avg,
+                              ina226_conversion_time_t bus_ct, ina226_conversion_time_t shunt_ct,
+                              uint8_t cnvr_alert)
+{
+    /* SHUNT_CAL = 13107.2e6 x 电流 LSB x R，电流 LSB 取通道 LSB / 16 */
+    uint32_t cal = (uint32_t)(((uint64_t)sc->current_ua_per_lsb * sc->shunt_uohm * 8192u + 5000000u) / 10000000u);
+    uint16_t v;
+
+    ina226_interface_shadow_exclude(addr);
+    if (cal == 0 || cal > 0x7FFF)
+    {
+        return 1;
+    }
+    if (reg_read16(addr, INA228_REG_MANUFACTURER, &v) != 0 || v != INA226_MANUFACTURER_ID ||
+        reg_read16(addr, INA228_REG_DEVICE_ID, &v) != 0 || (v >> 4) != INA228_DEVICE_ID)
+    {
+        return 1;
+    }
+
+    if (reg_write16(addr, INA228_REG_CONFIG, INA228_CONFIG_RST) != 0)
+    {
+        return 1;
+    }
+    for (uint8_t t = 0; ; t++)
+    {
+        ina226_interface_delay_ms(1);
+        if (reg_read16(addr, INA228_REG_CONFIG, &v) == 0 && (v & INA228_CONFIG_RST) == 0)
+        {
+            break;
+        }
+        if (t >= INA228_RESET_MS)
+        {
+            return 1;
+        }
+    }
+
+    if (reg_write16(addr, INA228_REG_SHUNT_CAL, (uint16_t)cal) != 0 ||
+        reg_write16(addr, INA228_REG_DIAG_ALRT, cnvr_alert ? INA228_DIAG_CNVR : 0) != 0 ||
+        reg_write16(addr, INA228_REG_CONFIG, INA228_CONFIG_RSTACC) != 0)
+    {
+        return 1;
+    }
+    /* 最后写 ADC 配置，写入后开始转换 */
+    return reg_write16(addr, INA228_REG_ADC_CONFIG,
+                       (uint16_t)(INA228_MODE_CONT_ALL << 12 | ct_228(bus_ct) << 9 |
+                                  ct_228(shunt_ct) << 6 | ct_228(shunt_ct) << 3 | (avg & 0x07u)));
+}
+
+uint8_t PDM_Sensor_IdReg(pdm_sensor_type_t type)
+{
+    return (type == PDM_SENSOR_INA228) ? INA228_REG_MANUFACTURER : INA226_REG_MANUFACTURER;
+}
+
+uint8_t PDM_Sensor_ReadAsync(pdm_sensor_type_t type, uint8_t addr, ina226_read_job_t *job,
+                             uint8_t with_acc, ina226_interface_iic_done_t done, void *ctx)
+{
+    if (type == PDM_SENSOR_INA228)
+    {
+        return ina226_interface_read_regs_async(addr, job, g_228_regs, g_228_lens,
+                                                with_acc ? INA226_JOB_MAX_REGS : INA228_SAMPLE_REGS,
+                                                done, ctx);
+    }
+    return ina226_interface_read_channel_async(addr, job, done, ctx);
+}
+
+/* --- 24 位寄存器的高 20 位，有符号 --- */
+static int32_t get_s20(const uint8_t *p)
+{
+    uint32_t u = (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8;
+
+    return (int32_t)u >> 12;
+}
+
+static uint64_t get_u40(const uint8_t *p)
+{
+    return (uint64_t)p[0] << 32 | (uint64_t)p[1] << 24 | (uint64_t)p[2] << 16 |
+           (uint64_t)p[3] << 8 | p[4];
+}
+
+uint8_t PDM_Sensor_Decode(pdm_sensor_type_t type, const ina226_read_job_t *job,
+                          pdm_sensor_sample_t *out)
+{
+    uint16_t diag;
+    int32_t bus;
+
+    if (type != PDM_SENSOR_INA228)
+    {
+        out->has_acc = 0;
+        return ina226_interface_channel_decode(job, &out->reg);
+    }
+    if (job->failed)
+    {
+        return 1;
+    }
+
+    diag = (uint16_t)((uint16_t)job->raw[0][0] << 8 | job->raw[0][1]);
+    out->reg.mask = (uint16_t)(((diag & INA228_DIAG_CNVRF) ? MASK_CVRF : 0) |
+                               ((diag & INA228_DIAG_MATHOF) ? MASK_OVF : 0) |
+                               ((diag & INA228_DIAG_ALERTS) ? MASK_AFF : 0));
+    /* 312.5 nV -> 2.5 uV：除以 8；电流 LSB 为通道 LSB / 16：除以 16 */
+    out->reg.shunt = pdm_calc_sat_i16(get_s20(job->raw[1]) / 8);
+    out->reg.current = pdm_calc_sat_i16(get_s20(job->raw[3]) / 16);
+    /* 195.3125 uV -> 1.25 mV：乘 5/32 */
+    bus = get_s20(job->raw[2]);
+    bus = (bus < 0) ? 0 : (bus * 5 + 16) / 32;
+    out->reg.bus = (uint16_t)((bus > 0xFFFF) ? 0xFFFF : bus);
+    /* INA226 功率寄存器 = 电流寄存器 x 总线电压寄存器 / 20000，不再读 POWER */
+    {
+        int32_t i = out->reg.current;
+        uint32_t p = (uint32_t)((i < 0) ? -i : i) * out->reg.bus / 20000u;
+
+        out->reg.power = (uint16_t)((p > 0xFFFF) ? 0xFFFF : p);
+    }
+
+    out->has_acc = (uint8_t)(job->n == INA226_JOB_MAX_REGS);
+    if (out->has_acc)
+    {
+        uint64_t q = get_u40(job->raw[5]);
+
+        out->energy = get_u40(job->raw[4]);
+        out->charge = (q & 0x8000000000ULL) ? (int64_t)(q | ~PDM_SENSOR_ACC_MASK) : (int64_t)q;
+    }
+
+    return (out->reg.mask & MASK_OVF) ? 4 : 0;
+}
@@ -0,0 +1,768 @@
+#include "pdm_shell.h"
+
+#if PDM_CFG_SHELL
+
+#include "pdm_blackbox.h"
+#include "pdm_boot.h"
+#include "pdm_clock.h"
+#include "pdm_crash.h"
+#include "pdm_load.h"
+#include "pdm_bus.h"
+#include "pdm_cal.h"
+#include "pdm_can.h"
+#include "pdm_canhealth.h"
+#include "pdm_capture.h"
+#include "pdm_cmd.h"
+#include "pdm_decim.h"
+#include "pdm_diag.h"
+#include "pdm_evlog.h"
+#include "pdm_filter.h"
+#include "pdm_hist.h"
+#include "pdm_irq.h"
+#include "pdm_log.h"
+#include "pdm_mcu.h"
+#include "pdm_monitor.h"
+#include "pdm_node.h"
+#include "pdm_param.h"
+#include "pdm_ping.h"
+#include "pdm_pool.h"
+#include "pdm_prof.h"
+#include "pdm_replay.h"
+#include "pdm_report.h"
+#include "pdm_rint.h"
+#include "pdm_rtos.h"
+#include "pdm_stack.h"
+#include "pdm_startup.h"
+#include "pdm_step.h"
+#include "pdm_timesync.h"
+#include "pdm_trend.h"
+#include "pdm_trip.h"
+#include "usart.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* DMA 循环接收缓冲区；两次解析之间（20 ms）收到的字符不能超过它，手动输入或逐行发送的命令足够 */
+#define RX_BUF_SIZE     128u
+#define LINE_MAX        48u
+#define ARGS_MAX        4u
+
+static uint8_t g_rx_buf[RX_BUF_SIZE];
+static volatile uint8_t g_rx_event;         /* 中断中置位，有新字符 */
+static uint16_t g_rx_pos;                   /* 已处理到的位置 */
+static char g_line[LINE_MAX];
+static uint8_t g_line_len;
+static uint8_t g_line_over;                 /* 本行超长，丢弃到行尾 */
+
+static void rx_start(void)
+{
+    g_rx_pos = 0;
+    (void)HAL_UARTEx_ReceiveToIdle_DMA(&huart1, g_rx_buf, RX_BUF_SIZE);
+}
+
+static void reply(uint8_t res)
+{
+    switch (res)
+    {
+    case PDM_CMD_OK:
+        PDM_Log_Printf("OK\r\n");
+        break;
+    case PDM_CMD_ERR_ARG:
+        PDM_Log_Printf("ERR arg\r\n");
+        break;
+    default:
+        PDM_Log_Printf("ERR unknown\r\n");
+        break;
+    }
+}
+
+/* --- 解析数字参数，十进制或 0x 十六进制；返回 0 成功 --- */
+static uint8_t parse_u32(const char *s, uint32_t *v)
+{
+    char *end;
+
+    *v = strtoul(s, &end, 0);
+    return (end == s || *end != '\0');
+}
+
+/* --- 把文本命令转换为 CAN 命令格式交给 PDM_Cmd_Exec()，本地命令直接处理 --- */
+static uint8_t exec(uint8_t argc, char **argv)
+{
+    uint8_t cmd[7];
+    uint32_t a[ARGS_MAX];
+
+    if (strcmp(argv[0], "help") == 0)
+    {
+        PDM_Log_Printf("help stats sample <ms> can <id> <ms> [0|1] capture fast [0|1] lap [1] laps reset <mask> prof [reset] irq bus canlat [reset] time bb [freeze|clear] filter [<ch> <alpha> <median>] decim [<ch> <shift>] steps rint node signals events [n] trend hist [reset <mask>] param [<id> <value>|save|defaults|load] cal [<ch> zero|<mA>] trip [reset <mask>] mcu stack pool diag [clear] rtos sub [<name> <decim>] replay boot crash [clear] clock cpu ping [reset] startup\r\n");
+        return PDM_CMD_OK;
+    }
+    if (strcmp(argv[0], "stats") == 0)
+    {
+        PDM_Report_PrintStats();
+        return PDM_CMD_OK;
+    }
+    if (strcmp(argv[0], "prof") == 0)
+    {
+#if PDM_CFG_PROFILE
+        if (argc > 1 && strcmp(argv[1], "reset") == 0)
+        {
+            PDM_Prof_Reset();
+        }
+        else
+        {
+            PDM_Prof_Dump();
+        }
+        return PDM_CMD_OK;
+#else
+        return PDM_CMD_ERR_ARG;         /* 未编译运行时间测量 */
+#endif
+    }
+    if (strcmp(argv[0], "bus") == 0)
+    {
+#if PDM_CFG_CANH
+        PDM_CanHealth_Print();
+        return PDM_CMD_OK;
+#else
+        return PDM_CMD_ERR_ARG;
+#endif
+    }
+    if (strcmp(argv[0], "mcu") == 0)
+    {
+#if PDM_CFG_MCU
+        PDM_Mcu_Print();
+        return PDM_CMD_OK;
+#else
+        return PDM_CMD_ERR_ARG;
+#endif
+    }
+    if (strcmp(argv[0], "pool") == 0)
+    {
+        PDM_Pool_Print();
+        return PDM_CMD_OK;
+    }
+    if (strcmp(argv[0], "diag") == 0)
+    {
+        if (argc > 1 && strcmp(argv[1], "clear") == 0)
+        {
+            PDM_Diag_Clear();
+        }
+        else
+        {
+            PDM_Diag_Print();
+        }
+        return PDM_CMD_OK;
+    }
+    if (strcmp(argv[0], "sub") == 0)
+    {
+        if (argc == 1)
+        {
+            PDM_Bus_Print();
+            return PDM_CMD_OK;
+        }
+        if (argc != 3 || parse_u32(argv[2], &a[2]) != 0 || a[2] > 0xFFu)
+        {
+            return PDM_CMD_ERR_ARG;
+        }
+        return (PDM_Bus_SetDecim(PDM_Bus_Find(argv[1]), (uint8_t)a[2]) == 0) ? PDM_CMD_OK : PDM_CMD_ERR_ARG;
+    }
+    if (strcmp(argv[0], "rtos") == 0)
+    {
+#if PDM_CFG_RTOS
+        PDM_Rtos_Print();
+        return PDM_CMD_OK;
+#else
+        return PDM_CMD_ERR_ARG;
+#endif
+    }
+    if (strcmp(argv[0], "boot") == 0)
+    {
+#if PDM_CFG_BOOT
+        PDM_Log_Printf("reset into CAN bootloader\r\n");
+        PDM_Boot_Request();
+        return PDM_CMD_OK;
+#else
+        return PDM_CMD_ERR_ARG;
+#endif
+    }
+    if (strcmp(argv[0], "crash") == 0)
+    {
+#if PDM_CFG_CRASH
+        if (argc > 1)
+        {
+            if (strcmp(argv[1], "clear") != 0)
+            {
+                return PDM_CMD_ERR_ARG;
+            }
+            PDM_Crash_Clear();
+            return PDM_CMD_OK;
+        }
+        PDM_Crash_Print();
+        return PDM_CMD_OK;
+#else
+        return PDM_CMD_ERR_ARG;
+#endif
+    }
+    if (strcmp(argv[0], "cpu") == 0)
+    {
+#if PDM_CFG_LOAD
+        PDM_Load_Print();
+        return PDM_CMD_OK;
+#else
+        return PDM_CMD_ERR_ARG;
+#endif
+    }
+    if (strcmp(argv[0], "startup") == 0)
+    {
+#if PDM_CFG_STARTUP
+        PDM_Startup_Print();
+        return PDM_CMD_OK;
+#else
+        return PDM_CMD_ERR_ARG;
+#endif
+    }
+    if (strcmp(argv[0], "ping") == 0)
+    {
+#if PDM_CFG_PING
+        if (argc > 1 && strcmp(argv[1], "reset") == 0)
+        {
+            PDM_Ping_Reset();
+        }
+        else
+        {
+            PDM_Ping_Print();
+        }
+        return PDM_CMD_OK;
+#else
+        return PDM_CMD_ERR_ARG;
+#endif
+    }
+    if (strcmp(argv[0], "clock") == 0)
+    {
+#if PDM_CFG_CLOCK_SCALE
+        PDM_Clock_Print();
+        return PDM_CMD_OK;
+#else
+        return PDM_CMD_ERR_ARG;
+#endif
+    }
+    if (strcmp(argv[0], "replay") == 0)
+    {
+#if PDM_CFG_REPLAY
+        PDM_Replay_Print();
+        return PDM_CMD_OK;
+#else
+        return PDM_CMD_ERR_ARG;
+#endif
+    }
+    if (strcmp(argv[0], "stack") == 0)
+    {
+#if PDM_CFG_STACK
+        PDM_Stack_Print();
+        return PDM_CMD_OK;
+#else
+        return PDM_CMD_ERR_ARG;
+#endif
+    }
+    if (strcmp(argv[0], "canlat") == 0)
+    {
+#if PDM_CFG_CAN_LATENCY
+        if (argc > 1 && strcmp(argv[1], "reset") == 0)
+        {
+            PDM_Can_LatReset();
+        }
+        else
+        {
+            PDM_Can_LatPrint();
+        }
+        return PDM_CMD_OK;
+#else
+        return PDM_CMD_ERR_ARG;
+#endif
+    }
+    if (strcmp(argv[0], "time") == 0)
+    {
+#if PDM_CFG_TIMESYNC
+        PDM_TimeSync_Print();
+        return PDM_CMD_OK;
+#else
+        return PDM_CMD_ERR_ARG;
+#endif
+    }
+    if (strcmp(argv[0], "irq") == 0)
+    {
+#if PDM_CFG_PROFILE
+        PDM_Irq_Dump();
+        return PDM_CMD_OK;
+#else
+        return PDM_CMD_ERR_ARG;
+#endif
+    }
+
+    if (strcmp(argv[0], "bb") == 0)
+    {
+#if PDM_CFG_BLACKBOX
+        pdm_bb_status_t st;
+
+        if (argc > 1)
+        {
+            cmd[0] = PDM_CMD_BLACKBOX;
+            if (strcmp(argv[1], "freeze") == 0)
+            {
+                cmd[1] = 0;
+            }
+            else if (strcmp(argv[1], "clear") == 0)
+            {
+                cmd[1] = 1;
+            }
+            else
+            {
+                return PDM_CMD_ERR_ARG;
+            }
+            return PDM_Cmd_Exec(cmd, 2);
+        }
+        PDM_Blackbox_GetStatus(&st);
+        PDM_Log_Printf("blackbox %s reason %u, %u/%u bytes, at %lu ms\r\n",
+                       st.state == PDM_BB_FROZEN ? "frozen" : "recording", st.reason,
+                       st.used, (unsigned)PDM_CFG_BLACKBOX_BYTES, (unsigned long)st.freeze_ms);
+        return PDM_CMD_OK;
+#else
+        return PDM_CMD_ERR_ARG;
+#endif
+    }
+
+    if (strcmp(argv[0], "hist") == 0)
+    {
+#if PDM_CFG_HIST
+        uint32_t bins[PDM_HIST_BINS];
+
+        if (argc > 1)
+        {
+            if (argc != 3 || strcmp(argv[1], "reset") != 0 || parse_u32(argv[2], &a[2]) != 0 || a[2] > 0xFFu)
+            {
+                return PDM_CMD_ERR_ARG;
+            }
+            cmd[0] = PDM_CMD_RESET_HIST;
+            cmd[1] = (uint8_t)a[2];
+            return PDM_Cmd_Exec(cmd, 2);
+        }
+        /* 第一行为各档下限（电流寄存器原始值），之后每通道一行计数 */
+        PDM_Log_Begin();
+        PDM_Log_Str("hist edges");
+        for (uint8_t b = 0; b < PDM_HIST_BINS; b++)
+        {
+            PDM_Log_Char(' ');
+            PDM_Log_Uint(PDM_Hist_EdgeRaw(b));
+        }
+        PDM_Log_Str("\r\n");
+        (void)PDM_Log_End();
+        for (uint8_t i = 0; i < PDM_CFG_CHANNELS; i++)
+        {
+            PDM_Hist_Get(i, bins);
+            PDM_Log_Begin();
+            PDM_Log_Str("hist ");
+            PDM_Log_Uint(i);
+            for (uint8_t b = 0; b < PDM_HIST_BINS; b++)
+            {
+                PDM_Log_Char(' ');
+                PDM_Log_Uint(bins[b]);
+            }
+            PDM_Log_Str("\r\n");
+            (void)PDM_Log_End();
+        }
+        return PDM_CMD_OK;
+#else
+        return PDM_CMD_ERR_ARG;
+#endif
+    }
+
+    if (strcmp(argv[0], "param") == 0)
+    {
+        static const char *const ops[] = { "save", "defaults", "load" };
+
+        if (argc == 1)
+        {
+            PDM_Param_Print();
+            return PDM_CMD_OK;
+        }
+        cmd[0] = PDM_CMD_PARAM;
+        if (argc == 2)
+        {
+            for (uint8_t i = 0; i < sizeof(ops) / sizeof(ops[0]); i++)
+            {
+                if (strcmp(argv[1], ops[i]) == 0)
+                {
+                    cmd[1] = (uint8_t)(PDM_PARAM_OP_SAVE + i);
+                    return PDM_Cmd_Exec(cmd, 2);
+                }
+            }
+            return PDM_CMD_ERR_ARG;
+        }
+        if (argc != 3 || parse_u32(argv[1], &a[1]) != 0 || parse_u32(argv[2], &a[2]) != 0 || a[1] > 0xFFu)
+        {
+            return PDM_CMD_ERR_ARG;
+        }
+        cmd[1] = PDM_PARAM_OP_SET;
+        cmd[2] = (uint8_t)a[1];
+        cmd[3] = (uint8_t)(a[2] >> 24);
+        cmd[4] = (uint8_t)(a[2] >> 16);
+        cmd[5] = (uint8_t)(a[2] >> 8);
+        cmd[6] = (uint8_t)a[2];
+        return PDM_Cmd_Exec(cmd, 7);
+    }
+
+    if (strcmp(argv[0], "cal") == 0)
+    {
+#if PDM_CFG_CAL
+        if (argc == 1)
+        {
+            PDM_Cal_Print();
+            return PDM_CMD_OK;
+        }
+        if (argc != 3 || parse_u32(argv[1], &a[1]) != 0 || a[1] > 0xFFu)
+        {
+            return PDM_CMD_ERR_ARG;
+        }
+        cmd[0] = PDM_CMD_CAL;
+        cmd[1] = (uint8_t)a[1];
+        if (strcmp(argv[2], "zero") == 0)
+        {
+            cmd[2] = PDM_CAL_ZERO;
+            return PDM_Cmd_Exec(cmd, 3);
+        }
+        /* 参考电流可以是负数（充电方向），strtoul 按补码返回 */
+        if (parse_u32(argv[2], &a[2]) != 0)
+        {
+            return PDM_CMD_ERR_ARG;
+        }
+        cmd[2] = PDM_CAL_REF;
+        cmd[3] = (uint8_t)(a[2] >> 24);
+        cmd[4] = (uint8_t)(a[2] >> 16);
+        cmd[5] = (uint8_t)(a[2] >> 8);
+        cmd[6] = (uint8_t)a[2];
+        return PDM_Cmd_Exec(cmd, 7);
+#else
+        return PDM_CMD_ERR_ARG;
+#endif
+    }
+
+    if (strcmp(argv[0], "trip") == 0)
+    {
+#if PDM_CFG_TRIP
+        if (argc == 1)
+        {
+            PDM_Trip_Print();
+            return PDM_CMD_OK;
+        }
+        if (argc != 3 || strcmp(argv[1], "reset") != 0 || parse_u32(argv[2], &a[2]) != 0 || a[2] > 0xFFu)
+        {
+            return PDM_CMD_ERR_ARG;
+        }
+        cmd[0] = PDM_CMD_TRIP_RESET;
+        cmd[1] = (uint8_t)a[2];
+        return PDM_Cmd_Exec(cmd, 2);
+#else
+        return PDM_CMD_ERR_ARG;
+#endif
+    }
+
+    /* 以下命令的参数都是数字 */
+    for (uint8_t i = 1; i < argc; i++)
+    {
+        if (parse_u32(argv[i], &a[i]) != 0)
+        {
+            return PDM_CMD_ERR_ARG;
+        }
+    }
+    if (strcmp(argv[0], "reset") == 0)
+    {
+        if (argc != 2 || a[1] > 0xFFu)
+        {
+            return PDM_CMD_ERR_ARG;
+        }
+        cmd[0] = PDM_CMD_RESET_ENERGY;
+        cmd[1] = (uint8_t)a[1];
+        return PDM_Cmd_Exec(cmd, 2);
+    }
+    if (strcmp(argv[0], "sample") == 0)
+    {
+        if (argc != 2 || a[1] > 0xFFFFu)
+        {
+            return PDM_CMD_ERR_ARG;
+        }
+        cmd[0] = PDM_CMD_SET_SAMPLE;
+        cmd[1] = (uint8_t)(a[1] >> 8);
+        cmd[2] = (uint8_t)(a[1] & 0xFF);
+        return PDM_Cmd_Exec(cmd, 3);
+    }
+    if (strcmp(argv[0], "can") == 0)
+    {
+        if (argc < 3 || a[1] > 0x7FFu || a[2] > 0xFFFFu)
+        {
+            return PDM_CMD_ERR_ARG;
+        }
+        cmd[0] = PDM_CMD_SET_CAN_PERIOD;
+        cmd[1] = (uint8_t)(a[1] >> 8);
+        cmd[2] = (uint8_t)(a[1] & 0xFF);
+        cmd[3] = (uint8_t)(a[2] >> 8);
+        cmd[4] = (uint8_t)(a[2] & 0xFF);
+        cmd[5] = (uint8_t)(argc > 3 && a[3] != 0);
+        return PDM_Cmd_Exec(cmd, 6);
+    }
+    if (strcmp(argv[0], "capture") == 0)
+    {
+        cmd[0] = PDM_CMD_CAPTURE;
+        return PDM_Cmd_Exec(cmd, 1);
+    }
+    if (strcmp(argv[0], "fast") == 0)
+    {
+        if (argc == 1)
+        {
+#if PDM_CFG_CAPTURE && PDM_CFG_CAPTURE_FAST
+            PDM_Capture_PrintFast();
+            return PDM_CMD_OK;
+#else
+            return PDM_CMD_ERR_ARG;
+#endif
+        }
+        if (argc > 2 || a[1] > 1u)
+        {
+            return PDM_CMD_ERR_ARG;
+        }
+        cmd[0] = PDM_CMD_FAST;
+        cmd[1] = (uint8_t)a[1];
+        return PDM_Cmd_Exec(cmd, 2);
+    }
+    if (strcmp(argv[0], "lap") == 0)
+    {
+        if (argc > 2 || (argc == 2 && a[1] > 1u))
+        {
+            return PDM_CMD_ERR_ARG;
+        }
+        cmd[0] = PDM_CMD_LAP;
+        cmd[1] = (uint8_t)a[1];
+        return PDM_Cmd_Exec(cmd, (uint8_t)(argc > 1 ? 2 : 1));
+    }
+    if (strcmp(argv[0], "laps") == 0)
+    {
+#if PDM_CFG_LAP
+        PDM_Report_PrintLaps();
+        return PDM_CMD_OK;
+#else
+        return PDM_CMD_ERR_ARG;
+#endif
+    }
+    if (strcmp(argv[0], "signals") == 0)
+    {
+        PDM_Report_PrintSignals();
+        return PDM_CMD_OK;
+    }
+    if (strcmp(argv[0], "filter") == 0)
+    {
+#if PDM_CFG_FILTER
+        if (argc == 1)
+        {
+            for (uint8_t i = 0; i < PDM_CFG_CHANNELS; i++)
+            {
+                pdm_channel_t c;
+                uint16_t alpha;
+                uint8_t median;
+
+                PDM_Filter_Get(i, &alpha, &median);
+                PDM_Monitor_GetChannel(i, &c);
+                PDM_Log_Printf("filter %u alpha %u median %u: %ld/%ld mV %ld/%ld uA\r\n",
+                               (unsigned)i, (unsigned)alpha, (unsigned)median,
+                               (long)c.voltage_mV, (long)c.voltage_f_mV,
+                               (long)c.current_uA, (long)c.current_f_uA);
+            }
+            return PDM_CMD_OK;
+        }
+        if (argc != 4 || a[1] > 0xFFu || a[2] > 0xFFFFu)
+        {
+            return PDM_CMD_ERR_ARG;
+        }
+        cmd[0] = PDM_CMD_SET_FILTER;
+        cmd[1] = (uint8_t)a[1];
+        cmd[2] = (uint8_t)(a[2] >> 8);
+        cmd[3] = (uint8_t)(a[2] & 0xFF);
+        cmd[4] = (uint8_t)(a[3] != 0);
+        return PDM_Cmd_Exec(cmd, 5);
+#else
+        return PDM_CMD_ERR_ARG;
+#endif
+    }
+    if (strcmp(argv[0], "decim") == 0)
+    {
+#if PDM_CFG_DECIM
+        if (argc == 1)
+        {
+            PDM_Decim_Print();
+            return PDM_CMD_OK;
+        }
+        if (argc != 3 || a[1] > 0xFFu || a[2] > 0xFFu)
+        {
+            return PDM_CMD_ERR_ARG;
+        }
+        cmd[0] = PDM_CMD_SET_DECIM;
+        cmd[1] = (uint8_t)a[1];
+        cmd[2] = (uint8_t)a[2];
+        return PDM_Cmd_Exec(cmd, 3);
+#else
+        return PDM_CMD_ERR_ARG;
+#endif
+    }
+    if (strcmp(argv[0], "node") == 0)
+    {
+#if PDM_CFG_NODE
+        PDM_Node_Print();
+        return PDM_CMD_OK;
+#else
+        return PDM_CMD_ERR_ARG;
+#endif
+    }
+    if (strcmp(argv[0], "rint") == 0)
+    {
+#if PDM_CFG_RINT
+        PDM_Rint_Print();
+        return PDM_CMD_OK;
+#else
+        return PDM_CMD_ERR_ARG;
+#endif
+    }
+    if (strcmp(argv[0], "steps") == 0)
+    {
+#if PDM_CFG_STEP
+        PDM_Step_Print();
+        return PDM_CMD_OK;
+#else
+        return PDM_CMD_ERR_ARG;
+#endif
+    }
+    if (strcmp(argv[0], "events") == 0)
+    {
+#if PDM_CFG_EVLOG
+        if (argc > 2 || (argc == 2 && a[1] > 0xFFFFu))
+        {
+            return PDM_CMD_ERR_ARG;
+        }
+        PDM_Evlog_Print((uint16_t)(argc > 1 ? a[1] : 10u));
+        return PDM_CMD_OK;
+#else
+        return PDM_CMD_ERR_ARG;
+#endif
+    }
+    if (strcmp(argv[0], "trend") == 0)
+    {
+#if PDM_CFG_TREND
+        PDM_Trend_Print();
+        return PDM_CMD_OK;
+#else
+        return PDM_CMD_ERR_ARG;
+#endif
+    }
+    return PDM_CMD_ERR_UNKNOWN;
+}
+
+static void run_line(void)
+{
+    char *argv[ARGS_MAX];
+    uint8_t argc = 0;
+    char *p = g_line;
+
+    g_line[g_line_len] = '\0';
+    while (*p != '\0')
+    {
+        while (*p == ' ')
+        {
+            *p++ = '\0';
+        }
+        if (*p == '\0')
+        {
+            break;
+        }
+        if (argc == ARGS_MAX)
+        {
+            reply(PDM_CMD_ERR_ARG);
+            return;
+        }
+        argv[argc++] = p;
+        while (*p != ' ' && *p != '\0')
+        {
+            p++;
+        }
+    }
+    if (argc > 0)
+    {
+        reply(exec(argc, argv));
+    }
+}
+
+static void put_char(char c)
+{
+    if (c == '\r' || c == '\n')
+    {
+        if (g_line_over)
+        {
+            reply(PDM_CMD_ERR_ARG);
+        }
+        else if (g_line_len > 0)
+        {
+            run_line();
+        }
+        g_line_len = 0;
+        g_line_over = 0;
+    }
+    else if (g_line_len < LINE_MAX - 1u)
+    {
+        g_line[g_line_len++] = c;
+    }
+    else
+    {
+        g_line_over = 1;
+    }
+}
+
+void PDM_Shell_Init(void)
+{
+    g_line_len = 0;
+    g_line_over = 0;
+    rx_start();
+}
+
+void PDM_Shell_Poll(void)
+{
+    uint16_t pos;
+
+    /* 接收错误（溢出、噪声）时 HAL 会停止 DMA 接收，这里重新开始 */
+    if (huart1.RxState == HAL_UART_STATE_READY)
+    {
+        rx_start();
+        return;
+    }
+    if (!g_rx_event)
+    {
+        return;
+    }
+    g_rx_event = 0;
+
+    /* DMA 写到的位置直接由剩余计数得到，循环模式下不需要中断给出的长度 */
+    pos = (uint16_t)(RX_BUF_SIZE - __HAL_DMA_GET_COUNTER(&hdma_usart1_rx));
+    if (pos >= RX_BUF_SIZE)
+    {
+        pos = 0;
+    }
+    while (g_rx_pos != pos)
+    {
+        put_char((char)g_rx_buf[g_rx_pos]);
+        g_rx_pos = (uint16_t)((g_rx_pos + 1u) % RX_BUF_SIZE);
+    }
+}
+
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t size)
+{
+    (void)size;
+    if (huart == &huart1)
+    {
+        g_rx_event = 1;
+    }
+}
+
+#endif /* PDM_CFG_SHELL */
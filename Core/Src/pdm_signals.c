@@ -0,0 +1,32 @@
+#include "pdm_signals.h"
+#include "pdm_log.h"
+
+const pdm_signal_desc_t g_pdm_channel_signals[PDM_SIG_COUNT] = {
+#define SIG_DESC(n, str, src, type, pos, lsb, div, unit, inv) \
+    { str, unit, (pos), PDM_SIG_SIGNED_##type, (lsb), (uint16_t)((lsb) / (div)), (inv) },
+    PDM_CHANNEL_SIGNALS(SIG_DESC)
+#undef SIG_DESC
+};
+
+void PDM_Signal_PrintDbc(uint32_t can_id, const char *msg_name)
+{
+    PDM_Log_Printf("BO_ %lu %s: 8 PDM\r\n", (unsigned long)can_id, msg_name);
+    for (uint8_t k = 0; k < PDM_SIG_COUNT; k++)
+    {
+        const pdm_signal_desc_t *d = &g_pdm_channel_signals[k];
+        /* 失效值不计入范围：int16 为 -32768 ~ 32766，uint16 为 0 ~ 65534 */
+        long lo = d->is_signed ? -32768L * d->factor : 0L;
+        long hi = (d->is_signed ? 32766L : 65534L) * d->factor;
+
+
+        /* 大端（Motorola）信号的起始位为最高位 */
+        PDM_Log_Printf(" SG_ %s_%s : %u|16@0%c (%u,0) [%ld|%ld] \"%s\" VCU\r\n", msg_name, d->name,
+                       d->pos * 8u + 7u, d->is_signed ? '-' : '+', d->factor, lo, hi, d->unit);
+    }
+    for (uint8_t k = 0; k < PDM_SIG_COUNT; k++)
+    {
+        const pdm_signal_desc_t *d = &g_pdm_channel_signals[k];
+
+        PDM_Log_Printf("VAL_ %lu %s_%s %u \"invalid\" ;\r\n", (unsigned long)can_id, msg_name, d->name, d->invalid);
+    }
+}
@@ -0,0 +1,223 @@
+#include "pdm_soc.h"
+
+#if PDM_CFG_SOC
+
+/* 内部单位 uA x us，1 mAs = 1e9，1 mAh = 3.6e12 */
+#define UAUS_PER_MAS        1000000000LL
+#define UAUS_PER_MAH        3600000000000LL
+#define CAPACITY_UAUS       ((int64_t)PDM_CFG_BAT_CAPACITY_MAH * UAUS_PER_MAH)
+#define PERMILLE_UAUS       (CAPACITY_UAUS / 1000)      /* 0.1% 容量，乘 1000 会超出 int64 */
+
+/* 静置计时的上限 (us)，大于 PDM_CFG_SOC_REST_S 即可，避免 32 位回绕 */
+#define REST_US_MAX         4000000000u
+
+#if PDM_CFG_SOC_REST_S >= 4000
+#error "PDM_CFG_SOC_REST_S must be below 4000 s"
+#endif
+
+/* 剩余时间用的平均电流时间常数 (ms) */
+#define AVG_TAU_MS          60000
+
+/* 放电电流低于该值 (uA) 时不计算剩余时间 */
+#define AVG_MIN_UA          10000
+
+/* 磷酸铁锂单体开路电压表（25 °C 静置，典型值），SoC 单位 0.1% */
+typedef struct {
+    uint16_t permille;
+    uint16_t mV;
+} ocv_point_t;
+
+static const ocv_point_t g_ocv[] = {
+    {    0, 2900 }, {   50, 3150 }, {  100, 3200 }, {  200, 3250 },
+    {  300, 3270 }, {  400, 3290 }, {  500, 3300 }, {  600, 3310 },
+    {  700, 3320 }, {  800, 3330 }, {  900, 3340 }, {  950, 3350 },
+    { 1000, 3400 },
+};
+
+#define OCV_POINTS          (sizeof(g_ocv) / sizeof(g_ocv[0]))
+/* 曲线斜率不低于 3 mV / 1% 的区间才用来修正 */
+#define OCV_MIN_MV_PER_PCT  3
+
+static int64_t g_charge;            /* 剩余电量 (uA x us) */
+static int32_t g_avg_uA;            /* 平均电流，放电为正 */
+static int32_t g_cell_mV;
+static uint32_t g_rest_us;          /* 已静置时间，不超过 REST_US_MAX */
+static uint8_t g_rest_done;         /* 本次静置已修正过 */
+static uint8_t g_flags;
+static uint8_t g_ready;
+
+/* flash 中保存的剩余电量，在第一个电池侧采样时使用 */
+static uint8_t g_restored;
+static int32_t g_restored_mAs;
+
+/* --- 查表：返回 SoC (0.1%)，*steep 表示所在区间足够陡，可以用来修正 --- */
+static uint16_t ocv_lookup(int32_t cell_mV, uint8_t *steep)
+{
+    *steep = 1;
+    if (cell_mV <= g_ocv[0].mV)
+    {
+        return 0;
+    }
+    for (uint8_t i = 0; i + 1u < OCV_POINTS; i++)
+    {
+        const ocv_point_t *a = &g_ocv[i];
+        const ocv_point_t *b = &g_ocv[i + 1u];
+
+        if (cell_mV < b->mV)
+        {
+            int32_t dmv = b->mV - a->mV;
+            int32_t dp = b->permille - a->permille;
+
+            *steep = (uint8_t)(dmv * 10 >= OCV_MIN_MV_PER_PCT * dp);
+            return (uint16_t)(a->permille + (cell_mV - a->mV) * dp / dmv);
+        }
+    }
+    return 1000;
+}
+
+static void set_charge(int64_t c)
+{
+    if (c < 0) c = 0;
+    if (c > CAPACITY_UAUS) c = CAPACITY_UAUS;
+    g_charge = c;
+}
+
+void PDM_Soc_Init(uint8_t restored, int32_t charge_mAs, int32_t bat_mV)
+{
+    uint8_t steep;
+
+    g_cell_mV = bat_mV / PDM_CFG_BAT_CELLS;
+    g_avg_uA = 0;
+    g_rest_us = 0;
+    g_rest_done = 0;
+    g_flags = 0;
+    g_ready = 1;
+
+    if (restored)
+    {
+        set_charge((int64_t)charge_mAs * UAUS_PER_MAS);
+    }
+    else
+    {
+        /* 没有保存的计数：平坦区间也只能先用查表结果 */
+        set_charge(PERMILLE_UAUS * ocv_lookup(g_cell_mV, &steep));
+        g_flags |= PDM_SOC_FLAG_FROM_OCV;
+    }
+}
+
+void PDM_Soc_Add(int32_t current_uA, uint32_t dt_us, int32_t bat_mV)
+{
+    uint8_t steep;
+    uint32_t dt_ms = dt_us / 1000u;
+    uint32_t tau_dt = (dt_ms < AVG_TAU_MS) ? dt_ms : AVG_TAU_MS;
+
+    if (!g_ready)
+    {
+        return;
+    }
+    set_charge(g_charge - (int64_t)current_uA * dt_us);
+    g_avg_uA += (int32_t)((int64_t)(current_uA - g_avg_uA) * tau_dt / AVG_TAU_MS);
+    g_cell_mV = bat_mV / PDM_CFG_BAT_CELLS;
+
+    if (current_uA < PDM_CFG_SOC_REST_MA * 1000 && current_uA > -PDM_CFG_SOC_REST_MA * 1000)
+    {
+        g_rest_us = (g_rest_us > REST_US_MAX - dt_us) ? REST_US_MAX : g_rest_us + dt_us;
+        g_flags |= PDM_SOC_FLAG_REST;
+    }
+    else
+    {
+        g_rest_us = 0;
+        g_rest_done = 0;
+        g_flags &= (uint8_t)~PDM_SOC_FLAG_REST;
+    }
+
+    if (!g_rest_done && g_rest_us >= PDM_CFG_SOC_REST_S * 1000000u)
+    {
+        uint16_t soc = ocv_lookup(g_cell_mV, &steep);
+
+        g_rest_done = 1;
+        if (steep)
+        {
+            set_charge(PERMILLE_UAUS * soc);
+            g_flags |= PDM_SOC_FLAG_CORRECTED;
+        }
+    }
+}
+
+void PDM_Soc_Restore(int32_t charge_mAs)
+{
+    g_restored = 1;
+    g_restored_mAs = charge_mAs;
+}
+
+void PDM_Soc_Sample(int32_t current_uA, uint32_t dt_us, int32_t bat_mV)
+{
+    if (!g_ready)
+    {
+        PDM_Soc_Init(g_restored, g_restored_mAs, bat_mV);
+    }
+    else if (dt_us != 0)
+    {
+        PDM_Soc_Add(current_uA, dt_us, bat_mV);
+    }
+}
+
+uint8_t PDM_Soc_Saved(int32_t *charge_mAs)
+{
+    if (g_ready)
+    {
+        *charge_mAs = PDM_Soc_ChargeMAs();
+        return 1;
+    }
+    *charge_mAs = g_restored_mAs;   /* 还没有采样，保留上次的值 */
+    return g_restored;
+}
+
+uint8_t PDM_Soc_Ready(void)
+{
+    return g_ready;
+}
+
+int32_t PDM_Soc_ChargeMAs(void)
+{
+    return (int32_t)(g_charge / UAUS_PER_MAS);
+}
+
+uint16_t PDM_Soc_Permille(void)
+{
+    return (uint16_t)(g_charge / PERMILLE_UAUS);
+}
+
+void PDM_Soc_Encode(uint8_t *data, const void *arg)
+{
+    uint16_t soc = PDM_Soc_Permille();
+    uint32_t mah = (uint32_t)(g_charge / UAUS_PER_MAH);
+    uint32_t minutes = 0xFFFF;
+    int32_t cell = (g_cell_mV - 2000) / 10;
+
+    (void)arg;
+    if (!g_ready)
+    {
+        soc = 0xFFFF;
+        mah = 0xFFFF;
+    }
+    else if (g_avg_uA > AVG_MIN_UA)
+    {
+        minutes = (uint32_t)(g_charge / g_avg_uA / 60000000);
+        if (minutes > 0xFFFE) minutes = 0xFFFE;
+    }
+    if (mah > 0xFFFF) mah = 0xFFFF;
+    if (cell < 0) cell = 0;
+    if (cell > 255) cell = 255;
+
+    data[0] = (uint8_t)(soc >> 8);
+    data[1] = (uint8_t)(soc & 0xFF);
+    data[2] = (uint8_t)(mah >> 8);
+    data[3] = (uint8_t)(mah & 0xFF);
+    data[4] = (uint8_t)(minutes >> 8);
+    data[5] = (uint8_t)(minutes & 0xFF);
+    data[6] = g_flags;
+    data[7] = (uint8_t)cell;
+}
+
+#endif /* PDM_CFG_SOC */
@@ -0,0 +1,124 @@
+#include "pdm_stack.h"
+
+#if PDM_CFG_STACK
+
+#include "pdm_log.h"
+#include "stm32f1xx_hal.h"
+
+#define PAINT_MARGIN        64u         /* 填充时在当前栈指针以下留出的字节 */
+
+/* CubeIDE 链接脚本中的符号 */
+extern uint32_t _sdata;
+extern uint32_t _ebss;
+extern uint32_t _end;
+extern uint32_t _estack;
+extern uint32_t _Min_Heap_Size;         /* 绝对符号，取地址即为数值 */
+
+static uint32_t *g_base;                /* 栈区底部 */
+static uint32_t *g_mark;                /* 最低的被改写的字 */
+static uint8_t g_painted;
+static uint8_t g_reported;              /* 已打印的状态位 */
+
+/* 启动代码已初始化 .data/.bss，中断还没有打开；只填充当前栈指针以下的部分 */
+__attribute__((noinline)) void PDM_Stack_Paint(void)
+{
+    uint32_t lo = ((uint32_t)&_end + (uint32_t)&_Min_Heap_Size + 3u) & ~3u;
+    uint32_t hi = (__get_MSP() - PAINT_MARGIN) & ~3u;
+
+    g_base = (uint32_t *)lo;
+    g_mark = (uint32_t *)hi;
+    if (hi <= lo + PDM_STACK_GUARD)
+    {
+        return;
+    }
+    for (volatile uint32_t *p = (volatile uint32_t *)lo; p < (volatile uint32_t *)hi; p++)
+    {
+        *p = PDM_STACK_FILL;
+    }
+    g_painted = 1;
+}
+
+void PDM_Stack_Get(pdm_stack_t *out)
+{
+    const volatile uint32_t *p = g_base;
+    uint32_t free_bytes;
+
+    out->size = (uint32_t)&_estack - (uint32_t)g_base;
+    out->static_ram = (uint32_t)&_ebss - (uint32_t)&_sdata;
+    out->status = 0;
+    if (!g_painted)
+    {
+        out->peak = 0;
+        out->status = PDM_STACK_UNPAINTED;
+        return;
+    }
+    while (p < g_mark && *p == PDM_STACK_FILL)
+    {
+        p++;
+    }
+    g_mark = (uint32_t *)p;
+
+    free_bytes = (uint32_t)g_mark - (uint32_t)g_base;
+    out->peak = out->size - free_bytes;
+    if (free_bytes < PDM_CFG_STACK_WARN)
+    {
+        out->status |= PDM_STACK_LOW;
+    }
+    if (free_bytes < PDM_STACK_GUARD)
+    {
+        out->status |= PDM_STACK_OVERFLOW;
+    }
+}
+
+static void put_be16(uint8_t *p, uint32_t v)
+{
+    v = (v > 0xFFFFu) ? 0xFFFFu : v;
+    p[0] = (uint8_t)(v >> 8);
+    p[1] = (uint8_t)v;
+}
+
+void PDM_Stack_Encode(uint8_t *data, const void *arg)
+{
+    pdm_stack_t st;
+
+    (void)arg;
+    PDM_Stack_Get(&st);
+    put_be16(&data[0], st.peak);
+    put_be16(&data[2], st.size);
+    put_be16(&data[4], st.static_ram);
+    data[6] = st.status;
+    data[7] = 0;
+}
+
+void PDM_Stack_Run(void)
+{
+    pdm_stack_t st;
+    uint8_t fresh;
+
+    PDM_Stack_Get(&st);
+    fresh = (uint8_t)(st.status & ~g_reported & (PDM_STACK_LOW | PDM_STACK_OVERFLOW));
+    if (fresh == 0)
+    {
+        return;
+    }
+    g_reported |= fresh;
+    PDM_Log_Printf("STACK %s: peak %lu of %lu bytes\r\n", (fresh & PDM_STACK_OVERFLOW) ? "OVERFLOW" : "low",
+                   (unsigned long)st.peak, (unsigned long)st.size);
+}
+
+void PDM_Stack_Print(void)
+{
+    pdm_stack_t st;
+
+    PDM_Stack_Get(&st);
+    if (st.status & PDM_STACK_UNPAINTED)
+    {
+        PDM_Log_Printf("stack not painted (region %lu bytes)\r\n", (unsigned long)st.size);
+        return;
+    }
+    PDM_Log_Printf("stack peak %lu of %lu bytes, free %lu, static ram %lu bytes%s\r\n", (unsigned long)st.peak,
+                   (unsigned long)st.size, (unsigned long)(st.size - st.peak), (unsigned long)st.static_ram,
+                   (st.status & PDM_STACK_OVERFLOW) ? ", OVERFLOW" : (st.status & PDM_STACK_LOW) ? ", low" : "");
+}
+
+#endif /* PDM_CFG_STACK */
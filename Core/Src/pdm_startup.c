@@ -0,0 +1,110 @@
+#include "pdm_startup.h"
+
+#if PDM_CFG_STARTUP
+
+#include "pdm_can.h"
+#include "pdm_capture.h"
+#include "pdm_log.h"
+#include "pdm_sched.h"
+#include "pdm_timer.h"
+#include "stm32f1xx_hal.h"
+
+/* 启动时间点：HAL_Init() 起的 us 加 1，0 为还没有到 */
+static struct {
+    uint32_t base_us;           /* HAL_Init() 时的 PDM_Sched_NowUs()，定时器时间基准时不为 0 */
+    uint32_t t_us[PDM_STARTUP_POINTS];
+    uint8_t sent;
+} g_startup;
+
+void PDM_Startup_Init(void)
+{
+#if PDM_TIMER_US
+    g_startup.base_us = PDM_Sched_NowUs() - HAL_GetTick() * 1000u;
+#endif
+}
+
+void PDM_Startup_Mark(uint8_t point)
+{
+    if (point < PDM_STARTUP_POINTS && g_startup.t_us[point] == 0)
+    {
+        g_startup.t_us[point] = PDM_Sched_NowUs() - g_startup.base_us + 1u;
+    }
+}
+
+/* --- 启动时间帧的一个字段：2 字节 0.1 ms，FFFF 为没有 --- */
+static void put_ms10(uint8_t *p, uint32_t t)
+{
+    uint32_t v = (t == 0) ? 0xFFFFu : (t - 1u) / 100u;
+
+    if (v > 0xFFFFu)
+    {
+        v = 0xFFFEu;
+    }
+    p[0] = (uint8_t)(v >> 8);
+    p[1] = (uint8_t)(v & 0xFF);
+}
+
+static uint32_t startup_capture_us(void)
+{
+#if PDM_CFG_CAPTURE && PDM_CFG_CAPTURE_BOOT
+    uint32_t t = PDM_Capture_BootFirstUs();
+
+    return (t == 0) ? 0u : t + 1u;
+#else
+    return 0;
+#endif
+}
+
+void PDM_Startup_Poll(uint32_t now)
+{
+    uint8_t data[8];
+
+    if (g_startup.sent || (g_startup.t_us[PDM_STARTUP_DATA] == 0 && now < PDM_STARTUP_GIVEUP_MS))
+    {
+        return;
+    }
+    put_ms10(&data[0], startup_capture_us());
+    put_ms10(&data[2], g_startup.t_us[PDM_STARTUP_FRAME]);
+    put_ms10(&data[4], g_startup.t_us[PDM_STARTUP_SAMPLE]);
+    put_ms10(&data[6], g_startup.t_us[PDM_STARTUP_DATA]);
+    if (PDM_Can_Send(PDM_STARTUP_CAN_ID, data, sizeof(data)) == 0)
+    {
+        g_startup.sent = 1;
+        PDM_Startup_Print();
+    }
+}
+
+static void print_ms(const char *name, uint32_t t)
+{
+    PDM_Log_Char(' ');
+    PDM_Log_Str(name);
+    PDM_Log_Char(' ');
+    if (t == 0)
+    {
+        PDM_Log_Char('-');
+    }
+    else
+    {
+        PDM_Log_Fixed((int32_t)(t - 1u), 1000, 1);
+    }
+}
+
+void PDM_Startup_Print(void)
+{
+    PDM_Log_Begin();
+    PDM_Log_Str("startup ms:");
+#if PDM_CFG_CAPTURE && PDM_CFG_CAPTURE_BOOT
+    print_ms("boot capture", startup_capture_us());
+#endif
+    print_ms("first frame", g_startup.t_us[PDM_STARTUP_FRAME]);
+    print_ms("init", g_startup.t_us[PDM_STARTUP_INIT]);
+    print_ms("first sample", g_startup.t_us[PDM_STARTUP_SAMPLE]);
+    print_ms("first channel frame", g_startup.t_us[PDM_STARTUP_DATA]);
+    PDM_Log_Str("\r\n");
+    (void)PDM_Log_End();
+#if PDM_CFG_CAPTURE && PDM_CFG_CAPTURE_BOOT
+    PDM_Capture_PrintBoot();
+#endif
+}
+
+#endif /* PDM_CFG_STARTUP */
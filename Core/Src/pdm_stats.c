@@ -0,0 +1,174 @@
+#include "pdm_stats.h"
+#include <string.h>
+
+typedef struct {
+    uint32_t n;
+    uint32_t start;             /* 窗口开始时间 */
+    int16_t i_min;
+    int16_t i_max;
+    uint16_t v_min;
+    uint16_t v_max;
+    uint16_t p_peak;
+    int64_t i_sum;
+    uint64_t i_sumsq;
+    uint64_t v_sum;
+    uint64_t p_sum;
+} acc_t;
+
+typedef struct {
+    const pdm_scale_t *scale;
+    acc_t cur[PDM_STATS_WINDOWS];       /* 正在累加 */
+    acc_t done[PDM_STATS_WINDOWS];      /* 上一个已结束的窗口 */
+    uint32_t done_ms[PDM_STATS_WINDOWS];
+} ch_stats_t;
+
+/* 各窗口长度 (ms)，0 表示手动结束 */
+static const uint32_t g_win_ms[PDM_STATS_WINDOWS] = {
+    PDM_CFG_STATS_FAST_MS, PDM_CFG_STATS_SLOW_MS, 0, 0
+};
+
+static ch_stats_t g_stats[PDM_CFG_CHANNELS];
+
+static void acc_reset(acc_t *a, uint32_t now)
+{
+    memset(a, 0, sizeof(*a));
+    a->start = now;
+    a->i_min = INT16_MAX;
+    a->i_max = INT16_MIN;
+    a->v_min = UINT16_MAX;
+}
+
+/* 64 位整数平方根（逐位），只在读取结果时用 */
+static uint32_t isqrt64(uint64_t v)
+{
+    uint64_t res = 0;
+    uint64_t bit = (uint64_t)1 << 62;
+
+    while (bit > v)
+    {
+        bit >>= 2;
+    }
+    while (bit != 0)
+    {
+        if (v >= res + bit)
+        {
+            v -= res + bit;
+            res = (res >> 1) + bit;
+        }
+        else
+        {
+            res >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)res;
+}
+
+void PDM_Stats_Init(uint8_t ch, const pdm_scale_t *scale, uint32_t now)
+{
+    if (ch >= PDM_CFG_CHANNELS)
+    {
+        return;
+    }
+    g_stats[ch].scale = scale;
+    for (uint8_t w = 0; w < PDM_STATS_WINDOWS; w++)
+    {
+        acc_reset(&g_stats[ch].cur[w], now);
+        acc_reset(&g_stats[ch].done[w], now);
+        g_stats[ch].done_ms[w] = 0;
+    }
+}
+
+void PDM_Stats_Add(uint8_t ch, int16_t current, uint16_t bus, uint16_t power)
+{
+    if (ch >= PDM_CFG_CHANNELS)
+    {
+        return;
+    }
+    for (uint8_t w = 0; w < PDM_STATS_WINDOWS; w++)
+    {
+        acc_t *a = &g_stats[ch].cur[w];
+
+        a->n++;
+        if (current < a->i_min) a->i_min = current;
+        if (current > a->i_max) a->i_max = current;
+        if (bus < a->v_min) a->v_min = bus;
+        if (bus > a->v_max) a->v_max = bus;
+        if (power > a->p_peak) a->p_peak = power;
+        a->i_sum += current;
+        a->i_sumsq += (uint64_t)((int32_t)current * current);
+        a->v_sum += bus;
+        a->p_sum += power;
+    }
+}
+
+void PDM_Stats_Close(uint8_t ch, uint8_t win, uint32_t now)
+{
+    ch_stats_t *s;
+
+    if (ch >= PDM_CFG_CHANNELS || win >= PDM_STATS_WINDOWS)
+    {
+        return;
+    }
+    s = &g_stats[ch];
+    s->done[win] = s->cur[win];
+    s->done_ms[win] = now - s->cur[win].start;
+    acc_reset(&s->cur[win], now);
+}
+
+void PDM_Stats_Tick(uint32_t now)
+{
+    for (uint8_t ch = 0; ch < PDM_CFG_CHANNELS; ch++)
+    {
+        for (uint8_t w = 0; w < PDM_STATS_WINDOWS; w++)
+        {
+            if (g_win_ms[w] != 0 && now - g_stats[ch].cur[w].start >= g_win_ms[w])
+            {
+                PDM_Stats_Close(ch, w, now);
+            }
+        }
+    }
+}
+
+uint8_t PDM_Stats_Get(uint8_t ch, uint8_t win, pdm_stats_result_t *res)
+{
+    const acc_t *a;
+    const pdm_scale_t *sc;
+    int64_t mean16;
+    uint64_t msq256;
+    int64_t var256;
+
+    if (ch >= PDM_CFG_CHANNELS || win >= PDM_STATS_WINDOWS || g_stats[ch].scale == NULL)
+    {
+        return 1;
+    }
+    a = &g_stats[ch].done[win];
+    sc = g_stats[ch].scale;
+    if (a->n == 0)
+    {
+        return 1;
+    }
+
+    res->n = a->n;
+    res->duration_ms = g_stats[ch].done_ms[win];
+
+    /* 电流：均值、均方按 1/16 LSB 定点计算，平方和先除 n 再放大，避免溢出 */
+    mean16 = a->i_sum * 16 / (int64_t)a->n;
+    msq256 = ((a->i_sumsq / a->n) << 8) + (((a->i_sumsq % a->n) << 8) / a->n);
+    var256 = (int64_t)msq256 - mean16 * mean16;
+    if (var256 < 0) var256 = 0;
+
+    res->i_min_uA = pdm_calc_current_uA(a->i_min, sc);
+    res->i_max_uA = pdm_calc_current_uA(a->i_max, sc);
+    res->i_mean_uA = (int32_t)(mean16 * (int32_t)sc->current_ua_per_lsb / 16);
+    res->i_std_uA = (int32_t)((uint64_t)isqrt64((uint64_t)var256) * sc->current_ua_per_lsb / 16u);
+    res->i_rms_uA = (int32_t)((uint64_t)isqrt64(msq256) * sc->current_ua_per_lsb / 16u);
+
+    res->v_min_mV = pdm_calc_bus_mV(a->v_min);
+    res->v_max_mV = pdm_calc_bus_mV(a->v_max);
+    res->v_mean_mV = (int32_t)((a->v_sum * PDM_BUS_UV_PER_LSB / a->n + 500u) / 1000u);
+
+    res->p_mean_uW = (uint32_t)(a->p_sum * sc->power_uw_per_lsb / a->n);
+    res->p_peak_uW = pdm_calc_power_uW(a->p_peak, sc);
+    return 0;
+}
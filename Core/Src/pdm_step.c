@@ -0,0 +1,236 @@
+#include "pdm_step.h"
+
+#if PDM_CFG_STEP
+
+#include "pdm_can.h"
+#include "pdm_log.h"
+#include "pdm_param.h"
+#include "stm32f1xx_hal.h"
+
+#if PDM_CFG_STEP_FILTER > 4
+#error "PDM_CFG_STEP_FILTER must be 0..4"
+#endif
+#if PDM_CFG_STEP_RING < 1 || PDM_CFG_STEP_RING > 32
+#error "PDM_CFG_STEP_RING must be 1..32"
+#endif
+
+#define Q_BITS          4       /* 内部用寄存器值 x 16 */
+#define BASE_SHIFT      4       /* 基线的低通系数 1/16 */
+
+#define ST_START        0       /* 下一个采样初始化 */
+#define ST_WAIT         1
+#define ST_MOVING       2
+
+typedef struct {
+    const pdm_scale_t *sc;
+    int32_t thr;                /* 门限（电流寄存器 x 16），0 不检测 */
+    uint8_t state;
+    uint8_t n;                  /* 变化开始后的采样数 */
+    uint8_t same;               /* 连续变化不大的采样数 */
+    uint8_t seq;
+    int32_t fast;               /* 电流低通值和基线 */
+    int32_t base;
+    int32_t last;
+    int32_t vfast;              /* 总线电压低通值和基线 */
+    int32_t vbase;
+    int32_t pre;                /* 阶跃前的基线 */
+    int32_t vpre;
+    uint32_t t0_us;
+    uint32_t t0_ms;
+    uint32_t move_us;           /* 最后一个变化较大的采样 */
+    uint32_t count;
+} step_ch_t;
+
+static step_ch_t g_step[PDM_CFG_CHANNELS];
+static pdm_step_event_t g_ring[PDM_CFG_STEP_RING];
+static uint8_t g_ring_next;
+static uint8_t g_ring_n;
+static volatile uint32_t g_total;
+
+static int32_t abs32(int32_t v)
+{
+    return (v < 0) ? -v : v;
+}
+
+static int32_t q_to_ua(int32_t q, const pdm_scale_t *sc)
+{
+    return (int32_t)(((int64_t)q * (int64_t)sc->current_ua_per_lsb) >> Q_BITS);
+}
+
+static int32_t q_to_uv(int32_t q)
+{
+    return (int32_t)(((int64_t)q * PDM_BUS_UV_PER_LSB) >> Q_BITS);
+}
+
+static void put_be16(uint8_t *p, int32_t v)
+{
+    uint16_t u = (uint16_t)pdm_calc_sat_i16(v);
+
+    p[0] = (uint8_t)(u >> 8);
+    p[1] = (uint8_t)u;
+}
+
+/* --- 一次阶跃：记入环形缓冲区并发送事件帧 --- */
+static void step_emit(uint8_t ch, step_ch_t *s, int32_t post, int32_t vpost)
+{
+    pdm_step_event_t *e = &g_ring[g_ring_next];
+    uint8_t data[8];
+
+    e->ch = ch;
+    e->seq = s->seq++;
+    e->tick_ms = s->t0_ms;
+    e->t_us = s->t0_us;
+    e->rise_us = s->move_us - s->t0_us;
+    e->pre_ua = q_to_ua(s->pre, s->sc);
+    e->post_ua = q_to_ua(post, s->sc);
+    e->pre_uv = q_to_uv(s->vpre);
+    e->post_uv = q_to_uv(vpost);
+    g_ring_next = (uint8_t)((g_ring_next + 1u) % PDM_CFG_STEP_RING);
+    if (g_ring_n < PDM_CFG_STEP_RING)
+    {
+        g_ring_n++;
+    }
+    s->count++;
+    g_total++;
+
+    data[0] = (uint8_t)(ch << 4 | (e->seq & 0x0Fu));
+    data[1] = (uint8_t)(e->tick_ms >> 16);
+    data[2] = (uint8_t)(e->tick_ms >> 8);
+    data[3] = (uint8_t)e->tick_ms;
+    put_be16(&data[4], e->pre_ua / 10000);
+    put_be16(&data[6], e->post_ua / 10000);
+    (void)PDM_Can_Send(PDM_STEP_CAN_ID, data, sizeof(data));
+}
+
+void PDM_Step_Init(uint8_t ch, const pdm_scale_t *sc)
+{
+    uint32_t ma;
+    uint32_t primask;
+
+    if (ch >= PDM_CFG_CHANNELS)
+    {
+        return;
+    }
+    ma = PDM_Param_Get()->step_ma[ch];
+    primask = __get_PRIMASK();
+    __disable_irq();            /* 采集和主循环在 FreeRTOS 版本中是不同的任务 */
+    g_step[ch].sc = sc;
+    g_step[ch].thr = (int32_t)(((uint64_t)ma * 1000u << Q_BITS) / sc->current_ua_per_lsb);
+    g_step[ch].state = ST_START;
+    __set_PRIMASK(primask);
+}
+
+void PDM_Step_Reset(uint8_t ch)
+{
+    if (ch < PDM_CFG_CHANNELS)
+    {
+        g_step[ch].state = ST_START;
+    }
+}
+
+void PDM_Step_Add(uint8_t ch, int16_t current, uint16_t bus, uint32_t ts_us)
+{
+    step_ch_t *s;
+    int32_t d;
+
+    if (ch >= PDM_CFG_CHANNELS || g_step[ch].thr == 0)
+    {
+        return;
+    }
+    s = &g_step[ch];
+    if (s->state == ST_START)
+    {
+        s->fast = s->base = s->last = (int32_t)current << Q_BITS;
+        s->vfast = s->vbase = (int32_t)bus << Q_BITS;
+        s->state = ST_WAIT;
+        return;
+    }
+    s->fast += (((int32_t)current << Q_BITS) - s->fast) >> PDM_CFG_STEP_FILTER;
+    s->vfast += (((int32_t)bus << Q_BITS) - s->vfast) >> PDM_CFG_STEP_FILTER;
+
+    if (s->state == ST_WAIT)
+    {
+        if (abs32(s->fast - s->base) < s->thr)
+        {
+            s->base += (s->fast - s->base) >> BASE_SHIFT;
+            s->vbase += (s->vfast - s->vbase) >> BASE_SHIFT;
+            return;
+        }
+        s->pre = s->base;
+        s->vpre = s->vbase;
+        s->t0_us = s->move_us = ts_us;
+        s->t0_ms = HAL_GetTick();
+        s->last = s->fast;
+        s->n = 0;
+        s->same = 0;
+        s->state = ST_MOVING;
+        return;
+    }
+
+    d = s->fast - s->last;
+    s->last = s->fast;
+    s->n++;
+    if (abs32(d) > s->thr / 4)
+    {
+        s->same = 0;
+        s->move_us = ts_us;
+    }
+    else
+    {
+        s->same++;
+    }
+    if (s->same < PDM_CFG_STEP_SETTLE && s->n < PDM_CFG_STEP_MAX_N)
+    {
+        return;
+    }
+    if (abs32(s->fast - s->pre) >= s->thr)
+    {
+        step_emit(ch, s, s->fast, s->vfast);
+    }
+    s->base = s->fast;
+    s->vbase = s->vfast;
+    s->state = ST_WAIT;
+}
+
+uint32_t PDM_Step_Count(void)
+{
+    return g_total;
+}
+
+uint8_t PDM_Step_Get(uint8_t k, pdm_step_event_t *out)
+{
+    uint32_t primask;
+
+    if (k >= g_ring_n)
+    {
+        return 1;
+    }
+    primask = __get_PRIMASK();
+    __disable_irq();
+    *out = g_ring[(g_ring_next + PDM_CFG_STEP_RING - 1u - k) % PDM_CFG_STEP_RING];
+    __set_PRIMASK(primask);
+    return 0;
+}
+
+void PDM_Step_Print(void)
+{
+    const pdm_param_t *p = PDM_Param_Get();
+    pdm_step_event_t e;
+
+    for (uint8_t ch = 0; ch < PDM_CFG_CHANNELS; ch++)
+    {
+        if (g_step[ch].sc != NULL)
+        {
+            PDM_Log_Printf("step ch%u threshold %u mA, %lu steps\r\n", ch, p->step_ma[ch],
+                           (unsigned long)g_step[ch].count);
+        }
+    }
+    for (uint8_t k = 0; PDM_Step_Get(k, &e) == 0; k++)
+    {
+        PDM_Log_Printf("  ch%u #%u t %lu ms rise %lu us: %ld -> %ld mA, %ld -> %ld mV\r\n", e.ch, e.seq,
+                       (unsigned long)e.tick_ms, (unsigned long)e.rise_us, (long)(e.pre_ua / 1000),
+                       (long)(e.post_ua / 1000), (long)(e.pre_uv / 1000), (long)(e.post_uv / 1000));
+    }
+}
+
+#endif /* PDM_CFG_STEP */
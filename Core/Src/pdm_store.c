@@ -0,0 +1,371 @@
+#include "pdm_store.h"
+#include "stm32f1xx_hal.h"
+#include "pdm_boot.h"
+#include "pdm_calc.h"
+#include <stddef.h>
+#include <string.h>
+
+/* STM32F103C8: 64 KB flash */
+#define STORE_FLASH_END     (FLASH_BASE + 0x10000u)
+#define STORE_BASE          (STORE_FLASH_END - PDM_CFG_STORE_PAGES * PDM_STORE_PAGE_SIZE)
+#define STORE_SLOTS_PAGE    (PDM_STORE_PAGE_SIZE / PDM_STORE_REC_SIZE)
+#define STORE_SLOTS         (PDM_CFG_STORE_PAGES * STORE_SLOTS_PAGE)
+
+#define REC_MAGIC           0x5244u     /* "DR" */
+#define REC_HALFWORDS       (PDM_STORE_REC_SIZE / 2u)
+
+/* 每次 PDM_Store_Run() 最多编程的半字数（每个约 50~70 us） */
+#define PROGRAM_STEP        8
+
+typedef struct {
+    uint8_t payload[PDM_STORE_PAYLOAD];
+    uint32_t seq;
+    uint16_t crc;
+    uint16_t magic;
+} store_rec_t;
+
+/* 数据页数作为绝对符号交给链接脚本 Core/pdm_flash_check.ld，程序镜像进入数据页时链接失败 */
+#define STORE_STR(x)        #x
+#define STORE_XSTR(x)       STORE_STR(x)
+__asm__(".globl pdm_flash_data_pages\n\t.equ pdm_flash_data_pages, " STORE_XSTR(PDM_BOOT_DATA_PAGES));
+
+/* 程序镜像结束位置（链接脚本中的符号） */
+extern uint32_t _sidata;
+extern uint32_t _sdata;
+extern uint32_t _edata;
+
+static uint8_t g_store_ok;
+static int16_t g_newest = -1;       /* 最新有效记录的槽号 */
+static uint16_t g_next;             /* 下一条记录写入的槽号 */
+static uint32_t g_seq;
+
+static store_rec_t g_wr;            /* 正在写入的记录 */
+static uint8_t g_wr_pending;
+static uint8_t g_wr_pos;            /* 已编程的半字数 */
+static int16_t g_erase_page = -1;   /* 等待擦除的页号 */
+
+static const store_rec_t *slot_rec(uint16_t slot)
+{
+    return (const store_rec_t *)(STORE_BASE + (uint32_t)slot * PDM_STORE_REC_SIZE);
+}
+
+static uint8_t slot_erased(uint16_t slot)
+{
+    const uint32_t *p = (const uint32_t *)slot_rec(slot);
+
+    for (uint8_t i = 0; i < PDM_STORE_REC_SIZE / 4u; i++)
+    {
+        if (p[i] != 0xFFFFFFFFu)
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static uint8_t page_erased(uint16_t page)
+{
+    for (uint16_t i = 0; i < STORE_SLOTS_PAGE; i++)
+    {
+        if (!slot_erased((uint16_t)(page * STORE_SLOTS_PAGE + i)))
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static uint8_t rec_valid(const store_rec_t *r)
+{
+    return r->magic == REC_MAGIC &&
+           r->crc == pdm_calc_crc16((const uint8_t *)r, offsetof(store_rec_t, crc));
+}
+
+/* --- 写入位置进入新的一页时，安排擦除再下一页，保证写满后有空页可用 --- */
+static void plan_erase(uint16_t slot)
+{
+    uint16_t page = (uint16_t)(slot / STORE_SLOTS_PAGE);
+    uint16_t next_page = (uint16_t)((page + 1u) % PDM_CFG_STORE_PAGES);
+
+    if (!page_erased(next_page))
+    {
+        g_erase_page = (int16_t)next_page;
+    }
+}
+
+/* --- 跳过写到一半的槽，找到下一个空槽 --- */
+static void advance_next(void)
+{
+    for (uint16_t n = 0; n < STORE_SLOTS; n++)
+    {
+        if (g_next % STORE_SLOTS_PAGE == 0)
+        {
+            uint16_t page = (uint16_t)(g_next / STORE_SLOTS_PAGE);
+
+            if (!page_erased(page))
+            {
+                g_erase_page = (int16_t)page;   /* 必须先擦除才能写 */
+                return;
+            }
+            plan_erase(g_next);
+        }
+        if (slot_erased(g_next))
+        {
+            return;
+        }
+        g_next = (uint16_t)((g_next + 1u) % STORE_SLOTS);
+    }
+}
+
+uint8_t PDM_Store_Init(void)
+{
+    uint32_t image_end = (uint32_t)&_sidata + ((uint32_t)&_edata - (uint32_t)&_sdata);
+
+    g_store_ok = 0;
+    g_newest = -1;
+    g_seq = 0;
+    g_wr_pending = 0;
+    g_erase_page = -1;
+
+    if (image_end > STORE_BASE)
+    {
+        return 1;
+    }
+
+    /* 只看标志和序号，找序号最大的记录；CRC 只校验选中的那一条 */
+    for (uint16_t i = 0; i < STORE_SLOTS; i++)
+    {
+        const store_rec_t *r = slot_rec(i);
+
+        if (r->magic == REC_MAGIC && r->seq != 0xFFFFFFFFu &&
+            (g_newest < 0 || (int32_t)(r->seq - g_seq) > 0))
+        {
+            g_newest = (int16_t)i;
+            g_seq = r->seq;
+        }
+    }
+
+    /* 最新一条 CRC 不对时往前找一条有效的；g_seq 保持最大值，序号不复用 */
+    while (g_newest >= 0 && !rec_valid(slot_rec((uint16_t)g_newest)))
+    {
+        uint32_t bad_seq = slot_rec((uint16_t)g_newest)->seq;
+        int16_t best = -1;
+
+        for (uint16_t i = 0; i < STORE_SLOTS; i++)
+        {
+            const store_rec_t *r = slot_rec(i);
+
+            if (r->magic == REC_MAGIC && (int32_t)(bad_seq - r->seq) > 0 &&
+                (best < 0 || (int32_t)(r->seq - slot_rec((uint16_t)best)->seq) > 0))
+            {
+                best = (int16_t)i;
+            }
+        }
+        g_newest = best;
+    }
+
+    g_next = (g_newest < 0) ? 0 : (uint16_t)((g_newest + 1) % STORE_SLOTS);
+    g_store_ok = 1;
+    advance_next();
+    return 0;
+}
+
+uint8_t PDM_Store_Load(void *buf, uint16_t len)
+{
+    if (!g_store_ok || g_newest < 0 || len > PDM_STORE_PAYLOAD)
+    {
+        return 1;
+    }
+    memcpy(buf, slot_rec((uint16_t)g_newest)->payload, len);
+    return 0;
+}
+
+uint8_t PDM_Store_Append(const void *buf, uint16_t len)
+{
+    if (!g_store_ok || len > PDM_STORE_PAYLOAD)
+    {
+        return 1;
+    }
+
+    /* 已开始编程的记录不能再改，新数据等下一次 */
+    if (g_wr_pending && g_wr_pos != 0)
+    {
+        return 1;
+    }
+
+    memset(&g_wr, 0xFF, sizeof(g_wr));
+    memcpy(g_wr.payload, buf, len);
+    g_wr.seq = g_seq + 1u;
+    g_wr.crc = pdm_calc_crc16((const uint8_t *)&g_wr, offsetof(store_rec_t, crc));
+    g_wr.magic = REC_MAGIC;
+    g_wr_pending = 1;
+    g_wr_pos = 0;
+    return 0;
+}
+
+void PDM_Store_Run(uint8_t erase_ok)
+{
+    if (!g_store_ok)
+    {
+        return;
+    }
+
+    if (g_erase_page >= 0)
+    {
+        FLASH_EraseInitTypeDef er;
+        uint32_t err;
+
+        if (!erase_ok)
+        {
+            /* 要写的页还没擦除时只能等 */
+            if ((uint16_t)g_erase_page == g_next / STORE_SLOTS_PAGE)
+            {
+                return;
+            }
+        }
+        else
+        {
+            er.TypeErase = FLASH_TYPEERASE_PAGES;
+            er.Banks = FLASH_BANK_1;
+            er.PageAddress = STORE_BASE + (uint32_t)g_erase_page * PDM_STORE_PAGE_SIZE;
+            er.NbPages = 1;
+
+            HAL_FLASH_Unlock();
+            (void)HAL_FLASHEx_Erase(&er, &err);
+            HAL_FLASH_Lock();
+
+            g_erase_page = -1;
+            advance_next();
+            return;                 /* 本次已占用较长时间 */
+        }
+    }
+
+    if (!g_wr_pending)
+    {
+        return;
+    }
+
+    /* 数据、序号、CRC 先写，标志最后一个半字写入 */
+    const uint16_t *src = (const uint16_t *)&g_wr;
+    uint32_t dst = (uint32_t)slot_rec(g_next);
+
+    uint8_t failed = 0;
+
+    HAL_FLASH_Unlock();
+    for (uint8_t n = 0; n < PROGRAM_STEP && g_wr_pos < REC_HALFWORDS; n++, g_wr_pos++)
+    {
+        if (HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD, dst + 2u * g_wr_pos, src[g_wr_pos]) != HAL_OK)
+        {
+            failed = 1;
+            break;
+        }
+    }
+    HAL_FLASH_Lock();
+
+    if (failed)
+    {
+        /* 编程失败（槽不干净）：放弃这个槽，整条记录换到下一个槽重写 */
+        g_wr_pos = 0;
+        g_next = (uint16_t)((g_next + 1u) % STORE_SLOTS);
+        advance_next();
+        return;
+    }
+    if (g_wr_pos < REC_HALFWORDS)
+    {
+        return;                     /* 下次继续 */
+    }
+
+    g_wr_pending = 0;
+    g_wr_pos = 0;
+    if (rec_valid(slot_rec(g_next)))
+    {
+        g_newest = (int16_t)g_next;
+        g_seq = g_wr.seq;
+    }
+    g_next = (uint16_t)((g_next + 1u) % STORE_SLOTS);
+    advance_next();
+}
+
+uint8_t PDM_Store_WriteNow(const void *buf, uint16_t len)
+{
+    store_rec_t rec;
+    uint16_t slot = g_next;
+    uint32_t primask;
+    uint8_t was_locked;
+
+    if (!g_store_ok || len > PDM_STORE_PAYLOAD)
+    {
+        return 1;
+    }
+    if (g_wr_pending && g_wr_pos != 0)
+    {
+        slot = (uint16_t)((slot + 1u) % STORE_SLOTS);     /* 写了一半的槽不能再用 */
+    }
+    if (!slot_erased(slot))
+    {
+        return 1;
+    }
+
+    memset(&rec, 0xFF, sizeof(rec));
+    memcpy(rec.payload, buf, len);
+    rec.seq = g_seq + 1u;
+    rec.crc = pdm_calc_crc16((const uint8_t *)&rec, offsetof(store_rec_t, crc));
+    rec.magic = REC_MAGIC;
+
+    /* 主循环可能正在用 HAL 编程（HAL 的锁还占着），这里直接写寄存器 */
+    primask = __get_PRIMASK();
+    __disable_irq();
+    while (FLASH->SR & FLASH_SR_BSY) { }
+    was_locked = (FLASH->CR & FLASH_CR_LOCK) != 0;
+    if (was_locked)
+    {
+        FLASH->KEYR = FLASH_KEY1;
+        FLASH->KEYR = FLASH_KEY2;
+    }
+    FLASH->SR = FLASH_SR_EOP | FLASH_SR_PGERR | FLASH_SR_WRPRTERR;
+    FLASH->CR |= FLASH_CR_PG;
+
+    const uint16_t *src = (const uint16_t *)&rec;
+    volatile uint16_t *dst = (volatile uint16_t *)slot_rec(slot);
+    for (uint8_t i = 0; i < REC_HALFWORDS; i++)
+    {
+        dst[i] = src[i];
+        while (FLASH->SR & FLASH_SR_BSY) { }
+    }
+
+    FLASH->CR &= ~FLASH_CR_PG;
+    FLASH->SR = FLASH_SR_EOP | FLASH_SR_PGERR | FLASH_SR_WRPRTERR;
+    if (was_locked)
+    {
+        FLASH->CR |= FLASH_CR_LOCK;
+    }
+
+    g_wr_pending = 0;
+    g_wr_pos = 0;
+    if (rec_valid(slot_rec(slot)))
+    {
+        g_newest = (int16_t)slot;
+        g_seq = rec.seq;
+    }
+    g_next = (uint16_t)((slot + 1u) % STORE_SLOTS);
+    advance_next();
+    __set_PRIMASK(primask);
+
+    return (uint8_t)(g_newest != (int16_t)slot);
+}
+
+uint8_t PDM_Store_Busy(void)
+{
+    return (uint8_t)(g_wr_pending || g_erase_page >= 0);
+}
+
+uint32_t PDM_Store_Seq(void)
+{
+    return g_seq;
+}
+
+const uint8_t *PDM_Store_Area(uint32_t *size)
+{
+    *size = PDM_CFG_STORE_PAGES * PDM_STORE_PAGE_SIZE;
+    return (const uint8_t *)STORE_BASE;
+}
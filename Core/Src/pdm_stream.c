@@ -0,0 +1,199 @@
+#include "pdm_stream.h"
+
+#if PDM_CFG_UART_STREAM
+
+#include "pdm_calc.h"
+#include "pdm_log.h"
+#include "usart.h"
+#if PDM_CFG_UART_STREAM_PACK
+#include "pdm_pack.h"
+#endif
+
+/* 编码前最大数据长度（含 CRC）；COBS 每 254 字节最多多 1 字节，这里只需多 1 字节 */
+#if PDM_CFG_UART_STREAM_PACK
+/* 压缩帧：3 字节头 + 时间戳块 + 4 个 16 位字段块 + CRC */
+#define STREAM_BASE_RAW     (3u + PDM_PACK_MAX_BYTES + 4u * PDM_PACK_MAX_BYTES_16 + 2u)
+#else
+#define STREAM_BASE_RAW     32u
+#endif
+#if PDM_CFG_CAPTURE_FAST
+/* 电流帧：12 字节头 + 每样本 4 字节 + CRC */
+#define STREAM_FAST_RAW     (12u + 4u * PDM_CFG_CAPTURE_FAST_BLOCK + 2u)
+#define STREAM_MAX_RAW      ((STREAM_FAST_RAW > STREAM_BASE_RAW) ? STREAM_FAST_RAW : STREAM_BASE_RAW)
+#else
+#define STREAM_MAX_RAW      STREAM_BASE_RAW
+#endif
+#define STREAM_MAX_FRAME    (STREAM_MAX_RAW + 3u)
+
+#if PDM_CFG_CHANNELS * 4 + 2 + 2 > STREAM_MAX_RAW
+#error "PDM_CFG_CHANNELS too large for the stream info frame"
+#endif
+
+_Static_assert(STREAM_MAX_RAW <= 254u, "single-level COBS needs frames of at most 254 bytes");
+
+static uint8_t g_seq;
+
+#if PDM_CFG_UART_STREAM_PACK
+/* 每通道按字段分开编码：时间戳、总线、分流、电流、功率 */
+#define STREAM_FIELDS       5u
+static pdm_pack_t g_pack[PDM_CFG_CHANNELS][STREAM_FIELDS];
+#endif
+
+static void put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)(v & 0xFF);
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+    put_u16(p, (uint16_t)(v & 0xFFFF));
+    put_u16(p + 2, (uint16_t)(v >> 16));
+}
+
+/* --- 追加 CRC，COBS 编码并写入日志缓冲区；缓冲区满时整帧丢弃，返回 1 --- */
+static uint8_t send_frame(uint8_t *raw, uint8_t len)
+{
+    uint8_t out[STREAM_MAX_FRAME];
+    uint8_t code_at = 1;        /* 当前段长度字节的位置 */
+    uint8_t n = 2;
+
+    put_u16(&raw[len], pdm_calc_crc16(raw, len));
+    len += 2u;
+
+    /* COBS：0x00 换成到下一个 0x00 的距离，帧内不再出现 0x00（数据不超过 254 字节，只有一级） */
+    out[0] = 0x00;
+    for (uint8_t i = 0; i < len; i++)
+    {
+        if (raw[i] == 0x00)
+        {
+            out[code_at] = (uint8_t)(n - code_at);
+            code_at = n++;
+        }
+        else
+        {
+            out[n++] = raw[i];
+        }
+    }
+    out[code_at] = (uint8_t)(n - code_at);
+    out[n++] = 0x00;
+
+    return PDM_Log_Write((const char *)out, n);
+}
+
+void PDM_Stream_Init(void)
+{
+    huart1.Init.BaudRate = PDM_CFG_UART_STREAM_BAUD;
+    if (HAL_UART_Init(&huart1) != HAL_OK)
+    {
+        Error_Handler();
+    }
+    g_seq = 0;
+#if PDM_CFG_UART_STREAM_PACK
+    for (uint8_t ch = 0; ch < PDM_CFG_CHANNELS; ch++)
+    {
+        for (uint8_t f = 0; f < STREAM_FIELDS; f++)
+        {
+            PDM_Pack_Init(&g_pack[ch][f]);
+        }
+    }
+#endif
+}
+
+void PDM_Stream_Sample(uint8_t ch, uint32_t ts_us, uint16_t bus, int16_t shunt,
+                       int16_t current, uint16_t power)
+{
+    uint8_t raw[STREAM_MAX_RAW];
+
+#if PDM_CFG_UART_STREAM_PACK
+    pdm_pack_t *pk;
+    uint8_t len;
+
+    if (ch >= PDM_CFG_CHANNELS)
+    {
+        return;
+    }
+    pk = g_pack[ch];
+    (void)PDM_Pack_Put(&pk[0], ts_us);
+    (void)PDM_Pack_Put(&pk[1], bus);
+    (void)PDM_Pack_Put(&pk[2], (uint32_t)(int32_t)shunt);
+    (void)PDM_Pack_Put(&pk[3], (uint32_t)(int32_t)current);
+    if (!PDM_Pack_Put(&pk[4], power))
+    {
+        return;
+    }
+
+    /* 攒满一块才输出一帧，各字段的块依次排列 */
+    raw[0] = PDM_STREAM_TYPE_PACKED;
+    raw[1] = ch;
+    raw[2] = g_seq++;
+    len = 3;
+    for (uint8_t f = 0; f < STREAM_FIELDS; f++)
+    {
+        len = (uint8_t)(len + PDM_Pack_Flush(&pk[f], &raw[len]));
+    }
+    (void)send_frame(raw, len);
+#else
+    raw[0] = PDM_STREAM_TYPE_SAMPLE;
+    raw[1] = ch;
+    raw[2] = g_seq++;
+    put_u32(&raw[3], ts_us);
+    put_u16(&raw[7], bus);
+    put_u16(&raw[9], (uint16_t)shunt);
+    put_u16(&raw[11], (uint16_t)current);
+    put_u16(&raw[13], power);
+    (void)send_frame(raw, 15);
+#endif
+}
+
+void PDM_Stream_Info(uint8_t ch_count, const uint32_t *current_ua_per_lsb)
+{
+    uint8_t raw[STREAM_MAX_RAW];
+
+    raw[0] = PDM_STREAM_TYPE_INFO;
+    raw[1] = ch_count;
+    for (uint8_t i = 0; i < ch_count; i++)
+    {
+        put_u32(&raw[2 + 4 * i], current_ua_per_lsb[i]);
+    }
+    (void)send_frame(raw, (uint8_t)(2 + 4 * ch_count));
+}
+
+void PDM_Stream_Time(uint8_t state, uint32_t local_us, uint64_t vehicle_us)
+{
+    uint8_t raw[STREAM_MAX_RAW];
+
+    raw[0] = PDM_STREAM_TYPE_TIME;
+    raw[1] = state;
+    put_u32(&raw[2], local_us);
+    put_u32(&raw[6], (uint32_t)vehicle_us);
+    put_u32(&raw[10], (uint32_t)(vehicle_us >> 32));
+    (void)send_frame(raw, 14);
+}
+
+#if PDM_CFG_CAPTURE_FAST
+uint8_t PDM_Stream_Fast(uint8_t ch, uint32_t t0_us, uint32_t dropped,
+                        const int16_t *shunt, const uint16_t *dt_us, uint8_t n)
+{
+    uint8_t raw[STREAM_MAX_RAW];
+
+    if (n > PDM_CFG_CAPTURE_FAST_BLOCK)
+    {
+        n = PDM_CFG_CAPTURE_FAST_BLOCK;
+    }
+    raw[0] = PDM_STREAM_TYPE_FAST;
+    raw[1] = ch;
+    raw[2] = g_seq++;
+    put_u32(&raw[3], t0_us);
+    put_u32(&raw[7], dropped);
+    raw[11] = n;
+    for (uint8_t i = 0; i < n; i++)
+    {
+        put_u16(&raw[12 + 4 * i], (uint16_t)shunt[i]);
+        put_u16(&raw[14 + 4 * i], dt_us[i]);
+    }
+    return send_frame(raw, (uint8_t)(12 + 4 * n));
+}
+#endif
+
+#endif /* PDM_CFG_UART_STREAM */
@@ -0,0 +1,479 @@
+#include "pdm_telem.h"
+#include "pdm_calc.h"
+#include "pdm_can.h"
+#include "pdm_canhealth.h"
+#include "pdm_decim.h"
+#include "pdm_derived.h"
+#include "pdm_e2e.h"
+#include "pdm_load.h"
+#include "pdm_mcu.h"
+#include "pdm_monitor.h"
+#include "pdm_node.h"
+#include "pdm_param.h"
+#include "pdm_plaus.h"
+#include "pdm_replay.h"
+#include "pdm_signals.h"
+#include "pdm_soc.h"
+#include "pdm_stack.h"
+#include "pdm_stats.h"
+#include "pdm_timesync.h"
+#include "ina226_async.h"
+#include "stm32f1xx_hal.h"
+#include <string.h>
+
+#define CH_COUNT    PDM_CFG_CHANNELS
+
+/* 扩展遥测每个通道的页数：电流、电压、分流电压与计数、RMS 与峰值功率，滤波后的值 */
+#define EXT_PAGES   (4 + PDM_CFG_FILTER)
+
+static void put_be16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)(v >> 8);
+    p[1] = (uint8_t)(v & 0xFF);
+}
+
+/* 通道帧上次编码的结果：发布序号不变时直接复制，变了时只重新换算来源值变化的字段 */
+typedef struct {
+    uint8_t ch;                 /* 通道号；通道帧和 E2E 帧的回调参数指向这一项 */
+    uint32_t seq;
+    uint8_t valid;
+    uint8_t online;
+#define ENC_SRC(n, str, src, type, pos, lsb, div, unit, inv) type src;
+    PDM_CHANNEL_SIGNALS(ENC_SRC)
+#undef ENC_SRC
+    uint8_t data[8];
+} can_enc_t;
+
+static can_enc_t g_can_enc[CH_COUNT];
+
+/* --- Encode one channel into a CAN payload --- */
+static void encode_channel(uint8_t *data, const void *arg)
+{
+    can_enc_t *e = (can_enc_t *)arg;
+    uint8_t i = e->ch;
+    uint32_t seq = PDM_Monitor_Seq(i);
+    pdm_channel_t snap;
+    const pdm_channel_t *ch = &snap;
+
+    if (e->valid && e->seq == seq)
+    {
+        memcpy(data, e->data, 8);       /* 上次编码之后没有新的采样 */
+        return;
+    }
+    PDM_Monitor_GetChannel(i, &snap);  /* 复制期间又发布过时 seq 偏旧，下次多换算一次 */
+    if (!e->valid || ch->online != e->online)
+    {
+        e->online = ch->online;
+        e->valid = 0;                   /* 在线状态变化，所有字段重新填写 */
+    }
+    if (!ch->online)
+    {
+        if (!e->valid)
+        {
+#define ENC_INVALID(n, str, src, type, pos, lsb, div, unit, inv) put_be16(&e->data[pos], inv);
+            PDM_CHANNEL_SIGNALS(ENC_INVALID)
+#undef ENC_INVALID
+        }
+    }
+    else
+    {
+        /* Saturating integer scaling，各字段由 pdm_signals.h 展开 */
+#define ENC_FIELD(n, str, src, type, pos, lsb, div, unit, inv) \
+        if (!e->valid || ch->src != e->src) \
+        { \
+            e->src = ch->src; \
+            put_be16(&e->data[pos], pdm_sig_encode_##n(ch->src)); \
+        }
+        PDM_CHANNEL_SIGNALS(ENC_FIELD)
+#undef ENC_FIELD
+    }
+    e->seq = seq;
+    e->valid = 1;
+    memcpy(data, e->data, 8);
+}
+
+/* --- 通道帧按变化发送：电压或电流与上次发出的值相差超过死区（运行参数），离线标志变化 --- */
+static uint8_t channel_changed(const uint8_t *data, const uint8_t *last, const void *arg)
+{
+    const pdm_param_t *p = PDM_Param_Get();
+    uint8_t i = ((const can_enc_t *)arg)->ch;
+    int32_t v = (int16_t)((uint16_t)data[PDM_SIG_VOLTAGE_POS] << 8 | data[PDM_SIG_VOLTAGE_POS + 1]);
+    int32_t lv = (int16_t)((uint16_t)last[PDM_SIG_VOLTAGE_POS] << 8 | last[PDM_SIG_VOLTAGE_POS + 1]);
+    int32_t c = (int16_t)((uint16_t)data[PDM_SIG_CURRENT_POS] << 8 | data[PDM_SIG_CURRENT_POS + 1]);
+    int32_t lc = (int16_t)((uint16_t)last[PDM_SIG_CURRENT_POS] << 8 | last[PDM_SIG_CURRENT_POS + 1]);
+    int32_t dv = (v > lv) ? v - lv : lv - v;
+    int32_t dc = (c > lc) ? c - lc : lc - c;
+
+    if ((v == PDM_SIG_VOLTAGE_INVALID) != (lv == PDM_SIG_VOLTAGE_INVALID))
+    {
+        return 1;
+    }
+    return (uint8_t)((uint32_t)dv * PDM_CAN_VOLTAGE_MV_PER_LSB > p->can_db_mv ||
+                     (uint32_t)dc * PDM_CAN_CURRENT_UA_PER_LSB > (uint32_t)p->can_db_ma[i] * 1000u);
+}
+
+#if PDM_CFG_BENCH
+void PDM_Telem_EncodeChannel(uint8_t ch, uint8_t *data, uint8_t full)
+{
+    if (full)
+    {
+        g_can_enc[ch].valid = 0;
+    }
+    encode_channel(data, &g_can_enc[ch]);
+}
+#endif
+
+#if PDM_CFG_E2E
+static uint8_t g_e2e_alive[CH_COUNT];
+
+/* --- 带计数器和 CRC 的通道帧：前 6 字节同通道帧，能量字段换成状态/计数器和 CRC（见 pdm_e2e.h） --- */
+static void encode_channel_e2e(uint8_t *data, const void *arg)
+{
+    uint8_t i = ((const can_enc_t *)arg)->ch;
+    uint8_t status = 0;
+
+    encode_channel(data, arg);
+#if PDM_CFG_PLAUS
+    if (PDM_Plaus_Flags(i) != 0)
+    {
+        status |= PDM_E2E_STATUS_PLAUS;
+    }
+#endif
+    data[6] = (uint8_t)(status << 4);
+    PDM_E2E_Protect(PDM_Node_TxId(PDM_Param_Get()->can_id[i] + PDM_CFG_E2E_ID_OFFSET), &g_e2e_alive[i], data);
+}
+#endif
+
+#if PDM_CFG_TIMESYNC
+/* --- 车辆时间帧：各通道轮流，给出该通道最新一组采样的车辆时间（见 pdm_timesync.h） --- */
+static void encode_time(uint8_t *data, const void *arg)
+{
+    static uint8_t ch;
+    pdm_channel_t snap;
+
+    (void)arg;
+    PDM_Monitor_GetChannel(ch, &snap);
+    PDM_TimeSync_Encode(PDM_TSYNC_KIND_SAMPLE, ch, snap.sample_us, data);
+    ch = (uint8_t)((ch + 1u) % CH_COUNT);
+}
+#endif
+
+/* --- Encode device health:
+ * [状态（每通道 2 位，通道 0 在低位）, 总线恢复次数, 重新初始化次数, 平均档位（每通道 2 位）, 读取错误 x4]，
+ * 计数超过 255 时保持 255 --- */
+static void encode_health(uint8_t *data, const void *arg)
+{
+    uint16_t recov = ina226_interface_iic_recoveries();
+    uint32_t reinit = 0;
+
+    (void)arg;
+    memset(data, 0, 8);
+    for (uint8_t i = 0; i < CH_COUNT && i < 4; i++)
+    {
+        pdm_dev_status_t st;
+
+        PDM_Monitor_GetStatus(i, &st);
+        data[0] |= (uint8_t)(st.health << (2u * i));
+        data[3] |= (uint8_t)(st.level << (2u * i));
+        data[4 + i] = (uint8_t)(st.errors > 255u ? 255u : st.errors);
+        reinit += st.reinits;
+    }
+    data[1] = (uint8_t)(recov > 255u ? 255u : recov);
+    data[2] = (uint8_t)(reinit > 255u ? 255u : reinit);
+}
+
+/* --- Encode extended telemetry: data[0] = 通道 << 4 | 页，每次发送一页，各通道轮流。
+ * 每个通道发第 0 页时结束该通道的遥测统计窗口（PDM_STATS_WIN_TELEM），页 0~3 都用这一份结果。
+ *   页 0：[mux, 采样数(饱和 255), 电流 min, max, mean]      int16，10 mA/LSB
+ *   页 1：[mux, 采样数(饱和 255), 电压 min, max, mean]      int16，1 mV/LSB
+ *   页 2：[mux, 平均档位 << 4 | 状态, 分流电压寄存器(2), 采样数(2), 读取错误(2)]  分流电压 2.5 uV/LSB
+ *   页 3：[mux, 采样数(饱和 255), 电流 RMS, 电流标准差, 峰值功率]  10 mA/LSB，100 mW/LSB
+ *   页 4：[mux, 0, 滤波后的电压, 电流, 功率]  分辨率同通道帧，只在 PDM_CFG_FILTER=1 时发送
+ * 窗口内没有有效采样时统计字段为 0x7FFF，页 4 在通道离线时为失效值 --- */
+static void encode_ext(uint8_t *data, const void *arg)
+{
+    static uint8_t ch;
+    static uint8_t page;
+    static pdm_stats_result_t pub;
+    static uint8_t valid;
+    int16_t f1 = 0x7FFF, f2 = 0x7FFF, f3 = 0x7FFF;
+
+    (void)arg;
+    if (page == 0)
+    {
+        PDM_Stats_Close(ch, PDM_STATS_WIN_TELEM, HAL_GetTick());
+        valid = (uint8_t)(PDM_Stats_Get(ch, PDM_STATS_WIN_TELEM, &pub) == 0);
+        if (!valid)
+        {
+            pub.n = 0;
+        }
+    }
+
+    data[0] = (uint8_t)(ch << 4 | page);
+    data[1] = (uint8_t)(pub.n > 255u ? 255u : pub.n);
+    switch (page)
+    {
+    case 0:
+        if (valid)
+        {
+            f1 = pdm_calc_sat_i16(pub.i_min_uA / PDM_CAN_CURRENT_UA_PER_LSB);
+            f2 = pdm_calc_sat_i16(pub.i_max_uA / PDM_CAN_CURRENT_UA_PER_LSB);
+            f3 = pdm_calc_sat_i16(pub.i_mean_uA / PDM_CAN_CURRENT_UA_PER_LSB);
+        }
+        break;
+    case 1:
+        if (valid)
+        {
+            f1 = pdm_calc_sat_i16(pub.v_min_mV / PDM_CAN_VOLTAGE_MV_PER_LSB);
+            f2 = pdm_calc_sat_i16(pub.v_max_mV / PDM_CAN_VOLTAGE_MV_PER_LSB);
+            f3 = pdm_calc_sat_i16(pub.v_mean_mV / PDM_CAN_VOLTAGE_MV_PER_LSB);
+        }
+        break;
+#if PDM_CFG_FILTER
+    case 4:
+    {
+        pdm_channel_t c;
+
+        PDM_Monitor_GetChannel(ch, &c);
+        data[1] = 0;
+        f3 = (int16_t)0xFFFF;
+        if (c.online)
+        {
+            f1 = pdm_calc_sat_i16(c.voltage_f_mV / PDM_CAN_VOLTAGE_MV_PER_LSB);
+            f2 = pdm_calc_sat_i16(c.current_f_uA / PDM_CAN_CURRENT_UA_PER_LSB);
+            f3 = (int16_t)pdm_calc_sat_u16(c.power_f_uW / PDM_CAN_POWER_UW_PER_LSB);
+        }
+        break;
+    }
+#endif
+    case 2:
+    {
+        pdm_dev_status_t st;
+        pdm_channel_t c;
+
+        PDM_Monitor_GetStatus(ch, &st);
+        PDM_Monitor_GetChannel(ch, &c);
+        data[1] = (uint8_t)(st.level << 4 | st.health);
+        f1 = valid ? c.shunt_raw : 0x7FFF;
+        f2 = (int16_t)pdm_calc_sat_u16(pub.n);
+        f3 = (int16_t)pdm_calc_sat_u16(st.errors);
+        break;
+    }
+    default:
+        if (valid)
+        {
+            f1 = pdm_calc_sat_i16(pub.i_rms_uA / PDM_CAN_CURRENT_UA_PER_LSB);
+            f2 = pdm_calc_sat_i16(pub.i_std_uA / PDM_CAN_CURRENT_UA_PER_LSB);
+            f3 = (int16_t)pdm_calc_sat_u16(pub.p_peak_uW / PDM_CAN_POWER_UW_PER_LSB);
+        }
+        break;
+    }
+    put_be16(&data[2], (uint16_t)f1);
+    put_be16(&data[4], (uint16_t)f2);
+    put_be16(&data[6], (uint16_t)f3);
+
+    if (++page == EXT_PAGES)
+    {
+        page = 0;
+        ch = (uint8_t)((ch + 1u) % CH_COUNT);
+    }
+}
+
+/* --- Encode charge / discharge energy, one channel per frame:
+ * [通道号, 0, 放电 (2), 充电 (2), 净值 = 放电 - 充电 (2, 有符号)]，10 mWh/LSB，大端 --- */
+static void encode_energy(uint8_t *data, const void *arg)
+{
+    static uint8_t ch;
+    pdm_channel_t c;
+    uint16_t dis, chg;
+
+    (void)arg;
+    PDM_Monitor_GetChannel(ch, &c);
+    dis = pdm_calc_sat_u16(c.energy_dis_uWh / PDM_CAN_ENERGY_UWH_PER_LSB);
+    chg = pdm_calc_sat_u16(c.energy_chg_uWh / PDM_CAN_ENERGY_UWH_PER_LSB);
+    data[0] = ch;
+    data[1] = 0;
+    put_be16(&data[2], dis);
+    put_be16(&data[4], chg);
+    put_be16(&data[6], (uint16_t)pdm_calc_sat_i16((int32_t)dis - (int32_t)chg));
+
+    ch = (uint8_t)((ch + 1u) % CH_COUNT);
+}
+
+#if PDM_CFG_CAN_ENERGY32_MS
+/* --- 32 位能量帧，一次一个通道，各通道轮流：
+ * [通道号 << 4 | 0x300/0x301 能量字段的回绕次数 (低 4 位), 能量 (4, 10 uWh/LSB), 净电荷 (3, 0.1 mAh/LSB，有符号)]，大端。
+ * 能量 = 回绕次数 x 655.36 Wh + energy_uWh，与通道帧的能量同一来源，32 位回绕 --- */
+static void encode_energy32(uint8_t *data, const void *arg)
+{
+    static uint8_t ch;
+    pdm_channel_t c;
+    uint32_t e;
+    int32_t q;
+
+    (void)arg;
+    PDM_Monitor_GetChannel(ch, &c);
+    e = (uint32_t)(((uint64_t)c.energy_wraps * PDM_ENERGY_WRAP_UWH + c.energy_uWh) / 10u);
+    q = pdm_calc_charge_100uAh(c.charge_acc, &PDM_Monitor_Config(ch)->scale);
+    if (q > 0x7FFFFF)
+    {
+        q = 0x7FFFFF;
+    }
+    else if (q < -0x800000)
+    {
+        q = -0x800000;
+    }
+    data[0] = (uint8_t)(ch << 4 | (c.energy_wraps & 0x0Fu));
+    data[1] = (uint8_t)(e >> 24);
+    data[2] = (uint8_t)(e >> 16);
+    data[3] = (uint8_t)(e >> 8);
+    data[4] = (uint8_t)e;
+    data[5] = (uint8_t)((uint32_t)q >> 16);
+    data[6] = (uint8_t)((uint32_t)q >> 8);
+    data[7] = (uint8_t)q;
+
+    ch = (uint8_t)((ch + 1u) % CH_COUNT);
+}
+#endif
+
+/* CAN 报文表：每通道一帧，然后是器件状态帧、扩展遥测帧和充放电能量帧，初始化时按运行参数填写 */
+#define MSG_HEALTH  CH_COUNT
+#define MSG_EXT     (CH_COUNT + 1)
+#define MSG_ENERGY  (CH_COUNT + 2)
+#define MSG_SOC     (CH_COUNT + 3)
+#define MSG_DERIVED (CH_COUNT + 3 + PDM_CFG_SOC)
+#define MSG_PLAUS   (CH_COUNT + 3 + PDM_CFG_SOC + PDM_CFG_DERIVED)
+#define MSG_CANH    (CH_COUNT + 3 + PDM_CFG_SOC + PDM_CFG_DERIVED + PDM_CFG_PLAUS)
+#define MSG_E2E     (CH_COUNT + 3 + PDM_CFG_SOC + PDM_CFG_DERIVED + PDM_CFG_PLAUS + PDM_CFG_CANH)    /* 每通道一帧 */
+#define MSG_TIME    (MSG_E2E + CH_COUNT * PDM_CFG_E2E)
+#define MSG_MCU     (MSG_TIME + PDM_CFG_TIMESYNC)
+#define MSG_STACK   (MSG_MCU + PDM_CFG_MCU)
+#define MSG_REPLAY  (MSG_STACK + PDM_CFG_STACK)
+#define MSG_DECIM   (MSG_REPLAY + PDM_CFG_REPLAY)
+#define MSG_LOAD    (MSG_DECIM + PDM_CFG_DECIM)
+#define MSG_ENERGY32 (MSG_LOAD + PDM_CFG_LOAD)
+
+static pdm_can_msg_t g_can_msgs[CH_COUNT + 3 + PDM_CFG_SOC + PDM_CFG_DERIVED + PDM_CFG_PLAUS + PDM_CFG_CANH +
+                                CH_COUNT * PDM_CFG_E2E + PDM_CFG_TIMESYNC + PDM_CFG_MCU + PDM_CFG_STACK +
+                                PDM_CFG_REPLAY + PDM_CFG_DECIM + PDM_CFG_LOAD + (PDM_CFG_CAN_ENERGY32_MS != 0)];
+
+_Static_assert(sizeof(g_can_msgs) / sizeof(g_can_msgs[0]) <= PDM_CAN_MAX_MSGS, "CAN message table exceeds PDM_CAN_MAX_MSGS");
+
+static void set_msg(uint8_t i, uint32_t id, void (*encode)(uint8_t *, const void *), const void *arg,
+                    uint16_t period_ms, uint8_t on_sample)
+{
+    g_can_msgs[i].id = id;
+    g_can_msgs[i].dlc = 8;
+    g_can_msgs[i].encode = encode;
+    g_can_msgs[i].arg = arg;
+    g_can_msgs[i].period_ms = period_ms;
+    g_can_msgs[i].on_sample = on_sample;
+}
+
+void PDM_Telem_Init(uint32_t now)
+{
+    const pdm_param_t *p = PDM_Param_Get();
+
+    for (uint8_t i = 0; i < CH_COUNT; i++)
+    {
+        g_can_enc[i].ch = i;
+        set_msg(i, p->can_id[i], encode_channel, &g_can_enc[i], p->can_ms, p->can_on_sample);
+    }
+    for (uint8_t i = 0; i < CH_COUNT; i++)
+    {
+        g_can_msgs[i].keepalive_ms = PDM_CFG_CAN_KEEPALIVE_MS;
+        g_can_msgs[i].changed = channel_changed;
+        g_can_msgs[i].min_ms = p->can_min_ms;
+        g_can_msgs[i].max_ms = p->can_max_ms;
+    }
+    set_msg(MSG_HEALTH, PDM_TELEM_HEALTH_ID, encode_health, NULL, 1000, 0);
+    set_msg(MSG_EXT, PDM_TELEM_EXT_ID, encode_ext, NULL, PDM_CFG_CAN_EXT_PERIOD_MS, 0);
+    set_msg(MSG_ENERGY, PDM_TELEM_ENERGY_ID, encode_energy, NULL, 500, 0);
+#if PDM_CFG_SOC
+    set_msg(MSG_SOC, PDM_SOC_CAN_ID, PDM_Soc_Encode, NULL, 1000, 0);
+#endif
+#if PDM_CFG_DERIVED
+    set_msg(MSG_DERIVED, PDM_DERIVED_CAN_ID, PDM_Derived_Encode, NULL, PDM_CFG_DERIVED_PERIOD_MS, 0);
+#endif
+#if PDM_CFG_PLAUS
+    set_msg(MSG_PLAUS, PDM_PLAUS_CAN_ID, PDM_Plaus_Encode, NULL, p->can_ms, p->can_on_sample);
+#endif
+#if PDM_CFG_CANH
+    set_msg(MSG_CANH, PDM_CANH_CAN_ID, PDM_CanHealth_Encode, NULL, 1000, 0);
+#endif
+#if PDM_CFG_E2E
+    for (uint8_t i = 0; i < CH_COUNT; i++)
+    {
+        set_msg((uint8_t)(MSG_E2E + i), p->can_id[i] + PDM_CFG_E2E_ID_OFFSET, encode_channel_e2e, &g_can_enc[i],
+                p->can_ms, p->can_on_sample);
+    }
+#endif
+#if PDM_CFG_TIMESYNC
+    set_msg(MSG_TIME, PDM_TIMESYNC_CAN_ID, encode_time, NULL, p->can_ms, p->can_on_sample);
+#endif
+#if PDM_CFG_MCU
+    set_msg(MSG_MCU, PDM_MCU_CAN_ID, PDM_Mcu_Encode, NULL, 1000, 0);
+#endif
+#if PDM_CFG_STACK
+    set_msg(MSG_STACK, PDM_STACK_CAN_ID, PDM_Stack_Encode, NULL, 1000, 0);
+#endif
+#if PDM_CFG_REPLAY
+    set_msg(MSG_REPLAY, PDM_REPLAY_CAN_ID, PDM_Replay_Encode, NULL, 100, 0);
+#endif
+#if PDM_CFG_DECIM
+    set_msg(MSG_DECIM, PDM_DECIM_CAN_ID, PDM_Decim_Encode, NULL, PDM_CFG_DECIM_PERIOD_MS, 0);
+#endif
+#if PDM_CFG_LOAD
+    set_msg(MSG_LOAD, PDM_LOAD_CAN_ID, PDM_Load_Encode, NULL, 1000, 0);
+#endif
+#if PDM_CFG_CAN_ENERGY32_MS
+    set_msg(MSG_ENERGY32, PDM_TELEM_ENERGY32_ID, encode_energy32, NULL, PDM_CFG_CAN_ENERGY32_MS, 0);
+#endif
+    PDM_Can_Init(g_can_msgs, (uint8_t)(sizeof(g_can_msgs) / sizeof(g_can_msgs[0])), now);
+}
+
+void PDM_Telem_FollowChannel(uint16_t period_ms, uint8_t on_sample)
+{
+    for (uint8_t i = 0; i < CH_COUNT; i++)
+    {
+        (void)PDM_Can_SetSchedule(g_can_msgs[i].id, period_ms, on_sample);
+#if PDM_CFG_E2E
+        (void)PDM_Can_SetSchedule(g_can_msgs[MSG_E2E + i].id, period_ms, on_sample);
+#endif
+    }
+#if PDM_CFG_PLAUS
+    (void)PDM_Can_SetSchedule(PDM_PLAUS_CAN_ID, period_ms, on_sample);
+#endif
+#if PDM_CFG_TIMESYNC
+    (void)PDM_Can_SetSchedule(PDM_TIMESYNC_CAN_ID, period_ms, on_sample);
+#endif
+}
+
+void PDM_Telem_SetChange(uint16_t min_ms, uint16_t max_ms)
+{
+    for (uint8_t i = 0; i < CH_COUNT; i++)
+    {
+        (void)PDM_Can_SetChange(g_can_msgs[i].id, min_ms, max_ms);
+    }
+}
+
+void PDM_Telem_SetChannelId(uint8_t ch, uint16_t id)
+{
+    g_can_msgs[ch].id = id;
+#if PDM_CFG_E2E
+    g_can_msgs[MSG_E2E + ch].id = id + PDM_CFG_E2E_ID_OFFSET;
+#endif
+}
+
+uint8_t PDM_Telem_IdUsed(uint32_t id)
+{
+    for (uint8_t j = CH_COUNT; j < sizeof(g_can_msgs) / sizeof(g_can_msgs[0]); j++)
+    {
+        if ((j < MSG_E2E || j >= MSG_E2E + CH_COUNT * PDM_CFG_E2E) && g_can_msgs[j].encode != NULL &&
+            g_can_msgs[j].id == id)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,157 @@
+#include "pdm_timer.h"
+
+#if PDM_TIMER_US
+
+#include "pdm_irq.h"
+#include "pdm_ramfunc.h"
+#include "stm32f1xx_hal.h"
+
+/* 采样时钟 TIM3 的计数频率：10 kHz，ARR 16 位时最长周期 6553 ms */
+#define SAMPLE_TICK_HZ      10000u
+
+#if PDM_CFG_SAMPLE_TIMER
+static void (*g_on_sample)(uint32_t now_us);
+#endif
+#if PDM_CFG_ALERT_CAPTURE
+static volatile uint32_t g_alert_us[2];
+static volatile uint32_t g_alert_miss;
+#endif
+
+/* APB1 分频不为 1 时定时器时钟是 PCLK1 的两倍（默认 72 MHz） */
+static uint32_t tim_clock_hz(void)
+{
+    uint32_t clk = HAL_RCC_GetPCLK1Freq();
+
+    if ((RCC->CFGR & RCC_CFGR_PPRE1) != RCC_CFGR_PPRE1_DIV1)
+    {
+        clk *= 2u;
+    }
+    return clk;
+}
+
+void PDM_Timer_Init(void)
+{
+    __HAL_RCC_TIM2_CLK_ENABLE();
+    __HAL_RCC_TIM4_CLK_ENABLE();
+
+    /* TIM2：1 MHz，计满 16 位溢出，更新事件作为 TRGO */
+    TIM2->CR1 = 0;
+    TIM2->PSC = tim_clock_hz() / 1000000u - 1u;
+    TIM2->ARR = 0xFFFFu;
+    TIM2->EGR = TIM_EGR_UG;             /* 装入预分频值 */
+    TIM2->CR2 = TIM_CR2_MMS_1;          /* MMS = 010：更新 */
+#if PDM_CFG_ALERT_CAPTURE
+    /* CH2 (PA1)、CH4 (PA3)：输入捕获，IC 映射到各自的 TI，滤波 fCK_INT N=8（约 0.1 us 固定延迟），下降沿；
+     * 引脚保持 EXTI 输入配置，不开 TIM2 中断 */
+    TIM2->CCER = 0;
+    TIM2->CCMR1 = TIM_CCMR1_CC2S_0 | TIM_CCMR1_IC2F_1 | TIM_CCMR1_IC2F_0;
+    TIM2->CCMR2 = TIM_CCMR2_CC4S_0 | TIM_CCMR2_IC4F_1 | TIM_CCMR2_IC4F_0;
+    TIM2->CCER = TIM_CCER_CC2P | TIM_CCER_CC2E | TIM_CCER_CC4P | TIM_CCER_CC4E;
+#endif
+
+    /* TIM4：外部时钟模式 1，时钟来自 ITR1 (TIM2 TRGO) */
+    TIM4->CR1 = 0;
+    TIM4->PSC = 0;
+    TIM4->ARR = 0xFFFFu;
+    TIM4->SMCR = TIM_SMCR_TS_0 | TIM_SMCR_SMS_2 | TIM_SMCR_SMS_1 | TIM_SMCR_SMS_0;
+    TIM4->CNT = 0;
+    TIM4->CR1 = TIM_CR1_CEN;
+
+    TIM2->CNT = 0;
+    TIM2->CR1 = TIM_CR1_CEN;
+}
+
+uint32_t PDM_Timer_NowUs(void)
+{
+    uint32_t lo1, hi, lo2;
+
+    /* 低 16 位在两次读取之间没有回绕时高 16 位有效；
+     * 刚回绕的 1 us 内 TIM4 可能还没加一，也重读 */
+    do
+    {
+        lo1 = TIM2->CNT;
+        hi = TIM4->CNT;
+        lo2 = TIM2->CNT;
+    } while (lo1 == 0 || lo2 < lo1);
+
+    return hi << 16 | lo1;
+}
+
+#if PDM_CFG_ALERT_CAPTURE
+PDM_RAMFUNC void PDM_Timer_OnAlert(uint8_t n)
+{
+    uint32_t flag = (n == 0) ? TIM_SR_CC2IF : TIM_SR_CC4IF;
+    uint32_t now;
+    uint16_t lo;
+
+    if (n >= 2)
+    {
+        return;
+    }
+    /* 先读锁存值再读当前时间，边沿总在当前时间之前，差值按 16 位计算 */
+    if ((TIM2->SR & flag) == 0)
+    {
+        g_alert_miss++;
+        g_alert_us[n] = PDM_Timer_NowUs();
+        return;
+    }
+    lo = (uint16_t)((n == 0) ? TIM2->CCR2 : TIM2->CCR4);      /* 读 CCR 清除捕获标志 */
+    TIM2->SR = (uint16_t)~((n == 0) ? TIM_SR_CC2OF : TIM_SR_CC4OF);   /* 多个边沿时保留最后一个 */
+    now = PDM_Timer_NowUs();
+    g_alert_us[n] = now - (uint16_t)((uint16_t)now - lo);
+}
+
+uint32_t PDM_Timer_AlertUs(uint8_t n)
+{
+    return (n < 2) ? g_alert_us[n] : 0;
+}
+
+uint32_t PDM_Timer_AlertMiss(void)
+{
+    return g_alert_miss;
+}
+#endif /* PDM_CFG_ALERT_CAPTURE */
+
+#if PDM_CFG_SAMPLE_TIMER
+
+void PDM_Timer_StartSample(uint32_t period_ms, void (*on_sample)(uint32_t now_us))
+{
+    g_on_sample = on_sample;
+
+    __HAL_RCC_TIM3_CLK_ENABLE();
+    TIM3->CR1 = 0;
+    TIM3->PSC = tim_clock_hz() / SAMPLE_TICK_HZ - 1u;
+    PDM_Timer_SetPeriod(period_ms);
+    TIM3->EGR = TIM_EGR_UG;             /* 装入预分频值和周期 */
+    TIM3->SR = 0;                       /* UG 也会置位更新标志 */
+    TIM3->DIER = TIM_DIER_UIE;
+    TIM3->CR1 = TIM_CR1_ARPE | TIM_CR1_CEN;
+
+    HAL_NVIC_SetPriority(TIM3_IRQn, PDM_IRQ_PRIO_SAMPLE, 0);
+    HAL_NVIC_EnableIRQ(TIM3_IRQn);
+}
+
+void PDM_Timer_SetPeriod(uint32_t period_ms)
+{
+    uint32_t arr = period_ms * (SAMPLE_TICK_HZ / 1000u);
+
+    if (arr < 1u) arr = 1u;
+    if (arr > 0x10000u) arr = 0x10000u;
+    TIM3->ARR = arr - 1u;               /* ARPE：当前周期结束后生效 */
+}
+
+PDM_RAMFUNC void PDM_Timer_IRQHandler(void)
+{
+    if ((TIM3->SR & TIM_SR_UIF) != 0)
+    {
+        TIM3->SR = (uint16_t)~TIM_SR_UIF;     /* 写 0 清除，其他位写 1 不变 */
+        if (g_on_sample != NULL)
+        {
+            g_on_sample(PDM_Timer_NowUs());
+        }
+    }
+}
+
+#endif /* PDM_CFG_SAMPLE_TIMER */
+
+#endif /* PDM_TIMER_US */
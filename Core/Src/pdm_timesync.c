@@ -0,0 +1,191 @@
+#include "pdm_timesync.h"
+
+#if PDM_CFG_TIMESYNC
+
+#include "pdm_log.h"
+#include "pdm_sched.h"
+#include "stm32f1xx_hal.h"
+
+#define TYPE_SYNC           0x10u   /* 不带 CRC 的 SYNC / FUP */
+#define TYPE_FUP            0x18u
+#define DRIFT_DIV           16      /* 频差估计的一阶滤波系数 1/16 */
+#define MAX_GAP_MS          1000000u    /* 超过该时间没有同步时不再外推（接近 32 位本地微秒时间的一半），下一次同步直接跳变 */
+
+/* 基准点：本地时间 g_base_local 对应车辆时间 g_base_vehicle */
+static uint8_t g_synced;
+static uint32_t g_base_local;
+static uint64_t g_base_vehicle;
+static int32_t g_drift_ppb;
+static uint8_t g_drift_valid;
+static uint32_t g_last_ms;
+
+/* 等待 FUP 的 SYNC */
+static uint8_t g_sync_pending;
+static uint8_t g_sync_seq;
+static uint32_t g_sync_sec;
+static uint32_t g_sync_local;
+static uint32_t g_sync_ms;
+
+static pdm_tsync_stats_t g_st;
+
+static uint32_t get_be32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static void put_be32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+static uint64_t to_vehicle(uint32_t local_us)
+{
+    /* 有符号差值：比基准点稍早的采样时间戳也能换算 */
+    int32_t dt = (int32_t)(local_us - g_base_local);
+
+    return g_base_vehicle + (uint64_t)((int64_t)dt + (int64_t)dt * g_drift_ppb / 1000000000);
+}
+
+static uint8_t state_now(void)
+{
+    uint32_t age = HAL_GetTick() - g_last_ms;
+
+    if (!g_synced || age >= MAX_GAP_MS)
+    {
+        return PDM_TSYNC_NONE;
+    }
+    return (age > PDM_CFG_TIMESYNC_TIMEOUT_MS) ? PDM_TSYNC_HOLDOVER : PDM_TSYNC_SYNCED;
+}
+
+/* --- 一个同步点：本地时间 local_us 时车辆时间为 vehicle_us --- */
+static void accept(uint32_t local_us, uint64_t vehicle_us)
+{
+    uint32_t now = HAL_GetTick();
+
+    if (g_synced && now - g_last_ms < MAX_GAP_MS)
+    {
+        int64_t err = (int64_t)(vehicle_us - to_vehicle(local_us));
+        uint32_t dl = local_us - g_base_local;
+
+        if (err <= PDM_CFG_TIMESYNC_STEP_US && err >= -(int64_t)PDM_CFG_TIMESYNC_STEP_US && dl != 0)
+        {
+            uint32_t mag = (uint32_t)((err < 0) ? -err : err);
+            int64_t meas = ((int64_t)(vehicle_us - g_base_vehicle) - (int64_t)dl) * 1000000000 / dl;
+
+            g_st.last_err_us = (int32_t)err;
+            if (mag > g_st.max_err_us) g_st.max_err_us = mag;
+            /* 超出晶振可能的频差的测量值（同步点时间戳异常）不计入 */
+            if (meas <= PDM_CFG_TIMESYNC_MAX_PPM * 1000 && meas >= -PDM_CFG_TIMESYNC_MAX_PPM * 1000)
+            {
+                if (!g_drift_valid)
+                {
+                    g_drift_ppb = (int32_t)meas;
+                    g_drift_valid = 1;
+                }
+                else
+                {
+                    g_drift_ppb += ((int32_t)meas - g_drift_ppb) / DRIFT_DIV;
+                }
+            }
+            g_base_local = local_us;
+            g_base_vehicle = vehicle_us;
+            g_last_ms = now;
+            g_st.syncs++;
+            return;
+        }
+    }
+
+    g_st.last_err_us = 0;
+    g_st.steps++;
+    g_st.syncs++;
+    g_base_local = local_us;
+    g_base_vehicle = vehicle_us;
+    g_last_ms = now;
+    g_synced = 1;
+}
+
+void PDM_TimeSync_Rx(const pdm_can_frame_t *f)
+{
+    uint8_t seq;
+    uint32_t t;
+
+    if (f->dlc < 8 || (f->data[2] >> 4) != PDM_CFG_TIMESYNC_DOMAIN)
+    {
+        return;
+    }
+    seq = f->data[2] & 0x0Fu;
+    t = get_be32(&f->data[4]);
+
+    if (f->data[0] == TYPE_SYNC)
+    {
+        if (g_sync_pending)
+        {
+            g_st.rejected++;            /* 上一个 SYNC 没有等到 FUP */
+        }
+        g_sync_pending = 1;
+        g_sync_seq = seq;
+        g_sync_sec = t;
+        g_sync_local = f->t_us;
+        g_sync_ms = HAL_GetTick();
+    }
+    else if (f->data[0] == TYPE_FUP)
+    {
+        if (!g_sync_pending || seq != g_sync_seq || HAL_GetTick() - g_sync_ms > PDM_CFG_TIMESYNC_FUP_MS ||
+            t >= 1000000000u)
+        {
+            g_st.rejected++;
+            g_sync_pending = 0;
+            return;
+        }
+        g_sync_pending = 0;
+        accept(g_sync_local, ((uint64_t)g_sync_sec + (f->data[3] & 0x03u)) * 1000000u + t / 1000u);
+    }
+}
+
+uint8_t PDM_TimeSync_ToVehicle(uint32_t local_us, uint64_t *vehicle_us)
+{
+    uint8_t st = state_now();
+
+    *vehicle_us = (st != PDM_TSYNC_NONE) ? to_vehicle(local_us) : 0;
+    return st;
+}
+
+void PDM_TimeSync_Encode(uint8_t kind, uint8_t ch, uint32_t local_us, uint8_t *data)
+{
+    uint64_t v;
+    uint32_t frac;
+
+    data[1] = PDM_TimeSync_ToVehicle(local_us, &v);
+    frac = (uint32_t)(((v % 1000000u) << 16) / 1000000u);
+    data[0] = (uint8_t)(kind << 4 | ch);
+    put_be32(&data[2], (uint32_t)(v / 1000000u));
+    data[6] = (uint8_t)(frac >> 8);
+    data[7] = (uint8_t)frac;
+}
+
+void PDM_TimeSync_Get(pdm_tsync_stats_t *out)
+{
+    *out = g_st;
+    out->state = state_now();
+    out->drift_ppb = g_drift_ppb;
+    out->age_ms = g_synced ? HAL_GetTick() - g_last_ms : 0;
+}
+
+void PDM_TimeSync_Print(void)
+{
+    pdm_tsync_stats_t s;
+    uint64_t v;
+
+    PDM_TimeSync_Get(&s);
+    (void)PDM_TimeSync_ToVehicle(PDM_Sched_NowUs(), &v);
+    PDM_Log_Printf("time state %u vehicle %lu.%06lu s age %lu ms\r\n", s.state,
+                   (unsigned long)(v / 1000000u), (unsigned long)(v % 1000000u), (unsigned long)s.age_ms);
+    PDM_Log_Printf("time syncs %lu steps %lu rejected %lu err %ld us (max %lu) drift %ld ppb\r\n",
+                   (unsigned long)s.syncs, (unsigned long)s.steps, (unsigned long)s.rejected,
+                   (long)s.last_err_us, (unsigned long)s.max_err_us, (long)s.drift_ppb);
+}
+
+#endif /* PDM_CFG_TIMESYNC */
@@ -0,0 +1,438 @@
+#include "pdm_trend.h"
+
+#if PDM_CFG_TREND
+
+#include "pdm_calc.h"
+#include "pdm_log.h"
+#include "pdm_monitor.h"
+#include "pdm_pack.h"
+#include "pdm_param.h"
+#include "pdm_persist.h"
+#include "pdm_signals.h"
+#include "pdm_stats.h"
+#include "pdm_store.h"
+#include "stm32f1xx_hal.h"
+#include <stddef.h>
+#include <string.h>
+
+#if PDM_CFG_TREND_PAGES < 2
+#error "PDM_CFG_TREND_PAGES must be at least 2"
+#endif
+#if PDM_CFG_TREND_S < 1 || PDM_CFG_TREND_S > 3600
+#error "PDM_CFG_TREND_S must be 1..3600"
+#endif
+
+#if PDM_CFG_EVLOG
+#define TR_EV_PAGES         PDM_CFG_EVLOG_PAGES
+#else
+#define TR_EV_PAGES         0
+#endif
+
+/* 记录区在事件记录区之前（STM32F103C8: 64 KB flash） */
+#define TR_BASE             (FLASH_BASE + 0x10000u - (PDM_CFG_STORE_PAGES + PDM_PARAM_PAGES + TR_EV_PAGES + \
+                             PDM_CFG_TREND_PAGES) * PDM_STORE_PAGE_SIZE)
+#define TR_SIZE             ((uint32_t)PDM_CFG_TREND_PAGES * PDM_STORE_PAGE_SIZE)
+
+#define TR_MAGIC            0x5447u     /* "GT" */
+#define TR_VALUES           (PDM_CFG_CHANNELS * PDM_TREND_FIELDS)
+#define TR_MAX_BYTES        (sizeof(trend_hdr_t) + TR_VALUES * PDM_PACK_MAX_BYTES_16 + 1u + 2u)
+
+/* 每次 PDM_Trend_Run() 最多编程的半字数（每个约 50~70 us） */
+#define PROGRAM_STEP        8
+
+typedef struct {
+    uint16_t magic;
+    uint16_t len;
+    uint32_t seq;
+    uint32_t uptime_s;
+    uint16_t boots;
+    uint16_t interval_s;
+    uint8_t n;
+    uint8_t nch;
+    uint8_t nfields;
+    uint8_t reserved;
+} trend_hdr_t;
+
+_Static_assert(sizeof(trend_hdr_t) == 20, "trend group header size");
+_Static_assert(PDM_TREND_GROUP == PDM_PACK_BLOCK, "a trend group is one pack block per field");
+_Static_assert(TR_MAX_BYTES <= PDM_STORE_PAGE_SIZE, "a trend group must fit in one page");
+
+/* 程序镜像结束位置（链接脚本中的符号） */
+extern uint32_t _sidata;
+extern uint32_t _sdata;
+extern uint32_t _edata;
+
+static uint8_t g_ok;
+static uint16_t g_page;                 /* 正在写的页 */
+static uint16_t g_pos;                  /* 页中下一组的位置 */
+static uint32_t g_seq;                  /* 最新一组的序号 */
+static uint16_t g_page_n[PDM_CFG_TREND_PAGES];     /* 每页的记录数 */
+static uint16_t g_page_g[PDM_CFG_TREND_PAGES];     /* 每页的组数 */
+static int16_t g_erase_page = -1;
+static uint32_t g_erases;
+static uint32_t g_dropped;              /* 上一组还没写完时丢弃的组 */
+
+/* 还没写满一组的记录 */
+static int16_t g_raw[PDM_TREND_GROUP][TR_VALUES];
+static uint8_t g_n;
+static uint32_t g_uptime_s;
+static uint16_t g_boots;
+
+/* 正在写入的组 */
+static uint16_t g_buf[(TR_MAX_BYTES + 1u) / 2u];
+static uint16_t g_len;
+static uint8_t g_wr_pending;
+static uint16_t g_wr_pos;               /* 已编程的半字数（标志所在的第 0 个半字最后写） */
+
+/* 下载 */
+static uint16_t g_lat_first;
+static uint32_t g_lat_erases;
+
+static uint32_t page_addr(uint16_t page)
+{
+    return TR_BASE + (uint32_t)page * PDM_STORE_PAGE_SIZE;
+}
+
+static uint8_t range_erased(uint32_t addr, uint32_t len)
+{
+    const uint32_t *p = (const uint32_t *)addr;
+
+    for (uint32_t i = 0; i < (len + 3u) / 4u; i++)
+    {
+        if (p[i] != 0xFFFFFFFFu)
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* --- 一页中连续的有效组：返回第一个空位置，torn 为 1 时其后不是空白（写到一半的组） --- */
+static uint16_t scan_page(uint16_t page, uint8_t *torn)
+{
+    uint16_t pos = 0;
+
+    g_page_n[page] = 0;
+    g_page_g[page] = 0;
+    while (pos + sizeof(trend_hdr_t) <= PDM_STORE_PAGE_SIZE)
+    {
+        const trend_hdr_t *h = (const trend_hdr_t *)(page_addr(page) + pos);
+
+        if (h->magic != TR_MAGIC || h->len < sizeof(trend_hdr_t) + 2u || (h->len & 1u) != 0 ||
+            pos + h->len > PDM_STORE_PAGE_SIZE)
+        {
+            break;
+        }
+        if (g_seq == 0 || (int32_t)(h->seq - g_seq) > 0)
+        {
+            g_seq = h->seq;
+        }
+        g_page_n[page] = (uint16_t)(g_page_n[page] + h->n);
+        g_page_g[page]++;
+        pos = (uint16_t)(pos + h->len);
+    }
+    *torn = (uint8_t)(pos < PDM_STORE_PAGE_SIZE &&
+                      !range_erased(page_addr(page) + pos, PDM_STORE_PAGE_SIZE - pos));
+    return pos;
+}
+
+uint8_t PDM_Trend_Init(void)
+{
+    uint32_t image_end = (uint32_t)&_sidata + ((uint32_t)&_edata - (uint32_t)&_sdata);
+    uint32_t newest_seq = 0;
+
+    g_ok = 0;
+    if (image_end > TR_BASE)
+    {
+        return 1;
+    }
+
+    g_seq = 0;
+    g_page = 0;
+    g_pos = 0;
+    for (uint16_t p = 0; p < PDM_CFG_TREND_PAGES; p++)
+    {
+        uint8_t torn;
+        uint16_t end = scan_page(p, &torn);
+
+        /* 最新一组所在的页接着写；该页后面不是空白时换到下一页 */
+        if (g_page_g[p] != 0 && g_seq != newest_seq)
+        {
+            newest_seq = g_seq;
+            g_page = p;
+            g_pos = torn ? (uint16_t)PDM_STORE_PAGE_SIZE : end;
+        }
+    }
+    g_ok = 1;
+    return 0;
+}
+
+/* --- 为待写的组找位置：放不下（或后面不是空白）时换到下一页（最旧的一页），新的一页不是空白时先擦除 --- */
+static void place(void)
+{
+    if (g_pos + g_len > PDM_STORE_PAGE_SIZE ||
+        (g_pos != 0 && !range_erased(page_addr(g_page) + g_pos, g_len)))
+    {
+        g_page = (uint16_t)((g_page + 1u) % PDM_CFG_TREND_PAGES);
+        g_pos = 0;
+    }
+    if (g_pos == 0 && !range_erased(page_addr(g_page), PDM_STORE_PAGE_SIZE))
+    {
+        g_erase_page = (int16_t)g_page;
+    }
+    g_wr_pos = 0;
+}
+
+/* --- 把 RAM 中的记录压缩为一组，放入写入缓冲 --- */
+static void build_group(void)
+{
+    uint8_t *b = (uint8_t *)g_buf;
+    trend_hdr_t *h = (trend_hdr_t *)g_buf;
+    uint16_t pos = sizeof(trend_hdr_t);
+    pdm_pack_t pk;
+
+    for (uint8_t v = 0; v < TR_VALUES; v++)
+    {
+        uint8_t is_energy = (uint8_t)(v % PDM_TREND_FIELDS == PDM_TREND_FIELDS - 1u);
+
+        PDM_Pack_Init(&pk);
+        for (uint8_t r = 0; r < g_n; r++)
+        {
+            int16_t x = g_raw[r][v];
+
+            (void)PDM_Pack_Put(&pk, is_energy ? (uint32_t)(uint16_t)x : (uint32_t)(int32_t)x);
+        }
+        pos = (uint16_t)(pos + PDM_Pack_Flush(&pk, &b[pos]));
+    }
+    if (pos & 1u)
+    {
+        b[pos++] = 0xFF;
+    }
+
+    h->magic = TR_MAGIC;
+    h->len = (uint16_t)(pos + 2u);
+    h->seq = g_seq + 1u;
+    h->uptime_s = g_uptime_s;
+    h->boots = g_boots;
+    h->interval_s = PDM_CFG_TREND_S;
+    h->n = g_n;
+    h->nch = PDM_CFG_CHANNELS;
+    h->nfields = PDM_TREND_FIELDS;
+    h->reserved = 0xFF;
+    g_buf[pos / 2u] = pdm_calc_crc16(&b[2], pos - 2u);
+
+    g_len = h->len;
+    g_n = 0;
+    g_wr_pending = 1;
+    place();
+}
+
+void PDM_Trend_Add(const int16_t *values, uint32_t uptime_s, uint16_t boots)
+{
+    if (g_n == 0)
+    {
+        g_boots = boots;
+    }
+    memcpy(g_raw[g_n], values, sizeof(g_raw[0]));
+    g_uptime_s = uptime_s;
+    if (++g_n < PDM_TREND_GROUP)
+    {
+        return;
+    }
+    if (!g_ok || g_wr_pending)
+    {
+        g_dropped++;                    /* 上一组等擦页已经超过一组的时间 */
+        g_n = 0;
+        return;
+    }
+    build_group();
+}
+
+/* --- 编程最多 steps 个半字，写完时更新位置；返回 1 本组已写完 --- */
+static uint8_t program(uint16_t steps)
+{
+    const trend_hdr_t *h = (const trend_hdr_t *)g_buf;
+    uint32_t dst = page_addr(g_page) + g_pos;
+    uint16_t halfwords = (uint16_t)(g_len / 2u);
+    uint8_t failed = 0;
+
+    HAL_FLASH_Unlock();
+    for (uint16_t n = 0; n < steps && g_wr_pos < halfwords; n++, g_wr_pos++)
+    {
+        /* 第 1 个半字起依次写，标志（第 0 个）最后写 */
+        uint16_t i = (uint16_t)((g_wr_pos + 1u) % halfwords);
+
+        if (HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD, dst + 2u * i, g_buf[i]) != HAL_OK)
+        {
+            failed = 1;
+            break;
+        }
+    }
+    HAL_FLASH_Lock();
+
+    if (failed)
+    {
+        g_pos = PDM_STORE_PAGE_SIZE;    /* 放弃本页剩余部分，换页重写 */
+        place();
+        return 0;
+    }
+    if (g_wr_pos < halfwords)
+    {
+        return 0;
+    }
+    g_page_n[g_page] = (uint16_t)(g_page_n[g_page] + h->n);
+    g_page_g[g_page]++;
+    g_seq = h->seq;
+    g_pos = (uint16_t)(g_pos + g_len);
+    g_wr_pending = 0;
+    return 1;
+}
+
+static void erase(void)
+{
+    FLASH_EraseInitTypeDef er;
+    uint32_t err;
+
+    er.TypeErase = FLASH_TYPEERASE_PAGES;
+    er.Banks = FLASH_BANK_1;
+    er.PageAddress = page_addr((uint16_t)g_erase_page);
+    er.NbPages = 1;
+
+    HAL_FLASH_Unlock();
+    (void)HAL_FLASHEx_Erase(&er, &err);
+    HAL_FLASH_Lock();
+
+    g_page_n[g_erase_page] = 0;
+    g_page_g[g_erase_page] = 0;
+    g_erase_page = -1;
+    g_erases++;
+}
+
+void PDM_Trend_Run(uint8_t erase_ok)
+{
+    if (!g_ok || !g_wr_pending)
+    {
+        return;
+    }
+    if (g_erase_page >= 0)
+    {
+        if (erase_ok)
+        {
+            erase();                    /* 本次已占用较长时间 */
+        }
+        return;
+    }
+    (void)program(PROGRAM_STEP);
+}
+
+/* --- 每 PDM_CFG_TREND_S 秒结束各通道的趋势统计窗口，加入一条记录：平均电流、最大电流、最低电压、本段能量 --- */
+void PDM_Trend_Poll(uint32_t now)
+{
+    static uint32_t last;
+    static uint32_t last_mWh[PDM_CFG_CHANNELS];
+    static uint8_t started;
+    int16_t vals[TR_VALUES];
+    pdm_stats_result_t r;
+    pdm_channel_t c;
+    uint32_t mWh;
+
+    if (started && now - last < PDM_CFG_TREND_S * 1000u)
+    {
+        return;
+    }
+    last = now;
+    for (uint8_t i = 0; i < PDM_CFG_CHANNELS; i++)
+    {
+        int16_t *v = &vals[i * PDM_TREND_FIELDS];
+
+        PDM_Stats_Close(i, PDM_STATS_WIN_TREND, now);
+        if (PDM_Stats_Get(i, PDM_STATS_WIN_TREND, &r) == 0)
+        {
+            v[0] = pdm_calc_sat_i16(r.i_mean_uA / PDM_CAN_CURRENT_UA_PER_LSB);
+            v[1] = pdm_calc_sat_i16(r.i_max_uA / PDM_CAN_CURRENT_UA_PER_LSB);
+            v[2] = pdm_calc_sat_i16(r.v_min_mV);
+        }
+        else
+        {
+            v[0] = v[1] = v[2] = PDM_TREND_INVALID;
+        }
+
+        /* 按累计值求差，不丢失不足 1 mWh 的部分；清零后从新的累计值开始 */
+        PDM_Monitor_GetChannel(i, &c);
+        mWh = (uint32_t)(((uint64_t)c.energy_wraps * PDM_ENERGY_WRAP_UWH + c.energy_uWh) / 1000u);
+        if (!started || mWh < last_mWh[i])
+        {
+            last_mWh[i] = mWh;
+        }
+        v[3] = (int16_t)pdm_calc_sat_u16(mWh - last_mWh[i]);
+        last_mWh[i] = mWh;
+    }
+    /* 第一次调用只开始统计窗口 */
+    if (started)
+    {
+        PDM_Trend_Add(vals, PDM_Persist_UptimeS(), (uint16_t)PDM_Persist_Boots());
+    }
+    started = 1;
+}
+
+uint32_t PDM_Trend_Latch(void)
+{
+    if (!g_ok)
+    {
+        return 0;
+    }
+    if (!g_wr_pending && g_n != 0)
+    {
+        build_group();
+    }
+    /* 编程失败时换页重写，换到需要擦除的页时留给 PDM_Trend_Run() */
+    for (uint16_t t = 0; t < 2u * PDM_CFG_TREND_PAGES && g_wr_pending && g_erase_page < 0; t++)
+    {
+        (void)program(0xFFFFu);
+    }
+    g_lat_first = (uint16_t)((g_page + 1u) % PDM_CFG_TREND_PAGES);
+    g_lat_erases = g_erases;
+    return TR_SIZE;
+}
+
+uint8_t PDM_Trend_Read(uint32_t off, uint8_t *buf, uint8_t n)
+{
+    while (n > 0)
+    {
+        uint16_t page = (uint16_t)((g_lat_first + off / PDM_STORE_PAGE_SIZE) % PDM_CFG_TREND_PAGES);
+        uint32_t o = off % PDM_STORE_PAGE_SIZE;
+        uint8_t m = (uint8_t)((PDM_STORE_PAGE_SIZE - o < n) ? PDM_STORE_PAGE_SIZE - o : n);
+
+        if (off >= TR_SIZE || g_erases != g_lat_erases)
+        {
+            return 1;
+        }
+        memcpy(buf, (const uint8_t *)(page_addr(page) + o), m);
+        buf += m;
+        off += m;
+        n = (uint8_t)(n - m);
+    }
+    return 0;
+}
+
+void PDM_Trend_Print(void)
+{
+    uint32_t records = 0;
+    uint32_t groups = 0;
+    uint16_t used = 0;
+
+    for (uint16_t p = 0; p < PDM_CFG_TREND_PAGES; p++)
+    {
+        records += g_page_n[p];
+        groups += g_page_g[p];
+        used = (uint16_t)(used + (g_page_g[p] != 0));
+    }
+    PDM_Log_Printf("trend every %u s%s: %lu records (%lu min) in %lu groups, %u/%u pages\r\n",
+                   (unsigned)PDM_CFG_TREND_S, g_ok ? "" : " (flash area not usable)", (unsigned long)records,
+                   (unsigned long)(records * PDM_CFG_TREND_S / 60u), (unsigned long)groups, used,
+                   (unsigned)PDM_CFG_TREND_PAGES);
+    PDM_Log_Printf("trend page %u at %u, seq %lu, in RAM %u records%s, dropped %lu groups\r\n", g_page, g_pos,
+                   (unsigned long)g_seq, g_n, g_wr_pending ? " + 1 group writing" : "", (unsigned long)g_dropped);
+}
+
+#endif /* PDM_CFG_TREND */
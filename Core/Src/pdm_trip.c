@@ -0,0 +1,314 @@
+#include "pdm_trip.h"
+
+#if PDM_CFG_TRIP
+
+#include "pdm_blackbox.h"
+#include "pdm_can.h"
+#include "pdm_evlog.h"
+#include "pdm_log.h"
+#include "pdm_param.h"
+#include "pdm_prof.h"
+#include "pdm_protect.h"
+#include "pdm_ramfunc.h"
+#include "pdm_sched.h"
+#include "pdm_timer.h"
+#include "stm32f1xx_hal.h"
+
+#define DT_MAX_US           1000000u    /* 离线恢复后的第一个间隔等，超过 1 s 按 1 s 累计 */
+
+/* BSRR 低 16 位置 1，高 16 位清 0，一次写入 */
+#define PIN_TRIP            (PDM_CFG_TRIP_LEVEL ? (uint32_t)PDM_CFG_TRIP_PIN : (uint32_t)PDM_CFG_TRIP_PIN << 16)
+#define PIN_RELEASE         (PDM_CFG_TRIP_LEVEL ? (uint32_t)PDM_CFG_TRIP_PIN << 16 : (uint32_t)PDM_CFG_TRIP_PIN)
+
+/* 门限（寄存器单位），0 表示不检查 */
+typedef struct {
+    int32_t trim;               /* 零点修正折算的电流寄存器值 */
+    uint32_t oc_raw;
+    uint32_t nom2;              /* 额定电流寄存器值的平方 */
+    int64_t i2t_limit;          /* 电流寄存器值^2 x us */
+    uint16_t uv_raw;
+} trip_lim_t;
+
+typedef struct {
+    trip_lim_t lim;
+    int64_t acc;                /* I2t 累计值，单位同 i2t_limit */
+    volatile uint8_t cause;
+    uint8_t last_cause;         /* 最近一次切断的原因（复位后保留） */
+    uint16_t count;
+    uint32_t last_tick;
+    uint32_t react_us;
+    uint32_t react_max_us;
+    uint16_t reported;          /* 主循环已打印的次数 */
+} trip_ch_t;
+
+static trip_ch_t g_trip[PDM_CFG_CHANNELS];
+static volatile uint8_t g_active;
+
+static void send_fault(uint8_t ch, uint8_t type, uint16_t count, uint32_t now)
+{
+    uint8_t data[8];
+
+    data[0] = ch;
+    data[1] = type;
+    data[2] = (uint8_t)(count >> 8);
+    data[3] = (uint8_t)(count & 0xFF);
+    data[4] = (uint8_t)(now >> 24);
+    data[5] = (uint8_t)(now >> 16);
+    data[6] = (uint8_t)(now >> 8);
+    data[7] = (uint8_t)(now & 0xFF);
+    (void)PDM_Can_SendFromIsr(PDM_PROT_FAULT_ID, data, sizeof(data));
+}
+
+/* --- 切断：先写输出，再记录；返回 1 本次新切断，0 该通道已切断 ---
+ * 采样判断（I2C 中断）可能被 ALERT（EXTI）打断，记录部分关中断 */
+static uint8_t trip_fire(uint8_t ch, uint8_t type)
+{
+    trip_ch_t *t = &g_trip[ch];
+    uint32_t primask;
+
+    PDM_CFG_TRIP_PORT->BSRR = PIN_TRIP;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    if (t->cause != 0)
+    {
+        __set_PRIMASK(primask);
+        return 0;
+    }
+    t->cause = type;
+    t->last_cause = type;
+    t->count++;
+    g_active |= (uint8_t)(1u << ch);
+    __set_PRIMASK(primask);
+
+    t->last_tick = HAL_GetTick();
+#if PDM_CFG_BLACKBOX
+    PDM_Blackbox_Freeze(PDM_BB_REASON_FAULT);
+#endif
+#if PDM_CFG_EVLOG
+    PDM_Evlog_Add(PDM_EV_TRIP, ch, type, t->count);
+#endif
+    return 1;
+}
+
+void PDM_Trip_Init(void)
+{
+    GPIO_InitTypeDef gpio = {0};
+
+    PDM_CFG_TRIP_PORT->BSRR = PIN_RELEASE;
+    gpio.Pin = PDM_CFG_TRIP_PIN;
+    gpio.Mode = GPIO_MODE_OUTPUT_PP;
+    gpio.Pull = GPIO_NOPULL;
+    gpio.Speed = GPIO_SPEED_FREQ_HIGH;
+    HAL_GPIO_Init(PDM_CFG_TRIP_PORT, &gpio);
+}
+
+void PDM_Trip_Config(uint8_t ch, const pdm_scale_t *sc)
+{
+    const pdm_param_t *p = PDM_Param_Get();
+    uint32_t lsb = sc->current_ua_per_lsb;
+    uint32_t nom = (uint32_t)p->trip_nom_ma[ch] * 1000u / lsb;
+    trip_lim_t lim;
+    uint32_t primask;
+
+    lim.trim = ((int32_t)p->offset[ch] * (int32_t)sc->cal) >> 11;
+    lim.oc_raw = (uint32_t)p->trip_oc_ma[ch] * 1000u / lsb;
+    lim.nom2 = nom * nom;
+    /* A^2 ms -> 寄存器值^2 x us：x 1e15 / lsb^2，先乘 1e9 再除，不会溢出 */
+    lim.i2t_limit = (int64_t)((uint64_t)p->trip_i2t[ch] * 1000000000u / ((uint64_t)lsb * lsb) * 1000000u);
+    lim.uv_raw = (uint16_t)pdm_calc_bus_raw_from_mV(p->trip_uv_mv[ch]);
+    if (p->trip_oc_ma[ch] != 0 && lim.oc_raw == 0)
+    {
+        lim.oc_raw = 1;
+    }
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    g_trip[ch].lim = lim;
+    if (lim.i2t_limit == 0)
+    {
+        g_trip[ch].acc = 0;
+    }
+    __set_PRIMASK(primask);
+}
+
+PDM_RAMFUNC void PDM_Trip_Check(uint8_t ch, int16_t current, uint16_t bus, uint32_t dt_us, uint32_t ts_us)
+{
+    PDM_PROF_BEGIN(PDM_PROF_TRIP);
+    trip_ch_t *t = &g_trip[ch];
+    int32_t i = pdm_calc_sat_i16((int32_t)current - t->lim.trim);
+    uint32_t a = (uint32_t)((i < 0) ? -i : i);
+    uint8_t type = 0;
+
+    if (t->lim.i2t_limit != 0)
+    {
+        t->acc += ((int64_t)(a * a) - (int64_t)t->lim.nom2) * (int64_t)((dt_us > DT_MAX_US) ? DT_MAX_US : dt_us);
+        if (t->acc < 0)
+        {
+            t->acc = 0;
+        }
+        if (t->acc >= t->lim.i2t_limit)
+        {
+            type = PDM_PROT_I2T;
+        }
+    }
+    if (t->lim.oc_raw != 0 && a >= t->lim.oc_raw)
+    {
+        type = PDM_PROT_OVER_CURRENT;
+    }
+    if (t->lim.uv_raw != 0 && bus < t->lim.uv_raw)
+    {
+        type = PDM_PROT_UNDER_VOLT;
+    }
+    if (type == 0 || t->cause != 0 || !trip_fire(ch, type))
+    {
+        return;
+    }
+    PDM_PROF_END(PDM_PROF_TRIP);
+
+    t->react_us = PDM_Sched_NowUs() - ts_us;
+    if (t->react_us > t->react_max_us)
+    {
+        t->react_max_us = t->react_us;
+    }
+    send_fault(ch, type, t->count, t->last_tick);
+}
+
+PDM_RAMFUNC void PDM_Trip_OnRead(uint8_t ch, pdm_sensor_type_t type, const ina226_read_job_t *job,
+                                  uint32_t dt_us, uint32_t ts_us)
+{
+    pdm_sensor_sample_t smp;
+
+    PDM_PROF_BEGIN(PDM_PROF_TRIP_EVAL);
+    if (PDM_Sensor_Decode(type, job, &smp) == 0)
+    {
+        PDM_Trip_Check(ch, smp.reg.current, smp.reg.bus, dt_us, ts_us);
+    }
+    PDM_PROF_END(PDM_PROF_TRIP_EVAL);
+}
+
+void PDM_Trip_OnAlert(uint8_t ch, uint8_t type)
+{
+#if PDM_CFG_TRIP_ON_ALERT
+    PDM_PROF_BEGIN(PDM_PROF_TRIP_ALERT);
+
+    if (ch < PDM_CFG_CHANNELS && trip_fire(ch, type))
+    {
+        PDM_PROF_END(PDM_PROF_TRIP_ALERT);
+#if PDM_CFG_ALERT_CAPTURE
+        g_trip[ch].react_us = PDM_Sched_NowUs() - PDM_Timer_AlertUs(ch);   /* 边沿到输出动作，含中断响应 */
+        if (g_trip[ch].react_us > g_trip[ch].react_max_us)
+        {
+            g_trip[ch].react_max_us = g_trip[ch].react_us;
+        }
+#endif
+    }
+#else
+    (void)ch;
+    (void)type;
+#endif
+}
+
+uint8_t PDM_Trip_Reset(uint8_t mask)
+{
+    uint8_t res = 0;
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    for (uint8_t i = 0; i < PDM_CFG_CHANNELS; i++)
+    {
+        trip_ch_t *t = &g_trip[i];
+
+        if (!(mask & (1u << i)) || t->cause == 0)
+        {
+            continue;
+        }
+        if (t->cause == PDM_PROT_I2T && t->acc > t->lim.i2t_limit / 2)
+        {
+            res = 1;                    /* 还在冷却 */
+            continue;
+        }
+        t->cause = 0;
+        g_active &= (uint8_t)~(1u << i);
+    }
+    if (g_active == 0)
+    {
+        PDM_CFG_TRIP_PORT->BSRR = PIN_RELEASE;
+    }
+    __set_PRIMASK(primask);
+    return res;
+}
+
+uint8_t PDM_Trip_Active(void)
+{
+    return g_active;
+}
+
+static const char *type_name(uint8_t type)
+{
+    switch (type)
+    {
+    case PDM_PROT_BUS_OVER_POWER: return "alert over power";
+    case PDM_PROT_BAT_UNDER_VOLT: return "alert under voltage";
+    case PDM_PROT_OVER_CURRENT:   return "over current";
+    case PDM_PROT_I2T:            return "I2t";
+    case PDM_PROT_UNDER_VOLT:     return "under voltage";
+    default:                      return "-";
+    }
+}
+
+void PDM_Trip_Run(void)
+{
+    for (uint8_t i = 0; i < PDM_CFG_CHANNELS; i++)
+    {
+        trip_ch_t *t = &g_trip[i];
+        uint16_t count = t->count;
+
+        if (count != t->reported)
+        {
+            t->reported = count;
+            PDM_Log_Printf("TRIP #%u %s (%u)\r\n", i, type_name(t->last_cause), count);
+        }
+    }
+}
+
+void PDM_Trip_GetStat(uint8_t ch, pdm_trip_stat_t *st)
+{
+    const trip_ch_t *t = &g_trip[ch];
+    uint32_t primask = __get_PRIMASK();
+    int64_t acc, limit;
+
+    __disable_irq();
+    st->cause = t->cause;
+    st->count = t->count;
+    st->last_tick = t->last_tick;
+    st->react_us = t->react_us;
+    st->react_max_us = t->react_max_us;
+    acc = t->acc;
+    limit = t->lim.i2t_limit;
+    __set_PRIMASK(primask);
+
+    st->i2t_pct = (uint8_t)((limit == 0) ? 0 : (acc >= limit) ? 100 : acc * 100 / limit);
+}
+
+void PDM_Trip_Print(void)
+{
+    const pdm_param_t *p = PDM_Param_Get();
+
+    PDM_Log_Printf("trip output %s, channels 0x%02X\r\n", g_active ? "OPEN" : "on", g_active);
+#if PDM_CFG_ALERT_CAPTURE
+    PDM_Log_Printf("alert capture: %lu edges without capture\r\n", (unsigned long)PDM_Timer_AlertMiss());
+#endif
+    for (uint8_t i = 0; i < PDM_CFG_CHANNELS; i++)
+    {
+        pdm_trip_stat_t st;
+
+        PDM_Trip_GetStat(i, &st);
+        PDM_Log_Printf("trip %u oc %u mA nom %u mA i2t %lu A2ms (%u%%) uv %u mV: %s, count %u, react %lu/%lu us\r\n",
+                       i, p->trip_oc_ma[i], p->trip_nom_ma[i], (unsigned long)p->trip_i2t[i], st.i2t_pct,
+                       p->trip_uv_mv[i], type_name(st.cause), st.count, (unsigned long)st.react_us,
+                       (unsigned long)st.react_max_us);
+    }
+}
+
+#endif /* PDM_CFG_TRIP */
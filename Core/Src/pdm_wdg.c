@@ -0,0 +1,117 @@
+#include "pdm_wdg.h"
+#include "pdm_log.h"
+#include "stm32f1xx_hal.h"
+
+/* IWDG 使用 LSI（约 40 kHz，实际 30~60 kHz），分频 64 后每个计数约 1.6 ms */
+#define IWDG_KEY_RELOAD     0xAAAAu
+#define IWDG_KEY_ENABLE     0xCCCCu
+#define IWDG_KEY_ACCESS     0x5555u
+#define IWDG_PRESCALER_64   4u
+#define IWDG_LSI_HZ         40000u
+
+typedef struct {
+    const char *name;
+    uint32_t deadline_ms;
+    volatile uint32_t last_tick;
+} wdg_slot_t;
+
+static wdg_slot_t g_wdg_slots[PDM_WDG_MAX_SLOTS];
+static uint8_t g_wdg_count;
+static uint8_t g_wdg_started;
+static uint8_t g_wdg_reported;      /* 已打印过超时的任务，避免重复打印 */
+
+static uint8_t g_reset_cause;
+static uint8_t g_reset_read;
+
+uint8_t PDM_Wdg_ResetCause(void)
+{
+    if (!g_reset_read)
+    {
+        uint32_t csr = RCC->CSR;
+
+        if (csr & RCC_CSR_PORRSTF)  g_reset_cause |= PDM_RESET_POR;
+        if (csr & RCC_CSR_PINRSTF)  g_reset_cause |= PDM_RESET_PIN;
+        if (csr & RCC_CSR_SFTRSTF)  g_reset_cause |= PDM_RESET_SOFT;
+        if (csr & RCC_CSR_IWDGRSTF) g_reset_cause |= PDM_RESET_IWDG;
+        if (csr & RCC_CSR_WWDGRSTF) g_reset_cause |= PDM_RESET_WWDG;
+        if (csr & RCC_CSR_LPWRRSTF) g_reset_cause |= PDM_RESET_LPWR;
+
+        RCC->CSR |= RCC_CSR_RMVF;
+        g_reset_read = 1;
+    }
+    return g_reset_cause;
+}
+
+uint8_t PDM_Wdg_Register(const char *name, uint32_t deadline_ms)
+{
+    uint8_t slot = g_wdg_count;
+
+    if (slot >= PDM_WDG_MAX_SLOTS)
+    {
+        return PDM_WDG_MAX_SLOTS - 1;       /* 表满，和最后一个共用 */
+    }
+    g_wdg_slots[slot].name = name;
+    g_wdg_slots[slot].deadline_ms = deadline_ms;
+    g_wdg_slots[slot].last_tick = HAL_GetTick();
+    g_wdg_count++;
+    return slot;
+}
+
+void PDM_Wdg_CheckIn(uint8_t slot)
+{
+    if (slot < g_wdg_count)
+    {
+        g_wdg_slots[slot].last_tick = HAL_GetTick();
+    }
+}
+
+void PDM_Wdg_Start(void)
+{
+#if PDM_CFG_WDG
+    uint32_t reload = PDM_CFG_WDG_TIMEOUT_MS * (IWDG_LSI_HZ / 1000u) / 64u;
+
+    if (reload > 0xFFFu)
+    {
+        reload = 0xFFFu;
+    }
+
+    /* 调试器暂停内核时看门狗也暂停 */
+    DBGMCU->CR |= DBGMCU_CR_DBG_IWDG_STOP;
+
+    IWDG->KR = IWDG_KEY_ENABLE;
+    IWDG->KR = IWDG_KEY_ACCESS;
+    IWDG->PR = IWDG_PRESCALER_64;
+    IWDG->RLR = reload;
+    while (IWDG->SR != 0) { }
+    IWDG->KR = IWDG_KEY_RELOAD;
+
+    /* 慢任务启动前的等待不算超时 */
+    for (uint8_t i = 0; i < g_wdg_count; i++)
+    {
+        g_wdg_slots[i].last_tick = HAL_GetTick();
+    }
+    g_wdg_started = 1;
+#endif
+}
+
+void PDM_Wdg_Run(uint32_t now)
+{
+    for (uint8_t i = 0; i < g_wdg_count; i++)
+    {
+        if (now - g_wdg_slots[i].last_tick > g_wdg_slots[i].deadline_ms)
+        {
+            if (!(g_wdg_reported & (1u << i)))
+            {
+                g_wdg_reported |= (uint8_t)(1u << i);
+                PDM_Log_Printf("WDG: %s missed deadline\r\n", g_wdg_slots[i].name);
+            }
+            return;                         /* 不喂狗 */
+        }
+    }
+
+    g_wdg_reported = 0;
+    if (g_wdg_started)
+    {
+        IWDG->KR = IWDG_KEY_RELOAD;
+    }
+}
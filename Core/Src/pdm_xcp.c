@@ -0,0 +1,504 @@
+#include "pdm_xcp.h"
+
+#if PDM_CFG_XCP
+
+#include "pdm_can.h"
+#include "stm32f1xx_hal.h"
+#include <string.h>
+
+/* STM32F103C8: 64 KB flash, 20 KB SRAM */
+#define XCP_FLASH_END       (FLASH_BASE + 0x10000u)
+#define XCP_SRAM_END        (SRAM_BASE + 0x5000u)
+
+#define XCP_MAX_CTO         8u
+#define XCP_ODT_ENTRIES     7u          /* 每个 ODT 最多 7 字节数据，条目数也不超过 7 */
+#define XCP_ODT_BYTES       7u
+
+#if PDM_CFG_XCP_DAQ_LISTS * PDM_CFG_XCP_ODTS > 0xFC
+#error "PDM_CFG_XCP_DAQ_LISTS x PDM_CFG_XCP_ODTS must not exceed 0xFC (absolute ODT PIDs)"
+#endif
+
+/* 命令码 */
+#define CMD_CONNECT                 0xFF
+#define CMD_DISCONNECT              0xFE
+#define CMD_GET_STATUS              0xFD
+#define CMD_SYNCH                   0xFC
+#define CMD_GET_COMM_MODE_INFO      0xFB
+#define CMD_GET_ID                  0xFA
+#define CMD_SET_MTA                 0xF6
+#define CMD_UPLOAD                  0xF5
+#define CMD_SHORT_UPLOAD            0xF4
+#define CMD_CLEAR_DAQ_LIST          0xE3
+#define CMD_SET_DAQ_PTR             0xE2
+#define CMD_WRITE_DAQ               0xE1
+#define CMD_SET_DAQ_LIST_MODE       0xE0
+#define CMD_GET_DAQ_LIST_MODE       0xDF
+#define CMD_START_STOP_DAQ_LIST     0xDE
+#define CMD_START_STOP_SYNCH        0xDD
+#define CMD_GET_DAQ_PROCESSOR_INFO  0xDA
+#define CMD_GET_DAQ_RESOLUTION_INFO 0xD9
+#define CMD_GET_DAQ_LIST_INFO       0xD8
+#define CMD_GET_DAQ_EVENT_INFO      0xD7
+
+/* 回复 PID 和错误码 */
+#define RES_OK                      0xFF
+#define RES_ERR                     0xFE
+#define ERR_CMD_SYNCH               0x00
+#define ERR_DAQ_ACTIVE              0x1A
+#define ERR_CMD_UNKNOWN             0x20
+#define ERR_CMD_SYNTAX              0x21
+#define ERR_OUT_OF_RANGE            0x22
+#define ERR_ACCESS_DENIED           0x24
+#define ERR_MODE_NOT_VALID          0x27
+
+/* SESSION_STATUS / DAQ 列表模式 */
+#define SESSION_DAQ_RUNNING         0x40
+#define DAQ_MODE_SELECTED           0x01
+#define DAQ_MODE_DIRECTION          0x02    /* STIM，不支持 */
+#define DAQ_MODE_TIMESTAMP          0x10    /* 不支持 */
+#define DAQ_MODE_PID_OFF            0x20    /* 不支持 */
+#define DAQ_MODE_RUNNING            0x40
+
+typedef struct {
+    uint32_t addr;
+    uint8_t size;               /* 0 表示未使用 */
+} odt_entry_t;
+
+typedef struct {
+    odt_entry_t entry[PDM_CFG_XCP_ODTS][XCP_ODT_ENTRIES];
+    uint16_t event;
+    uint8_t prescaler;
+    uint8_t count;
+    uint8_t mode;               /* DAQ_MODE_SELECTED | DAQ_MODE_RUNNING */
+} daq_list_t;
+
+static const char g_event_name[] = "sample";
+
+static uint8_t g_connected;
+static uint32_t g_mta;
+static daq_list_t g_daq[PDM_CFG_XCP_DAQ_LISTS];
+static uint8_t g_ptr_daq, g_ptr_odt, g_ptr_entry;
+
+static uint16_t get_u16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (uint16_t)p[1] << 8);
+}
+
+static uint32_t get_u32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+/* --- 只允许读 SRAM 和 flash，外设寄存器读取可能清除标志 --- */
+static uint8_t addr_ok(uint32_t addr, uint32_t len)
+{
+    return (addr >= SRAM_BASE && addr <= XCP_SRAM_END && len <= XCP_SRAM_END - addr) ||
+           (addr >= FLASH_BASE && addr <= XCP_FLASH_END && len <= XCP_FLASH_END - addr);
+}
+
+static void send(const uint8_t *data, uint8_t len)
+{
+    (void)PDM_Can_Send(PDM_CFG_XCP_TX_ID, data, len);
+}
+
+static void send_err(uint8_t code)
+{
+    uint8_t res[2] = { RES_ERR, code };
+
+    send(res, sizeof(res));
+}
+
+static uint8_t daq_running(void)
+{
+    for (uint8_t i = 0; i < PDM_CFG_XCP_DAQ_LISTS; i++)
+    {
+        if (g_daq[i].mode & DAQ_MODE_RUNNING)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void daq_reset(void)
+{
+    memset(g_daq, 0, sizeof(g_daq));
+    for (uint8_t i = 0; i < PDM_CFG_XCP_DAQ_LISTS; i++)
+    {
+        g_daq[i].prescaler = 1;
+    }
+    g_ptr_daq = 0;
+    g_ptr_odt = 0;
+    g_ptr_entry = 0;
+}
+
+/* --- 读取 n 字节到回复帧，MTA 后移；返回 0 成功，否则为错误码 --- */
+static uint8_t upload(uint8_t *res, uint8_t n)
+{
+    if (n == 0 || n > XCP_MAX_CTO - 1u)
+    {
+        return ERR_OUT_OF_RANGE;
+    }
+    if (!addr_ok(g_mta, n))
+    {
+        return ERR_ACCESS_DENIED;
+    }
+    memcpy(&res[1], (const void *)g_mta, n);
+    g_mta += n;
+    return 0;
+}
+
+static uint8_t write_daq(const uint8_t *d)
+{
+    daq_list_t *dl = &g_daq[g_ptr_daq];
+    uint8_t size = d[2];
+    uint32_t addr = get_u32(&d[4]);
+    uint8_t used = 0;
+
+    if (dl->mode & DAQ_MODE_RUNNING)
+    {
+        return ERR_DAQ_ACTIVE;
+    }
+    if (g_ptr_entry >= XCP_ODT_ENTRIES)
+    {
+        return ERR_OUT_OF_RANGE;
+    }
+    if (d[1] != 0xFF || d[3] != 0)              /* 不支持位偏移和地址扩展 */
+    {
+        return ERR_OUT_OF_RANGE;
+    }
+    for (uint8_t i = 0; i < XCP_ODT_ENTRIES; i++)
+    {
+        if (i != g_ptr_entry)
+        {
+            used = (uint8_t)(used + dl->entry[g_ptr_odt][i].size);
+        }
+    }
+    if (size == 0 || used + size > XCP_ODT_BYTES)
+    {
+        return ERR_OUT_OF_RANGE;
+    }
+    if (!addr_ok(addr, size))
+    {
+        return ERR_ACCESS_DENIED;
+    }
+    dl->entry[g_ptr_odt][g_ptr_entry].addr = addr;
+    dl->entry[g_ptr_odt][g_ptr_entry].size = size;
+    g_ptr_entry++;                              /* 连续写入时自动指向下一个条目 */
+    return 0;
+}
+
+void PDM_Xcp_Rx(const uint8_t *d, uint8_t dlc)
+{
+    uint8_t res[8] = { RES_OK };
+    uint8_t len = 1;
+    uint8_t err = 0;
+
+    if (dlc == 0)
+    {
+        return;
+    }
+    if (!g_connected && d[0] != CMD_CONNECT)
+    {
+        return;                                 /* 未连接时只响应 CONNECT */
+    }
+
+    switch (d[0])
+    {
+    case CMD_CONNECT:
+        if (!g_connected)
+        {
+            daq_reset();
+            g_connected = 1;
+        }
+        res[1] = 0x04;                          /* RESOURCE: DAQ */
+        res[2] = 0x80;                          /* COMM_MODE_BASIC: Intel，字节粒度，支持 GET_COMM_MODE_INFO */
+        res[3] = XCP_MAX_CTO;
+        res[4] = 8;                             /* MAX_DTO */
+        res[5] = 0;
+        res[6] = 0x01;                          /* 协议层版本 */
+        res[7] = 0x01;                          /* 传输层版本 */
+        len = 8;
+        break;
+
+    case CMD_DISCONNECT:
+        daq_reset();
+        g_connected = 0;
+        break;
+
+    case CMD_GET_STATUS:
+        res[1] = daq_running() ? SESSION_DAQ_RUNNING : 0;
+        len = 6;
+        break;
+
+    case CMD_SYNCH:
+        err = ERR_CMD_SYNCH;
+        break;
+
+    case CMD_GET_COMM_MODE_INFO:
+        res[7] = 0x10;                          /* 驱动版本 1.0，不支持块传输和交错模式 */
+        len = 8;
+        break;
+
+    case CMD_GET_ID:
+        len = 8;                                /* 长度 0：没有 A2L 名称 */
+        break;
+
+    case CMD_SET_MTA:
+        if (dlc < 8)
+        {
+            err = ERR_CMD_SYNTAX;
+        }
+        else if (d[3] != 0)
+        {
+            err = ERR_OUT_OF_RANGE;
+        }
+        else
+        {
+            g_mta = get_u32(&d[4]);
+        }
+        break;
+
+    case CMD_UPLOAD:
+        if (dlc < 2)
+        {
+            err = ERR_CMD_SYNTAX;
+            break;
+        }
+        err = upload(res, d[1]);
+        len = (uint8_t)(1u + d[1]);
+        break;
+
+    case CMD_SHORT_UPLOAD:
+        if (dlc < 8)
+        {
+            err = ERR_CMD_SYNTAX;
+            break;
+        }
+        if (d[3] != 0)
+        {
+            err = ERR_OUT_OF_RANGE;
+            break;
+        }
+        g_mta = get_u32(&d[4]);
+        err = upload(res, d[1]);
+        len = (uint8_t)(1u + d[1]);
+        break;
+
+    case CMD_CLEAR_DAQ_LIST:
+    case CMD_SET_DAQ_PTR:
+    case CMD_SET_DAQ_LIST_MODE:
+    case CMD_GET_DAQ_LIST_MODE:
+    case CMD_GET_DAQ_LIST_INFO:
+    {
+        uint16_t n = (dlc >= 4) ? get_u16(&d[2]) : 0xFFFFu;
+        daq_list_t *dl;
+
+        if (n >= PDM_CFG_XCP_DAQ_LISTS)
+        {
+            err = ERR_OUT_OF_RANGE;
+            break;
+        }
+        dl = &g_daq[n];
+        if (d[0] == CMD_CLEAR_DAQ_LIST)
+        {
+            if (dl->mode & DAQ_MODE_RUNNING)
+            {
+                err = ERR_DAQ_ACTIVE;
+                break;
+            }
+            memset(dl->entry, 0, sizeof(dl->entry));
+        }
+        else if (d[0] == CMD_SET_DAQ_PTR)
+        {
+            if (dlc < 6 || d[4] >= PDM_CFG_XCP_ODTS || d[5] >= XCP_ODT_ENTRIES)
+            {
+                err = ERR_OUT_OF_RANGE;
+                break;
+            }
+            g_ptr_daq = (uint8_t)n;
+            g_ptr_odt = d[4];
+            g_ptr_entry = d[5];
+        }
+        else if (d[0] == CMD_SET_DAQ_LIST_MODE)
+        {
+            if (dlc < 8 || get_u16(&d[4]) >= PDM_XCP_EVENTS || d[6] == 0)
+            {
+                err = ERR_OUT_OF_RANGE;
+                break;
+            }
+            if (d[1] & (DAQ_MODE_DIRECTION | DAQ_MODE_TIMESTAMP | DAQ_MODE_PID_OFF))
+            {
+                err = ERR_MODE_NOT_VALID;
+                break;
+            }
+            if (dl->mode & DAQ_MODE_RUNNING)
+            {
+                err = ERR_DAQ_ACTIVE;
+                break;
+            }
+            dl->event = get_u16(&d[4]);
+            dl->prescaler = d[6];
+            dl->count = 0;
+        }
+        else if (d[0] == CMD_GET_DAQ_LIST_MODE)
+        {
+            res[1] = dl->mode;
+            res[4] = (uint8_t)(dl->event & 0xFF);
+            res[5] = (uint8_t)(dl->event >> 8);
+            res[6] = dl->prescaler;
+            len = 8;
+        }
+        else
+        {
+            res[1] = 0x04;                      /* DAQ_LIST_PROPERTIES: 只有 DAQ 方向 */
+            res[2] = PDM_CFG_XCP_ODTS;
+            res[3] = XCP_ODT_ENTRIES;
+            len = 6;
+        }
+        break;
+    }
+
+    case CMD_WRITE_DAQ:
+        err = (dlc < 8) ? ERR_CMD_SYNTAX : write_daq(d);
+        break;
+
+    case CMD_START_STOP_DAQ_LIST:
+    {
+        uint16_t n = (dlc >= 4) ? get_u16(&d[2]) : 0xFFFFu;
+
+        if (n >= PDM_CFG_XCP_DAQ_LISTS || d[1] > 2)
+        {
+            err = ERR_OUT_OF_RANGE;
+            break;
+        }
+        if (d[1] == 0)
+        {
+            g_daq[n].mode &= (uint8_t)~DAQ_MODE_RUNNING;
+        }
+        else if (d[1] == 1)
+        {
+            g_daq[n].mode |= DAQ_MODE_RUNNING;
+            g_daq[n].count = 0;
+        }
+        else
+        {
+            g_daq[n].mode |= DAQ_MODE_SELECTED;
+        }
+        res[1] = (uint8_t)(n * PDM_CFG_XCP_ODTS);     /* FIRST_PID */
+        len = 2;
+        break;
+    }
+
+    case CMD_START_STOP_SYNCH:
+        if (dlc < 2 || d[1] > 2)
+        {
+            err = ERR_MODE_NOT_VALID;
+            break;
+        }
+        for (uint8_t i = 0; i < PDM_CFG_XCP_DAQ_LISTS; i++)
+        {
+            daq_list_t *dl = &g_daq[i];
+
+            if (d[1] == 0)
+            {
+                dl->mode = 0;
+            }
+            else if (dl->mode & DAQ_MODE_SELECTED)
+            {
+                dl->mode = (d[1] == 1) ? DAQ_MODE_RUNNING : 0;
+                dl->count = 0;
+            }
+        }
+        break;
+
+    case CMD_GET_DAQ_PROCESSOR_INFO:
+        res[1] = 0x02;                          /* 静态配置，支持分频 */
+        res[2] = PDM_CFG_XCP_DAQ_LISTS;
+        res[4] = PDM_XCP_EVENTS;
+        len = 8;                                /* MIN_DAQ 0，DAQ_KEY_BYTE 0：绝对 ODT 号 */
+        break;
+
+    case CMD_GET_DAQ_RESOLUTION_INFO:
+        res[1] = 1;                             /* ODT 条目粒度 1 字节 */
+        res[2] = XCP_ODT_BYTES;
+        len = 8;                                /* 没有 STIM 和时间戳 */
+        break;
+
+    case CMD_GET_DAQ_EVENT_INFO:
+        if (dlc < 4 || get_u16(&d[2]) >= PDM_XCP_EVENTS)
+        {
+            err = ERR_OUT_OF_RANGE;
+            break;
+        }
+        res[1] = 0x04;                          /* 只有 DAQ */
+        res[2] = 0xFF;                          /* 不限列表数 */
+        res[3] = (uint8_t)(sizeof(g_event_name) - 1u);
+        res[4] = 0;                             /* 非固定周期（跟随采样周期） */
+        g_mta = (uint32_t)g_event_name;         /* 名称由 UPLOAD 读出 */
+        len = 7;
+        break;
+
+    default:
+        err = ERR_CMD_UNKNOWN;
+        break;
+    }
+
+    if (err != 0 || (d[0] == CMD_SYNCH))
+    {
+        send_err(err);
+    }
+    else
+    {
+        send(res, len);
+    }
+}
+
+void PDM_Xcp_Event(uint8_t event)
+{
+    uint8_t dto[8];
+
+    if (!g_connected)
+    {
+        return;
+    }
+    for (uint8_t i = 0; i < PDM_CFG_XCP_DAQ_LISTS; i++)
+    {
+        daq_list_t *dl = &g_daq[i];
+
+        if (!(dl->mode & DAQ_MODE_RUNNING) || dl->event != event)
+        {
+            continue;
+        }
+        if (++dl->count < dl->prescaler)
+        {
+            continue;
+        }
+        dl->count = 0;
+
+        /* 按顺序发送各 ODT，遇到没有条目的 ODT 结束 */
+        for (uint8_t o = 0; o < PDM_CFG_XCP_ODTS; o++)
+        {
+            uint8_t n = 1;
+
+            dto[0] = (uint8_t)(i * PDM_CFG_XCP_ODTS + o);
+            for (uint8_t e = 0; e < XCP_ODT_ENTRIES; e++)
+            {
+                const odt_entry_t *en = &dl->entry[o][e];
+
+                if (en->size != 0)
+                {
+                    memcpy(&dto[n], (const void *)en->addr, en->size);
+                    n = (uint8_t)(n + en->size);
+                }
+            }
+            if (n == 1)
+            {
+                break;
+            }
+            send(dto, n);
+        }
+    }
+}
+
+#endif /* PDM_CFG_XCP */
@@ -22,7 +22,14 @@
 #include "stm32f1xx_it.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
-#include "pdm_monitor.h"
+#include "pdm_alert.h"
+#include "pdm_capture.h"
+#include "pdm_prof.h"
+#include "pdm_timer.h"
+#include "pdm_rtos.h"
+#include "pdm_crash.h"
+#include "ina226_async.h"
+#include "can.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -47,6 +54,10 @@
 
 /* Private function prototypes -----------------------------------------------*/
 /* USER CODE BEGIN PFP */
+#if PDM_CFG_CRASH
+/* 不生成入栈代码，栈帧地址由下面的汇编按 EXC_RETURN 取得 */
+void HardFault_Handler(void) __attribute__((naked));
+#endif
 
 /* USER CODE END PFP */
 
@@ -59,7 +70,11 @@
 extern CAN_HandleTypeDef hcan;
 extern I2C_HandleTypeDef hi2c1;
 /* USER CODE BEGIN EV */
-
+extern UART_HandleTypeDef huart1;
+extern DMA_HandleTypeDef hdma_usart1_tx;
+#if PDM_CFG_SHELL
+extern DMA_HandleTypeDef hdma_usart1_rx;
+#endif
 /* USER CODE END EV */
 
 /******************************************************************************/
@@ -75,6 +90,9 @@ void NMI_Handler(void)
   /* USER CODE END NonMaskableInt_IRQn 0 */
   HAL_RCC_NMI_IRQHandler();
   /* USER CODE BEGIN NonMaskableInt_IRQn 1 */
+#if PDM_CFG_CRASH
+  PDM_Crash_Error(PDM_CRASH_NMI, 0);
+#endif
    while (1)
   {
   }
@@ -87,7 +105,15 @@ void NMI_Handler(void)
 void HardFault_Handler(void)
 {
   /* USER CODE BEGIN HardFault_IRQn 0 */
-
+#if PDM_CFG_CRASH
+  __asm volatile(
+      "tst lr, #4            \n"
+      "ite eq                \n"
+      "mrseq r0, msp         \n"
+      "mrsne r0, psp         \n"
+      "mov r1, lr            \n"
+      "b PDM_Crash_Fault     \n");
+#endif
   /* USER CODE END HardFault_IRQn 0 */
   while (1)
   {
@@ -190,6 +216,12 @@ void SysTick_Handler(void)
   /* USER CODE END SysTick_IRQn 0 */
   HAL_IncTick();
   /* USER CODE BEGIN SysTick_IRQn 1 */
+#if PDM_CFG_RTOS
+  PDM_Rtos_Tick();
+#endif
+#if PDM_CFG_CAPTURE && PDM_CFG_CAPTURE_BOOT
+  PDM_Capture_Tick();       // 上电采集在阻塞读写期间停下，总线释放后在这里继续
+#endif
 
   /* USER CODE END SysTick_IRQn 1 */
 }
@@ -207,11 +239,11 @@ void SysTick_Handler(void)
 void EXTI1_IRQHandler(void)
 {
   /* USER CODE BEGIN EXTI1_IRQn 0 */
-
+  PDM_PROF_BEGIN(PDM_PROF_IRQ_FAULT);
   /* USER CODE END EXTI1_IRQn 0 */
   HAL_GPIO_EXTI_IRQHandler(ALERT1_Pin);
   /* USER CODE BEGIN EXTI1_IRQn 1 */
-
+  PDM_PROF_END(PDM_PROF_IRQ_FAULT);
   /* USER CODE END EXTI1_IRQn 1 */
 }
 
@@ -221,11 +253,11 @@ void EXTI1_IRQHandler(void)
 void EXTI3_IRQHandler(void)
 {
   /* USER CODE BEGIN EXTI3_IRQn 0 */
-
+  PDM_PROF_BEGIN(PDM_PROF_IRQ_FAULT);
   /* USER CODE END EXTI3_IRQn 0 */
   HAL_GPIO_EXTI_IRQHandler(ALERT2_Pin);
   /* USER CODE BEGIN EXTI3_IRQn 1 */
-
+  PDM_PROF_END(PDM_PROF_IRQ_FAULT);
   /* USER CODE END EXTI3_IRQn 1 */
 }
 
@@ -235,11 +267,11 @@ void EXTI3_IRQHandler(void)
 void USB_LP_CAN1_RX0_IRQHandler(void)
 {
   /* USER CODE BEGIN USB_LP_CAN1_RX0_IRQn 0 */
-
+  PDM_PROF_BEGIN(PDM_PROF_IRQ_CAN);
   /* USER CODE END USB_LP_CAN1_RX0_IRQn 0 */
   HAL_CAN_IRQHandler(&hcan);
   /* USER CODE BEGIN USB_LP_CAN1_RX0_IRQn 1 */
-
+  PDM_PROF_END(PDM_PROF_IRQ_CAN);
   /* USER CODE END USB_LP_CAN1_RX0_IRQn 1 */
 }
 
@@ -249,11 +281,16 @@ void USB_LP_CAN1_RX0_IRQHandler(void)
 void I2C1_EV_IRQHandler(void)
 {
   /* USER CODE BEGIN I2C1_EV_IRQn 0 */
-
+  PDM_PROF_BEGIN(PDM_PROF_IRQ_I2C);
+#if PDM_CFG_I2C_LL
+  ina226_interface_i2c_ev_irq(0);   // 2 字节读取由接口层的寄存器级流程处理，其余交给 HAL
+  PDM_PROF_END(PDM_PROF_IRQ_I2C);
+  return;
+#endif
   /* USER CODE END I2C1_EV_IRQn 0 */
   HAL_I2C_EV_IRQHandler(&hi2c1);
   /* USER CODE BEGIN I2C1_EV_IRQn 1 */
-
+  PDM_PROF_END(PDM_PROF_IRQ_I2C);
   /* USER CODE END I2C1_EV_IRQn 1 */
 }
 
@@ -263,24 +300,127 @@ void I2C1_EV_IRQHandler(void)
 void I2C1_ER_IRQHandler(void)
 {
   /* USER CODE BEGIN I2C1_ER_IRQn 0 */
-
+  PDM_PROF_BEGIN(PDM_PROF_IRQ_I2C);
+#if PDM_CFG_I2C_LL
+  ina226_interface_i2c_er_irq(0);
+  PDM_PROF_END(PDM_PROF_IRQ_I2C);
+  return;
+#endif
   /* USER CODE END I2C1_ER_IRQn 0 */
   HAL_I2C_ER_IRQHandler(&hi2c1);
   /* USER CODE BEGIN I2C1_ER_IRQn 1 */
-
+  PDM_PROF_END(PDM_PROF_IRQ_I2C);
   /* USER CODE END I2C1_ER_IRQn 1 */
 }
 
 /* USER CODE BEGIN 1 */
+/**
+  * @brief This function handles DMA1 channel4 global interrupt (USART1_TX).
+  */
+void DMA1_Channel4_IRQHandler(void)
+{
+  PDM_PROF_BEGIN(PDM_PROF_IRQ_UART);
+  HAL_DMA_IRQHandler(&hdma_usart1_tx);
+  PDM_PROF_END(PDM_PROF_IRQ_UART);
+}
+
+/**
+  * @brief This function handles USART1 global interrupt.
+  */
+void USART1_IRQHandler(void)
+{
+  PDM_PROF_BEGIN(PDM_PROF_IRQ_UART);
+  HAL_UART_IRQHandler(&huart1);
+  PDM_PROF_END(PDM_PROF_IRQ_UART);
+}
+
+/**
+  * @brief This function handles PVD interrupt through EXTI line 16.
+  */
+void PVD_IRQHandler(void)
+{
+  PDM_PROF_BEGIN(PDM_PROF_IRQ_FAULT);
+  HAL_PWR_PVD_IRQHandler();
+  PDM_PROF_END(PDM_PROF_IRQ_FAULT);
+}
+
+/**
+  * @brief This function handles USB high priority or CAN TX interrupts.
+  */
+void USB_HP_CAN1_TX_IRQHandler(void)
+{
+  PDM_PROF_BEGIN(PDM_PROF_IRQ_CAN);
+  HAL_CAN_IRQHandler(&hcan);
+  PDM_PROF_END(PDM_PROF_IRQ_CAN);
+}
+
+#if PDM_CFG_CANH
+/**
+  * @brief This function handles CAN1 SCE interrupt (error and status change).
+  */
+void CAN1_SCE_IRQHandler(void)
+{
+  PDM_PROF_BEGIN(PDM_PROF_IRQ_CAN);
+  HAL_CAN_IRQHandler(&hcan);
+  PDM_PROF_END(PDM_PROF_IRQ_CAN);
+}
+#endif
+
+#if PDM_CFG_SHELL
+/**
+  * @brief This function handles DMA1 channel5 global interrupt (USART1_RX).
+  */
+void DMA1_Channel5_IRQHandler(void)
+{
+  PDM_PROF_BEGIN(PDM_PROF_IRQ_UART);
+  HAL_DMA_IRQHandler(&hdma_usart1_rx);
+  PDM_PROF_END(PDM_PROF_IRQ_UART);
+}
+#endif
+
+#if PDM_CFG_I2C2
+/**
+  * @brief This function handles I2C2 event interrupt.
+  */
+void I2C2_EV_IRQHandler(void)
+{
+  PDM_PROF_BEGIN(PDM_PROF_IRQ_I2C);
+  ina226_interface_i2c_ev_irq(1);
+  PDM_PROF_END(PDM_PROF_IRQ_I2C);
+}
+
+/**
+  * @brief This function handles I2C2 error interrupt.
+  */
+void I2C2_ER_IRQHandler(void)
+{
+  PDM_PROF_BEGIN(PDM_PROF_IRQ_I2C);
+  ina226_interface_i2c_er_irq(1);
+  PDM_PROF_END(PDM_PROF_IRQ_I2C);
+}
+#endif
+
+#if PDM_CFG_SAMPLE_TIMER
+/**
+  * @brief This function handles TIM3 global interrupt (sample clock).
+  */
+void TIM3_IRQHandler(void)
+{
+  PDM_PROF_BEGIN(PDM_PROF_IRQ_SAMPLE);
+  PDM_Timer_IRQHandler();
+  PDM_PROF_END(PDM_PROF_IRQ_SAMPLE);
+}
+#endif
+
 void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
 {
     if (GPIO_Pin == ALERT1_Pin)
     {
-        g_alert1_flag = 1;
+        PDM_Alert_OnEdge(0);
     }
     if (GPIO_Pin == ALERT2_Pin)
     {
-        g_alert2_flag = 1;
+        PDM_Alert_OnEdge(1);
     }
 }
 /* USER CODE END 1 */
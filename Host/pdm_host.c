@@ -0,0 +1,455 @@
+#include "pdm_host.h"
+#include "pdm_calc.h"
+#include "pdm_cmd.h"
+#include "pdm_irq.h"
+#include "pdm_log.h"
+#include "pdm_monitor.h"
+#include "pdm_node.h"
+#include "pdm_pool.h"
+#include "pdm_replay.h"
+#include "pdm_sensor.h"
+#include "pdm_telem.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * 主机测试和基准（make host）：固件在模拟板上启动（pdm_host.h），记录经回放模式的虚拟 INA226 送入采集，
+ * 能量和电荷与记录本身算出的真值比较，不合格时返回非 0。
+ *   pdm_host [-t trace.csv] [-n 次数] [-v]
+ *   -t  pdm_stream.py 保存的 CSV（t_us、ch、bus_raw、shunt_raw 列，与 Tools/pdm_replay.py 相同），
+ *       需要先把零点参数设为 0 的记录；不给时用内置的合成记录（两个通道约 10 min，含脉冲负载和回充）
+ *   -n  基准的重复次数（默认 200000）
+ *   -v  固件的 UART 输出写到 stdout
+ * 真值：每条记录的分流电压 / 标称采样电阻 x 总线电压 x 间隔，双精度累加。
+ * 误差来自器件的整数运算：电流寄存器取整，功率寄存器截断（每条记录少算不到 1 LSB）。
+ * 合格范围为 TOL_PPM 加 TOL_ABS_*，能量再加上每条记录 1 个功率 LSB。
+ * 最后收到的 0x314 帧按同样的真值检查（再加上字段的分辨率），另有 10 A、24 V 1 h 的换算算例。
+ * 基准为本机时间，只用于比较代码修改前后（板上的周期数见 make bench）：
+ *   replay      回放整段记录，包括调度、CAN 和日志，按处理的记录数平均
+ *   decode      PDM_Sensor_Decode()，一次读取的 5 个寄存器
+ *   can_encode  通道帧编码（PDM_Telem_EncodeChannel()，重新编码 / 用上次的结果）
+ */
+
+#define SAMPLE_MS       10u             /* 本机采样周期（最小值），记录间隔不短于它时为实时回放 */
+#define FEED_MARGIN     2u              /* 按队列空位送入记录时少用的空位 */
+#define DRAIN_MS        3000u           /* 记录送完后继续运行的时间 */
+#define TOL_PPM         50.0
+#define TOL_ABS_MWH     0.01
+#define TOL_ABS_MAH     0.001
+#define SYN_DT          100u            /* 合成记录间隔 (100 us)：10 ms */
+#define SYN_STEPS       60000u
+#define CAN_ID_ENERGY32 0x314u          /* 能量 10 uWh/LSB，净电荷 0.1 mAh/LSB */
+
+typedef struct {
+    uint8_t ch;
+    int16_t shunt;
+    uint16_t bus;
+    uint16_t dt;                        /* 100 us */
+} trace_rec_t;
+
+typedef struct {
+    double e_mwh;                       /* 按 |电流| 累计的能量，同 energy_uWh */
+    double dis_mwh;
+    double chg_mwh;
+    double q_mah;                       /* 净电荷，放电为正 */
+    double trunc_mwh;                   /* 功率寄存器截断的上限 */
+    uint32_t n;
+} truth_t;
+
+static trace_rec_t *g_rec;
+static uint32_t g_n;
+static uint32_t g_cap;
+static truth_t g_truth[PDM_CFG_CHANNELS];
+static uint8_t g_fail;
+static uint8_t g_e32[PDM_CFG_CHANNELS][8];  /* 每个通道最后一个 0x314 帧 */
+static uint8_t g_e32_seen[PDM_CFG_CHANNELS];
+static const pdm_scale_t g_sc = PDM_CALC_SCALE(PDM_SHUNT_UOHM, PDM_CURRENT_UA_PER_LSB);
+
+static double wall_s(void)
+{
+    struct timespec ts;
+
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void rec_add(uint8_t ch, int32_t shunt, int32_t bus, uint32_t dt)
+{
+    if (g_n == g_cap)
+    {
+        g_cap = g_cap ? g_cap * 2u : 4096u;
+        g_rec = realloc(g_rec, g_cap * sizeof(*g_rec));
+        if (g_rec == NULL)
+        {
+            fprintf(stderr, "out of memory\n");
+            exit(2);
+        }
+    }
+    g_rec[g_n].ch = ch;
+    g_rec[g_n].shunt = (int16_t)((shunt > 32767) ? 32767 : (shunt < -32768) ? -32768 : shunt);
+    g_rec[g_n].bus = (uint16_t)((bus < 0) ? 0 : (bus > 0x7FFF) ? 0x7FFF : bus);
+    g_rec[g_n].dt = (uint16_t)((dt < 1u) ? 1u : (dt > 0xFFFFu) ? 0xFFFFu : dt);
+    g_n++;
+}
+
+/* --- 与 Tools/pdm_replay.py 的 load() 相同：每个通道的第一条只用来确定间隔，没有总线电压的样本跳过 --- */
+static uint8_t load_csv(const char *path)
+{
+    char line[512];
+    int col_t = -1, col_ch = -1, col_bus = -1, col_shunt = -1;
+    uint32_t last[PDM_CFG_CHANNELS];
+    uint8_t have[PDM_CFG_CHANNELS] = {0};
+    FILE *f = fopen(path, "r");
+
+    if (f == NULL || fgets(line, sizeof(line), f) == NULL)
+    {
+        fprintf(stderr, "cannot read %s\n", path);
+        return 1;
+    }
+    for (int i = 0, c = 0; line[i] != '\0'; c++)
+    {
+        int len = (int)strcspn(&line[i], ",\r\n");
+
+        if (len == 4 && strncmp(&line[i], "t_us", 4) == 0) col_t = c;
+        if (len == 2 && strncmp(&line[i], "ch", 2) == 0) col_ch = c;
+        if (len == 7 && strncmp(&line[i], "bus_raw", 7) == 0) col_bus = c;
+        if (len == 9 && strncmp(&line[i], "shunt_raw", 9) == 0) col_shunt = c;
+        i += len + (line[i + len] == ',');
+        if (line[i] == '\r' || line[i] == '\n')
+        {
+            break;
+        }
+    }
+    if (col_t < 0 || col_ch < 0 || col_bus < 0 || col_shunt < 0)
+    {
+        fprintf(stderr, "%s: need t_us, ch, bus_raw and shunt_raw columns\n", path);
+        fclose(f);
+        return 1;
+    }
+    while (fgets(line, sizeof(line), f) != NULL)
+    {
+        long v[4] = {0};
+        uint8_t empty_bus = 0;
+        char *p = line;
+
+        for (int c = 0; *p != '\0' && *p != '\r' && *p != '\n'; c++)
+        {
+            int len = (int)strcspn(p, ",\r\n");
+            int k = (c == col_t) ? 0 : (c == col_ch) ? 1 : (c == col_bus) ? 2 : (c == col_shunt) ? 3 : -1;
+
+            if (k >= 0)
+            {
+                v[k] = strtol(p, NULL, 10);
+                empty_bus |= (uint8_t)(k == 2 && len == 0);
+            }
+            p += len + (p[len] == ',');
+        }
+        if (empty_bus || v[1] < 0 || v[1] >= PDM_CFG_CHANNELS)
+        {
+            continue;
+        }
+        uint8_t ch = (uint8_t)v[1];
+        uint32_t t = (uint32_t)v[0];
+        uint32_t dt_us = t - last[ch];
+
+        last[ch] = t;
+        if (!have[ch] || dt_us == 0)
+        {
+            have[ch] = 1;
+            continue;
+        }
+        rec_add(ch, v[3], v[2], (dt_us + PDM_REPLAY_DT_US / 2u) / PDM_REPLAY_DT_US);
+    }
+    fclose(f);
+    return (g_n == 0);
+}
+
+/* --- 合成记录：BUS 通道 3 A 基础负载、每 2 s 一个 300 ms 的 8 A 脉冲和慢速三角波，电压随电流下降；
+ * BAT 通道为 BUS 加 0.5 A 自耗电，每 7 s 有 1 s 回充 -6 A。两个通道都叠加 +-2 LSB 的噪声 --- */
+static void synth(void)
+{
+    uint32_t seed = 12345u;
+
+    for (uint32_t k = 0; k < SYN_STEPS; k++)
+    {
+        uint32_t t_ms = k * (SYN_DT / 10u);
+        int32_t tri = (int32_t)(t_ms % 20000u);
+        int32_t bus_ma = 3000 + ((t_ms % 2000u) < 300u ? 8000 : 0) + ((tri < 10000) ? tri : 20000 - tri) / 10;
+        int32_t bat_ma = ((t_ms % 7000u) < 1000u) ? -6000 : bus_ma + 500;
+        int32_t ma[2] = { bus_ma, bat_ma };
+        int32_t mv[2] = { 24000 - bus_ma / 20, 26000 - bat_ma / 10 };
+
+        for (uint8_t ch = 0; ch < 2u && ch < PDM_CFG_CHANNELS; ch++)
+        {
+            int32_t noise;
+
+            seed = seed * 1103515245u + 12345u;
+            noise = (int32_t)((seed >> 16) % 5u) - 2;
+            rec_add(ch, pdm_calc_shunt_raw_from_mA(ma[ch], &g_sc) + noise,
+                    (int32_t)pdm_calc_bus_raw_from_mV((uint32_t)mv[ch]) + noise, SYN_DT);
+        }
+    }
+}
+
+static void truth_calc(void)
+{
+    const double r_ohm = PDM_SHUNT_UOHM * 1e-6;
+
+    memset(g_truth, 0, sizeof(g_truth));
+    for (uint32_t i = 0; i < g_n; i++)
+    {
+        const trace_rec_t *r = &g_rec[i];
+        truth_t *t = &g_truth[r->ch];
+        double a = r->shunt * (PDM_SHUNT_NV_PER_LSB * 1e-9) / r_ohm;
+        double v = r->bus * (PDM_BUS_UV_PER_LSB * 1e-6);
+        double h = r->dt * (PDM_REPLAY_DT_US * 1e-6) / 3600.0;
+        double e = a * v * h * 1000.0;
+
+        t->e_mwh += fabs(e);
+        t->dis_mwh += (e > 0) ? e : 0;
+        t->chg_mwh += (e < 0) ? -e : 0;
+        t->q_mah += a * h * 1000.0;
+        t->trunc_mwh += g_sc.power_uw_per_lsb * h * 1e-3;
+        t->n++;
+    }
+}
+
+static void feed(const trace_rec_t *r, uint8_t start)
+{
+    static uint8_t seq;
+    uint8_t d[8];
+
+    seq = start ? 0 : (uint8_t)(seq + 1u);
+    d[0] = (uint8_t)((start ? PDM_REPLAY_START : 0) | r->ch);
+    d[1] = (uint8_t)((uint16_t)r->shunt >> 8);
+    d[2] = (uint8_t)r->shunt;
+    d[3] = (uint8_t)(r->bus >> 8);
+    d[4] = (uint8_t)r->bus;
+    d[5] = (uint8_t)(r->dt >> 8);
+    d[6] = (uint8_t)r->dt;
+    d[7] = seq;
+    PDM_Replay_Rx(d, sizeof(d));
+}
+
+/* --- 按队列空位送入全部记录，送完后继续运行 DRAIN_MS；返回本机用时 (s) --- */
+static double replay(uint8_t st[8])
+{
+    uint32_t i = 0;
+    uint64_t end_us = 0;
+    double t0 = wall_s();
+
+    while (end_us == 0 || PDM_Host_NowUs() < end_us)
+    {
+        PDM_Replay_Encode(st, NULL);
+        for (uint8_t k = st[0]; k > FEED_MARGIN && i < g_n; k--, i++)
+        {
+            feed(&g_rec[i], i == 0);
+        }
+        if (i == g_n && end_us == 0 && st[0] == PDM_CFG_REPLAY_FIFO - 1u)
+        {
+            end_us = PDM_Host_NowUs() + DRAIN_MS * 1000u;
+        }
+        PDM_Monitor_Update();
+    }
+    return wall_s() - t0;
+}
+
+static void check(const char *what, double fw, double truth, double tol_abs)
+{
+    double err = fw - truth;
+    double tol = fabs(truth) * TOL_PPM * 1e-6 + tol_abs;
+    uint8_t ok = (uint8_t)(fabs(err) <= tol);
+
+    printf("  %-20s %14.4f %14.4f %+10.4f %9.1f ppm  %s\n", what, fw, truth, err,
+           (truth != 0) ? err / fabs(truth) * 1e6 : 0.0, ok ? "ok" : "FAIL");
+    g_fail += (uint8_t)!ok;
+}
+
+static void can_tx(uint32_t id, const uint8_t *data, uint8_t dlc)
+{
+    uint8_t ch = data[0] >> 4;
+
+    if (id == PDM_Node_TxId(CAN_ID_ENERGY32) && dlc == 8 && ch < PDM_CFG_CHANNELS)
+    {
+        memcpy(g_e32[ch], data, 8);
+        g_e32_seen[ch] = 1;
+    }
+}
+
+/* --- 换算算例：10 A、24 V 持续 1 h，应为 1000 mAh（0x314 的 100000）和 240 Wh（24000000） --- */
+static void check_units(void)
+{
+    const uint64_t hour_us = 3600000000ull;
+    int32_t shunt = pdm_calc_shunt_raw_from_mA(10000, &g_sc);
+    uint32_t power = pdm_calc_power_raw_from_mW(240000, &g_sc);
+    uint64_t e_acc = 0;
+
+    for (uint32_t s = 0; s < 3600u; s++)
+    {
+        pdm_calc_energy_add(&e_acc, (uint16_t)power, 1000000u, &g_sc);
+    }
+    check("10 A 1 h 0.1 mAh", pdm_calc_charge_100uAh((int64_t)shunt * (int64_t)hour_us, &g_sc), 100000.0, 0.0);
+    check("240 W 1 h 10 uWh", pdm_calc_energy_uWh(e_acc, &g_sc) / 10u, 24000000.0, 0.0);
+}
+
+static void check_channels(void)
+{
+    printf("%-22s %14s %14s %10s %13s\n", "check", "firmware", "truth", "error", "");
+    for (uint8_t ch = 0; ch < PDM_CFG_CHANNELS; ch++)
+    {
+        pdm_channel_t c;
+        char name[24];
+
+        if (g_truth[ch].n == 0 || PDM_Monitor_GetChannel(ch, &c) != 0)
+        {
+            continue;
+        }
+        snprintf(name, sizeof(name), "ch%u energy mWh", ch);
+        check(name, ((double)c.energy_wraps * PDM_ENERGY_WRAP_UWH + c.energy_uWh) / 1000.0, g_truth[ch].e_mwh,
+              TOL_ABS_MWH + g_truth[ch].trunc_mwh);
+        snprintf(name, sizeof(name), "ch%u discharge mWh", ch);
+        check(name, c.energy_dis_uWh / 1000.0, g_truth[ch].dis_mwh, TOL_ABS_MWH + g_truth[ch].trunc_mwh);
+        snprintf(name, sizeof(name), "ch%u charge mWh", ch);
+        check(name, c.energy_chg_uWh / 1000.0, g_truth[ch].chg_mwh, TOL_ABS_MWH + g_truth[ch].trunc_mwh);
+        snprintf(name, sizeof(name), "ch%u net mAh", ch);
+        check(name, (double)c.charge_acc * g_sc.current_ua_per_lsb / 3.6e12, g_truth[ch].q_mah, TOL_ABS_MAH);
+        if (!g_e32_seen[ch])
+        {
+            printf("  ch%u: no 0x314 frame  FAIL\n", ch);
+            g_fail++;
+            continue;
+        }
+        snprintf(name, sizeof(name), "ch%u 0x314 mWh", ch);
+        check(name, ((uint32_t)g_e32[ch][1] << 24 | (uint32_t)g_e32[ch][2] << 16 | (uint32_t)g_e32[ch][3] << 8 |
+                     g_e32[ch][4]) / 100.0,
+              g_truth[ch].e_mwh, TOL_ABS_MWH + 0.01 + g_truth[ch].trunc_mwh);
+        snprintf(name, sizeof(name), "ch%u 0x314 mAh", ch);
+        check(name, (int32_t)((uint32_t)g_e32[ch][5] << 24 | (uint32_t)g_e32[ch][6] << 16 |
+                              (uint32_t)g_e32[ch][7] << 8) / 256 / 10.0,
+              g_truth[ch].q_mah, TOL_ABS_MAH + 0.1);
+    }
+    check_units();
+}
+
+/* --- 基准：n 次的平均本机时间 (ns) --- */
+static volatile uint32_t g_sink;
+
+static double bench(void (*op)(void), uint32_t n)
+{
+    double t0 = wall_s();
+
+    for (uint32_t k = 0; k < n; k++)
+    {
+        op();
+    }
+    return (wall_s() - t0) * 1e9 / n;
+}
+
+static ina226_read_job_t g_job;
+static pdm_sensor_sample_t g_smp;
+static uint8_t g_frame[8];
+
+static void op_decode(void)
+{
+    g_sink += PDM_Sensor_Decode(PDM_SENSOR_INA226, &g_job, &g_smp);
+}
+
+static void op_can_encode(void)
+{
+    PDM_Telem_EncodeChannel(0, g_frame, 1);
+    g_sink += g_frame[0];
+}
+
+static void op_can_cached(void)
+{
+    PDM_Telem_EncodeChannel(0, g_frame, 0);
+    g_sink += g_frame[0];
+}
+
+static void benchmarks(uint32_t n, double replay_s)
+{
+    /* 默认采样电阻下约 12 V、2 A，与 pdm_bench.c 相同 */
+    static const uint8_t raw[INA226_READ_REGS][2] = {
+        { 0x04, 0x08 }, { 0x0C, 0x80 }, { 0x25, 0x80 }, { 0x0F, 0xA0 }, { 0x07, 0x80 },
+    };
+    double ns;
+
+    memcpy(g_job.raw, raw, sizeof(raw));
+    g_job.n = INA226_READ_REGS;
+
+    printf("%-12s %10s %14s\n", "bench", "ns/op", "op/s");
+    ns = replay_s * 1e9 / g_n;
+    printf("%-12s %10.1f %14.0f\n", "replay", ns, 1e9 / ns);
+    ns = bench(op_decode, n);
+    printf("%-12s %10.1f %14.0f\n", "decode", ns, 1e9 / ns);
+    ns = bench(op_can_encode, n);
+    printf("%-12s %10.1f %14.0f\n", "can_encode", ns, 1e9 / ns);
+    ns = bench(op_can_cached, n);
+    printf("%-12s %10.1f %14.0f\n", "can_cached", ns, 1e9 / ns);
+}
+
+int main(int argc, char **argv)
+{
+    const char *trace = NULL;
+    uint32_t iter = 200000u;
+    uint8_t st[8];
+    double replay_s;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+        {
+            trace = argv[++i];
+        }
+        else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+        {
+            iter = (uint32_t)strtoul(argv[++i], NULL, 0);
+        }
+        else if (strcmp(argv[i], "-v") == 0)
+        {
+            PDM_Host_SetUartEcho(1);
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [-t trace.csv] [-n iterations] [-v]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (trace != NULL ? load_csv(trace) != 0 : (synth(), 0))
+    {
+        return 2;
+    }
+    truth_calc();
+    if (PDM_Host_Init() != 0)
+    {
+        return 2;
+    }
+
+    /* 与 main() 中 USER CODE 2 的顺序相同 */
+    PDM_Irq_Init();
+    PDM_Pool_Init();
+    PDM_Log_Init();
+    PDM_Monitor_Init();
+    PDM_Cmd_Init();
+    if (PDM_Monitor_SetSamplePeriod(SAMPLE_MS) != 0)
+    {
+        fprintf(stderr, "cannot set the sample period\n");
+        return 2;
+    }
+
+    PDM_Host_SetCanTx(can_tx);
+    printf("trace %s: %lu records\n", trace ? trace : "(synthetic)", (unsigned long)g_n);
+    replay_s = replay(st);
+    printf("replay: %.1f s simulated, lost %u, overflow %u, %lu CAN frames\n", PDM_Host_NowUs() * 1e-6, st[1],
+           (unsigned)((uint16_t)st[6] << 8 | st[7]), (unsigned long)PDM_Host_CanTxCount());
+    g_fail += (uint8_t)(st[1] != 0 || st[6] != 0 || st[7] != 0);
+
+    check_channels();
+    benchmarks(iter, replay_s);
+
+    printf("%s\n", g_fail ? "FAILED" : "passed");
+    return g_fail ? 1 : 0;
+}
@@ -0,0 +1,43 @@
+#ifndef PDM_HOST_H
+#define PDM_HOST_H
+
+#include <stdint.h>
+
+/*
+ * 主机构建（make host）的模拟板：Core/Src 中除 CubeMX 生成的外设初始化以外的模块用本机 gcc 编译，
+ * 使用原有的 HAL 和 CMSIS 头文件，HAL 函数由 pdm_host_hal.c 代替。
+ *   寄存器     外设、内核外设、flash 和系统存储区按 STM32F103 的地址映射为普通内存（非 PIE，指针转 32 位不丢位），
+ *              寄存器只是内存：写入没有硬件动作，需要硬件清除的位只能等超时
+ *   INA226     PDM_CFG_REPLAY=1，接口层的读写由虚拟器件完成（pdm_replay.h），记录由 pdm_host.c 直接送入
+ *   时间       模拟时间 (us)：WFI 推进到下一个 1 ms tick（有挂起事件时不推进），每次 HAL_GetTick() 推进 1 us，
+ *              忙等和超时都能结束；SysTick->VAL、DWT->CYCCNT 按 72 MHz 跟随
+ *   中断       CAN 发送完成、UART DMA 发送完成在 PRIMASK 为 0 时的 HAL_GetTick() 中或 WFI 中执行回调
+ *   CAN        PDM_CFG_CAN_DIRECT_TX=0，三个邮箱由 HAL_CAN_AddTxMessage() 模拟，帧交给 PDM_Host_SetCanTx() 的回调
+ *   UART       日志输出到 stdout（PDM_Host_SetUartEcho(1)）或丢弃
+ *   flash      HAL_FLASH_Program() / HAL_FLASHEx_Erase() 直接改映射的内存，启动时全部为 0xFF
+ */
+
+typedef void (*pdm_host_can_tx_t)(uint32_t id, const uint8_t *data, uint8_t dlc);
+
+/* 映射存储区、设置 SysTick 和外设句柄；在任何固件函数之前调用，返回 0 成功 */
+uint8_t PDM_Host_Init(void);
+
+/* 模拟时间 (us)，从 PDM_Host_Init() 起 */
+uint64_t PDM_Host_NowUs(void);
+
+/* 推进模拟时间，之后执行已挂起的中断（PRIMASK 为 0 时） */
+void PDM_Host_Advance(uint32_t us);
+
+/* 每个发送完成的 CAN 帧调用一次，NULL 为不回调 */
+void PDM_Host_SetCanTx(pdm_host_can_tx_t fn);
+
+/* 已发送的 CAN 帧数 */
+uint32_t PDM_Host_CanTxCount(void);
+
+/* 模拟 CAN 接收一帧（标准帧），在接收中断中交给 pdm_can.c；返回 0 成功，1 FIFO 满 */
+uint8_t PDM_Host_CanRx(uint16_t id, const uint8_t *data, uint8_t dlc);
+
+/* UART 输出是否写到 stdout */
+void PDM_Host_SetUartEcho(uint8_t on);
+
+#endif /* PDM_HOST_H */
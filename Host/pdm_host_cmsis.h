@@ -0,0 +1,91 @@
+/*
+ * 主机构建（make host）用：以 -include 在每个源文件之前包含，占用 Drivers/CMSIS/Include/cmsis_compiler.h 的
+ * 头文件保护宏，使它和 cmsis_gcc.h 不再展开。宏与 cmsis_gcc.h 相同，Cortex-M 内核指令换成模拟核上的普通 C
+ * （PRIMASK 是变量，WFI 推进模拟时间，见 pdm_host.h），core_cm3.h 和 HAL 头文件不用修改即可编译。
+ */
+#ifndef __CMSIS_COMPILER_H
+#define __CMSIS_COMPILER_H
+
+#include <stdint.h>
+
+#define __ASM                                  __asm
+#define __INLINE                               inline
+#define __STATIC_INLINE                        static inline
+#define __STATIC_FORCEINLINE                   __attribute__((always_inline)) static inline
+#define __NO_RETURN                            __attribute__((__noreturn__))
+#define __USED                                 __attribute__((used))
+#define __WEAK                                 __attribute__((weak))
+#define __PACKED                               __attribute__((packed, aligned(1)))
+#define __PACKED_STRUCT                        struct __attribute__((packed, aligned(1)))
+#define __PACKED_UNION                         union __attribute__((packed, aligned(1)))
+#define __UNALIGNED_UINT32(x)                  (*(uint32_t *)(x))
+#define __UNALIGNED_UINT16_WRITE(addr, val)    (void)(*(uint16_t *)(void *)(addr) = (val))
+#define __UNALIGNED_UINT16_READ(addr)          (*(const uint16_t *)(const void *)(addr))
+#define __UNALIGNED_UINT32_WRITE(addr, val)    (void)(*(uint32_t *)(void *)(addr) = (val))
+#define __UNALIGNED_UINT32_READ(addr)          (*(const uint32_t *)(const void *)(addr))
+#define __ALIGNED(x)                           __attribute__((aligned(x)))
+#define __RESTRICT                             __restrict
+#define __COMPILER_BARRIER()                   __asm volatile("" ::: "memory")
+
+extern volatile uint32_t g_host_primask;     /* 模拟核的 PRIMASK 和 IPSR（中断号 + 16，主循环为 0） */
+extern volatile uint32_t g_host_ipsr;
+void PDM_Host_Wfi(void);
+void PDM_Host_Bkpt(void);
+void PDM_Host_Nop(void);                    /* NVIC_SystemReset() 之后在这里结束进程 */
+uint32_t PDM_Host_Msp(void);
+
+__STATIC_FORCEINLINE void __enable_irq(void)               { g_host_primask = 0; }
+__STATIC_FORCEINLINE void __disable_irq(void)              { g_host_primask = 1; }
+__STATIC_FORCEINLINE uint32_t __get_PRIMASK(void)          { return g_host_primask; }
+__STATIC_FORCEINLINE void __set_PRIMASK(uint32_t priMask)  { g_host_primask = priMask & 1u; }
+__STATIC_FORCEINLINE uint32_t __get_IPSR(void)             { return g_host_ipsr; }
+__STATIC_FORCEINLINE uint32_t __get_xPSR(void)             { return g_host_ipsr; }
+__STATIC_FORCEINLINE uint32_t __get_MSP(void)              { return PDM_Host_Msp(); }
+__STATIC_FORCEINLINE uint32_t __get_CONTROL(void)          { return 0; }
+__STATIC_FORCEINLINE uint32_t __get_BASEPRI(void)          { return 0; }
+__STATIC_FORCEINLINE void __set_BASEPRI(uint32_t v)        { (void)v; }
+__STATIC_FORCEINLINE uint32_t __get_FAULTMASK(void)        { return 0; }
+__STATIC_FORCEINLINE void __set_FAULTMASK(uint32_t v)      { (void)v; }
+
+#define __NOP()                                PDM_Host_Nop()
+#define __WFI()                                PDM_Host_Wfi()
+#define __WFE()                                PDM_Host_Wfi()
+#define __SEV()                                __COMPILER_BARRIER()
+#define __ISB()                                __COMPILER_BARRIER()
+#define __DSB()                                __COMPILER_BARRIER()
+#define __DMB()                                __COMPILER_BARRIER()
+#define __BKPT(value)                          PDM_Host_Bkpt()
+
+__STATIC_FORCEINLINE uint32_t __REV(uint32_t value)        { return __builtin_bswap32(value); }
+__STATIC_FORCEINLINE uint32_t __REV16(uint32_t value)
+{
+    return ((value & 0xFF00FF00u) >> 8) | ((value & 0x00FF00FFu) << 8);
+}
+__STATIC_FORCEINLINE int16_t __REVSH(int16_t value)        { return (int16_t)__builtin_bswap16((uint16_t)value); }
+__STATIC_FORCEINLINE uint32_t __RBIT(uint32_t value)
+{
+    uint32_t r = 0;
+
+    for (uint8_t i = 0; i < 32u; i++)
+    {
+        r = (r << 1) | ((value >> i) & 1u);
+    }
+    return r;
+}
+__STATIC_FORCEINLINE uint8_t __CLZ(uint32_t value)         { return (value == 0u) ? 32u : (uint8_t)__builtin_clz(value); }
+
+__STATIC_FORCEINLINE int32_t __SSAT(int32_t val, uint32_t sat)
+{
+    const int32_t max = (int32_t)((1u << (sat - 1u)) - 1u);
+    const int32_t min = -1 - max;
+
+    return (val > max) ? max : ((val < min) ? min : val);
+}
+__STATIC_FORCEINLINE uint32_t __USAT(int32_t val, uint32_t sat)
+{
+    const uint32_t max = (1u << sat) - 1u;
+
+    return (val > (int32_t)max) ? max : ((val < 0) ? 0u : (uint32_t)val);
+}
+
+#endif /* __CMSIS_COMPILER_H */
@@ -0,0 +1,532 @@
+#include "pdm_host.h"
+#include "main.h"
+#include "can.h"
+#include "i2c.h"
+#include "usart.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+/* 模拟板的 HAL：只实现固件用到的函数，行为见 pdm_host.h */
+
+#define CORE_HZ         72000000u
+#define TICK_LOAD       (CORE_HZ / 1000u - 1u)
+#define GETTICK_US      1u              /* 每次 HAL_GetTick() 推进的时间 */
+#define FLASH_HW_US     60u             /* 编程一个半字的时间 */
+#define FLASH_PAGE_US   20000u          /* 擦除一页的时间 */
+#define RX_FIFO_LEN     3u              /* bxCAN 接收 FIFO 深度 */
+
+typedef struct {
+    uint32_t base;
+    uint32_t size;
+    uint8_t fill;
+} host_region_t;
+
+/* 按 STM32F103C8 的地址映射：flash 64 KB、系统存储区（UID 和 flash 容量）、SRAM 20 KB、外设、内核外设和 DBGMCU */
+static const host_region_t g_regions[] = {
+    { FLASH_BASE,      0x10000u,  0xFF },
+    { 0x1FFFF000u,     0x1000u,   0x00 },
+    { SRAM_BASE,       0x5000u,   0x00 },
+    { PERIPH_BASE,     0x30000u,  0x00 },
+    { 0xE0000000u,     0x100000u, 0x00 },
+};
+
+typedef struct {
+    uint8_t busy;
+    uint16_t id;
+    uint8_t dlc;
+    uint8_t data[8];
+} host_mailbox_t;
+
+volatile uint32_t g_host_primask;
+volatile uint32_t g_host_ipsr;
+__IO uint32_t uwTick;
+
+uint32_t SystemCoreClock = CORE_HZ;
+
+CAN_HandleTypeDef hcan;
+I2C_HandleTypeDef hi2c1;
+I2C_HandleTypeDef hi2c2;
+UART_HandleTypeDef huart1;
+DMA_HandleTypeDef hdma_usart1_tx;
+DMA_HandleTypeDef hdma_usart1_rx;
+
+static uint64_t g_now_us;
+static host_mailbox_t g_mb[3];
+static host_mailbox_t g_rx[RX_FIFO_LEN];
+static uint8_t g_rx_head;
+static uint8_t g_rx_count;
+static uint32_t g_can_tx_count;
+static pdm_host_can_tx_t g_can_tx;
+static uint8_t g_uart_pending;
+static uint8_t g_uart_echo;
+
+static uint8_t map_region(const host_region_t *r)
+{
+#ifdef _WIN32
+    void *p = VirtualAlloc((void *)(uintptr_t)r->base, r->size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+    void *p = mmap((void *)(uintptr_t)r->base, r->size, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+#endif
+
+    if (p != (void *)(uintptr_t)r->base)
+    {
+        fprintf(stderr, "host: cannot map 0x%08lx (%lu bytes)\n", (unsigned long)r->base, (unsigned long)r->size);
+        return 1;
+    }
+    memset(p, r->fill, r->size);
+    return 0;
+}
+
+/* SysTick 向下计数，DWT 周期计数器向上，都按模拟时间换算 */
+static void sync_counters(void)
+{
+    uint32_t frac_us = (uint32_t)(g_now_us % 1000u);
+
+    uwTick = (uint32_t)(g_now_us / 1000u);
+    SysTick->VAL = TICK_LOAD - frac_us * (CORE_HZ / 1000000u);
+    DWT->CYCCNT = (uint32_t)(g_now_us * (CORE_HZ / 1000000u));
+}
+
+static uint8_t irq_pending(void)
+{
+    return (uint8_t)(g_uart_pending || g_rx_count != 0 || g_mb[0].busy || g_mb[1].busy || g_mb[2].busy);
+}
+
+/* --- 执行挂起的中断：UART 发送完成、CAN 发送完成、CAN 接收；不嵌套 --- */
+static void irq_run(void)
+{
+    static void (*const tx_done[3])(CAN_HandleTypeDef *) = {
+        HAL_CAN_TxMailbox0CompleteCallback, HAL_CAN_TxMailbox1CompleteCallback, HAL_CAN_TxMailbox2CompleteCallback,
+    };
+
+    if (g_host_ipsr != 0)
+    {
+        return;
+    }
+    if (g_uart_pending)
+    {
+        g_uart_pending = 0;
+        huart1.gState = HAL_UART_STATE_READY;
+        g_host_ipsr = USART1_IRQn + 16u;
+        HAL_UART_TxCpltCallback(&huart1);
+        g_host_ipsr = 0;
+    }
+    for (uint8_t n = 0; n < 3u; n++)
+    {
+        if (!g_mb[n].busy)
+        {
+            continue;
+        }
+        g_mb[n].busy = 0;
+        CAN1->TSR |= (CAN_TSR_TME0 | CAN_TSR_RQCP0 | CAN_TSR_TXOK0) << (8u * n);
+        g_can_tx_count++;
+        if (g_can_tx != NULL)
+        {
+            g_can_tx(g_mb[n].id, g_mb[n].data, g_mb[n].dlc);
+        }
+        g_host_ipsr = USB_HP_CAN1_TX_IRQn + 16u;
+        tx_done[n](&hcan);
+        g_host_ipsr = 0;
+    }
+    if (g_rx_count != 0)
+    {
+        g_host_ipsr = USB_LP_CAN1_RX0_IRQn + 16u;
+        HAL_CAN_RxFifo0MsgPendingCallback(&hcan);
+        g_host_ipsr = 0;
+    }
+}
+
+uint8_t PDM_Host_Init(void)
+{
+    for (uint8_t i = 0; i < sizeof(g_regions) / sizeof(g_regions[0]); i++)
+    {
+        if (map_region(&g_regions[i]) != 0)
+        {
+            return 1;
+        }
+    }
+    *(volatile uint16_t *)FLASHSIZE_BASE = 64;
+    for (uint8_t i = 0; i < 12u; i++)
+    {
+        ((volatile uint8_t *)UID_BASE)[i] = (uint8_t)(0x30u + i);
+    }
+
+    SysTick->LOAD = TICK_LOAD;
+    SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk | SysTick_CTRL_ENABLE_Msk;
+    CAN1->TSR = CAN_TSR_TME0 | CAN_TSR_TME1 | CAN_TSR_TME2;
+    FLASH->CR = FLASH_CR_LOCK;
+    g_now_us = 0;
+    sync_counters();
+
+    /* 与 MX_CAN_Init() / MX_I2C1_Init() / MX_USART1_UART_Init() 相同的配置，位速率和波特率由此计算 */
+    hcan.Instance = CAN1;
+    hcan.Init.Prescaler = 4;
+    hcan.Init.Mode = CAN_MODE_NORMAL;
+    hcan.Init.SyncJumpWidth = CAN_SJW_1TQ;
+    hcan.Init.TimeSeg1 = CAN_BS1_13TQ;
+    hcan.Init.TimeSeg2 = CAN_BS2_4TQ;
+    hcan.State = HAL_CAN_STATE_LISTENING;
+    hi2c1.Instance = I2C1;
+    hi2c1.Init.ClockSpeed = 400000;
+    hi2c1.Init.AddressingMode = I2C_ADDRESSINGMODE_7BIT;
+    hi2c1.State = HAL_I2C_STATE_READY;
+    hi2c2.Instance = I2C2;
+    hi2c2.Init = hi2c1.Init;
+    hi2c2.State = HAL_I2C_STATE_READY;
+    huart1.Instance = USART1;
+    huart1.Init.BaudRate = 115200;
+    huart1.Init.WordLength = UART_WORDLENGTH_8B;
+    huart1.Init.StopBits = UART_STOPBITS_1;
+    huart1.Init.Parity = UART_PARITY_NONE;
+    huart1.Init.Mode = UART_MODE_TX_RX;
+    huart1.gState = HAL_UART_STATE_READY;
+    huart1.RxState = HAL_UART_STATE_READY;
+    hdma_usart1_tx.Instance = DMA1_Channel4;
+    hdma_usart1_rx.Instance = DMA1_Channel5;
+    return 0;
+}
+
+uint64_t PDM_Host_NowUs(void)
+{
+    return g_now_us;
+}
+
+void PDM_Host_Advance(uint32_t us)
+{
+    g_now_us += us;
+    sync_counters();
+    if (g_host_primask == 0)
+    {
+        irq_run();
+    }
+}
+
+void PDM_Host_SetCanTx(pdm_host_can_tx_t fn)
+{
+    g_can_tx = fn;
+}
+
+uint32_t PDM_Host_CanTxCount(void)
+{
+    return g_can_tx_count;
+}
+
+uint8_t PDM_Host_CanRx(uint16_t id, const uint8_t *data, uint8_t dlc)
+{
+    host_mailbox_t *m;
+
+    if (g_rx_count >= RX_FIFO_LEN || dlc > 8u)
+    {
+        return 1;
+    }
+    m = &g_rx[(g_rx_head + g_rx_count) % RX_FIFO_LEN];
+    m->id = id;
+    m->dlc = dlc;
+    memcpy(m->data, data, dlc);
+    g_rx_count++;
+    PDM_Host_Advance(0);
+    return 0;
+}
+
+void PDM_Host_SetUartEcho(uint8_t on)
+{
+    g_uart_echo = on;
+}
+
+/* --- 内核：WFI 在没有挂起的中断时睡到下一个 tick，醒来后执行中断 --- */
+void PDM_Host_Wfi(void)
+{
+    if (!irq_pending())
+    {
+        g_now_us += 1000u - g_now_us % 1000u;
+        sync_counters();
+    }
+    irq_run();
+}
+
+void PDM_Host_Bkpt(void)
+{
+    fprintf(stderr, "host: BKPT\n");
+    exit(3);
+}
+
+/* NVIC_SystemReset() 置 SYSRESETREQ 后在 __NOP() 上循环 */
+void PDM_Host_Nop(void)
+{
+    if (SCB->AIRCR & SCB_AIRCR_SYSRESETREQ_Msk)
+    {
+        fprintf(stderr, "host: system reset requested\n");
+        exit(3);
+    }
+}
+
+uint32_t PDM_Host_Msp(void)
+{
+    return SRAM_BASE + 0x5000u - 0x100u;
+}
+
+void Error_Handler(void)
+{
+    fprintf(stderr, "host: Error_Handler\n");
+    exit(3);
+}
+
+/* --- HAL --- */
+
+uint32_t HAL_GetTick(void)
+{
+    PDM_Host_Advance(GETTICK_US);
+    return uwTick;
+}
+
+void HAL_Delay(uint32_t Delay)
+{
+    uint32_t start = HAL_GetTick();
+
+    while (HAL_GetTick() - start < Delay + 1u)
+    {
+        PDM_Host_Wfi();
+    }
+}
+
+void HAL_NVIC_SetPriorityGrouping(uint32_t PriorityGroup)
+{
+    (void)PriorityGroup;
+}
+
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority)
+{
+    (void)IRQn;
+    (void)PreemptPriority;
+    (void)SubPriority;
+}
+
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn)
+{
+    (void)IRQn;
+}
+
+void HAL_NVIC_DisableIRQ(IRQn_Type IRQn)
+{
+    (void)IRQn;
+}
+
+uint32_t HAL_RCC_GetPCLK1Freq(void)
+{
+    return CORE_HZ / 2u;
+}
+
+void HAL_GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_Init)
+{
+    (void)GPIOx;
+    (void)GPIO_Init;
+}
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+    return (GPIOx->IDR & GPIO_Pin) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState)
+{
+    if (PinState != GPIO_PIN_RESET)
+    {
+        GPIOx->ODR |= GPIO_Pin;
+    }
+    else
+    {
+        GPIOx->ODR &= ~(uint32_t)GPIO_Pin;
+    }
+}
+
+void HAL_GPIO_TogglePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+    GPIOx->ODR ^= GPIO_Pin;
+}
+
+void HAL_PWR_ConfigPVD(PWR_PVDTypeDef *sConfigPVD)
+{
+    (void)sConfigPVD;
+}
+
+void HAL_PWR_EnablePVD(void)
+{
+}
+
+/* 回放模式下接口层不访问 I2C，中断入口只需要存在 */
+void HAL_I2C_EV_IRQHandler(I2C_HandleTypeDef *hi2c)
+{
+    (void)hi2c;
+}
+
+void HAL_I2C_ER_IRQHandler(I2C_HandleTypeDef *hi2c)
+{
+    (void)hi2c;
+}
+
+/* --- CAN：三个发送邮箱，发送在下一次执行中断时完成 --- */
+
+HAL_StatusTypeDef HAL_CAN_ConfigFilter(CAN_HandleTypeDef *hcan_, const CAN_FilterTypeDef *sFilterConfig)
+{
+    (void)hcan_;
+    (void)sFilterConfig;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_CAN_ActivateNotification(CAN_HandleTypeDef *hcan_, uint32_t ActiveITs)
+{
+    (void)hcan_;
+    (void)ActiveITs;
+    return HAL_OK;
+}
+
+uint32_t HAL_CAN_GetTxMailboxesFreeLevel(const CAN_HandleTypeDef *hcan_)
+{
+    (void)hcan_;
+    return (uint32_t)(!g_mb[0].busy + !g_mb[1].busy + !g_mb[2].busy);
+}
+
+HAL_StatusTypeDef HAL_CAN_AddTxMessage(CAN_HandleTypeDef *hcan_, const CAN_TxHeaderTypeDef *pHeader,
+                                       const uint8_t aData[], uint32_t *pTxMailbox)
+{
+    (void)hcan_;
+    for (uint8_t n = 0; n < 3u; n++)
+    {
+        if (g_mb[n].busy)
+        {
+            continue;
+        }
+        g_mb[n].busy = 1;
+        g_mb[n].id = (uint16_t)pHeader->StdId;
+        g_mb[n].dlc = (uint8_t)(pHeader->DLC & 0x0Fu);
+        memcpy(g_mb[n].data, aData, (g_mb[n].dlc > 8u) ? 8u : g_mb[n].dlc);
+        CAN1->TSR &= ~(uint32_t)(CAN_TSR_TME0 << (8u * n));
+        *pTxMailbox = 1u << n;
+        return HAL_OK;
+    }
+    return HAL_ERROR;
+}
+
+uint32_t HAL_CAN_GetRxFifoFillLevel(const CAN_HandleTypeDef *hcan_, uint32_t RxFifo)
+{
+    (void)hcan_;
+    return (RxFifo == CAN_RX_FIFO0) ? g_rx_count : 0u;
+}
+
+HAL_StatusTypeDef HAL_CAN_GetRxMessage(CAN_HandleTypeDef *hcan_, uint32_t RxFifo,
+                                       CAN_RxHeaderTypeDef *pHeader, uint8_t aData[])
+{
+    const host_mailbox_t *m = &g_rx[g_rx_head];
+
+    (void)hcan_;
+    if (RxFifo != CAN_RX_FIFO0 || g_rx_count == 0)
+    {
+        return HAL_ERROR;
+    }
+    memset(pHeader, 0, sizeof(*pHeader));
+    pHeader->StdId = m->id;
+    pHeader->IDE = CAN_ID_STD;
+    pHeader->RTR = CAN_RTR_DATA;
+    pHeader->DLC = m->dlc;
+    memcpy(aData, m->data, m->dlc);
+    g_rx_head = (uint8_t)((g_rx_head + 1u) % RX_FIFO_LEN);
+    g_rx_count--;
+    return HAL_OK;
+}
+
+/* --- UART：DMA 发送立即写出，完成回调在下一次执行中断时调用；接收没有数据 --- */
+
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef *huart)
+{
+    huart->gState = HAL_UART_STATE_READY;
+    huart->RxState = HAL_UART_STATE_READY;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size)
+{
+    if (huart->gState != HAL_UART_STATE_READY)
+    {
+        return HAL_BUSY;
+    }
+    huart->gState = HAL_UART_STATE_BUSY_TX;
+    if (g_uart_echo)
+    {
+        fwrite(pData, 1, Size, stdout);
+    }
+    g_uart_pending = 1;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size)
+{
+    (void)pData;
+    huart->RxState = HAL_UART_STATE_BUSY_RX;
+    huart->hdmarx = &hdma_usart1_rx;
+    hdma_usart1_rx.Instance->CNDTR = Size;      /* 没有收到数据 */
+    return HAL_OK;
+}
+
+/* --- flash：只能在擦除后的半字上编程（写 0 除外），与芯片相同 --- */
+
+HAL_StatusTypeDef HAL_FLASH_Unlock(void)
+{
+    FLASH->CR &= ~FLASH_CR_LOCK;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASH_Lock(void)
+{
+    FLASH->CR |= FLASH_CR_LOCK;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASH_Program(uint32_t TypeProgram, uint32_t Address, uint64_t Data)
+{
+    uint8_t n = (TypeProgram == FLASH_TYPEPROGRAM_HALFWORD) ? 1u : (TypeProgram == FLASH_TYPEPROGRAM_WORD) ? 2u : 4u;
+
+    if ((FLASH->CR & FLASH_CR_LOCK) || (Address & 1u) || Address < FLASH_BASE ||
+        Address + 2u * n > FLASH_BASE + 0x10000u)
+    {
+        return HAL_ERROR;
+    }
+    for (uint8_t i = 0; i < n; i++)
+    {
+        volatile uint16_t *dst = (volatile uint16_t *)(uintptr_t)(Address + 2u * i);
+        uint16_t v = (uint16_t)(Data >> (16u * i));
+
+        if (*dst != 0xFFFFu && v != 0)
+        {
+            FLASH->SR |= FLASH_SR_PGERR;
+            return HAL_ERROR;
+        }
+        *dst = v;
+        g_now_us += FLASH_HW_US;
+    }
+    sync_counters();
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASHEx_Erase(FLASH_EraseInitTypeDef *pEraseInit, uint32_t *PageError)
+{
+    uint32_t a = pEraseInit->PageAddress;
+
+    *PageError = 0xFFFFFFFFu;
+    if ((FLASH->CR & FLASH_CR_LOCK) || pEraseInit->TypeErase != FLASH_TYPEERASE_PAGES ||
+        a < FLASH_BASE || a + pEraseInit->NbPages * FLASH_PAGE_SIZE > FLASH_BASE + 0x10000u)
+    {
+        *PageError = a;
+        return HAL_ERROR;
+    }
+    memset((void *)(uintptr_t)a, 0xFF, pEraseInit->NbPages * FLASH_PAGE_SIZE);
+    g_now_us += (uint64_t)pEraseInit->NbPages * FLASH_PAGE_US;
+    sync_counters();
+    return HAL_OK;
+}
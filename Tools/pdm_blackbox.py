@@ -0,0 +1,77 @@
+#!/usr/bin/env python3
+"""PDM 黑匣子解码（固件 PDM_CFG_BLACKBOX=1）。
+
+用法：
+    python pdm_blackbox.py bb.bin                   # 显示冻结信息和最后几秒的采样
+    python pdm_blackbox.py bb.bin -o bb.csv         # 全部采样写入 CSV
+
+bb.bin 为 ISO-TP 请求 [0x01, 0x03] 的响应去掉前两个字节（0x41 0x03）后的数据，
+格式见 Core/Inc/pdm_blackbox.h，记录中的块用 pdm_pack.py 解码。
+"""
+import argparse
+import csv
+import os
+import struct
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from pdm_pack import decode_block  # noqa: E402
+
+REASONS = {0: 'none', 1: 'fault', 2: 'watchdog reset', 3: 'VDD drop', 4: 'command'}
+BUS_MV_PER_LSB = 1.25
+
+
+def decode(data):
+    """返回 (头信息 dict, [(时间 ms, 通道, 电流原始值, 总线原始值), ...])，按时间排序"""
+    state, reason, nch, _, freeze_ms, used = struct.unpack_from('>BBBBIH', data, 0)
+    lsb = list(struct.unpack_from('>%dI' % nch, data, 10))
+    pos = 10 + 4 * nch
+    end = pos + used
+    samples = []
+    while pos < end:
+        rec_len, ch = data[pos], data[pos + 1]
+        p = pos + 2
+        ts, p = decode_block(data, p)
+        cur, p = decode_block(data, p)
+        bus, p = decode_block(data, p)
+        if p != pos + rec_len:
+            raise ValueError('bad record at offset %d' % pos)
+        samples += [(t & 0xFFFFFFFF, ch, c, b & 0xFFFF) for t, c, b in zip(ts, cur, bus)]
+        pos += rec_len
+    samples.sort(key=lambda s: s[0])
+    info = {'state': state, 'reason': reason, 'channels': nch, 'freeze_ms': freeze_ms,
+            'used': used, 'lsb_ua': lsb}
+    return info, samples
+
+
+def main():
+    ap = argparse.ArgumentParser(description='PDM black box decoder')
+    ap.add_argument('file')
+    ap.add_argument('-o', '--output', help='CSV 输出文件')
+    ap.add_argument('-n', '--tail', type=int, default=20, help='终端显示最后几个采样')
+    args = ap.parse_args()
+
+    with open(args.file, 'rb') as f:
+        info, samples = decode(f.read())
+
+    when = 'unknown' if info['freeze_ms'] == 0xFFFFFFFF else '%u ms' % info['freeze_ms']
+    print('%s, reason: %s, request at %s, %u bytes, %u samples' % (
+        'frozen' if info['state'] else 'recording', REASONS.get(info['reason'], info['reason']),
+        when, info['used'], len(samples)))
+    if samples:
+        print('covers %.1f s: %u .. %u ms' % ((samples[-1][0] - samples[0][0]) / 1000.0,
+                                              samples[0][0], samples[-1][0]))
+
+    rows = [(t, ch, c, b, b * BUS_MV_PER_LSB, c * info['lsb_ua'][ch] / 1000.0)
+            for t, ch, c, b in samples]
+    if args.output:
+        with open(args.output, 'w', newline='') as f:
+            w = csv.writer(f)
+            w.writerow(['t_ms', 'ch', 'current_raw', 'bus_raw', 'voltage_mV', 'current_mA'])
+            w.writerows(rows)
+    for t, ch, _, _, v, i in rows[-args.tail:]:
+        print('%10u ch%u %9.2fmV %9.2fmA' % (t, ch, v, i))
+
+
+if __name__ == '__main__':
+    main()
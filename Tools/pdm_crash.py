@@ -0,0 +1,108 @@
+#!/usr/bin/env python3
+"""接收并解码 PDM 启动时发送的崩溃记录（Core/Inc/pdm_crash.h，CAN ID 0x315）。
+
+用法：
+    python pdm_crash.py                                 # 等待下一次启动（socketcan can0）
+    python pdm_crash.py -n 1 -i pcan -c PCAN_USBBUS1    # 节点 1
+    python pdm_crash.py --elf Debug/PDM.elf             # 用 addr2line 显示 pc、lr 所在的函数和行号
+
+崩溃后 PDM 立即复位，启动后约 100 ms 内发完 17 帧；任务序号按固件 g_tasks[] 的顺序（命令行 crash 显示名称）。
+需要 python-can。
+"""
+import argparse
+import subprocess
+import sys
+import time
+
+CRASH_ID = 0x315
+NODE_STRIDE = 0x100
+VALUES = 15
+PAGES = 17
+NO_TASK = 0xFF
+
+TYPES = {1: 'hardfault', 2: 'nmi', 3: 'error handler'}
+NAMES = ('tick_ms', 'pc', 'lr', 'xpsr', 'sp', 'cfsr', 'hfsr', 'bfar', 'mmfar',
+         'r0', 'r1', 'r2', 'r3', 'r12', 'exc_return')
+CFSR_BITS = ((0, 'IACCVIOL'), (1, 'DACCVIOL'), (3, 'MUNSTKERR'), (4, 'MSTKERR'), (7, 'MMARVALID'),
+             (8, 'IBUSERR'), (9, 'PRECISERR'), (10, 'IMPRECISERR'), (11, 'UNSTKERR'), (12, 'STKERR'),
+             (15, 'BFARVALID'), (16, 'UNDEFINSTR'), (17, 'INVSTATE'), (18, 'INVPC'), (19, 'NOCP'),
+             (24, 'UNALIGNED'), (25, 'DIVBYZERO'))
+HFSR_BITS = ((1, 'VECTTBL'), (30, 'FORCED'), (31, 'DEBUGEVT'))
+
+
+def flags(v, bits):
+    return '|'.join(n for b, n in bits if v >> b & 1) or '-'
+
+
+def receive(bus, can_id, timeout):
+    """返回 {页号: 数据}，收齐或超时（收到第一帧后 1 s）为止"""
+    pages, end = {}, time.time() + timeout
+    while time.time() < end and len(pages) < PAGES:
+        msg = bus.recv(max(end - time.time(), 0.001))
+        if msg is None or msg.arbitration_id != can_id or msg.is_extended_id or len(msg.data) != 8:
+            continue
+        if not pages:
+            end = min(end, time.time() + 1.0)
+        pages[msg.data[0]] = bytes(msg.data)
+    return pages
+
+
+def addr2line(elf, addr):
+    try:
+        out = subprocess.run(['arm-none-eabi-addr2line', '-f', '-e', elf, '0x%08X' % (addr & ~1)],
+                             capture_output=True, text=True, check=True).stdout.split()
+    except (OSError, subprocess.CalledProcessError):
+        return ''
+    return '  %s %s' % tuple(out[:2]) if len(out) >= 2 else ''
+
+
+def show(pages, elf):
+    missing = [p for p in range(PAGES) if p not in pages]
+    first = next(iter(pages.values()))
+    typ = first[1]
+    v = {NAMES[p]: int.from_bytes(pages[p][2:6], 'big') for p in range(VALUES) if p in pages}
+    task, count = (pages[0][6], pages[0][7]) if 0 in pages else (NO_TASK, 0)
+    trace = [t for p in range(VALUES, PAGES) if p in pages for t in pages[p][2:] if t != NO_TASK]
+
+    print('crash %u since power-on: %s, task %s%s' % (count, TYPES.get(typ, 'type %u' % typ),
+                                                      '-' if task == NO_TASK else task,
+                                                      ' (in interrupt %u)' % (v['xpsr'] & 0x1FF)
+                                                      if v.get('xpsr', 0) & 0x1FF else ''))
+    for name in NAMES:
+        if name in v:
+            extra = ''
+            if name in ('pc', 'lr') and elf:
+                extra = addr2line(elf, v[name])
+            elif name == 'cfsr':
+                extra = '  ' + flags(v[name], CFSR_BITS)
+            elif name == 'hfsr':
+                extra = '  ' + flags(v[name], HFSR_BITS)
+            print('  %-10s %s%s' % (name, '%u' % v[name] if name == 'tick_ms' else '%08X' % v[name], extra))
+    print('  recent tasks (newest first): %s' % (' '.join('%u' % t for t in trace) or '-'))
+    if missing:
+        print('  missing pages: %s' % ' '.join('%u' % p for p in missing))
+
+
+def main():
+    ap = argparse.ArgumentParser(description='PDM crash record receiver')
+    ap.add_argument('-n', '--node', type=int, default=0)
+    ap.add_argument('-i', '--interface', default='socketcan')
+    ap.add_argument('-c', '--channel', default='can0')
+    ap.add_argument('-b', '--bitrate', type=int, default=500000)
+    ap.add_argument('-t', '--timeout', type=float, default=3600.0, help='等待第一帧的时间 (s)')
+    ap.add_argument('--elf', help='固件 ELF，用于显示函数和行号')
+    args = ap.parse_args()
+
+    bus = can.Bus(interface=args.interface, channel=args.channel, bitrate=args.bitrate)
+    try:
+        pages = receive(bus, CRASH_ID + args.node * NODE_STRIDE, args.timeout)
+    finally:
+        bus.shutdown()
+    if not pages:
+        sys.exit('no crash record received')
+    show(pages, args.elf)
+
+
+if __name__ == '__main__':
+    import can
+    main()
@@ -0,0 +1,85 @@
+#!/usr/bin/env python3
+"""PDM 故障/事件记录解码（固件 PDM_CFG_EVLOG=1）。
+
+用法：
+    python pdm_evlog.py events.bin                  # 从最新一条开始，每行一个事件
+    python pdm_evlog.py events.bin -o events.csv    # 同时写入 CSV
+
+events.bin 为 ISO-TP 请求 [0x01, 0x05] 或 [0x01, 0x05, N] 的响应去掉前两个字节（0x41 0x05）后的数据，
+每条 16 字节，小端，格式见 Core/Inc/pdm_evlog.h。时间从每次启动开始计，
+同一次启动的事件排在该次启动记录 (boot) 之后（序号更大）。
+"""
+import argparse
+import csv
+import struct
+
+REC = struct.Struct('<IIBBHHH')
+
+TYPES = {1: 'boot', 2: 'trip', 3: 'alert', 4: 'offline', 5: 'online', 6: 'busoff', 7: 'crash'}
+FAULTS = {1: 'bus over power', 2: 'bat under volt', 3: 'over current', 4: 'i2t', 5: 'under volt'}
+CRASHES = {1: 'hardfault', 2: 'nmi', 3: 'error handler'}
+RESETS = ((0x01, 'por'), (0x02, 'pin'), (0x04, 'soft'), (0x08, 'iwdg'), (0x10, 'wwdg'), (0x20, 'lpwr'))
+
+
+def crc16(data):
+    """CRC16-CCITT（初值 0xFFFF，不反转），与固件 pdm_calc_crc16() 相同"""
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+def describe(typ, arg, value):
+    if typ == 1:
+        causes = [n for bit, n in RESETS if arg & bit] or ['-']
+        return 'reset %s, boot %u' % ('|'.join(causes), value)
+    if typ in (2, 3):
+        return '%s, count %u' % (FAULTS.get(arg, 'type %u' % arg), value)
+    if typ == 4:
+        return 'read errors %u' % value
+    if typ == 5:
+        return 'reinit %u' % value
+    if typ == 6:
+        return 'tec %u, bus-off %u' % (arg, value)
+    if typ == 7:
+        return '%s, pc 0x....%04X' % (CRASHES.get(arg, 'type %u' % arg), value)
+    return 'arg %u value %u' % (arg, value)
+
+
+def decode(data):
+    """返回 [(序号, 时间 ms, 类型, 通道或 None, 参数, 值, CRC 正确)]，顺序与下载相同（最新在前）"""
+    events = []
+    for off in range(0, len(data) - REC.size + 1, REC.size):
+        seq, tick, typ, ch, arg, value, crc = REC.unpack_from(data, off)
+        ok = crc == crc16(data[off:off + REC.size - 2])
+        events.append((seq, tick, typ, None if ch == 0xFF else ch, arg, value, ok))
+    return events
+
+
+def main():
+    ap = argparse.ArgumentParser(description='PDM event log decoder')
+    ap.add_argument('file')
+    ap.add_argument('-o', '--output', help='CSV 输出文件')
+    args = ap.parse_args()
+
+    with open(args.file, 'rb') as f:
+        events = decode(f.read())
+
+    for seq, tick, typ, ch, arg, value, ok in events:
+        print('#%-6u %10.3f s  %-8s %-4s %s%s' % (seq, tick / 1000.0, TYPES.get(typ, '?%u' % typ),
+                                                  '' if ch is None else 'ch%u' % ch, describe(typ, arg, value),
+                                                  '' if ok else '  (CRC error)'))
+
+    if args.output:
+        with open(args.output, 'w', newline='') as f:
+            w = csv.writer(f)
+            w.writerow(['seq', 'tick_ms', 'type', 'ch', 'arg', 'value', 'crc_ok'])
+            for seq, tick, typ, ch, arg, value, ok in events:
+                w.writerow([seq, tick, TYPES.get(typ, typ), '' if ch is None else ch, arg, value, int(ok)])
+
+
+if __name__ == '__main__':
+    main()
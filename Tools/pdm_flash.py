@@ -0,0 +1,162 @@
+#!/usr/bin/env python3
+"""通过 CAN 更新 PDM 程序（CAN 引导程序，Boot/pdm_bootloader.c；应用程序用 make BOOT=1 编译）。
+
+用法：
+    python pdm_flash.py Debug-boot/PDM.bin                      # 命令 PDM 进入引导程序后写入（socketcan can0）
+    python pdm_flash.py PDM.bin -n 1 -i pcan -c PCAN_USBBUS1    # 节点 1
+    python pdm_flash.py PDM.bin --no-enter                      # PDM 已停在引导程序中（上次更新没有完成）
+
+协议见 Core/Inc/pdm_boot.h。每页先比较 CRC，相同的页不再发送，中途断开后重新运行即可从断开处继续；
+全部写完后校验整个镜像的 CRC，通过后才运行新程序。需要 python-can。
+"""
+import argparse
+import sys
+import time
+
+CMD_ID = 0x310
+CMD_REPLY_ID = 0x311
+CMD_BOOT = 0x0E
+BOOT_KEY = (0xB0, 0x07)
+TP_RX_ID = 0x340            # PDM 接收（上位机发送）
+TP_TX_ID = 0x341
+NODE_STRIDE = 0x100
+PAGE = 1024
+
+REQ_INFO, REQ_START, REQ_WRITE, REQ_CRC, REQ_COMMIT, REQ_RUN = 0x10, 0x11, 0x12, 0x13, 0x14, 0x15
+STATES = {0: 'valid', 1: 'updating', 2: 'empty'}
+NRC = {0x11: 'not supported', 0x13: 'length', 0x22: 'conditions', 0x31: 'range', 0x72: 'programming failed'}
+
+
+def crc16(data):
+    """CRC16-CCITT（初值 0xFFFF，不反转），与固件 pdm_calc_crc16() 相同"""
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+class Boot:
+    def __init__(self, bus, node):
+        self.bus = bus
+        self.rx_id = TP_RX_ID + node * NODE_STRIDE
+        self.tx_id = TP_TX_ID + node * NODE_STRIDE
+
+    def _send(self, data):
+        data = bytes(data) + b'\xCC' * (8 - len(data))
+        self.bus.send(can.Message(arbitration_id=self.rx_id, data=data, is_extended_id=False))
+
+    def _recv(self, timeout):
+        end = time.time() + timeout
+        while time.time() < end:
+            msg = self.bus.recv(max(end - time.time(), 0.001))
+            if msg is not None and msg.arbitration_id == self.tx_id and not msg.is_extended_id:
+                return bytes(msg.data)
+        return None
+
+    def request(self, payload, timeout=1.0):
+        """发送一个请求（单帧或首帧 + 连续帧），返回单帧响应的内容；超时返回 None"""
+        if len(payload) <= 7:
+            self._send([len(payload)] + list(payload))
+        else:
+            self._send([0x10 | (len(payload) >> 8), len(payload) & 0xFF] + list(payload[:6]))
+            fc = self._recv(1.0)
+            if fc is None or fc[0] != 0x30:
+                return None
+            stmin = fc[2] / 1000.0 if fc[2] <= 0x7F else 0.0
+            sn, pos = 1, 6
+            while pos < len(payload):
+                self._send([0x20 | sn] + list(payload[pos:pos + 7]))
+                sn, pos = (sn + 1) & 0x0F, pos + 7
+                if stmin:
+                    time.sleep(stmin)
+        rsp = self._recv(timeout)
+        if rsp is None or rsp[0] >> 4 != 0 or not 0 < (rsp[0] & 0x0F) <= 7:
+            return None
+        rsp = rsp[1:1 + (rsp[0] & 0x0F)]
+        if rsp[0] == 0x7F:
+            raise RuntimeError('request 0x%02X rejected: %s' % (rsp[1], NRC.get(rsp[2], '0x%02X' % rsp[2])))
+        if rsp[0] != payload[0] + 0x40:
+            return None
+        return rsp
+
+    def retry(self, payload, timeout=1.0, tries=3):
+        for _ in range(tries):
+            rsp = self.request(payload, timeout)
+            if rsp is not None:
+                return rsp
+        raise RuntimeError('no response to request 0x%02X' % payload[0])
+
+
+def enter(bus, node):
+    """应用程序中发送 PDM_CMD_BOOT，等回复"""
+    bus.send(can.Message(arbitration_id=CMD_ID + node * NODE_STRIDE, data=[CMD_BOOT, *BOOT_KEY],
+                         is_extended_id=False))
+    end = time.time() + 1.0
+    while time.time() < end:
+        msg = bus.recv(0.1)
+        if msg is not None and msg.arbitration_id == CMD_REPLY_ID + node * NODE_STRIDE and msg.data[0] == CMD_BOOT:
+            if msg.data[1] != 0:
+                sys.exit('PDM refused to enter the bootloader (built without BOOT=1?)')
+            return
+    print('no reply to the boot command, trying the bootloader anyway')
+
+
+def main():
+    ap = argparse.ArgumentParser(description='PDM firmware update over CAN')
+    ap.add_argument('file', help='make BOOT=1 生成的 PDM.bin')
+    ap.add_argument('-n', '--node', type=int, default=0)
+    ap.add_argument('-i', '--interface', default='socketcan')
+    ap.add_argument('-c', '--channel', default='can0')
+    ap.add_argument('-b', '--bitrate', type=int, default=500000)
+    ap.add_argument('--no-enter', action='store_true', help='不发送进入引导程序的命令')
+    args = ap.parse_args()
+
+    with open(args.file, 'rb') as f:
+        image = f.read()
+    pages = [image[i:i + PAGE].ljust(PAGE, b'\xFF') for i in range(0, len(image), PAGE)]
+
+    bus = can.Bus(interface=args.interface, channel=args.channel, bitrate=args.bitrate)
+    boot = Boot(bus, args.node)
+    try:
+        if not args.no_enter:
+            enter(bus, args.node)
+        info = None
+        for _ in range(20):
+            info = boot.request([REQ_INFO], 0.25)
+            if info is not None:
+                break
+        if info is None:
+            sys.exit('bootloader not responding')
+        print('bootloader v%u, %s, node %u, %u pages' % (info[1], STATES.get(info[2], '?'), info[3], info[4]))
+        if len(pages) > info[4]:
+            sys.exit('image is %u bytes, the application area holds %u' % (len(image), info[4] * PAGE))
+
+        t0 = time.time()
+        if info[2] != 1:
+            boot.retry([REQ_START], 1.0)
+        written = 0
+        for n, data in enumerate(pages):
+            rsp = boot.retry([REQ_CRC, n])
+            if (rsp[2] << 8 | rsp[3]) == crc16(data):
+                continue
+            # 擦页 + 编程约 50 ms
+            boot.retry(bytes([REQ_WRITE, n]) + data, 2.0)
+            written += 1
+            print('\rpage %u/%u' % (n + 1, len(pages)), end='', flush=True)
+        crc = crc16(image)
+        boot.retry([REQ_COMMIT] + list(len(image).to_bytes(4, 'big')) + [crc >> 8, crc & 0xFF], 3.0)
+        print('\r%u bytes, %u of %u pages written, CRC %04X, %.1f s' % (len(image), written, len(pages), crc,
+                                                                      time.time() - t0))
+        boot.retry([REQ_RUN])
+    except RuntimeError as e:
+        sys.exit(str(e))
+    finally:
+        bus.shutdown()
+
+
+if __name__ == '__main__':
+    import can
+    main()
@@ -0,0 +1,68 @@
+#!/usr/bin/env python3
+"""PDM 电流分布计数解码（固件 PDM_CFG_HIST=1）。
+
+用法：
+    python pdm_hist.py hist.bin                     # 每通道一张表：电流区间、采样数、占比
+    python pdm_hist.py hist.bin -o hist.csv         # 同时写入 CSV
+
+hist.bin 为 ISO-TP 请求 [0x01, 0x04] 的响应去掉前两个字节（0x41 0x04）后的数据，
+格式见 Core/Inc/pdm_hist.h。计数为采样数，定时采样时乘以采样周期即为时间。
+"""
+import argparse
+import csv
+import struct
+
+FLOOR_BITS = 8
+FULL_SCALE = 0x7FFF
+
+
+def edge_raw(b, bins):
+    """档 b 的下限（电流寄存器原始值），与固件 PDM_Hist_EdgeRaw() 相同"""
+    if b == 0:
+        return 0
+    if b >= bins - 1:
+        return FULL_SCALE
+    return (2 + ((b - 1) & 1)) << (FLOOR_BITS - 1 + (b - 1) // 2)
+
+
+def decode(data):
+    """返回 (每通道电流 LSB uA 列表, 每通道计数列表)"""
+    nch, bins = data[0], data[1]
+    lsb = list(struct.unpack_from('>%dI' % nch, data, 4))
+    pos = 4 + 4 * nch
+    counts = []
+    for _ in range(nch):
+        counts.append(list(struct.unpack_from('>%dI' % bins, data, pos)))
+        pos += 4 * bins
+    return lsb, counts
+
+
+def main():
+    ap = argparse.ArgumentParser(description='PDM current histogram decoder')
+    ap.add_argument('file')
+    ap.add_argument('-o', '--output', help='CSV 输出文件')
+    args = ap.parse_args()
+
+    with open(args.file, 'rb') as f:
+        lsb, counts = decode(f.read())
+
+    rows = []
+    for ch, (ua, c) in enumerate(zip(lsb, counts)):
+        bins = len(c)
+        total = sum(c) or 1
+        print('ch%u: %u samples, LSB %u uA' % (ch, sum(c), ua))
+        for b, n in enumerate(c):
+            lo = edge_raw(b, bins) * ua / 1000.0
+            hi = edge_raw(b + 1, bins) * ua / 1000.0 if b + 1 < bins else float('inf')
+            rows.append((ch, b, lo, hi, n))
+            print('  %2u %9.1f .. %9.1f mA %10u %6.2f%%' % (b, lo, hi, n, 100.0 * n / total))
+
+    if args.output:
+        with open(args.output, 'w', newline='') as f:
+            w = csv.writer(f)
+            w.writerow(['ch', 'bin', 'from_mA', 'to_mA', 'samples'])
+            w.writerows(rows)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,47 @@
+#!/usr/bin/env python3
+"""PDM 采样序列压缩块解码（固件 Core/Src/pdm_pack.c）。
+
+块格式：[n][w][第一个值 zigzag LEB128][n-1 个差分 zigzag，每个 w 位，高位在前]。
+decode_block(data, pos) 返回 (值列表, 下一块位置)；值为 32 位有符号整数，
+无符号字段（总线电压、功率、时间戳）按需要 & 0xFFFF / & 0xFFFFFFFF。
+"""
+
+
+def unzigzag(z):
+    return (z >> 1) ^ -(z & 1)
+
+
+def decode_block(data, pos=0):
+    n, w = data[pos], data[pos + 1]
+    pos += 2
+    first, shift = 0, 0
+    while True:
+        b = data[pos]
+        pos += 1
+        first |= (b & 0x7F) << shift
+        shift += 7
+        if not b & 0x80:
+            break
+    values = [unzigzag(first)]
+    nbits = (n - 1) * w
+    acc = int.from_bytes(data[pos:pos + (nbits + 7) // 8], 'big')
+    acc >>= (8 - nbits % 8) % 8
+    pos += (nbits + 7) // 8
+    mask = (1 << w) - 1
+    for i in range(n - 1):
+        z = (acc >> ((n - 2 - i) * w)) & mask if w else 0
+        # 差分按 32 位回绕
+        v = (values[-1] + unzigzag(z)) & 0xFFFFFFFF
+        values.append(v - (1 << 32) if v & 0x80000000 else v)
+    return values, pos
+
+
+def decode_capture(data):
+    """高速采集压缩数据（0x321 帧去掉序号后依次拼接）：交替的电流块和间隔块。
+    返回 [(电流原始值, 间隔 us), ...]"""
+    out, pos = [], 0
+    while pos < len(data):
+        cur, pos = decode_block(data, pos)
+        dt, pos = decode_block(data, pos)
+        out += zip(cur, [d & 0xFFFF for d in dt])
+    return out
@@ -0,0 +1,114 @@
+#!/usr/bin/env python3
+"""CAN 往返延迟测试（Core/Inc/pdm_ping.h，请求 0x360，回复 0x361/0x362）。
+
+用法：
+    python pdm_ping.py                                  # 1000 次，间隔 10 ms（socketcan can0）
+    python pdm_ping.py -N 10000 -p 2 -l 8 -n 1          # 节点 1，8 字节请求
+    python pdm_ping.py -i pcan -c PCAN_USBBUS1 -o ping.csv
+
+每次发送 [序号, 填充...]，等待原样回复和时间帧，输出往返时间、PDM 内部两段（接收中断到命令任务取出、
+到回复入队）和其余部分（总线、发送队列、上位机）的分布。往返时间用接收帧的时间戳（接口支持时），
+否则为上位机时间，包含上位机调度的抖动。需要 python-can。
+"""
+import argparse
+import csv
+import sys
+import time
+
+PING_ID = 0x360
+NODE_STRIDE = 0x100
+SAT = 0xFFFF
+
+
+def percentiles(values, ps=(0, 50, 90, 99, 99.9, 100)):
+    s = sorted(values)
+    return [s[min(len(s) - 1, int(round(p / 100.0 * (len(s) - 1))))] for p in ps]
+
+
+def histogram(name, values, bins=10, width=40):
+    lo, hi = min(values), max(values)
+    step = max((hi - lo) / bins, 1)
+    counts = [0] * bins
+    for v in values:
+        counts[min(bins - 1, int((v - lo) / step))] += 1
+    top = max(counts)
+    print('%s (us):' % name)
+    for i, c in enumerate(counts):
+        print('  %8.0f ~ %8.0f %7u %s' % (lo + i * step, lo + (i + 1) * step, c, '#' * (c * width // top)))
+
+
+def ping_once(bus, args, base, seq):
+    """返回 (往返 us, 取出 us, 入队 us)，超时返回 None"""
+    data = bytes([seq]) + bytes(range(1, args.length))
+    msg = can.Message(arbitration_id=base, data=data, is_extended_id=False)
+    t0 = time.time()
+    bus.send(msg)
+    echo = timing = None
+    end = t0 + args.timeout
+    while time.time() < end and (echo is None or timing is None):
+        r = bus.recv(max(end - time.time(), 0.001))
+        if r is None or r.is_extended_id:
+            continue
+        if r.arbitration_id == base + 1 and bytes(r.data) == data:
+            t = r.timestamp if abs(r.timestamp - time.time()) < 1.0 else time.time()
+            echo = (t - t0) * 1e6
+        elif r.arbitration_id == base + 2 and len(r.data) == 8 and r.data[0] == seq:
+            timing = (int.from_bytes(r.data[1:3], 'big'), int.from_bytes(r.data[3:5], 'big'))
+    if echo is None or timing is None:
+        return None
+    return echo, timing[0], timing[1]
+
+
+def main():
+    ap = argparse.ArgumentParser(description='PDM CAN round-trip latency test')
+    ap.add_argument('-N', '--count', type=int, default=1000)
+    ap.add_argument('-p', '--period', type=float, default=10.0, help='请求间隔 (ms)')
+    ap.add_argument('-l', '--length', type=int, default=8, choices=range(1, 9), help='请求字节数')
+    ap.add_argument('-n', '--node', type=int, default=0)
+    ap.add_argument('-i', '--interface', default='socketcan')
+    ap.add_argument('-c', '--channel', default='can0')
+    ap.add_argument('-b', '--bitrate', type=int, default=500000)
+    ap.add_argument('-t', '--timeout', type=float, default=0.1, help='每次等待回复的时间 (s)')
+    ap.add_argument('-o', '--output', help='每次结果写入 CSV')
+    args = ap.parse_args()
+
+    base = PING_ID + args.node * NODE_STRIDE
+    rows, lost = [], 0
+    bus = can.Bus(interface=args.interface, channel=args.channel, bitrate=args.bitrate)
+    try:
+        for i in range(args.count):
+            r = ping_once(bus, args, base, i & 0xFF)
+            if r is None:
+                lost += 1
+            else:
+                rows.append(r)
+            time.sleep(max(args.period / 1000.0 - (r[0] / 1e6 if r else args.timeout), 0))
+    except KeyboardInterrupt:
+        pass
+    finally:
+        bus.shutdown()
+    if not rows:
+        sys.exit('no reply (%u lost)' % lost)
+
+    if args.output:
+        with open(args.output, 'w', newline='') as f:
+            w = csv.writer(f)
+            w.writerow(['rtt_us', 'rx_to_poll_us', 'rx_to_queued_us'])
+            w.writerows(('%.0f' % a, b, c) for a, b, c in rows)
+
+    rtt = [r[0] for r in rows]
+    proc = [r[1] for r in rows]
+    enq = [r[2] for r in rows]
+    rest = [a - c for a, _, c in rows]
+    sat = sum(1 for r in rows if r[1] == SAT or r[2] == SAT)
+    print('%u replies, %u lost, %u saturated' % (len(rows), lost, sat))
+    print('%-14s %8s %8s %8s %8s %8s %8s' % ('us', 'min', 'p50', 'p90', 'p99', 'p99.9', 'max'))
+    for name, v in (('round trip', rtt), ('rx->poll', proc), ('rx->queued', enq), ('bus+host', rest)):
+        print('%-14s' % name + ''.join(' %8.0f' % x for x in percentiles(v)))
+    histogram('round trip', rtt)
+    histogram('rx->poll', proc)
+
+
+if __name__ == '__main__':
+    import can
+    main()
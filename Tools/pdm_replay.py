@@ -0,0 +1,118 @@
+#!/usr/bin/env python3
+"""把记录的采样流通过 CAN 回放给 PDM（固件 PDM_CFG_REPLAY=1，make REPLAY=1）。
+
+用法：
+    python pdm_replay.py log.csv                          # 按记录的时间实时回放（socketcan can0）
+    python pdm_replay.py log.csv -s 5                     # 5 倍速，PDM 采样周期要相应缩短（命令 0x02）
+    python pdm_replay.py log.csv -s 0 -i pcan -c PCAN_USBBUS1 -b 500000   # 按 PDM 的队列空位尽快发送
+
+输入为 pdm_stream.py 保存的 CSV（t_us、ch、bus_raw、shunt_raw 列），帧格式见 Core/Inc/pdm_replay.h。
+采样流中的分流值已做零点修正，回放前把 PDM 的零点参数设为 0，否则修正两次。
+按 PDM 每 100 ms 的状态帧中的队列空位控制发送，结束时显示 PDM 的统计。
+需要 python-can。
+"""
+import argparse
+import csv
+import sys
+import time
+
+REPLAY_ID = 0x350
+STATUS_ID = 0x30E
+FLAG_START = 0x80
+DT_US_PER_LSB = 100
+MARGIN = 2              # 按状态帧发送时少用的空位（状态帧之后到达的帧）
+
+
+def load(path):
+    """返回 [(t_us, ch, shunt, bus, dt)]，dt 为同一通道与上一条的间隔（100 us）"""
+    recs, last = [], {}
+    with open(path, newline='') as f:
+        for row in csv.DictReader(f):
+            if not row['bus_raw']:
+                continue        # 高速电流流的样本没有总线电压
+            t, ch = int(row['t_us']), int(row['ch'])
+            dt_us = (t - last[ch]) & 0xFFFFFFFF if ch in last else 0
+            last[ch] = t
+            if dt_us == 0:
+                continue        # 每个通道的第一条只用来确定间隔
+            dt = min(max(round(dt_us / DT_US_PER_LSB), 1), 0xFFFF)
+            recs.append((t, ch, int(row['shunt_raw']), int(row['bus_raw']), dt))
+    return recs
+
+
+def frame(rec, seq, start):
+    _, ch, shunt, bus, dt = rec
+    return bytes([(FLAG_START if start else 0) | ch]) + (shunt & 0xFFFF).to_bytes(2, 'big') + \
+        bus.to_bytes(2, 'big') + dt.to_bytes(2, 'big') + bytes([seq & 0xFF])
+
+
+def status(msg):
+    d = msg.data
+    return {'free': d[0], 'lost': d[1], 'served': int.from_bytes(d[2:4], 'big'),
+            'stale': int.from_bytes(d[4:6], 'big'), 'overflow': int.from_bytes(d[6:8], 'big')}
+
+
+def wait_status(bus, timeout):
+    end = time.monotonic() + timeout
+    while time.monotonic() < end:
+        msg = bus.recv(end - time.monotonic())
+        if msg is not None and msg.arbitration_id == STATUS_ID and len(msg.data) == 8:
+            return status(msg)
+    return None
+
+
+def main():
+    ap = argparse.ArgumentParser(description='PDM trace replay over CAN')
+    ap.add_argument('file', help='pdm_stream.py 保存的 CSV')
+    ap.add_argument('-s', '--speed', type=float, default=1.0, help='回放速度，0 为按队列空位尽快发送')
+    ap.add_argument('-i', '--interface', default='socketcan')
+    ap.add_argument('-c', '--channel', default='can0')
+    ap.add_argument('-b', '--bitrate', type=int, default=500000)
+    args = ap.parse_args()
+
+    recs = load(args.file)
+    if not recs:
+        sys.exit('no samples in %s' % args.file)
+
+    import can
+    bus = can.Bus(interface=args.interface, channel=args.channel, bitrate=args.bitrate)
+    st = wait_status(bus, 1.0)
+    if st is None:
+        sys.exit('no replay status frame 0x%03X, firmware not built with REPLAY=1?' % STATUS_ID)
+
+    credit = st['free'] - MARGIN
+    t_first = recs[0][0]
+    wall0 = time.monotonic()
+    try:
+        for n, rec in enumerate(recs):
+            if args.speed > 0:
+                delay = wall0 + ((rec[0] - t_first) & 0xFFFFFFFF) / 1e6 / args.speed - time.monotonic()
+                if delay > 0:
+                    time.sleep(delay)
+            while credit <= 0:
+                st = wait_status(bus, 1.0)
+                if st is None:
+                    sys.exit('replay status frame lost')
+                credit = st['free'] - MARGIN
+            bus.send(can.Message(arbitration_id=REPLAY_ID, data=frame(rec, n, n == 0), is_extended_id=False))
+            credit -= 1
+            msg = bus.recv(0)
+            while msg is not None:      # 按最新的状态帧重新计算空位，其他帧丢掉
+                if msg.arbitration_id == STATUS_ID and len(msg.data) == 8:
+                    credit = status(msg)['free'] - MARGIN
+                msg = bus.recv(0)
+    except KeyboardInterrupt:
+        n = n - 1
+    wall = time.monotonic() - wall0
+
+    time.sleep(0.5)             # 等 PDM 取完队列中的记录
+    st = wait_status(bus, 1.0)
+    bus.shutdown()
+    sys.stderr.write('sent %u in %.1f s (%.0f/s)\n' % (n + 1, wall, (n + 1) / wall if wall > 0 else 0))
+    if st is not None:
+        sys.stderr.write('pdm served %u, stale %u, overflow %u, lost %u (16-bit counters)\n' %
+                         (st['served'], st['stale'], st['overflow'], st['lost']))
+
+
+if __name__ == '__main__':
+    main()
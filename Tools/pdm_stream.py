@@ -0,0 +1,221 @@
+#!/usr/bin/env python3
+"""PDM UART 二进制采样流解码（固件 PDM_CFG_UART_STREAM=1）。
+
+用法：
+    python pdm_stream.py COM5 -o log.csv            # 921600 baud，记录到 CSV
+    python pdm_stream.py /dev/ttyUSB0 -b 2000000    # 只在终端显示
+    python pdm_stream.py - < capture.bin            # 解码已保存的原始数据
+
+帧格式见 Core/Inc/pdm_stream.h，压缩帧（PDM_CFG_UART_STREAM_PACK=1）用 pdm_pack.py 解码。
+CRC 错误的帧计数，非帧数据（文本日志）原样显示。
+固件打开 PDM_CFG_TIMESYNC 时按最近的时间帧把采样时间戳换算成车辆时间（CSV 的 t_vehicle_us 列，未同步时为空）。
+只测电流的高速采样流（PDM_CFG_CAPTURE_FAST）的电流帧每个样本一行，只有分流值，其他列为空；
+结束时显示固件报告的丢弃样本数。
+"""
+import argparse
+import csv
+import os
+import struct
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from pdm_pack import decode_block  # noqa: E402
+
+TYPE_SAMPLE = 0x01
+TYPE_INFO = 0x02
+TYPE_PACKED = 0x03
+TYPE_TIME = 0x04
+TYPE_FAST = 0x05
+
+BUS_MV_PER_LSB = 1.25
+SHUNT_UV_PER_LSB = 2.5
+
+
+def crc16(data):
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) & 0xFFFF if crc & 0x8000 else (crc << 1) & 0xFFFF
+    return crc
+
+
+def cobs_decode(data):
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data) + 1:
+            return None
+        out += data[i + 1:i + code]
+        i += code
+        if code < 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def parse(chunk):
+    """返回 (类型, 数据) ；不是有效帧时返回 None"""
+    raw = cobs_decode(chunk)
+    if raw is None or len(raw) < 3:
+        return None
+    body, crc = raw[:-2], struct.unpack('<H', raw[-2:])[0]
+    if crc16(body) != crc:
+        return None
+    return body[0], body
+
+
+class Decoder:
+    def __init__(self, writer=None, quiet=False):
+        self.buf = bytearray()
+        self.lsb_ua = {}
+        self.last_seq = None
+        self.time_ref = None        # (本地 us, 车辆 us)
+        self.samples = 0
+        self.lost = 0
+        self.bad = 0
+        self.fast_dropped = None    # 电流帧中固件累计丢弃的样本数
+        self.writer = writer
+        self.quiet = quiet
+
+    def feed(self, data):
+        self.buf += data
+        while True:
+            end = self.buf.find(b'\x00')
+            if end < 0:
+                break
+            chunk = bytes(self.buf[:end])
+            del self.buf[:end + 1]
+            if chunk:
+                self.chunk(chunk)
+
+    def chunk(self, chunk):
+        frame = parse(chunk)
+        if frame is None:
+            text = chunk.decode('ascii', 'replace')
+            if text.isprintable() or text.endswith('\n'):
+                sys.stderr.write(text)
+            else:
+                self.bad += 1
+            return
+        ftype, body = frame
+        if ftype == TYPE_INFO and len(body) >= 2:
+            n = body[1]
+            for ch in range(n):
+                self.lsb_ua[ch] = struct.unpack_from('<I', body, 2 + 4 * ch)[0]
+        elif ftype == TYPE_SAMPLE and len(body) == 15:
+            ch, seq, ts, bus, shunt, cur, pwr = struct.unpack('<BBIHhhH', body[1:])
+            self.count_seq(seq)
+            self.sample(ch, ts, bus, shunt, cur, pwr)
+        elif ftype == TYPE_PACKED and len(body) > 3:
+            self.packed(body)
+        elif ftype == TYPE_FAST and len(body) >= 12 and len(body) == 12 + 4 * body[11]:
+            self.fast(body)
+        elif ftype == TYPE_TIME and len(body) == 14:
+            state, local, vehicle = struct.unpack('<BIQ', body[1:])
+            self.time_ref = (local, vehicle) if state != 0 else None
+
+    def count_seq(self, seq):
+        if self.last_seq is not None:
+            self.lost += (seq - self.last_seq - 1) & 0xFF
+        self.last_seq = seq
+
+    def packed(self, body):
+        ch, seq = body[1], body[2]
+        fields, pos = [], 3
+        try:
+            for _ in range(5):
+                values, pos = decode_block(body, pos)
+                fields.append(values)
+        except IndexError:
+            self.bad += 1
+            return
+        self.count_seq(seq)
+        ts, bus, shunt, cur, pwr = fields
+        for i in range(len(ts)):
+            self.sample(ch, ts[i] & 0xFFFFFFFF, bus[i] & 0xFFFF, shunt[i], cur[i], pwr[i] & 0xFFFF)
+
+    def fast(self, body):
+        ch, seq, t0, dropped, n = struct.unpack_from('<BBIIB', body, 1)
+        self.count_seq(seq)
+        self.fast_dropped = dropped
+        ts = t0
+        for i in range(n):
+            shunt, dt = struct.unpack_from('<hH', body, 12 + 4 * i)
+            if i > 0:
+                ts = (ts + dt) & 0xFFFFFFFF
+            self.samples += 1
+            tv = self.vehicle_us(ts)
+            if self.writer:
+                self.writer.writerow([ts, ch, '', shunt, '', '', '', '', '', '' if tv is None else tv])
+            if not self.quiet:
+                print('%10u ch%u %8.1fuV' % (ts, ch, shunt * SHUNT_UV_PER_LSB))
+
+    def vehicle_us(self, ts):
+        """本地时间戳换算成车辆时间；本地时间 32 位回绕，按有符号差值计算"""
+        if self.time_ref is None:
+            return None
+        local, vehicle = self.time_ref
+        dt = (ts - local) & 0xFFFFFFFF
+        if dt >= 0x80000000:
+            dt -= 0x100000000
+        return vehicle + dt
+
+    def sample(self, ch, ts, bus, shunt, cur, pwr):
+        self.samples += 1
+        tv = self.vehicle_us(ts)
+
+        lsb = self.lsb_ua.get(ch)
+        v_mv = bus * BUS_MV_PER_LSB
+        i_ma = cur * lsb / 1000.0 if lsb else None
+        p_mw = pwr * 25 * lsb / 1000.0 if lsb else None
+        if self.writer:
+            self.writer.writerow([ts, ch, bus, shunt, cur, pwr, v_mv,
+                                  '' if i_ma is None else i_ma, '' if p_mw is None else p_mw,
+                                  '' if tv is None else tv])
+        if not self.quiet:
+            print('%10u ch%u %8.2fmV %8.1fuV' % (ts, ch, v_mv, shunt * SHUNT_UV_PER_LSB) +
+                  ('' if i_ma is None else ' %9.2fmA %9.2fmW' % (i_ma, p_mw)))
+
+
+def main():
+    ap = argparse.ArgumentParser(description='PDM UART binary stream decoder')
+    ap.add_argument('port', help='串口名，或 - 从标准输入读取')
+    ap.add_argument('-b', '--baud', type=int, default=921600)
+    ap.add_argument('-o', '--output', help='CSV 输出文件')
+    ap.add_argument('-q', '--quiet', action='store_true', help='不在终端逐条显示')
+    args = ap.parse_args()
+
+    out = open(args.output, 'w', newline='') if args.output else None
+    writer = csv.writer(out) if out else None
+    if writer:
+        writer.writerow(['t_us', 'ch', 'bus_raw', 'shunt_raw', 'current_raw', 'power_raw',
+                         'voltage_mV', 'current_mA', 'power_mW', 't_vehicle_us'])
+    dec = Decoder(writer, args.quiet)
+
+    if args.port == '-':
+        src = sys.stdin.buffer
+        read = lambda: src.read(4096)
+    else:
+        import serial
+        src = serial.Serial(args.port, args.baud, timeout=0.1)
+        read = lambda: src.read(4096)
+
+    try:
+        while True:
+            data = read()
+            if args.port == '-' and not data:
+                break
+            dec.feed(data)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        if out:
+            out.close()
+        sys.stderr.write('\nsamples %u, lost %u, bad frames %u\n' % (dec.samples, dec.lost, dec.bad))
+        if dec.fast_dropped is not None:
+            sys.stderr.write('fast stream: %u samples dropped on the PDM\n' % dec.fast_dropped)
+
+
+if __name__ == '__main__':
+    main()
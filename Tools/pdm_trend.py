@@ -0,0 +1,139 @@
+#!/usr/bin/env python3
+"""PDM 长时间趋势记录解码（固件 PDM_CFG_TREND=1）。
+
+用法：
+    python pdm_trend.py trend.bin                   # 每组一行概况和每通道的汇总
+    python pdm_trend.py trend.bin -o trend.csv      # 全部记录写入 CSV
+
+trend.bin 为 ISO-TP 请求 [0x01, 0x06] 的响应去掉前两个字节（0x41 0x06）后的数据，
+按页从最旧的开始排列，格式见 Core/Inc/pdm_trend.h，组中的块用 pdm_pack.py 解码。
+时间为累计运行时间 (s)，跨越多次启动连续；上电次数变化表示中间断过电。
+"""
+import argparse
+import csv
+import os
+import struct
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from pdm_pack import decode_block  # noqa: E402
+
+PAGE = 1024
+MAGIC = 0x5447
+HDR = struct.Struct('<HHIIHHBBBB')
+INVALID = 0x7FFF
+FIELDS = ('i_mean_mA', 'i_max_mA', 'v_min_mV', 'energy_mWh')
+CURRENT_MA_PER_LSB = 10
+
+
+def crc16(data):
+    """CRC16-CCITT（初值 0xFFFF，不反转），与固件 pdm_calc_crc16() 相同"""
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+def parse_group(data, pos):
+    """解码 pos 处的一组；返回 (头 dict, [[每通道 [字段...]] 每条记录]) 或 None（CRC 错误）"""
+    magic, length, seq, uptime, boots, interval, n, nch, nfields, _ = HDR.unpack_from(data, pos)
+    body = data[pos:pos + length]
+    if struct.unpack_from('<H', body, length - 2)[0] != crc16(body[2:length - 2]):
+        return None
+    off = HDR.size
+    cols = []
+    for k in range(nch * nfields):
+        values, off = decode_block(body, off)
+        if k % nfields == nfields - 1:
+            values = [v & 0xFFFF for v in values]
+        cols.append(values)
+    records = [[[cols[ch * nfields + f][r] for f in range(nfields)] for ch in range(nch)] for r in range(n)]
+    hdr = {'seq': seq, 'uptime_s': uptime, 'boots': boots, 'interval_s': interval, 'n': n, 'nch': nch}
+    return hdr, records
+
+
+def decode(data):
+    """返回 ([(头 dict, 记录)], CRC 错误组数)，按组序号排序"""
+    groups, bad = [], 0
+    for page in range(0, len(data) - len(data) % PAGE, PAGE):
+        pos = page
+        while pos + HDR.size <= page + PAGE:
+            magic, length = struct.unpack_from('<HH', data, pos)
+            if magic != MAGIC or length < HDR.size + 2 or length & 1 or pos + length > page + PAGE:
+                # 写到一半的组没有标志，跳过这块，后面的组从下一页开始
+                break
+            g = parse_group(data, pos)
+            if g is None:
+                bad += 1
+            else:
+                groups.append(g)
+            pos += length
+    groups.sort(key=lambda g: g[0]['seq'])
+    return groups, bad
+
+
+def rows(groups):
+    """展开为 [(运行时间 s, 上电次数, 通道, 字段...)]，无效字段为 None"""
+    for hdr, records in groups:
+        n = hdr['n']
+        for r, rec in enumerate(records):
+            t = hdr['uptime_s'] - (n - 1 - r) * hdr['interval_s']
+            for ch, f in enumerate(rec):
+                i_mean, i_max, v_min, e = f
+                yield (t, hdr['boots'], ch,
+                       None if i_mean == INVALID else i_mean * CURRENT_MA_PER_LSB,
+                       None if i_max == INVALID else i_max * CURRENT_MA_PER_LSB,
+                       None if v_min == INVALID else v_min,
+                       e)
+
+
+def main():
+    ap = argparse.ArgumentParser(description='PDM trend log decoder')
+    ap.add_argument('file')
+    ap.add_argument('-o', '--output', help='CSV 输出文件')
+    args = ap.parse_args()
+
+    with open(args.file, 'rb') as f:
+        groups, bad = decode(f.read())
+
+    if not groups:
+        print('no groups (%u CRC errors)' % bad)
+        return
+    for hdr, records in groups:
+        print('#%-6u uptime %8u s  boot %-5u %2u x %u s' % (hdr['seq'], hdr['uptime_s'], hdr['boots'],
+                                                           hdr['n'], hdr['interval_s']))
+    first, last = groups[0][0], groups[-1][0]
+    print('%u groups, %u CRC errors, uptime %u..%u s' % (len(groups), bad,
+                                                         first['uptime_s'] - (first['n'] - 1) * first['interval_s'],
+                                                         last['uptime_s']))
+
+    nch = first['nch']
+    energy = [0] * nch
+    peak = [None] * nch
+    vmin = [None] * nch
+    for t, boots, ch, i_mean, i_max, v_min, e in rows(groups):
+        if ch >= nch:
+            continue
+        energy[ch] += e
+        if i_max is not None and (peak[ch] is None or i_max > peak[ch]):
+            peak[ch] = i_max
+        if v_min is not None and (vmin[ch] is None or v_min < vmin[ch]):
+            vmin[ch] = v_min
+    for ch in range(nch):
+        print('ch%u: energy %u mWh, peak %s mA, min %s mV' % (ch, energy[ch],
+                                                               '-' if peak[ch] is None else peak[ch],
+                                                               '-' if vmin[ch] is None else vmin[ch]))
+
+    if args.output:
+        with open(args.output, 'w', newline='') as f:
+            w = csv.writer(f)
+            w.writerow(['uptime_s', 'boots', 'ch'] + list(FIELDS))
+            for row in rows(groups):
+                w.writerow(['' if x is None else x for x in row])
+
+
+if __name__ == '__main__':
+    main()
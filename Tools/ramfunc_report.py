@@ -0,0 +1,88 @@
+#!/usr/bin/env python3
+"""SRAM 执行代码占用报告（固件 PDM_CFG_RAMFUNC / PDM_CFG_RAM_VECTORS）。
+
+用法（通常由 make ramfunc-report 调用）：
+    python ramfunc_report.py Debug/PDM.map [--elf Debug/PDM.elf --nm arm-none-eabi-nm]
+
+从链接 map 文件中找出 .RamFunc 输入段（按目标文件）和 SRAM 向量表 g_ram_vectors 的大小；
+给出 --elf 时再用 nm 列出落在这些地址范围内的每个函数。
+.RamFunc 同时占用 RAM 和 flash（加载地址），向量表只占 RAM。
+"""
+import argparse
+import re
+import subprocess
+import sys
+
+# 输入段行：" .RamFunc  0x20000010  0x5c obj"；段名太长时地址和大小在下一行
+SECTION_RE = re.compile(r'^ (\.\S+)(?:\s+(0x[0-9a-fA-F]+)\s+(0x[0-9a-fA-F]+)\s+(\S.*))?$')
+CONT_RE = re.compile(r'^\s+(0x[0-9a-fA-F]+)\s+(0x[0-9a-fA-F]+)\s+(\S.*)$')
+
+
+def input_sections(lines):
+    """生成 (段名, 地址, 大小, 目标文件)"""
+    pending = None
+    for line in lines:
+        line = line.rstrip('\n')
+        if pending is not None:
+            m = CONT_RE.match(line)
+            if m:
+                yield pending, int(m.group(1), 16), int(m.group(2), 16), m.group(3)
+            pending = None
+            continue
+        m = SECTION_RE.match(line)
+        if not m:
+            continue
+        if m.group(2) is None:
+            pending = m.group(1)
+        else:
+            yield m.group(1), int(m.group(2), 16), int(m.group(3), 16), m.group(4)
+
+
+def ram_functions(elf, nm, ranges):
+    out = subprocess.run([nm, '--print-size', '--size-sort', '--reverse-sort', '--radix=x', elf],
+                         check=True, capture_output=True, text=True).stdout
+    funcs = []
+    for line in out.splitlines():
+        parts = line.split()
+        if len(parts) != 4:
+            continue
+        addr, size, name = int(parts[0], 16), int(parts[1], 16), parts[3]
+        if any(lo <= addr < hi for lo, hi in ranges):
+            funcs.append((size, name))
+    return funcs
+
+
+def main():
+    ap = argparse.ArgumentParser(description='RAM cost of code placed in SRAM')
+    ap.add_argument('map')
+    ap.add_argument('--elf')
+    ap.add_argument('--nm', default='arm-none-eabi-nm')
+    args = ap.parse_args()
+
+    ramfunc = []
+    vectors = 0
+    with open(args.map, errors='replace') as f:
+        for name, addr, size, obj in input_sections(f):
+            if size == 0:
+                continue
+            if name.startswith('.RamFunc'):
+                ramfunc.append((addr, size, obj))
+            elif name.endswith('.g_ram_vectors'):
+                vectors = size
+
+    total = sum(s for _, s, _ in ramfunc)
+    print('.RamFunc code: %u bytes RAM (+%u bytes flash load copy)' % (total, total))
+    for addr, size, obj in sorted(ramfunc, key=lambda r: -r[1]):
+        print('  %6u  0x%08x  %s' % (size, addr, obj))
+    if args.elf and ramfunc:
+        for size, name in ram_functions(args.elf, args.nm, [(a, a + s) for a, s, _ in ramfunc]):
+            print('    %6u  %s' % (size, name))
+    print('RAM vector table: %u bytes' % vectors)
+    print('total RAM: %u bytes' % (total + vectors))
+    if total == 0 and vectors == 0:
+        print('(PDM_CFG_RAMFUNC and PDM_CFG_RAM_VECTORS are off)')
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
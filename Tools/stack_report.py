@@ -0,0 +1,153 @@
+#!/usr/bin/env python3
+"""栈使用量静态报告：每个函数的栈帧（gcc -fstack-usage 的 .su 文件）按调用关系累加，给出最坏调用链。
+
+用法（通常由 make stack-report 调用）：
+    python stack_report.py Debug/PDM.elf Debug [--objdump arm-none-eabi-objdump] [--top 15]
+
+调用关系从 objdump 反汇编的 bl/b 指令得到（尾调用算作调用，跨 flash/SRAM 的长跳转桩按目标函数计算）。
+根为 main 和向量表中的各个 *_Handler，每个根给出最深的调用链；最后按"主循环最深 + 每个中断嵌套一次
+（各中断最深 + 硬件压栈 32 字节）"给出偏保守的总和，同一优先级的中断实际上不会互相嵌套。
+标记：
+    *  函数中有通过寄存器的间接调用（函数指针，如报文表编码函数、HAL 回调），其深度没有计入
+    ?  没有 .su 信息（汇编、未带 -fstack-usage 编译的库函数），按 0 计
+    +  栈帧大小与参数有关（动态，有上限），! 为动态且没有上限（alloca、变长数组）
+    R  调用链中有递归，只计一层
+LTO 时编译阶段不生成代码，.su 为空，用 make release-stack-report（不带 LTO 编译）查看优化后的大小。
+"""
+import argparse
+import os
+import re
+import subprocess
+import sys
+
+FUNC_RE = re.compile(r'^[0-9a-fA-F]+ <([^>]+)>:$')
+# 直接调用和跳转："bl 8000278 <HAL_Init>"、"b.w 8000140 <foo>"、"beq.n 80001a2 <bar>"
+BRANCH_RE = re.compile(r'^\s*[0-9a-fA-F]+:\s+b(?:l|lx)?(?:eq|ne|cs|cc|hs|lo|mi|pl|vs|vc|hi|ls|ge|lt|gt|le|al)?'
+                       r'(?:\.[nw])?\s+[0-9a-fA-F]+ <([^>+]+)>')
+INDIRECT_RE = re.compile(r'^\s*[0-9a-fA-F]+:\s+blx\s+r\d+')
+VENEER_RE = re.compile(r'^__(.+)_veneer$')
+EXC_FRAME = 32          # Cortex-M3 进入异常时硬件压栈 8 个字
+
+
+def read_su(build_dir):
+    """{函数名: (字节, 修饰)}；不同文件中的同名 static 函数取较大的一个"""
+    frames = {}
+    for root, _, files in os.walk(build_dir):
+        for name in files:
+            if not name.endswith('.su'):
+                continue
+            with open(os.path.join(root, name), errors='replace') as f:
+                for line in f:
+                    parts = line.rstrip('\n').split('\t')
+                    if len(parts) != 3:
+                        continue
+                    func = parts[0].rsplit(':', 1)[-1]
+                    size = int(parts[1])
+                    qual = '!' if 'dynamic' in parts[2] and 'bounded' not in parts[2] else \
+                           '+' if 'dynamic' in parts[2] else ''
+                    if func not in frames or size > frames[func][0]:
+                        frames[func] = (size, qual)
+    return frames
+
+
+def call_graph(elf, objdump):
+    """({调用者: 被调用者集合}, 有间接调用的函数集合)"""
+    out = subprocess.run([objdump, '-d', '--no-show-raw-insn', elf],
+                         check=True, capture_output=True, text=True).stdout
+    calls = {}
+    indirect = set()
+    cur = None
+    for line in out.splitlines():
+        m = FUNC_RE.match(line)
+        if m:
+            cur = m.group(1)
+            calls.setdefault(cur, set())
+            continue
+        if cur is None:
+            continue
+        m = BRANCH_RE.match(line)
+        if m:
+            callee = m.group(1)
+            v = VENEER_RE.match(callee)
+            if v:
+                callee = v.group(1)
+            if callee != cur:
+                calls[cur].add(callee)
+        elif INDIRECT_RE.match(line):
+            indirect.add(cur)
+    # 长跳转桩不是函数，对桩的调用已按目标函数记录
+    for name in [n for n in calls if VENEER_RE.match(n)]:
+        del calls[name]
+    return calls, indirect
+
+
+def worst(func, calls, frames, memo, stack):
+    """(最深字节数, 调用链, 是否有递归)"""
+    if func in memo:
+        return memo[func]
+    if func in stack:
+        return 0, [], True
+    stack.add(func)
+    best, chain, rec = 0, [], False
+    for callee in sorted(calls.get(func, ())):
+        d, c, r = worst(callee, calls, frames, memo, stack)
+        rec = rec or r
+        if d > best or not chain:
+            best, chain = d, c
+    stack.discard(func)
+    own = frames.get(func, (0, ''))[0]
+    memo[func] = (own + best, [func] + chain, rec)
+    return memo[func]
+
+
+def mark(func, frames, indirect):
+    s = frames[func][1] if func in frames else '?'
+    return s + ('*' if func in indirect else '')
+
+
+def main():
+    ap = argparse.ArgumentParser(description='worst-case stack depth per call chain')
+    ap.add_argument('elf')
+    ap.add_argument('build_dir')
+    ap.add_argument('--objdump', default='arm-none-eabi-objdump')
+    ap.add_argument('--top', type=int, default=15, help='number of largest frames to list')
+    args = ap.parse_args()
+
+    frames = read_su(args.build_dir)
+    if not frames:
+        sys.exit('no .su files under %s (built without -fstack-usage, or with LTO)' % args.build_dir)
+    calls, indirect = call_graph(args.elf, args.objdump)
+
+    print('largest frames:')
+    for func, (size, qual) in sorted(frames.items(), key=lambda kv: -kv[1][0])[:args.top]:
+        if func in calls:                       # 只列出链接进镜像的函数
+            print('  %6u%-2s %s' % (size, qual, func))
+
+    roots = ['main'] + sorted(n for n in calls if n.endswith('Handler') and n != 'Reset_Handler')
+    memo = {}
+    main_depth = 0
+    isr_total = 0
+    isr_worst = (0, None)
+    print('worst chain per entry:')
+    for root in roots:
+        if root not in calls:
+            continue
+        depth, chain, rec = worst(root, calls, frames, memo, set())
+        if depth == 0 and len(chain) == 1:
+            continue                            # 默认的空处理函数
+        flags = ''.join(sorted(set(''.join(mark(f, frames, indirect) for f in chain)))) + ('R' if rec else '')
+        print('  %6u %-4s %s' % (depth, flags, ' > '.join(chain)))
+        if root == 'main':
+            main_depth = depth
+        else:
+            isr_total += depth + EXC_FRAME
+            if depth > isr_worst[0]:
+                isr_worst = (depth, root)
+    print('main %u + all handlers nested once %u = %u bytes (upper bound)'
+          % (main_depth, isr_total, main_depth + isr_total))
+    if isr_worst[1]:
+        print('deepest handler: %s %u bytes' % (isr_worst[1], isr_worst[0]))
+
+
+if __name__ == '__main__':
+    main()